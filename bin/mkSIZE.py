@@ -23,7 +23,7 @@ def writeSize(params, infile, outfile):
         if value:
             lines = [
                 re.sub(
-                    r'(.*\bparameter\b.*\b{0} *= *)\S+?( *[),])'.format(key),
+                    r'(.*\bparameter\b.*\b{0} *= *)[^,)]+?( *[),])'.format(key),
                     r'\g<1>{0}\g<2>'.format(value), l, flags=re.I)
                 for l in lines]
 
@@ -137,6 +137,15 @@ except:
 size_params['lpmin']=str(lpmin)
 size_params['lpmax']=str(lpmax)
 
+# lelt ###
+# a fixed per-rank capacity lets one binary serve many meshes/rank counts,
+# memory is only touched for the elements a rank actually owns
+try:
+  lelt = int(par['GENERAL']['maxNumElementsPerProcess'])
+  size_params['lelt']=str(lelt)
+except:
+  pass
+
 # ldimt ###
 ldimt  = 1
 for sections in par.sections():
@@ -203,7 +212,7 @@ try:
 except:
   pass
 
-if (lelg*lx1**ldim)/lpmin > 2**19:
+if 'lelt' not in size_params and (lelg*lx1**ldim)/lpmin > 2**19:
      print("<INFO> Increase GENERAL:minNumProcesses to reduce memory usage")
 
 # generate SIZE file ###
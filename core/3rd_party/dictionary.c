@@ -26,6 +26,9 @@
 /** Minimal allocated number of entries in a dictionary */
 #define DICTMINSZ   128
 
+/** Key and section hash tables are kept at most half full */
+#define DICT_SLOTS(n)   (2*(n))
+
 /** Invalid key token */
 #define DICT_INVALID_KEY    ((char*)-1)
 
@@ -70,11 +73,13 @@ static int dictionary_grow(dictionary * d)
     char        ** new_val ;
     char        ** new_key ;
     unsigned     * new_hash ;
+    ssize_t      * new_snext ;
 
-    new_val  = (char**) calloc(d->size * 2, sizeof *d->val);
-    new_key  = (char**) calloc(d->size * 2, sizeof *d->key);
-    new_hash = (unsigned*) calloc(d->size * 2, sizeof *d->hash);
-    if (!new_val || !new_key || !new_hash) {
+    new_val   = (char**) calloc(d->size * 2, sizeof *d->val);
+    new_key   = (char**) calloc(d->size * 2, sizeof *d->key);
+    new_hash  = (unsigned*) calloc(d->size * 2, sizeof *d->hash);
+    new_snext = (ssize_t*) calloc(d->size * 2, sizeof *d->snext);
+    if (!new_val || !new_key || !new_hash || !new_snext) {
         /* An allocation failed, leave the dictionary unchanged */
         if (new_val)
             free(new_val);
@@ -82,21 +87,209 @@ static int dictionary_grow(dictionary * d)
             free(new_key);
         if (new_hash)
             free(new_hash);
+        if (new_snext)
+            free(new_snext);
         return -1 ;
     }
     /* Initialize the newly allocated space */
     memcpy(new_val, d->val, d->size * sizeof(char *));
     memcpy(new_key, d->key, d->size * sizeof(char *));
     memcpy(new_hash, d->hash, d->size * sizeof(unsigned));
+    memcpy(new_snext, d->snext, d->size * sizeof(ssize_t));
     /* Delete previous data */
     free(d->val);
     free(d->key);
     free(d->hash);
+    free(d->snext);
     /* Actually update the dictionary */
     d->size *= 2 ;
     d->val = new_val;
     d->key = new_key;
     d->hash = new_hash;
+    d->snext = new_snext;
+    return 0 ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Hash of the first len characters of a string.
+
+  Same function as dictionary_hash(), used for the section part of a
+  "section:key" string.
+ */
+/*--------------------------------------------------------------------------*/
+static unsigned dictionary_hashn(const char * key, size_t len)
+{
+    unsigned    hash ;
+    size_t      i ;
+
+    for (hash=0, i=0 ; i<len ; i++) {
+        hash += (unsigned)key[i] ;
+        hash += (hash<<10);
+        hash ^= (hash>>6) ;
+    }
+    hash += (hash <<3);
+    hash ^= (hash >>11);
+    hash += (hash <<15);
+    return hash ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Length of the section part of a key, 0 if it has none.
+ */
+/*--------------------------------------------------------------------------*/
+static size_t dictionary_seclen(const char * key)
+{
+    const char * c = strchr(key, ':');
+    return c ? (size_t)(c-key) : 0 ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Find the key table slot of a key.
+  @param    d       Dictionary to search
+  @param    key     Key to look for
+  @param    hash    dictionary_hash(key)
+  @return   Slot holding the key, or -1-s with s the first free slot
+ */
+/*--------------------------------------------------------------------------*/
+static ssize_t dictionary_probe(const dictionary * d, const char * key,
+                                unsigned hash)
+{
+    ssize_t mask = d->nslot-1 ;
+    ssize_t s, e, first = -1 ;
+
+    for (s=hash & mask ; ; s=(s+1) & mask) {
+        e = d->slot[s] ;
+        if (e==0)
+            return -1-(first>=0 ? first : s) ;
+        if (e<0) {
+            if (first<0) first = s ;
+            continue ;
+        }
+        if (d->hash[e-1]==hash && !strcmp(key, d->key[e-1]))
+            return s ;
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Find the section table slot of a section.
+  @param    d       Dictionary to search
+  @param    sec     Section name, not necessarily 0-terminated
+  @param    len     Length of the section name
+  @return   Slot holding the section, or -1-s with s the first free slot
+ */
+/*--------------------------------------------------------------------------*/
+static ssize_t dictionary_secprobe(const dictionary * d, const char * sec,
+                                   size_t len)
+{
+    ssize_t mask = d->nslot-1 ;
+    ssize_t s, e, first = -1 ;
+    unsigned hash = dictionary_hashn(sec, len);
+
+    for (s=hash & mask ; ; s=(s+1) & mask) {
+        e = d->sslot[s] ;
+        if (e==0)
+            return -1-(first>=0 ? first : s) ;
+        if (e<0) {
+            if (first<0) first = s ;
+            continue ;
+        }
+        if (!strncmp(sec, d->key[e-1], len) && d->key[e-1][len]==':')
+            return s ;
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Enter entry i into the key table and its section chain.
+ */
+/*--------------------------------------------------------------------------*/
+static void dictionary_link(dictionary * d, ssize_t i)
+{
+    ssize_t s, e ;
+    size_t  len ;
+
+    s = dictionary_probe(d, d->key[i], d->hash[i]);
+    s = -1-s ;
+    if (d->slot[s]<0) d->ndel-- ;
+    d->slot[s] = i+1 ;
+
+    d->snext[i] = 0 ;
+    len = dictionary_seclen(d->key[i]);
+    if (len==0) return ;
+
+    s = dictionary_secprobe(d, d->key[i], len);
+    if (s<0) {
+        s = -1-s ;
+        if (d->sslot[s]<0) d->ndel-- ;
+        d->sslot[s] = i+1 ;
+        return ;
+    }
+    /* append to keep the section in insertion order */
+    for (e=d->sslot[s] ; d->snext[e-1] ; e=d->snext[e-1]) ;
+    d->snext[e-1] = i+1 ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Remove entry i from the key table and its section chain.
+ */
+/*--------------------------------------------------------------------------*/
+static void dictionary_unlink(dictionary * d, ssize_t i)
+{
+    ssize_t s, e ;
+    size_t  len ;
+
+    s = dictionary_probe(d, d->key[i], d->hash[i]);
+    d->slot[s] = -1 ;
+    d->ndel++ ;
+
+    len = dictionary_seclen(d->key[i]);
+    if (len==0) return ;
+
+    s = dictionary_secprobe(d, d->key[i], len);
+    if (d->sslot[s]==i+1) {
+        d->sslot[s] = d->snext[i] ? d->snext[i] : -1 ;
+        if (d->sslot[s]<0) d->ndel++ ;
+        return ;
+    }
+    for (e=d->sslot[s] ; d->snext[e-1]!=i+1 ; e=d->snext[e-1]) ;
+    d->snext[e-1] = d->snext[i] ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Rebuild the hash tables with nslot slots
+  @return   This function returns non-zero in case of failure
+ */
+/*--------------------------------------------------------------------------*/
+static int dictionary_rehash(dictionary * d, ssize_t nslot)
+{
+    ssize_t * slot ;
+    ssize_t * sslot ;
+    ssize_t   i, m ;
+
+    for (m=1 ; m<nslot ; m*=2) ;
+    slot  = (ssize_t*) calloc(m, sizeof *slot);
+    sslot = (ssize_t*) calloc(m, sizeof *sslot);
+    if (!slot || !sslot) {
+        if (slot)  free(slot);
+        if (sslot) free(sslot);
+        return -1 ;
+    }
+    free(d->slot);
+    free(d->sslot);
+    d->slot  = slot ;
+    d->sslot = sslot ;
+    d->nslot = m ;
+    d->ndel  = 0 ;
+    for (i=0 ; i<d->size ; i++) {
+        if (d->key[i]!=NULL)
+            dictionary_link(d, i);
+    }
     return 0 ;
 }
 
@@ -117,23 +310,9 @@ static int dictionary_grow(dictionary * d)
 /*--------------------------------------------------------------------------*/
 unsigned dictionary_hash(const char * key)
 {
-    size_t      len ;
-    unsigned    hash ;
-    size_t      i ;
-
     if (!key)
         return 0 ;
-
-    len = strlen(key);
-    for (hash=0, i=0 ; i<len ; i++) {
-        hash += (unsigned)key[i] ;
-        hash += (hash<<10);
-        hash ^= (hash>>6) ;
-    }
-    hash += (hash <<3);
-    hash ^= (hash >>11);
-    hash += (hash <<15);
-    return hash ;
+    return dictionary_hashn(key, strlen(key));
 }
 
 /*-------------------------------------------------------------------------*/
@@ -157,10 +336,15 @@ dictionary * dictionary_new(size_t size)
     d = (dictionary*) calloc(1, sizeof *d) ;
 
     if (d) {
-        d->size = size ;
-        d->val  = (char**) calloc(size, sizeof *d->val);
-        d->key  = (char**) calloc(size, sizeof *d->key);
-        d->hash = (unsigned*) calloc(size, sizeof *d->hash);
+        d->size  = size ;
+        d->val   = (char**) calloc(size, sizeof *d->val);
+        d->key   = (char**) calloc(size, sizeof *d->key);
+        d->hash  = (unsigned*) calloc(size, sizeof *d->hash);
+        d->snext = (ssize_t*) calloc(size, sizeof *d->snext);
+        if (dictionary_rehash(d, DICT_SLOTS(size)) != 0) {
+            dictionary_del(d);
+            return NULL ;
+        }
     }
     return d ;
 }
@@ -188,6 +372,9 @@ void dictionary_del(dictionary * d)
     free(d->val);
     free(d->key);
     free(d->hash);
+    free(d->snext);
+    free(d->slot);
+    free(d->sslot);
     free(d);
     return ;
 }
@@ -208,22 +395,58 @@ void dictionary_del(dictionary * d)
 /*--------------------------------------------------------------------------*/
 const char * dictionary_get(const dictionary * d, const char * key, const char * def)
 {
-    unsigned    hash ;
     ssize_t      i ;
 
-    hash = dictionary_hash(key);
-    for (i=0 ; i<d->size ; i++) {
-        if (d->key[i]==NULL)
-            continue ;
-        /* Compare hash */
-        if (hash==d->hash[i]) {
-            /* Compare string, to avoid hash collisions */
-            if (!strcmp(key, d->key[i])) {
-                return d->val[i] ;
-            }
-        }
-    }
-    return def ;
+    i = dictionary_index(d, key);
+    return i<0 ? def : d->val[i] ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Locate a key in a dictionary.
+  @param    d       dictionary object to search.
+  @param    key     Key to look for in the dictionary.
+  @return   Index of the entry in d->key/d->val, -1 if not found.
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_index(const dictionary * d, const char * key)
+{
+    ssize_t      s ;
+
+    if (d==NULL || key==NULL) return -1 ;
+    s = dictionary_probe(d, key, dictionary_hash(key));
+    return s<0 ? -1 : d->slot[s]-1 ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    First key of a section.
+  @param    d       dictionary object to search.
+  @param    sec     Section name (without the colon).
+  @return   Index of the first "sec:key" entry, -1 if there is none.
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_secfirst(const dictionary * d, const char * sec)
+{
+    ssize_t      s ;
+
+    if (d==NULL || sec==NULL) return -1 ;
+    s = dictionary_secprobe(d, sec, strlen(sec));
+    return s<0 ? -1 : d->sslot[s]-1 ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Next key of the same section.
+  @param    d       dictionary object to search.
+  @param    i       Index returned by dictionary_secfirst/secnext.
+  @return   Index of the next entry of the section, -1 at the end.
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_secnext(const dictionary * d, ssize_t i)
+{
+    if (d==NULL || i<0 || i>=d->size) return -1 ;
+    return d->snext[i]-1 ;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -262,21 +485,15 @@ int dictionary_set(dictionary * d, const char * key, const char * val)
     /* Compute hash for this key */
     hash = dictionary_hash(key) ;
     /* Find if value is already in dictionary */
-    if (d->n>0) {
-        for (i=0 ; i<d->size ; i++) {
-            if (d->key[i]==NULL)
-                continue ;
-            if (hash==d->hash[i]) { /* Same hash value */
-                if (!strcmp(key, d->key[i])) {   /* Same key */
-                    /* Found a value: modify and return */
-                    if (d->val[i]!=NULL)
-                        free(d->val[i]);
-                    d->val[i] = (val ? xstrdup(val) : NULL);
-                    /* Value has been modified: return */
-                    return 0 ;
-                }
-            }
-        }
+    i = dictionary_probe(d, key, hash);
+    if (i>=0) {
+        i = d->slot[i]-1 ;
+        /* Found a value: modify and return */
+        if (d->val[i]!=NULL)
+            free(d->val[i]);
+        d->val[i] = (val ? xstrdup(val) : NULL);
+        /* Value has been modified: return */
+        return 0 ;
     }
     /* Add a new value */
     /* See if dictionary needs to grow */
@@ -285,6 +502,11 @@ int dictionary_set(dictionary * d, const char * key, const char * val)
         if (dictionary_grow(d) != 0)
             return -1;
     }
+    /* Keep the hash tables at most half full (including deletions) */
+    if (2*(d->n+1+d->ndel) > d->nslot) {
+        if (dictionary_rehash(d, DICT_SLOTS(d->size)) != 0)
+            return -1;
+    }
 
     /* Insert key in the first empty slot. Start at d->n and wrap at
        d->size. Because d->n < d->size this will necessarily
@@ -297,6 +519,7 @@ int dictionary_set(dictionary * d, const char * key, const char * val)
     d->val[i]  = (val ? xstrdup(val) : NULL) ;
     d->hash[i] = hash;
     d->n ++ ;
+    dictionary_link(d, i);
     return 0 ;
 }
 
@@ -313,30 +536,18 @@ int dictionary_set(dictionary * d, const char * key, const char * val)
 /*--------------------------------------------------------------------------*/
 void dictionary_unset(dictionary * d, const char * key)
 {
-    unsigned    hash ;
     ssize_t      i ;
 
     if (key == NULL || d == NULL) {
         return;
     }
 
-    hash = dictionary_hash(key);
-    for (i=0 ; i<d->size ; i++) {
-        if (d->key[i]==NULL)
-            continue ;
-        /* Compare hash */
-        if (hash==d->hash[i]) {
-            /* Compare string, to avoid hash collisions */
-            if (!strcmp(key, d->key[i])) {
-                /* Found key */
-                break ;
-            }
-        }
-    }
-    if (i>=d->size)
+    i = dictionary_index(d, key);
+    if (i<0)
         /* Key not found */
         return ;
 
+    dictionary_unlink(d, i);
     free(d->key[i]);
     d->key[i] = NULL ;
     if (d->val[i]!=NULL) {
@@ -37,9 +37,14 @@ extern "C" {
   @brief    Dictionary object
 
   This object contains a list of string/string associations. Each
-  association is identified by a unique string key. Looking up values
-  in the dictionary is speeded up by the use of a (hopefully collision-free)
-  hash function.
+  association is identified by a unique string key. Entries are stored
+  in the key/val/hash lists, an open-addressing table (slot, linear
+  probing) maps a key hash to its entry in constant time.
+
+  Keys of the form "section:key" are also chained per section: sslot
+  maps the hash of the section part to the first entry of that section
+  and snext links the following ones, so the keys of one section are
+  found without scanning the whole dictionary.
  */
 /*-------------------------------------------------------------------------*/
 typedef struct _dictionary_ {
@@ -48,6 +53,11 @@ typedef struct _dictionary_ {
     char        **  val ;   /** List of string values */
     char        **  key ;   /** List of string keys */
     unsigned     *  hash ;  /** List of hash values for keys */
+    ssize_t         nslot ; /** Size of the hash tables (power of 2) */
+    ssize_t         ndel ;  /** Deleted markers in the hash tables */
+    ssize_t      *  slot ;  /** Key table: entry+1, 0 empty, -1 deleted */
+    ssize_t      *  sslot ; /** Section table: first entry+1 */
+    ssize_t      *  snext ; /** Next entry+1 of the same section */
 } dictionary ;
 
 
@@ -152,6 +162,44 @@ int dictionary_set(dictionary * vd, const char * key, const char * val);
 void dictionary_unset(dictionary * d, const char * key);
 
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Locate a key in a dictionary.
+  @param    d       dictionary object to search.
+  @param    key     Key to look for in the dictionary.
+  @return   Index of the entry in d->key/d->val, -1 if not found.
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_index(const dictionary * d, const char * key);
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    First key of a section.
+  @param    d       dictionary object to search.
+  @param    sec     Section name (without the colon).
+  @return   Index of the first "sec:key" entry, -1 if there is none.
+
+  Together with dictionary_secnext() this iterates over the keys of one
+  section in insertion order:
+
+  @code
+    for (i=dictionary_secfirst(d,"scalar01"); i>=0;
+         i=dictionary_secnext(d,i)) ...
+  @endcode
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_secfirst(const dictionary * d, const char * sec);
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Next key of the same section.
+  @param    d       dictionary object to search.
+  @param    i       Index returned by dictionary_secfirst/secnext.
+  @return   Index of the next entry of the section, -1 at the end.
+ */
+/*--------------------------------------------------------------------------*/
+ssize_t dictionary_secnext(const dictionary * d, ssize_t i);
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Dump a dictionary to an opened file pointer.
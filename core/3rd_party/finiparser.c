@@ -1,5 +1,8 @@
 #include <ctype.h>
 #include "iniparser.h"
+#ifdef MPI
+#include <mpi.h>
+#endif
 
 #ifndef FNAME_H
 #define FNAME_H
@@ -34,8 +37,12 @@
 #define finiparser_getDbl         FORTRAN_NAME(finiparser_getdbl,  FINIPARSER_GETDBL)
 #define finiparser_getToken       FORTRAN_NAME(finiparser_gettoken,  FINIPARSER_GETTOKEN)
 #define finiparser_findTokens     FORTRAN_NAME(finiparser_findtokens,  FINIPARSER_FINDTOKENS)
+#define finiparser_getSecPairs    FORTRAN_NAME(finiparser_getsecpairs,  FINIPARSER_GETSECPAIRS)
+#define finiparser_bcast          FORTRAN_NAME(finiparser_bcast,  FINIPARSER_BCAST)
 
 #define ntokenmax  100 
+#define nkeymax    1024
+#define bcastchunk 65536 /* first broadcast, holds any usual .par file */
 
 static dictionary *dic=NULL;
 static char *token[ntokenmax];
@@ -62,6 +69,19 @@ char *addchar0(char * str,int str_len)
     return newstr;
 }
 
+/* blank stripped copy of a Fortran string in buf (no allocation, so the
+   lookups below are cheap enough to be called from the time loop) */
+static const char *fstr(char *buf, const char *str, int str_len)
+{
+    int i;
+
+    if (str_len > nkeymax) str_len = nkeymax;
+    for (i=str_len-1; i>=0; i--) if (str[i] != ' ') break;
+    memcpy(buf, str, i+1);
+    buf[i+1] = '\0';
+    return buf;
+}
+
 void finiparser_dump()
 {
     if(dic != NULL) iniparser_dump(dic,stdout);
@@ -70,9 +90,10 @@ void finiparser_dump()
 
 void finiparser_find(int* out,char *key,int* ifnd,int key_len)
 {
+    char buf[nkeymax+1];
     int tmp;
     *ifnd = 0;
-    tmp = iniparser_find_entry(dic,addchar0(key,key_len));
+    tmp = iniparser_find_entry(dic,fstr(buf,key,key_len));
     if (tmp == 1) {
        *out = tmp;
        *ifnd = 1;
@@ -127,6 +148,7 @@ void finiparser_free()
 
 void finiparser_getString(char *out,char *key,int *ifnd,int out_len,int key_len)
 {
+    char buf[nkeymax+1];
     int i;
     const char* str;
     int real_out_len;
@@ -134,7 +156,7 @@ void finiparser_getString(char *out,char *key,int *ifnd,int out_len,int key_len)
     *ifnd = 0;
     for (i=0; i<out_len; i++) out[i] = ' ';
 
-    str = iniparser_getstring(dic,addchar0(key,key_len),NULL);
+    str = iniparser_getstring(dic,fstr(buf,key,key_len),NULL);
     if (str != NULL) {
        real_out_len = strlen(str);
        if(real_out_len <= out_len) {
@@ -147,10 +169,11 @@ void finiparser_getString(char *out,char *key,int *ifnd,int out_len,int key_len)
 
 void finiparser_getBool(int* out,char *key,int* ifnd,int key_len)
 {
+    char buf[nkeymax+1];
     int tmp;
 
     *ifnd = 0;
-    tmp = iniparser_getboolean(dic,addchar0(key,key_len),-1);
+    tmp = iniparser_getboolean(dic,fstr(buf,key,key_len),-1);
     if (tmp != -1) { 
        *out = tmp;
        *ifnd = 1;
@@ -160,10 +183,11 @@ void finiparser_getBool(int* out,char *key,int* ifnd,int key_len)
 
 void finiparser_getDbl(double* out,char *key,int *ifnd,int key_len)
 {
+    char buf[nkeymax+1];
     const char* str;
 
     *ifnd = 0;
-    str = iniparser_getstring(dic,addchar0(key,key_len),NULL);
+    str = iniparser_getstring(dic,fstr(buf,key,key_len),NULL);
     if (str != NULL) {
        *out = atof(str);
        *ifnd = 1;
@@ -184,17 +208,18 @@ void finiparser_getToken(char *out,int *id,int out_len)
 
 void finiparser_findTokens(char *key, char *delim, int *icounter,int key_len,int delim_len)
 {
+    static char *newstr = NULL;
+    char buf[nkeymax+1], d[nkeymax+1];
     const char *str;
-    char *newstr;
-    char *d;
     int i;
 
     *icounter = 0;
 
-    d = addchar0(delim,delim_len);
-    str = iniparser_getstring(dic,addchar0(key,key_len),NULL);
+    fstr(d,delim,delim_len);
+    str = iniparser_getstring(dic,fstr(buf,key,key_len),NULL);
     if (str == NULL) return;
 
+    free(newstr); /* tokens of the previous call */
     newstr = (char *) malloc((strlen(str)+1)*sizeof(char));
     strncpy(newstr,str,strlen(str)+1);
 
@@ -208,3 +233,109 @@ void finiparser_findTokens(char *key, char *delim, int *icounter,int key_len,int
     
    return;
 }
+
+/* Bulk extraction of a section: keys (without the "section:" part) and
+   values of up to nmax entries of sec, n returns the number of keys in
+   the section (0 if it does not exist).  Entries that do not fit the
+   Fortran strings are returned blank. */
+void finiparser_getSecPairs(char *sec, char *keys, char *vals, int *nmax,
+                            int *n, int sec_len, int key_len, int val_len)
+{
+    char buf[nkeymax+1], lsec[nkeymax+1];
+    const char *k, *v;
+    ssize_t j;
+    int i, lk, lv;
+
+    *n = 0;
+    if (dic == NULL) return;
+    strlwc(fstr(buf,sec,sec_len),lsec,sizeof(lsec));
+
+    for (j=dictionary_secfirst(dic,lsec); j>=0; j=dictionary_secnext(dic,j)) {
+        if (*n < *nmax) {
+            char *ko = keys + (size_t)(*n)*key_len;
+            char *vo = vals + (size_t)(*n)*val_len;
+            for (i=0; i<key_len; i++) ko[i] = ' ';
+            for (i=0; i<val_len; i++) vo[i] = ' ';
+            k  = dic->key[j] + strlen(lsec) + 1;
+            v  = dic->val[j];
+            lk = strlen(k);
+            lv = v ? strlen(v) : 0;
+            if (lk <= key_len && lv <= val_len) {
+                memcpy(ko,k,lk);
+                if (lv) memcpy(vo,v,lv);
+            }
+        }
+        (*n)++;
+    }
+    return;
+}
+
+/* Distribute the dictionary loaded on rank 0 of comm to all ranks.
+   Rank 0 serializes the entries (nbytes, n, then key\0 flag val\0 in
+   entry order) into one buffer; the first bcastchunk bytes go out in a
+   single broadcast, a second one carries the rest only for very large
+   files.  The other ranks rebuild the dictionary without file access. */
+void finiparser_bcast(int *comm)
+{
+#ifdef MPI
+    MPI_Comm c_comm = MPI_Comm_f2c(*comm);
+    char *buf, *p;
+    int nid, n, i, j;
+    size_t nbytes = 0, len;
+
+    MPI_Comm_rank(c_comm,&nid);
+
+    if (nid == 0) {
+        nbytes = 2*sizeof(int);
+        for (j=0; j<dic->size; j++) {
+            if (dic->key[j] == NULL) continue;
+            nbytes += strlen(dic->key[j]) + 2;
+            nbytes += (dic->val[j] ? strlen(dic->val[j]) : 0) + 1;
+        }
+    }
+    buf = (char *) malloc(nbytes > bcastchunk ? nbytes : bcastchunk);
+
+    if (nid == 0) {
+        p = buf + 2*sizeof(int);
+        for (j=0; j<dic->size; j++) {
+            if (dic->key[j] == NULL) continue;
+            len = strlen(dic->key[j]) + 1;
+            memcpy(p,dic->key[j],len); p += len;
+            *p++ = dic->val[j] != NULL;
+            len = dic->val[j] ? strlen(dic->val[j]) : 0;
+            if (len) memcpy(p,dic->val[j],len);
+            p += len;
+            *p++ = '\0';
+        }
+        n = (int)nbytes;
+        memcpy(buf,&n,sizeof(int));
+        memcpy(buf+sizeof(int),&dic->n,sizeof(int));
+    }
+
+    MPI_Bcast(buf,bcastchunk,MPI_CHAR,0,c_comm);
+    memcpy(&n,buf,sizeof(int));
+    nbytes = (size_t)n;
+    if (nbytes > bcastchunk) {
+        if (nid != 0) buf = (char *) realloc(buf,nbytes);
+        MPI_Bcast(buf+bcastchunk,(int)(nbytes-bcastchunk),MPI_CHAR,0,c_comm);
+    }
+
+    if (nid != 0) {
+        memcpy(&n,buf+sizeof(int),sizeof(int));
+        if (dic != NULL) dictionary_del(dic);
+        dic = dictionary_new(n);
+        p = buf + 2*sizeof(int);
+        for (i=0; i<n; i++) {
+            char *k = p, *v;
+            int hasval;
+            p += strlen(k) + 1;
+            hasval = *p++;
+            v = p;
+            p += strlen(v) + 1;
+            dictionary_set(dic,k,hasval ? v : NULL);
+        }
+    }
+    free(buf);
+#endif
+    return;
+}
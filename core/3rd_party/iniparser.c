@@ -254,8 +254,7 @@ void iniparser_dump_ini(const dictionary * d, FILE * f)
 /*--------------------------------------------------------------------------*/
 void iniparser_dumpsection_ini(const dictionary * d, const char * s, FILE * f)
 {
-    int     j ;
-    char    keym[ASCIILINESZ+1];
+    ssize_t j ;
     int     seclen ;
 
     if (d==NULL || f==NULL) return ;
@@ -263,16 +262,11 @@ void iniparser_dumpsection_ini(const dictionary * d, const char * s, FILE * f)
 
     seclen  = (int)strlen(s);
     fprintf(f, "\n[%s]\n", s);
-    sprintf(keym, "%s:", s);
-    for (j=0 ; j<d->size ; j++) {
-        if (d->key[j]==NULL)
-            continue ;
-        if (!strncmp(d->key[j], keym, seclen+1)) {
-            fprintf(f,
-                    "%-30s = %s\n",
-                    d->key[j]+seclen+1,
-                    d->val[j] ? d->val[j] : "");
-        }
+    for (j=dictionary_secfirst(d, s) ; j>=0 ; j=dictionary_secnext(d, j)) {
+        fprintf(f,
+                "%-30s = %s\n",
+                d->key[j]+seclen+1,
+                d->val[j] ? d->val[j] : "");
     }
     fprintf(f, "\n");
     return ;
@@ -288,24 +282,15 @@ void iniparser_dumpsection_ini(const dictionary * d, const char * s, FILE * f)
 /*--------------------------------------------------------------------------*/
 int iniparser_getsecnkeys(const dictionary * d, const char * s)
 {
-    int     seclen, nkeys ;
-    char    keym[ASCIILINESZ+1];
-    int j ;
+    int     nkeys ;
+    ssize_t j ;
 
     nkeys = 0;
 
     if (d==NULL) return nkeys;
-    if (! iniparser_find_entry(d, s)) return nkeys;
-
-    seclen  = (int)strlen(s);
-    sprintf(keym, "%s:", s);
 
-    for (j=0 ; j<d->size ; j++) {
-        if (d->key[j]==NULL)
-            continue ;
-        if (!strncmp(d->key[j], keym, seclen+1))
-            nkeys++;
-    }
+    for (j=dictionary_secfirst(d, s) ; j>=0 ; j=dictionary_secnext(d, j))
+        nkeys++;
 
     return nkeys;
 
@@ -329,24 +314,17 @@ int iniparser_getsecnkeys(const dictionary * d, const char * s)
 /*--------------------------------------------------------------------------*/
 const char ** iniparser_getseckeys(const dictionary * d, const char * s, const char ** keys)
 {
-    int i, j, seclen ;
-    char keym[ASCIILINESZ+1];
+    int i ;
+    ssize_t j ;
 
     if (d==NULL || keys==NULL) return NULL;
     if (! iniparser_find_entry(d, s)) return NULL;
 
-    seclen  = (int)strlen(s);
-    sprintf(keym, "%s:", s);
-
     i = 0;
 
-    for (j=0 ; j<d->size ; j++) {
-        if (d->key[j]==NULL)
-            continue ;
-        if (!strncmp(d->key[j], keym, seclen+1)) {
-            keys[i] = d->key[j];
-            i++;
-        }
+    for (j=dictionary_secfirst(d, s) ; j>=0 ; j=dictionary_secnext(d, j)) {
+        keys[i] = d->key[j];
+        i++;
     }
 
     return keys;
@@ -2,19 +2,100 @@ c-----------------------------------------------------------------------
       subroutine in_situ_init()
 #ifdef VISIT
       call visit_init()
+#endif
+#ifdef INSITU
+      call insitu_init()
 #endif
       end
 c-----------------------------------------------------------------------
       subroutine in_situ_check()
 #ifdef VISIT
       call visit_check()
+#endif
+#ifdef INSITU
+      call insitu_check()
 #endif
       end
 c-----------------------------------------------------------------------
       subroutine in_situ_end()
 #ifdef VISIT
       call visit_end()
+#endif
+#ifdef INSITU
+      call insitu_end()
 #endif
       end
 c-----------------------------------------------------------------------
 
+#ifdef INSITU
+c-----------------------------------------------------------------------
+      subroutine insitu_init()
+c
+c     Register the mesh and solution with the generic in-situ adapter
+c     (nek_insitu.c, consumer API in nek_insitu.h).  No data is copied
+c     here, the consumer sees these arrays by address; with
+c     general:inSituAsync they are snapshotted at each hand-off.
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      character*3 sname
+      integer ifasync,ifmove,nxyz1,nxyz2,ifld
+
+      if (wdsize.ne.8) call exitti('insitu: needs 8 byte reals$',wdsize)
+
+      ifasync = 0
+      if (param(189).gt.0) ifasync = 1
+      ifmove = 0
+      if (ifmvbd) ifmove = 1
+
+      call nek_insitu_setup(nekcomm,ifasync,ifmove,session)
+      call nek_insitu_mesh(ldim,lx1,ly1,lz1,nelv,nelt,lglel
+     $                    ,xm1,ym1,zm1)
+
+      nxyz1 = lx1*ly1*lz1
+      nxyz2 = lx2*ly2*lz2
+      if (ifflow) then
+         call nek_insitu_field('vx',vx,nxyz1,nelv)
+         call nek_insitu_field('vy',vy,nxyz1,nelv)
+         if (if3d) call nek_insitu_field('vz',vz,nxyz1,nelv)
+         call nek_insitu_field('pr',pr,nxyz2,nelv)
+      endif
+      if (ifheat) call nek_insitu_field('t',t,nxyz1,nelt)
+      do ifld=3,nfield
+         write(sname,'(a1,i2.2)') 's',ifld-2
+         call nek_insitu_field(sname,t(1,1,1,1,ifld-1),nxyz1,nelt)
+      enddo
+
+      call nek_insitu_start
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine insitu_check()
+c
+c     Hand off every general:inSituInterval steps (default: the output
+c     interval) and at the last step.
+c
+      include 'SIZE'
+      include 'TSTEP'
+      include 'INPUT'
+
+      integer isint
+
+      isint = iostep
+      if (param(188).gt.0) isint = int(param(188))
+      if (lastep.eq.1 .or. (isint.gt.0 .and. mod(istep,isint).eq.0))
+     $   call nek_insitu_publish(istep,time)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine insitu_end()
+
+      call nek_insitu_end
+
+      return
+      end
+c-----------------------------------------------------------------------
+#endif
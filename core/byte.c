@@ -1,3 +1,6 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +10,27 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#if defined(MPI) && !defined(NOMPIIO)
+#  include <mpi.h>
+#  define BYTE_ASYNC
+#endif
+
+#ifdef ZSTD
+#  include <zstd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define BYTE_SWAP_X86
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#  define BYTE_SWAP_NEON
+#  include <arm_neon.h>
+#endif
 
 #ifndef FNAME_H
 #define FNAME_H
@@ -37,6 +61,22 @@
 #define byte_rewind   FORTRAN_NAME(byte_rewind,   BYTE_REWIND )
 #define byte_read     FORTRAN_NAME(byte_read,     BYTE_READ   )
 #define byte_write    FORTRAN_NAME(byte_write,    BYTE_WRITE  )
+#define byte_read_swap FORTRAN_NAME(byte_read_swap,BYTE_READ_SWAP)
+#define byte_hopen    FORTRAN_NAME(byte_hopen,    BYTE_HOPEN  )
+#define byte_hclose   FORTRAN_NAME(byte_hclose,   BYTE_HCLOSE )
+#define byte_hrewind  FORTRAN_NAME(byte_hrewind,  BYTE_HREWIND)
+#define byte_hread    FORTRAN_NAME(byte_hread,    BYTE_HREAD  )
+#define byte_hwrite   FORTRAN_NAME(byte_hwrite,   BYTE_HWRITE )
+#define byte_mmap_open   FORTRAN_NAME(byte_mmap_open,  BYTE_MMAP_OPEN  )
+#define byte_mmap_read   FORTRAN_NAME(byte_mmap_read,  BYTE_MMAP_READ  )
+#define byte_mmap_close  FORTRAN_NAME(byte_mmap_close, BYTE_MMAP_CLOSE )
+#define byte_zpack       FORTRAN_NAME(byte_zpack,      BYTE_ZPACK      )
+#define byte_zunpack     FORTRAN_NAME(byte_zunpack,    BYTE_ZUNPACK    )
+#define byte_async_open  FORTRAN_NAME(byte_async_open, BYTE_ASYNC_OPEN )
+#define byte_async_view  FORTRAN_NAME(byte_async_view, BYTE_ASYNC_VIEW )
+#define byte_async_write FORTRAN_NAME(byte_async_write,BYTE_ASYNC_WRITE)
+#define byte_async_close FORTRAN_NAME(byte_async_close,BYTE_ASYNC_CLOSE)
+#define byte_async_flush FORTRAN_NAME(byte_async_flush,BYTE_ASYNC_FLUSH)
 
 #define READ     1
 #define WRITE    2
@@ -44,6 +84,13 @@
 
 #define SWAP(a,b)       temp=(a); (a)=(b); (b)=temp;
 
+#define BYTE_MAX_HANDLES 32
+#define BYTE_ALIGN       4096
+#define BYTE_BUFSIZE     (4*1024*1024)
+#define BYTE_SWAP_BLOCK  8192  /* words read per swap block */
+#define BYTE_MAX_MAPS    8
+#define BYTE_ZMAXN       32    /* max. points per direction, lossy mode */
+
 static FILE *fp=NULL;
 static int  flag=0;
 static char name[MAX_NAME+1];
@@ -59,31 +106,146 @@ int bytesw_read=0;
   void exitt();
 #endif
 
-void byte_reverse(float *buf, int *nn,int *ierr)
+/*
+   Byte swap kernels, picked once at runtime. All of them swap nbytes of
+   buf in place in units of wd (4 or 8) bytes.
+*/
+
+typedef void (*bswap_fun)(char *buf, size_t nbytes, int wd);
+
+static void bswap_scalar(char *buf, size_t nbytes, int wd)
 {
-  int n;
+  size_t i;
   char temp, *ptr;
 
+#if defined(__GNUC__)
+  if (wd==4) {
+    uint32_t w[4];
+    for (i=0; i+16<=nbytes; i+=16) {
+      memcpy(w,buf+i,16);
+      w[0] = __builtin_bswap32(w[0]);
+      w[1] = __builtin_bswap32(w[1]);
+      w[2] = __builtin_bswap32(w[2]);
+      w[3] = __builtin_bswap32(w[3]);
+      memcpy(buf+i,w,16);
+    }
+  } else {
+    uint64_t w[2];
+    for (i=0; i+16<=nbytes; i+=16) {
+      memcpy(w,buf+i,16);
+      w[0] = __builtin_bswap64(w[0]);
+      w[1] = __builtin_bswap64(w[1]);
+      memcpy(buf+i,w,16);
+    }
+  }
+#else
+  i = 0;
+#endif
+
+  for (ptr=buf+i; i<nbytes; i+=wd, ptr+=wd)
+  {
+    if (wd==4) {
+      SWAP(ptr[0],ptr[3])
+      SWAP(ptr[1],ptr[2])
+    } else {
+      SWAP(ptr[0],ptr[7])
+      SWAP(ptr[1],ptr[6])
+      SWAP(ptr[2],ptr[5])
+      SWAP(ptr[3],ptr[4])
+    }
+  }
+}
+
+#if defined(BYTE_SWAP_X86)
+static const char bswap_mask4[32] = { 3, 2, 1, 0, 7, 6, 5, 4,
+                                     11,10, 9, 8,15,14,13,12,
+                                      3, 2, 1, 0, 7, 6, 5, 4,
+                                     11,10, 9, 8,15,14,13,12};
+static const char bswap_mask8[32] = { 7, 6, 5, 4, 3, 2, 1, 0,
+                                     15,14,13,12,11,10, 9, 8,
+                                      7, 6, 5, 4, 3, 2, 1, 0,
+                                     15,14,13,12,11,10, 9, 8};
+
+__attribute__((target("ssse3")))
+static void bswap_ssse3(char *buf, size_t nbytes, int wd)
+{
+  size_t i;
+  __m128i m = _mm_loadu_si128((const __m128i *)(wd==4 ? bswap_mask4 :
+                                                          bswap_mask8));
+  for (i=0; i+16<=nbytes; i+=16) {
+    __m128i v = _mm_loadu_si128((__m128i *)(buf+i));
+    _mm_storeu_si128((__m128i *)(buf+i),_mm_shuffle_epi8(v,m));
+  }
+  if (i<nbytes) bswap_scalar(buf+i,nbytes-i,wd);
+}
+
+__attribute__((target("avx2")))
+static void bswap_avx2(char *buf, size_t nbytes, int wd)
+{
+  size_t i;
+  __m256i m = _mm256_loadu_si256((const __m256i *)(wd==4 ? bswap_mask4 :
+                                                             bswap_mask8));
+  for (i=0; i+64<=nbytes; i+=64) {
+    __m256i v0 = _mm256_loadu_si256((__m256i *)(buf+i));
+    __m256i v1 = _mm256_loadu_si256((__m256i *)(buf+i+32));
+    _mm256_storeu_si256((__m256i *)(buf+i)   ,_mm256_shuffle_epi8(v0,m));
+    _mm256_storeu_si256((__m256i *)(buf+i+32),_mm256_shuffle_epi8(v1,m));
+  }
+  for (; i+32<=nbytes; i+=32) {
+    __m256i v = _mm256_loadu_si256((__m256i *)(buf+i));
+    _mm256_storeu_si256((__m256i *)(buf+i),_mm256_shuffle_epi8(v,m));
+  }
+  if (i<nbytes) bswap_scalar(buf+i,nbytes-i,wd);
+}
+#endif
+
+#if defined(BYTE_SWAP_NEON)
+static void bswap_neon(char *buf, size_t nbytes, int wd)
+{
+  size_t i;
+  for (i=0; i+16<=nbytes; i+=16) {
+    uint8x16_t v = vld1q_u8((uint8_t *)(buf+i));
+    v = (wd==4) ? vrev32q_u8(v) : vrev64q_u8(v);
+    vst1q_u8((uint8_t *)(buf+i),v);
+  }
+  if (i<nbytes) bswap_scalar(buf+i,nbytes-i,wd);
+}
+#endif
+
+static bswap_fun bswap_kernel=NULL;
+
+static void bswap(char *buf, size_t nbytes, int wd)
+{
+  if (!bswap_kernel) {
+    bswap_kernel = bswap_scalar;
+#if defined(BYTE_SWAP_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      bswap_kernel = bswap_avx2;
+    else if (__builtin_cpu_supports("ssse3"))
+      bswap_kernel = bswap_ssse3;
+#elif defined(BYTE_SWAP_NEON)
+    bswap_kernel = bswap_neon;
+#endif
+  }
+  bswap_kernel(buf,nbytes,wd);
+}
+
+void byte_reverse(float *buf, int *nn,int *ierr)
+{
   if (*nn<0)
   {
     printf("byte_reverse() :: n must be positive\n"); 
     *ierr=1;
     return;
   }
-  
-  for (ptr=(char *)buf,n=*nn; n--; ptr+=4)
-  {
-     SWAP(ptr[0],ptr[3])
-     SWAP(ptr[1],ptr[2])
-  }
+
+  bswap((char *)buf,(size_t)(*nn)*4,4);
   *ierr=0;
 }
 
 void byte_reverse8(float *buf, int *nn,int *ierr)
 {
-  int n;
-  char temp, *ptr;
-
   if (*nn<0)
   {
     printf("byte_reverse8() :: n must be positive\n");
@@ -97,13 +259,7 @@ void byte_reverse8(float *buf, int *nn,int *ierr)
     return;
   }
 
-  for (ptr=(char *)buf,n=*nn,n=n+2; n-=2; ptr+=8)
-  {
-     SWAP(ptr[0],ptr[7])
-     SWAP(ptr[1],ptr[6])
-     SWAP(ptr[2],ptr[5])
-     SWAP(ptr[3],ptr[4])
-  }
+  bswap((char *)buf,(size_t)(*nn)*4,8);
   *ierr=0;
 }
 
@@ -196,10 +352,12 @@ void byte_write(float *buf, int *n,int *ierr)
 }
 
 
-void byte_read(float *buf, int *n,int *ierr)
+/* read n 4-byte words, swapping each block (word size wd) right after it
+   has arrived while it is still in cache; wd=0 means no swap */
+static void byte_read_blocked(float *buf, int *n, int wd, int *ierr)
 {
-  int flags;
-  mode_t mode;
+  size_t nw,nr,nb;
+  char  *ptr;
 
   if (*n<0)
     {printf("byte_read() :: n must be positive\n"); *ierr=1; return;}
@@ -218,22 +376,24 @@ void byte_read(float *buf, int *n,int *ierr)
 
   if (flag==READ)
   {
-     if (bytesw_read == 1)
-        byte_reverse (buf,n,ierr);
-     fread(buf,sizeof(float),*n,fp);
-     if (ferror(fp))
-     {
-       printf("ABORT: Error reading %s\n",name);
-       *ierr=1;
-       return;
-     }
-     else if (feof(fp))
+     for (ptr=(char *)buf,nw=*n; nw>0; nw-=nb, ptr+=nb*sizeof(float))
      {
-       printf("ABORT: EOF found while reading %s\n",name);
-       *ierr=1;
-       return;
+       nb = nw<BYTE_SWAP_BLOCK ? nw : BYTE_SWAP_BLOCK;
+       nr = fread(ptr,sizeof(float),nb,fp);
+       if (ferror(fp))
+       {
+         printf("ABORT: Error reading %s\n",name);
+         *ierr=1;
+         return;
+       }
+       else if (feof(fp))
+       {
+         printf("ABORT: EOF found while reading %s\n",name);
+         *ierr=1;
+         return;
+       }
+       if (wd) bswap(ptr,nr*sizeof(float),wd);
      }
-
   }
   else
   {
@@ -244,6 +404,29 @@ void byte_read(float *buf, int *n,int *ierr)
   *ierr=0;
 }
 
+void byte_read(float *buf, int *n,int *ierr)
+{
+  byte_read_blocked(buf,n,(bytesw_read == 1) ? 4 : 0,ierr);
+}
+
+/* read n 4-byte words and swap them in place using word size wdsize */
+void byte_read_swap(float *buf, int *n, int *wdsize, int *ierr)
+{
+  if (*wdsize!=4 && *wdsize!=8)
+  {
+    printf("byte_read_swap() :: invalid word size %d\n",*wdsize);
+    *ierr=1;
+    return;
+  }
+  if (*wdsize==8 && *n % 2 != 0)
+  {
+    printf("byte_read_swap() :: n must be multiple of 2\n");
+    *ierr=1;
+    return;
+  }
+  byte_read_blocked(buf,n,*wdsize,ierr);
+}
+
 void set_bytesw_write (int *pa)
 {
     if (*pa != 0)
@@ -269,3 +452,952 @@ void get_bytesw_read (int *pa)
 {
     *pa = bytesw_read;
 }
+
+/*********************************handle based I/O*****************************/
+/*
+   Handle based variant of byte_open/byte_read/byte_write which allows
+   several files to be streamed at the same time. Each handle carries its
+   own aligned buffer, so small chunks passed from the Fortran side are
+   coalesced into large read()/write() calls.
+
+     call byte_hopen (fname,ih,imode,nbuf,idirect,ierr)
+     call byte_hread (ih,buf,n,ierr)       n in 4-byte words
+     call byte_hwrite(ih,buf,n,ierr)       n in 4-byte words
+     call byte_hrewind(ih,ierr)
+     call byte_hclose(ih,ierr)
+
+   imode   : 1 read, 2 write
+   nbuf    : buffer size in bytes (<=0: $NEK_BYTE_BUFSIZE or 4MB default)
+   idirect : 1 use O_DIRECT (bypass page cache) if supported
+*/
+
+typedef struct {
+  int    fd;
+  int    mode;
+  int    direct;
+  char  *buf;
+  size_t bsize;   /* buffer capacity                     */
+  size_t pos;     /* current position within the buffer  */
+  size_t len;     /* valid bytes in buffer (read mode)   */
+  char   name[MAX_NAME+1];
+} byte_handle;
+
+static byte_handle htab[BYTE_MAX_HANDLES];
+static int htab_init=0;
+
+static void byte_make_dir(char *fname)
+{
+  int  i;
+  char dirname[MAX_NAME+1];
+
+  for (i=strlen(fname)-1; i>0; i--) if (fname[i] == '/') break;
+  if (i>0) {
+    strncpy(dirname,fname,i);
+    dirname[i] = '\0';
+    mkdir(dirname,0755);
+  }
+}
+
+static byte_handle *byte_get_handle(int *ih, const char *fun)
+{
+  if (*ih<0 || *ih>=BYTE_MAX_HANDLES || htab[*ih].fd<0)
+  {
+    printf("%s() :: invalid handle %d\n",fun,*ih);
+    return NULL;
+  }
+  return &htab[*ih];
+}
+
+static int byte_flush_handle(byte_handle *h)
+{
+  size_t nw = h->pos;
+  char  *ptr = h->buf;
+  ssize_t r;
+
+#ifdef O_DIRECT
+  /* O_DIRECT requires block aligned transfers, write the tail buffered */
+  if (h->direct && (nw % BYTE_ALIGN)) {
+    int flags = fcntl(h->fd,F_GETFL);
+    fcntl(h->fd,F_SETFL,flags & ~O_DIRECT);
+    h->direct = 0;
+  }
+#endif
+
+  while (nw>0) {
+    r = write(h->fd,ptr,nw);
+    if (r<0) {
+      if (errno==EINTR) continue;
+      printf("byte_hwrite() :: write failure on %s\n",h->name);
+      return 1;
+    }
+    nw  -= r;
+    ptr += r;
+  }
+  h->pos = 0;
+  return 0;
+}
+
+void byte_hopen(char *n, int *ih, int *imode, int *nbuf, int *idirect,
+                int *ierr, int nlen)
+{
+  int  i,k,flags;
+  char *envvar;
+  byte_handle *h;
+
+  *ierr = 1;
+  *ih   = -1;
+
+  if (!htab_init) {
+    for (k=0; k<BYTE_MAX_HANDLES; k++) htab[k].fd = -1;
+    htab_init = 1;
+  }
+
+  if (nlen>MAX_NAME)
+  {
+    printf("byte_hopen() :: invalid string length\n");
+    return;
+  }
+  if (*imode!=READ && *imode!=WRITE)
+  {
+    printf("byte_hopen() :: invalid mode %d\n",*imode);
+    return;
+  }
+
+  for (k=0; k<BYTE_MAX_HANDLES; k++) if (htab[k].fd<0) break;
+  if (k==BYTE_MAX_HANDLES)
+  {
+    printf("byte_hopen() :: too many open handles!\n");
+    return;
+  }
+  h = &htab[k];
+
+  strncpy(h->name,n,nlen);
+  h->name[nlen] = '\0';
+  for (i=nlen-1; i>=0; i--) if (h->name[i] != ' ' && h->name[i] != '\0') break;
+  h->name[i+1] = '\0';
+
+  h->bsize = BYTE_BUFSIZE;
+  if (*nbuf>0)
+    h->bsize = *nbuf;
+  else if ((envvar = getenv("NEK_BYTE_BUFSIZE")))
+    if (atol(envvar)>0) h->bsize = atol(envvar);
+  h->bsize = (h->bsize+BYTE_ALIGN-1)/BYTE_ALIGN*BYTE_ALIGN;
+
+  if (posix_memalign((void **)&h->buf,BYTE_ALIGN,h->bsize))
+  {
+    printf("byte_hopen() :: cannot allocate %zu bytes\n",h->bsize);
+    return;
+  }
+
+  if (*imode==WRITE) {
+    byte_make_dir(h->name);
+    flags = O_WRONLY | O_CREAT | O_TRUNC;
+  } else {
+    flags = O_RDONLY;
+  }
+
+  h->direct = 0;
+#ifdef O_DIRECT
+  if (*idirect==1) {
+    h->fd = open(h->name,flags | O_DIRECT,0644);
+    if (h->fd>=0) h->direct = 1;
+  } else
+    h->fd = -1;
+  if (h->fd<0)
+#endif
+  h->fd = open(h->name,flags,0644);
+
+  if (h->fd<0)
+  {
+    printf("%s\n",h->name);
+    printf("byte_hopen() :: open failure!\n");
+    free(h->buf);
+    h->buf = NULL;
+    return;
+  }
+
+  h->mode = *imode;
+  h->pos  = 0;
+  h->len  = 0;
+  *ih     = k;
+  *ierr   = 0;
+}
+
+void byte_hclose(int *ih, int *ierr)
+{
+  byte_handle *h;
+
+  *ierr = 1;
+  if (!(h = byte_get_handle(ih,"byte_hclose"))) return;
+
+  if (h->mode==WRITE) *ierr = byte_flush_handle(h);
+  else *ierr = 0;
+
+  if (close(h->fd))
+  {
+    printf("byte_hclose() :: couldn't close %s!\n",h->name);
+    *ierr = 1;
+  }
+  free(h->buf);
+  h->buf = NULL;
+  h->fd  = -1;
+}
+
+void byte_hrewind(int *ih, int *ierr)
+{
+  byte_handle *h;
+
+  *ierr = 1;
+  if (!(h = byte_get_handle(ih,"byte_hrewind"))) return;
+
+  if (h->mode==WRITE && byte_flush_handle(h)) return;
+  if (lseek(h->fd,0,SEEK_SET)<0) return;
+  h->pos = 0;
+  h->len = 0;
+  *ierr  = 0;
+}
+
+void byte_hwrite(int *ih, float *buf, int *n, int *ierr)
+{
+  size_t nb,nc;
+  char  *src = (char *)buf;
+  byte_handle *h;
+
+  *ierr = 1;
+  if (*n<0)
+  {
+    printf("byte_hwrite() :: n must be positive\n");
+    return;
+  }
+  if (!(h = byte_get_handle(ih,"byte_hwrite"))) return;
+  if (h->mode!=WRITE)
+  {
+    printf("byte_hwrite() :: can't write to a read handle!\n");
+    return;
+  }
+
+  if (bytesw_write == 1) byte_reverse(buf,n,ierr);
+
+  nb = (size_t)(*n)*sizeof(float);
+  while (nb>0) {
+    nc = h->bsize - h->pos;
+    if (nc>nb) nc = nb;
+    memcpy(h->buf+h->pos,src,nc);
+    h->pos += nc;
+    src    += nc;
+    nb     -= nc;
+    if (h->pos==h->bsize && byte_flush_handle(h)) return;
+  }
+  *ierr = 0;
+}
+
+void byte_hread(int *ih, float *buf, int *n, int *ierr)
+{
+  size_t nb,nc;
+  ssize_t r;
+  char  *dst = (char *)buf;
+  byte_handle *h;
+
+  *ierr = 1;
+  if (*n<0)
+  {
+    printf("byte_hread() :: n must be positive\n");
+    return;
+  }
+  if (!(h = byte_get_handle(ih,"byte_hread"))) return;
+  if (h->mode!=READ)
+  {
+    printf("byte_hread() :: can't read from a write handle!\n");
+    return;
+  }
+
+  nb = (size_t)(*n)*sizeof(float);
+  while (nb>0) {
+    if (h->pos==h->len) {
+      do r = read(h->fd,h->buf,h->bsize); while (r<0 && errno==EINTR);
+      if (r<0) {
+        printf("ABORT: Error reading %s\n",h->name);
+        return;
+      }
+      if (r==0) {
+        printf("ABORT: EOF found while reading %s\n",h->name);
+        return;
+      }
+      h->pos = 0;
+      h->len = r;
+    }
+    nc = h->len - h->pos;
+    if (nc>nb) nc = nb;
+    memcpy(dst,h->buf+h->pos,nc);
+    h->pos += nc;
+    dst    += nc;
+    nb     -= nc;
+  }
+
+  if (bytesw_read == 1) byte_reverse(buf,n,ierr);
+  *ierr = 0;
+}
+
+/*******************************memory mapped input****************************/
+/*
+   Read-only mapping of a whole file. Every rank maps the file and copies
+   out only the byte ranges it owns, so the kernel pages in just what is
+   touched and unrequested fields are never read from disk.
+
+     call byte_mmap_open (fname,ih,ierr)
+     call byte_mmap_read (ih,ioff,buf,n,ierr)   ioff: integer*8 byte offset
+     call byte_mmap_close(ih,ierr)                 n: 4-byte words
+*/
+
+typedef struct {
+  char  *base;
+  size_t size;
+} byte_map;
+
+static byte_map mtab[BYTE_MAX_MAPS];
+
+void byte_mmap_open(char *n, int *ih, int *ierr, int nlen)
+{
+  int  i,k,fd;
+  char fname[MAX_NAME+1];
+  struct stat st;
+  void *p;
+
+  *ierr = 1;
+  *ih   = -1;
+
+  if (nlen>MAX_NAME)
+  {
+    printf("byte_mmap_open() :: invalid string length\n");
+    return;
+  }
+  strncpy(fname,n,nlen);
+  fname[nlen] = '\0';
+  for (i=nlen-1; i>=0; i--) if (fname[i] != ' ' && fname[i] != '\0') break;
+  fname[i+1] = '\0';
+
+  for (k=0; k<BYTE_MAX_MAPS; k++) if (!mtab[k].base) break;
+  if (k==BYTE_MAX_MAPS)
+  {
+    printf("byte_mmap_open() :: too many open maps!\n");
+    return;
+  }
+
+  if ((fd = open(fname,O_RDONLY))<0 || fstat(fd,&st)<0 || st.st_size==0)
+  {
+    printf("%s\n",fname);
+    printf("byte_mmap_open() :: open failure!\n");
+    if (fd>=0) close(fd);
+    return;
+  }
+
+  p = mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (p==MAP_FAILED)
+  {
+    printf("byte_mmap_open() :: mmap failed on %s\n",fname);
+    return;
+  }
+  /* each rank touches its own scattered elements, skip the readahead */
+  madvise(p,(size_t)st.st_size,MADV_RANDOM);
+
+  mtab[k].base = (char *)p;
+  mtab[k].size = (size_t)st.st_size;
+  *ih   = k;
+  *ierr = 0;
+}
+
+void byte_mmap_read(int *ih, long long *ioff, float *buf, int *n, int *ierr)
+{
+  size_t nb;
+  byte_map *m;
+
+  *ierr = 1;
+  if (*ih<0 || *ih>=BYTE_MAX_MAPS || !mtab[*ih].base)
+  {
+    printf("byte_mmap_read() :: invalid handle %d\n",*ih);
+    return;
+  }
+  m  = &mtab[*ih];
+  nb = (size_t)(*n)*sizeof(float);
+  if (*n<0 || *ioff<0 || (size_t)(*ioff)+nb>m->size)
+  {
+    printf("byte_mmap_read() :: range %lld+%zu beyond EOF\n",*ioff,nb);
+    return;
+  }
+
+  memcpy(buf,m->base+*ioff,nb);
+  *ierr = 0;
+}
+
+void byte_mmap_close(int *ih, int *ierr)
+{
+  *ierr = 1;
+  if (*ih<0 || *ih>=BYTE_MAX_MAPS || !mtab[*ih].base)
+  {
+    printf("byte_mmap_close() :: invalid handle %d\n",*ih);
+    return;
+  }
+  if (munmap(mtab[*ih].base,mtab[*ih].size)) return;
+  mtab[*ih].base = NULL;
+  mtab[*ih].size = 0;
+  *ih   = -1;
+  *ierr = 0;
+}
+
+/*******************************compressed records*****************************/
+/*
+   Per-element records of compressed .fld files (#stz header). A record
+   holds ncomp fields of nx*ny*nz words of size wdsize and looks like
+
+     byte 0     codec: 0 raw, 1 shuffle+PackBits, 2 shuffle+zstd,
+                       3 quantized Legendre coefficients (lossy)
+     bytes 1-3  unused
+     bytes 4-   payload, padded to a multiple of 4 bytes
+
+   The lossless codecs store the byte planes of all words one after the
+   other (sign/exponent bytes of neighbouring values are almost equal) and
+   run-length or zstd code them. The lossy codec transforms every component
+   to Legendre space and rounds the coefficients to multiples of
+   step = 2*tol/(nx*ny*nz). As |P_k| <= 1 the nodal error stays below tol.
+   Whatever codec yields the smallest record is kept, a record is never
+   larger than 4 + raw bytes.
+
+     call byte_zpack  (in,ncomp,nx,ny,nz,wdsize,imode,tol,out,nbytes)
+     call byte_zunpack(in,nbytes,ncomp,nx,ny,nz,wdsize,iswap,out,ierr)
+
+   imode: 1 lossless, 2 lossy. byte_zunpack returns the data in the byte
+   order of the file, such that the usual byte_reverse logic applies;
+   iswap=1 tells it the file was written on a machine of other endianess.
+*/
+
+#define ZREC_HDR 4
+
+static char  *zscr=NULL;
+static size_t zscr_len=0;
+
+static char *zscratch(size_t n)
+{
+  if (n>zscr_len) {
+    free(zscr);
+    zscr_len = n;
+    if (!(zscr = (char *)malloc(n))) zscr_len = 0;
+  }
+  return zscr;
+}
+
+static void zshuffle(char *out, const char *in, size_t nw, int wd)
+{
+  size_t i; int b;
+  for (b=0; b<wd; b++)
+    for (i=0; i<nw; i++) out[b*nw+i] = in[i*wd+b];
+}
+
+static void zunshuffle(char *out, const char *in, size_t nw, int wd)
+{
+  size_t i; int b;
+  for (b=0; b<wd; b++)
+    for (i=0; i<nw; i++) out[i*wd+b] = in[b*nw+i];
+}
+
+/* PackBits, returns 0 if the output does not fit into cap bytes */
+static size_t zrle_enc(unsigned char *out, size_t cap,
+                       const unsigned char *in, size_t n)
+{
+  size_t i=0,o=0,r,l;
+
+  while (i<n) {
+    for (r=1; i+r<n && r<128 && in[i+r]==in[i]; r++);
+    if (r>=3) {
+      if (o+2>cap) return 0;
+      out[o++] = (unsigned char)(257-r);
+      out[o++] = in[i];
+      i += r;
+      continue;
+    }
+    for (l=1; i+l<n && l<128; l++)
+      if (i+l+2<n && in[i+l]==in[i+l+1] && in[i+l]==in[i+l+2]) break;
+    if (o+1+l>cap) return 0;
+    out[o++] = (unsigned char)(l-1);
+    memcpy(out+o,in+i,l);
+    o += l;
+    i += l;
+  }
+  return o;
+}
+
+static int zrle_dec(unsigned char *out, size_t n,
+                    const unsigned char *in, size_t len)
+{
+  size_t i=0,o=0,r;
+
+  while (i<len && o<n) {
+    r = in[i++];
+    if (r<128) {
+      r++;
+      if (i+r>len || o+r>n) return 1;
+      memcpy(out+o,in+i,r);
+      i += r;
+    } else if (r>128) {
+      r = 257-r;
+      if (i>=len || o+r>n) return 1;
+      memset(out+o,in[i++],r);
+    }
+    o += r;
+  }
+  return o!=n;
+}
+
+/* 1D Legendre transform on nx GLL points, u = V c and c = W u         */
+static double zV[BYTE_ZMAXN+1][BYTE_ZMAXN*BYTE_ZMAXN];
+static double zW[BYTE_ZMAXN+1][BYTE_ZMAXN*BYTE_ZMAXN];
+static int    zVinit[BYTE_ZMAXN+1];
+
+static void zlegendre(double *p, double x, int n)
+{
+  int k;
+  p[0] = 1.0;
+  if (n>1) p[1] = x;
+  for (k=2; k<n; k++) p[k] = ((2*k-1)*x*p[k-1] - (k-1)*p[k-2])/k;
+}
+
+static void zlegendre_setup(int n)
+{
+  int    i,j,it,N=n-1;
+  double x[BYTE_ZMAXN],w[BYTE_ZMAXN],p[BYTE_ZMAXN+1],dx,pn,pn1,dp,g;
+  double *V=zV[n],*W=zW[n];
+
+  if (zVinit[n]) return;
+
+  /* GLL points: roots of (1-x^2) P_N'(x), Newton on Chebyshev guess */
+  for (i=0; i<n; i++) {
+    x[i] = -cos(M_PI*i/N);
+    if (i>0 && i<N) for (it=0; it<100; it++) {
+      zlegendre(p,x[i],n+1);
+      pn = p[N]; pn1 = p[N-1];
+      dp = N*(pn1 - x[i]*pn)/(1-x[i]*x[i]);             /* P_N'  */
+      dx = (2*x[i]*dp - N*(N+1)*pn)/(1-x[i]*x[i]);     /* P_N'' */
+      dx = dp/dx;
+      x[i] -= dx;
+      if (fabs(dx)<1e-15) break;
+    }
+    zlegendre(p,x[i],n);
+    w[i] = 2.0/(N*(N+1)*p[N]*p[N]);
+    for (j=0; j<n; j++) V[i+j*n] = p[j];
+  }
+  /* discrete orthogonality: c_j = sum_i w_i P_j(x_i) u_i / gamma_j */
+  for (j=0; j<n; j++) {
+    g = (j<N) ? 2.0/(2*j+1) : 2.0/N;
+    for (i=0; i<n; i++) W[j+i*n] = w[i]*V[i+j*n]/g;
+  }
+  zVinit[n] = 1;
+}
+
+/* v = (Az x Ay x Ax) u, nz==1 skips the third direction */
+static void ztensor(double *v, const double *u, double *t,
+                    const double *Ax, const double *Ay, const double *Az,
+                    int nx, int ny, int nz)
+{
+  int i,j,k,l,nxy=nx*ny;
+  double s;
+
+  for (k=0; k<nz; k++) for (j=0; j<ny; j++) for (i=0; i<nx; i++) {
+    for (s=0,l=0; l<nx; l++) s += Ax[i+l*nx]*u[l+j*nx+k*nxy];
+    t[i+j*nx+k*nxy] = s;
+  }
+  for (k=0; k<nz; k++) for (j=0; j<ny; j++) for (i=0; i<nx; i++) {
+    for (s=0,l=0; l<ny; l++) s += Ay[j+l*ny]*t[i+l*nx+k*nxy];
+    v[i+j*nx+k*nxy] = s;
+  }
+  if (nz==1) return;
+  memcpy(t,v,sizeof(double)*nxy*nz);
+  for (k=0; k<nz; k++) for (j=0; j<ny; j++) for (i=0; i<nx; i++) {
+    for (s=0,l=0; l<nz; l++) s += Az[k+l*nz]*t[i+j*nx+l*nxy];
+    v[i+j*nx+k*nxy] = s;
+  }
+}
+
+static size_t zvarint(unsigned char *out, uint64_t v)
+{
+  size_t o=0;
+  while (v>=0x80) { out[o++] = (unsigned char)(v|0x80); v >>= 7; }
+  out[o++] = (unsigned char)v;
+  return o;
+}
+
+static size_t zgetvarint(const unsigned char *in, size_t len, uint64_t *v)
+{
+  size_t i=0; int sh=0;
+  *v = 0;
+  while (i<len && sh<64) {
+    *v |= (uint64_t)(in[i]&0x7f) << sh;
+    if (!(in[i++]&0x80)) return i;
+    sh += 7;
+  }
+  return 0;
+}
+
+static double *zdscr=NULL;
+static size_t  zdscr_len=0;
+
+static double *zdscratch(size_t n)
+{
+  if (n>zdscr_len) {
+    free(zdscr);
+    zdscr_len = n;
+    if (!(zdscr = (double *)malloc(n*sizeof(double)))) zdscr_len = 0;
+  }
+  return zdscr;
+}
+
+static int zlossy_ok(int nx, int ny, int nz)
+{
+  if (nx<2 || ny<2 || nx>BYTE_ZMAXN || ny>BYTE_ZMAXN || nz>BYTE_ZMAXN)
+    return 0;
+  zlegendre_setup(nx);
+  zlegendre_setup(ny);
+  if (nz>1) zlegendre_setup(nz);
+  return 1;
+}
+
+/* quantized coefficients: zigzag varints, 0 announces a run of zeros */
+static size_t zlossy_enc(unsigned char *out, size_t cap, const char *in,
+                         int ncomp, int nx, int ny, int nz, int wd, double tol)
+{
+  int    c,i,nxyz=nx*ny*nz;
+  size_t o=ZREC_HDR+sizeof(double),run=0;
+  double *u,*t,*cf,step,r;
+  int64_t q;
+  uint64_t z;
+
+  if (tol<=0 || !zlossy_ok(nx,ny,nz)) return 0;
+  if (!(u = zdscratch(3*(size_t)nxyz))) return 0;
+  t  = u+nxyz;
+  cf = t+nxyz;
+
+  step = 2*tol/nxyz;
+  memcpy(out+ZREC_HDR,&step,sizeof(double));
+
+  for (c=0; c<ncomp; c++) {
+    for (i=0; i<nxyz; i++)
+      u[i] = (wd==8) ? ((double *)in)[c*nxyz+i] : ((float *)in)[c*nxyz+i];
+    ztensor(cf,u,t,zW[nx],zW[ny],zW[nz],nx,ny,nz);
+    for (i=0; i<nxyz; i++) {
+      r = cf[i]/step;
+      if (!(fabs(r)<4.0e18)) return 0;
+      q = llround(r);
+      if (q==0) { run++; continue; }
+      if (o+22>cap) return 0;
+      if (run) { out[o++] = 0; o += zvarint(out+o,run); run = 0; }
+      z = ((uint64_t)q << 1) ^ (uint64_t)(q >> 63);
+      o += zvarint(out+o,z);
+    }
+  }
+  if (run) {
+    if (o+11>cap) return 0;
+    out[o++] = 0; o += zvarint(out+o,run);
+  }
+  return o;
+}
+
+static int zlossy_dec(char *out, const unsigned char *in, size_t len,
+                      int ncomp, int nx, int ny, int nz, int wd, int iswap)
+{
+  int    c,i,nxyz=nx*ny*nz,n=ncomp*nxyz;
+  size_t p=ZREC_HDR+sizeof(double),m,k=0;
+  double *u,*t,*cf,step;
+  uint64_t z,r;
+  char   sb[sizeof(double)];
+
+  if (len<p || !zlossy_ok(nx,ny,nz)) return 1;
+  if (!(cf = zdscratch((size_t)n+2*nxyz))) return 1;
+  u = cf+n;
+  t = u+nxyz;
+
+  memcpy(sb,in+ZREC_HDR,sizeof(double));
+  if (iswap) bswap(sb,sizeof(double),sizeof(double));
+  memcpy(&step,sb,sizeof(double));
+
+  while (k<(size_t)n) {                 /* runs may span components */
+    if (!(m = zgetvarint(in+p,len-p,&z))) return 1;
+    p += m;
+    if (z==0) {
+      if (!(m = zgetvarint(in+p,len-p,&r)) || r>(uint64_t)n-k) return 1;
+      p += m;
+      for (; r>0; r--) cf[k++] = 0;
+    } else
+      cf[k++] = step*(double)((int64_t)(z >> 1) ^ -(int64_t)(z & 1));
+  }
+
+  for (c=0; c<ncomp; c++) {
+    ztensor(u,cf+c*nxyz,t,zV[nx],zV[ny],zV[nz],nx,ny,nz);
+    if (wd==8) for (i=0; i<nxyz; i++) ((double *)out)[c*nxyz+i] = u[i];
+    else       for (i=0; i<nxyz; i++) ((float  *)out)[c*nxyz+i] = (float)u[i];
+  }
+  if (iswap) bswap(out,(size_t)n*wd,wd); /* back to file byte order */
+  return 0;
+}
+
+void byte_zpack(float *in, int *ncomp, int *nx, int *ny, int *nz,
+                int *wdsize, int *imode, double *tol, float *out, int *nbytes)
+{
+  int    wd = *wdsize;
+  size_t nw = (size_t)(*ncomp)*(*nx)*(*ny)*(*nz);
+  size_t raw = nw*wd, best = raw, n;
+  unsigned char *o = (unsigned char *)out, *sh, *tmp;
+  int    codec = 0;
+
+  sh  = (unsigned char *)zscratch(3*raw+64);
+  tmp = sh ? sh+raw : NULL;
+
+  if (sh) {
+    zshuffle((char *)sh,(char *)in,nw,wd);
+#ifdef ZSTD
+    n = ZSTD_compress(tmp,2*raw+64,sh,raw,1);
+    if (!ZSTD_isError(n) && n<best) { best = n; codec = 2; }
+#endif
+    if (codec==0) {
+      n = zrle_enc(tmp,best,sh,raw);
+      if (n>0 && n<best) { best = n; codec = 1; }
+    }
+    if (codec) memcpy(o+ZREC_HDR,tmp,best);
+
+    if (*imode==2) {
+      n = zlossy_enc(tmp,ZREC_HDR+best,(char *)in,*ncomp,*nx,*ny,*nz,wd,*tol);
+      if (n>0 && n-ZREC_HDR<best) {
+        best = n-ZREC_HDR; codec = 3;
+        memcpy(o+ZREC_HDR,tmp+ZREC_HDR,best);
+      }
+    }
+  }
+  if (codec==0) memcpy(o+ZREC_HDR,in,raw);
+
+  o[0] = (unsigned char)codec; o[1] = o[2] = o[3] = 0;
+  n = ZREC_HDR + best;
+  while (n%4) o[n++] = 0;
+  *nbytes = (int)n;
+}
+
+void byte_zunpack(float *in, int *nbytes, int *ncomp, int *nx, int *ny,
+                  int *nz, int *wdsize, int *iswap, float *out, int *ierr)
+{
+  int    wd = *wdsize;
+  size_t nw = (size_t)(*ncomp)*(*nx)*(*ny)*(*nz);
+  size_t raw = nw*wd, len = (size_t)(*nbytes);
+  unsigned char *p = (unsigned char *)in;
+  char   *sh;
+
+  *ierr = 1;
+  if (len<ZREC_HDR+4) {
+    printf("byte_zunpack() :: invalid record size %d\n",*nbytes);
+    return;
+  }
+
+  switch (p[0]) {
+  case 0:
+    if (len<ZREC_HDR+raw) break;
+    memcpy(out,p+ZREC_HDR,raw);
+    *ierr = 0;
+    break;
+  case 1:
+  case 2:
+    if (!(sh = zscratch(raw))) break;
+    if (p[0]==1) {
+      /* decoding stops after raw bytes, the padding is never looked at */
+      if (zrle_dec((unsigned char *)sh,raw,p+ZREC_HDR,len-ZREC_HDR)) break;
+    } else {
+#ifdef ZSTD
+      size_t n = ZSTD_getFrameContentSize(p+ZREC_HDR,len-ZREC_HDR);
+      if (n!=raw) break;
+      /* the frame ends before the padding, find its true size */
+      n = ZSTD_findFrameCompressedSize(p+ZREC_HDR,len-ZREC_HDR);
+      if (ZSTD_isError(n)) break;
+      if (ZSTD_decompress(sh,raw,p+ZREC_HDR,n)!=raw) break;
+#else
+      printf("byte_zunpack() :: zstd record found, compile with ZSTD\n");
+      return;
+#endif
+    }
+    zunshuffle((char *)out,sh,nw,wd);
+    *ierr = 0;
+    break;
+  case 3:
+    if (zlossy_dec((char *)out,p,len,*ncomp,*nx,*ny,*nz,wd,*iswap)) break;
+    *ierr = 0;
+    break;
+  }
+  if (*ierr) printf("byte_zunpack() :: corrupt record (codec %d)\n",p[0]);
+}
+
+/*******************************asynchronous MPI-IO****************************/
+/*
+   Staged, nonblocking MPI-IO writes behind byte_write_mpi.
+
+   After byte_async_open(fh) all byte_set_view/byte_write_mpi/byte_close_mpi
+   calls on fh are intercepted: the data is copied into a staging bank and
+   handed to MPI_File_iwrite_at, and the close is deferred. Two banks are used
+   in turns, so a new dump only waits for the one issued before the previous
+   dump. byte_async_flush drains all banks and has to be called collectively
+   (e.g. at nek_end).
+*/
+
+#define BYTE_ASYNC_NBANK 2
+
+#ifdef BYTE_ASYNC
+typedef struct {
+  char        *buf;
+  size_t       cap,pos;
+  MPI_Request *req;
+  int          nreq,mreq;
+  MPI_File     fh;
+  int          fhf;     /* Fortran handle, -1 if none   */
+  int          pending; /* deferred close outstanding   */
+  MPI_Offset   off;     /* current file position        */
+} async_bank;
+
+static async_bank abank[BYTE_ASYNC_NBANK];
+static int acur=-1;
+
+static int async_drain(async_bank *b)
+{
+  int ierr=0;
+
+  if (b->nreq>0) {
+    if (MPI_Waitall(b->nreq,b->req,MPI_STATUSES_IGNORE)!=MPI_SUCCESS)
+      ierr=1;
+    b->nreq=0;
+  }
+  b->pos=0;
+  if (b->pending) {
+    if (MPI_File_close(&b->fh)!=MPI_SUCCESS) ierr=1;
+    b->pending=0;
+  }
+  b->fhf=-1;
+  return ierr;
+}
+
+static async_bank *async_find(int fhf)
+{
+  int k;
+  if (acur<0) return NULL;
+  for (k=0; k<BYTE_ASYNC_NBANK; k++)
+    if (abank[k].fhf==fhf && !abank[k].pending) return &abank[k];
+  return NULL;
+}
+#endif
+
+void byte_async_open(int *fh, int *ierr)
+{
+  *ierr=0;
+#ifdef BYTE_ASYNC
+  int k;
+  if (acur<0)
+    for (k=0; k<BYTE_ASYNC_NBANK; k++) {
+      memset(&abank[k],0,sizeof(async_bank));
+      abank[k].fhf=-1;
+    }
+  acur = (acur+1) % BYTE_ASYNC_NBANK;
+
+  /* reuse of a bank requires its previous dump to be on disk */
+  *ierr = async_drain(&abank[acur]);
+
+  abank[acur].fh  = MPI_File_f2c((MPI_Fint)*fh);
+  abank[acur].fhf = *fh;
+  abank[acur].off = 0;
+#else
+  (void)fh;
+#endif
+}
+
+void byte_async_view(long long *ioff, int *fh, int *iasync)
+{
+  *iasync=0;
+#ifdef BYTE_ASYNC
+  async_bank *b = async_find(*fh);
+  if (!b) return;
+  b->off  = (MPI_Offset)*ioff;
+  *iasync = 1;
+#else
+  (void)ioff; (void)fh;
+#endif
+}
+
+void byte_async_write(float *buf, int *n, int *fh, int *iasync, int *ierr)
+{
+  *iasync=0;
+  *ierr=0;
+#ifdef BYTE_ASYNC
+  size_t nb = (size_t)(*n)*sizeof(float);
+  async_bank *b = async_find(*fh);
+  if (!b) return;
+  *iasync=1;
+
+  if (b->pos+nb > b->cap) {
+    /* growing moves the staging memory, so in-flight writes must finish */
+    size_t cap = 2*(b->pos+nb);
+    char *p;
+    if (b->nreq>0) {
+      MPI_Waitall(b->nreq,b->req,MPI_STATUSES_IGNORE);
+      b->nreq=0;
+    }
+    if (!(p=realloc(b->buf,cap))) {
+      printf("byte_async_write() :: cannot allocate %zu bytes\n",cap);
+      *ierr=1;
+      return;
+    }
+    b->buf=p;
+    b->cap=cap;
+    b->pos=0;
+  }
+  if (b->nreq==b->mreq) {
+    int m = b->mreq ? 2*b->mreq : 64;
+    MPI_Request *r;
+    if (b->nreq>0) {
+      /* in-flight requests must not move either */
+      MPI_Waitall(b->nreq,b->req,MPI_STATUSES_IGNORE);
+      b->nreq=0;
+    }
+    if (!(r=realloc(b->req,m*sizeof(MPI_Request)))) { *ierr=1; return; }
+    b->req=r;
+    b->mreq=m;
+  }
+
+  if (nb>0) memcpy(b->buf+b->pos,buf,nb);
+  if (MPI_File_iwrite_at(b->fh,b->off,b->buf+b->pos,*n,MPI_FLOAT,
+                         &b->req[b->nreq])!=MPI_SUCCESS)
+  {
+    printf("byte_async_write() :: MPI_File_iwrite_at failure\n");
+    *ierr=1;
+    return;
+  }
+  b->nreq++;
+  b->pos += nb;
+  b->off += nb;
+#else
+  (void)buf; (void)n; (void)fh;
+#endif
+}
+
+void byte_async_close(int *fh, int *iasync, int *ierr)
+{
+  *iasync=0;
+  *ierr=0;
+#ifdef BYTE_ASYNC
+  async_bank *b = async_find(*fh);
+  if (!b) return;
+  b->pending=1;
+  *iasync=1;
+#else
+  (void)fh;
+#endif
+}
+
+void byte_async_flush(int *ierr)
+{
+  *ierr=0;
+#ifdef BYTE_ASYNC
+  int k;
+  if (acur<0) return;
+  for (k=0; k<BYTE_ASYNC_NBANK; k++) *ierr += async_drain(&abank[k]);
+#endif
+}
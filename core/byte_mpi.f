@@ -58,6 +58,45 @@ C--------------------------------------------------------------------------
       call exitti('MPI_file_read_all unsupported!$',0)
 #endif
 
+      return
+      end
+C--------------------------------------------------------------------------
+      subroutine byte_read_mpi_swap(buf,icount,iorank,mpi_fh,wdsize,
+     $                              ifbswap,ierr)
+c
+c     read icount 4-byte words and byte swap them in place using
+c     word size wdsize (4 or 8) if requested
+c
+      real*4  buf(1)          ! buffer
+      integer wdsize
+      logical ifbswap
+
+      call byte_read_mpi(buf,icount,iorank,mpi_fh,ierr)
+      if(ierr.ne.0 .or. .not.ifbswap) return
+
+      if(wdsize.eq.8) then
+        call byte_reverse8(buf,icount,ierr)
+      else
+        call byte_reverse (buf,icount,ierr)
+      endif
+
+      return
+      end
+C--------------------------------------------------------------------------
+      subroutine byte_read_bswap(buf,icount,wdsize,ifbswap,ierr)
+c
+c     serial counterpart of byte_read_mpi_swap (uses byte_open stream)
+c
+      real*4  buf(1)          ! buffer
+      integer wdsize
+      logical ifbswap
+
+      if(ifbswap) then
+        call byte_read_swap(buf,icount,wdsize,ierr)
+      else
+        call byte_read(buf,icount,ierr)
+      endif
+
       return
       end
 C--------------------------------------------------------------------------
@@ -71,6 +110,9 @@ C--------------------------------------------------------------------------
       iout = icount ! icount is in 4-byte words
       if(iorank.ge.0 .and. nid.ne.iorank) iout = 0
 #ifndef NOMPIIO
+      call byte_async_write(buf,iout,mpi_fh,iasync,ierr) ! staged?
+      if(iasync.eq.1) return
+
       call MPI_file_write_all(mpi_fh,buf,iout,MPI_REAL,
      &                        MPI_STATUS_IGNORE,ierr)
 #else
@@ -85,6 +127,9 @@ C--------------------------------------------------------------------------
       include 'mpif.h'
 
 #ifndef NOMPIIO
+      call byte_async_close(mpi_fh,iasync,ierr) ! deferred if staged
+      if(iasync.eq.1) return
+
       call MPI_file_close(mpi_fh,ierr)
 #else
       call exitti('MPI_file_close unsupported!$',0)
@@ -101,6 +146,9 @@ C--------------------------------------------------------------------------
       if(ioff_in.lt.0) 
      & call exitti('Invalid index in MPI_file_set_view!$',ioff_in)
 #ifndef NOMPIIO
+      call byte_async_view(ioff_in,mpi_fh,iasync)
+      if(iasync.eq.1) return
+
       call MPI_file_set_view(mpi_fh,ioff_in,MPI_BYTE,MPI_BYTE,
      &                       'native',MPI_INFO_NULL,ierr)
 #endif
@@ -7,6 +7,7 @@
 #define print_stack FORTRAN_UNPREFIXED(print_stack, PRINT_STACK)
 #define sizeOfLongInt FORTRAN_UNPREFIXED(sizeoflongint, SIZEOFLONGINT)
 #define getmaxrss FORTRAN_UNPREFIXED(getmaxrss, GETMAXRSS)
+#define getstaticmem FORTRAN_UNPREFIXED(getstaticmem, GETSTATICMEM)
 #define set_stdout FORTRAN_UNPREFIXED(set_stdout, SET_STDOUT)
 
 #if defined __GLIBC__
@@ -40,6 +41,17 @@ double getmaxrss()
 #endif
 }
 
+/* size of the initialized and zero-initialized data (commons) */
+double getstaticmem()
+{
+#if defined(__linux__)
+  extern char etext, end;
+  return (double)(&end - &etext);
+#else
+  return 0.;
+#endif
+}
+
 int sizeOfLongInt()
 {
   return sizeof(long int);
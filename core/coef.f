@@ -723,6 +723,12 @@ C
       ENDIF
 C
 C     Compute geometric factors for integrated del-squared operator.
+C     With lgelt < lelt they are not stored (see GEOFAC1).
+C
+      IF (LGELT.LT.LELT) THEN
+         CALL CHKGEOFAC
+         GOTO 590
+      ENDIF
 C
       IF (ldim.EQ.2) THEN
          CALL VDOT2 (G1M1,RXM1,RYM1,RXM1,RYM1,NTOT1)
@@ -763,6 +769,7 @@ C
             CALL COL2 (G6M1(1,1,1,IEL),W3M1,NXYZ1)
          ENDIF
   580 CONTINUE
+  590 CONTINUE
 C
 C     Compute the mass matrix on mesh M1.
 C
@@ -816,9 +823,158 @@ C
 C     Compute normals, tangents, and areas on elemental surfaces
 C
       CALL SETAREA
+C
+      IF (ldim.EQ.3) CALL SETGCOMP
 C
       RETURN
       END
+c-----------------------------------------------------------------------
+      subroutine setgcomp
+c
+c     Compressed geometry for axhelm (param(183)): elements whose
+c     g1m1..g6m1 are constants times w3m1 (affine elements) keep the
+c     six constants in gcm1, igcm1 = 1.  With param(183) = 2 the other
+c     elements recompute their factors from xm1,ym1,zm1 (igcm1 = 2).
+c     Must run before sfastax overwrites g4m1..g6m1.
+c
+      include 'SIZE'
+      include 'GEOM'
+      include 'INPUT'
+      include 'TSTEP'
+      include 'WZ'
+      include 'WSPACE'
+
+      integer e,nc(2)
+      integer*8 kg
+
+      nxyz = lx1*ly1*lz1
+      call izero(igcm1,nelt)
+      if (param(183).le.0 .or. ifaxis) return
+
+      call nek_ws_push
+      kg = nek_ws_r(6*nxyz)
+
+      imode = param(183)
+      do e=1,nelt
+         if (lgelt.lt.lelt) then
+            call geofac1(ws(kg),e)
+            call gcfit(gcm1(1,e),ws(kg),ws(kg+nxyz),ws(kg+2*nxyz),
+     $                 ws(kg+3*nxyz),ws(kg+4*nxyz),ws(kg+5*nxyz),
+     $                 w3m1,nxyz,ifit)
+         else
+            call gcfit(gcm1(1,e),g1m1(1,1,1,e),g2m1(1,1,1,e),
+     $                 g3m1(1,1,1,e),g4m1(1,1,1,e),g5m1(1,1,1,e),
+     $                 g6m1(1,1,1,e),w3m1,nxyz,ifit)
+         endif
+         if (ifit.eq.1) then
+            igcm1(e) = 1
+         elseif (imode.ge.2) then
+            igcm1(e) = 2
+         endif
+      enddo
+
+      nc(1) = 0
+      nc(2) = 0
+      do e=1,nelt
+         if (igcm1(e).gt.0) nc(igcm1(e)) = nc(igcm1(e)) + 1
+      enddo
+      nc(1) = iglsum(nc(1),1)
+      nc(2) = iglsum(nc(2),1)
+      if (nio.eq.0 .and. istep.le.1) write(6,1) nc(1),nc(2)
+    1 format(' compressed geometry: ',i10,' affine ',i10,
+     $       ' recomputed elements')
+
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine geofac1(g,e)
+c
+c     g(,1..6) = g1m1..g6m1 of element e (3D), for lgelt < lelt where
+c     the factors are not stored
+c
+      include 'SIZE'
+      include 'GEOM'
+      include 'WZ'
+
+      real g(lx1*ly1*lz1,6)
+      integer e
+
+      nxyz = lx1*ly1*lz1
+      do i=1,nxyz
+         rxe = rxm1(i,1,1,e)
+         rye = rym1(i,1,1,e)
+         rze = rzm1(i,1,1,e)
+         sxe = sxm1(i,1,1,e)
+         sye = sym1(i,1,1,e)
+         sze = szm1(i,1,1,e)
+         txe = txm1(i,1,1,e)
+         tye = tym1(i,1,1,e)
+         tze = tzm1(i,1,1,e)
+         wje = w3m1(i,1,1)/jacm1(i,1,1,e)
+         g(i,1) = (rxe*rxe + rye*rye + rze*rze)*wje
+         g(i,2) = (sxe*sxe + sye*sye + sze*sze)*wje
+         g(i,3) = (txe*txe + tye*tye + tze*tze)*wje
+         g(i,4) = (rxe*sxe + rye*sye + rze*sze)*wje
+         g(i,5) = (rxe*txe + rye*tye + rze*tze)*wje
+         g(i,6) = (sxe*txe + sye*tye + sze*tze)*wje
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine chkgeofac
+c
+c     lgelt < lelt drops g1m1..g6m1.  Only the 3D Helmholtz paths that
+c     recompute them per element are allowed then: axhelm through
+c     ax3c_batch (compressedGeometry = recompute), setprec and the h1
+c     multigrid setup (geofac1).
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      ierr = 0
+      if (ldim.ne.3 .or. ifaxis .or. ifdg) ierr = 1
+      if (param(183).ne.2) ierr = 2
+#ifdef OPENACC
+      ierr = 3
+#endif
+      if (ierr.ne.0) call exitti(
+     $   'lgelt < lelt needs 3D, compressedGeometry = recompute $',ierr)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gcfit(c,g1,g2,g3,g4,g5,g6,w3,n,ifit)
+c
+c     c(k) with gk = c(k)*w3 up to roundoff, ifit = 1 if all six fit
+c
+      real c(6),g1(n),g2(n),g3(n),g4(n),g5(n),g6(n),w3(n)
+
+      gmax = max(vlamax(g1,n),vlamax(g2,n),vlamax(g3,n))
+      tol  = 1e-12*gmax
+
+      c(1) = g1(1)/w3(1)
+      c(2) = g2(1)/w3(1)
+      c(3) = g3(1)/w3(1)
+      c(4) = g4(1)/w3(1)
+      c(5) = g5(1)/w3(1)
+      c(6) = g6(1)/w3(1)
+
+      err = 0
+      do i=1,n
+         err = max(err,abs(g1(i)-c(1)*w3(i)),abs(g2(i)-c(2)*w3(i))
+     $                ,abs(g3(i)-c(3)*w3(i)),abs(g4(i)-c(4)*w3(i))
+     $                ,abs(g5(i)-c(5)*w3(i)),abs(g6(i)-c(6)*w3(i)))
+      enddo
+
+      ifit = 0
+      if (err.le.tol) ifit = 1
+
+      return
+      end
+c-----------------------------------------------------------------------
       subroutine geom2
 C-------------------------------------------------------------------
 C
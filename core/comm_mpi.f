@@ -16,7 +16,18 @@ c-----------------------------------------------------------------------
 
       ! Init MPI
       call mpi_initialized(mpi_is_initialized, ierr)
+#if defined(OPENMP) && defined(MPI)
+      ! threads only run element loops, all MPI calls stay on the master
+      if (mpi_is_initialized .eq. 0 ) then
+         call mpi_init_thread(MPI_THREAD_FUNNELED,iprov,ierr)
+         if (iprov.lt.MPI_THREAD_FUNNELED) then
+            write(6,*) 'ABORT: MPI_THREAD_FUNNELED not supported!'
+            call mpi_abort(MPI_COMM_WORLD,1,ierr)
+         endif
+      endif
+#else
       if (mpi_is_initialized .eq. 0 ) call mpi_init(ierr)
+#endif
       call mpi_comm_size(MPI_COMM_WORLD,np_global,ierr)
       call mpi_comm_rank(MPI_COMM_WORLD,nid_global,ierr)
 
@@ -144,6 +155,9 @@ c---------------------------------------------------------------------
       common /nekmpi/ nid_,np_,nekcomm,nekgroup,nekreal
 
       logical flag
+#ifdef OPENMP
+      integer omp_get_max_threads
+#endif
 
       nid  = mynode()
       nid_ = nid
@@ -197,6 +211,9 @@ C     Test timer accuracy
 
       if (nid.eq.nio) then 
          write(6,*) 'Number of processors:',np
+#ifdef OPENMP
+         write(6,*) 'Threads per rank    :',omp_get_max_threads()
+#endif
          WRITE(6,*) 'REAL    wdsize      :',WDSIZE
          WRITE(6,*) 'INTEGER wdsize      :',ISIZE
          WRITE(6,'(A,1pE8.2)') ' Timer accuracy      : ',edif
@@ -247,6 +264,73 @@ c
 
       call copy(x,w,n)
 
+#ifdef TIMER
+      tgop =tgop +(dnekclock()-etime1)
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gop_begin( x, w, op, n, ireq)
+c
+c     Start a nonblocking gop of x into w; gop_end completes it.
+c     Neither x nor w may be touched in between.
+c
+      include 'CTIMER'
+
+      include 'mpif.h'
+      common /nekmpi/ nid,np,nekcomm,nekgroup,nekreal
+
+      real x(n), w(n)
+      character*3 op
+
+      if (ifsync) call nekgsync()
+
+#ifdef TIMER
+      ngop = ngop + 1
+      etime1=dnekclock()
+#endif
+
+      if (np.eq.1) then
+         call copy(w,x,n)
+         ireq = -1
+      elseif (op.eq.'+  ') then
+         call mpi_iallreduce (x,w,n,nekreal,mpi_sum ,nekcomm,ireq,ierr)
+      elseif (op.EQ.'M  ') then
+         call mpi_iallreduce (x,w,n,nekreal,mpi_max ,nekcomm,ireq,ierr)
+      elseif (op.EQ.'m  ') then
+         call mpi_iallreduce (x,w,n,nekreal,mpi_min ,nekcomm,ireq,ierr)
+      else
+         write(6,*) nid,' OP ',op,' not supported.  ABORT in GOP_BEGIN.'
+         call exitt
+      endif
+
+#ifdef TIMER
+      tgop =tgop +(dnekclock()-etime1)
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gop_end( x, w, n, ireq)
+c
+c     Complete gop_begin: x := reduced values
+c
+      include 'CTIMER'
+
+      include 'mpif.h'
+      common /nekmpi/ nid,np,nekcomm,nekgroup,nekreal
+
+      real x(n), w(n)
+      integer status(mpi_status_size)
+
+#ifdef TIMER
+      etime1=dnekclock()
+#endif
+
+      if (ireq.ne.-1) call mpi_wait (ireq,status,ierr)
+      call copy(x,w,n)
+
 #ifdef TIMER
       tgop =tgop +(dnekclock()-etime1)
 #endif
@@ -629,6 +713,38 @@ c      if (nid.eq.0) call close_files
 c      call print_runtime_info
       call nek_die(1) 
  
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine print_mem_info
+c
+c     Static capacity (lelt) against what the ranks actually use. The
+c     commons are reserved for lelt elements but only the pages of
+c     the local elements get touched.
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      real*8 wcur,wpeak,wheld
+
+      dstat = glmax(getstaticmem(),1)/1e9
+      drss  = glmax(getmaxrss(),1)/1e9
+      call nek_ws_stats(wcur,wpeak,wheld)
+      wpk   = wpeak
+      dws   = glmax(wpk,1)/1e9
+      nemax = iglmax(nelt,1)
+      nemin = iglmin(nelt,1)
+
+      if (nid.eq.0) then
+         write(6,'(A,2i10,A,i10)')
+     &      ' local elements min/max       : ',nemin,nemax,
+     &      '   lelt: ',lelt
+         write(6,'(3(A,1p1e13.5,A,/))')
+     &       ' static memory per rank       : ',dstat, ' GB'
+     &      ,' max workspace per rank       : ',dws  , ' GB'
+     &      ,' max resident memory per rank : ',drss , ' GB'
+      endif
+
       return
       end
 c-----------------------------------------------------------------------
@@ -638,6 +754,8 @@ c-----------------------------------------------------------------------
       include 'CTIMER'
       include 'mpif.h'
 
+      real*8 wcur,wpeak,wheld
+
 #ifdef PAPI
       gflops = glsum(dnekgflops(),1)
 #endif
@@ -648,6 +766,9 @@ c-----------------------------------------------------------------------
       nxyz   = lx1*ly1*lz1
 
       dtmp4 = glsum(getmaxrss(),1)/1e9
+      call nek_ws_stats(wcur,wpeak,wheld)
+      wpk   = wpeak
+      dtmp5 = glmax(wpk,1)/1e9
 
       if (nid.eq.0) then 
          dtmp1 = 0
@@ -661,12 +782,13 @@ c-----------------------------------------------------------------------
            dtmp2 = (ttime-tprep)/max(istep,1)
          endif 
          write(6,*) ' '
-         write(6,'(5(A,1p1e13.5,A,/))') 
+         write(6,'(6(A,1p1e13.5,A,/))') 
      &       'total elapsed time             : ',ttotal, ' sec'
      &      ,'total solver time w/o IO       : ',tsol,   ' sec'
      &      ,'time/timestep                  : ',dtmp2 , ' sec'
      &      ,'avg throughput per timestep    : ',dtmp1 , ' gridpts/CPUs'
      &      ,'total max memory usage         : ',dtmp4 , ' GB'
+     &      ,'max workspace per rank         : ',dtmp5 , ' GB'
 #ifdef PAPI
          write(6,'(1(A,1p1e13.5,/))') 
      &      ,'total Gflops/s                 : ',gflops
@@ -106,6 +106,171 @@ C        Radiation case, smooth convergence, avoid flip-flop (ER).
       return
       end
 
+c-----------------------------------------------------------------------
+      subroutine cdscal_block (igeom,ifdone)
+C
+C     Block solve of the passive scalars at t^n (param(184)).  Scalars
+C     with the same Helmholtz operator (mesh, h1, h2, mask and mult)
+C     are solved together by hmholtz_block.  ifdone(ifield) flags the
+C     fields done here, the others are left to cdscal.
+C
+      include 'SIZE'
+      include 'INPUT'
+      include 'SOLN'
+      include 'TSTEP'
+      include 'WSPACE'
+
+      logical ifdone(ldimt1)
+
+      parameter (lb=ldimt1)
+      integer     jf(lb),jg(lb),jm(lb)
+      real        eq(lb,lb),wk(lb*lb)
+      character*4 name(lb)
+      logical     ifstdh,ifsame
+
+      integer*8 kh,ka,kx,kr,kh1,kh2
+
+      do i=1,ldimt1
+         ifdone(i) = .false.
+      enddo
+
+#ifdef OPENACC
+      return               ! hmholtz keeps its operands on the device
+#endif
+      if (igeom.ne.2 .or. param(184).eq.0 .or. .not.iftran) return
+
+c     Candidates: cdscal cases that reduce to a single cggo call
+      nc = 0
+      do ifield=2,nfield
+         ifstdh = .not.ifprojfld(ifield) .or. param(93).eq.0 .or.
+     $            param(94).eq.0 .or. istep.lt.param(94) .or.
+     $            ifield.gt.ldimt_proj+1
+         if (idpss(ifield-1).eq.0 .and. .not.ifdgfld(ifield) .and.
+     $       .not.ifcvfld(ifield) .and. .not.ifnonl(ifield) .and.
+     $       .not.ifpipefld(ifield) .and. ifstdh .and.
+     $       .not.(ifaxis.and.ifaziv.and.ifield.eq.2)) then
+            nc = nc+1
+            jf(nc) = ifield
+         endif
+      enddo
+      if (nc.lt.2) return
+
+      ln = lx1*ly1*lz1*nelt
+
+      call nek_ws_push
+      kh = nek_ws_r(2*ln*nc)     ! h1,h2 of each candidate
+      ka = nek_ws_r(ln)
+
+      do i=1,nc
+         ifield = jf(i)
+         n      = lx1*ly1*lz1*nelfld(ifield)
+         intype = -1
+         if (.not.iftmsh(ifield)) imesh = 1
+         if (     iftmsh(ifield)) imesh = 2
+         call unorm
+         call settolt
+         kh1 = kh+2*(i-1)*ln
+         kh2 = kh1+ln
+         call sethlm  (ws(kh1),ws(kh2),intype)
+         call bcneusc (ws(ka),-1)
+         call add2    (ws(kh2),ws(ka),n)
+      enddo
+
+c     eq(i,j) = 1 if i and j have the same operator, eq(i,i) = -max h2
+c     (a zero h2 needs the mean correction of cggo), min over all ranks
+      call rzero(eq,lb*lb)
+      do j=1,nc
+         n = lx1*ly1*lz1*nelfld(jf(j))
+         eq(j,j) = -vlmax(ws(kh+(2*j-1)*ln),n)
+         do i=1,j-1
+            eq(i,j) = 0
+            ni = lx1*ly1*lz1*nelfld(jf(i))
+            if (n.eq.ni .and. (iftmsh(jf(i)).eqv.iftmsh(jf(j)))) then
+               eq(i,j) = 1
+               if (.not.ifsame(ws(kh+2*(i-1)*ln),ws(kh+2*(j-1)*ln),n)
+     $        .or. .not.ifsame(ws(kh+(2*i-1)*ln),ws(kh+(2*j-1)*ln),n)
+     $        .or. .not.ifsame(tmask(1,1,1,1,jf(i)-1)
+     $                        ,tmask(1,1,1,1,jf(j)-1),n)
+     $        .or. .not.ifsame(tmult(1,1,1,1,jf(i)-1)
+     $                        ,tmult(1,1,1,1,jf(j)-1),n)) eq(i,j) = 0
+            endif
+            eq(j,i) = eq(i,j)
+         enddo
+      enddo
+      call gop(eq,wk,'m  ',lb*lb)
+
+      do j=1,nc
+         jg(j) = j
+         do i=j-1,1,-1
+            if (jg(i).eq.i .and. eq(i,j).gt.0 .and. eq(i,i).lt.0)
+     $         jg(j) = i
+         enddo
+      enddo
+
+      do ig=1,nc
+         nb = 0
+         do j=ig,nc
+            if (jg(j).eq.ig) then
+               nb = nb+1
+               jm(nb) = jf(j)
+            endif
+         enddo
+         if (nb.lt.2 .or. eq(ig,ig).ge.0) goto 100
+
+         ifield = jf(ig)
+         n      = lx1*ly1*lz1*nelfld(ifield)
+         imesh  = 1
+         if (iftmsh(ifield)) imesh = 2
+         kh1 = kh+2*(ig-1)*ln
+         kh2 = kh1+ln
+
+         call nek_ws_push
+         kx = nek_ws_r(n*nb)
+         kr = nek_ws_r(n*nb)
+         do k=1,nb
+            ifield = jm(k)
+            i = ifield-1
+            write(name(k),'(a2,i2)') 'PS',i-1
+            if (ifield.eq.2) name(k) = 'TEMP'
+            call bcdirsc (t(1,1,1,1,i))
+            call axhelm  (ws(ka),t(1,1,1,1,i),ws(kh1),ws(kh2),imesh,1)
+            call sub3    (ws(kr+(k-1)*n),bq(1,1,1,1,i),ws(ka),n)
+            call bcneusc (ws(ka),1)
+            call add2    (ws(kr+(k-1)*n),ws(ka),n)
+         enddo
+
+         ifield = jf(ig)
+         call hmholtz_block(name,ws(kx),ws(kr),jm,nb,n,ws(kh1),ws(kh2)
+     $                     ,tmask(1,1,1,1,ifield-1)
+     $                     ,tmult(1,1,1,1,ifield-1),imesh,nmxh,1)
+
+         do k=1,nb
+            call add2 (t(1,1,1,1,jm(k)-1),ws(kx+(k-1)*n),n)
+            ifdone(jm(k)) = .true.
+         enddo
+         call nek_ws_pop
+  100    continue
+      enddo
+
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      logical function ifsame(a,b,n)
+c
+c     true if a(1:n) and b(1:n) are identical (local)
+c
+      real a(n),b(n)
+
+      ifsame = .false.
+      do i=1,n
+         if (a(i).ne.b(i)) return
+      enddo
+      ifsame = .true.
+
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine makeuq
 
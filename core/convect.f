@@ -31,6 +31,7 @@ c-----------------------------------------------------------------------
       subroutine setup_convect(igeom)
       include 'SIZE'
       include 'TOTAL'
+      include 'WSPACE'
       logical ifnew
 
       common /cchar/ ct_vx(0:lorder+1) ! time for each slice in c_vx()
@@ -50,27 +51,31 @@ c-----------------------------------------------------------------------
          if (ifmhd) nelc = max(nelv,nelfld(ifldmhd))
          if (ifmhd) call exitti('no characteristics for mhd yet$',istep)
 
+         call char_alloc
+
          ifnew = .true.
          if (igeom.gt.2) ifnew = .false.
 
          if (ifgeom) then ! Moving mesh
             call opsub3(cx,cy,cz,vx,vy,vz,wx,wy,wz)
-            call set_conv_char(ct_vx,c_vx,cx,cy,cz,nelc,time,ifnew)
+            call set_conv_char(ct_vx,ws(kc_vx),cx,cy,cz,nelc,time,
+     $                         ifnew)
             call set_char_mask(hmsk,cx,cy,cz) ! mask for hyperbolic system 
          else
-            call set_conv_char(ct_vx,c_vx,vx,vy,vz,nelc,time,ifnew)
+            call set_conv_char(ct_vx,ws(kc_vx),vx,vy,vz,nelc,time,
+     $                         ifnew)
             call set_char_mask(hmsk,vx,vy,vz) ! mask for hyperbolic system 
          endif
 
          n=lx1*ly1*lz1*nelv
          call rone(hmsk,n)          ! TEST: TURN OFF MASK
-         call set_binv (bmnv, hmsk,n) ! Store binvm1*(hyperbolic mask)
+         call set_binv (ws(kbmnv),hmsk,n) ! Store binvm1*(hyperbolic mask)
          if(ifmvbd) then
-            call set_bdivw(bdivw,hmsk,n) ! Store Bdivw *(hyperbolic mask)
+            call set_bdivw(ws(kbdivw),hmsk,n) ! Store Bdivw *(hyperbolic mask)
          else
-            call rzero(bdivw,n*lorder)
+            call rzero(ws(kbdivw),n*lorder)
          endif
-         call set_bmass(bmass,hmsk,n) ! Store binvm1*(hyperbolic mask)
+         call set_bmass(ws(kbmass),hmsk,n) ! Store binvm1*(hyperbolic mask)
 
       else
 
@@ -98,21 +103,63 @@ c
 c
       include 'SIZE'
       include 'TOTAL'
+      include 'WSPACE'
+
       real    p0(1),u(1),ulag(1),bm(1),bmlag(1),msk(1),c(1),cs(0:1)
       integer gsl
 
+      integer*8 kh
+
+      ln  = lx1*ly1*lz1*lelt
+      n   = lx1*ly1*lz1*nelfld(ifield)
+
+      call nek_ws_push
+      kh = nek_ws_r(n*nbd)
+      call char_hist (ws(kh),u,ulag,n,ln,nbd)
+      call char_conv_many (p0,ws(kh),1,bm,bmlag,c,cs,gsl)
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine char_hist(uh,u,ulag,n,ln,nh)
+
+c     Gather u and its nh-1 lagged slices into uh(n,nh)
+
+      real uh(n,nh),u(n),ulag(ln,1)
+
+      call copy(uh,u,n)
+      do k=2,nh
+         call copy(uh(1,k),ulag(1,k-1),n)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine char_conv_many(p0,uh,nf,bm,bmlag,c,cs,gsl)
+c
+c     Characteristics scheme for nf fields advected by the same c,
+c     uh(n,nbd,nf) holds u and its lagged slices for each field
+c
+c     The interpolated convecting field, mass and divergence terms of
+c     each RK stage are computed once for all fields, and each stage
+c     applies c to every field with a single gather-scatter.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'WSPACE'
+
+      real    p0(1),uh(1),bm(1),bmlag(1),c(1),cs(0:1)
+      integer gsl
+
       common /scrns/ ct  (lxd*lyd*lzd*lelv*ldim)
 
       common /scrvh/ bmsk(lx1*ly1*lz1*lelv)
      $             , bdwt(lx1*ly1*lz1*lelv)
      $             , bmst(lx1*ly1*lz1*lelv)
-     $             , u1  (lx1*ly1*lz1*lelv)
 
-      common /scrmg/ r1  (lx1*ly1*lz1*lelv)
-     $             , r2  (lx1*ly1*lz1*lelv)
-     $             , r3  (lx1*ly1*lz1*lelv)
-     $             , r4  (lx1*ly1*lz1*lelv)
-      
+      integer*8 ku,nu
+
       nelc = nelv            ! number of elements in convecting field
       if (ifield.eq.ifldmhd) nelc = nelfld(ifield)
 
@@ -122,26 +169,33 @@ c
       n   = lx1*ly1*lz1*nelfld(ifield)
       m   = lxd*lyd*lzd*nelc*ldim
 
-c      if(nid.eq.0) write(*,*) 'going into char_conv1 '
-      call char_conv1 (p0,u,bmnv,n,ulag,ln,gsl,c,m,cs(1),nc,ct
-     $  ,u1,r1,r2,r3,r4,bmsk,bdivw,bdwt,bmass,bmst,bm,bmlag)
+      call nek_ws_push       ! u1, r1-r4 for nf fields
+      nu = n*nf
+      ku = nek_ws_r(5*n*nf)
+
+      call char_conv1 (p0,uh,nf,nbd,ws(kbmnv),n,ln,gsl,c,m,cs(1),nc,ct
+     $  ,ws(ku),ws(ku+nu),ws(ku+2*nu),ws(ku+3*nu),ws(ku+4*nu)
+     $  ,bmsk,ws(kbdivw),bdwt,ws(kbmass),bmst,bm,bmlag)
+
+      call nek_ws_pop
 
       return
       end
 c-----------------------------------------------------------------------
-      subroutine char_conv1 (p0,u,bmnv,n,ulag,ln,gsl,c,m,cs,nc,ct
+      subroutine char_conv1 (p0,uh,nf,nh,bmnv,n,ln,gsl,c,m,cs,nc,ct
      $  ,u1,r1,r2,r3,r4,bmsk,bdivw,bdwt,bmass,bmst,bm,bmlag)
 
       include 'SIZE'
       include 'INPUT'
       include 'TSTEP'
 
-      real p0(n),u(n),bmnv(n,1),ulag(ln,1),c(m,0:nc),cs(0:nc),bdivw(n,1)
-     $          ,bm(n), bmlag(ln,1)
+      real p0(n,nf),uh(n,nh,nf),bmnv(n,1),c(m,0:nc),cs(0:nc)
+     $    ,bdivw(n,1),bmass(n,1),bm(n),bmlag(ln,1)
 
-      real ct(m),u1(n),r1(n),r2(n),r3(n),r4(n),bmsk(n),bdwt(n) ! work arrays
+      real ct(m),bmsk(n),bdwt(n),bmst(n)                 ! work arrays
+      real u1(n,nf),r1(n,nf),r2(n,nf),r3(n,nf),r4(n,nf)
 
-      integer gsl
+      integer gsl,f
 
 
 !     Convect over last NBD steps using characteristics scheme
@@ -164,35 +218,30 @@ c-----------------------------------------------------------------------
 !     n = lx1*ly1*lz1*nelv
 !     m = lxd*lyd*lzd*nelv
 
+!     Each of the nf fields is carried through the same stages, uh(,q,)
+!     is the slice n-q.
+
       tau = time-vlsum(dtlag,nbd)              ! initialize time for u^n-k
       call int_vel (ct  ,tau,c    ,m,nc,cs,nid) ! ct(t) = sum w_k c(.,k)
       call int_vel (bmsk,tau,bmnv ,n,nc,cs,nid) ! B^-1(t^n-1)
       call int_vel (bmst,tau,bmass,n,nc,cs,nid) ! B(t^n-1)
       call int_vel (bdwt,tau,bdivw,n,nc,cs,nid) ! BdivW(t^n-1)
 
-      call rzero(p0,n)
+      call rzero(p0,n*nf)
 
       do ilag = nbd,1,-1
 
-         um = 0
-         if (ilag.eq.1) then
-            do i=1,n
-               p0(i) = p0(i)+bd(ilag+1)*u(i)*bm(i)
-               um=max(um,u(i))
-            enddo
-         else
-           if(ifmvbd) then
+         do f=1,nf
+           if (ilag.eq.1 .or. .not.ifmvbd) then
             do i=1,n
-               p0(i) = p0(i)+bd(ilag+1)*ulag(i,ilag-1)*bmlag(i,ilag-1)
-               um=max(um,ulag(i,ilag-1))
+               p0(i,f) = p0(i,f)+bd(ilag+1)*uh(i,ilag,f)*bm(i)
             enddo
            else
             do i=1,n
-               p0(i) = p0(i)+bd(ilag+1)*ulag(i,ilag-1)*bm(i)
-               um=max(um,ulag(i,ilag-1))
+               p0(i,f) = p0(i,f)+bd(ilag+1)*uh(i,ilag,f)*bmlag(i,ilag-1)
             enddo
            endif
-         endif
+         enddo
 
          dtau = dtlag(ilag)/ntaubd
          do itau = 1,ntaubd ! ntaubd=number of RK4 substeps (typ. 1 or 2)
@@ -204,39 +253,51 @@ c-----------------------------------------------------------------------
             c3 = -dtau
             th = tau+dtau/2.
 
-            call invcol3 (u1,p0,bmst,n)
-            call conv_rhs(r1,u1,ct,bmsk,bmst,bdwt,gsl)          ! STAGE 1
-            call col2    (r1,bmst,n)     !             ! r1 = B(n-1)* r1
-
-            call add3s12 (u1,p0,r1,c1,c2,n)
+            do f=1,nf
+               call invcol3 (u1(1,f),p0(1,f),bmst,n)
+            enddo
+            call conv_rhs_many(r1,u1,n,nf,ct,bmsk,bmst,bdwt,gsl) ! 1
+            do f=1,nf
+               call col2    (r1(1,f),bmst,n)       ! r1 = B(n-1)* r1
+               call add3s12 (u1(1,f),p0(1,f),r1(1,f),c1,c2,n)
+            enddo
             call int_vel (bmst,th,bmass,n,nc,cs,nid)   ! B(n-1/2)
-            call invcol2 (u1,bmst,n)                   ! u2=B(n-1/2)
+            do f=1,nf
+               call invcol2 (u1(1,f),bmst,n)           ! u2=B(n-1/2)
+            enddo
 
             call int_vel (ct  ,th,c    ,m,nc,cs,nid)   ! STAGE 2
             call int_vel (bmsk,th,bmnv ,n,nc,cs,nid)   ! B^-1(n-1/2)
             call int_vel (bdwt,th,bdivw,n,nc,cs,nid)   ! BdivW(n-1/2)
-            call conv_rhs(r2,u1,ct,bmsk,bmst,bdwt,gsl)
-            call col2    (r2,bmst,n)     !  du = B          * du
-
-            call add3s12 (u1,p0,r2,c1,c2,n)           ! STAGE 3
-            call invcol2 (u1,bmst,n)
-            call conv_rhs(r3,u1,ct,bmsk,bmst,bdwt,gsl)          ! B(n-1/2) (still)
-            call col2    (r3,bmst,n)     !  du = B          * du
-
-            call add3s12 (u1,p0,r3,c1,c3,n)
+            call conv_rhs_many(r2,u1,n,nf,ct,bmsk,bmst,bdwt,gsl)
+            do f=1,nf
+               call col2    (r2(1,f),bmst,n)       !  du = B * du
+               call add3s12 (u1(1,f),p0(1,f),r2(1,f),c1,c2,n) ! STAGE 3
+               call invcol2 (u1(1,f),bmst,n)
+            enddo
+            call conv_rhs_many(r3,u1,n,nf,ct,bmsk,bmst,bdwt,gsl)
+            do f=1,nf
+               call col2    (r3(1,f),bmst,n)       ! B(n-1/2) (still)
+               call add3s12 (u1(1,f),p0(1,f),r3(1,f),c1,c3,n)
+            enddo
             call int_vel (bmst,tau1,bmass,n,nc,cs,nid) ! B^-1(n)
-            call invcol2 (u1,bmst,n)                   ! u2=B(n-1/2)
+            do f=1,nf
+               call invcol2 (u1(1,f),bmst,n)           ! u2=B(n-1/2)
+            enddo
 
             call int_vel (ct  ,tau1,c    ,m,nc,cs,nid) ! STAGE 4
             call int_vel (bmsk,tau1,bmnv ,n,nc,cs,nid) ! B^-1(n)
             call int_vel (bdwt,tau1,bdivw,n,nc,cs,nid) ! BdivW(n)
-            call conv_rhs(r4,u1,ct,bmsk,bmst,bdwt,gsl)
-            call col2    (r4,bmst,n)     !  du = B          * du
+            call conv_rhs_many(r4,u1,n,nf,ct,bmsk,bmst,bdwt,gsl)
 
             c1 = -dtau/6.
             c2 = -dtau/3.
+            do f=1,nf
             do i=1,n
-               p0(i) = p0(i)+c1*(r1(i)+r4(i))+c2*(r2(i)+r3(i))
+               r4(i,f) = r4(i,f)*bmst(i)   !  du = B * du
+               p0(i,f) = p0(i,f)+c1*(r1(i,f)+r4(i,f))
+     $                          +c2*(r2(i,f)+r3(i,f))
+            enddo
             enddo
             tau = tau1
          enddo
@@ -318,6 +379,98 @@ c
          call rzero   (du,n)
       endif
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine conv_rhs_many (du,u,n,nf,c,bmsk,bmst,bdwt,gsl)
+c
+      include 'SIZE'
+      include 'TOTAL'
+c
+c     apply convecting field c(1,ldim) to the nf scalar fields u(n,nf),
+c     the direct stiffness sum is done for all fields in one exchange
+c
+      real du(n,nf),u(n,nf),c(1),bmsk(1),bmst(1),bdwt(1)
+      integer gsl,f
+
+      if (ifdgfld(ifield) .or. ifcons) then
+         do f=1,nf
+            call conv_rhs (du(1,f),u(1,f),c,bmsk,bmst,bdwt,gsl)
+         enddo
+         return
+      endif
+
+      nd = lxd*lyd*lzd
+      call convop_fst_many (du,u,n,nf,c,nd,lx1,lxd,nelv,if3d)
+
+      do f=1,nf
+         call subcol3(du(1,f),bdwt,u(1,f),n)
+      enddo
+      call fgslib_gs_op_fields (gsl,du,n,nf,1,1,0)  !  +
+      do f=1,nf
+         call col2 (du(1,f),bmsk,n)     !  du = Binv * msk * du
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine convop_fst_many(du,u,n,nf,c,nd,mx,md,nel,if3d)
+c
+c     convop_fst_3d/2d for nf fields: the interpolation and derivative
+c     operators are looked up once, and the fine-grid convecting field
+c     of an element is applied to all fields while it is in cache
+c
+      include 'SIZE'
+c
+      real du(n,nf),u(n,nf),c(nd,nel,*)
+      logical if3d
+c
+      parameter (ldd=lxd*lyd*lzd)
+      common /ctmp1/ ur(ldd),us(ldd),ut(ldd),ud(ldd),ju(ldd)
+      real ju
+c
+      parameter (ldg=lxd**3,lwkd=4*lxd*lxd)
+      common /dgrad/ d(ldg),dt(ldg),dg(ldg),dgt(ldg),jgl(ldg),jgt(ldg)
+     $             , wkd(lwkd)
+      real jgl,jgt
+c
+      parameter (ld=2*lxd)
+      common /ctmp0/ w(ld**ldim,2)
+c
+      integer e,f
+c
+      call lim_chk(nd,ldd,'urus ','ldd  ','convop_fm ')
+      call lim_chk(md,ld ,'md   ','ld   ','convop_fm ')
+      call lim_chk(mx,ld ,'mx   ','ld   ','convop_fm ')
+
+      ldw  = 2*(ld**ldim)
+      nxyz = mx*mx
+      if (if3d) nxyz = nxyz*mx
+      m0   = md-1
+
+      call get_int_ptr (ij,mx,md)
+      call get_dgl_ptr (ip,md,md)
+c
+      do e=1,nel
+         k = 1 + (e-1)*nxyz
+         do f=1,nf
+            call specmpn(ju,md,u(k,f),mx,jgl(ij),jgt(ij),if3d,w,ldw)
+            if (if3d) then
+               call local_grad3(ur,us,ut,ju,m0,1,dg(ip),dgt(ip))
+               do i=1,nd
+c                 C has the mass matrix factored in per (4.8.5), DFM.
+                  ud(i) = c(i,e,1)*ur(i)+c(i,e,2)*us(i)+c(i,e,3)*ut(i)
+               enddo
+            else
+               call local_grad2(ur,us,ju,m0,1,dg(ip),dgt(ip))
+               do i=1,nd
+                  ud(i) = c(i,e,1)*ur(i)+c(i,e,2)*us(i)
+               enddo
+            endif
+            call specmpn(du(k,f),mx,ud,md,jgt(ij),jgl(ij),if3d,w,ldw)
+         enddo
+      enddo
+c
       return
       end
 c-----------------------------------------------------------------------
@@ -625,6 +778,35 @@ c
          call gen_dgl(dg (ip),dgt(ip),md,mx,wkd)
       endif
 c
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine char_alloc
+c
+c     Allocate the characteristics history (see SOLN) for the local
+c     elements on first use; nelv does not change afterwards since
+c     rebalancing is off with ifchar (rebal_init).
+c
+      include 'SIZE'
+      include 'SOLN'
+      include 'WSPACE'
+
+      integer*8 nek_ws_rkeep
+
+      if (kc_vx.ne.0) return
+
+      n = lx1*ly1*lz1*nelt*(lorder+1)
+      kbmnv  = nek_ws_rkeep(n)
+      kbmass = nek_ws_rkeep(n)
+      kbdivw = nek_ws_rkeep(n)
+      call rzero(ws(kbmnv) ,n)
+      call rzero(ws(kbmass),n)
+      call rzero(ws(kbdivw),n)
+
+      n = lxd*lyd*lzd*nelv*ldim*(lorder+1)
+      kc_vx  = nek_ws_rkeep(n)
+      call rzero(ws(kc_vx),n)
+
       return
       end
 c-----------------------------------------------------------------------
@@ -638,7 +820,7 @@ c-----------------------------------------------------------------------
       integer nelc               ! number of elements in conv. field
       logical ifnew              ! =true if shifting stack of fields
 
-      numr      = lxd*lyd*lzd*lelv*ldim*(lorder+1)
+      numr      = lxd*lyd*lzd*nelv*ldim*(lorder+1) ! see char_alloc
       denr      = lxd*lyd*lzd*nelv*ldim
       nconv_max = numr/denr
       if (nconv_max.lt.nbdinp+1) 
@@ -813,6 +995,154 @@ C
 
       enddo
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine convect_new_many(bdu,u,nf,ld,cx,cy,cz)
+
+C     convect_new for nf fields u(ld,nf) on the coarse mesh and C
+C     already in rst form on the fine mesh (ifuf=.false., ifcf=.true.).
+C     An element's C is applied to all fields while it is in cache.
+C
+      include 'SIZE'
+      include 'TOTAL'
+
+      real bdu(ld,nf),u(ld,nf),cx(1),cy(1),cz(1)
+
+      parameter (lxy=lx1*ly1*lz1,ltd=lxd*lyd*lzd)
+      common /scrcv/ fx(ltd),fy(ltd),fz(ltd)
+     $             , ur(ltd),us(ltd),ut(ltd)
+     $             , tr(ltd,3),uf(ltd)
+
+      integer e,f
+
+      call set_dealias_rx
+
+      nxyz1 = lx1*ly1*lz1
+      nxyzd = lxd*lyd*lzd
+
+      do e=1,nelv
+         ic = (e-1)*nxyzd
+         ib = (e-1)*nxyz1 + 1
+         do f=1,nf
+            call intp_rstd(uf,u(ib,f),lx1,lxd,if3d,0) ! 0 --> forward
+            call grad_rst(ur,us,ut,uf,lxd,if3d)
+            if (if3d) then
+               do i=1,nxyzd ! mass matrix included, per DFM (4.8.5)
+                  uf(i) = cx(ic+i)*ur(i)+cy(ic+i)*us(i)+cz(ic+i)*ut(i)
+               enddo
+            else
+               do i=1,nxyzd ! mass matrix included, per DFM (4.8.5)
+                  uf(i) = cx(ic+i)*ur(i)+cy(ic+i)*us(i)
+               enddo
+            endif
+            call intp_rstd(bdu(ib,f),uf,lx1,lxd,if3d,1) ! back to coarse
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine convect_pert_many(bdu,bdv,bdw,ux,uy,uz,ld,nfp,cx,cy,cz)
+
+C     Dealiased linearized convection of nfp perturbations u(ld,nfp)
+C     about the base flow C (all on the coarse mesh):
+C
+C        b = J^T Bf [ JC.grad Ju + Ju.grad JC ]
+C
+C     i.e. convect_new of u with C plus convect_new of C with u.  The
+C     base flow is interpolated and differentiated once per element
+C     for all perturbations, and the two terms are summed on the fine
+C     mesh so each component is projected back only once.
+C
+      include 'SIZE'
+      include 'TOTAL'
+
+      real bdu(ld,nfp),bdv(ld,nfp),bdw(ld,nfp)
+      real ux(ld,nfp),uy(ld,nfp),uz(ld,nfp),cx(1),cy(1),cz(1)
+
+      parameter (lxy=lx1*ly1*lz1,ltd=lxd*lyd*lzd)
+      common /scrcvp/ fc(ltd,3),tc(ltd,3),gc(ltd,3,3)
+     $              , fu(ltd,3),tu(ltd,3),ur(ltd),us(ltd),ut(ltd)
+     $              , uf(ltd)
+
+      integer e
+
+      call set_dealias_rx
+
+      nxyz1 = lx1*ly1*lz1
+      nxyzd = lxd*lyd*lzd
+
+      do e=1,nelv
+         ib = (e-1)*nxyz1 + 1
+
+c        Base flow on the fine mesh, its rst form and its gradients
+
+         call intp_rstd(fc(1,1),cx(ib),lx1,lxd,if3d,0) ! 0 --> forward
+         call intp_rstd(fc(1,2),cy(ib),lx1,lxd,if3d,0)
+         if (if3d) call intp_rstd(fc(1,3),cz(ib),lx1,lxd,if3d,0)
+         call set_convect_rst(tc,fc,e)
+         do j=1,ldim
+            call grad_rst(gc(1,1,j),gc(1,2,j),gc(1,3,j),fc(1,j)
+     $                   ,lxd,if3d)
+         enddo
+
+         do jp=1,nfp
+            call intp_rstd(fu(1,1),ux(ib,jp),lx1,lxd,if3d,0)
+            call intp_rstd(fu(1,2),uy(ib,jp),lx1,lxd,if3d,0)
+            if (if3d) call intp_rstd(fu(1,3),uz(ib,jp),lx1,lxd,if3d,0)
+            call set_convect_rst(tu,fu,e)
+
+            do j=1,ldim
+               call grad_rst(ur,us,ut,fu(1,j),lxd,if3d)
+               if (if3d) then
+                  do i=1,nxyzd ! mass matrix included, per DFM (4.8.5)
+                     uf(i) = tc(i,1)*ur(i)+tc(i,2)*us(i)+tc(i,3)*ut(i)
+     $                     + tu(i,1)*gc(i,1,j)+tu(i,2)*gc(i,2,j)
+     $                     + tu(i,3)*gc(i,3,j)
+                  enddo
+               else
+                  do i=1,nxyzd
+                     uf(i) = tc(i,1)*ur(i)+tc(i,2)*us(i)
+     $                     + tu(i,1)*gc(i,1,j)+tu(i,2)*gc(i,2,j)
+                  enddo
+               endif
+               if (j.eq.1) call intp_rstd(bdu(ib,jp),uf,lx1,lxd,if3d,1)
+               if (j.eq.2) call intp_rstd(bdv(ib,jp),uf,lx1,lxd,if3d,1)
+               if (j.eq.3) call intp_rstd(bdw(ib,jp),uf,lx1,lxd,if3d,1)
+            enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine set_convect_rst(tr,f,e)
+C
+C     Convert the fine mesh convector f of element e to rst form
+C
+      include 'SIZE'
+      include 'TOTAL'
+
+      parameter (ltd=lxd*lyd*lzd)
+      real tr(ltd,3),f(ltd,3)
+      integer e
+
+      nxyzd = lxd*lyd*lzd
+
+      if (if3d) then
+         do i=1,nxyzd
+            tr(i,1)=rx(i,1,e)*f(i,1)+rx(i,2,e)*f(i,2)+rx(i,3,e)*f(i,3)
+            tr(i,2)=rx(i,4,e)*f(i,1)+rx(i,5,e)*f(i,2)+rx(i,6,e)*f(i,3)
+            tr(i,3)=rx(i,7,e)*f(i,1)+rx(i,8,e)*f(i,2)+rx(i,9,e)*f(i,3)
+         enddo
+      else
+         do i=1,nxyzd
+            tr(i,1)=rx(i,1,e)*f(i,1)+rx(i,2,e)*f(i,2)
+            tr(i,2)=rx(i,3,e)*f(i,1)+rx(i,4,e)*f(i,2)
+         enddo
+      endif
+
       return
       end
 c-----------------------------------------------------------------------
@@ -1046,13 +1376,13 @@ c
       include 'PARALLEL'
 
       include 'CTIMER'
+      include 'WSPACE'
 
       common /cchar/ ct_vx(0:lorder) ! time for each slice in c_vx()
 
-      common /scruz/ phx  (lx1*ly1*lz1*lelt)
-     $ ,             phy  (lx1*ly1*lz1*lelt)
-     $ ,             phz  (lx1*ly1*lz1*lelt)
-     $ ,             hmsk (lx1*ly1*lz1*lelt)
+      common /scruz/ hmsk (lx1*ly1*lz1*lelt)
+
+      integer*8 kh,kx,ky,kz
 
       if (icalld.eq.0) tadvc=0.0
       icalld=icalld+1
@@ -1061,11 +1391,20 @@ c
 
       dti = 1./dt
       n   = lx1*ly1*lz1*nelv
+      ln  = lx1*ly1*lz1*lelt
 
-      call char_conv(phx,vx,vxlag,bm1,bm1lag,hmsk,c_vx,ct_vx,gsh_fld(1))
-      call char_conv(phy,vy,vylag,bm1,bm1lag,hmsk,c_vx,ct_vx,gsh_fld(1))
-      if (if3d) call char_conv
-     $              (phz,vz,vzlag,bm1,bm1lag,hmsk,c_vx,ct_vx,gsh_fld(1))
+c     All velocity components in one pass
+      call nek_ws_push
+      kx = nek_ws_r(n*ldim)
+      ky = kx+n
+      kz = ky+n
+      kh = nek_ws_r(n*nbd*ldim)
+      call char_hist(ws(kh)          ,vx,vxlag,n,ln,nbd)
+      call char_hist(ws(kh+  n*nbd)  ,vy,vylag,n,ln,nbd)
+      if (if3d)
+     $call char_hist(ws(kh+2*n*nbd)  ,vz,vzlag,n,ln,nbd)
+      call char_conv_many
+     $   (ws(kx),ws(kh),ldim,bm1,bm1lag,ws(kc_vx),ct_vx,gsh_fld(1))
 
       call cfill(hmsk,dti,n)
       if(.not. iflomach) call col2(hmsk,vtrans,n) 
@@ -1074,20 +1413,21 @@ c
 
         do i=1,n
            h2i = hmsk(i)
-           bfx(i,1,1,1) = bfx(i,1,1,1)+phx(i)*h2i
-           bfy(i,1,1,1) = bfy(i,1,1,1)+phy(i)*h2i
-           bfz(i,1,1,1) = bfz(i,1,1,1)+phz(i)*h2i
+           bfx(i,1,1,1) = bfx(i,1,1,1)+ws(kx+i-1)*h2i
+           bfy(i,1,1,1) = bfy(i,1,1,1)+ws(ky+i-1)*h2i
+           bfz(i,1,1,1) = bfz(i,1,1,1)+ws(kz+i-1)*h2i
         enddo
 
       else
         
         do i=1,n
            h2i = hmsk(i)
-           bfx(i,1,1,1) = bfx(i,1,1,1)+phx(i)*h2i
-           bfy(i,1,1,1) = bfy(i,1,1,1)+phy(i)*h2i
+           bfx(i,1,1,1) = bfx(i,1,1,1)+ws(kx+i-1)*h2i
+           bfy(i,1,1,1) = bfy(i,1,1,1)+ws(ky+i-1)*h2i
         enddo
 
       endif
+      call nek_ws_pop
 
       tadvc=tadvc+(dnekclock()-etime1)
 
@@ -1109,9 +1449,14 @@ c     operator-integrator-factor method (characteristics).
 
       common /cchar/ ct_vx(0:lorder) ! time for each slice in c_vx()
 
+      include 'WSPACE'
+
       common /scruz/ phi  (lx1*ly1*lz1*lelt)
      $ ,             hmsk (lx1*ly1*lz1*lelt)
 
+      common /ccharb/ kchph,nchph,ichph(ldimt1)
+      integer*8 kchph
+
       if (icalld.eq.0) tadvc=0.0
       icalld=icalld+1
       nadvc=icalld
@@ -1121,8 +1466,18 @@ c     operator-integrator-factor method (characteristics).
       dti = 1./dt
 
       if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'convch', ifield
-      call char_conv(phi,t(1,1,1,1,ifield-1),tlag(1,1,1,1,1,ifield-1)
-     $        ,bm1,bm1lag,hmsk,c_vx,ct_vx,gsh_fld(1))
+
+      j = 0
+      do i=1,nchph
+         if (ichph(i).eq.ifield) j = i
+      enddo
+
+      if (j.gt.0) then   ! done by setup_char_scal
+         call copy(phi,ws(kchph+(j-1)*n),n)
+      else
+         call char_conv(phi,t(1,1,1,1,ifield-1),tlag(1,1,1,1,1,ifield-1)
+     $        ,bm1,bm1lag,hmsk,ws(kc_vx),ct_vx,gsh_fld(1))
+      endif
 
       do i=1,n
          bq(i,1,1,1,ifield-1) = bq(i,1,1,1,ifield-1)
@@ -1131,6 +1486,93 @@ c     operator-integrator-factor method (characteristics).
 
       tadvc=tadvc+(dnekclock()-etime1)
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine setup_char_scal
+c
+c     Characteristics for all advected scalars of the step in batched
+c     passes (see char_conv_many).  The results are reserved in the
+c     caller's workspace frame, convch picks them up by field number
+c     until free_char_scal is called.
+c
+      include 'SIZE'
+      include 'MASS'
+      include 'INPUT'
+      include 'SOLN'
+      include 'TSTEP'
+      include 'PARALLEL'
+      include 'CTIMER'
+      include 'WSPACE'
+
+      common /cchar/ ct_vx(0:lorder) ! time for each slice in c_vx()
+
+      common /ccharb/ kchph,nchph,ichph(ldimt1)
+      integer*8 kchph
+
+      parameter (lbat=4)             ! scalars per pass
+      integer*8 kh,kp
+      integer   f
+
+      nchph = 0
+      if (.not.(ifchar.and.iftran)) return
+
+      nf = 0
+      do ifld=2,nfield
+         if (idpss(ifld-1).eq.0 .and. ifadvc(ifld) .and.
+     $       .not.ifcvfld(ifld) .and. .not.ifdgfld(ifld) .and.
+     $       nelfld(ifld).eq.nelv) then
+            nf = nf+1
+            ichph(nf) = ifld
+         endif
+      enddo
+      if (nf.lt.2) return    ! nothing to share, leave it to convch
+
+      etime1=dnekclock()
+
+      n   = lx1*ly1*lz1*nelv
+      ln  = lx1*ly1*lz1*lelt
+
+      kchph = nek_ws_r(n*nf)
+      ifld0 = ifield
+
+      do j0=1,nf,lbat
+         nb = min(lbat,nf-j0+1)
+         ifield = ichph(j0)
+
+         call nek_ws_push
+         kh = nek_ws_r(n*nbd*nb)
+         do f=1,nb
+            i = ichph(j0+f-1)-1
+            call char_hist(ws(kh+(f-1)*n*nbd),t(1,1,1,1,i)
+     $                    ,tlag(1,1,1,1,1,i),n,ln,nbd)
+         enddo
+         kp = kchph+(j0-1)*n
+         call char_conv_many
+     $      (ws(kp),ws(kh),nb,bm1,bm1lag,ws(kc_vx),ct_vx,gsh_fld(1))
+         call nek_ws_pop
+      enddo
+
+      ifield = ifld0
+      nchph  = nf
+
+      tadvc=tadvc+(dnekclock()-etime1)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine free_char_scal
+c
+c     Drop the scalar characteristics of setup_char_scal, call before
+c     releasing the workspace frame that holds them
+c
+      include 'SIZE'
+
+      common /ccharb/ kchph,nchph,ichph(ldimt1)
+      integer*8 kchph
+
+      nchph = 0
+
       return
       end
 c-----------------------------------------------------------------------
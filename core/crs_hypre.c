@@ -0,0 +1,336 @@
+/*
+ * In-process AMG coarse grid solver (BoomerAMG from hypre)
+ *
+ * Selected by pressure:preconditioner = semg_amg_hypre (param 40 = 2)
+ * and built with PPLIST HYPRE.  The setup takes the arguments of
+ * fgslib_crs_setup: n local coarse dofs with global ids id[] (0 marks
+ * a Dirichlet dof) and the unassembled matrix (ia, ja, a) in local
+ * indices.  Global ids are distributed in contiguous blocks over the
+ * ranks; every rank sends its matrix entries and rhs contributions to
+ * the owner of the row.  Ids that do not occur (or only as Dirichlet
+ * dofs) get an identity row.  With a null space the row of the last
+ * id is pinned, the rhs is made mean free and so is the solution.
+ *
+ * The solve applies a fixed number of V-cycles (tolerance 0), so the
+ * coarse solve stays a fixed linear operator like XXT.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "name.h"
+
+#define crs_hypre_setup FORTRAN_UNPREFIXED(crs_hypre_setup,CRS_HYPRE_SETUP)
+#define crs_hypre_solve FORTRAN_UNPREFIXED(crs_hypre_solve,CRS_HYPRE_SOLVE)
+#define crs_hypre_free  FORTRAN_UNPREFIXED(crs_hypre_free ,CRS_HYPRE_FREE )
+
+#if defined(HYPRE) && defined(MPI)
+
+#include <mpi.h>
+#include "HYPRE.h"
+#include "HYPRE_parcsr_ls.h"
+
+#define CRS_HYPRE_MAX 16
+
+struct crs_hypre {
+  MPI_Comm comm;
+  int np, nid;
+  int n;                  /* local dofs                       */
+  int *u;                 /* local dof -> unique id, -1: none */
+  int nu;                 /* unique local ids                 */
+  int *scnt, *sdsp;       /* unique ids per owner rank        */
+  int nr, *rcnt, *rdsp;   /* ids received by the owner        */
+  int *rrow;              /* their local row                  */
+  long long ilower, iupper, ng, gpin;
+  int null_space;
+  double *bu, *br, *xr;
+  HYPRE_IJMatrix A;
+  HYPRE_IJVector b, x;
+  HYPRE_ParCSRMatrix parA;
+  HYPRE_ParVector parb, parx;
+  HYPRE_Solver amg;
+};
+
+static struct crs_hypre *crs_h[CRS_HYPRE_MAX];
+
+struct tri { long long r, c; double v; };
+
+static int cmp_ll(const void *a, const void *b)
+{
+  const long long *x = (const long long *)a, *y = (const long long *)b;
+  return x[0] < y[0] ? -1 : (x[0] > y[0] ? 1 : 0);
+}
+
+static int cmp_tri(const void *a, const void *b)
+{
+  const struct tri *x = (const struct tri *)a, *y = (const struct tri *)b;
+  if (x->r != y->r) return x->r < y->r ? -1 : 1;
+  if (x->c != y->c) return x->c < y->c ? -1 : 1;
+  return 0;
+}
+
+static int owner(const struct crs_hypre *h, long long g)
+{
+  long long bs = (h->ng + h->np - 1)/h->np;
+  return (int)((g - 1)/bs);
+}
+
+static void fail(const char *msg)
+{
+  fprintf(stderr, "crs_hypre: %s\n", msg);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+void crs_hypre_setup(int *handle, MPI_Fint *fcomm, int *np, int *n,
+                     const long long *id, int *nz, const int *ia,
+                     const int *ja, const double *a, int *null_space)
+{
+  struct crs_hypre *h;
+  long long *gi, ngl, bs;
+  int i, j, k, p, m, ih, *tcnt, *tdsp, *tcnt_r, *tdsp_r, ntr, *mrk;
+  struct tri *ts, *tr;
+  MPI_Datatype ttype;
+
+  for (ih = 0; ih < CRS_HYPRE_MAX && crs_h[ih]; ih++) ;
+  if (ih == CRS_HYPRE_MAX) fail("too many handles");
+  h = crs_h[ih] = calloc(1, sizeof(struct crs_hypre));
+
+  h->comm = MPI_Comm_f2c(*fcomm);
+  MPI_Comm_size(h->comm, &h->np);
+  MPI_Comm_rank(h->comm, &h->nid);
+  h->n = *n;
+  h->null_space = *null_space;
+
+  ngl = 0;
+  for (i = 0; i < h->n; i++) if (id[i] > ngl) ngl = id[i];
+  MPI_Allreduce(&ngl, &h->ng, 1, MPI_LONG_LONG, MPI_MAX, h->comm);
+  if (h->ng == 0) h->ng = 1;
+  bs = (h->ng + h->np - 1)/h->np;
+  h->ilower = (long long)h->nid*bs;
+  h->iupper = (long long)(h->nid + 1)*bs - 1;
+  if (h->iupper > h->ng - 1) h->iupper = h->ng - 1;
+  if (h->ilower > h->iupper) h->iupper = h->ilower - 1;
+  h->gpin = h->null_space ? h->ng : 0;
+
+  /* unique local ids, sorted, hence grouped by owner */
+  gi = malloc(2*sizeof(long long)*(h->n + 1));
+  for (i = m = 0; i < h->n; i++)
+    if (id[i] > 0) { gi[2*m] = id[i]; gi[2*m + 1] = i; m++; }
+  qsort(gi, m, 2*sizeof(long long), cmp_ll);
+  h->u = malloc(sizeof(int)*(h->n + 1));
+  for (i = 0; i < h->n; i++) h->u[i] = -1;
+  for (i = 0, h->nu = 0; i < m; i++) {
+    if (i > 0 && gi[2*i] != gi[2*(i - 1)]) h->nu++;
+    h->u[gi[2*i + 1]] = h->nu;
+  }
+  if (m > 0) h->nu++;
+
+  h->scnt = calloc(h->np, sizeof(int));
+  h->sdsp = calloc(h->np, sizeof(int));
+  h->rcnt = calloc(h->np, sizeof(int));
+  h->rdsp = calloc(h->np, sizeof(int));
+  {
+    long long *us = malloc(sizeof(long long)*(h->nu + 1)), *ur;
+    for (i = 0; i < m; i++) us[h->u[gi[2*i + 1]]] = gi[2*i];
+    for (j = 0; j < h->nu; j++) h->scnt[owner(h, us[j])]++;
+    for (p = 1; p < h->np; p++) h->sdsp[p] = h->sdsp[p-1] + h->scnt[p-1];
+    MPI_Alltoall(h->scnt, 1, MPI_INT, h->rcnt, 1, MPI_INT, h->comm);
+    for (p = 1; p < h->np; p++) h->rdsp[p] = h->rdsp[p-1] + h->rcnt[p-1];
+    h->nr = h->rdsp[h->np-1] + h->rcnt[h->np-1];
+    ur = malloc(sizeof(long long)*(h->nr + 1));
+    MPI_Alltoallv(us, h->scnt, h->sdsp, MPI_LONG_LONG,
+                  ur, h->rcnt, h->rdsp, MPI_LONG_LONG, h->comm);
+    h->rrow = malloc(sizeof(int)*(h->nr + 1));
+    for (i = 0; i < h->nr; i++) h->rrow[i] = (int)(ur[i] - 1 - h->ilower);
+    free(ur);
+    free(us);
+  }
+  free(gi);
+
+  /* matrix entries to the owner of the row */
+  tcnt = calloc(h->np, sizeof(int));
+  tdsp = calloc(h->np, sizeof(int));
+  tcnt_r = calloc(h->np, sizeof(int));
+  tdsp_r = calloc(h->np, sizeof(int));
+  for (k = 0; k < *nz; k++) {
+    long long r = id[ia[k]], c = id[ja[k]];
+    if (r > 0 && c > 0) tcnt[owner(h, r)]++;
+  }
+  for (p = 1; p < h->np; p++) tdsp[p] = tdsp[p-1] + tcnt[p-1];
+  ts = malloc(sizeof(struct tri)*(tdsp[h->np-1] + tcnt[h->np-1] + 1));
+  {
+    int *pos = malloc(sizeof(int)*h->np);
+    memcpy(pos, tdsp, sizeof(int)*h->np);
+    for (k = 0; k < *nz; k++) {
+      long long r = id[ia[k]], c = id[ja[k]];
+      if (r > 0 && c > 0) {
+        struct tri *t = &ts[pos[owner(h, r)]++];
+        t->r = r; t->c = c; t->v = a[k];
+      }
+    }
+    free(pos);
+  }
+  MPI_Alltoall(tcnt, 1, MPI_INT, tcnt_r, 1, MPI_INT, h->comm);
+  for (p = 1; p < h->np; p++) tdsp_r[p] = tdsp_r[p-1] + tcnt_r[p-1];
+  ntr = tdsp_r[h->np-1] + tcnt_r[h->np-1];
+  tr = malloc(sizeof(struct tri)*(ntr + 1));
+  MPI_Type_contiguous(sizeof(struct tri), MPI_BYTE, &ttype);
+  MPI_Type_commit(&ttype);
+  MPI_Alltoallv(ts, tcnt, tdsp, ttype, tr, tcnt_r, tdsp_r, ttype, h->comm);
+  MPI_Type_free(&ttype);
+  free(ts); free(tcnt); free(tdsp); free(tcnt_r); free(tdsp_r);
+
+  /* sum duplicates, pin the null space row, identity for empty rows */
+  qsort(tr, ntr, sizeof(struct tri), cmp_tri);
+  for (i = 0, j = -1; i < ntr; i++) {
+    if (h->gpin && (tr[i].r == h->gpin || tr[i].c == h->gpin)) continue;
+    if (j >= 0 && tr[j].r == tr[i].r && tr[j].c == tr[i].c)
+      tr[j].v += tr[i].v;
+    else
+      tr[++j] = tr[i];
+  }
+  ntr = j + 1;
+
+  m = (int)(h->iupper - h->ilower + 1);
+  HYPRE_IJMatrixCreate(h->comm, h->ilower, h->iupper, h->ilower, h->iupper,
+                       &h->A);
+  HYPRE_IJMatrixSetObjectType(h->A, HYPRE_PARCSR);
+  HYPRE_IJMatrixInitialize(h->A);
+  mrk = calloc(m + 1, sizeof(int));
+  for (i = 0; i < ntr; ) {
+    HYPRE_BigInt row = tr[i].r - 1, cols[1024];
+    double vals[1024];
+    HYPRE_Int nc = 0;
+    while (i < ntr && tr[i].r - 1 == row && nc < 1024) {
+      cols[nc] = tr[i].c - 1; vals[nc] = tr[i].v; nc++; i++;
+    }
+    HYPRE_IJMatrixAddToValues(h->A, 1, &nc, &row, cols, vals);
+    mrk[row - h->ilower] = 1;
+  }
+  for (i = 0; i < m; i++) if (!mrk[i]) {
+    HYPRE_BigInt row = h->ilower + i;
+    HYPRE_Int nc = 1;
+    double one = 1.0;
+    HYPRE_IJMatrixAddToValues(h->A, 1, &nc, &row, &row, &one);
+  }
+  free(mrk);
+  free(tr);
+  HYPRE_IJMatrixAssemble(h->A);
+  HYPRE_IJMatrixGetObject(h->A, (void **)&h->parA);
+
+  HYPRE_IJVectorCreate(h->comm, h->ilower, h->iupper, &h->b);
+  HYPRE_IJVectorSetObjectType(h->b, HYPRE_PARCSR);
+  HYPRE_IJVectorInitialize(h->b);
+  HYPRE_IJVectorAssemble(h->b);
+  HYPRE_IJVectorGetObject(h->b, (void **)&h->parb);
+  HYPRE_IJVectorCreate(h->comm, h->ilower, h->iupper, &h->x);
+  HYPRE_IJVectorSetObjectType(h->x, HYPRE_PARCSR);
+  HYPRE_IJVectorInitialize(h->x);
+  HYPRE_IJVectorAssemble(h->x);
+  HYPRE_IJVectorGetObject(h->x, (void **)&h->parx);
+
+  h->bu = malloc(sizeof(double)*(h->nu + 1));
+  h->br = malloc(sizeof(double)*(h->nr + 1));
+  h->xr = malloc(sizeof(double)*(m + 1));
+
+  HYPRE_BoomerAMGCreate(&h->amg);
+  HYPRE_BoomerAMGSetCoarsenType(h->amg, 10);       /* HMIS          */
+  HYPRE_BoomerAMGSetInterpType(h->amg, 6);         /* extended+i    */
+  HYPRE_BoomerAMGSetPMaxElmts(h->amg, 4);
+  HYPRE_BoomerAMGSetStrongThreshold(h->amg, 0.25);
+  HYPRE_BoomerAMGSetCycleRelaxType(h->amg, 18, 1); /* l1-Jacobi     */
+  HYPRE_BoomerAMGSetCycleRelaxType(h->amg, 18, 2);
+  HYPRE_BoomerAMGSetCycleRelaxType(h->amg, 9, 3);  /* direct coarsest */
+  HYPRE_BoomerAMGSetNumSweeps(h->amg, 1);
+  HYPRE_BoomerAMGSetMaxCoarseSize(h->amg, 100);
+  HYPRE_BoomerAMGSetTol(h->amg, 0.0);
+  HYPRE_BoomerAMGSetMaxIter(h->amg, 1);
+  HYPRE_BoomerAMGSetPrintLevel(h->amg, 0);
+  HYPRE_BoomerAMGSetup(h->amg, h->parA, h->parb, h->parx);
+
+  *handle = ih;
+}
+
+void crs_hypre_solve(int *handle, double *x, const double *b)
+{
+  struct crs_hypre *h = crs_h[*handle];
+  int i, m = (int)(h->iupper - h->ilower + 1);
+  HYPRE_BigInt *rows = malloc(sizeof(HYPRE_BigInt)*(m + 1));
+  double s, sg;
+
+  /* unassembled rhs -> owned rows */
+  for (i = 0; i < h->nu; i++) h->bu[i] = 0;
+  for (i = 0; i < h->n; i++) if (h->u[i] >= 0) h->bu[h->u[i]] += b[i];
+  MPI_Alltoallv(h->bu, h->scnt, h->sdsp, MPI_DOUBLE,
+                h->br, h->rcnt, h->rdsp, MPI_DOUBLE, h->comm);
+  for (i = 0; i < m; i++) { h->xr[i] = 0; rows[i] = h->ilower + i; }
+  for (i = 0; i < h->nr; i++) h->xr[h->rrow[i]] += h->br[i];
+
+  if (h->null_space) {
+    for (i = 0, s = 0; i < h->nr; i++) s += h->br[i];
+    MPI_Allreduce(&s, &sg, 1, MPI_DOUBLE, MPI_SUM, h->comm);
+    for (i = 0; i < m; i++) h->xr[i] -= sg/h->ng;
+    if (h->gpin - 1 >= h->ilower && h->gpin - 1 <= h->iupper)
+      h->xr[h->gpin - 1 - h->ilower] = 0;
+  }
+
+  HYPRE_IJVectorSetValues(h->b, m, rows, h->xr);
+  for (i = 0; i < m; i++) h->xr[i] = 0;
+  HYPRE_IJVectorSetValues(h->x, m, rows, h->xr);
+  HYPRE_BoomerAMGSolve(h->amg, h->parA, h->parb, h->parx);
+  HYPRE_IJVectorGetValues(h->x, m, rows, h->xr);
+
+  if (h->null_space) {
+    for (i = 0, s = 0; i < m; i++) s += h->xr[i];
+    MPI_Allreduce(&s, &sg, 1, MPI_DOUBLE, MPI_SUM, h->comm);
+    for (i = 0; i < m; i++) h->xr[i] -= sg/h->ng;
+  }
+
+  /* owned rows -> local dofs */
+  for (i = 0; i < h->nr; i++) h->br[i] = h->xr[h->rrow[i]];
+  MPI_Alltoallv(h->br, h->rcnt, h->rdsp, MPI_DOUBLE,
+                h->bu, h->scnt, h->sdsp, MPI_DOUBLE, h->comm);
+  for (i = 0; i < h->n; i++) x[i] = h->u[i] >= 0 ? h->bu[h->u[i]] : 0;
+
+  free(rows);
+}
+
+void crs_hypre_free(int *handle)
+{
+  struct crs_hypre *h = crs_h[*handle];
+  if (!h) return;
+  HYPRE_BoomerAMGDestroy(h->amg);
+  HYPRE_IJMatrixDestroy(h->A);
+  HYPRE_IJVectorDestroy(h->b);
+  HYPRE_IJVectorDestroy(h->x);
+  free(h->u); free(h->scnt); free(h->sdsp); free(h->rcnt); free(h->rdsp);
+  free(h->rrow); free(h->bu); free(h->br); free(h->xr);
+  free(h);
+  crs_h[*handle] = 0;
+}
+
+#else
+
+static void crs_hypre_fail(void)
+{
+  fprintf(stderr, "ERROR: semg_amg_hypre requires PPLIST HYPRE (and MPI)\n");
+  exit(1);
+}
+
+void crs_hypre_setup(int *handle, int *comm, int *np, int *n,
+                     const long long *id, int *nz, const int *ia,
+                     const int *ja, const double *a, int *null_space)
+{
+  (void)handle; (void)comm; (void)np; (void)n; (void)id;
+  (void)nz; (void)ia; (void)ja; (void)a; (void)null_space;
+  crs_hypre_fail();
+}
+
+void crs_hypre_solve(int *handle, double *x, const double *b)
+{
+  (void)handle; (void)x; (void)b;
+  crs_hypre_fail();
+}
+
+void crs_hypre_free(int *handle) { (void)handle; }
+
+#endif
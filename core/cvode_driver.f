@@ -105,6 +105,8 @@ c----------------------------------------------------------------------
       cv_ipretype = param(167) ! 0: no, 1:left, 2: right
       cv_maxl     = 20         ! max dimension of Krylov subspace
       cv_iatol    = 2          ! 1: scalar 2: vector
+      cv_ifcrhs   = param(185).gt.0 ! transport frozen per step
+      cv_ifljv    = param(186).gt.0 ! point-local Jacobian
 
       ! setup absolute tolerances
       if (cv_iatol.eq.1) then
@@ -193,6 +195,10 @@ c----------------------------------------------------------------------
      &                         cv_dtmax
         write(6,'(A,f5.3)')  '   increment factor         DQJ   : ',
      &                         cv_sigs
+        write(6,'(A,L2)')     '   cached rhs                     : ',
+     &                         cv_ifcrhs
+        write(6,'(A,L2)')     '   local jacobian                 : ',
+     &                         cv_ifljv
         write(6,'(A,g15.3,A,/)') ' done :: initializing CVODE',
      &                         etime1, ' sec'
       endif
@@ -261,6 +267,9 @@ c
       call copy(vy_,vy,ntot)            
       if (if3d) call copy(vz_,vz,ntot)  
 
+      ! cached rhs: freeze geometry and transport at the end of the step
+      if (cv_ifcrhs) call cv_upd_tran
+
       ! MAIN solver call
       time_ = time
       call fcvsetrin('MAX_STEP',cv_dtmax,ier)
@@ -434,9 +443,7 @@ c
       real time_,y(*),ydot(*),rpar(*)
       integer*8 ipar(*)
 
-      real w1(lx1,ly1,lz1,lelt),
-     $     w2(lx1,ly1,lz1,lelt),
-     $     w3(lx1,ly1,lz1,lelt)
+      real w1(lx1,ly1,lz1,lelt)
 
       real ydott(lx1,ly1,lz1,lelt,ldimt)
       common /CV_YDOT/ ydott
@@ -445,36 +452,8 @@ c
       etime1  = dnekclock()
       time    = time_   
       nxyz    = lx1*ly1*lz1
-      ntotv   = nxyz*nelv
        
-      if (time.ne.cv_timel) then
-         call cv_settime     
- 
-         if(nio.eq.0) write(6,10) istep,time,time-cv_timel
-  10       format(4x,i7,2x,'t=',1pE14.7,'  stepsize=',1pE13.4)
-
-         call cv_upd_v
-         call copy(w1,vx,ntotv)
-         call copy(w2,vy,ntotv)
-         if (if3d) call copy(w3,vz,ntotv)
-
-         if (ifmvbd) then
-            call cv_upd_coor 
-            call cv_eval_geom
-            call cv_upd_w
-            call sub2(vx,wx,ntotv)
-            call sub2(vy,wy,ntotv)
-            if (if3d) call sub2(vz,wz,ntotv)
-         endif
-        
-         if (param(99).gt.0) call set_convect_new(vxd,vyd,vzd,vx,vy,vz)
-
-         call copy(vx,w1,ntotv)
-         call copy(vy,w2,ntotv)
-         if (if3d) call copy(vz,w3,ntotv)
-
-         cv_timel = time          
-      endif
+      if (.not.cv_ifcrhs .and. time.ne.cv_timel) call cv_upd_tran
 
       call cvunpack(t,p0th,y)          
 
@@ -487,10 +466,12 @@ c
          if (ifcvfld(ifield)) call vprops
       enddo  
 
+      if (cv_ifcrhs) call cv_makeq_many
+
       do ifield=2,nfield
          if (ifcvfld(ifield)) then
            ntot = nxyz*nelfld(ifield)
-           call makeq
+           if (.not.cv_ifcrhs) call makeq
 
            if (iftmsh(ifield)) then                                
               call dssum(bq(1,1,1,1,ifield-1),lx1,ly1,lz1)
@@ -537,6 +518,183 @@ c
       ier = 0
       ifcvfun = .false.
 
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine cv_upd_tran
+c
+c     Extrapolate velocity, mesh and convecting field to the current
+c     time.  Called by fcvfun whenever the time changes or, with the
+c     cached rhs (param(185)), once per step by cdscal_cvode.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CVODE'
+      include 'WSPACE'
+
+      integer*8 k1,k2,k3
+
+      ntotv = lx1*ly1*lz1*nelv
+
+      call cv_settime     
+ 
+      if(nio.eq.0) write(6,10) istep,time,time-cv_timel
+  10    format(4x,i7,2x,'t=',1pE14.7,'  stepsize=',1pE13.4)
+
+      call nek_ws_push
+      k1 = nek_ws_r(ntotv)
+      k2 = nek_ws_r(ntotv)
+      k3 = nek_ws_r(ntotv)
+
+      call cv_upd_v
+      call copy(ws(k1),vx,ntotv)
+      call copy(ws(k2),vy,ntotv)
+      if (if3d) call copy(ws(k3),vz,ntotv)
+
+      if (ifmvbd) then
+         call cv_upd_coor 
+         call cv_eval_geom
+         call cv_upd_w
+         call sub2(vx,wx,ntotv)
+         call sub2(vy,wy,ntotv)
+         if (if3d) call sub2(vz,wz,ntotv)
+      endif
+        
+      if (param(99).gt.0) call set_convect_new(vxd,vyd,vzd,vx,vy,vz)
+
+      call copy(vx,ws(k1),ntotv)
+      call copy(vy,ws(k2),ntotv)
+      if (if3d) call copy(vz,ws(k3),ntotv)
+      call nek_ws_pop
+
+      cv_timel = time          
+
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine cv_makeq_many
+c
+c     makeq for all cvode fields with the cached rhs.  Runs of
+c     consecutive v-mesh scalars with dealiased convection get their
+c     convection and diffusion in one pass over the elements for the
+c     whole run (cv_makeq_run), the other fields go through makeq.
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      logical ifb(ldimt1),ifcnv,ifi
+
+      ifcnv = param(99).eq.4 .and. param(86).eq.0 .and. .not.ifpert
+      if (ifmhd.and.ifaxis) ifcnv = .false.
+
+      do i=2,nfield
+         ifb(i) = ifcvfld(i) .and. .not.iftmsh(i) .and. ifdiff(i)
+     $      .and. ifadvc(i) .and. ifdeal(i) .and. .not.ifdgfld(i)
+     $      .and. ifcnv
+      enddo
+
+      do ifield=2,nfield
+         if (ifcvfld(ifield) .and. .not.ifb(ifield)) call makeq
+      enddo
+
+      i0 = 0
+      do i=2,nfield+1
+         ifi = .false.
+         if (i.le.nfield) ifi = ifb(i)
+         if (ifi .and. i0.eq.0) i0 = i
+         if (.not.ifi .and. i0.gt.0) then
+            call cv_makeq_run(i0,i-i0)
+            i0 = 0
+         endif
+      enddo
+
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine cv_makeq_run(i0,nf)
+c
+c     makeq for the fields i0,...,i0+nf-1 on the v-mesh: user forcing
+c     per field, then convect_new_many and axhelm_vec over all fields
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'WSPACE'
+
+      integer*8 kc,kb,kf
+
+      nxyz = lx1*ly1*lz1
+      n    = nxyz*nelv
+      ld   = nxyz*lelt
+
+      call nek_ws_push
+      kc = nek_ws_r(ld*nf)
+      kb = nek_ws_r(n)
+
+      do ifield=i0,i0+nf-1
+         call makeq_aux ! nekuq, etc.
+      enddo
+
+      call convect_new_many(ws(kc),t(1,1,1,1,i0-1),nf,ld,vxd,vyd,vzd)
+      do ifield=i0,i0+nf-1
+         kf = kc + (ifield-i0)*ld
+         call invcol2(ws(kf),bm1,n)  ! local mass inverse, as convop
+         do i=1,n
+            bq(i,1,1,1,ifield-1) = bq(i,1,1,1,ifield-1)
+     $         - bm1(i,1,1,1)*ws(kf+i-1)*vtrans(i,1,1,1,ifield)
+         enddo
+      enddo
+
+      ! weak laplacian, as wlaplacian
+      call axhelm_vec(ws(kc),t(1,1,1,1,i0-1),vdiff(1,1,1,1,i0),nf,ld,n,
+     $                1)
+      do ifield=i0,i0+nf-1
+         kf = kc + (ifield-i0)*ld
+         call bcneusc(ws(kb),1)
+         call sub2(ws(kb),ws(kf),n)
+         call add2(bq(1,1,1,1,ifield-1),ws(kb),n)
+      enddo
+
+      call nek_ws_pop
+
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine cv_fun_local(time_,y,ydot)
+c
+c     Point-local part of the rhs, the user forcing with the properties
+c     held fixed and no transport, for the local Jacobian in fcvjtimes
+c     (param(186)).  Its Jacobian is block diagonal with one block (over
+c     the fields) per grid point.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CVODE'
+
+      real time_,y(*),ydot(*)
+
+      real ydott(lx1,ly1,lz1,lelt,ldimt)
+      common /CV_YDOT/ ydott
+
+      time = time_
+      nxyz = lx1*ly1*lz1
+
+      call cvunpack(t,p0th,y)
+
+      do ifield=2,nfield
+         if (ifcvfld(ifield)) then
+            ntot = nxyz*nelfld(ifield)
+            call makeq_aux
+            call invcol3(ydott(1,1,1,1,ifield-1),bq(1,1,1,1,ifield-1),
+     $                   vtrans(1,1,1,1,ifield),ntot)
+            call invcol2(ydott(1,1,1,1,ifield-1),bm1,ntot)
+            call col2   (ydott(1,1,1,1,ifield-1),
+     $                   tmask(1,1,1,1,ifield-1),ntot)
+         endif
+      enddo
+
+      dpdt = 0. ! no thermodynamic pressure coupling
+      call cvpack(ydot,ydott,dpdt,.false.)
+
       return
       end
 
@@ -8,8 +8,9 @@ c
       INCLUDE 'SIZE'
       INCLUDE 'INPUT'
       INCLUDE 'CVODE'
+      INCLUDE 'WSPACE'
 
-      integer*8 ipar(1)
+      integer*8 ipar(1),k
 
       if (nio.eq.0.and.loglevel.gt.2)
      $   write(6,*) 'fcvjtimes'
@@ -27,16 +28,32 @@ c
       sig =  1./sum
       sig = cv_sigs * sig
 
-      ! set FJV = f(t, y + sigs*v/||v||)
-      do i = 1,cv_nlocal
-         work(i) = y(i) + sig*v(i)
-      enddo
-      call fcvfun(tt,work,fjv,ipar,rpar,ier)
-
       siginv = 1./sig
-      do i = 1,cv_nlocal
-         fjv(i) = fjv(i)*siginv - fy(i)*siginv
-      enddo
+
+      if (cv_ifljv) then
+         ! point-local Jacobian, differences of cv_fun_local only
+         call nek_ws_push
+         k = nek_ws_r(int(cv_nlocal))
+         call cv_fun_local(tt,y,ws(k))
+         do i = 1,cv_nlocal
+            work(i) = y(i) + sig*v(i)
+         enddo
+         call cv_fun_local(tt,work,fjv)
+         do i = 1,cv_nlocal
+            fjv(i) = fjv(i)*siginv - ws(k+i-1)*siginv
+         enddo
+         call nek_ws_pop
+      else
+         ! set FJV = f(t, y + sigs*v/||v||)
+         do i = 1,cv_nlocal
+            work(i) = y(i) + sig*v(i)
+         enddo
+         call fcvfun(tt,work,fjv,ipar,rpar,ier)
+
+         do i = 1,cv_nlocal
+            fjv(i) = fjv(i)*siginv - fy(i)*siginv
+         enddo
+      endif
 
       ifdqj = .false.
       ier = 0
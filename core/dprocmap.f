@@ -10,6 +10,8 @@
       integer   disp_unit
       integer*8 winsize, winptr
 
+      dProcmapGen = 0
+
 #ifdef MPI
 c      call MPI_Type_Extent(MPI_INTEGER,disp_unit,ierr)
       disp_unit = ISIZE
@@ -67,15 +69,16 @@ c-----------------------------------------------------------------------
       integer   cache(lc,3)
       save      cache
 
-      save icalld
+      save icalld,igen
       data icalld /0/
 
       save iran
       parameter(im = 6075, ia = 106, ic = 1283)
 
-      if (icalld .eq. 0) then
+      if (icalld .eq. 0 .or. igen .ne. dProcmapGen) then
          call ifill(cache,-1,size(cache))
          icalld = 1
+         igen   = dProcmapGen
       endif
 
       ii = lsearch_ur(cache(1,3),lc,ieg)
@@ -107,6 +110,106 @@ c         write(6,*) nid, 'cache hit ', 'ieg:', ieg
          endif
       endif
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dProcmapPutN(ibuf,ldb,lbuf,ioff,ieg,ldi,n)
+c
+c     dProcmapPut for n elements in one passive-target epoch:
+c     ibuf(1:lbuf,i) (leading dim ldb) goes to element ieg(1+(i-1)*ldi),
+c     ldi = 0 means consecutive ids starting at ieg(1).
+c     Like dProcmapPut, not collective; sync before reading back.
+c
+      include 'mpif.h'
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'DPROCMAP'
+
+      integer ibuf(ldb,n),ieg(1)
+      integer*8 disp
+
+#ifdef MPI
+      if (n.le.0) return
+      call mpi_win_lock_all(0,dProcmapH,ierr)
+      do i=1,n
+         jeg = ieg(1) + i-1
+         if (ldi.gt.0) jeg = ieg(1+(i-1)*ldi)
+         call dProcMapFind(iloc,nids,jeg)
+         disp = 3*(iloc-1) + ioff
+         call mpi_put(ibuf(1,i),lbuf,MPI_INTEGER,nids,disp,lbuf,
+     $                MPI_INTEGER,dProcmapH,ierr)
+      enddo
+      call mpi_win_unlock_all(dProcmapH,ierr)
+#else
+      do i=1,n
+         jeg = ieg(1) + i-1
+         if (ldi.gt.0) jeg = ieg(1+(i-1)*ldi)
+         call icopy(dProcmapWin(3*(jeg-1) + ioff + 1),ibuf(1,i),lbuf)
+      enddo
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dProcmapGetN(ibuf,ieg,ldi,n)
+c
+c     dProcmapGet for n elements in one passive-target epoch:
+c     ibuf(1:3,i) is the entry of element ieg(1+(i-1)*ldi) (see
+c     dProcmapPutN for ldi).  Bypasses the cache of dProcmapGet.
+c
+      include 'mpif.h'
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'DPROCMAP'
+
+      integer ibuf(3,n),ieg(1)
+      integer*8 disp
+
+#ifdef MPI
+      if (n.le.0) return
+      call mpi_win_lock_all(0,dProcmapH,ierr)
+      do i=1,n
+         jeg = ieg(1) + i-1
+         if (ldi.gt.0) jeg = ieg(1+(i-1)*ldi)
+         call dProcmapFind(il,nidt,jeg)
+         disp = 3*(il-1)
+         call mpi_get(ibuf(1,i),3,MPI_INTEGER,nidt,disp,3,MPI_INTEGER,
+     $                dProcmapH,ierr)
+      enddo
+      call mpi_win_unlock_all(dProcmapH,ierr)
+#else
+      do i=1,n
+         jeg = ieg(1) + i-1
+         if (ldi.gt.0) jeg = ieg(1+(i-1)*ldi)
+         call icopy(ibuf(1,i),dProcmapWin(3*(jeg-1) + 1),3)
+      enddo
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dProcmapNidN(nids,ldn,ieg,ldi,n)
+c
+c     owner rank of n elements, nids(1+(i-1)*ldn) = gllnid(ieg(..))
+c
+      integer nids(1),ieg(1)
+
+      parameter (lchunk=1024)
+      integer ibuf(3,lchunk)
+
+      do i0=1,n,lchunk
+         m = min(lchunk,n-i0+1)
+         if (ldi.gt.0) then
+            call dProcmapGetN(ibuf,ieg(1+(i0-1)*ldi),ldi,m)
+         else
+            jeg0 = ieg(1)+i0-1
+            call dProcmapGetN(ibuf,jeg0,0,m)
+         endif
+         do i=1,m
+            nids(1+(i0+i-2)*ldn) = ibuf(2,i)
+         enddo
+      enddo
+
       return
       end
 c-----------------------------------------------------------------------
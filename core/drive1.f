@@ -8,6 +8,7 @@ c
 c
       include 'OPCTR'
       include 'CTIMER'
+      include 'WSPACE'
 
 C     used scratch arrays
 C     NOTE: no initial declaration needed. Linker will take 
@@ -35,6 +36,8 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
 
       logical ifemati
 
+      integer itmr(6)        ! setup phases, see nek_mem_report
+
       ! set word size for REAL
       eps = 1.0e-12
       if (1.0 + eps .ne. 1.0) then
@@ -49,11 +52,21 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       ! set word size for CHARACTER
       csize = 1
 
+      call nek_ws_init(ws,wdsize)
+
       call setupcomm()
       nekcomm  = intracomm
       comm_out = nekcomm
       call iniproc()
 
+      call nek_timer_id('setup'       ,itmr(1))
+      call nek_timer_id('readat'      ,itmr(2))
+      call nek_timer_id('topo'        ,itmr(3))
+      call nek_timer_id('geom'        ,itmr(4))
+      call nek_timer_id('solver_setup',itmr(5))
+      call nek_timer_id('ics'         ,itmr(6))
+      call nek_timer_push(itmr(1))
+
       etimes = dnekclock()
       istep  = 0
       tpp    = 0.0
@@ -65,7 +78,10 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       call files
 
       etime = dnekclock()
+      call nek_timer_push(itmr(2))
       call readat          ! Read .rea +map file
+      call initdat_nel     ! Clear field arrays of the local elements
+      call nek_timer_pop(itmr(2))
 
       etims0 = dnekclock_sync()
       if (nio.eq.0) then
@@ -75,12 +91,15 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       endif 
 
       call setvar          ! Initialize most variables
+      call rebal_init      ! Element weights for load rebalancing
 
       instep=1             ! Check for zero steps
       if (nsteps.eq.0 .and. fintim.eq.0.) instep=0
 
       igeom = 2
+      call nek_timer_push(itmr(3))
       call setup_topo      ! Setup domain topology  
+      call nek_timer_pop(itmr(3))
 
       call genwz           ! Compute GLL points, weights, etc.
 
@@ -88,6 +107,7 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       call usrdat
       if(nio.eq.0) write(6,'(A,/)') ' done :: usrdat' 
 
+      call nek_timer_push(itmr(4))
       call gengeom(igeom)  ! Generate geometry, after usrdat 
 
       if (ifmvbd) call setup_mesh_dssum ! Set mesh dssum (needs geom)
@@ -101,6 +121,7 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
 
       call geom_reset(1)    ! recompute Jacobians, etc.
       call vrdsmsh          ! verify mesh topology
+      call nek_timer_pop(itmr(4))
 
       call setlog  ! Initalize logical flags
 
@@ -113,6 +134,7 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
 
       call dg_setup    !     Setup DG, if dg flag is set.
 
+      call nek_timer_push(itmr(5))
       if (ifflow.and.(fintim.ne.0.or.nsteps.ne.0)) then    ! Pressure solver 
          call estrat                                       ! initialization.
          if (iftran.and.solver_type.eq.'itr') then         ! Uses SOLN space 
@@ -126,6 +148,7 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
             call g25d_init
          endif
       endif
+      call nek_timer_pop(itmr(5))
 
       if(ifcvode) call cv_setsize
 
@@ -138,8 +161,11 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
         if (nio.eq.0) write(6,*)'Initialized DG machinery'
 #endif
 
+      call nek_timer_push(itmr(6))
       call setics   !     Set initial conditions 
       call setprop  !     Compute field properties
+      call ckpt_init !    Local checkpoints, restore the latest one
+      call nek_timer_pop(itmr(6))
 
       if (instep.ne.0) then !USRCHK
         if(nio.eq.0) write(6,*) 'call userchk'
@@ -156,11 +182,20 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       call sstest (isss) 
 
       call dofcnt
+      call nek_ws_trim  ! drop the setup workspace
+      call print_mem_info
 
       jp = 0            ! Set perturbation field count to 0 for baseline flow
 
       call in_situ_init()
 
+#ifdef OPENACC
+      call nek_acc_init
+#endif
+
+      call nek_timer_pop(itmr(1))
+      call nek_mem_report(nekcomm)  ! memory of the setup phases
+
       call time00       !     Initalize timers to ZERO
       call opcount(2)
 
@@ -212,13 +247,16 @@ c-----------------------------------------------------------------------
       msteps = 1
 
       do kstep=1,nsteps,msteps
+         call rebal_tic()
          call nek__multi_advance(kstep,msteps)
+         call rebal_toc()
          if(kstep.ge.nsteps) lastep = 1
          call check_ioinfo  
          call set_outfld
          call userchk
          call prepost (ifoutfld,'his')
          call in_situ_check()
+         call rebal_check()
          if (lastep .eq. 1) goto 1001
       enddo
  1001 lastep=1
@@ -346,7 +384,15 @@ c-----------------------------------------------------------------------
       include 'PARALLEL'
       include 'OPCTR'
 
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
+
+      call byte_async_flush(ierr)  ! drain staged output
+      call err_chk(ierr,'Error flushing async output. $')
+
       if(instep.ne.0)  call runstat
+      call nek_comm_dump()
+      call flush_io
+      call nek_timer_report(nekcomm)
       if(xxth(1).gt.0) call fgslib_crs_stats(xxth(1))
 
       call in_situ_end()
@@ -364,9 +410,7 @@ c-----------------------------------------------------------------------
          istep = istep+i
          call nek_advance
 
-         if (ifneknek) call xfer_bcs_neknek
-         if (ifneknek) call bcopy
-         if (ifneknek) call chk_outflow
+         if (ifneknek) call neknek_xfer_step
 
       enddo
 
@@ -53,6 +53,7 @@ c     Set default logicals
       if (lx1.eq.lx2) ifsplit=.true.
 
       if_full_pres = .false.
+      geomGen      = 0
 
 c     Turn off (on) diagnostics for communication
       IFGPRNT= .FALSE.
@@ -69,8 +70,25 @@ C
       CALL RZERO(XC,NEL8)
       CALL RZERO(YC,NEL8)
       CALL RZERO(ZC,NEL8)
-C
-      NTOT=lx1*ly1*lz1*LELT
+
+      kc_vx  = 0           ! characteristics history, see char_alloc
+      kbmnv  = 0
+      kbmass = 0
+      kbdivw = 0
+
+      RETURN
+      END
+c-----------------------------------------------------------------------
+      subroutine initdat_nel
+c
+c     Clear the field arrays of the local elements once nelt is known.
+c     Slots beyond nelt are never touched, so a binary built for a
+c     large lelt only commits memory for the elements a rank owns.
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      NTOT=lx1*ly1*lz1*NELT
       CALL RZERO(ABX1,NTOT)
       CALL RZERO(ABX2,NTOT)
       CALL RZERO(ABY1,NTOT)
@@ -80,7 +98,7 @@ C
       CALL RZERO(VGRADT1,NTOT)
       CALL RZERO(VGRADT2,NTOT)
 
-      NTOT=lx2*ly2*lz2*LELT
+      NTOT=lx2*ly2*lz2*NELT
       CALL RZERO(USRDIV,NTOT)
       CALL RZERO(QTL,NTOT)
 
@@ -774,14 +792,19 @@ C
       include 'DEALIAS'
 
       real*8 ts, dnekclock
+      logical ifdone(ldimt1)
 
       ts = dnekclock()
 
       if (nio.eq.0 .and. igeom.eq.2) 
      &    write(*,'(13x,a)') 'Solving for Hmholtz scalars'
 
+      call nek_ws_push
+      if (igeom.eq.1) call setup_char_scal  ! batched characteristics
+      call cdscal_block(igeom,ifdone)       ! block solve, see param(184)
+
       do ifield = 2,nfield
-         if (idpss(ifield-1).eq.0) then      ! helmholtz
+         if (idpss(ifield-1).eq.0 .and. .not.ifdone(ifield)) then
             intype        = -1
             if (.not.iftmsh(ifield)) imesh = 1
             if (     iftmsh(ifield)) imesh = 2
@@ -791,6 +814,9 @@ C
          endif
       enddo
 
+      call free_char_scal
+      call nek_ws_pop
+
       if (nio.eq.0 .and. igeom.eq.2)
      &   write(*,'(4x,i7,a,1p2e12.4)') 
      &   istep,'  Scalars done',time,dnekclock()-ts
@@ -1315,8 +1341,6 @@ c        Operator timings
          write(6,*) 'advc time',nadvc,tadvc,padvc
 
 c        Low-level routines
-         pmxmf=tmxmf/tttstp
-         write(6,*) 'mxmf time',tmxmf,pmxmf
          padc3=tadc3/tttstp
          write(6,*) 'adc3 time',tadc3,padc3
          pcol2=tcol2/tttstp
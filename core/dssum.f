@@ -18,6 +18,10 @@ c     Global-to-local mapping for gs
 c     Initialize gather-scatter code
       ntot      = nx*ny*nz*nel
       call fgslib_gs_setup(gs_handle,glo_num,ntot,nekcomm,mp)
+      call dssum_split_setup(gs_handle,glo_num,nx,ny,nz,nel)
+#ifdef OPENACC
+      call nek_acc_gs_setup(gs_handle,glo_num,ntot)
+#endif
 
 c     call gs_chkr(glo_num)
 
@@ -37,11 +41,19 @@ c-----------------------------------------------------------------------
       include 'NONCON'
       include 'PARALLEL'
       include 'TSTEP'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
       real u(1)
 
       parameter (lface=lx1*ly1)
       common /nonctmp/ uin(lface,2*ldim),uout(lface)
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
       ifldt = ifield
 c     if (ifldt.eq.0)       ifldt = 1
       if (ifldt.eq.ifldmhd) ifldt = 1
@@ -76,7 +88,20 @@ c
       if (gsh_fld(ifldt).ge.0) then
          if (nio.eq.0.and.loglevel.gt.5)
      $   write(6,*) 'dssum', ifldt 
+         if (itmr.eq.0) call nek_timer_id('dssum',itmr)
+         call nek_timer_push(itmr)
+         call nek_comm_push('dssum')
+#ifdef OPENACC
+         if (nek_acc_dev(u)) then
+            call nek_acc_gs_op(gsh_fld(ifldt),u,1)
+         else
+            call fgslib_gs_op(gsh_fld(ifldt),u,1,1,0)  ! 1 ==> +
+         endif
+#else
          call fgslib_gs_op(gsh_fld(ifldt),u,1,1,0)  ! 1 ==> +
+#endif
+         call nek_comm_pop()
+         call nek_timer_pop(itmr)
       endif
 c
 c
@@ -176,6 +201,10 @@ c
 
       REAL U(1),V(1),W(1)
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
       if(ifsync) call nekgsync()
 
 #ifdef TIMER
@@ -195,7 +224,12 @@ c
 c     if (ifldt.eq.0)       ifldt = 1
       if (ifldt.eq.ifldmhd) ifldt = 1
 
+      if (itmr.eq.0) call nek_timer_id('dssum',itmr)
+      call nek_timer_push(itmr)
+      call nek_comm_push('dssum')
       call fgslib_gs_op_many(gsh_fld(ifldt),u,v,w,u,u,u,ldim,1,1,0)
+      call nek_comm_pop()
+      call nek_timer_pop(itmr)
 
 #ifdef TIMER
       timee=(dnekclock()-etime1)
@@ -917,5 +951,418 @@ c
          call exitti('ms_gs_op: invalid operation!$',1)
       endif
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_split_setup(gs_h,glo_num,nx,ny,nz,nel)
+c
+c     Prepare the split-phase dssum (dssum_begin/dssum_end) for gs_h.
+c     Enabled by param(174); needs np > 1 and the lx1 mesh.  Only the
+c     scalar dssum is split, vec_dssum and nvec_dssum stay blocking.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'DSSPLIT'
+      include 'WSPACE'
+      include 'mpif.h'
+
+      integer gs_h
+      integer*8 glo_num(1)
+
+      parameter (lt=lx1*ly1*lz1*lelt)
+      common /scrns/ wmin(lt),wmax(lt)
+
+      integer h
+      integer*8 kti,kto,ktl,ktol,kpr,nek_ws_ikeep,nek_ws_rkeep
+
+      integer icalld
+      save    icalld
+      data    icalld /0/
+
+      if (icalld.eq.0) then
+         ds_nh  = 0
+         ds_act = 0
+         icalld = 1
+      endif
+
+      if (param(174).le.0 .or. np.eq.1) return
+      if (nx.ne.lx1 .or. ny.ne.ly1 .or. nz.ne.lz1) return
+      if (ds_nh.ge.lds_h) return
+
+      t0   = dnekclock()
+      h    = ds_nh+1
+      nxyz = nx*ny*nz
+      n    = nxyz*nel
+
+c     nodes shared with another rank: min/max of the owner id differ
+      do i=1,n
+         wmin(i) = nid
+         wmax(i) = nid
+      enddo
+      call fgslib_gs_op(gs_h,wmin,1,3,0)
+      call fgslib_gs_op(gs_h,wmax,1,4,0)
+      ncp = 0
+      do i=1,n
+         if (wmin(i).ne.wmax(i)) ncp = ncp+1
+      enddo
+
+c     tuple capacity: twice the face nodes of the largest partition
+      mpr = 2*(nxyz-(nx-2)*(ny-2)*(nz-2))*iglmax(nel,1)
+
+      call nek_ws_push
+      kti  = nek_ws_i (3*mpr)
+      kto  = nek_ws_i (3*mpr)
+      ktl  = nek_ws_i8(mpr)
+      ktol = nek_ws_i8(mpr)
+      kpr  = nek_ws_i (mpr)
+      ds_kelst(h) = nek_ws_ikeep(nel)
+      ds_kicp(h)  = nek_ws_ikeep(ncp)
+      ds_kkcp(h)  = nek_ws_ikeep(ncp)
+
+      call dssum_split_map(ierr,nbel,nu,n2,nnb,ds_nbr(1,h),ds_nbo(1,h)
+     $                    ,iws(ds_kelst(h)),iws(ds_kicp(h))
+     $                    ,iws(ds_kkcp(h)),iws(kpr),wmin,wmax,glo_num
+     $                    ,nxyz,nel,iws(kti),iws(kto),iws8(ktl)
+     $                    ,iws8(ktol),mpr)
+
+      ierr = iglmax(ierr,1)
+      if (ierr.eq.0) then
+         ds_kkpr(h) = nek_ws_ikeep(n2)
+         ds_ks(h)   = nek_ws_rkeep(nu)
+         ds_ksb(h)  = nek_ws_rkeep(n2)
+         ds_krb(h)  = nek_ws_rkeep(n2)
+         call icopy(iws(ds_kkpr(h)),iws(kpr),n2)
+      endif
+      call nek_ws_pop
+
+      if (ierr.ne.0) then
+         call nek_ws_ifree(ds_kelst(h))
+         call nek_ws_ifree(ds_kicp(h))
+         call nek_ws_ifree(ds_kkcp(h))
+         if (nio.eq.0) write(6,*) 'dssum_split_setup: tables too small,'
+     $                           ,' using blocking dssum'
+         return
+      endif
+
+      call fgslib_gs_setup(ds_gsl(h),glo_num,n,mpi_comm_self,1)
+
+      ds_gsh(h)  = gs_h
+      ds_nel(h)  = nel
+      ds_nbel(h) = nbel
+      ds_ncp(h)  = ncp
+      ds_nu(h)   = nu
+      ds_npr(h)  = n2
+      ds_nnb(h)  = nnb
+      ds_nh      = h
+
+      nbmax = iglmax(nbel,1)
+      nnmax = iglmax(nnb,1)
+      t1    = dnekclock() - t0
+      if (nio.eq.0) write(6,1) t1,nnmax,nbmax
+    1 format('   split dssum setup',1pe11.4,' seconds, max nbr/bnd el',
+     $       2i8)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_split_map(ierr,nbel,nu,n2,nnb,nbr,nbo,elst,icp
+     $                          ,kcp,kpr,wmin,wmax,glo_num,nxyz,nel
+     $                          ,ti,to,tl,tol,mpr)
+c
+c     Tables of dssum_split_setup from the owner id range wmin/wmax of
+c     each node; ti,to,tl,tol are tuple work arrays for mpr tuples.
+c     Returns kpr(1:n2) in send/recv slot order.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'DSSPLIT'
+
+      integer nbr(lds_nb),nbo(lds_nb+1),elst(nel),icp(1),kcp(1),kpr(1)
+      integer ti(3,mpr),to(3,mpr)
+      integer*8 glo_num(1),tl(mpr),tol(mpr)
+      real wmin(1),wmax(1),vr(1)
+
+      integer e,key(2)
+      integer*8 g
+
+      ierr = 0
+
+c     local copies of shared nodes, elements holding them go first
+      ncp  = 0
+      nbel = 0
+      do e=1,nel
+         ifb = 0
+         do j=1,nxyz
+            i = j + nxyz*(e-1)
+            if (wmin(i).ne.wmax(i)) then
+               ncp = ncp+1
+               ti(1,ncp) = i
+               tl(ncp)   = glo_num(i)
+               ifb = 1
+            endif
+         enddo
+         if (ifb.ne.0) then
+            nbel = nbel+1
+            elst(nbel) = e
+         endif
+      enddo
+      m = nbel
+      k = 1
+      do e=1,nel
+         if (k.le.nbel .and. elst(k).eq.e) then
+            k = k+1
+         else
+            m = m+1
+            elst(m) = e
+         endif
+      enddo
+
+c     number the distinct shared ids in global id order and send
+c     (id, local number) to the home rank mod(id,np)
+      nu = 0
+      key(1) = 4
+      call fgslib_crystal_tuple_sort(cr_h,ncp,ti,3,tl,1,vr,0,key,1)
+      do j=1,ncp
+         icp(j) = ti(1,j)
+         if (j.eq.1 .or. tl(j).ne.g) then
+            g  = tl(j)
+            nu = nu+1
+            ti(1,nu) = mod(g,np)
+            ti(2,nu) = nu
+            tl(nu)   = g
+         endif
+         kcp(j) = nu
+      enddo
+      n1 = nu
+      call fgslib_crystal_tuple_transfer(cr_h,n1,mpr,ti,3,tl,1,vr,0,1)
+      if (n1.gt.mpr) ierr = 1
+
+c     home rank: every pair of ranks sharing an id gets one tuple
+      n2 = 0
+      if (ierr.eq.0) then
+         key(1) = 4
+         call fgslib_crystal_tuple_sort(cr_h,n1,ti,3,tl,1,vr,0,key,1)
+         j0 = 1
+         do j=1,n1
+            if (j.eq.n1 .or. tl(min(j+1,n1)).ne.tl(j0)) then
+               do ia=j0,j
+               do ib=j0,j
+                  if (ia.ne.ib .and. ti(1,ia).ne.ti(1,ib)) then
+                     n2 = n2+1
+                     if (n2.le.mpr) then
+                        to(1,n2) = ti(1,ia)
+                        to(2,n2) = ti(2,ia)
+                        to(3,n2) = ti(1,ib)
+                        tol(n2)  = tl(j0)
+                     endif
+                  endif
+               enddo
+               enddo
+               j0 = j+1
+            endif
+         enddo
+         if (n2.gt.mpr) then
+            ierr = 1
+            n2   = 0
+         endif
+      endif
+      call fgslib_crystal_tuple_transfer(cr_h,n2,mpr,to,3,tol,1,vr,0,1)
+      if (n2.gt.mpr) ierr = 1
+
+c     group by neighbor, global id order within each neighbor
+      nnb = 0
+      if (ierr.eq.0) then
+         key(1) = 3
+         key(2) = 4
+         call fgslib_crystal_tuple_sort(cr_h,n2,to,3,tol,1,vr,0,key,2)
+         do j=1,n2
+            if (j.eq.1 .or. to(3,j).ne.to(3,max(j-1,1))) then
+               nnb = nnb+1
+               if (nnb.gt.lds_nb) goto 10
+               nbr(nnb) = to(3,j)
+               nbo(nnb) = j
+            endif
+            kpr(j) = to(2,j)
+         enddo
+         nbo(nnb+1) = n2+1
+      endif
+ 10   if (nnb.gt.lds_nb) ierr = 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function dssum_split_slot()
+c
+c     slot of the split-phase tables for the current field, 0 if none
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'TSTEP'
+      include 'DSSPLIT'
+
+      integer h
+
+      ifldt = ifield
+      if (ifldt.eq.ifldmhd) ifldt = 1
+
+      dssum_split_slot = 0
+      do h=1,ds_nh
+         if (ds_gsh(h).eq.gsh_fld(ifldt)) dssum_split_slot = h
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_begin(u)
+c
+c     Start the exchange of u on nodes shared with other ranks.  Only
+c     the first ds_nbel elements of the element list need to be final;
+c     the others may be updated until dssum_end(u), which completes
+c     u = dssum(u).
+c
+      include 'SIZE'
+      include 'DSSPLIT'
+      include 'WSPACE'
+
+      real u(1)
+      integer h,dssum_split_slot
+
+      h = dssum_split_slot()
+      if (h.eq.0 .or. ds_act.ne.0) then
+         ds_act = -1                   ! dssum_end falls back to dssum
+         return
+      endif
+
+      call nek_comm_push('dssum')
+      call dssum_split_send(u,h,iws(ds_kicp(h)),iws(ds_kkcp(h))
+     $                     ,iws(ds_kkpr(h)),ws(ds_ks(h)),ws(ds_ksb(h))
+     $                     ,ws(ds_krb(h)))
+      call nek_comm_pop()
+
+      ds_act = h
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_split_send(u,h,icp,kcp,kpr,s,sb,rb)
+c
+c     sum the shared copies of u and post the exchange of table h
+c
+      include 'SIZE'
+      include 'DSSPLIT'
+      include 'mpif.h'
+
+      real u(1),s(1),sb(1),rb(1)
+      integer h,icp(1),kcp(1),kpr(1)
+
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
+
+      parameter (mtag=7331)
+
+      do k=1,ds_ncp(h)
+         s(kcp(k)) = 0
+      enddo
+      do k=1,ds_ncp(h)
+         s(kcp(k)) = s(kcp(k)) + u(icp(k))
+      enddo
+
+      do j=1,ds_nnb(h)
+         j0 = ds_nbo(j,h)
+         nj = ds_nbo(j+1,h) - j0
+         call mpi_irecv(rb(j0),nj,nekreal,ds_nbr(j,h),mtag,nekcomm
+     $                 ,ds_req(j),ierr)
+      enddo
+      do j=1,ds_nnb(h)
+         j0 = ds_nbo(j,h)
+         nj = ds_nbo(j+1,h) - j0
+         do k=j0,j0+nj-1
+            sb(k) = s(kpr(k))
+         enddo
+         call mpi_isend(sb(j0),nj,nekreal,ds_nbr(j,h),mtag,nekcomm
+     $                 ,ds_req(ds_nnb(h)+j),ierr)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_end(u)
+c
+c     Complete u = dssum(u) started by dssum_begin(u)
+c
+      include 'SIZE'
+      include 'DSSPLIT'
+      include 'WSPACE'
+      include 'mpif.h'
+
+      real u(1)
+      integer h
+      integer status(mpi_status_size,2*lds_nb)
+
+      h = ds_act
+      ds_act = 0
+      if (h.le.0) then
+         call dssum(u,lx1,ly1,lz1)
+         return
+      endif
+
+      call nek_comm_push('dssum')
+      call fgslib_gs_op(ds_gsl(h),u,1,1,0)   ! rank-local sum
+
+      call mpi_waitall(2*ds_nnb(h),ds_req,status,ierr)
+
+      call dssum_split_recv(u,h,iws(ds_kicp(h)),iws(ds_kkcp(h))
+     $                     ,iws(ds_kkpr(h)),ws(ds_ks(h)),ws(ds_krb(h)))
+      call nek_comm_pop()
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_split_recv(u,h,icp,kcp,kpr,s,rb)
+c
+c     add the remote partial sums received for table h to u
+c
+      include 'SIZE'
+      include 'DSSPLIT'
+
+      real u(1),s(1),rb(1)
+      integer h,icp(1),kcp(1),kpr(1)
+
+      do k=1,ds_ncp(h)
+         s(kcp(k)) = 0
+      enddo
+      do k=1,ds_npr(h)
+         s(kpr(k)) = s(kpr(k)) + rb(k)
+      enddo
+      do k=1,ds_ncp(h)
+         u(icp(k)) = u(icp(k)) + s(kcp(k))
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine dssum_split_free
+c
+c     release all split-phase tables (before the gs handles are rebuilt)
+c
+      include 'SIZE'
+      include 'DSSPLIT'
+
+      integer h
+
+      do h=1,ds_nh
+         call fgslib_gs_free(ds_gsl(h))
+         call nek_ws_ifree(ds_kicp(h))
+         call nek_ws_ifree(ds_kkcp(h))
+         call nek_ws_ifree(ds_kkpr(h))
+         call nek_ws_ifree(ds_kelst(h))
+         call nek_ws_rfree(ds_ks(h))
+         call nek_ws_rfree(ds_ksb(h))
+         call nek_ws_rfree(ds_krb(h))
+      enddo
+      ds_nh  = 0
+      ds_act = 0
+
       return
       end
@@ -44,6 +44,7 @@ c     Fill interiors
       iz1 = 0
       if (if3d) iz1=1
       call rzero(v1,ntot1)
+c$omp parallel do private(e,ix,iy,iz)
       do e=1,nelv
          do iz=1,lz2
          do iy=1,ly2
@@ -64,6 +65,7 @@ c
       eoff  = 0
       if (ifield.gt.1) eoff  = nelv
 
+c$omp parallel do private(e,eb,w1,w2)
       do e = 1,nelv
          eb = e + eoff
          call fastdm1(v1(1,1,1,e),df(1,eb)
@@ -80,6 +82,7 @@ c
 c
 c     Map back to pressure grid (extract interior values)
 c
+c$omp parallel do private(e,ix,iy,iz)
       do e=1,nelv
          do iz=1,lz2
          do iy=1,ly2
@@ -132,6 +135,7 @@ C
 C
       include 'SIZE'
       include 'INPUT'
+      include 'PARALLEL'
       real v(nv,nv,nv),u(nu,nu,nu)
       real A(1),Bt(1),Ct(1)
       real w(1)
@@ -142,6 +146,11 @@ C
          call exitt
       endif
 
+      if (if3d .and. wdsize.eq.8) then
+         call tnsr3_batch(v,nv,u,nu,A,Bt,Ct,1,ifok)
+         if (ifok.ne.0) return
+      endif
+
       if (if3d) then
          nuv = nu*nv
          nvv = nv*nv
@@ -6,13 +6,18 @@ c     generic field file reader
 c     reads sourcefld and interpolates all avaiable fields
 c     onto current mesh
 c
-c     memory requirement: 
-c     nelgs*nxs**ldim < np*(4*lelt*lx1**ldim)
+c     The source is processed in chunks of at most 4*lelt*lx1**ldim 
+c     points per rank (or param(195) elements per rank, if set), so 
+c     any source size can be read: for each chunk the source mesh is
+c     read, its points are located and all fields are interpolated
+c     in one pass. Only target points inside the bounding box of the
+c     chunk take part, and across chunks the best match is kept.
 c
       include 'SIZE'
       include 'TOTAL'
       include 'RESTART'
       include 'GFLDR'
+      include 'WSPACE'
 
       character sourcefld*(*)
 
@@ -21,11 +26,20 @@ c
 
       character*1   hdr(iHeaderSize)
 
-      integer*8 dtmp8
+      integer*8 dtmp8,ielc0,i8glsum,nfail,nfail_sum
+      integer*8 kbcode,kbdist,kxc
 
       logical ifbswp, if_byte_swap_test
       real*4 bytetest
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+
+      if (itmr.eq.0) call nek_timer_id('gfldr',itmr)
+      call nek_timer_push(itmr)
+
       etime_t = dnekclock_sync()
       if(nio.eq.0) write(6,*) 'call gfldr ',trim(sourcefld) 
 
@@ -48,6 +62,7 @@ c
       call err_chk(ierr,' Invalid header!$')
       ifbswp = if_byte_swap_test(bytetest,ierr)
       call err_chk(ierr,' Invalid endian tag!$')
+      if_byte_sw = ifbswp                ! used by the #stz reader
 
       nelgs   = nelgr
       nxs     = nxr
@@ -60,38 +75,25 @@ c
       endif
       if (ifgtim) time = timer
 
-      ! distribute elements across all ranks
-      nels = nelgs/np
-      do i = 0,mod(nelgs,np)-1
-         if(i.eq.nid) nels = nels + 1
-      enddo
+      ! source elements are streamed in nchunk passes, each spread
+      ! across all ranks with at most nelcmx elements per rank
       nxyzs      = nxs*nys*nzs
-      dtmp8      = nels
-      ntots_b    = dtmp8*nxyzs*wdsizr
-      rankoff_b  = igl_running_sum(nels) - dtmp8
-      rankoff_b  = rankoff_b*nxyzs*wdsizr  
       dtmp8      = nelgs
       nSizeFld_b = dtmp8*nxyzs*wdsizr
       noff0_b    = iHeaderSize + iSize + iSize*dtmp8
 
+      nelcmx = ltots/nxyzs
+      if(ifzipr) nelcmx = min(nelcmx,lelr)
+      if(param(195).gt.0) nelcmx = min(nelcmx,int(param(195)))
+      if(nelcmx.lt.1) 
+     $ call exitti('source polynomial order too high, nxs=$',nxs)
+      nchunk = (dtmp8 - 1)/(int(np,8)*nelcmx) + 1
+
       ! do some checks
       if(ldims.ne.ldim) 
      $ call exitti('ldim of source does not match target!$',0)
-      if(ntots_b/wdsize .gt. ltots) then
-        dtmp8 = nelgs
-        lelt_req = dtmp8*nxs*nys*nzs / (np*ltots/lelt)
-        lelt_req = lelt_req + 1
-        if(nio.eq.0) write(6,*)
-     $   'ABORT: buffer too small, increase lelt > ', lelt_req
-        call exitt
-      endif
 
-      ifldpos = 0
-      if(ifgetxr) then
-        ! read source mesh coordinates
-        call gfldr_getxyz(xm1s,ym1s,zm1s,ifbswp)
-        ifldpos = ldim
-      else
+      if(.not.ifgetxr) then
         call exitti('source does not contain a mesh!$',0)
       endif
 
@@ -103,52 +105,104 @@ c
         call exitti('no support for conj/HT!$',0)
       endif
 
-      ! initialize interpolation tool using source mesh
-      nxf   = 2*nxs
-      nyf   = 2*nys
-      nzf   = 2*nzs
-      nhash = nxs*nys*nzs 
-      nmax  = 256
+      if(nio.eq.0 .and. nchunk.gt.1) write(6,*)
+     $  'gfldr: streaming source in chunks ',nchunk
 
-      call fgslib_findpts_setup(inth_gfldr,nekcomm,np,ldim,
-     &                          xm1s,ym1s,zm1s,nxs,nys,nzs,
-     &                          nels,nxf,nyf,nzf,bb_t,
-     &                          nhash,nhash,nmax,tol)
+      ntot = lx1*ly1*lz1*nelt
+      call nek_ws_push
+      kbcode = nek_ws_i(ntot)       ! best findpts code so far
+      kbdist = nek_ws_r(ntot)       ! and its distance
+      kgcand = nek_ws_i(ntot)       ! target points of this chunk
+      kgupd  = nek_ws_i(ntot)       ! chunk improves on best
+      kxc    = nek_ws_r(ldim*ntot)  ! their coordinates
+      kgfe   = nek_ws_r(ntot)       ! interpolated values
+      call ifill(iws(kbcode),2,ntot)
+      call cfill(ws(kbdist),1.e30,ntot)
+
+      do ic = 1,nchunk
+         ielc0 = ((ic-1)*dtmp8)/nchunk
+         nelgc = (ic*dtmp8)/nchunk - ielc0
+
+         ! distribute chunk elements across all ranks
+         nels = nelgc/np
+         do i = 0,mod(nelgc,np)-1
+            if(i.eq.nid) nels = nels + 1
+         enddo
+         ntots_b    = nels
+         ntots_b    = ntots_b*nxyzs*wdsizr
+         rankoff_b  = igl_running_sum(nels) - nels
+         rankoff_b  = (rankoff_b + ielc0)*nxyzs*wdsizr
+         offzr      = noff0_b
+
+         ! read chunk mesh coordinates and locate target points
+         call gfldr_getxyz(xm1s,ym1s,zm1s,ifbswp)
+         ifldpos = ldim
+         call gfldr_locate(xm1,ym1,zm1,iws(kbcode),ws(kbdist),
+     $                     iws(kgcand),iws(kgupd),ws(kxc),ntot)
+
+         ! read chunk fields and interpolate
+         if(ifgetur) then
+           if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading vel'
+           call gfldr_getfld(vx,vy,vz,ldim,ifldpos+1,ifbswp)
+           ifldpos = ifldpos + ldim
+         endif
+         if(ifgetpr) then
+           if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading pr'
+           call gfldr_getfld(pm1,dum,dum,1,ifldpos+1,ifbswp)
+           ifldpos = ifldpos + 1
+         endif
+         if(ifgettr .and. ifheat) then
+           if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading temp'
+           call gfldr_getfld(t(1,1,1,1,1),dum,dum,1,ifldpos+1,ifbswp)
+           ifldpos = ifldpos + 1
+         elseif(ifgettr .and. ifzipr) then  ! skip block, next offset
+           nelbs = rankoff_b/(nxyzs*wdsizr)
+           call mfi_zopen(offzr,nelbs,nels,nelgs,fldh_gfldr,.true.,ierr)
+           ifldpos = ifldpos + 1
+         endif
+         do i = 1,ldimt-1
+            if(ifgtpsr(i)) then
+              if(nid.eq.0 .and. loglevel.gt.2) 
+     $          write(6,*) 'reading scalar',i
+              call gfldr_getfld(t(1,1,1,1,i+1),dum,dum,1,ifldpos+1,
+     $                          ifbswp) 
+              ifldpos = ifldpos + 1
+            endif
+         enddo
+
+         call fgslib_findpts_free(inth_gfldr)
+      enddo
 
-      ! read source fields and interpolate
-      if(ifgetur) then
-        if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading vel'
-        call gfldr_getfld(vx,vy,vz,ldim,ifldpos+1,ifbswp)
-        ifldpos = ifldpos + ldim
+      ! points never found keep their previous value
+      toldist = 5e-6
+      if(wdsizr.eq.8) toldist = 5e-14
+      nfail = 0
+      do i=1,ntot
+         if(iws(kbcode+i-1).eq.1 .and. sqrt(ws(kbdist+i-1)).gt.toldist)
+     &     nfail = nfail + 1
+         if(iws(kbcode+i-1).eq.2) nfail = nfail + 1
+      enddo
+      call nek_ws_pop
+
+      nfail_sum = i8glsum(nfail,1)
+      if(nfail_sum.gt.0) then
+        if(nio.eq.0) write(6,*)
+     &    ' WARNING: Unable to find all mesh points in source fld ',
+     &    nfail_sum
       endif
+
       if(ifgetpr) then
-        if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading pr'
-        call gfldr_getfld(pm1,dum,dum,1,ifldpos+1,ifbswp)
-        ifldpos = ifldpos + 1
         if (ifaxis) call axis_interp_ic(pm1)
         call map_pm1_to_pr(pm1,1)
       endif
-      if(ifgettr .and. ifheat) then
-        if(nid.eq.0 .and. loglevel.gt.2) write(6,*) 'reading temp'
-        call gfldr_getfld(t(1,1,1,1,1),dum,dum,1,ifldpos+1,ifbswp)
-        ifldpos = ifldpos + 1
-      endif
-      do i = 1,ldimt-1
-         if(ifgtpsr(i)) then
-           if(nid.eq.0 .and. loglevel.gt.2) 
-     $       write(6,*) 'reading scalar',i
-           call gfldr_getfld(t(1,1,1,1,i+1),dum,dum,1,ifldpos+1,ifbswp) 
-           ifldpos = ifldpos + 1
-         endif
-      enddo
 
       call byte_close_mpi(fldh_gfldr,ierr)
-      call fgslib_findpts_free(inth_gfldr)
 
       etime_t = dnekclock_sync() - etime_t
       if(nio.eq.0) write(6,'(A,1(1g8.2),A)')
      &                   ' done :: gfldr  ', etime_t, ' sec'
 
+      call nek_timer_pop(itmr)
       return
       end
 c-----------------------------------------------------------------------
@@ -166,14 +220,14 @@ c-----------------------------------------------------------------------
       integer*8 ioff_b
 
  
-      ioff_b = noff0_b + ldim*rankoff_b
-      call byte_set_view(ioff_b,fldh_gfldr)
-
       nread = ldim*ntots_b/4
-      call byte_read_mpi(bufr,nread,-1,fldh_gfldr,ierr)
-      if(ifbswp) then
-        if(wdsizr.eq.4) call byte_reverse (bufr,nread,ierr)
-        if(wdsizr.eq.8) call byte_reverse8(bufr,nread,ierr)
+      if(ifzipr) then
+        call gfldr_zread(bufr,ldim,ifbswp)
+      else
+        ioff_b = noff0_b + ldim*rankoff_b
+        call byte_set_view(ioff_b,fldh_gfldr)
+        call byte_read_mpi_swap(bufr,nread,-1,fldh_gfldr,wdsizr,ifbswp,
+     $                          ierr)
       endif
 
       call gfldr_buf2vi (xout,1,bufr,ldim,wdsizr,nels,nxyzs)
@@ -198,43 +252,58 @@ c-----------------------------------------------------------------------
 
       integer*8 ioff_b
 
-      logical ifpts
-
-      integer icalld
-      save    icalld
-      data    icalld /0/
-
-
-      ifpts = .false.
-      if(icalld.eq.0) then
-        ifpts = .true. ! find points
-        icalld = 1
-      endif
-
       ! read field data from source fld file
-      ioff_b = noff0_b + (ifldpos-1)*nSizeFld_b
-      ioff_b = ioff_b  + nldim*rankoff_b
-      call byte_set_view(ioff_b,fldh_gfldr)
       nread = nldim*ntots_b/4
-      call byte_read_mpi(bufr,nread,-1,fldh_gfldr,ierr)
-      if(ifbswp) then
-        if(wdsizr.eq.4) call byte_reverse (bufr,nread,ierr)
-        if(wdsizr.eq.8) call byte_reverse8(bufr,nread,ierr)
+      if(ifzipr) then
+        call gfldr_zread(bufr,nldim,ifbswp)
+      else
+        ioff_b = noff0_b + (ifldpos-1)*nSizeFld_b
+        ioff_b = ioff_b  + nldim*rankoff_b
+        call byte_set_view(ioff_b,fldh_gfldr)
+        call byte_read_mpi_swap(bufr,nread,-1,fldh_gfldr,wdsizr,ifbswp,
+     $                          ierr)
       endif
 
       ! interpolate onto current mesh
-      ntot = lx1*ly1*lz1*nelt
       call gfldr_buf2vi  (buffld,1,bufr,nldim,wdsizr,nels,nxyzs)
-      call gfldr_intp    (out1,buffld,ifpts)
+      call gfldr_intp    (out1,buffld)
       if(nldim.eq.1) return
 
       call gfldr_buf2vi  (buffld,2,bufr,nldim,wdsizr,nels,nxyzs)
-      call gfldr_intp    (out2,buffld,.false.)
+      call gfldr_intp    (out2,buffld)
       if(nldim.eq.2) return
 
       if(nldim.eq.3) then
         call gfldr_buf2vi(buffld,3,bufr,nldim,wdsizr,nels,nxyzs)
-        call gfldr_intp  (out3,buffld,.false.)
+        call gfldr_intp  (out3,buffld)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gfldr_zread(buf,nldim,ifbswp)
+c
+c     read next field block of a compressed (#stz) source file
+c
+      include 'SIZE'
+      include 'GFLDR'
+      include 'RESTART'
+
+      real*4  buf(*)
+      logical ifbswp
+
+      nelbs = rankoff_b/(nxyzs*wdsizr)
+      nwe   = nldim*nxyzs*wdsizr/4
+      call mfi_zopen(offzr,nelbs,nels,nelgs,fldh_gfldr,.true.,ierr)
+      call mfi_zread(buf,nels,nwe,fldh_gfldr,.true.,ierr)
+      call err_chk(ierr,' Error reading compressed field!$')
+
+      if (ifbswp) then
+        if(wdsizr.eq.8) then
+          call byte_reverse8(buf,nels*nwe,ierr)
+        else
+          call byte_reverse (buf,nels*nwe,ierr)
+        endif
       endif
 
       return
@@ -261,61 +330,119 @@ c-----------------------------------------------------------------------
       return
       end
 c-----------------------------------------------------------------------
-      subroutine gfldr_intp(fieldout,fieldin,iffpts)
-
+      subroutine gfldr_locate(xt,yt,zt,bcode,bdist,icand,iupd,xc,n)
+c
+c     set up findpts on the current source chunk and locate the target
+c     points (xt,yt,zt) inside its bounding box that are not yet 
+c     found inside an element. iupd flags the candidates icand for 
+c     which this chunk is a better match than bcode/bdist so far.
+c
       include 'SIZE'
-      include 'RESTART'
-      include 'GEOM'
       include 'GFLDR'
 
-      real    fieldout(*),fieldin(*)
-      logical iffpts
+      common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
 
-      integer*8 i8glsum,nfail,nfail_sum
+      real    xt(n),yt(n),zt(n),bdist(n),xc(n,ldim)
+      integer bcode(n),icand(n),iupd(n)
+
+      real    bmin(3),bmax(3)
+
+      nxyz = nels*nxyzs
+      bmin(1) = glmin(xm1s,nxyz)
+      bmax(1) = glmax(xm1s,nxyz)
+      bmin(2) = glmin(ym1s,nxyz)
+      bmax(2) = glmax(ym1s,nxyz)
+      bmin(3) = 0
+      bmax(3) = 0
+      if(ldim.eq.3) then
+        bmin(3) = glmin(zm1s,nxyz)
+        bmax(3) = glmax(zm1s,nxyz)
+      endif
+      ext = max(bmax(1)-bmin(1),bmax(2)-bmin(2),bmax(3)-bmin(3))
+      do i=1,3
+         bmin(i) = bmin(i) - bb_t*ext
+         bmax(i) = bmax(i) + bb_t*ext
+      enddo
 
+      ncand = 0
+      do i=1,n
+         if(bcode(i).ne.0 .and.
+     $      xt(i).ge.bmin(1) .and. xt(i).le.bmax(1) .and.
+     $      yt(i).ge.bmin(2) .and. yt(i).le.bmax(2)) then
+           if(ldim.eq.2 .or.
+     $        (zt(i).ge.bmin(3) .and. zt(i).le.bmax(3))) then
+             ncand = ncand + 1
+             icand(ncand) = i
+             xc(ncand,1)  = xt(i)
+             xc(ncand,2)  = yt(i)
+             if(ldim.eq.3) xc(ncand,ldim) = zt(i)
+           endif
+         endif
+      enddo
 
-      nfail = 0
-      ntot  = lx1*ly1*lz1*nelt
+      ! initialize interpolation tool using source chunk
+      nxf   = 2*nxs
+      nyf   = 2*nys
+      nzf   = 2*nzs
+      nhash = nxs*nys*nzs 
+      nmax  = 256
 
-      toldist = 5e-6
-      if(wdsizr.eq.8) toldist = 5e-14
+      call fgslib_findpts_setup(inth_gfldr,nekcomm,npp,ldim,
+     &                          xm1s,ym1s,zm1s,nxs,nys,nzs,
+     &                          nels,nxf,nyf,nzf,bb_t,
+     &                          nhash,nhash,nmax,tol)
 
-      if(iffpts) then ! locate points (iel,iproc,r,s,t)
-
-        call fgslib_findpts(inth_gfldr,
-     &                      grcode,1,
-     &                      gproc,1,
-     &                      gelid,1,
-     &                      grst,ldim,
-     &                      gdist,1,
-     &                      xm1,1,
-     &                      ym1,1,
-     &                      zm1,1,ntot)
-
-        do i=1,ntot
-           if(grcode(i).eq.1 .and. sqrt(gdist(i)).gt.toldist)
-     &       nfail = nfail + 1
-           if(grcode(i).eq.2) nfail = nfail + 1
-        enddo
-
-        nfail_sum = i8glsum(nfail,1)
-        if(nfail_sum.gt.0) then
-          if(nio.eq.0) write(6,*)
-     &      ' WARNING: Unable to find all mesh points in source fld ',
-     &      nfail_sum
-        endif
+      ! locate points (iel,iproc,r,s,t)
+      call fgslib_findpts(inth_gfldr,
+     &                    grcode,1,
+     &                    gproc,1,
+     &                    gelid,1,
+     &                    grst,ldim,
+     &                    gdist,1,
+     &                    xc(1,1),1,
+     &                    xc(1,2),1,
+     &                    xc(1,ldim),1,ncand)
+
+      do j=1,ncand
+         i = icand(j)
+         iupd(j) = 0
+         if(grcode(j).lt.bcode(i) .or. (grcode(j).eq.1 .and. 
+     $      bcode(i).eq.1 .and. gdist(j).lt.bdist(i))) then
+           iupd(j)  = 1
+           bcode(i) = grcode(j)
+           bdist(i) = gdist(j)
+         endif
+      enddo
 
-      endif
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gfldr_intp(fieldout,fieldin)
+c
+c     evaluate source chunk field fieldin at the located points and
+c     update fieldout where the chunk is the best match
+c
+      include 'SIZE'
+      include 'GFLDR'
+      include 'WSPACE'
+
+      real    fieldout(*),fieldin(*)
 
-      ! evaluate inut field at given points
+
+      ! evaluate input field at given points
       call fgslib_findpts_eval(inth_gfldr,
-     &                         fieldout,1,
+     &                         ws(kgfe),1,
      &                         grcode,1,
      &                         gproc,1,
      &                         gelid,1,
-     &                         grst,ldim,ntot,
+     &                         grst,ldim,ncand,
      &                         fieldin)
 
+      do j=1,ncand
+         if(iws(kgupd+j-1).ne.0)
+     $     fieldout(iws(kgcand+j-1)) = ws(kgfe+j-1)
+      enddo
+
       return
       end
 
@@ -10,6 +10,7 @@ c     intype = -1  (implicit)
       include 'SIZE'
       include 'TOTAL'
       include 'GMRES'
+      include 'WSPACE'
       common  /ctolpr/ divex
       common  /cprint/ ifprint
       logical          ifprint
@@ -18,13 +19,15 @@ c     intype = -1  (implicit)
       real             h2   (lx1,ly1,lz1,lelv)
       real             h2inv(lx1,ly1,lz1,lelv)
 
-      common /scrmg/    wp (lx2,ly2,lz2,lelv)
-
       common /ctmp0/   wk1(lgmres),wk2(lgmres)
       common /cgmres1/ y(lgmres)
 
+      real hr(lgmres+1),hw(lgmres+1)
+      logical ifpipe
+
       real alpha, l, temp
       integer j,m
+      integer*8 kwp
 c
       logical iflag
       save    iflag
@@ -55,6 +58,14 @@ c     if (param(21).lt.0) tolps = abs(param(21))
       tolpss = tolps
 c
       ntot2  = lx2*ly2*lz2*nelv
+      ifpipe = param(180).gt.0
+
+      call nek_ws_push
+#ifdef OPENACC
+      kwp = kwp_gmres          ! kept on the device
+#else
+      kwp = nek_ws_r(ntot2)    ! preconditioner work array
+#endif
 c
       iconv = 0
       call rzero(x_gmres,ntot2)
@@ -89,18 +100,16 @@ c           call copy(r_gmres,res,ntot2)
                                                      !  1            1
          do j=1,m
             iter = iter+1
-                                                           !       -1
+
+            if (.not.ifpipe .or. j.eq.1) then              !       -1
             call col3(w_gmres,mu_gmres,v_gmres(1,j),ntot2) ! w  = U   v
                                                            !           j
             
             etime2 = dnekclock()
-            if(param(43).eq.1) then
-               call uzprec(z_gmres(1,j),w_gmres,h1,h2,intype,wp)
-            else                                        !       -1
-               call hsmg_solve(z_gmres(1,j),w_gmres)    ! z  = M   w
-c              call copy(z_gmres(1,j),w_gmres,ntot2)    ! z  = M   w
-            endif     
+            call uzawa_gmres_prec(z_gmres(1,j),w_gmres
+     $                           ,h1,h2,intype,ws(kwp))
             etime_p = etime_p + dnekclock()-etime2
+            endif
      
             call cdabdtp(w_gmres,z_gmres(1,j),    ! w = A z
      $                   h1,h2,h2inv,intype)      !        j
@@ -108,6 +117,25 @@ c              call copy(z_gmres(1,j),w_gmres,ntot2)    ! z  = M   w
                                                   !      -1
             call col2(w_gmres,ml_gmres,ntot2)     ! w = L   w
 
+            if (ifpipe) then
+c              one reduction for the step, overlapped with M U^-1 w
+               call gmres_pipe_begin(hr,hw,w_gmres,v_gmres,w_gmres
+     $                              ,.false.,j,ntot2,ireq)
+               if (j.lt.m) then
+                  etime2 = dnekclock()
+                  call col3(r_gmres,mu_gmres,w_gmres,ntot2)
+                  call uzawa_gmres_prec(z_gmres(1,j+1),r_gmres
+     $                                 ,h1,h2,intype,ws(kwp))
+                  etime_p = etime_p + dnekclock()-etime2
+               endif
+               call gmres_pipe_end(hr,hw,w_gmres,v_gmres,w_gmres
+     $                            ,.false.,j,ntot2,ireq,alpha)
+               do i=1,j
+                  h_gmres(i,j) = hr(i)
+               enddo
+               goto 100
+            endif
+
 c           !modified Gram-Schmidt
 c           do i=1,j
 c              h_gmres(i,j)=glsc2(w_gmres,v_gmres(1,i),ntot2) ! h    = (w,v )
@@ -127,6 +155,9 @@ c           2-PASS GS, 1st pass:
             do i=1,j
                call add2s2(w_gmres,v_gmres(1,i),-h_gmres(i,j),ntot2) ! w = w - h    v
             enddo                                                    !          i,j  i
+                                                              !            ______
+            alpha = sqrt(glsc2(w_gmres,w_gmres,ntot2))        ! alpha =  \/ (w,w)
+  100       continue
 
 
 c           2-PASS GS, 2nd pass:
@@ -151,8 +182,6 @@ c           enddo
                h_gmres(i+1,j)= -s_gmres(i)*temp 
      $                        + c_gmres(i)*h_gmres(i+1,j)
             enddo
-                                                              !            ______
-            alpha = sqrt(glsc2(w_gmres,w_gmres,ntot2))        ! alpha =  \/ (w,w)
             rnorm = 0.
             if(alpha.eq.0.) goto 900  !converged
             l = sqrt(h_gmres(j,j)*h_gmres(j,j)+alpha*alpha)
@@ -181,6 +210,7 @@ c            call outmat(h,m,j,' h    ',j)
             temp = 1./alpha
             call cmult2(v_gmres(1,j+1),w_gmres,temp,ntot2) ! v    = w / alpha
                                                            !  j+1            
+            if (ifpipe) call gmres_pipe_z(z_gmres,hr,alpha,j,ntot2)
          enddo
   900    iconv = 1
  1000    continue
@@ -231,6 +261,8 @@ c     END DIAGNOSTICS
 c     call flush_hack
  9999 format(i11,a,I6,1p5e13.4)
 
+      call nek_ws_pop
+
       return
       end
 
@@ -253,6 +285,14 @@ c-----------------------------------------------------------------------
       integer n
       real l(n),u(n),b(n),binv(n)
       integer i
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(l)
+#endif
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
 c        l(i)=sqrt(binv(i))
 c        u(i)=sqrt(b(i))
@@ -294,8 +334,7 @@ c
 
       imsh = 1
       isd  = 1
-      call axhelm (w,x,h1,h2,imsh,isd)
-      call dssum  (w,lx1,ly1,lz1)
+      call axhelm_ds (w,x,h1,h2,imsh,isd)
       call col2   (w,pmask,n)
 
       return
@@ -326,6 +365,9 @@ c     GMRES iteration.
       real alpha, l, temp
       integer outer
 
+      real hr(lgmres+1),hw(lgmres+1)
+      logical ifpipe
+
       logical iflag,if_hyb
       save    iflag,if_hyb
 c     data    iflag,if_hyb  /.false. , .true. /
@@ -351,7 +393,13 @@ c     data    iflag,if_hyb  /.false. , .true. /
          norm_fac = 1./sqrt(volvm1)
       endif
 
+#ifdef OPENACC
+      call nek_acc_host_push
+#endif
       if (param(100).ne.2) call set_fdm_prec_h1b(d,h1,h2,nelv)
+#ifdef OPENACC
+      call nek_acc_host_pop
+#endif
 
       call chktcg1(tolps,res,h1,h2,pmask,vmult,1,1)
       if (param(21).gt.0.and.tolps.gt.abs(param(21))) 
@@ -359,6 +407,8 @@ c     data    iflag,if_hyb  /.false. , .true. /
       if (istep.eq.0) tolps = 1.e-4
       tolpss = tolps
 c
+      ifpipe = param(180).gt.0
+
       iconv = 0
       call rzero(x_gmres,n)
 
@@ -393,34 +443,19 @@ c           call copy(r,res,n)
                                                   !  1            1
          do j=1,m
             iter = iter+1
-                                                       !       -1
+
+            if (.not.ifpipe .or. j.eq.1) then          !       -1
             call col3(w_gmres,mu_gmres,v_gmres(1,j),n) ! w  = U   v
                                                        !           j
 
 c . . . . . Overlapping Schwarz + coarse-grid . . . . . . .
 
             etime2 = dnekclock()
-
 c           if (outer.gt.2) if_hyb = .true.       ! Slow outer convergence
-            if (ifmgrid) then
-               call h1mg_solve(z_gmres(1,j),w_gmres,if_hyb) ! z  = M   w
-            else                                            !  j
-               kfldfdm = ldim+1
-               if (param(100).eq.2) then
-                   call h1_overlap_2 (z_gmres(1,j),w_gmres,pmask)
-               else
-                   call fdm_h1
-     $               (z_gmres(1,j),w_gmres,d,pmask,vmult,nelv,
-     $                ktype(1,1,kfldfdm),wk)
-               endif
-               call crs_solve_h1 (wk,w_gmres)        ! z  = M   w
-               call add2         (z_gmres(1,j),wk,n) !  j        
-            endif
-
-
-            call ortho        (z_gmres(1,j)) ! Orthogonalize wrt null space, if present
+            call hmh_gmres_prec(z_gmres(1,j),w_gmres,d,wk,if_hyb)
             etime_p = etime_p + dnekclock()-etime2
 c . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . 
+            endif
 
      
             call ax  (w_gmres,z_gmres(1,j),h1,h2,n) ! w = A z
@@ -429,6 +464,25 @@ c . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .
                                                     !      -1
             call col2(w_gmres,ml_gmres,n)           ! w = L   w
 
+            if (ifpipe) then
+c              one reduction for the step, overlapped with M U^-1 w
+               call gmres_pipe_begin(hr,hw,w_gmres,v_gmres,wt
+     $                              ,.true.,j,n,ireq)
+               if (j.lt.m) then
+                  etime2 = dnekclock()
+                  call col3(r_gmres,mu_gmres,w_gmres,n)
+                  call hmh_gmres_prec(z_gmres(1,j+1),r_gmres,d,wk
+     $                               ,if_hyb)
+                  etime_p = etime_p + dnekclock()-etime2
+               endif
+               call gmres_pipe_end(hr,hw,w_gmres,v_gmres,wt
+     $                            ,.true.,j,n,ireq,alpha)
+               do i=1,j
+                  h_gmres(i,j) = hr(i)
+               enddo
+               goto 100
+            endif
+
 c           !modified Gram-Schmidt
 
 c           do i=1,j
@@ -449,6 +503,9 @@ c           2-PASS GS, 1st pass:
             do i=1,j
                call add2s2(w_gmres,v_gmres(1,i),-h_gmres(i,j),n) ! w = w - h    v
             enddo                                                !          i,j  i
+                                                      !            ______
+            alpha = sqrt(glsc3(w_gmres,w_gmres,wt,n)) ! alpha =  \/ (w,w)
+  100       continue
 
 
 c           2-PASS GS, 2nd pass:
@@ -472,8 +529,6 @@ c           enddo
                h_gmres(i+1,j)= -s_gmres(i)*temp 
      $                        + c_gmres(i)*h_gmres(i+1,j)
             enddo
-                                                      !            ______
-            alpha = sqrt(glsc3(w_gmres,w_gmres,wt,n)) ! alpha =  \/ (w,w)
             rnorm = 0.
             if(alpha.eq.0.) goto 900  !converged
             l = sqrt(h_gmres(j,j)*h_gmres(j,j)+alpha*alpha)
@@ -500,6 +555,7 @@ c           enddo
             temp = 1./alpha
             call cmult2(v_gmres(1,j+1),w_gmres,temp,n) ! v    = w / alpha
                                                        !  j+1            
+            if (ifpipe) call gmres_pipe_z(z_gmres,hr,alpha,j,n)
          enddo
   900    iconv = 1
  1000    continue
@@ -534,6 +590,132 @@ c     call flush_hack
 
       if (outer.le.2) if_hyb = .false.
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hmh_gmres_prec(z,w,d,wk,if_hyb)
+
+c     z = M w for hmh_gmres (w is overwritten)
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'FDMH1'
+
+      real z(1),w(1),d(1),wk(1)
+      logical if_hyb
+
+      n = lx1*ly1*lz1*nelv
+
+      if (ifmgrid) then
+         call h1mg_solve(z,w,if_hyb)                ! z  = M   w
+      else                                          !  j
+         kfldfdm = ldim+1
+         if (param(100).eq.2) then
+             call h1_overlap_2 (z,w,pmask)
+         else
+             call fdm_h1
+     $         (z,w,d,pmask,vmult,nelv,
+     $          ktype(1,1,kfldfdm),wk)
+         endif
+         call crs_solve_h1 (wk,w)              ! z  = M   w
+         call add2         (z,wk,n)            !  j        
+      endif
+
+      call ortho (z) ! Orthogonalize wrt null space, if present
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine uzawa_gmres_prec(z,w,h1,h2,intype,wp)
+
+c     z = M w for uzawa_gmres
+
+      include 'SIZE'
+      include 'INPUT'
+
+      real z(1),w(1),h1(1),h2(1),wp(1)
+
+      if(param(43).eq.1) then
+         call uzprec(z,w,h1,h2,intype,wp)
+      else                                   !       -1
+         call hsmg_solve(z,w)                ! z  = M   w
+      endif     
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gmres_pipe_begin(hr,hw,w,v,wt,ifwt,j,n,ireq)
+
+c     Start the single reduction of Arnoldi step j (param(180) > 0):
+c     hr(i) = (w,v_i), i <= j, and hr(j+1) = (w,w), weighted by wt
+c     if ifwt.  gmres_pipe_end completes it.  v is v_gmres, its
+c     columns are ld apart whatever the current n.
+
+      include 'SIZE'
+      parameter (ld=lx2*ly2*lz2*lelv)
+      real hr(j+1),hw(j+1),w(n),v(ld,j),wt(n)
+      logical ifwt
+
+      do i=1,j
+         if (ifwt) then
+            hr(i) = vlsc3(w,v(1,i),wt,n)
+         else
+            hr(i) = vlsc2(w,v(1,i),n)
+         endif
+      enddo
+      if (ifwt) then
+         hr(j+1) = vlsc3(w,w,wt,n)
+      else
+         hr(j+1) = vlsc2(w,w,n)
+      endif
+      call gop_begin(hr,hw,'+  ',j+1,ireq)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gmres_pipe_end(hr,hw,w,v,wt,ifwt,j,n,ireq,alpha)
+
+c     Complete gmres_pipe_begin: w = w - sum hr(i) v_i and alpha = |w|
+c     from (w,w) - sum hr(i)^2, recomputed if that has cancelled.
+
+      include 'SIZE'
+      parameter (ld=lx2*ly2*lz2*lelv)
+      real hr(j+1),hw(j+1),w(n),v(ld,j),wt(n),alpha
+      logical ifwt
+
+      call gop_end(hr,hw,j+1,ireq)
+
+      ww = hr(j+1)
+      do i=1,j
+         call add2s2(w,v(1,i),-hr(i),n)
+         ww = ww - hr(i)**2
+      enddo
+
+      if (ww.gt.1.e-4*hr(j+1)) then
+         alpha = sqrt(ww)
+      elseif (ifwt) then
+         alpha = sqrt(glsc3(w,w,wt,n))
+      else
+         alpha = sqrt(glsc2(w,w,n))
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine gmres_pipe_z(z,hr,alpha,j,n)
+
+c     z_j+1 := (z_j+1 - sum hr(i) z_i)/alpha.  With z_j+1 = M U^-1 w
+c     computed during the reduction this is M U^-1 v_j+1, by linearity.
+
+      include 'SIZE'
+      parameter (ld=lx2*ly2*lz2*lelv)
+      real z(ld,j+1),hr(j)
+
+      do i=1,j
+         call add2s2(z(1,j+1),z(1,i),-hr(i),n)
+      enddo
+      call cmult(z(1,j+1),1./alpha,n)
+
       return
       end
 c-----------------------------------------------------------------------
@@ -633,6 +815,7 @@ c     This is the Q Q  part
 c
       call fgslib_gs_op(gsh_dd,v1,1,1,0)  ! 1 ==> +         ! swap v1 & add vals
 
+c$omp parallel do private(e,/work1/)
       do e =1,nelv
          call dface_add1si_g  (v1,-1.,2,e,nx,nz)
          call fastdm1_g       (v1(1,1,1,e),e,w1,w2)
@@ -47,6 +47,12 @@ c     if (name.eq.'VELZ') kfldfdm =  3
       if (name.eq.'PRES') kfldfdm =  ldim+1
 c     if (.not.iffdm) kfldfdm=-1
 C
+#ifdef OPENACC
+      if (imsh.eq.1) call nek_acc_begin
+     $   (u,rhs,h1,h2,mask,mult,binvm1,ntot,name)
+      if (imsh.eq.2) call nek_acc_begin
+     $   (u,rhs,h1,h2,mask,mult,bintm1,ntot,name)
+#endif
       call dssum   (rhs,lx1,ly1,lz1)
       call col2    (rhs,mask,ntot)
 c      if (nio.eq.0.and.istep.le.10) 
@@ -60,6 +66,12 @@ c     $    write(6,*) param(22),' p22 ',istep,imsh
      $   (u,rhs,h1,h2,mask,mult,imsh,tol,maxit,isd,binvm1,name)
       if (imsh.eq.2) call cggo
      $   (u,rhs,h1,h2,mask,mult,imsh,tol,maxit,isd,bintm1,name)
+#ifdef OPENACC
+      if (imsh.eq.1) call nek_acc_end
+     $   (u,rhs,h1,h2,mask,mult,binvm1,ntot)
+      if (imsh.eq.2) call nek_acc_end
+     $   (u,rhs,h1,h2,mask,mult,bintm1,ntot)
+#endif
 
 #ifdef TIMER
       if (name.ne.'PRES') thmhz=thmhz+(dnekclock()-etime1)
@@ -84,6 +96,10 @@ C------------------------------------------------------------------
       include 'INPUT'
       include 'PARALLEL'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
 C
       COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
       COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
@@ -100,15 +116,18 @@ C
      $ ,             TMP2  (LX1,LY1,LZ1)
      $ ,             TMP3  (LX1,LY1,LZ1)
 
-      REAL           TM1   (LX1,LY1,LZ1)
-      REAL           TM2   (LX1,LY1,LZ1)
-      REAL           TM3   (LX1,LY1,LZ1)
       REAL           DUAX  (LX1)
       REAL           YSM1  (LX1)
-      EQUIVALENCE    (DUDR,TM1),(DUDS,TM2),(DUDT,TM3)
 
       integer e
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('axhelm',itmr)
+      call nek_timer_push(itmr)
+
       naxhm = naxhm + 1
       etime1 = dnekclock()
 
@@ -124,6 +143,31 @@ C
       IF (.NOT.IFSOLV) CALL SETFAST(HELM1,HELM2,IMESH)
       CALL RZERO (AU,NTOT)
 
+#ifdef OPENACC
+      if (nek_acc_dev(au)) then
+         call axhelm_acc(au,u,helm1,nel)
+         goto 101
+      endif
+#endif
+
+      if (ldim.eq.3 .and. wdsize.eq.8) then
+         if (param(183).gt.0) then ! compressed geometry, see setgcomp
+            call ax3c_batch(au,u,helm1,g1m1,g2m1,g3m1,g4m1,g5m1,g6m1,
+     $                      dxm1,wddx,wddyt,wddzt,ifdfrm,iffast,
+     $                      gcm1,igcm1,w3m1,wxm1,xm1,ym1,zm1,lx1,nel,
+     $                      ifok)
+         else
+            call ax3_batch(au,u,helm1,g1m1,g2m1,g3m1,g4m1,g5m1,g6m1,
+     $                     dxm1,wddx,wddyt,wddzt,ifdfrm,iffast,lx1,nel,
+     $                     ifok)
+         endif
+         if (ifok.ne.0) goto 101
+      endif
+      if (lgelt.lt.lelt) call exitti
+     $   ('axhelm needs g1m1..g6m1, lgelt too small $',lgelt)
+
+c     setaxdy switches the shared dym1/dytm1 per element
+c$omp parallel do private(e,h1,iz,/ctmp1/) if(.not.ifaxis)
       do 100 e=1,nel
 C
         if (ifaxis) call setaxdy ( ifrzer(e) )
@@ -137,11 +181,11 @@ C
 C          Fast 2-d mode: constant properties and undeformed element
 C
            h1 = helm1(1,1,1,e)
-           call mxm   (wddx,lx1,u(1,1,1,e),lx1,tm1,nyz)
-           call mxm   (u(1,1,1,e),lx1,wddyt,ly1,tm2,ly1)
-           call col2  (tm1,g4m1(1,1,1,e),nxyz)
-           call col2  (tm2,g5m1(1,1,1,e),nxyz)
-           call add3  (au(1,1,1,e),tm1,tm2,nxyz)
+           call mxm   (wddx,lx1,u(1,1,1,e),lx1,dudr,nyz)
+           call mxm   (u(1,1,1,e),lx1,wddyt,ly1,duds,ly1)
+           call col2  (dudr,g4m1(1,1,1,e),nxyz)
+           call col2  (duds,g5m1(1,1,1,e),nxyz)
+           call add3  (au(1,1,1,e),dudr,duds,nxyz)
            call cmult (au(1,1,1,e),h1,nxyz)
 C
            else
@@ -157,10 +201,10 @@ C
            endif
            call col2 (tmp1,helm1(1,1,1,e),nxyz)
            call col2 (tmp2,helm1(1,1,1,e),nxyz)
-           call mxm  (dxtm1,lx1,tmp1,lx1,tm1,nyz)
-           call mxm  (tmp2,lx1,dym1,ly1,tm2,ly1)
-           call add2 (au(1,1,1,e),tm1,nxyz)
-           call add2 (au(1,1,1,e),tm2,nxyz)
+           call mxm  (dxtm1,lx1,tmp1,lx1,dudr,nyz)
+           call mxm  (tmp2,lx1,dym1,ly1,duds,ly1)
+           call add2 (au(1,1,1,e),dudr,nxyz)
+           call add2 (au(1,1,1,e),duds,nxyz)
 
         endif
 C
@@ -173,16 +217,16 @@ C
 C          Fast 3-d mode: constant properties and undeformed element
 C
            h1 = helm1(1,1,1,e)
-           call mxm   (wddx,lx1,u(1,1,1,e),lx1,tm1,nyz)
+           call mxm   (wddx,lx1,u(1,1,1,e),lx1,dudr,nyz)
            do 5 iz=1,lz1
-           call mxm   (u(1,1,iz,e),lx1,wddyt,ly1,tm2(1,1,iz),ly1)
+           call mxm   (u(1,1,iz,e),lx1,wddyt,ly1,duds(1,1,iz),ly1)
  5         continue
-           call mxm   (u(1,1,1,e),nxy,wddzt,lz1,tm3,lz1)
-           call col2  (tm1,g4m1(1,1,1,e),nxyz)
-           call col2  (tm2,g5m1(1,1,1,e),nxyz)
-           call col2  (tm3,g6m1(1,1,1,e),nxyz)
-           call add3  (au(1,1,1,e),tm1,tm2,nxyz)
-           call add2  (au(1,1,1,e),tm3,nxyz)
+           call mxm   (u(1,1,1,e),nxy,wddzt,lz1,dudt,lz1)
+           call col2  (dudr,g4m1(1,1,1,e),nxyz)
+           call col2  (duds,g5m1(1,1,1,e),nxyz)
+           call col2  (dudt,g6m1(1,1,1,e),nxyz)
+           call add3  (au(1,1,1,e),dudr,duds,nxyz)
+           call add2  (au(1,1,1,e),dudt,nxyz)
            call cmult (au(1,1,1,e),h1,nxyz)
 C
            else
@@ -207,20 +251,21 @@ C
            call col2 (tmp1,helm1(1,1,1,e),nxyz)
            call col2 (tmp2,helm1(1,1,1,e),nxyz)
            call col2 (tmp3,helm1(1,1,1,e),nxyz)
-           call mxm  (dxtm1,lx1,tmp1,lx1,tm1,nyz)
+           call mxm  (dxtm1,lx1,tmp1,lx1,dudr,nyz)
            do 20 iz=1,lz1
-              call mxm(tmp2(1,1,iz),lx1,dym1,ly1,tm2(1,1,iz),ly1)
+              call mxm(tmp2(1,1,iz),lx1,dym1,ly1,duds(1,1,iz),ly1)
    20      continue
-           call mxm  (tmp3,nxy,dzm1,lz1,tm3,lz1)
-           call add2 (au(1,1,1,e),tm1,nxyz)
-           call add2 (au(1,1,1,e),tm2,nxyz)
-           call add2 (au(1,1,1,e),tm3,nxyz)
+           call mxm  (tmp3,nxy,dzm1,lz1,dudt,lz1)
+           call add2 (au(1,1,1,e),dudr,nxyz)
+           call add2 (au(1,1,1,e),duds,nxyz)
+           call add2 (au(1,1,1,e),dudt,nxyz)
 C
            endif
 c
         endif
 C
  100  continue
+ 101  continue
 C
       if (ifh2) call addcol4 (au,helm2,bm1,u,ntot)
 C
@@ -255,9 +300,224 @@ C               endif
       endif
 
       taxhm=taxhm+(dnekclock()-etime1)
+      call nek_timer_pop(itmr)
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine axhelm_ds (au,u,helm1,helm2,imesh,isd)
+C
+C     AU = dssum(helm1*[A]u + helm2*[B]u).  With the split-phase dssum
+C     the elements holding shared nodes are applied first and the
+C     exchange runs while the interior elements are applied.
+C
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'CTIMER'
+      include 'DSSPLIT'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
+      include 'WSPACE'
+C
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+C
+      REAL AU(1),U(1),HELM1(1),HELM2(1)
+      integer h,dssum_split_slot
+
+      nel=nelt
+      if (imesh.eq.1) nel=nelv
+
+#ifdef OPENACC
+      if (nek_acc_dev(au)) then
+         call axhelm (au,u,helm1,helm2,imesh,isd)
+         call dssum  (au,lx1,ly1,lz1)
+         return
+      endif
+#endif
+
+      h = dssum_split_slot()
+      ifok = 0
+      if (h.gt.0 .and. ldim.eq.3 .and. wdsize.eq.8 .and. .not.ifaxis)
+     $   call ax3_batch(au,u,helm1,helm1,helm1,helm1,helm1,helm1,helm1,
+     $                  wddx,wddx,wddyt,wddzt,ifdfrm,iffast,lx1,0,ifok)
+      if (ifok.eq.0 .or. ds_nel(max(h,1)).ne.nel) then
+         call axhelm (au,u,helm1,helm2,imesh,isd)
+         call dssum  (au,lx1,ly1,lz1)
+         return
+      endif
+
+      naxhm = naxhm + 1
+      etime1 = dnekclock()
+
+      IF (.NOT.IFSOLV) CALL SETFAST(HELM1,HELM2,IMESH)
+
+      nb = ds_nbel(h)
+      call axhelm_list (au,u,helm1,helm2,iws(ds_kelst(h)),nb)
+      call dssum_begin (au)
+      call axhelm_list (au,u,helm1,helm2,iws(ds_kelst(h)+nb),nel-nb)
+      taxhm=taxhm+(dnekclock()-etime1)
+      call dssum_end   (au)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine axhelm_list (au,u,helm1,helm2,elist,nl)
+C
+C     3-d, double precision axhelm on the elements elist(1:nl)
+C
+      include 'SIZE'
+      include 'DXYZ'
+      include 'GEOM'
+      include 'MASS'
+      include 'INPUT'
+      include 'WZ'
+C
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+C
+      parameter (lxyz=lx1*ly1*lz1)
+      REAL AU(lxyz,1),U(lxyz,1),HELM1(lxyz,1),HELM2(lxyz,1)
+      integer elist(1),e,eg
+
+      do ie=1,nl
+         e = elist(ie)
+         if (param(183).gt.0) then
+         eg = min(e,lgelt) ! g1m1..g6m1 unused if not stored
+         call ax3c_batch(au(1,e),u(1,e),helm1(1,e)
+     $                 ,g1m1(1,1,1,eg),g2m1(1,1,1,eg),g3m1(1,1,1,eg)
+     $                 ,g4m1(1,1,1,eg),g5m1(1,1,1,eg),g6m1(1,1,1,eg)
+     $                 ,dxm1,wddx,wddyt,wddzt,ifdfrm(e),iffast(e)
+     $                 ,gcm1(1,e),igcm1(e),w3m1,wxm1
+     $                 ,xm1(1,1,1,e),ym1(1,1,1,e),zm1(1,1,1,e)
+     $                 ,lx1,1,ifok)
+         else
+         call ax3_batch(au(1,e),u(1,e),helm1(1,e)
+     $                 ,g1m1(1,1,1,e),g2m1(1,1,1,e),g3m1(1,1,1,e)
+     $                 ,g4m1(1,1,1,e),g5m1(1,1,1,e),g6m1(1,1,1,e)
+     $                 ,dxm1,wddx,wddyt,wddzt,ifdfrm(e),iffast(e)
+     $                 ,lx1,1,ifok)
+         endif
+         if (ifh2) call addcol4 (au(1,e),helm2(1,e),bm1(1,1,1,e)
+     $                          ,u(1,e),lxyz)
+      enddo
+
+      return
+      end
+C
+c-----------------------------------------------------------------------
+      subroutine axhelm_many (au,u,nv,n,helm1,helm2,imesh,isd)
+C
+C     AU(,k) = helm1*[A]u(,k) + helm2*[B]u(,k), k=1,...,nv, for vectors
+C     sharing helm1 and helm2 (no dssum).  In 3-d double precision the
+C     elements are walked once for all vectors (ax3m_batch).
+C
+      include 'SIZE'
+      include 'DXYZ'
+      include 'GEOM'
+      include 'MASS'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'CTIMER'
+C
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+C
+      REAL AU(N,NV),U(N,NV),HELM1(1),HELM2(1)
+
+      nel=nelt
+      if (imesh.eq.1) nel=nelv
+
+      ifok = 0
+      if (ldim.eq.3 .and. wdsize.eq.8 .and. param(183).eq.0) then
+         naxhm = naxhm + 1
+         etime1 = dnekclock()
+         IF (.NOT.IFSOLV) CALL SETFAST(HELM1,HELM2,IMESH)
+         call ax3m_batch(au,u,nv,n,helm1,0,g1m1,g2m1,g3m1,g4m1,g5m1,
+     $                   g6m1,dxm1,wddx,wddyt,wddzt,ifdfrm,iffast,lx1,
+     $                   nel,ifok)
+         if (ifok.ne.0 .and. ifh2) then
+            do k=1,nv
+               call addcol4 (au(1,k),helm2,bm1,u(1,k),n)
+            enddo
+         endif
+         taxhm=taxhm+(dnekclock()-etime1)
+      endif
+
+      if (ifok.eq.0) then
+         do k=1,nv
+            call axhelm (au(1,k),u(1,k),helm1,helm2,imesh,isd)
+         enddo
+      endif
+
       return
       end
+c-----------------------------------------------------------------------
+      subroutine axhelm_vec (au,u,helm1,nv,ld,n,imesh)
+C
+C     AU(,k) = helm1(,k)*[A]u(,k), k=1,...,nv, for vectors ld apart with
+C     their own helm1 (helm2 = 0, no dssum).  As axhelm_many, the 3-d
+C     double precision case walks the elements once for all vectors;
+C     an element takes the fast path only if it does for every helm1.
+C
+      include 'SIZE'
+      include 'DXYZ'
+      include 'GEOM'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'CTIMER'
+      include 'WSPACE'
 C
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+C
+      REAL AU(LD,NV),U(LD,NV),HELM1(LD,NV)
+      LOGICAL IFALL(LELT)
+      integer*8 k2
+
+      nel=nelt
+      if (imesh.eq.1) nel=nelv
+
+      call nek_ws_push
+      k2 = nek_ws_r(n)
+      call rzero(ws(k2),n)
+
+      ifok = 0
+      if (ldim.eq.3 .and. wdsize.eq.8 .and. param(183).eq.0) then
+         naxhm = naxhm + 1
+         etime1 = dnekclock()
+         do k=1,nv
+            call setfast(helm1(1,k),ws(k2),imesh)
+            do ie=1,nel
+               if (k.eq.1) ifall(ie) = iffast(ie)
+               ifall(ie) = ifall(ie) .and. iffast(ie)
+            enddo
+         enddo
+         do ie=1,nel
+            iffast(ie) = ifall(ie)
+         enddo
+         call ax3m_batch(au,u,nv,ld,helm1,ld,g1m1,g2m1,g3m1,g4m1,g5m1,
+     $                   g6m1,dxm1,wddx,wddyt,wddzt,ifdfrm,iffast,lx1,
+     $                   nel,ifok)
+         taxhm=taxhm+(dnekclock()-etime1)
+      endif
+
+      if (ifok.eq.0) then
+         do k=1,nv
+            call axhelm (au(1,k),u(1,k),helm1(1,k),ws(k2),imesh,1)
+         enddo
+      endif
+
+      call nek_ws_pop
+
+      return
+      end
 c=======================================================================
       subroutine setfast (helm1,helm2,imesh)
 C-------------------------------------------------------------------
@@ -303,6 +563,9 @@ c
       IFH2   = .FALSE.
       TESTH2 =  VLAMAX(HELM2,NTOT)
       IF (TESTH2.GT.0.) IFH2 = .TRUE.
+#ifdef OPENACC
+      call nek_acc_setfast
+#endif
       return
       END
 C
@@ -349,6 +612,10 @@ C
   300    CONTINUE
          IFIRST=.FALSE.
       ENDIF
+C
+C     Without stored factors the fast elements use gcm1 (setgcomp)
+C
+      IF (LGELT.LT.LELT) RETURN
 C
       IF (ldim.EQ.3) THEN
          DO 1001 IE=1,NELT
@@ -390,16 +657,19 @@ C-------------------------------------------------------------------
       include 'INPUT'
       include 'TSTEP'
       include 'MASS'
+      include 'WSPACE'
       REAL            DPCM1 (LX1,LY1,LZ1,1)
       COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
       LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
       REAL            HELM1(lx1,ly1,lz1,1), HELM2(lx1,ly1,lz1,1)
       REAL YSM1(LY1)
+      integer*8 kg
 
       nel=nelt
       if (imsh.eq.1) nel=nelv
 
-      ntot = nel*lx1*ly1*lz1
+      nxyz = lx1*ly1*lz1
+      ntot = nel*nxyz
 
 c     The following lines provide a convenient debugging option
 c     call rone(dpcm1,ntot)
@@ -407,84 +677,23 @@ c     if (ifield.eq.1) call copy(dpcm1,binvm1,ntot)
 c     if (ifield.eq.2) call copy(dpcm1,bintm1,ntot)
 c     return
 
+      CALL NEK_WS_PUSH
+      KG = NEK_WS_R(6*NXYZ)
+
       CALL RZERO(DPCM1,NTOT)
       DO 1000 IE=1,NEL
 
         IF (IFAXIS) CALL SETAXDY ( IFRZER(IE) )
 
-        DO 320 IQ=1,lx1
-        DO 320 IZ=1,lz1
-        DO 320 IY=1,ly1
-        DO 320 IX=1,lx1
-           DPCM1(IX,IY,IZ,IE) = DPCM1(IX,IY,IZ,IE) + 
-     $                          G1M1(IQ,IY,IZ,IE) * DXTM1(IX,IQ)**2
-  320   CONTINUE
-        DO 340 IQ=1,ly1
-        DO 340 IZ=1,lz1
-        DO 340 IY=1,ly1
-        DO 340 IX=1,lx1
-           DPCM1(IX,IY,IZ,IE) = DPCM1(IX,IY,IZ,IE) + 
-     $                          G2M1(IX,IQ,IZ,IE) * DYTM1(IY,IQ)**2
-  340   CONTINUE
-        IF (LDIM.EQ.3) THEN
-           DO 360 IQ=1,lz1
-           DO 360 IZ=1,lz1
-           DO 360 IY=1,ly1
-           DO 360 IX=1,lx1
-              DPCM1(IX,IY,IZ,IE) = DPCM1(IX,IY,IZ,IE) + 
-     $                             G3M1(IX,IY,IQ,IE) * DZTM1(IZ,IQ)**2
-  360      CONTINUE
-C
-C          Add cross terms if element is deformed.
-C
-           IF (IFDFRM(IE)) THEN
-              DO 600 IY=1,ly1,ly1-1
-              DO 600 IZ=1,lz1,max(1,lz1-1)
-              DPCM1(1,IY,IZ,IE) = DPCM1(1,IY,IZ,IE)
-     $            + G4M1(1,IY,IZ,IE) * DXTM1(1,1)*DYTM1(IY,IY)
-     $            + G5M1(1,IY,IZ,IE) * DXTM1(1,1)*DZTM1(IZ,IZ)
-              DPCM1(lx1,IY,IZ,IE) = DPCM1(lx1,IY,IZ,IE)
-     $            + G4M1(lx1,IY,IZ,IE) * DXTM1(lx1,lx1)*DYTM1(IY,IY)
-     $            + G5M1(lx1,IY,IZ,IE) * DXTM1(lx1,lx1)*DZTM1(IZ,IZ)
-  600         CONTINUE
-              DO 700 IX=1,lx1,lx1-1
-              DO 700 IZ=1,lz1,max(1,lz1-1)
-                 DPCM1(IX,1,IZ,IE) = DPCM1(IX,1,IZ,IE)
-     $            + G4M1(IX,1,IZ,IE) * DYTM1(1,1)*DXTM1(IX,IX)
-     $            + G6M1(IX,1,IZ,IE) * DYTM1(1,1)*DZTM1(IZ,IZ)
-                 DPCM1(IX,ly1,IZ,IE) = DPCM1(IX,ly1,IZ,IE)
-     $            + G4M1(IX,ly1,IZ,IE) * DYTM1(ly1,ly1)*DXTM1(IX,IX)
-     $            + G6M1(IX,ly1,IZ,IE) * DYTM1(ly1,ly1)*DZTM1(IZ,IZ)
-  700         CONTINUE
-              DO 800 IX=1,lx1,lx1-1
-              DO 800 IY=1,ly1,ly1-1
-                 DPCM1(IX,IY,1,IE) = DPCM1(IX,IY,1,IE)
-     $                + G5M1(IX,IY,1,IE) * DZTM1(1,1)*DXTM1(IX,IX)
-     $                + G6M1(IX,IY,1,IE) * DZTM1(1,1)*DYTM1(IY,IY)
-                 DPCM1(IX,IY,lz1,IE) = DPCM1(IX,IY,lz1,IE)
-     $                + G5M1(IX,IY,lz1,IE) * DZTM1(lz1,lz1)*DXTM1(IX,IX)
-     $                + G6M1(IX,IY,lz1,IE) * DZTM1(lz1,lz1)*DYTM1(IY,IY)
-  800         CONTINUE
-           ENDIF
-
-        ELSE  ! 2D
-
-           IZ=1
-           IF (IFDFRM(IE)) THEN
-              DO 602 IY=1,ly1,ly1-1
-                 DPCM1(1,IY,IZ,IE) = DPCM1(1,IY,IZ,IE)
-     $                + G4M1(1,IY,IZ,IE) * DXTM1(1,1)*DYTM1(IY,IY)
-                 DPCM1(lx1,IY,IZ,IE) = DPCM1(lx1,IY,IZ,IE)
-     $                + G4M1(lx1,IY,IZ,IE) * DXTM1(lx1,lx1)*DYTM1(IY,IY)
-  602         CONTINUE
-              DO 702 IX=1,lx1,lx1-1
-                 DPCM1(IX,1,IZ,IE) = DPCM1(IX,1,IZ,IE)
-     $                + G4M1(IX,1,IZ,IE) * DYTM1(1,1)*DXTM1(IX,IX)
-                 DPCM1(IX,ly1,IZ,IE) = DPCM1(IX,ly1,IZ,IE)
-     $                + G4M1(IX,ly1,IZ,IE) * DYTM1(ly1,ly1)*DXTM1(IX,IX)
-  702         CONTINUE
-           ENDIF
-
+        IF (LGELT.LT.LELT) THEN ! factors not stored
+           CALL GEOFAC1 (WS(KG),IE)
+           CALL SETPREC_E (DPCM1(1,1,1,IE),WS(KG),WS(KG+NXYZ)
+     $          ,WS(KG+2*NXYZ),WS(KG+3*NXYZ),WS(KG+4*NXYZ)
+     $          ,WS(KG+5*NXYZ),IFDFRM(IE))
+        ELSE
+           CALL SETPREC_E (DPCM1(1,1,1,IE),G1M1(1,1,1,IE)
+     $          ,G2M1(1,1,1,IE),G3M1(1,1,1,IE),G4M1(1,1,1,IE)
+     $          ,G5M1(1,1,1,IE),G6M1(1,1,1,IE),IFDFRM(IE))
         ENDIF
  1000 CONTINUE
 C
@@ -519,6 +728,98 @@ C
 C
       CALL DSSUM (DPCM1,lx1,ly1,lz1)
       CALL INVCOL1 (DPCM1,NTOT)
+C
+      CALL NEK_WS_POP
+C
+      return
+      END
+C
+c=======================================================================
+      subroutine setprec_e (d,g1,g2,g3,g4,g5,g6,ifdf)
+C
+C     D += diagonal of [A] for one element with factors G1..G6
+C
+      include 'SIZE'
+      include 'DXYZ'
+      REAL    D (LX1,LY1,LZ1)
+      REAL    G1(LX1,LY1,LZ1),G2(LX1,LY1,LZ1),G3(LX1,LY1,LZ1)
+      REAL    G4(LX1,LY1,LZ1),G5(LX1,LY1,LZ1),G6(LX1,LY1,LZ1)
+      LOGICAL IFDF
+C
+      DO 320 IQ=1,lx1
+      DO 320 IZ=1,lz1
+      DO 320 IY=1,ly1
+      DO 320 IX=1,lx1
+         D(IX,IY,IZ) = D(IX,IY,IZ) + 
+     $                          G1(IQ,IY,IZ) * DXTM1(IX,IQ)**2
+  320 CONTINUE
+      DO 340 IQ=1,ly1
+      DO 340 IZ=1,lz1
+      DO 340 IY=1,ly1
+      DO 340 IX=1,lx1
+         D(IX,IY,IZ) = D(IX,IY,IZ) + 
+     $                          G2(IX,IQ,IZ) * DYTM1(IY,IQ)**2
+  340 CONTINUE
+      IF (LDIM.EQ.3) THEN
+         DO 360 IQ=1,lz1
+         DO 360 IZ=1,lz1
+         DO 360 IY=1,ly1
+         DO 360 IX=1,lx1
+            D(IX,IY,IZ) = D(IX,IY,IZ) + 
+     $                             G3(IX,IY,IQ) * DZTM1(IZ,IQ)**2
+  360    CONTINUE
+C
+C          Add cross terms if element is deformed.
+C
+         IF (IFDF) THEN
+            DO 600 IY=1,ly1,ly1-1
+            DO 600 IZ=1,lz1,max(1,lz1-1)
+            D(1,IY,IZ) = D(1,IY,IZ)
+     $            + G4(1,IY,IZ) * DXTM1(1,1)*DYTM1(IY,IY)
+     $            + G5(1,IY,IZ) * DXTM1(1,1)*DZTM1(IZ,IZ)
+            D(lx1,IY,IZ) = D(lx1,IY,IZ)
+     $            + G4(lx1,IY,IZ) * DXTM1(lx1,lx1)*DYTM1(IY,IY)
+     $            + G5(lx1,IY,IZ) * DXTM1(lx1,lx1)*DZTM1(IZ,IZ)
+  600       CONTINUE
+            DO 700 IX=1,lx1,lx1-1
+            DO 700 IZ=1,lz1,max(1,lz1-1)
+               D(IX,1,IZ) = D(IX,1,IZ)
+     $            + G4(IX,1,IZ) * DYTM1(1,1)*DXTM1(IX,IX)
+     $            + G6(IX,1,IZ) * DYTM1(1,1)*DZTM1(IZ,IZ)
+               D(IX,ly1,IZ) = D(IX,ly1,IZ)
+     $            + G4(IX,ly1,IZ) * DYTM1(ly1,ly1)*DXTM1(IX,IX)
+     $            + G6(IX,ly1,IZ) * DYTM1(ly1,ly1)*DZTM1(IZ,IZ)
+  700       CONTINUE
+            DO 800 IX=1,lx1,lx1-1
+            DO 800 IY=1,ly1,ly1-1
+               D(IX,IY,1) = D(IX,IY,1)
+     $                + G5(IX,IY,1) * DZTM1(1,1)*DXTM1(IX,IX)
+     $                + G6(IX,IY,1) * DZTM1(1,1)*DYTM1(IY,IY)
+               D(IX,IY,lz1) = D(IX,IY,lz1)
+     $                + G5(IX,IY,lz1) * DZTM1(lz1,lz1)*DXTM1(IX,IX)
+     $                + G6(IX,IY,lz1) * DZTM1(lz1,lz1)*DYTM1(IY,IY)
+  800       CONTINUE
+         ENDIF
+
+      ELSE  ! 2D
+
+         IZ=1
+         IF (IFDF) THEN
+            DO 602 IY=1,ly1,ly1-1
+               D(1,IY,IZ) = D(1,IY,IZ)
+     $                + G4(1,IY,IZ) * DXTM1(1,1)*DYTM1(IY,IY)
+               D(lx1,IY,IZ) = D(lx1,IY,IZ)
+     $                + G4(lx1,IY,IZ) * DXTM1(lx1,lx1)*DYTM1(IY,IY)
+  602       CONTINUE
+            DO 702 IX=1,lx1,lx1-1
+               D(IX,1,IZ) = D(IX,1,IZ)
+     $                + G4(IX,1,IZ) * DYTM1(1,1)*DXTM1(IX,IX)
+               D(IX,ly1,IZ) = D(IX,ly1,IZ)
+     $                + G4(IX,ly1,IZ) * DYTM1(ly1,ly1)*DXTM1(IX,IX)
+  702       CONTINUE
+         ENDIF
+
+      ENDIF
 C
       return
       END
@@ -626,7 +927,7 @@ C------------------------------------------------------------------------
       common /fastmd/ ifdfrm(lelt), iffast(lelt), ifh2, ifsolv
       logical ifdfrm, iffast, ifh2, ifsolv
 
-      logical ifmcor,ifprint_hmh
+      logical ifmcor,ifprint_hmh,ifpipe
  
       real x(1),f(1),h1(1),h2(1),mask(1),mult(1),binv(1)
       parameter        (lg=lx1*ly1*lz1*lelt)
@@ -676,11 +977,18 @@ c     overrule input tolerance
 C
 C     Set up diag preconditioner.
 C
+#ifdef OPENACC
+      call nek_acc_host_push
+#endif
       if (kfldfdm.lt.0) then
          call setprec(D,h1,h2,imsh,isd)
       elseif(param(100).ne.2) then
          call set_fdm_prec_h1b(d,h1,h2,nel)
       endif
+#ifdef OPENACC
+      call nek_acc_host_pop
+      call nek_acc_todev(d,n)
+#endif
 
       call copy (r,f,n)
       call rzero(x,n)
@@ -707,6 +1015,14 @@ c        call ortho (r)           ! Commented out March 15, 2011,pff
          call add2s2(r,x,rmean,n)
          call rzero(x,n)
       endif
+C
+      ifpipe = ifpipefld(ifield)
+      if (name.eq.'PRES') ifpipe = param(180).gt.0
+      if (ifpipe .and. kfldfdm.lt.0 .and. .not.ifmcor) then
+         call cggo_pipe(x,d,h1,h2,mask,mult,binv,imsh,isd,n,vol
+     $                 ,tin,tol,niter,name)
+         goto 9999
+      endif
 C
       krylov = 0
       rtz1=1.0
@@ -778,8 +1094,7 @@ c
          beta = rtz1/rtz2
          if (iter.eq.1) beta=0.0
          call add2s1 (p,z,beta,n)
-         call axhelm (w,p,h1,h2,imsh,isd)
-         call dssum  (w,lx1,ly1,lz1)
+         call axhelm_ds (w,p,h1,h2,imsh,isd)
          call col2   (w,mask,n)
 c
          rho0 = rho
@@ -827,12 +1142,359 @@ c
 c     if (n.gt.0) write(6,*) 'quit in cggo'
 c     if (n.gt.0) call exitt
 c     call exitt
+      return
+      end
+c=======================================================================
+      subroutine cggo_pipe(x,d,h1,h2,mask,mult,binv,imsh,isd,n,vol
+     $                    ,tin,tol,niter,name)
+c
+c     Pipelined Jacobi preconditioned CG (Ghysels & Vanroose 2014) for
+c     cggo.  The three inner products of an iteration, including the
+c     residual norm of the convergence check, go into one nonblocking
+c     gop that is overlapped with the preconditioner and the matvec.
+c     On input x = p = 0 and r = f (/scrmg/ of cggo); niter is the
+c     max/used iteration count.
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      COMMON  /CPRINT/ IFPRINT, IFHZPC
+      LOGICAL          IFPRINT, IFHZPC
+
+      real x(n),d(n),h1(n),h2(n),mask(n),mult(n),binv(n)
+      character*4 name
+
+      parameter        (lg=lx1*ly1*lz1*lelt)
+      common /SCRMG/  r (lg) , w (lg) , p (lg) , z (lg)
+      common /scrpcg/ u (lg) , vm(lg) , vn(lg) , q (lg) , s (lg)
+
+      real red(3),wrk(3)
+      logical ifprint_hmh
+
+      call col3     (u,r,d,n)                    ! u = M r
+      call axhelm_ds(w,u,h1,h2,imsh,isd)         ! w = A u
+      call col2     (w,mask,n)
+      call rzero    (z,n)
+      call rzero    (q,n)
+      call rzero    (s,n)
+
+      maxit = niter
+      do iter=1,maxit
+
+         red(1) = vlsc3 (r,u,mult,n)             ! gamma = (r,u)
+         red(2) = vlsc3 (w,u,mult,n)             ! delta = (w,u)
+         red(3) = vlsc32(r,mult,binv,n)          ! |r|^2
+         call gop_begin(red,wrk,'+  ',3,ireq)
+
+         call col3     (vm,w,d,n)                ! m = M w
+         call axhelm_ds(vn,vm,h1,h2,imsh,isd)    ! n = A m
+         call col2     (vn,mask,n)
+
+         call gop_end  (red,wrk,3,ireq)
+         gamma = red(1)
+         delta = red(2)
+         rbn2  = sqrt(red(3)/vol)
+         if (iter.eq.1) rbn0 = rbn2
+         if (param(22).lt.0) tol=abs(param(22))*rbn0
+         if (tin.lt.0)       tol=abs(tin)*rbn0
+
+         ifprint_hmh = .false.
+         if (nio.eq.0.and.ifprint.and.param(74).ne.0) ifprint_hmh=.true.
+         if (nio.eq.0.and.istep.eq.1)                 ifprint_hmh=.true.
+
+         if (ifprint_hmh)
+     &      write(6,3002) istep,'  Hmholtz ' // name,
+     &                    iter,rbn2,h1(1),tol,h2(1),.false.
+
+#ifndef TST_WSCAL
+         if (rbn2.le.tol.and.(iter.gt.1 .or. istep.le.5)) then
+#else
+         iter_max = param(150)
+         if (name.eq.'PRES') iter_max = param(151)
+         if (iter.gt.iter_max) then
+#endif
+            niter = iter-1
+            if (nio.eq.0)
+     &         write(6,3000) istep,'  Hmholtz ' // name,
+     &                       niter,rbn2,rbn0,tol
+            return
+         endif
+
+         if (iter.eq.1) then
+            beta  = 0.
+            alpha = gamma/delta
+         else
+            beta  = gamma/gamma0
+            alpha = gamma/(delta-beta*gamma/alpha0)
+         endif
+         gamma0 = gamma
+         alpha0 = alpha
+
+         call add2s1(z,vn,beta,n)                ! z = n + beta z
+         call add2s1(q,vm,beta,n)                ! q = m + beta q
+         call add2s1(s,w ,beta,n)                ! s = w + beta s
+         call add2s1(p,u ,beta,n)                ! p = u + beta p
+         call add2s2(x,p ,alpha,n)
+         call add2s2(r,s ,-alpha,n)
+         call add2s2(u,q ,-alpha,n)
+         call add2s2(w,z ,-alpha,n)
+      enddo
+      niter = maxit
+
+      if (nio.eq.0) write (6,3001) istep, '  Error Hmholtz ' // name,
+     &                             niter,rbn2,rbn0,tol
+
+ 3000 format(i11,a,1x,I7,1p4E13.4)
+ 3001 format(i11,a,1x,I7,1p4E13.4)
+ 3002 format(i11,a,1x,I7,1p4E13.4,l4)
+
+      return
+      end
+c=======================================================================
+      subroutine hmholtz_block(name,u,rhs,jf,nb,n,h1,h2,mask,mult,imsh
+     $                        ,maxit,isd)
+c
+c     hmholtz for nb right-hand sides rhs(n,nb) of the passive scalars
+c     jf(1:nb), all with the operator h1, h2, mask, mult.  The columns
+c     are solved together by cggo_block, rhs is destroyed.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CTIMER'
+
+      character*4 name(nb)
+      integer     jf(nb)
+      real        u(n,nb),rhs(n,nb),h1(1),h2(1),mask(1),mult(1)
+
+      parameter (lb=ldimt1)
+      real tol(lb)
+
+#ifdef TIMER
+      nhmhz = nhmhz + nb
+      etime1 = dnekclock()
+#endif
+
+      ifld0 = ifield
+      call nvec_dssum(rhs,n,nb,gsh_fld(ifield))
+
+      do k=1,nb
+         ifield = jf(k)
+         tli    = tolht(ifield)
+         tol(k) = abs(tli)
+         call col2 (rhs(1,k),mask,n)
+         if (param(22).eq.0.or.istep.le.10)
+     $      call chktcg1 (tol(k),rhs(1,k),h1,h2,mask,mult,imsh,isd)
+         if (tli.lt.0) tol(k)=tli ! caller-specified relative tolerance
+         if (tol(k).gt.0 .and. restol(ifield).ne.0)
+     $      tol(k) = restol(ifield)       ! overrule input tolerance
+      enddo
+      ifield = ifld0
+
+      if (imsh.eq.1) call cggo_block
+     $   (u,rhs,nb,n,h1,h2,mask,1,mult,imsh,isd,binvm1,tol,maxit,name)
+      if (imsh.eq.2) call cggo_block
+     $   (u,rhs,nb,n,h1,h2,mask,1,mult,imsh,isd,bintm1,tol,maxit,name)
+
+#ifdef TIMER
+      thmhz=thmhz+(dnekclock()-etime1)
+#endif
+
+      return
+      end
+c=======================================================================
+      subroutine cggo_block(x,r,nb,n,h1,h2,mask,nm,mult,imsh,isd,binv
+     $                     ,tin,maxit,name)
+c
+c     Jacobi preconditioned CG for nb right-hand sides r(n,nb) with the
+c     same operator.  It uses the single-reduction (Chronopoulos-Gear)
+c     form of cggo_pipe, so an iteration does one operator apply and
+c     one dssum for all unconverged columns (axhelm_many, nvec_dssum)
+c     and one gop for all their inner products.  Converged columns are
+c     swapped out of the active block.  Column k is masked with
+c     mask(:,1+mod(k-1,nm)), so nm=ldim gives the velocity components
+c     of several fields.  tin(k) as for cggo, r is overwritten.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'WSPACE'
+
+      real x(n,nb),r(n,nb),h1(1),h2(1),mask(n,nm),mult(1),binv(1)
+      real tin(nb)
+      character*4 name(nb)
+
+      integer*8 kd,kx,kz,kw,kp,ks
+      integer   nw
+
+      nw = n*nb
+      call nek_ws_push
+      kd = nek_ws_r(n)
+      kx = nek_ws_r(nw)
+      kz = nek_ws_r(nw)
+      kw = nek_ws_r(nw)
+      kp = nek_ws_r(nw)
+      ks = nek_ws_r(nw)
+
+      call cggo_block1(x,r,nb,n,h1,h2,mask,nm,mult,imsh,isd,binv,tin
+     $  ,maxit,name,ws(kd),ws(kx),ws(kz),ws(kw),ws(kp),ws(ks))
+
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine cggo_block1(x,r,nb,n,h1,h2,mask,nm,mult,imsh,isd
+     $                      ,binv,tin,maxit,name,d,xw,z,w,p,s)
+
+      include 'SIZE'
+      include 'TOTAL'
+
+      COMMON  /CPRINT/ IFPRINT, IFHZPC
+      LOGICAL          IFPRINT, IFHZPC
+
+      common /fastmd/ ifdfrm(lelt), iffast(lelt), ifh2, ifsolv
+      logical ifdfrm, iffast, ifh2, ifsolv
+
+      real x(n,nb),r(n,nb),h1(1),h2(1),mask(n,nm),mult(1),binv(1)
+      real tin(nb),d(n)
+      real xw(n,nb),z(n,nb),w(n,nb),p(n,nb),s(n,nb)   ! work arrays
+      character*4 name(nb)
+
+      parameter (lb=max(ldimt1,ldim*lpert))
+      real    red(3,lb),wrk(3,lb),tol(lb),rbn0(lb),gam0(lb),alp0(lb)
+      integer jc(lb)
+      logical ifprint_hmh
+
+      parameter (maxcg=900)
+
+      vol = volvm1
+      if (imsh.eq.2) vol = voltm1
+
+      niter = min(maxit,maxcg)
+
+      if (.not.ifsolv) then
+         call setfast(h1,h2,imsh)
+         ifsolv = .true.
+      endif
+      call setprec(d,h1,h2,imsh,isd)
+
+      call rzero(xw,n*nb)
+      call rzero(p ,n*nb)
+      call rzero(s ,n*nb)
+
+      do k=1,nb
+         jc (k) = k               ! column k holds rhs jc(k)
+         tol(k) = abs(tin(k))
+      enddo
+      na = nb                     ! active columns 1:na
+
+      do iter=1,niter
+
+         do k=1,na
+            call col3 (z(1,k),r(1,k),d,n)             ! z = M r
+         enddo
+         call axhelm_many (w,z,na,n,h1,h2,imsh,isd)   ! w = A z
+         call nvec_dssum  (w,n,na,gsh_fld(ifield))
+         do k=1,na
+            call col2 (w(1,k),mask(1,1+mod(jc(k)-1,nm)),n)
+            red(1,k) = vlsc3 (r(1,k),z(1,k),mult,n)   ! gamma = (r,z)
+            red(2,k) = vlsc3 (w(1,k),z(1,k),mult,n)   ! delta = (w,z)
+            red(3,k) = vlsc32(r(1,k),mult,binv,n)     ! |r|^2
+         enddo
+         call gop(red,wrk,'+  ',3*na)
+
+         ifprint_hmh = .false.
+         if (nio.eq.0.and.ifprint.and.param(74).ne.0) ifprint_hmh=.true.
+         if (nio.eq.0.and.istep.eq.1)                 ifprint_hmh=.true.
+
+         k = 1
+   10    if (k.le.na) then
+            j    = jc(k)
+            rbn2 = sqrt(red(3,k)/vol)
+            if (iter.eq.1) rbn0(k) = rbn2
+            if (param(22).lt.0) tol(k)=abs(param(22))*rbn0(k)
+            if (tin(j).lt.0)    tol(k)=abs(tin(j))*rbn0(k)
+
+            if (ifprint_hmh)
+     &         write(6,3002) istep,'  Hmholtz ' // name(j),
+     &                       iter,rbn2,h1(1),tol(k),h2(1),.false.
+
+            if ((rbn2.le.tol(k).and.(iter.gt.1 .or. istep.le.5))
+     $          .or. rbn2.eq.0) then
+               if (nio.eq.0)
+     &            write(6,3000) istep,'  Hmholtz ' // name(j),
+     &                          iter-1,rbn2,rbn0(k),tol(k)
+               call copy(x(1,j),xw(1,k),n)
+               if (k.lt.na) then     ! move the last active column to k
+                  call copy(xw(1,k),xw(1,na),n)
+                  call copy(r (1,k),r (1,na),n)
+                  call copy(z (1,k),z (1,na),n)
+                  call copy(w (1,k),w (1,na),n)
+                  call copy(p (1,k),p (1,na),n)
+                  call copy(s (1,k),s (1,na),n)
+                  do i=1,3
+                     red(i,k) = red(i,na)
+                  enddo
+                  jc  (k) = jc  (na)
+                  tol (k) = tol (na)
+                  rbn0(k) = rbn0(na)
+                  gam0(k) = gam0(na)
+                  alp0(k) = alp0(na)
+               endif
+               na = na-1
+            else
+               k = k+1
+            endif
+            goto 10
+         endif
+         if (na.eq.0) goto 9999
+
+         do k=1,na
+            gamma = red(1,k)
+            delta = red(2,k)
+            if (iter.eq.1) then
+               beta  = 0.
+               alpha = gamma/delta
+            else
+               beta  = gamma/gam0(k)
+               alpha = gamma/(delta-beta*gamma/alp0(k))
+            endif
+            gam0(k) = gamma
+            alp0(k) = alpha
+            call add2s1(p (1,k),z(1,k), beta,n)     ! p = z + beta p
+            call add2s1(s (1,k),w(1,k), beta,n)     ! s = w + beta s
+            call add2s2(xw(1,k),p(1,k), alpha,n)
+            call add2s2(r (1,k),s(1,k),-alpha,n)
+         enddo
+      enddo
+
+      do k=1,na
+         j = jc(k)
+         rbn2 = sqrt(red(3,k)/vol)
+         if (nio.eq.0) write (6,3001) istep, '  Error Hmholtz ' //
+     &                 name(j),niter,rbn2,rbn0(k),tol(k)
+         call copy(x(1,j),xw(1,k),n)
+      enddo
+
+ 3000 format(i11,a,1x,I7,1p4E13.4)
+ 3001 format(i11,a,1x,I7,1p4E13.4)
+ 3002 format(i11,a,1x,I7,1p4E13.4,l4)
+ 9999 continue
+      ifsolv = .false.
+
       return
       end
 c=======================================================================
       function vlsc32(r,b,m,n)
       real r(1),b(1),m(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       s = 0.
+#ifdef OPENACC
+      ifdev = nek_acc_dev(r)
+#endif
+c$acc parallel loop default(present) reduction(+:s) if(ifdev)
       do i=1,n
          s = s + b(i)*m(i)*r(i)*r(i)
       enddo
@@ -47,9 +47,17 @@ c----------------------------------------------------------------------
       integer nf,nc,nr
       integer nx,ny,nz
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('hsmg_setup',itmr)
+      call nek_timer_push(itmr)
+
       mg_fld = 1
       if (ifield.gt.1) mg_fld = 2
       if (ifield.eq.1) call hsmg_index_0 ! initialize index sets
+      call hsmg_setup_sp
 
       call hsmg_setup_mg_nx  ! set nx values for each level of multigrid
       call hsmg_setup_semhat ! set spectral element hat matrices
@@ -61,6 +69,28 @@ c----------------------------------------------------------------------
       call hsmg_setup_solve  ! set up the solver
 c     call hsmg_setup_dbg
 
+      call nek_timer_pop(itmr)
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_setup_sp
+c
+c     With param(187) > 0 the FDM eigenvectors/eigenvalues and the
+c     Schwarz weights are kept in single precision: they are computed
+c     in double, rounded once, and the smoother reads half the bytes.
+c     The smoother vectors, the exchanges and the outer Krylov solver
+c     stay double (gslib has no single precision exchange).
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'HSMG'
+
+      mg_ifsp = param(187).gt.0 .and. wdsize.eq.8
+#ifdef OPENACC
+      mg_ifsp = .false.   ! device kernels take real S,D,wt
+#endif
+
       return
       end
 c----------------------------------------------------------------------
@@ -174,7 +204,9 @@ c----------------------------------------------------------------------
       subroutine h1mg_setup_wtmask
       include 'SIZE'
       include 'HSMG'
+      include 'WSPACE'
       integer i,l
+      integer*8 kw
       i = mg_mask_index(mg_lmax,mg_fld-1)
       do l=1,mg_lmax
          mg_rstr_wt_index(l,mg_fld)=i
@@ -185,12 +217,15 @@ c----------------------------------------------------------------------
             write(6,*) 'parameter lmg_rwt too small',i,itmp,lmg_rwt
             call exitt
          endif
+         call nek_ws_push
+         kw = nek_ws_r(mg_nh(l)*mg_nh(l)*mg_nhz(l)*nelv)
          call hsmg_setup_rstr_wt(
      $           mg_rstr_wt(mg_rstr_wt_index(l,mg_fld))
-     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,mg_work)
+     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,ws(kw))
          call hsmg_setup_mask(
      $           mg_mask(mg_mask_index(l,mg_fld))
-     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,mg_work)
+     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,ws(kw))
+         call nek_ws_pop
       enddo
       mg_mask_index(l,mg_fld)=i
       end
@@ -198,7 +233,9 @@ c----------------------------------------------------------------------
       subroutine hsmg_setup_wtmask
       include 'SIZE'
       include 'HSMG'
+      include 'WSPACE'
       integer i,l
+      integer*8 kw
       i = mg_mask_index(mg_lmax,mg_fld-1)
       do l=1,mg_lmax-1
          mg_rstr_wt_index(l,mg_fld)=i
@@ -209,12 +246,15 @@ c----------------------------------------------------------------------
             write(6,*) 'parameter lmg_rwt too small',i,itmp,lmg_rwt
             call exitt
          endif
+         call nek_ws_push
+         kw = nek_ws_r(mg_nh(l)*mg_nh(l)*mg_nhz(l)*nelv)
          call hsmg_setup_rstr_wt(
      $           mg_rstr_wt(mg_rstr_wt_index(l,mg_fld))
-     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,mg_work)
+     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,ws(kw))
          call hsmg_setup_mask(
      $           mg_mask(mg_mask_index(l,mg_fld))
-     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,mg_work)
+     $          ,mg_nh(l),mg_nh(l),mg_nhz(l),l,ws(kw))
+         call nek_ws_pop
       enddo
       mg_mask_index(l,mg_fld)=i
       end
@@ -261,6 +301,16 @@ c     v = [A (x) A (x) A] u
       real v(1),u(1),A(1),At(1)
       include 'SIZE'
       include 'INPUT'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
+#ifdef OPENACC
+      if (nek_acc_dev(v)) then
+         call nek_acc_tnsr(v,nv,u,nu,A,At)
+         return
+      endif
+#endif
       if (.not. if3d) then
          call hsmg_tnsr2d(v,nv,u,nu,A,At)
       else
@@ -277,6 +327,7 @@ c     v = A u B
       real v(nv*nv,nelv),u(nu*nu,nelv),A(1),Bt(1)
       include 'SIZE'
       common /hsmgw/ work((lx1+2)*(lx1+2))
+c$omp threadprivate(/hsmgw/)
       integer ie
       do ie=1,nelv
          call mxm(A,nv,u(1,ie),nu,work,nu)
@@ -292,9 +343,17 @@ c     v = [C (x) B (x) A] u
       integer nv,nu
       real v(nv*nv*nv,nelv),u(nu*nu*nu,nelv),A(1),Bt(1),Ct(1)
       include 'SIZE'
+      include 'PARALLEL'
       parameter (lwk=(lx1+2)*(ly1+2)*(lz1+2))
       common /hsmgw/ work(0:lwk-1),work2(0:lwk-1)
-      integer ie, i
+c$omp threadprivate(/hsmgw/)
+      integer ie, i, ifok
+
+      if (wdsize.eq.8) then
+         call tnsr3_batch(v,nv,u,nu,A,Bt,Ct,nelv,ifok)
+         if (ifok.ne.0) return
+      endif
+
       do ie=1,nelv
          call mxm(A,nv,u(1,ie),nu,work,nu*nu)
          do i=0,nu-1
@@ -313,6 +372,7 @@ c     v = A u B
       real v(nv*nv),u(nu*nu),A(1),Bt(1)
       include 'SIZE'
       common /hsmgw/ work((lx1+2)*(lx1+2))
+c$omp threadprivate(/hsmgw/)
 c
       call mxm(A,nv,u,nu,work,nu)
       call mxm(work,nv,Bt,nu,v,nv)
@@ -329,6 +389,7 @@ c     v = [C (x) B (x) A] u
       include 'SIZE'
       parameter (lwk=(lx1+2)*(ly1+2)*(lz1+2))
       common /hsmgw/ work(0:lwk-1),work2(0:lwk-1)
+c$omp threadprivate(/hsmgw/)
       integer i
 c
       call mxm(A,nv,u,nu,work,nu*nu)
@@ -344,12 +405,24 @@ c----------------------------------------------------------------------
       include 'SIZE'
       include 'HSMG'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
       real u(1)
 
       if (ifsync) call nekgsync()
       etime1=dnekclock()
 
+#ifdef OPENACC
+      if (nek_acc_dev(u)) then
+         call nek_acc_gs_op(mg_gsh_handle(l,mg_fld),u,1)
+      else
+         call fgslib_gs_op(mg_gsh_handle(l,mg_fld),u,1,1,0)
+      endif
+#else
       call fgslib_gs_op(mg_gsh_handle(l,mg_fld),u,1,1,0)
+#endif
       tdadd =tdadd + dnekclock()-etime1
 
 
@@ -372,11 +445,24 @@ c----------------------------------------------------------------------
       include 'SIZE'
       include 'HSMG'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
+      real u(1)
 
       if (ifsync) call nekgsync()
       etime1=dnekclock()
 
+#ifdef OPENACC
+      if (nek_acc_dev(u)) then
+         call nek_acc_gs_op(mg_gsh_schwarz_handle(l,mg_fld),u,1)
+      else
+         call fgslib_gs_op(mg_gsh_schwarz_handle(l,mg_fld),u,1,1,0)
+      endif
+#else
       call fgslib_gs_op(mg_gsh_schwarz_handle(l,mg_fld),u,1,1,0)
+#endif
       tdadd =tdadd + dnekclock()-etime1
 
       return
@@ -390,10 +476,19 @@ c----------------------------------------------------------------------
       real f1,f2
       
       integer i,j,k,ie,i0,i1
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       i0=2
       i1=nx-1
       
       if(.not.if3d) then
+#ifdef OPENACC
+         ifdev = nek_acc_dev(arr1)
+#endif
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
          do ie=1,nelv
             do j=i0,i1
                arr1(l1+1 ,j,1,ie) = f1*arr1(l1+1 ,j,1,ie)
@@ -409,6 +504,11 @@ c----------------------------------------------------------------------
             enddo
          enddo
       else
+#ifdef OPENACC
+         ifdev = nek_acc_dev(arr1)
+#endif
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
          do ie=1,nelv
             do k=i0,i1
             do j=i0,i1
@@ -459,10 +559,12 @@ c----------------------------------------------------------------------
       include 'INPUT'  ! if3d
       include 'TSTEP'  ! ifield
       include 'HSMG'
+      include 'WSPACE'
 
       real e(1),r(1)
 
       integer enx,eny,enz,pm
+      integer*8 kw,i
 
       zero =  0
       one  =  1
@@ -473,36 +575,45 @@ c----------------------------------------------------------------------
 
       call h1mg_mask  (r,mg_imask(pm),nelfld(ifield))  ! Zero Dirichlet nodes
 
-      if (if3d) then ! extended array 
-         call hsmg_schwarz_toext3d(mg_work,r,mg_nh(l))
-      else
-         call hsmg_schwarz_toext2d(mg_work,r,mg_nh(l))
-      endif
-
       enx=mg_nh(l)+2
       eny=mg_nh(l)+2
       enz=mg_nh(l)+2
       if(.not.if3d) enz=1
-      i = enx*eny*enz*nelv+1
+      ne = enx*eny*enz*nelv
+
+      call nek_ws_push         ! two extended arrays
+#ifdef OPENACC
+      kw = mg_kwork            ! kept on the device
+#else
+      kw = nek_ws_r(2*ne)
+#endif
+      i  = kw+ne
+
+      if (if3d) then ! extended array 
+         call hsmg_schwarz_toext3d(ws(kw),r,mg_nh(l))
+      else
+         call hsmg_schwarz_toext2d(ws(kw),r,mg_nh(l))
+      endif
  
 c     exchange interior nodes
-      call hsmg_extrude(mg_work,0,zero,mg_work,2,one,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work,l)
-      call hsmg_extrude(mg_work,0,one ,mg_work,2,onem,enx,eny,enz)
+      call hsmg_extrude(ws(kw),0,zero,ws(kw),2,one,enx,eny,enz)
+      call hsmg_schwarz_dssum(ws(kw),l)
+      call hsmg_extrude(ws(kw),0,one ,ws(kw),2,onem,enx,eny,enz)
 
-      call hsmg_fdm(mg_work(i),mg_work,l) ! Do the local solves
+      call hsmg_fdm(ws(i),ws(kw),l) ! Do the local solves
 
 c     Sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      call hsmg_extrude(ws(kw),0,zero,ws(i),0,one ,enx,eny,enz)
+      call hsmg_schwarz_dssum(ws(i),l)
+      call hsmg_extrude(ws(i),0,one ,ws(kw),0,onem,enx,eny,enz)
+      call hsmg_extrude(ws(i),2,one,ws(i),0,one,enx,eny,enz)
 
       if(.not.if3d) then ! Go back to regular size array
-         call hsmg_schwarz_toreg2d(e,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg2d(e,ws(i),mg_nh(l))
       else
-         call hsmg_schwarz_toreg3d(e,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg3d(e,ws(i),mg_nh(l))
       endif
+      call nek_ws_pop
 
       call hsmg_dssum(e,l)                           ! sum border nodes
       call h1mg_mask (e,mg_imask(pm),nelfld(ifield)) ! apply mask 
@@ -514,12 +625,21 @@ c----------------------------------------------------------------------
       include 'SIZE'
       include 'INPUT'
       include 'HSMG'
+      include 'WSPACE'
       real e(1),r(1)
       integer l
       integer enx,eny,enz
-      integer i
+      integer*8 kw,i
+
+      integer itmr
+      save    itmr
+      data    itmr /0/
 
       real zero,one,onem
+
+      if (itmr.eq.0) call nek_timer_id('hsmg_schwarz',itmr)
+      call nek_timer_push(itmr)
+
       zero =  0
       one  =  1
       onem = -1
@@ -529,43 +649,54 @@ c     apply mask (zeros Dirichlet nodes)
       call hsmg_do_wt(r,mg_mask(mg_mask_index(l,mg_fld)),
      $                mg_nh(l),mg_nh(l),mg_nhz(l))
       
-c     go to extended size array (room for overlap)      
-      if (if3d) then
-         call hsmg_schwarz_toext3d(mg_work,r,mg_nh(l))
-      else
-         call hsmg_schwarz_toext2d(mg_work,r,mg_nh(l))
-      endif
-      
       enx=mg_nh(l)+2
       eny=mg_nh(l)+2
       enz=mg_nh(l)+2
       if(.not.if3d) enz=1
-      i = enx*eny*enz*nelv+1
+      ne = enx*eny*enz*nelv
+
+      call nek_ws_push         ! two extended arrays
+#ifdef OPENACC
+      kw = mg_kwork            ! kept on the device
+#else
+      kw = nek_ws_r(2*ne)
+#endif
+      i  = kw+ne
+
+c     go to extended size array (room for overlap)      
+      if (if3d) then
+         call hsmg_schwarz_toext3d(ws(kw),r,mg_nh(l))
+      else
+         call hsmg_schwarz_toext2d(ws(kw),r,mg_nh(l))
+      endif
 
 c     exchange interior nodes
-      call hsmg_extrude(mg_work,0,zero,mg_work,2,one,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work,l)
-      call hsmg_extrude(mg_work,0,one ,mg_work,2,onem,enx,eny,enz)
+      call hsmg_extrude(ws(kw),0,zero,ws(kw),2,one,enx,eny,enz)
+      call hsmg_schwarz_dssum(ws(kw),l)
+      call hsmg_extrude(ws(kw),0,one ,ws(kw),2,onem,enx,eny,enz)
 
 c     do the local solves
-      call hsmg_fdm(mg_work(i),mg_work,l)
+      call hsmg_fdm(ws(i),ws(kw),l)
 c     sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      call hsmg_extrude(ws(kw),0,zero,ws(i),0,one ,enx,eny,enz)
+      call hsmg_schwarz_dssum(ws(i),l)
+      call hsmg_extrude(ws(i),0,one ,ws(kw),0,onem,enx,eny,enz)
+      call hsmg_extrude(ws(i),2,one,ws(i),0,one,enx,eny,enz)
 c     go back to regular size array
       if(.not.if3d) then
-         call hsmg_schwarz_toreg2d(e,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg2d(e,ws(i),mg_nh(l))
       else
-         call hsmg_schwarz_toreg3d(e,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg3d(e,ws(i),mg_nh(l))
       endif
+      call nek_ws_pop
 c     sum border nodes
       call hsmg_dssum(e,l)
 c     apply mask (zeros Dirichlet nodes)
       !!!!!! changing r to e
       call hsmg_do_wt(e,mg_mask(mg_mask_index(l,mg_fld)),
      $                mg_nh(l),mg_nh(l),mg_nhz(l))
+
+      call nek_timer_pop(itmr)
       return
       end
 c----------------------------------------------------------------------
@@ -575,7 +706,16 @@ c----------------------------------------------------------------------
       real a(0:n+1,0:n+1,nelv),b(n,n,nelv)
       
       integer i,j,ie
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 c      call rzero(a,(n+2)*(n+2)*nelv)
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do private(ie,i,j)
+c$acc parallel loop gang vector default(present) if(ifdev)
       do ie=1,nelv
          do i=0,n+1
             a(i,0,ie)=0.
@@ -600,7 +740,16 @@ c----------------------------------------------------------------------
       real a(0:n+1,0:n+1,0:n+1,nelv),b(n,n,n,nelv)
       
       integer i,j,k,ie
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       call rzero(a,(n+2)*(n+2)*(n+2)*nelv)
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
       do ie=1,nelv
       do k=1,n
       do j=1,n
@@ -619,6 +768,15 @@ c----------------------------------------------------------------------
       real a(0:n+1,0:n+1,nelv),b(n,n,nelv)
       
       integer i,j,ie
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(b)
+#endif
+c$omp parallel do private(ie,i,j)
+c$acc parallel loop gang vector default(present) if(ifdev)
       do ie=1,nelv
       do j=1,n
       do i=1,n
@@ -635,6 +793,15 @@ c----------------------------------------------------------------------
       real a(0:n+1,0:n+1,0:n+1,nelv),b(n,n,n,nelv)
       
       integer i,j,k,ie
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(b)
+#endif
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
       do ie=1,nelv
       do k=1,n
       do j=1,n
@@ -652,29 +819,30 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,j,nl
+      integer l,i,j,nl,ns,nd
       i = mg_fast_s_index(mg_lmax,mg_fld-1)
       j = mg_fast_d_index(mg_lmax,mg_fld-1)
       do l=2,mg_lmax
          mg_fast_s_index(l,mg_fld)=i
          nl = mg_nh(l)+2
-         i=i+nl*nl*2*ldim*nelv
+         ns = nl*nl*2*ldim*nelv
+         if (mg_ifsp) ns = (ns+1)/2  ! real*4
+         i=i+ns
          if(i .gt. lmg_fasts*2*ldim*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fasts too small',i,itmp,lmg_fasts,l
             call exitt
          endif
          mg_fast_d_index(l,mg_fld)=j
-         j=j+(nl**ldim)*nelv
+         nd = (nl**ldim)*nelv
+         if (mg_ifsp) nd = (nd+1)/2
+         j=j+nd
          if(j .gt. lmg_fastd*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fastd too small',i,itmp,lmg_fastd,l
             call exitt
          endif
-         call hsmg_setup_fast(
-     $             mg_fast_s(mg_fast_s_index(l,mg_fld))
-     $            ,mg_fast_d(mg_fast_d_index(l,mg_fld))
-     $            ,mg_nh(l)+2,mg_ah(1,l),mg_bh(1,l),mg_nx(l))
+         call hsmg_setup_fast_l(l)
       enddo
       mg_fast_s_index(l,mg_fld)=i
       mg_fast_d_index(l,mg_fld)=j
@@ -686,32 +854,66 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,j,nl
+      integer l,i,j,nl,ns,nd
       i = mg_fast_s_index(mg_lmax,mg_fld-1)
       j = mg_fast_d_index(mg_lmax,mg_fld-1)
       do l=2,mg_lmax-1
          mg_fast_s_index(l,mg_fld)=i
          nl = mg_nh(l)+2
-         i=i+nl*nl*2*ldim*nelv
+         ns = nl*nl*2*ldim*nelv
+         if (mg_ifsp) ns = (ns+1)/2  ! real*4
+         i=i+ns
          if(i .gt. lmg_fasts*2*ldim*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fasts too small',i,itmp,lmg_fasts,l
             call exitt
          endif
          mg_fast_d_index(l,mg_fld)=j
-         j=j+(nl**ldim)*nelv
+         nd = (nl**ldim)*nelv
+         if (mg_ifsp) nd = (nd+1)/2
+         j=j+nd
          if(j .gt. lmg_fastd*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fastd too small',i,itmp,lmg_fastd,l
             call exitt
          endif
-         call hsmg_setup_fast(
-     $             mg_fast_s(mg_fast_s_index(l,mg_fld))
-     $            ,mg_fast_d(mg_fast_d_index(l,mg_fld))
-     $            ,mg_nh(l)+2,mg_ah(1,l),mg_bh(1,l),mg_nx(l))
+         call hsmg_setup_fast_l(l)
       enddo
       mg_fast_s_index(l,mg_fld)=i
       mg_fast_d_index(l,mg_fld)=j
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_setup_fast_l(l)
+c
+c     FDM of level l into mg_fast_s/d, rounded to real*4 with mg_ifsp
+c
+      include 'SIZE'
+      include 'HSMG'
+      include 'WSPACE'
+
+      integer l,nl,ns,nd
+      integer*8 ks,kd
+
+      nl = mg_nh(l)+2
+      if (mg_ifsp) then
+         ns = nl*nl*2*ldim*nelv
+         nd = (nl**ldim)*nelv
+         call nek_ws_push
+         ks = nek_ws_r(ns)
+         kd = nek_ws_r(nd)
+         call hsmg_setup_fast(ws(ks),ws(kd)
+     $            ,nl,mg_ah(1,l),mg_bh(1,l),mg_nx(l))
+         call copyX4(mg_fast_s4(2*mg_fast_s_index(l,mg_fld)),ws(ks),ns)
+         call copyX4(mg_fast_d4(2*mg_fast_d_index(l,mg_fld)),ws(kd),nd)
+         call nek_ws_pop
+      else
+         call hsmg_setup_fast(
+     $             mg_fast_s(mg_fast_s_index(l,mg_fld))
+     $            ,mg_fast_d(mg_fast_d_index(l,mg_fld))
+     $            ,nl,mg_ah(1,l),mg_bh(1,l),mg_nx(l))
+      endif
+
       return
       end
 c----------------------------------------------------------------------
@@ -903,10 +1105,28 @@ c     clobbers r
       include 'SIZE'
       include 'INPUT'
       include 'HSMG'
-      call hsmg_do_fast(e,r,
+      real e(1),r(1)
+
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('hsmg_fdm',itmr)
+      call nek_timer_push(itmr)
+
+      if (mg_ifsp) then
+         call hsmg_do_fast4(e,r,
+     $      mg_fast_s4(2*mg_fast_s_index(l,mg_fld)),
+     $      mg_fast_d4(2*mg_fast_d_index(l,mg_fld)),
+     $      mg_nh(l)+2)
+      else
+         call hsmg_do_fast(e,r,
      $      mg_fast_s(mg_fast_s_index(l,mg_fld)),
      $      mg_fast_d(mg_fast_d_index(l,mg_fld)),
      $      mg_nh(l)+2)
+      endif
+
+      call nek_timer_pop(itmr)
       return
       end
 c----------------------------------------------------------------------
@@ -914,14 +1134,32 @@ c     clobbers r
       subroutine hsmg_do_fast(e,r,s,d,nl)
       include 'SIZE'
       include 'INPUT'
+      include 'PARALLEL'
       real e(nl**ldim,nelv)
       real r(nl**ldim,nelv)
       real s(nl*nl,2,ldim,nelv)
       real d(nl**ldim,nelv)
       
-      integer ie,nn,i
+      integer ie,nn,i,ifok
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
       nn=nl**ldim
+
+#ifdef OPENACC
+      if (nek_acc_dev(e)) then
+         call nek_acc_fdm(e,r,s,d,nl)
+         return
+      endif
+#endif
+      if (if3d .and. wdsize.eq.8) then
+         call fdm3_batch(e,r,s,d,nl,nelv,ifok)
+         if (ifok.ne.0) return
+      endif
+
       if(.not.if3d) then
+c$omp parallel do private(ie,i)
          do ie=1,nelv
             call hsmg_tnsr2d_el(e(1,ie),nl,r(1,ie),nl
      $                         ,s(1,2,1,ie),s(1,1,2,ie))
@@ -932,6 +1170,7 @@ c     clobbers r
      $                         ,s(1,1,1,ie),s(1,2,2,ie))
          enddo
       else
+c$omp parallel do private(ie,i)
          do ie=1,nelv
             call hsmg_tnsr3d_el(e(1,ie),nl,r(1,ie),nl
      $                         ,s(1,2,1,ie),s(1,1,2,ie),s(1,1,3,ie))
@@ -945,6 +1184,53 @@ c     clobbers r
       return
       end
 c----------------------------------------------------------------------
+c     clobbers r, hsmg_do_fast with real*4 s,d (mg_ifsp)
+      subroutine hsmg_do_fast4(e,r,s,d,nl)
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+      real e(nl**ldim,nelv)
+      real r(nl**ldim,nelv)
+      real*4 s(nl*nl*2*ldim,nelv)
+      real*4 d(nl**ldim,nelv)
+
+      real sl(lmg_fasts*ldim)
+      integer ie,nn
+
+      nn=nl**ldim
+c$omp parallel do private(ie,sl)
+      do ie=1,nelv
+         call copy4r(sl,s(1,ie),nl*nl*2*ldim)
+         call hsmg_do_fast4_el(e(1,ie),r(1,ie),sl,d(1,ie),nl,nn)
+      enddo
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_do_fast4_el(e,r,s,d,nl,nn)
+      include 'SIZE'
+      include 'INPUT'
+      real e(nn),r(nn)
+      real s(nl*nl,2,ldim)
+      real*4 d(nn)
+
+      integer i
+
+      if(.not.if3d) then
+         call hsmg_tnsr2d_el(e,nl,r,nl,s(1,2,1),s(1,1,2))
+         do i=1,nn
+            r(i)=d(i)*e(i)
+         enddo
+         call hsmg_tnsr2d_el(e,nl,r,nl,s(1,1,1),s(1,2,2))
+      else
+         call hsmg_tnsr3d_el(e,nl,r,nl,s(1,2,1),s(1,1,2),s(1,1,3))
+         do i=1,nn
+            r(i)=d(i)*e(i)
+         enddo
+         call hsmg_tnsr3d_el(e,nl,r,nl,s(1,1,1),s(1,2,2),s(1,2,3))
+      endif
+      return
+      end
+c----------------------------------------------------------------------
 c     u = wt .* u
       subroutine hsmg_do_wt(u,wt,nx,ny,nz)
       include 'SIZE'
@@ -954,6 +1240,10 @@ c     u = wt .* u
       real wt(nx,nz,2,ldim,nelv)
       
       integer e
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 c     if (nx.eq.2) then
 c        do e=1,nelv
@@ -965,7 +1255,12 @@ c        enddo
 c        call exitti('hsmg_do_wt quit$',nelv)
 c     endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(u)
+#endif
       if (.not. if3d) then
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
          do ie=1,nelv
             do j=1,ny
                u( 1,j,1,ie)=u( 1,j,1,ie)*wt(j,1,1,1,ie)
@@ -977,6 +1272,8 @@ c     endif
             enddo
          enddo
       else
+c$omp parallel do private(ie,i,j,k)
+c$acc parallel loop gang vector default(present) if(ifdev)
          do ie=1,nelv
             do k=1,nz
             do j=1,ny
@@ -1207,7 +1504,7 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,nl,nlz
+      integer l,i,nl,nlz,nw
 
       i = mg_schwarz_wt_index(mg_lmax,mg_fld-1)
       do l=2,mg_lmax-1
@@ -1215,15 +1512,16 @@ c----------------------------------------------------------------------
          nl = mg_nh(l)
          nlz = mg_nh(l)
          if(.not.if3d) nlz=1
-         i=i+nl*nlz*4*ldim*nelv
+         nw = nl*nlz*4*ldim*nelv
+         if (mg_ifsp) nw = (nw+1)/2  ! real*4
+         i=i+nw
          if(i .gt. lmg_swt*4*ldim*lelv) then
             itmp = i/(4*ldim*lelv)
             write(6,*) 'lmg_swt too small',i,itmp,lmg_swt,l
             call exitt
          endif
 
-         call h1mg_setup_schwarz_wt_1(
-     $      mg_schwarz_wt(mg_schwarz_wt_index(l,mg_fld)),l,ifsqrt)
+         call hsmg_setup_schwarz_wt_l(l,nl*nlz*4*ldim,ifsqrt)
 
       enddo
       mg_schwarz_wt_index(l,mg_fld)=i
@@ -1237,7 +1535,7 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,nl,nlz
+      integer l,i,nl,nlz,nw
 
       i = mg_schwarz_wt_index(mg_lmax,mg_fld-1)
       do l=2,mg_lmax
@@ -1245,7 +1543,9 @@ c----------------------------------------------------------------------
          mg_schwarz_wt_index(l,mg_fld)=i
          nl  = mg_nh(l)
          nlz = mg_nhz(l)
-         i   = i+nl*nlz*4*ldim*nelv
+         nw  = nl*nlz*4*ldim*nelv
+         if (mg_ifsp) nw = (nw+1)/2  ! real*4
+         i   = i+nw
 
          if (i .gt. lmg_swt*4*ldim*lelv) then
             itmp = i/(4*ldim*lelv)
@@ -1253,13 +1553,39 @@ c----------------------------------------------------------------------
             call exitt
          endif
 
-         call h1mg_setup_schwarz_wt_1(
-     $      mg_schwarz_wt(mg_schwarz_wt_index(l,mg_fld)),l,ifsqrt)
+         call hsmg_setup_schwarz_wt_l(l,nl*nlz*4*ldim,ifsqrt)
 
       enddo
 
       mg_schwarz_wt_index(l,mg_fld)=i
 
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_setup_schwarz_wt_l(l,nwe,ifsqrt)
+c
+c     Schwarz weights (nwe per element) of level l, real*4 with mg_ifsp
+c
+      logical ifsqrt
+      include 'SIZE'
+      include 'HSMG'
+      include 'WSPACE'
+
+      integer l,nwe
+      integer*8 kw
+
+      if (mg_ifsp) then
+         call nek_ws_push
+         kw = nek_ws_r(nwe*nelt) ! h1mg fills nelfld(ifield) elements
+         call h1mg_setup_schwarz_wt_1(ws(kw),l,ifsqrt)
+         call copyX4(mg_schwarz_wt4(2*mg_schwarz_wt_index(l,mg_fld))
+     $              ,ws(kw),nwe*nelv)
+         call nek_ws_pop
+      else
+         call h1mg_setup_schwarz_wt_1(
+     $      mg_schwarz_wt(mg_schwarz_wt_index(l,mg_fld)),l,ifsqrt)
+      endif
+
       return
       end
 c----------------------------------------------------------------------
@@ -1267,11 +1593,19 @@ c----------------------------------------------------------------------
       include 'SIZE'
       include 'INPUT'
       include 'HSMG'
+      real e(1)
       
-      if(.not.if3d) call hsmg_schwarz_wt2d(
-     $    e,mg_schwarz_wt(mg_schwarz_wt_index(l,mg_fld)),mg_nh(l))
-      if(if3d) call hsmg_schwarz_wt3d(
-     $    e,mg_schwarz_wt(mg_schwarz_wt_index(l,mg_fld)),mg_nh(l))
+      k = mg_schwarz_wt_index(l,mg_fld)
+      if (mg_ifsp) then
+         if(.not.if3d) call hsmg_schwarz_wt2d4(
+     $       e,mg_schwarz_wt4(2*k),mg_nh(l))
+         if(if3d) call hsmg_schwarz_wt3d4(
+     $       e,mg_schwarz_wt4(2*k),mg_nh(l))
+         return
+      endif
+
+      if(.not.if3d) call hsmg_schwarz_wt2d(e,mg_schwarz_wt(k),mg_nh(l))
+      if(if3d) call hsmg_schwarz_wt3d(e,mg_schwarz_wt(k),mg_nh(l))
       return
       end
 c----------------------------------------------------------------------
@@ -1282,6 +1616,14 @@ c----------------------------------------------------------------------
       real wt(n,4,2,nelv)
       
       integer ie,i,j
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(e)
+#endif
+c$acc parallel loop gang vector default(present) if(ifdev)
       do ie=1,nelv
          do j=1,n
             e(1  ,j,ie)=e(1  ,j,ie)*wt(j,1,1,ie)
@@ -1306,6 +1648,77 @@ c----------------------------------------------------------------------
       real wt(n,n,4,3,nelv)
       
       integer ie,i,j,k
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(e)
+#endif
+c$acc parallel loop gang vector default(present) if(ifdev)
+      do ie=1,nelv
+         do k=1,n
+         do j=1,n
+            e(1  ,j,k,ie)=e(1  ,j,k,ie)*wt(j,k,1,1,ie)
+            e(2  ,j,k,ie)=e(2  ,j,k,ie)*wt(j,k,2,1,ie)
+            e(n-1,j,k,ie)=e(n-1,j,k,ie)*wt(j,k,3,1,ie)
+            e(n  ,j,k,ie)=e(n  ,j,k,ie)*wt(j,k,4,1,ie)
+         enddo
+         enddo
+         do k=1,n
+         do i=3,n-2
+            e(i,1  ,k,ie)=e(i,1  ,k,ie)*wt(i,k,1,2,ie)
+            e(i,2  ,k,ie)=e(i,2  ,k,ie)*wt(i,k,2,2,ie)
+            e(i,n-1,k,ie)=e(i,n-1,k,ie)*wt(i,k,3,2,ie)
+            e(i,n  ,k,ie)=e(i,n  ,k,ie)*wt(i,k,4,2,ie)
+         enddo
+         enddo
+         do j=3,n-2
+         do i=3,n-2
+            e(i,j,1  ,ie)=e(i,j,1  ,ie)*wt(i,j,1,3,ie)
+            e(i,j,2  ,ie)=e(i,j,2  ,ie)*wt(i,j,2,3,ie)
+            e(i,j,n-1,ie)=e(i,j,n-1,ie)*wt(i,j,3,3,ie)
+            e(i,j,n  ,ie)=e(i,j,n  ,ie)*wt(i,j,4,3,ie)
+         enddo
+         enddo
+      enddo
+      return
+      end
+c----------------------------------------------------------------------
+c     hsmg_schwarz_wt2d/3d with real*4 wt (mg_ifsp)
+      subroutine hsmg_schwarz_wt2d4(e,wt,n)
+      include 'SIZE'
+      integer n
+      real e(n,n,nelv)
+      real*4 wt(n,4,2,nelv)
+      
+      integer ie,i,j
+c$omp parallel do private(ie,i,j)
+      do ie=1,nelv
+         do j=1,n
+            e(1  ,j,ie)=e(1  ,j,ie)*wt(j,1,1,ie)
+            e(2  ,j,ie)=e(2  ,j,ie)*wt(j,2,1,ie)
+            e(n-1,j,ie)=e(n-1,j,ie)*wt(j,3,1,ie)
+            e(n  ,j,ie)=e(n  ,j,ie)*wt(j,4,1,ie)
+         enddo
+         do i=3,n-2
+            e(i,1  ,ie)=e(i,1  ,ie)*wt(i,1,2,ie)
+            e(i,2  ,ie)=e(i,2  ,ie)*wt(i,2,2,ie)
+            e(i,n-1,ie)=e(i,n-1,ie)*wt(i,3,2,ie)
+            e(i,n  ,ie)=e(i,n  ,ie)*wt(i,4,2,ie)
+         enddo
+      enddo
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_schwarz_wt3d4(e,wt,n)
+      include 'SIZE'
+      integer n
+      real e(n,n,n,nelv)
+      real*4 wt(n,n,4,3,nelv)
+      
+      integer ie,i,j,k
+c$omp parallel do private(ie,i,j,k)
       do ie=1,nelv
          do k=1,n
          do j=1,n
@@ -1364,7 +1777,9 @@ c
       etime1=dnekclock()
 
 
-      call fgslib_crs_solve(xxth(ifield),e,r)
+      call nek_comm_push('crs')
+      call nek_crs_solve(xxth(ifield),e,r)
+      call nek_comm_pop()
 
       tcrsl=tcrsl+dnekclock()-etime1
 
@@ -1403,6 +1818,7 @@ c----------------------------------------------------------------------
       include 'TSTEP'
       include 'CTIMER'
       include 'PARALLEL'
+      include 'WSPACE'
       
       common /quick/ ecrs  (2)  ! quick work array
      $             , ecrs2 (2)  ! quick work array
@@ -1422,7 +1838,7 @@ c    $             , ecrs2 (lx2*ly2*lz2*lelv)  ! quick work array
       data    rhoavg,copt1,copt2 /3*1./  ! Default copt = 1 for additive
 
       integer l,nt
-      integer*8 ntotg,nxyz2
+      integer*8 ntotg,nxyz2,kw
 
       logical if_hybrid
 
@@ -1464,6 +1880,8 @@ c     if (nid.eq.0) write(6,*) istep,n,rmax,' rmax1'
 
       l = mg_lmax
       nt = mg_nh(l)*mg_nh(l)*mg_nhz(l)*nelv
+      call nek_ws_push
+      kw = nek_ws_r(nt) ! w, at most the fine level
       ! e := W M        r
       !         Schwarz
       time_0 = dnekclock()
@@ -1477,12 +1895,12 @@ c     if (param(41).eq.1) if_hybrid = .true.
       if (if_hybrid) then
          ! w := E e
          rbd1dt = rhoavg*bd(1)/dt ! Assumes constant density!!!
-         call cdabdtp(mg_work2,e,h1,h2,h2inv,1)
-         call cmult  (mg_work2,rbd1dt,nt)
+         call cdabdtp(ws(kw),e,h1,h2,h2inv,1)
+         call cmult  (ws(kw),rbd1dt,nt)
          time_2 = dnekclock()
          if (istep.eq.1) then
-            copt(1)  = vlsc2(r       ,mg_work2,nt)
-            copt(2)  = vlsc2(mg_work2,mg_work2,nt)
+            copt(1)  = vlsc2(r       ,ws(kw),nt)
+            copt(2)  = vlsc2(ws(kw),ws(kw),nt)
             call gop(copt,copw,'+  ', 2)
             copt(1)  = copt(1)/copt(2)
             avg2     = 1./iter
@@ -1493,37 +1911,37 @@ c     if (param(41).eq.1) if_hybrid = .true.
          endif
          ! w := r - w
          do i = 1,nt
-            mg_work2(i) = r(i) - copt1*mg_work2(i)
+            ws(kw+i-1) = r(i) - copt1*ws(kw+i-1)
             e       (i) = copt1*e(i)
-            ecrs2   (i) = mg_work2(i)
+            ecrs2   (i) = ws(kw+i-1)
          enddo
 
       else   ! Additive
          ! w := r - w
          do i = 1,nt
-            mg_work2(i) = r(i)
+            ws(kw+i-1) = r(i)
          enddo
          time_2 = dnekclock()
       endif
  
       do l = mg_lmax-1,2,-1
 
-c        rmax = glmax(mg_work2,nt)
+c        rmax = glmax(ws(kw),nt)
 c        if (nid.eq.0) write(6,*) l,nt,rmax,' rmax2'
 
          nt = mg_nh(l)*mg_nh(l)*mg_nhz(l)*nelv
          !          T
          ! r   :=  J w
          !  l         
-         call hsmg_rstr(mg_solve_r(mg_solve_index(l,mg_fld)),mg_work2,l)
+         call hsmg_rstr(mg_solve_r(mg_solve_index(l,mg_fld)),ws(kw),l)
 
          ! w  := r
          !        l
-         call copy(mg_work2,mg_solve_r(mg_solve_index(l,mg_fld)),nt)
+         call copy(ws(kw),mg_solve_r(mg_solve_index(l,mg_fld)),nt)
          ! e  := M        w
          !  l     Schwarz  
          call hsmg_schwarz(
-     $          mg_solve_e(mg_solve_index(l,mg_fld)),mg_work2,l)
+     $          mg_solve_e(mg_solve_index(l,mg_fld)),ws(kw),l)
 
          ! e  := W e
          !  l       l
@@ -1534,13 +1952,13 @@ c        call exitti('quit in mg$',l)
          ! w  := r  - w
          !        l
          do i = 0,nt-1
-            mg_work2(i+1) = mg_solve_r(mg_solve_index(l,mg_fld)+i)
-     $         !-alpha*mg_work2(i+1)
+            ws(kw+i) = mg_solve_r(mg_solve_index(l,mg_fld)+i)
+     $         !-alpha*ws(kw+i)
          enddo
       enddo
 
       call hsmg_rstr_no_dssum(
-     $   mg_solve_r(mg_solve_index(1,mg_fld)),mg_work2,1)
+     $   mg_solve_r(mg_solve_index(1,mg_fld)),ws(kw),1)
 
       nzw = ldim-1
 
@@ -1561,13 +1979,13 @@ c        call exitti('quit in mg$',l)
          ! w   :=  J e
          !            l-1
          call hsmg_intp
-     $      (mg_work2,mg_solve_e(mg_solve_index(l-1,mg_fld)),l-1)
+     $      (ws(kw),mg_solve_e(mg_solve_index(l-1,mg_fld)),l-1)
 
          ! e   :=  e  + w
          !  l       l
          do i = 0,nt-1
             mg_solve_e(mg_solve_index(l,mg_fld)+i) =
-     $        + mg_solve_e(mg_solve_index(l,mg_fld)+i) + mg_work2(i+1)
+     $        + mg_solve_e(mg_solve_index(l,mg_fld)+i) + ws(kw+i)
          enddo
       enddo
       l = mg_lmax
@@ -1575,12 +1993,12 @@ c        call exitti('quit in mg$',l)
       ! w   :=  J e
       !            m-1
 
-      call hsmg_intp(mg_work2,
+      call hsmg_intp(ws(kw),
      $   mg_solve_e(mg_solve_index(l-1,mg_fld)),l-1)
 
       if (if_hybrid.and.istep.eq.1) then
          ! ecrs := E e_c
-         call cdabdtp(ecrs,mg_work2,h1,h2,h2inv,1)
+         call cdabdtp(ecrs,ws(kw),h1,h2,h2inv,1)
          call cmult  (ecrs,rbd1dt,nt)
          copt(1)  = vlsc2(ecrs2,ecrs,nt)
          copt(2)  = vlsc2(ecrs ,ecrs,nt)
@@ -1594,8 +2012,9 @@ c        call exitti('quit in mg$',l)
       ! e := e + w
 
       do i = 1,nt
-         e(i) = e(i) + copt2*mg_work2(i)
+         e(i) = e(i) + copt2*ws(kw+i-1)
       enddo
+      call nek_ws_pop
       time_4 = dnekclock()
 c     print *, 'Did an MG iteration'
 c
@@ -1934,7 +2353,14 @@ c     if_hybrid = .false.   ! to convergence efficiency
                                                       !  l         l+1
       p_msk = p_mg_msk(l,mg_fld)
       call h1mg_mask(r,mg_imask(p_msk),nel)           !        -1
+#ifdef OPENACC
+      nc = mg_h1_n(1,mg_fld)
+      call nek_acc_tohost(r,nc)
+#endif
       call hsmg_coarse_solve ( e(is) , r )            ! e  := A   r
+#ifdef OPENACC
+      call nek_acc_todev(e(is),nc)
+#endif
       call h1mg_mask(e(is),mg_imask(p_msk),nel)       !  1     1   1
 
 c     nx = mg_nh(1)
@@ -1948,19 +2374,16 @@ c     call exitt
          is = is - n
          n  = mg_h1_n(l,mg_fld)
          call hsmg_intp (w,e(im),l-1)                 ! w   :=  J e
-         i1=is-1                                      !            l-1
-         do i=1,n
-            e(i1+i) = e(i1+i) + w(i)                  ! e   :=  e  + w
-         enddo                                        !  l       l
-      enddo
+         call add2      (e(is),w,n)                   !            l-1
+      enddo                                           ! e   :=  e  + w
+                                                      !  l       l
 
       l  = mg_h1_lmax
       n  = mg_h1_n(l,mg_fld)
       im = is  ! solve index
       call hsmg_intp(w,e(im),l-1)                     ! w   :=  J e
-      do i = 1,n                                      !            l-1
-         z(i) = z(i) + w(i)                           ! z := z + w
-      enddo
+      call add2     (z,w,n)                           !            l-1
+                                                      ! z := z + w
 
       call dsavg(z) ! Emergency hack --- to ensure continuous z!
 
@@ -2066,7 +2489,17 @@ c-----------------------------------------------------------------------
       real    w   (1)
       integer mask(1)        ! Pointer to Dirichlet BCs
       integer e
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
       
+#ifdef OPENACC
+      if (nek_acc_dev(w)) then
+         call nek_acc_mask(w,mask,nel)
+         return
+      endif
+#endif
       do e=1,nel
          im = mask(e)
          call mg_mask_e(w,mask(im)) ! Zero out Dirichlet conditions
@@ -2159,6 +2592,16 @@ c
       real v(1),A(1),At(1)
       include 'SIZE'
       include 'INPUT'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical nek_acc_dev
+#endif
+#ifdef OPENACC
+      if (nek_acc_dev(v)) then
+         call nek_acc_tnsr1(v,nv,nu,A,At)
+         return
+      endif
+#endif
       if (.not. if3d) then
          call hsmg_tnsr1_2d(v,nv,nu,A,At)
       else
@@ -2172,6 +2615,7 @@ c-------------------------------------------------------T--------------
       real v(1),A(1),Bt(1)
       include 'SIZE'
       common /hsmgw/ work(lx1*lx1)
+c$omp threadprivate(/hsmgw/)
       integer e
 
       nv2 = nv*nv
@@ -2204,6 +2648,7 @@ c----------------------------------------------------------------------
       include 'SIZE'
       parameter (lwk=(lx1+2)*(ly1+2)*(lz1+2))
       common /hsmgw/ work(0:lwk-1),work2(0:lwk-1)
+c$omp threadprivate(/hsmgw/)
       integer e,e0,ee,es
 
       e0=1
@@ -2270,6 +2715,7 @@ c----------------------------------------------------------------------
       call rzero(h2   ,n)
       call rzero(h2inv,n)
 
+      call hsmg_setup_sp
       call h1mg_setup_mg_nx
       call h1mg_setup_semhat ! SEM hat matrices for each level
       call hsmg_setup_intp   ! Interpolation operators
@@ -2415,7 +2861,9 @@ c----------------------------------------------------------------------
       include 'SIZE'
       include 'HSMG'
       include 'TSTEP'
+      include 'WSPACE'
       integer p_msk
+      integer*8 kw
 
       l                  = mg_h1_lmax
       p_mg_msk(l,mg_fld) = 0
@@ -2429,8 +2877,11 @@ c----------------------------------------------------------------------
 
          p_msk = p_mg_msk(l,mg_fld)
 
+         call nek_ws_push
+         kw = nek_ws_r(nx*ny*nz*nelfld(ifield))
          call h1mg_setup_mask
-     $     (mg_imask(p_msk),nm,nx,ny,nz,nelfld(ifield),l,mg_work)
+     $     (mg_imask(p_msk),nm,nx,ny,nz,nelfld(ifield),l,ws(kw))
+         call nek_ws_pop
 
          if (l.gt.1) p_mg_msk(l-1,mg_fld)=p_mg_msk(l,mg_fld)+nm
 
@@ -2878,15 +3329,27 @@ c-----------------------------------------------------------------------
       subroutine gxfer_e (g,ng,e) 
       include 'SIZE'
       include 'TOTAL'
+      include 'WSPACE'
 
       real g(ng,1)
       integer e
+      integer*8 kg
 
       nxyz = lx1*ly1*lz1
 
 c     ifdfrm(e) = .true.  ! TOO LATE
 
-      if (if3d) then
+      if (lgelt.lt.lelt) then ! factors not stored, 3D only
+         call nek_ws_push
+         kg = nek_ws_r(6*nxyz)
+         call geofac1(ws(kg),e)
+         do i=1,nxyz
+         do k=1,6
+            g(k,i) = ws(kg+(i-1)+(k-1)*nxyz)
+         enddo
+         enddo
+         call nek_ws_pop
+      elseif (if3d) then
          do i=1,nxyz
             g(1,i) = g1m1(i,1,1,e)
             g(2,i) = g2m1(i,1,1,e)
@@ -3066,11 +3529,13 @@ c----------------------------------------------------------------------
       include 'INPUT'  ! if3d
       include 'TSTEP'  ! ifield
       include 'HSMG'
+      include 'WSPACE'
 
       real wt(1),work(1)
       logical ifsqrt
 
       integer enx,eny,enz,pm
+      integer*8 kw,i,k
 
       zero =  0
       one  =  1
@@ -3084,23 +3549,27 @@ c----------------------------------------------------------------------
       enz=mg_nh(l)+2
       if(.not.if3d) enz=1
       ns = enx*eny*enz*nelfld(ifield)
-      i  = ns+1
 
-      call rone(mg_work(i),ns)
+      call nek_ws_push
+      kw = nek_ws_r(2*ns)
+      i  = kw+ns
+
+      call rzero(ws(kw),ns)
+      call rone (ws(i),ns)
  
 c     Sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      call hsmg_extrude(ws(kw),0,zero,ws(i),0,one ,enx,eny,enz)
+      call hsmg_schwarz_dssum(ws(i),l)
+      call hsmg_extrude(ws(i),0,one ,ws(kw),0,onem,enx,eny,enz)
+      call hsmg_extrude(ws(i),2,one,ws(i),0,one,enx,eny,enz)
 
       if(.not.if3d) then ! Go back to regular size array
-         call hsmg_schwarz_toreg2d(mg_work,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg2d(ws(kw),ws(i),mg_nh(l))
       else
-         call hsmg_schwarz_toreg3d(mg_work,mg_work(i),mg_nh(l))
+         call hsmg_schwarz_toreg3d(ws(kw),ws(i),mg_nh(l))
       endif
 
-      call hsmg_dssum(mg_work,l)                           ! sum border nodes
+      call hsmg_dssum(ws(kw),l)                      ! sum border nodes
 
 
       nx = mg_nh(l)
@@ -3108,12 +3577,13 @@ c     Sum overlap region (border excluded)
       nz = mg_nh(l)
       if (.not.if3d) nz=1
       nxyz = nx*ny*nz
-      k    = 1
+      k    = kw
       do ie=1,nelfld(ifield)
-c        call outmat(mg_work(k),nx,ny,'NEW WT',ie)
-         call h1mg_setup_schwarz_wt_2(wt,ie,nx,mg_work(k),ifsqrt)
+c        call outmat(ws(k),nx,ny,'NEW WT',ie)
+         call h1mg_setup_schwarz_wt_2(wt,ie,nx,ws(k),ifsqrt)
          k = k+nxyz
       enddo
+      call nek_ws_pop
 c     stop
 
       return
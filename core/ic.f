@@ -1983,6 +1983,11 @@ c-----------------------------------------------------------------------
       logical iskip
       integer*8 i8tmp
 
+      if (ifmmapr) then
+         call mfi_get_mmap(u,u,u,1,wk,lwk,iskip)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
 
       nxyzr  = nxr*nyr*nzr  
@@ -2019,6 +2024,8 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
       endif
 
       ierr = 0
+      if (ifzipr .and. nid.eq.pid0r)
+     $   call mfi_zopen(offzr,nelBr,nelr,nelgr,ifh_mbyte,ifmpiio,ierr)
       if (nid.eq.pid0r.and.np.gt.1) then ! only i/o nodes will read
          ! read blocks of size nelrr
          k = 0
@@ -2029,7 +2036,9 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
             endif
             
             if(ierr.eq.0) then
-              if(ifmpiio) then
+              if(ifzipr) then
+                call mfi_zread(w2,nelrr,nxyzr,ifh_mbyte,ifmpiio,ierr)
+              elseif(ifmpiio) then
                 call byte_read_mpi(w2,nxyzr*nelrr,-1,ifh_mbyte,ierr)
               else
                 call byte_read (w2,nxyzr*nelrr,ierr)
@@ -2048,7 +2057,9 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
             k  = k + nelrr
          enddo
       elseif (np.eq.1) then
-         if(ifmpiio) then
+         if(ifzipr) then
+           call mfi_zread(wk,nelr,nxyzr,ifh_mbyte,ifmpiio,ierr)
+         elseif(ifmpiio) then
            call byte_read_mpi(wk,nxyzr*nelr,-1,ifh_mbyte,ierr)
          else
            call byte_read(wk,nxyzr*nelr,ierr)
@@ -2127,6 +2138,11 @@ c-----------------------------------------------------------------------
       integer e,ei,eg,msg_id(lelt)
       integer*8 i8tmp
  
+      if (ifmmapr) then
+         call mfi_get_mmap(u,v,w,ldim,wk,lwk,iskip)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
 
       nxyzr  = ldim*nxr*nyr*nzr
@@ -2164,6 +2180,8 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
       endif
 
       ierr = 0
+      if (ifzipr .and. nid.eq.pid0r)
+     $   call mfi_zopen(offzr,nelBr,nelr,nelgr,ifh_mbyte,ifmpiio,ierr)
       if (nid.eq.pid0r .and. np.gt.1) then ! only i/o nodes
          k = 0
          do i = 1,nread
@@ -2173,7 +2191,9 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
             endif
 
             if(ierr.eq.0) then
-              if(ifmpiio) then 
+              if(ifzipr) then
+                call mfi_zread(w2,nelrr,nxyzr,ifh_mbyte,ifmpiio,ierr)
+              elseif(ifmpiio) then 
                 call byte_read_mpi(w2,nxyzr*nelrr,-1,ifh_mbyte,ierr)
               else
                 call byte_read (w2,nxyzr*nelrr,ierr)
@@ -2192,7 +2212,9 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
             k  = k + nelrr
          enddo
       elseif (np.eq.1) then
-         if(ifmpiio) then 
+         if(ifzipr) then
+           call mfi_zread(wk,nelr,nxyzr,ifh_mbyte,ifmpiio,ierr)
+         elseif(ifmpiio) then 
            call byte_read_mpi(wk,nxyzr*nelr,-1,ifh_mbyte,ierr)
          else
            call byte_read(wk,nxyzr*nelr,ierr)
@@ -2258,10 +2280,12 @@ c         if(mod(dtmp,1.0*lrbs).ne.0) nread = nread + 1
 c-----------------------------------------------------------------------
       subroutine mfi_parse_hdr(hdr,ierr)
       include 'SIZE'
+      include 'RESTART'
 
       character*132 hdr
 
-      if (indx2(hdr,132,'#std',4).eq.1) then
+      ifzipr = indx2(hdr,132,'#stz',4).eq.1   ! compressed field blocks
+      if (indx2(hdr,132,'#std',4).eq.1 .or. ifzipr) then
           call parse_std_hdr(hdr)
       else
          if (nio.eq.0) write(6,80) hdr
@@ -2443,12 +2467,20 @@ c
 
       integer*8 offs0,offs,nbyte,stride,strideB,nxyzr8
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('io_read',itmr)
+      call nek_timer_push(itmr)
+
       tiostart=dnekclock()
 
       call mfi_prepare(fname)       ! determine reader nodes +
                                     ! read hdr + element mapping 
 
       offs0   = iHeadersize + 4 + isize*nelgr
+      offzr   = offs0
       nxyzr8  = nxr*nyr*nzr
       strideB = nelBr* nxyzr8*wdsizr
       stride  = nelgr* nxyzr8*wdsizr
@@ -2456,7 +2488,7 @@ c
       iofldsr = 0
       if (ifgetxr) then      ! if available
          offs = offs0 + ldim*strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_set_view(offs,offs0)
          if (ifgetx) then
 c            if(nid.eq.0) write(6,*) 'Reading mesh'
             call mfi_getv(xm1,ym1,zm1,wk,lwk,.false.)
@@ -2468,7 +2500,7 @@ c            if(nid.eq.0) write(6,*) 'Reading mesh'
 
       if (ifgetur) then
          offs = offs0 + iofldsr*stride + ldim*strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_set_view(offs,offs0 + iofldsr*stride)
          if (ifgetu) then
             if (ifmhd.and.ifile.eq.2) then
 c               if(nid.eq.0) write(6,*) 'Reading B field'
@@ -2485,7 +2517,7 @@ c               if(nid.eq.0) write(6,*) 'Reading velocity field'
 
       if (ifgetpr) then
          offs = offs0 + iofldsr*stride + strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_set_view(offs,offs0 + iofldsr*stride)
          if (ifgetp) then
 c           if(nid.eq.0) write(6,*) 'Reading pressure field'
             call mfi_gets(pm1,wk,lwk,.false.)
@@ -2497,7 +2529,7 @@ c           if(nid.eq.0) write(6,*) 'Reading pressure field'
 
       if (ifgettr) then
          offs = offs0 + iofldsr*stride + strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_set_view(offs,offs0 + iofldsr*stride)
          if (ifgett) then
 c            if(nid.eq.0) write(6,*) 'Reading temperature field'
             call mfi_gets(t,wk,lwk,.false.)
@@ -2511,7 +2543,7 @@ c            if(nid.eq.0) write(6,*) 'Reading temperature field'
       do k=1,ldimt-1
          if (ifgtpsr(k)) then
             offs = offs0 + iofldsr*stride + strideB
-            call byte_set_view(offs,ifh_mbyte)
+            call mfi_set_view(offs,offs0 + iofldsr*stride)
             if (ifgtps(k)) then
 c               if(nid.eq.0) write(6,'(A,I2,A)') ' Reading ps',k,' field'
                call mfi_gets(t(1,1,1,1,k+1),wk,lwk,.false.)
@@ -2526,7 +2558,9 @@ c               if(nid.eq.0) write(6,'(A,I2,A)') ' Reading ps',k,' field'
 
       if (ifgtim) time = timer
 
-      if(ifmpiio) then
+      if(ifmmapr) then
+        call byte_mmap_close(ihmmap,ierr)
+      elseif(ifmpiio) then
         if(nid.eq.pid0r) call byte_close_mpi(ifh_mbyte,ierr)
       else
         if(nid.eq.pid0r) call byte_close(ierr)
@@ -2550,6 +2584,7 @@ c               if(nid.eq.0) write(6,'(A,I2,A)') ' Reading ps',k,' field'
       if (ifaxis) call axis_interp_ic(pm1)      ! Interpolate to axi mesh
       if (ifgetp) call map_pm1_to_pr(pm1,ifile) ! Interpolate pressure
 
+      call nek_timer_pop(itmr)
       return
       end
 c-----------------------------------------------------------------------
@@ -2631,6 +2666,12 @@ c-----------------------------------------------------------------------
       ifmpiio = .false.
 #endif
 
+      ifmmapr = param(171).gt.0 .and. nfiler.eq.1 .and. .not.ifzipr
+      if (ifmmapr) then
+        call mfi_prepare_mmap(hname,ierr)
+        goto 102
+      endif
+
       if(.not.ifmpiio) then
 
         stride = np / nfiler
@@ -2693,6 +2734,289 @@ c-----------------------------------------------------------------------
  102  continue
       call err_chk(ierr,'Error reading header/element map.$')
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_zopen(offb,ielb,nel,ielg,ifh,ifmpi,ierr)
+c
+c     Field blocks of compressed (#stz) files look like
+c
+c        [size(1:ielg)]  int*4 record size in bytes (file element order)
+c        [records]       byte_zpack records, 4-byte aligned
+c
+c     Read the sizes of elements ielb+1:ielb+nel and position the file
+c     at their first record. With MPI-IO (ifmpi, collective on handle
+c     ifh) offb is moved on to the next field block, otherwise the
+c     byte_open stream is read sequentially.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      integer*8 offb,ioff,i8nb,i8pre,i8tot,i8gl_running_sum,i8glsum
+      logical ifmpi
+      integer e
+
+      izpos = 0
+      nell  = nel
+      if (nel.gt.lelr) then
+         write(6,*) nid,nel,lelr,'mfi_zopen: increase lelr in RESTART'
+         ierr = 1
+         nell = 0
+      endif
+
+      if (ifmpi) then
+         ioff = offb + isize*ielb
+         call byte_set_view(ioff,ifh)
+         call byte_read_mpi(izsz,nell,-1,ifh,ier)
+      else
+         call byte_read(izsz,nell,ier)
+      endif
+      if (ier.ne.0) ierr = ier
+      if (if_byte_sw) call byte_reverse(izsz,nell,ier)
+
+      if (ifmpi) then
+         i8nb = 0
+         do e=1,nell
+            i8nb = i8nb + izsz(e)
+         enddo
+         i8pre = i8gl_running_sum(i8nb) - i8nb
+         i8tot = i8glsum(i8nb,1)
+         ioff  = offb + isize*ielg + i8pre
+         call byte_set_view(ioff,ifh)
+         offb  = offb + isize*ielg + i8tot
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_zread(out,nel,nwe,ifh,ifmpi,ierr)
+c
+c     Read and decode the next nel records of the current compressed
+c     field block (see mfi_zopen) into out, nwe words per element. The
+c     data is left in file byte order, like byte_read does.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real*4 out(nwe,1)
+      logical ifmpi
+
+      parameter (lzbr=1024*1024)          ! staging buffer (4-byte words)
+      common /cmfi_zb/ zb(lzbr)
+      real*4 zb
+
+      integer e
+
+      ncomp = nwe*4/(wdsizr*nxr*nyr*nzr)
+      iswap = 0
+      if (if_byte_sw) iswap = 1
+
+      k  = 0
+   10 continue                            ! fill staging buffer
+         n  = 0
+         nw = 0
+   20    if (k+n.lt.nel) then
+            if (nw+izsz(izpos+n+1)/4.le.lzbr) then
+               nw = nw + izsz(izpos+n+1)/4
+               n  = n + 1
+               goto 20
+            endif
+         endif
+         if (k+n.lt.nel .and. n.eq.0) then  ! record exceeds zb
+            ierr = 1
+            k    = nel
+         endif
+
+         ier = 0
+         if (ifmpi) then
+            call byte_read_mpi(zb,nw,-1,ifh,ier)
+         elseif (nw.gt.0) then
+            call byte_read(zb,nw,ier)
+         endif
+         if (ier.ne.0) ierr = ier
+
+         j = 1
+         do e=1,n
+            nb = izsz(izpos+e)
+            if (ierr.eq.0) call byte_zunpack(zb(j),nb,ncomp,nxr,nyr,
+     $                             nzr,wdsizr,iswap,out(1,k+e),ierr)
+            j = j + nb/4
+         enddo
+         izpos = izpos + n
+         k     = k + n
+
+         if (ifmpi) then                  ! collective reads, keep going
+            if (iglmax(nel-k,1).gt.0) goto 10
+         elseif (k.lt.nel) then
+            goto 10
+         endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_set_view(offs,offb)
+c
+c     Position the restart reader at the next field block:
+c     offs is this rank's part (MPI-IO), offb the start of the field
+c
+      include 'SIZE'
+      include 'RESTART'
+
+      integer*8 offs,offb
+
+      if (ifmmapr) then
+         mfi_offb = offb
+      else
+         call byte_set_view(offs,ifh_mbyte)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_prepare_mmap(hname,ierr)
+c
+c     Map a single restart file on all ranks and locate the locally
+c     owned elements in it. Only the element map is scanned here, the
+c     field data is paged in on demand by mfi_get_mmap.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+      include 'WSPACE'
+
+      character*132 hname
+      integer e,eg
+      integer*8 offs,kg,ki
+
+      pid0r = nid
+      pid1r = nid
+      fid0r = 0
+      nelr  = nelt
+
+      call addfid(hname,fid0r)
+      if(nio.eq.0) write(6,*) '      FILE:',hname,' (mmap)'
+      call byte_mmap_open(hname,ihmmap,ierr)
+      if(ierr.ne.0) return
+
+      ! local global element ids, sorted, to invert the file map
+      call nek_ws_push
+      kg = nek_ws_i(nelt)
+      ki = nek_ws_i(nelt)
+      do e=1,nelt
+         iws(kg+e-1) = lglel(e)
+      enddo
+      call isort(iws(kg),iws(ki),nelt)
+
+      call izero(ierpos,nelt)
+      offs = iHeaderSize + 4
+      k    = 0
+   10 if (k.lt.nelgr) then                ! scan map in chunks of lelr
+         n = min(lelr,nelgr-k)
+         call byte_mmap_read(ihmmap,offs+isize*k,er,n,ierr)
+         if(ierr.ne.0) goto 30
+         if(if_byte_sw) call byte_reverse(er,n,ierr)
+         do i=1,n
+            eg = er(i)
+            il = 1
+            ih = nelt
+   20       if (il.lt.ih) then            ! bisect for eg
+               im = (il+ih)/2
+               if (iws(kg+im-1).lt.eg) then
+                  il = im+1
+               else
+                  ih = im
+               endif
+               goto 20
+            endif
+            if (nelt.gt.0) then
+               if (iws(kg+il-1).eq.eg) ierpos(iws(ki+il-1)) = k+i
+            endif
+         enddo
+         k = k + n
+         goto 10
+      endif
+   30 call nek_ws_pop
+      if(ierr.ne.0) return
+
+      do e=1,nelt
+         if (ierpos(e).eq.0) ierr = 1     ! element not found in file
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_get_mmap(u,v,w,ncomp,wk,lwk,iskip)
+c
+c     Copy ncomp (1 or ldim) components of the current field for all
+c     local elements straight out of the mapped restart file
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(lx1*ly1*lz1,1),v(lx1*ly1*lz1,1),w(lx1*ly1*lz1,1)
+      real*4 wk(lwk)
+      logical iskip
+
+      integer e
+      integer*8 offs,len
+
+      ierr = 0
+      if (iskip) goto 100                 ! pages are never touched
+
+      nxyzr = nxr*nyr*nzr
+      nxyzw = nxr*nyr*nzr
+      if (wdsizr.eq.8) nxyzw = 2*nxyzw
+      len   = ncomp*nxyzr*wdsizr          ! bytes per element
+      call lim_chk(ncomp*nxyzw,lwk,'     ','     ','mfi_get_mm')
+
+      do e=1,nelt
+         offs = mfi_offb + (ierpos(e)-1)*len
+         call byte_mmap_read(ihmmap,offs,wk,ncomp*nxyzw,ierr)
+         if (ierr.ne.0) goto 100
+
+         if (if_byte_sw) then
+            if(wdsizr.eq.8) then
+               call byte_reverse8(wk,ncomp*nxyzr*2,ierr)
+            else
+               call byte_reverse(wk,ncomp*nxyzr,ierr)
+            endif
+         endif
+         if (nxr.eq.lx1.and.nyr.eq.ly1.and.nzr.eq.lz1) then
+            if (wdsizr.eq.4) then         ! COPY
+               call copy4r(u(1,e),wk(1        ),nxyzr)
+               if (ncomp.eq.1) goto 50
+               call copy4r(v(1,e),wk(1+  nxyzw),nxyzr)
+               if (ncomp.eq.3)
+     $         call copy4r(w(1,e),wk(1+2*nxyzw),nxyzr)
+            else
+               call copy  (u(1,e),wk(1        ),nxyzr)
+               if (ncomp.eq.1) goto 50
+               call copy  (v(1,e),wk(1+  nxyzw),nxyzr)
+               if (ncomp.eq.3)
+     $         call copy  (w(1,e),wk(1+2*nxyzw),nxyzr)
+            endif
+         else                             ! INTERPOLATE
+            if (wdsizr.eq.4) then
+               call mapab4r(u(1,e),wk(1        ),nxr,1)
+               if (ncomp.eq.1) goto 50
+               call mapab4r(v(1,e),wk(1+  nxyzw),nxr,1)
+               if (ncomp.eq.3)
+     $         call mapab4r(w(1,e),wk(1+2*nxyzw),nxr,1)
+            else
+               call mapab  (u(1,e),wk(1        ),nxr,1)
+               if (ncomp.eq.1) goto 50
+               call mapab  (v(1,e),wk(1+  nxyzw),nxr,1)
+               if (ncomp.eq.3)
+     $         call mapab  (w(1,e),wk(1+2*nxyzw),nxr,1)
+            endif
+         endif
+   50    continue
+      enddo
+
+ 100  call err_chk(ierr,'Error reading restart data, in get_mmap.$')
       return
       end
 c-----------------------------------------------------------------------
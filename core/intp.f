@@ -1,44 +1,79 @@
 c
 c interpolation wrapper
 c
-
-#define INTP_HMAX 10
-
+c A handle keeps a plan for its last located point set: the owner rank,
+c element and Lagrange weights of each point are stored on the owner.
+c intp_nfld skips the search as long as the points (compared exactly),
+c the mesh (geomGen) and the element distribution (dProcmapGen) do not
+c change, and evaluates intp_fbat fields per exchange. Plans are sized
+c to the point set and live in kept workspace blocks (WSPACE).
+c
 c-----------------------------------------------------------------------
       subroutine intp_setup(tolin,nmsh,ih)
 
+      include 'SIZE'
+      include 'INTP'
+
+      data ihcounter /0/
+      save ihcounter
+
+      tol = tolin
+      if (tolin.le.0) tol = 5e-13
+
+      if (nio.eq.0)
+     $   write(6,*) 'call intp_setup ','tol=', tol
+
+      ihcounter = ihcounter + 1
+      ih = ihcounter
+      if (ih .gt. intp_hmax)
+     $   call exitti('Maximum number of handles exceeded!$',intp_hmax)
+
+      intp_tol(ih) = tol
+      intp_nms(ih) = nmsh
+      intp_kx(ih)  = 0
+      intp_ke(ih)  = 0
+      intp_ko(ih)  = 0
+      intp_kw(ih)  = 0
+      call intp_fpsetup(ih)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_fpsetup(ih)
+c
+c     findpts handles of ih for the current mesh, drops the plan
+c
       include 'SIZE'
       include 'INPUT'
       include 'GEOM'
+      include 'DPROCMAP'
+      include 'INTP'
 
       common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
 
-      common /intp_h/ ih_intp(2,INTP_HMAX)
-      common /intp/   tol
-
-      data ihcounter /0/
-      save ihcounter
-
       real xmi, ymi, zmi
       common /SCRMG/ xmi(lx1*ly1*lz1*lelt),
      $               ymi(lx1*ly1*lz1*lelt),
      $               zmi(lx1*ly1*lz1*lelt)
- 
+
       real w(2*lx1**3)
 
-      tol = tolin
-      if (tolin.le.0) tol = 5e-13
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('findpts_setup',itmr)
+      call nek_timer_push(itmr)
+
       npt_max = 256
       bb_t    = 0.01
-
-      if (nio.eq.0) 
-     $   write(6,*) 'call intp_setup ','tol=', tol
+      nmsh    = intp_nms(ih)
 
       ! setup handle for interpolation
       call fgslib_findpts_setup(ih_intp1,nekcomm,npp,ldim,
      &                          xm1,ym1,zm1,nx1,ny1,nz1,
      &                          nelt,nx1,ny1,nz1,bb_t,nelt+2,nelt+2,
-     &                          npt_max,tol)
+     &                          npt_max,intp_tol(ih))
 
       ! setup handle for findpts
       if (nmsh.gt.1 .and. nmsh.lt.lx1) then
@@ -46,32 +81,32 @@ c-----------------------------------------------------------------------
          nxi = nmsh
          nyi = nxi
          nzi = nxi
-         n   = nelt*nxi*nyi*nzi 
+         n   = nelt*nxi*nyi*nzi
          do ie = 1,nelt
            call map_m_to_n(xmi((ie-1)*nxi**3 + 1),nxi,xm1(1,1,1,ie),lx1,
      $                     if3d,w,size(w))
            call map_m_to_n(ymi((ie-1)*nyi**3 + 1),nyi,ym1(1,1,1,ie),ly1,
      $                     if3d,w,size(w))
-           if (if3d) 
+           if (if3d)
      $     call map_m_to_n(zmi((ie-1)*nzi**3 + 1),nzi,zm1(1,1,1,ie),lz1,
      $                     if3d,w,size(w))
          enddo
-  
+
          call fgslib_findpts_setup(ih_intp2,nekcomm,npp,ldim,
      $                             xmi,ymi,zmi,nxi,nyi,nzi,
      $                             nelt,2*nxi,2*nyi,2*nzi,bb_t,n,n,
-     $                             npt_max,tol)
+     $                             npt_max,intp_tol(ih))
       else
          ih_intp2 = ih_intp1
       endif
 
-      ihcounter = ihcounter + 1 
-      ih = ihcounter
-      if (ih .gt. INTP_HMAX)
-     $   call exitti('Maximum number of handles exceeded!$',INTP_HMAX)
       ih_intp(1,ih) = ih_intp1
       ih_intp(2,ih) = ih_intp2
+      intp_gen(1,ih) = geomGen
+      intp_gen(2,ih) = dProcmapGen
+      call intp_pfree(ih)
 
+      call nek_timer_pop(itmr)
       return
       end
 c-----------------------------------------------------------------------
@@ -87,11 +122,18 @@ c rwk       ... real working array dim(nmax,ldim+1)
 c nmax      ... maximum number of local points
 c iflp      ... locate interpolation points (proc,el,r,s,t)
 c ih        ... handle
+c
+c With iflp the search is skipped if the points are those of the plan
+c (iwk, rwk keep the result of that search). Once the mesh moved or
+c the elements changed ranks the points are located again.
 c
       include 'SIZE'
+      include 'GEOM'
+      include 'DPROCMAP'
+      include 'INTP'
+      include 'WSPACE'
 
-      common /intp/   tol
-      common /intp_h/ ih_intp(2,INTP_HMAX)
+      integer*8 nek_ws_rkeep
 
       real    fld(*),out(*)
       real    xp(*),yp(*),zp(*)
@@ -99,27 +141,47 @@ c
       logical iflp
 
       real    rwk(nmax,*)
-      integer iwk(nmax,*) 
+      integer iwk(nmax,*)
 
       integer nn(2)
-      logical ifot
-
-      ih_intp1 = ih_intp(1,ih)
-      ih_intp2 = ih_intp(2,ih)
+      logical ifot,ifloc,ifgen
+      integer intp_xsame
 
       ifot = .false. ! transpose output field
 
-      if(nio.eq.0) write(6,*) 'call intp_nfld', ih, ih_intp1, ih_intp2
-
       if(n.gt.nmax) then
         write(6,*)
      &   'ABORT: n>nmax in intp_nfld', n, nmax
         call exitt
       endif
 
+      ! mesh moved or elements changed ranks
+      ifgen = intp_gen(1,ih).ne.geomGen .or.
+     $        intp_gen(2,ih).ne.dProcmapGen
+      if (ifgen) then
+         ifloc = intp_np(ih).ge.0
+         call intp_fpfree(ih)
+         call intp_fpsetup(ih)
+         if (ifloc) intp_np(ih) = 0
+      endif
+
+      ! same points as the plan on all ranks?
+      isame = 0
+      if (intp_np(ih).eq.n .and. intp_kx(ih).ne.0)
+     $   isame = intp_xsame(ws(intp_kx(ih)),xp,yp,zp,n)
+      isame = iglmin(isame,1)
+
+      ifloc = iflp .and. (isame.eq.0 .or. intp_nr(ih).lt.0)
+      if (ifgen .and. intp_np(ih).ge.0) ifloc = .true.
+
+      ih_intp1 = ih_intp(1,ih)
+      ih_intp2 = ih_intp(2,ih)
+
+      if(nio.eq.0) write(6,*) 'call intp_nfld', ih, ih_intp1, ih_intp2
+
       ! locate points (iel,iproc,r,s,t)
       nfail = 0
-      if(iflp) then
+      if(ifloc) then
         if(nio.eq.0 .and. loglevel.gt.2) write(6,*) 'call findpts'
         call fgslib_findpts(ih_intp2,
      &                      iwk(1,1),1,
@@ -133,7 +195,7 @@ c
         do in=1,n
            ! check return code
            if(iwk(in,1).eq.1) then
-             if(rwk(in,1).gt.10*tol) then
+             if(rwk(in,1).gt.10*intp_tol(ih)) then
                nfail = nfail + 1
                if (nfail.le.5) write(6,'(a,1p4e15.7)')
      &     ' WARNING: point on boundary or outside the mesh xy[z]d^2: ',
@@ -146,25 +208,38 @@ c
      &        xp(in),yp(in),zp(in)
            endif
         enddo
+        call intp_pfree(ih)
+        intp_np(ih) = n
+        intp_nf(ih) = nfail
+        intp_kx(ih) = nek_ws_rkeep(ldim*n)
+        call intp_xkeep(ws(intp_kx(ih)),xp,yp,zp,n)
+        call intp_plan(ih,iwk,rwk,nmax,n)
+        isame = 1
+      elseif (isame.eq.1) then
+        nfail = intp_nf(ih)
       endif
 
       ! evaluate inut field at given points
-      ltot = lelt*lx1*ly1*lz1
-      do ifld = 1,nfld
-         iin    = (ifld-1)*ltot + 1
-         iout   = (ifld-1)*n + 1
-         is_out = 1
-         if(ifot) then ! transpose output
-           iout   = ifld
-           is_out = nfld
-         endif
-         call fgslib_findpts_eval(ih_intp1,out(iout),is_out,
-     &                            iwk(1,1),1,
-     &                            iwk(1,3),1,
-     &                            iwk(1,2),1,
-     &                            rwk(1,2),ldim,n,
-     &                            fld(iin))
-      enddo
+      if (isame.eq.1 .and. intp_nr(ih).ge.0) then
+         call intp_peval(out,fld,nfld,n,ih)
+      else
+         ltot = lelt*lx1*ly1*lz1
+         do ifld = 1,nfld
+            iin    = (ifld-1)*ltot + 1
+            iout   = (ifld-1)*n + 1
+            is_out = 1
+            if(ifot) then ! transpose output
+              iout   = ifld
+              is_out = nfld
+            endif
+            call fgslib_findpts_eval(ih_intp1,out(iout),is_out,
+     &                               iwk(1,1),1,
+     &                               iwk(1,3),1,
+     &                               iwk(1,2),1,
+     &                               rwk(1,2),ldim,n,
+     &                               fld(iin))
+         enddo
+      endif
 
       nn(1) = iglsum(n,1)
       nn(2) = iglsum(nfail,1)
@@ -177,15 +252,274 @@ c
       return
       end
 c-----------------------------------------------------------------------
-      subroutine intp_free(ih)
+      subroutine intp_plan(ih,iwk,rwk,nmax,n)
+c
+c     Send the located points to their owners and keep element, origin
+c     and Lagrange weights there
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'INTP'
+      include 'WSPACE'
+
+      real    rwk(nmax,*)
+      integer iwk(nmax,*)
 
-      common /intp_h/ ih_intp(2,INTP_HMAX)
+      integer*8 nek_ws_rkeep,nek_ws_ikeep,kc,kt,kv,tl
+      real    vd(1)
+
+      call nek_ws_push
+
+      ! points per owner rank, tells each rank how many it receives
+      kc = nek_ws_i(np)
+      kt = nek_ws_i(2*np)
+      call izero(iws(kc),np)
+      nq = 0
+      do i=1,n
+         if (iwk(i,1).ne.2) then ! found (inside or on the boundary)
+            nq = nq+1
+            iws(kc+iwk(i,3)) = iws(kc+iwk(i,3))+1
+         endif
+      enddo
+      mt = 0
+      do ip=0,np-1
+         if (iws(kc+ip).gt.0) then
+            iws(kt+2*mt)   = ip
+            iws(kt+2*mt+1) = iws(kc+ip)
+            mt = mt+1
+         endif
+      enddo
+      call fgslib_crystal_tuple_transfer(cr_h,mt,np,iws(kt),2,tl,0,
+     $                                   vd,0,1)
+      m = 0
+      do j=1,mt
+         m = m+iws(kt+2*j-1)
+      enddo
+
+      mc = max(m,nq,1)
+      kt = nek_ws_i(3*mc)
+      kv = nek_ws_r(ldim*mc)
+      intp_nq(ih) = nq
+      intp_nr(ih) = m
+      intp_ke(ih) = nek_ws_ikeep(m)
+      intp_ko(ih) = nek_ws_ikeep(2*m)
+      intp_kw(ih) = nek_ws_rkeep(lx1*ldim*m)
+      call intp_plan_set(iws(intp_ke(ih)),iws(intp_ko(ih)),
+     $                   ws(intp_kw(ih)),m,iws(kt),ws(kv),mc,
+     $                   iwk,rwk(1,2),nmax,n,cr_h)
+
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_plan_set(ie,io,w,m,ti,vr,mc,iwk,rst,nmax,n,
+     $                         icr)
+c
+c     Plan of the m points arriving in ti/vr (capacity mc), rst holds
+c     r,s(,t) of the located points as returned by findpts
+c
+      include 'SIZE'
+      include 'WZ'
+
+      integer ie(m),io(2,m),ti(3,mc)
+      real    w(lx1,ldim,m),vr(ldim,mc)
+      real    rst(ldim,*)
+      integer iwk(nmax,*)
+
+      integer*8 tl
+
+      k = 0
+      do i=1,n
+         if (iwk(i,1).ne.2) then
+            k = k+1
+            ti(1,k) = iwk(i,3)
+            ti(2,k) = iwk(i,2)+1
+            ti(3,k) = i
+            do id=1,ldim
+               vr(id,k) = rst(id,i)
+            enddo
+         endif
+      enddo
+      call fgslib_crystal_tuple_transfer(icr,k,mc,ti,3,tl,0,
+     $                                   vr,ldim,1)
+      if (k.ne.m) call exitti('intp_plan: unexpected point count$',k)
+
+      do j=1,m
+         ie(j)   = ti(2,j)
+         io(1,j) = ti(1,j)
+         io(2,j) = ti(3,j)
+         do id=1,ldim
+            call fd_weights_full(vr(id,j),zgm1(1,id),lx1-1,0,
+     $                           w(1,id,j))
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_peval(out,fld,nfld,n,ih)
+c
+c     Evaluate fields at the plan points, intp_fbat fields per exchange
+c
+      include 'SIZE'
+      include 'INTP'
+      include 'WSPACE'
+
+      real out(*),fld(*)
+
+      integer*8 kt,kv
+
+      mc = max(intp_nr(ih),intp_nq(ih),1)
+      call nek_ws_push
+      kt = nek_ws_i(3*mc)
+      kv = nek_ws_r(intp_fbat*mc)
+      call intp_peval_set(out,fld,nfld,n,iws(intp_ke(ih)),
+     $                    iws(intp_ko(ih)),ws(intp_kw(ih)),
+     $                    intp_nr(ih),iws(kt),ws(kv),mc)
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_peval_set(out,fld,nfld,n,ie,io,w,m,ti,vr,mc)
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'INTP'
+
+      real    out(n,nfld),fld(lx1*ly1*lz1*lelt,nfld)
+      integer ie(m),io(2,m),ti(3,mc)
+      real    w(lx1,ldim,m),vr(intp_fbat,mc)
+
+      integer*8 tl
+      real    intp_tens
+
+      nxyz = lx1*ly1*lz1
+      call rzero(out,n*nfld)
+
+      do if0=1,nfld,intp_fbat
+         nf = min(intp_fbat,nfld-if0+1)
+         k  = m
+         do j=1,m
+            ti(1,j) = io(1,j)
+            ti(2,j) = io(2,j)
+            ti(3,j) = 0
+            do l=1,nf
+               vr(l,j) = intp_tens(fld(1+(ie(j)-1)*nxyz,if0+l-1),
+     $                             w(1,1,j))
+            enddo
+         enddo
+         call fgslib_crystal_tuple_transfer(cr_h,k,mc,ti,3,tl,0,
+     $                                      vr,intp_fbat,1)
+         do j=1,k
+            i = ti(2,j)
+            do l=1,nf
+               out(i,if0+l-1) = vr(l,j)
+            enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      real function intp_tens(f,w)
+c
+c     f at a point of the element with Lagrange weights w
+c
+      include 'SIZE'
+
+      real f(lx1,ly1,lz1),w(lx1,ldim)
+
+      s = 0
+      do k=1,lz1
+         wk = 1.
+         if (ldim.eq.3) wk = w(k,ldim)
+         do j=1,ly1
+            wjk = w(j,2)*wk
+            do i=1,lx1
+               s = s + w(i,1)*wjk*f(i,j,k)
+            enddo
+         enddo
+      enddo
+      intp_tens = s
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_xkeep(x,xp,yp,zp,n)
+c
+c     copy of a point set, compared by intp_xsame
+c
+      include 'SIZE'
+
+      real x(n,ldim),xp(n),yp(n),zp(n)
+
+      call copy(x(1,1),xp,n)
+      call copy(x(1,2),yp,n)
+      if (ldim.eq.3) call copy(x(1,ldim),zp,n)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function intp_xsame(x,xp,yp,zp,n)
+c
+c     1 if xp,yp,zp are exactly the points kept in x, else 0
+c
+      include 'SIZE'
+
+      real x(n,ldim),xp(n),yp(n),zp(n)
+
+      intp_xsame = 0
+      do i=1,n
+         if (x(i,1).ne.xp(i) .or. x(i,2).ne.yp(i)) return
+         if (ldim.eq.3) then
+            if (x(i,ldim).ne.zp(i)) return
+         endif
+      enddo
+      intp_xsame = 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_fpfree(ih)
+
+      include 'SIZE'
+      include 'INTP'
 
       ih_intp1 = ih_intp(1,ih)
       ih_intp2 = ih_intp(2,ih)
 
       call fgslib_findpts_free(ih_intp1)
-      call fgslib_findpts_free(ih_intp2)
+      if (ih_intp2.ne.ih_intp1) call fgslib_findpts_free(ih_intp2)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_free(ih)
+
+      include 'SIZE'
+      include 'INTP'
+
+      call intp_fpfree(ih)
+      call intp_pfree(ih)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intp_pfree(ih)
+c
+c     drop the plan of ih
+c
+      include 'SIZE'
+      include 'INTP'
+
+      call nek_ws_rfree(intp_kx(ih))
+      call nek_ws_ifree(intp_ke(ih))
+      call nek_ws_ifree(intp_ko(ih))
+      call nek_ws_rfree(intp_kw(ih))
+      intp_np(ih) = -1
+      intp_nr(ih) = -1
 
       return
       end
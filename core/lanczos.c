@@ -0,0 +1,234 @@
+/*
+ * Lanczos eigenvalue estimation, shared by the tools (amg_hypre, the
+ * amg_matlab2 tdeig mex)
+ *
+ * lanczos_tdeig(lambda,y,d,v,n) finds the n+1 eigenvalues of the arrow
+ * matrix
+ *
+ *    d[1]           v[1]
+ *         d[2]      v[2]
+ *              d[n] v[n]
+ *    v[1] v[2] v[n] v[0]
+ *
+ * (d[1..n] ascending) as the roots of the secular equation, one per
+ * interval of the interlacing d.  d[0], d[n+1] are set to Gershgorin
+ * bounds, y gets the (n+1)th component of each orthonormal
+ * eigenvector.  This is the Ritz value update of the Lanczos iteration:
+ * the eigenbasis of T_(k-1) bordered by the new row of T_k.
+ *
+ * lanczos_eig(lambda,y,L,r) runs Lanczos on the operator L->ax from
+ * the start vector r (overwritten) until the extreme Ritz values change
+ * by less than L->tol and their last eigenvector components are below
+ * L->ytol, or L->kmax steps.  It returns the number k of Ritz values,
+ * ascending in lambda[0..k-1], with y as above (small y: converged).
+ * Vectors are distributed, L->gsum sums the dot products over ranks
+ * (NULL: serial); each step does one operator application and two
+ * reductions.
+ *
+ * With L->reorth the Lanczos vectors are kept (kmax*n) and every new
+ * vector is reorthogonalized against all of them with two passes of
+ * classical Gram-Schmidt.  Each pass is one block dot product (a single
+ * reduction of k values), and the norm rides along with the second pass
+ * in place of the usual norm reduction, so a step does three reductions
+ * instead of two: one extra rather than 2k.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "lanczos.h"
+
+/* minimizes cancellation error (but not round-off ...) */
+static double sum_3(const double a, const double b, const double c)
+{
+  if     ( (a>=0 && b>=0) || (a<=0 && b<=0) ) return (a+b)+c;
+  else if( (a>=0 && c>=0) || (a<=0 && c<=0) ) return (a+c)+b;
+  else return a+(b+c);
+}
+
+/* solve     c
+          - --- + b + a x == 0        with sign(x) = sign
+             x
+*/
+static double rat_root(const double a, const double b, const double c,
+                       const double sign)
+{
+  double bh = (fabs(b) + sqrt(b*b + 4*a*c))/2;
+  return sign * (b*sign <= 0 ? bh/a : c/bh);
+}
+
+/*
+  find d[ri] <= lambda <= d[ri+1]
+  such that 0 = lambda - v[0] + \sum_i^n v[i]^2 / (d[i] - lambda)
+*/
+#define EPS (128*DBL_EPSILON)
+static double sec_root(double *y, const double *d, const double *v,
+                       const int ri, const int n)
+{
+  double dl = d[ri], dr = d[ri+1], L = dr-dl;
+  double x0l = L/2, x0r = -L/2;
+  int i;
+  double al, ar, bln, blp, brn, brp, cl, cr;
+  double fn, fp, lambda0, lambda;
+  double tol = L;
+  if(fabs(dl)>tol) tol=fabs(dl);
+  if(fabs(dr)>tol) tol=fabs(dr);
+  tol *= EPS;
+  for(;;) {
+    if(fabs(x0l)==0 || x0l < 0) { *y=0; return dl; }
+    if(fabs(x0r)==0 || x0r > 0) { *y=0; return dr; }
+    lambda0 = fabs(x0l) < fabs(x0r) ? dl + x0l : dr + x0r;
+    al = ar = cl = cr = bln = blp = brn = brp = 0;
+    fn = fp = 0;
+    for(i=1;i<=ri;++i) {
+      double den = (d[i]-dl)-x0l;
+      double fac = v[i]/den;
+      double num = sum_3(d[i],-dr,-2*x0r);
+      fn += v[i]*fac;
+      fac *= fac;
+      ar += fac;
+      if(num > 0) brp += fac*num; else brn += fac*num;
+      bln += fac*(d[i]-dl);
+      cl  += fac*x0l*x0l;
+    }
+    for(i=ri+1;i<=n;++i) {
+      double den = (d[i]-dr)-x0r;
+      double fac = v[i]/den;
+      double num = sum_3(d[i],-dl,-2*x0l);
+      fp += v[i]*fac;
+      fac *= fac;
+      al += fac;
+      if(num > 0) blp += fac*num; else bln += fac*num;
+      brp += fac*(d[i]-dr);
+      cr  += fac*x0r*x0r;
+    }
+    if(lambda0>0) fp+=lambda0; else fn+=lambda0;
+    if(v[0]<0) fp-=v[0],blp-=v[0],brp-=v[0];
+          else fn-=v[0],bln-=v[0],brn-=v[0];
+    if(fp+fn > 0) { /* go left */
+      x0l = rat_root(1+al,sum_3(dl,blp,bln),cl,1);
+      lambda = dl + x0l;
+      x0r = x0l - L;
+    } else { /* go right */
+      x0r = rat_root(1+ar,sum_3(dr,brp,brn),cr,-1);
+      lambda = dr + x0r;
+      x0l = x0r + L;
+    }
+    if( fabs(lambda-lambda0) < tol ) {
+      double ty=0, fac;
+      for(i=1;i<=ri;++i) fac = v[i]/((d[i]-dl)-x0l), ty += fac*fac;
+      for(i=ri+1;i<=n;++i) fac = v[i]/((d[i]-dr)-x0r), ty += fac*fac;
+      *y = 1/sqrt(1+ty);
+      return lambda;
+    }
+  }
+}
+#undef EPS
+
+void lanczos_tdeig(double *lambda, double *y, double *d, const double *v,
+                   const int n)
+{
+  int i;
+  double v1norm = 0, min=v[0], max=v[0];
+  for(i=1;i<=n;++i) {
+    double vi = fabs(v[i]), a=d[i]-vi, b=d[i]+vi;
+    v1norm += vi;
+    if(a<min) min=a;
+    if(b>max) max=b;
+  }
+  d[0]   = v[0] - v1norm < min ? v[0] - v1norm : min;
+  d[n+1] = v[0] + v1norm > max ? v[0] + v1norm : max;
+  for(i=0;i<=n;++i) lambda[i] = sec_root(&y[i],d,v,i,n);
+}
+
+static double dot(const double *a, const double *b, const int n)
+{
+  double s = 0;
+  int i;
+  for(i=0;i<n;++i) s += a[i]*b[i];
+  return s;
+}
+
+static double gdot(const struct lanczos *L, const double *a, const double *b)
+{
+  double s = dot(a,b,L->n);
+  if(L->gsum) L->gsum(&s,1,L->ctx);
+  return s;
+}
+
+/* r := r - Q h,  h = Q^t r  (k vectors of Q, twice),  returns |r|^2 */
+static double reorth(const struct lanczos *L, const double *Q, const int k,
+                     double *h, double *r)
+{
+  const int n = L->n;
+  double rr = 0;
+  int pass, i, j;
+  for(pass=0;pass<2;++pass) {
+    for(j=0;j<k;++j) h[j] = dot(&Q[(size_t)j*n],r,n);
+    if(pass) h[k] = dot(r,r,n);
+    if(L->gsum) L->gsum(h,k+pass,L->ctx);
+    for(j=0;j<k;++j) {
+      const double *q = &Q[(size_t)j*n]; double hj = h[j];
+      for(i=0;i<n;++i) r[i] -= hj*q[i];
+    }
+  }
+  /* |r - Q h|^2 = |r|^2 - |h|^2 for the second (small) correction */
+  rr = h[k];
+  for(j=0;j<k;++j) rr -= h[j]*h[j];
+  return rr > 0 ? rr : 0;
+}
+
+int lanczos_eig(double *lambda, double *y, const struct lanczos *L,
+                double *r)
+{
+  const int n = L->n, kmax = L->kmax;
+  double *d  = malloc((kmax+1)*sizeof(double));
+  double *v  = malloc((kmax+1)*sizeof(double));
+  double *qk   = malloc((n+1)*sizeof(double));
+  double *qkm1 = malloc((n+1)*sizeof(double));
+  double *Aqk = malloc((n+1)*sizeof(double));
+  double *Q = 0, *h = 0;
+  double beta = sqrt(gdot(L,r,r)), change = 1.0;
+  int i, k = 0;
+
+  if(L->reorth) {
+    Q = malloc(((size_t)kmax*n+1)*sizeof(double));
+    h = malloc((kmax+1)*sizeof(double));
+  }
+  memset(qk,0,n*sizeof(double));
+
+  while (k < kmax && (k == 0 || change > L->tol ||
+                      y[0] > L->ytol || y[k-1] > L->ytol))
+  {
+    double alpha, *t;
+    k++;
+    t = qkm1, qkm1 = qk, qk = t;
+    for(i=0;i<n;++i) qk[i] = r[i]*(1./beta);
+    if(Q) memcpy(&Q[(size_t)(k-1)*n],qk,n*sizeof(double));
+    L->ax(Aqk,qk,L->ctx);
+    alpha = gdot(L,qk,Aqk);
+    for(i=0;i<n;++i) r[i] = Aqk[i] - alpha*qk[i] - beta*qkm1[i];
+
+    if(k==1) {
+      lambda[0] = alpha;
+      y[0] = 1;
+    } else {
+      double l0 = lambda[0], lkm2 = lambda[k-2];
+      d[0] = 0;
+      for(i=1;i<k;++i) d[i] = lambda[i-1];
+      d[k] = 0;
+      v[0] = alpha;
+      for(i=1;i<k;++i) v[i] = beta*y[i-1];
+      lanczos_tdeig(lambda,y,d,v,k-1);
+      change = fabs(l0 - lambda[0]) + fabs(lkm2 - lambda[k-1]);
+    }
+
+    beta = sqrt(Q ? reorth(L,Q,k,h,r) : gdot(L,r,r));
+    if(beta==0) break;
+  }
+
+  free(h); free(Q);
+  free(Aqk); free(qkm1); free(qk); free(v); free(d);
+  return k;
+}
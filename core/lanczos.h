@@ -0,0 +1,26 @@
+#ifndef LANCZOS_H
+#define LANCZOS_H
+
+/*
+ * Lanczos eigenvalue estimation (see lanczos.c)
+ *
+ * The operator and the global reduction are supplied by the caller, so
+ * the same engine serves serial and distributed (MPI) callers.
+ */
+struct lanczos {
+  int n;          /* local vector length                               */
+  int kmax;       /* maximum number of iterations (Ritz values)        */
+  int reorth;     /* 1: full (blocked CGS2) reorthogonalization        */
+  double tol;     /* stop when the extreme Ritz values move less, and  */
+  double ytol;    /* their eigenvector components are below ytol       */
+  void (*ax)(double *y, const double *x, void *ctx);  /* y = A x       */
+  void (*gsum)(double *v, int n, void *ctx);  /* in place global sum,  */
+  void *ctx;                                  /* NULL when serial      */
+};
+
+void lanczos_tdeig(double *lambda, double *y, double *d, const double *v,
+                   const int n);
+int  lanczos_eig(double *lambda, double *y, const struct lanczos *L,
+                 double *r);
+
+#endif
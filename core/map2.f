@@ -287,7 +287,7 @@ c-----------------------------------------------------------------------
       integer nelbox(3),nstride_box(3)
 
       integer proc
-      integer ibuf(2)
+      integer ibuf(2,lelt),iegl(lelt)
 
       nelt = 0
       nelv = 0
@@ -307,13 +307,14 @@ c-----------------------------------------------------------------------
                if (ieg.le.nelgv) nelv = nelv + 1
                if (ieg.le.nelgt) nelt = nelt + 1
 
-               ibuf(1) = iel
-               ibuf(2) = proc
-               call dProcmapPut(ibuf,2,0,ieg)
+               ibuf(1,iel) = iel
+               ibuf(2,iel) = proc
+               iegl(iel)   = ieg
             endif
          enddo
       enddo
       enddo
+      call dProcmapPutN(ibuf,2,2,0,iegl,1,iel)
       call nekgsync() ! wait pending puts
 
       return
@@ -425,7 +426,7 @@ c
       character*5   version
       real*4        test
 
-      logical ifma2,ifmap
+      logical ifma2,ifmap,ifpmap,ifre2
       integer e,eg,eg0,eg1
       integer itmp20(20)
 
@@ -433,6 +434,7 @@ c
 
       ierr   = 0
       ifma2  = .false.
+      ifpmap = .false.
       suffix = '.map'
       ntuple = 0
 
@@ -450,26 +452,43 @@ c
          endif
 
         if(.not.ifmap .and. .not.ifma2) ierr=1 
+
+        ! no map file or forced: partition in-situ from the .re2
+        ifpmap = param(175).gt.0 .or. ierr.eq.1
+        if (ifpmap) then
+           suffix = '.ma2'
+           call chcopy(mapfle1(lfname+1),suffix,4)
+           inquire(file=re2fle, exist=ifre2)
+           ierr = 0
+           if (.not.ifre2) ierr = 1
+        endif
+      endif
+      call bcast(ifpmap,sizeof(ifpmap))
+      call bcast(mapfle,sizeof(mapfle))
+      if (ifpmap) then
+         call err_chk(ierr,' Cannot find map or re2 file!$')
+         call parmap_vert(vertex,nlv,wk,mdw,ndw,ifgfdm,mapfle)
+         return
       endif
+
       if(nid.eq.0) write(6,'(A,A)') ' Reading ', mapfle
       call err_chk(ierr,' Cannot find map file!$')
-      call bcast(mapfle,sizeof(mapfle))
       call bcast(ifma2,sizeof(ifma2))
 
       ! just read header
       if (nid.eq.0) then
          if (ifma2) then         
-            call byte_open(mapfle,ierr)
+            call byte_hopen(mapfle,ih_map,1,0,0,ierr)
             if(ierr.ne.0) goto 100
 
             call blank(hdr,sizeof(hdr))
-            call byte_read(hdr,sizeof(hdr)/4,ierr)
+            call byte_hread(ih_map,hdr,sizeof(hdr)/4,ierr)
             if(ierr.ne.0) goto 100
 
             read (hdr,1) version,neli,nnzi
     1       format(a5,2i12)
 
-            call byte_read(test,1,ierr)
+            call byte_hread(ih_map,test,1,ierr)
             if(ierr.ne.0) goto 100
             ifbswap = if_byte_swap_test(test,ierr)
             if(ierr.ne.0) goto 100
@@ -494,7 +513,7 @@ c
       ifmpiio = .false.
 #endif
       if (ifma2 .and. ifmpiio) then
-         if (nid.eq.0) call byte_close(ierr)
+         if (nid.eq.0) call byte_hclose(ih_map,ierr)
          call byte_open_mpi(mapfle,ifh_map,.true.,ierr)
          offs0 = sizeof(hdr) + sizeof(test)
 
@@ -520,12 +539,8 @@ c
             m = m - 1
          enddo
 
-         m = 0
-         do j = 1,nelr
-            eg = nelBr + j
-            m = m + 1
-            call dProcmapPut(wk(1,m),1,2,eg) ! store global element index
-         enddo
+         eg = nelBr + 1
+         call dProcmapPutN(wk,mdw,1,2,eg,0,nelr) ! store global el index
 
          goto 50
       endif
@@ -548,7 +563,7 @@ c
 
             if (ifma2) then
                nwds = (eg1 - eg0)*(mdw-1)
-               call byte_read(wk,nwds,ierr)
+               call byte_hread(ih_map,wk,nwds,ierr)
                if (ierr.ne.0) goto 200
                if (ifbswap) call byte_reverse(wk,nwds,ierr)
 
@@ -567,11 +582,8 @@ c
                enddo
             endif
             
-            m = 0
-            do eg=eg0+1,eg1
-               m = m + 1
-               call dProcmapPut(wk(1,m),1,2,eg) ! store global element index
-            enddo
+            eg = eg0 + 1
+            call dProcmapPutN(wk,mdw,1,2,eg,0,eg1-eg0) ! global el index
     
             if (ipass.lt.npass) call csend(ipass,wk,len,ipass,0) !send to ipass
             eg0 = eg1
@@ -580,7 +592,7 @@ c
          ntuple = m
 
          if (ifma2) then
-            call byte_close(ierr)
+            call byte_hclose(ih_map,ierr)
          else
             close(80)
          endif
@@ -602,9 +614,7 @@ c
 
 
       key = mdw ! processor id
-      do i = 1,ntuple
-         wk(key,i) = gllnid(wk(1,i))
-      enddo
+      call dProcmapNidN(wk(key,1),mdw,wk(1,1),mdw,ntuple)
 
       call fgslib_crystal_ituple_transfer(cr_h,wk,mdw,ntuple,ndw,key)
 
@@ -632,20 +642,23 @@ c-----------------------------------------------------------------------
       integer function gllnid(ieg)
 
       include 'mpif.h'
+      include 'SIZE'
+      include 'DPROCMAP'
 
-      integer iegl, nidl
-      save    iegl, nidl
-      data    iegl, nidl /0,0/
+      integer iegl, nidl, igen
+      save    iegl, nidl, igen
+      data    iegl, nidl, igen /0,0,0/
 
       integer ibuf(3)
 
-      if (ieg.eq.iegl) then
+      if (ieg.eq.iegl .and. igen.eq.dProcmapGen) then
          ibuf(2) = nidl
          goto 100
       endif
       call dProcmapGet(ibuf,ieg)
 
  100  iegl   = ieg
+      igen   = dProcmapGen
       nidl   = ibuf(2)
       gllnid = ibuf(2)
 
@@ -654,20 +667,23 @@ c-----------------------------------------------------------------------
       integer function gllel(ieg)
 
       include 'mpif.h'
+      include 'SIZE'
+      include 'DPROCMAP'
 
-      integer iegl, iell
-      save    iegl, iell
-      data    iegl, iell /0,0/
+      integer iegl, iell, igen
+      save    iegl, iell, igen
+      data    iegl, iell, igen /0,0,0/
 
       integer ibuf(3)
 
-      if (ieg.eq.iegl) then
+      if (ieg.eq.iegl .and. igen.eq.dProcmapGen) then
          ibuf(1) = iell
          goto 100
       endif
       call dProcmapGet(ibuf,ieg)
 
  100  iegl  = ieg
+      igen  = dProcmapGen
       iell  = ibuf(1)
       gllel = ibuf(1)
 
@@ -682,9 +698,9 @@ c
       include 'SIZE'
       include 'PARALLEL'
 
-      integer ibuf(3)
+      integer ibuf(3,lelt)
       integer nel(2)
-      integer iw1(lelt), iw2(lelt)
+      integer iw1(lelt), iw2(lelt), irl(lelt)
 
       nel(1) = nelgv
       nel(2) = nelgt - nelgv
@@ -706,27 +722,29 @@ c
             if (nid_el.eq.nid) then
                irr = ir
                if (imsh.eq.2) irr = nelgv + irr
-               call dProcmapGet(ibuf,irr)
-               ieg = ibuf(3) 
-
                iel = iel + 1
-               lglel(iel) = ieg
-
-               if (ieg.le.nelgv) nelv = nelv + 1
-               if (ieg.le.nelgt) nelt = nelt + 1
-
+               if (iel.gt.lelt) call exitti('assign_gllnid: lelt $',iel)
+               irl(iel) = irr
                iw1(iel) = nid_el
             endif
          enddo
       enddo
 
+      call dProcmapGetN(ibuf,irl,1,iel)
+      do i = 1,iel
+         ieg = ibuf(3,i) 
+         lglel(i) = ieg
+         if (ieg.le.nelgv) nelv = nelv + 1
+         if (ieg.le.nelgt) nelt = nelt + 1
+      enddo
+
       ! local-to-global mapping
       call isort(lglel,iw2,nelt)
       do i = 1,nelt
-         ibuf(1) = i 
-         ibuf(2) = iw1(iw2(i))
-         call dProcmapPut(ibuf,2,0,lglel(i))
+         ibuf(1,i) = i 
+         ibuf(2,i) = iw1(iw2(i))
       enddo
+      call dProcmapPutN(ibuf,3,2,0,lglel,1,nelt)
 
       call nekgsync() ! wait for pending puts
 
@@ -1,3 +1,15 @@
+c
+c     With OpenMP (PPLIST OPENMP) the vector ops below split vectors of
+c     at least NEK_OMP_NMIN entries among the threads.  Shorter vectors,
+c     e.g. single elements inside an already threaded element loop,
+c     stay on the calling thread.
+c
+c     With OpenACC (PPLIST OPENACC) the same ops run on the device while
+c     a solve is resident there (ifacc, see offload.f) and the first
+c     argument is present on the device; host-only arrays such as the
+c     gop work buffers stay on the host.
+c
+#define NEK_OMP_NMIN 8192
 c-----------------------------------------------------------------------
       SUBROUTINE BLANK(A,N)
       CHARACTER*1 A(1)
@@ -58,6 +70,10 @@ C
       REAL A(1),B(1)
       include 'CTIMER'
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -67,6 +83,11 @@ C
       etime1=dnekclock()
 #endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)/B(I)
  100  CONTINUE
@@ -83,6 +104,10 @@ c-----------------------------------------------------------------------
 C
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) tinv3=0.0
@@ -91,6 +116,11 @@ C
       etime1=dnekclock()
 #endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)/C(I)
  100  CONTINUE
@@ -104,7 +134,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1),C(1),D(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)*C(I)*D(I)
   100 CONTINUE
@@ -126,7 +165,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1),C(1),D(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)+B(I)*C(I)*D(I)
   100 CONTINUE
@@ -148,7 +196,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)-B(I)
  100  CONTINUE
@@ -159,7 +216,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1),C(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)-C(I)
  100  CONTINUE
@@ -170,7 +236,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1),C(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)-B(I)*C(I)
   100 CONTINUE
@@ -190,6 +265,15 @@ C
 c-----------------------------------------------------------------------
       subroutine rzero(a,n)
       DIMENSION  A(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I = 1, N
  100     A(I ) = 0.0
       return
@@ -212,6 +296,15 @@ c-----------------------------------------------------------------------
 c-----------------------------------------------------------------------
       subroutine rone(a,n)
       DIMENSION A(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I = 1, N
  100     A(I ) = 1.0
       return
@@ -226,7 +319,16 @@ c-----------------------------------------------------------------------
 c-----------------------------------------------------------------------
       subroutine cfill(a,b,n)
       DIMENSION  A(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I = 1, N
  100     A(I) = B
       return
@@ -242,7 +344,16 @@ C
 c-----------------------------------------------------------------------
       subroutine copy(a,b,n)
       real a(1),b(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=b(i)
       enddo
@@ -287,7 +398,16 @@ C
 c-----------------------------------------------------------------------
       subroutine chsign(a,n)
       REAL A(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I) = -A(I)
  100  CONTINUE
@@ -299,7 +419,16 @@ c-----------------------------------------------------------------------
       REAL A(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)*CONST
  100  CONTINUE
@@ -310,7 +439,16 @@ c-----------------------------------------------------------------------
       REAL A(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=A(I)+CONST
  100  CONTINUE
@@ -330,7 +468,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)+CONST
  100  CONTINUE
@@ -400,9 +547,18 @@ c-----------------------------------------------------------------------
       real function vlsum(vec,n)
       REAL VEC(1)
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
       SUM = 0.
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(vec)
+#endif
+c$omp parallel do reduction(+:sum) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:sum) if(ifdev)
       DO 100 I=1,N
          SUM=SUM+VEC(I)
  100  CONTINUE
@@ -548,6 +704,10 @@ c-----------------------------------------------------------------------
       real a(1),b(1)
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -557,6 +717,11 @@ c-----------------------------------------------------------------------
       etime1=dnekclock()
 #endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=a(i)*b(i)
       enddo
@@ -570,7 +735,16 @@ c-----------------------------------------------------------------------
 c-----------------------------------------------------------------------
       subroutine col2c(a,b,c,n)
       real a(1),b(1),c
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=a(i)*b(i)*c
       enddo
@@ -582,6 +756,10 @@ c-----------------------------------------------------------------------
       real a(1),b(1),c(1)
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -591,6 +769,11 @@ c-----------------------------------------------------------------------
       etime1=dnekclock()
 #endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=b(i)*c(i)
       enddo
@@ -606,6 +789,10 @@ c-----------------------------------------------------------------------
       real a(1),b(1)
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -614,6 +801,11 @@ c-----------------------------------------------------------------------
       endif
       etime1=dnekclock()
 #endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=a(i)+b(i)
       enddo
@@ -627,7 +819,16 @@ c-----------------------------------------------------------------------
       subroutine add3(a,b,c,n)
       real a(1),b(1),c(1)
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=b(i)+c(i)
       enddo
@@ -638,6 +839,10 @@ c-----------------------------------------------------------------------
       real a(1),b(1),c(1)
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -647,6 +852,11 @@ c-----------------------------------------------------------------------
       etime1=dnekclock()
 #endif
 
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          a(i)=a(i)+b(i)*c(i)
       enddo
@@ -662,7 +872,16 @@ c-----------------------------------------------------------------------
       real a(1),b(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
         A(I)=C1*A(I)+B(I)
   100 CONTINUE
@@ -675,6 +894,10 @@ c-----------------------------------------------------------------------
 C
       include 'OPCTR'
       include 'CTIMER'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
 #ifdef TIMER2
       if (icalld.eq.0) then
@@ -684,6 +907,11 @@ C
       etime1=dnekclock()
 #endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
         A(I)=A(I)+C1*B(I)
   100 CONTINUE
@@ -700,7 +928,16 @@ c-----------------------------------------------------------------------
       real a(1),b(1),c(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
         A(I)=C1*B(I)+C2*C(I)
   100 CONTINUE
@@ -712,7 +949,16 @@ c-----------------------------------------------------------------------
       REAL A(1),B(1),C(1),D(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)+C(I)+D(I)
  100  CONTINUE
@@ -724,8 +970,17 @@ c-----------------------------------------------------------------------
       include 'SIZE'
       include 'OPCTR'
       include 'PARALLEL'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
       s = 0.
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$omp parallel do reduction(+:s) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:s) if(ifdev)
       do i=1,n
          s = s + x(i)*y(i)
       enddo
@@ -738,8 +993,17 @@ c-----------------------------------------------------------------------
       include 'SIZE'
       include 'OPCTR'
       include 'PARALLEL'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
       s = 0.
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$omp parallel do reduction(+:s) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:s) if(ifdev)
       do i=1,n
          s = s + x(i)*x(i)*y(i)
       enddo
@@ -764,8 +1028,17 @@ C
       REAL TMP,WORK(1)
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
       TMP = 0.0
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$omp parallel do reduction(+:tmp) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:tmp) if(ifdev)
       DO 10 I=1,N
          TMP = TMP + A(I)*B(I)*MULT(I)
  10   CONTINUE
@@ -782,8 +1055,17 @@ C
 c
       real x(1), y(1)
       real tmp,work(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
       tmp=0.0
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$omp parallel do reduction(+:tmp) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:tmp) if(ifdev)
       do 10 i=1,n
          tmp = tmp+ x(i)*y(i)
    10 continue
@@ -798,8 +1080,17 @@ C     Perform inner-product  x*x*y*z
 c
       real x(1), y(1),z(1)
       real tmp,work(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 
       ds = 0.0
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$omp parallel do reduction(+:ds) if(n.ge.NEK_OMP_NMIN)
+c$acc parallel loop default(present) reduction(+:ds) if(ifdev)
       do 10 i=1,n
          ds=ds+x(i)*x(i)*y(i)*z(i)
    10 continue
@@ -844,7 +1135,15 @@ c-----------------------------------------------------------------------
       function glsum (x,n)
       DIMENSION X(1)
       DIMENSION TMP(1),WORK(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       TSUM = 0.
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$acc parallel loop default(present) reduction(+:tsum) if(ifdev)
       DO 100 I=1,N
          TSUM = TSUM+X(I)
  100  CONTINUE
@@ -857,7 +1156,15 @@ c-----------------------------------------------------------------------
       real function glamax(a,n)
       REAL A(1)
       DIMENSION TMP(1),WORK(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       TMAX = 0.0
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$acc parallel loop default(present) reduction(max:tmax) if(ifdev)
       DO 100 I=1,N
          TMAX = MAX(TMAX,ABS(A(I)))
  100  CONTINUE
@@ -943,7 +1250,15 @@ C-----------------------------------------------------------------------
       function glmax(a,n)
       REAL A(1)
       DIMENSION TMP(1),WORK(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       TMAX=-99.0e20
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$acc parallel loop default(present) reduction(max:tmax) if(ifdev)
       DO 100 I=1,N
          TMAX=MAX(TMAX,A(I))
   100 CONTINUE
@@ -956,7 +1271,15 @@ c-----------------------------------------------------------------------
       function glmin(a,n)
       REAL A(1)
       DIMENSION TMP(1),WORK(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
       TMIN=99.0e20
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$acc parallel loop default(present) reduction(min:tmin) if(ifdev)
       DO 100 I=1,N
          TMIN=MIN(TMIN,A(I))
   100 CONTINUE
@@ -1556,7 +1879,15 @@ c
 c-----------------------------------------------------------------------
       subroutine add2sxy(x,a,y,b,n)
       real x(1),y(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 c
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$acc parallel loop default(present) if(ifdev)
       do i=1,n
          x(i) = a*x(i) + b*y(i)
       enddo
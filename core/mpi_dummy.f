@@ -591,6 +591,32 @@ c
 
       return
       end
+      subroutine mpi_iallreduce ( data1, data2, n, datatype,
+     &  operation, comm, irequest, ierror )
+
+c*********************************************************************72
+c
+cc MPI_IALLREDUCE carries out a reduction operation, completed at once.
+c
+      implicit none
+
+      integer n
+
+      integer comm
+      integer data1(n)
+      integer data2(n)
+      integer datatype
+      integer ierror
+      integer irequest
+      integer operation
+
+      call mpi_allreduce ( data1, data2, n, datatype,
+     &  operation, comm, ierror )
+      irequest = -1
+
+      return
+      end
+
       subroutine mpi_irecv ( data, n, datatype, iproc, itag,
      &  comm, irequest, ierror )
 
@@ -1097,4 +1123,34 @@ c
  
       return
       end
+
+      subroutine mpi_send_init(data,n,datatype,iproc,itag,comm,
+     $                         irequest,ierr)
+
+      call exitti('mpi_send_init not supported!$',1)
+
+      return
+      end
+
+      subroutine mpi_recv_init(data,n,datatype,iproc,itag,comm,
+     $                         irequest,ierr)
+
+      call exitti('mpi_recv_init not supported!$',1)
+
+      return
+      end
+
+      subroutine mpi_startall(icount,irequest,ierr)
+
+      ierr = 0
+
+      return
+      end
+
+      subroutine mpi_request_free(irequest,ierr)
+
+      ierr = 0
+
+      return
+      end
 c-----------------------------------------------------------------------
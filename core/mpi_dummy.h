@@ -3,6 +3,8 @@ c  Dummy parameters for MPI F77 stubs
 c
       integer mpi_comm_world
       parameter ( mpi_comm_world = 0 )
+      integer mpi_comm_self
+      parameter ( mpi_comm_self = 1 )
 c
 c  Return values.
 c
@@ -35,6 +35,7 @@ c     Boundary conditions are changed back to 'v' or 't'.
          call nekneksanchk(1)
          call set_intflag
          call neknekmv()
+         call neknek_stag_setup
          icalld = icalld + 1
       endif 
       call neknekgsync()
@@ -46,6 +47,9 @@ c     exchange_points2 finds the processor and element number at
 c     comm_world level and displaces the 1st mesh back
       call exchange_points2(dxf,dyf,dzf)
 
+c     Static meshes exchange through persistent channels
+      call neknek_plan
+
       return
       end
 c-------------------------------------------------------------
@@ -114,27 +118,10 @@ c     is activated. It is unconditionally stable.  If you want to use
 c     higher-order interface extrapolation schemes, you need to increase 
 c     ngeom to ngeom=3-5 for scheme to be stable.
 
-
-      if (NINTER.eq.1.or.istep.eq.0) then
-       c0=1.
-       c1=0.
-       c2=0.
-       else if (NINTER.eq.2.or.istep.eq.1) then
-         c0=2.
-         c1=-1.
-         c2=0.
-       else 
-         c0=3.
-         c1=-3.
-         c2=1.
-      endif
-
-      do k=1,nfld_neknek
-      do i=1,n
-         valint(i,1,1,1,k) = 
-     $      c0*bdrylg(i,k,0)+c1*bdrylg(i,k,1)+c2*bdrylg(i,k,2)
-      enddo
-      enddo
+c     A staggered session extrapolates to its first substep
+      theta = 1.
+      if (ifnn_stag) theta = 1./nn_msub
+      call neknek_extrap(theta)
 
       return
       end
@@ -444,6 +431,26 @@ c-----------------------------------------------------------------------
       nv = lx1*ly1*lz1*nelv
       nt = lx1*ly1*lz1*nelt
 
+      if (ifnn_pers) then
+c       Evaluate all fields on the donor side, one message per rank
+        nfld = nfld_neknek
+        call neknek_pack(vx,1,nfld)
+        call neknek_pack(vy,2,nfld)
+        if (ldim.eq.3) call neknek_pack(vz,ldim,nfld)
+        call neknek_pack(pm1,ldim+1,nfld)
+        do i=ldim+2,nfld_neknek
+          call neknek_pack(t(1,1,1,1,i-ldim-1),i,nfld)
+        enddo
+        call neknek_exch(1)
+        do j=1,npoints_nn
+          idx = iList(1,nn_rj(j))
+          do ifld=1,nfld
+            valint(idx,1,1,1,ifld)=nn_rb(ifld+nfld*(j-1))
+          enddo
+        enddo
+        goto 100
+      endif
+
 c     Interpolate using findpts_eval
       call field_eval(fieldout(1,1),1,vx)
       call field_eval(fieldout(1,2),1,vy)
@@ -464,7 +471,7 @@ c     the information will go to the boundary points
         enddo
        enddo
 
-      call nekgsync()
+ 100  call nekgsync()
       etime = dnekclock() - etime1
       tsync = etime1 - etime0
 
@@ -573,6 +580,16 @@ C--------------------------------------------------------------------------
 
 cccc  Exchanges field u between the two neknek sessions and copies it 
 cccc  to ui
+      if (ifnn_pers) then
+        call neknek_pack(u,1,1)
+        call neknek_exch(2)
+        do j=1,npoints_nn
+          ui(iList(1,nn_rj(j)))=nn_rb(j)
+        enddo
+        call neknekgsync()
+        return
+      endif
+
 c     Interpolate using findpts_eval
       call field_eval(fieldout(1,1),1,u)
 cccc
@@ -587,3 +604,327 @@ c     the information will go to the boundary points
       return
       end
 C--------------------------------------------------------------------------
+      subroutine neknek_plan
+c
+c     Static meshes: hand the located interface points to their donor
+c     ranks once and set up persistent send/receive requests, so each
+c     exchange sends all fields in one message per neighbor instead of
+c     one findpts_eval per field. Moving meshes keep findpts_eval.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+      include 'mpif.h'
+
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
+
+      integer ti,ind,key(2),aa(3),cr_nn,cnt
+      integer*8 tl
+      real vr
+      common /nnplan_s/ vr(ldim,nmaxl_nn),ti(3,nmaxl_nn)
+     $                , ind(nmaxl_nn),tl(1)
+
+      integer icalld
+      save    icalld,cr_nn
+      data    icalld /0/
+
+      if (icalld.eq.0) ifnn_pers = .false.
+      if (ifnn_pers) then
+        do j=1,nn_ns+nn_nr
+          call mpi_request_free(nn_req(j,1),ierr)
+          call mpi_request_free(nn_req(j,2),ierr)
+        enddo
+      endif
+      ifnn_pers = .false.
+      if (ifneknekm) return
+
+      if (icalld.eq.0)
+     $  call fgslib_crystal_setup(cr_nn,mpi_comm_world,np_global)
+      icalld = 1
+
+c     send (dest, index, element) and r,s(,t) to the donor ranks
+      do i=1,npoints_nn
+        ti(1,i) = proc(i)
+        ti(2,i) = i
+        ti(3,i) = elid(i)+1
+        do j=1,ldim
+          vr(j,i) = rst(ldim*(i-1)+j)
+        enddo
+      enddo
+      n = npoints_nn
+      call fgslib_crystal_tuple_transfer(cr_nn,n,nmaxl_nn,ti,3,tl,0,
+     $                                   vr,ldim,1)
+      ierr = 0
+      if (n.gt.nmaxl_nn) ierr = 1
+      ierr = ms_iglmax(ierr,1)
+      if (ierr.gt.0) then
+        if (nid.eq.0) write(6,*)
+     $    'neknek: too many donor points, using findpts_eval'
+        return
+      endif
+
+c     donor side, ordered by (receiver, index)
+      key(1) = 1
+      key(2) = 2
+      call ituple_sort(ti,3,n,key,2,ind,aa)
+      nn_nd = n
+      nn_ns = 0
+      do j=1,n
+        nn_de(j) = ti(3,j)
+        do id=1,ldim
+          call fd_weights_full(vr(id,ind(j)),zgm1(1,id),lx1-1,0,
+     $                         nn_dw(1,id,j))
+        enddo
+        if (j.eq.1 .or. ti(1,j).ne.ti(1,max(j-1,1))) then
+          nn_ns = nn_ns+1
+          nn_sp(nn_ns) = ti(1,j)
+          nn_so(nn_ns) = j
+        endif
+      enddo
+      nn_so(nn_ns+1) = n+1
+
+c     receiver side, same order within each donor
+      do i=1,npoints_nn
+        ti(1,i) = proc(i)
+        ti(2,i) = i
+      enddo
+      call ituple_sort(ti,3,npoints_nn,key,2,ind,aa)
+      nn_nr = 0
+      do j=1,npoints_nn
+        nn_rj(j) = ti(2,j)
+        if (j.eq.1 .or. ti(1,j).ne.ti(1,max(j-1,1))) then
+          nn_nr = nn_nr+1
+          nn_rp(nn_nr) = ti(1,j)
+          nn_ro(nn_nr) = j
+        endif
+      enddo
+      nn_ro(nn_nr+1) = npoints_nn+1
+
+      do k=1,2
+        nfld = nfld_neknek
+        if (k.eq.2) nfld = 1
+        do j=1,nn_nr
+          j0  = nfld*(nn_ro(j)-1)+1
+          cnt = nfld*(nn_ro(j+1)-nn_ro(j))
+          call mpi_recv_init(nn_rb(j0),cnt,nekreal,nn_rp(j),k,
+     $                       mpi_comm_world,nn_req(j,k),ierr)
+        enddo
+        do j=1,nn_ns
+          j0  = nfld*(nn_so(j)-1)+1
+          cnt = nfld*(nn_so(j+1)-nn_so(j))
+          call mpi_send_init(nn_sb(j0),cnt,nekreal,nn_sp(j),k,
+     $                       mpi_comm_world,nn_req(nn_nr+j,k),ierr)
+        enddo
+      enddo
+      ifnn_pers = .true.
+
+      nsg = ms_iglmax(nn_ns,1)
+      if (nid.eq.0) write(6,*) idsess,nsg,'neknek persistent exchange'
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_pack(f,ifld,nfld)
+c
+c     Evaluate f at the donor points into slot ifld of the send buffer
+c
+      include 'SIZE'
+      include 'NEKNEK'
+
+      real f(lx1*ly1*lz1,*)
+      real intp_tens
+
+      if (ifld.gt.nfld) return
+      do j=1,nn_nd
+        nn_sb(ifld+nfld*(j-1)) = intp_tens(f(1,nn_de(j)),nn_dw(1,1,j))
+      enddo
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_exch(k)
+c
+c     Run persistent request set k (1: all fields, 2: one field)
+c
+      include 'SIZE'
+      include 'NEKNEK'
+      include 'mpif.h'
+
+      integer status(mpi_status_size,2*nmaxl_nn)
+      save    status
+
+      n = nn_nr+nn_ns
+      if (n.eq.0) return
+      call mpi_startall(n,nn_req(1,k),ierr)
+      call mpi_waitall(n,nn_req(1,k),status,ierr)
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_extrap(theta)
+c
+c     Interface data at theta sync intervals past the last exchange,
+c     extrapolated from the last three exchanges (order NINTER)
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+      n    = lx1*ly1*lz1*nelt
+
+      ist = istep
+      if (ifnn_stag) ist = istep/nn_msub
+
+      if (NINTER.eq.1.or.ist.eq.0) then
+         c0=1.
+         c1=0.
+         c2=0.
+      else if (NINTER.eq.2.or.ist.eq.1) then
+         c0=1.+theta
+         c1=-theta
+         c2=0.
+      else
+         c0=(theta+1.)*(theta+2.)/2.
+         c1=-theta*(theta+2.)
+         c2=theta*(theta+1.)/2.
+      endif
+
+      do k=1,nfld_neknek
+      do i=1,n
+         valint(i,1,1,1,k) = 
+     $      c0*bdrylg(i,k,0)+c1*bdrylg(i,k,1)+c2*bdrylg(i,k,2)
+      enddo
+      enddo
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_stag_setup
+c
+c     Staggered coupling: with param(182) = m > 1 a session takes m
+c     steps per exchange. The sessions agree on the sync interval
+c     dt_sync (min of m*dt over the sessions), so the cheap session
+c     runs a larger dt instead of idling at every step.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+      nn_msub = max(1,int(param(182)))
+      nn_dts  = 0.
+      nn_tbsy = 0.
+      nn_tlst = dnekclock()
+      ifnn_stag = ms_iglmax(nn_msub,1).gt.1
+
+      if (.not.ifnn_stag) return
+
+      if (ifneknekm) call exitti(
+     $  'Staggered neknek needs static meshes! Session:$',idsess)
+      if (ngeom.gt.2) call exitti(
+     $  'Staggered neknek needs ngeom = 2! Session:$',idsess)
+      if (fintim.ne.0) call exitti(
+     $  'Staggered neknek needs numSteps, not endTime! Session:$',
+     $  idsess)
+
+      nsync = nsteps/nn_msub
+      if (mod(nsteps,nn_msub).ne.0) call exitti(
+     $  'numSteps has to be a multiple of nekNekSubSteps:$',nn_msub)
+      nmax  = ms_iglmax(nsync,1)
+      nmin  = ms_iglmin(nsync,1)
+      if (nmax.ne.nmin) call exitti(
+     $  'numSteps/nekNekSubSteps differs between sessions:$',nsync)
+
+      if (nid.eq.0) write(6,*) idsess,nn_msub,nsync,
+     $  'neknek substeps, sync intervals'
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_setdt(dtn)
+c
+c     Common time step: lockstep sessions take the min over sessions,
+c     staggered ones agree on dt_sync at the first substep of each
+c     interval and keep dt_sync/nn_msub for the whole interval
+c
+      include 'SIZE'
+      include 'TSTEP'
+      include 'INPUT'
+      include 'NEKNEK'
+
+      if (.not.(ifneknekc.and.ifnn_stag)) then
+         dtn = ms_glmin(dtn,1)
+         return
+      endif
+
+      if (mod(istep-1,nn_msub).eq.0) then
+         dts    = nn_msub*dtn
+         nn_dts = ms_glmin(dts,1)/nn_msub
+      endif
+      dtn = nn_dts
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_xfer_step
+c
+c     Interface update after a time step: exchange at the end of a sync
+c     interval, extrapolate to the next substep otherwise
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+      if (.not.(ifneknekc.and.ifnn_stag)) then
+         call xfer_bcs_neknek
+         call bcopy
+         call chk_outflow
+         return
+      endif
+
+      j = mod(istep,nn_msub)
+      if (j.eq.0) then
+         nn_tbsy = nn_tbsy + (dnekclock()-nn_tlst)
+         call xfer_bcs_neknek
+         call bcopy
+         nn_tlst = dnekclock()
+         if (mod(istep/nn_msub,100).eq.0) call neknek_cost
+      else
+         theta = real(j+1)/nn_msub
+         call neknek_extrap(theta)
+      endif
+      call chk_outflow
+
+      return
+      end
+c--------------------------------------------------------------------------
+      subroutine neknek_cost
+c
+c     Report the work of each session (rank-seconds between exchanges)
+c     and the rank split that would balance it
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+      real w(0:nsessmax-1),wk(0:nsessmax-1)
+
+      call rzero(w,nsessmax)
+      w(idsess) = nn_tbsy
+
+      call setnekcomm(iglobalcomm)
+      call gop(w,wk,'+  ',nsessmax)
+      call setnekcomm(intracomm)
+
+      wsum = vlsum(w,nsessions)
+      if (nid.eq.0 .and. wsum.gt.0) then
+         do i=0,nsessions-1
+            npi = max(1,nint(np_global*w(i)/wsum))
+            write(6,1) i,npsess(i),w(i)/npsess(i),npi
+         enddo
+      endif
+    1 format(' neknek session',i3,': ranks',i7,', busy',1pe12.4,
+     $       ' s/rank, balanced ranks',i7)
+
+      return
+      end
+c--------------------------------------------------------------------------
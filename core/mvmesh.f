@@ -903,6 +903,7 @@ C
       CALL ADD2 (XM1,UX,NTOT1)
       CALL ADD2 (YM1,UY,NTOT1)
       IF (ldim.EQ.3) CALL ADD2 (ZM1,UZ,NTOT1)
+      geomGen = geomGen + 1
 C
       return
       end
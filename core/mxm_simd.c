@@ -0,0 +1,128 @@
+/*
+ * Small matrix-matrix kernels for x86-64 (SIMD_MXM)
+ *
+ * C(n1,n3) = A(n1,n2) B(n2,n3), column major, double precision.
+ *
+ * One kernel per contraction length n2 = 1..MXS_NMAX is built for
+ * AVX-512 and for AVX2/FMA.  A kernel keeps a row block of all n2
+ * columns of A in registers and streams the columns of B through it;
+ * n1 is covered by blocks of 8, 4, 2 and 1 rows so any n1 and n3 are
+ * valid.  The table matching the CPU is picked on the first call;
+ * ifok = 0 tells the caller to use its generic path instead.
+ *
+ */
+#include <string.h>
+
+#ifdef UPCASE
+#  define FORTRAN_NAME(low,up) up
+#else
+#ifdef UNDERSCORE
+#  define FORTRAN_NAME(low,up) low##_
+#else
+#  define FORTRAN_NAME(low,up) low
+#endif
+#endif
+
+#define mxm_simd FORTRAN_NAME(mxm_simd,MXM_SIMD)
+
+#define MXS_NMAX 24
+
+typedef void (*mxs_kernel)(const double *, int, const double *,
+                           double *, int);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+typedef double v8d __attribute__((vector_size(64)));
+typedef double v4d __attribute__((vector_size(32)));
+typedef double v2d __attribute__((vector_size(16)));
+typedef double v1d;
+
+/* one block of W rows starting at row i */
+#define MXS_BLOCK(VT)                                                     \
+static inline __attribute__((always_inline))                              \
+void blk_##VT(const double *a, int n1, const double *b, const int n2,     \
+              double *c, int n3, int i)                                   \
+{                                                                         \
+  VT av[MXS_NMAX], s;                                                     \
+  int j,k;                                                                \
+  for (k=0; k<n2; k++) memcpy(&av[k],a+i+k*n1,sizeof(VT));                \
+  for (j=0; j<n3; j++) {                                                  \
+    const double *bj = b + j*n2;                                          \
+    s = av[0]*bj[0];                                                      \
+    for (k=1; k<n2; k++) s += av[k]*bj[k];                                \
+    memcpy(c+i+j*n1,&s,sizeof(VT));                                       \
+  }                                                                       \
+}
+
+MXS_BLOCK(v8d)
+MXS_BLOCK(v4d)
+MXS_BLOCK(v2d)
+MXS_BLOCK(v1d)
+
+#define MXS_KERNEL_512(N)                                                 \
+static void __attribute__((target("avx512f,fma")))                        \
+mxs512_##N(const double *a, int n1, const double *b, double *c, int n3)  \
+{                                                                         \
+  int i = 0;                                                              \
+  for (; i+8 <= n1; i += 8) blk_v8d(a,n1,b,N,c,n3,i);                     \
+  if (i+4 <= n1) { blk_v4d(a,n1,b,N,c,n3,i); i += 4; }                    \
+  if (i+2 <= n1) { blk_v2d(a,n1,b,N,c,n3,i); i += 2; }                    \
+  if (i   <  n1)   blk_v1d(a,n1,b,N,c,n3,i);                              \
+}
+
+#define MXS_KERNEL_256(N)                                                 \
+static void __attribute__((target("avx2,fma")))                           \
+mxs256_##N(const double *a, int n1, const double *b, double *c, int n3)  \
+{                                                                         \
+  int i = 0;                                                              \
+  for (; i+4 <= n1; i += 4) blk_v4d(a,n1,b,N,c,n3,i);                     \
+  if (i+2 <= n1) { blk_v2d(a,n1,b,N,c,n3,i); i += 2; }                    \
+  if (i   <  n1)   blk_v1d(a,n1,b,N,c,n3,i);                              \
+}
+
+#define MXS_ALL(K) \
+  K(1)  K(2)  K(3)  K(4)  K(5)  K(6)  K(7)  K(8)  \
+  K(9)  K(10) K(11) K(12) K(13) K(14) K(15) K(16) \
+  K(17) K(18) K(19) K(20) K(21) K(22) K(23) K(24)
+
+MXS_ALL(MXS_KERNEL_512)
+MXS_ALL(MXS_KERNEL_256)
+
+#define MXS_ENTRY_512(N) mxs512_##N,
+#define MXS_ENTRY_256(N) mxs256_##N,
+
+static const mxs_kernel tab512[MXS_NMAX+1] = { 0, MXS_ALL(MXS_ENTRY_512) };
+static const mxs_kernel tab256[MXS_NMAX+1] = { 0, MXS_ALL(MXS_ENTRY_256) };
+
+static const mxs_kernel *mxs_select()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return tab512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return tab256;
+  return NULL;
+}
+
+#else
+
+static const mxs_kernel *mxs_select() { return NULL; }
+
+#endif
+
+static const mxs_kernel *mxs_tab = NULL;
+static int mxs_init = 0;
+
+void mxm_simd(const double *a, const int *n1, const double *b,
+              const int *n2, double *c, const int *n3, int *ifok)
+{
+  if (!mxs_init) {
+    mxs_tab  = mxs_select();
+    mxs_init = 1;
+  }
+  if (!mxs_tab || *n2 < 1 || *n2 > MXS_NMAX) {
+    *ifok = 0;
+    return;
+  }
+  mxs_tab[*n2](a,*n1,b,c,*n3);
+  *ifok = 1;
+}
@@ -12,21 +12,13 @@ c
 c
       integer*8 tt
 
-#ifdef TIMER2
-      if (isclld.eq.0) then
-          isclld=1
-          nrout=nrout+1
-          myrout=nrout
-          rname(myrout) = 'mxm   '
+#ifdef SIMD_MXM
+      if (wdsize.eq.8) then
+         call mxm_simd(a,n1,b,n2,c,n3,ifok)
+         if (ifok.ne.0) goto 111
       endif
-      isbcnt = n1*n3*(2*n2-1)
-      dct(myrout) = dct(myrout) + (isbcnt)
-      ncall(myrout) = ncall(myrout) + 1
-      dcount = dcount + (isbcnt)
-      etime1 = dnekclock()
 #endif
 
-
 #ifdef BGQ
       if (n2 .eq. 8 .and. mod(n1,4) .eq. 0 
 c        .and. MOD(LOC(a),tt).eq.0 & 
@@ -80,9 +72,6 @@ c        .and. MOD(LOC(c),tt).eq.0 &
  101  call mxmf2(a,n1,b,n2,c,n3)
 
  111  continue
-#ifdef TIMER2
-      tmxmf = tmxmf + dnekclock() - etime1  
-#endif
       return
       end
 c-----------------------------------------------------------------------
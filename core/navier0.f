@@ -28,6 +28,7 @@ C
       etime1=dnekclock()
 
 c     write(6,*) solver_type,' solver type',iesolv
+      call nek_comm_push('pres')
       if (iesolv.eq.1) then
          if (solver_type.eq.'fdm') then
             ntot2 = lx2*ly2*lz2*nelv
@@ -46,6 +47,7 @@ c     write(6,*) solver_type,' solver type',iesolv
          WRITE(6,*) 'Stop in ESOLVER'
          CALL EXITT
       ENDIF
+      call nek_comm_pop()
 
       teslv=teslv+(dnekclock()-etime1)
 
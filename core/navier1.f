@@ -281,6 +281,13 @@ C
      $ ,             TB2 (LX1,LY1,LZ1,LELV)
      $ ,             TB3 (LX1,LY1,LZ1,LELV)
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('cdabdtp',itmr)
+      call nek_timer_push(itmr)
+
       call opgradt (ta1,ta2,ta3,wp)
       if ((intype.eq.0).or.(intype.eq.-1)) then
          tolhin=tolhs
@@ -295,6 +302,7 @@ C
       endif
       call opdiv  (ap,tb1,tb2,tb3)
 
+      call nek_timer_pop(itmr)
       return
       end
 C
@@ -3166,9 +3174,16 @@ C
       REAL    CONV (LX1,LY1,LZ1,1) 
       REAL    FI   (LX1,LY1,LZ1,1)
 
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
       if (nio.eq.0.and.loglevel.gt.2)
      $   write(6,*) 'convop', ifield, ifdeal(ifield)
 
+      if (itmr.eq.0) call nek_timer_id('convop',itmr)
+      call nek_timer_push(itmr)
+
 #ifdef TIMER
       if (icalld.eq.0) tadvc=0.0
       icalld=icalld+1
@@ -3210,6 +3225,7 @@ C
       endif
 
  100  continue
+      call nek_timer_pop(itmr)
 
 #ifdef TIMER
       tadvc=tadvc+(dnekclock()-etime1)
@@ -3303,6 +3319,7 @@ C
 C
 C     Compute vel.grad(u)
 C
+c$omp parallel do private(ie,iz,i,/ctmp0/)
       do ie=1,nel
 C
         if (if3d) then
@@ -327,6 +327,10 @@ C
       REAL DT
 C
       include 'OPCTR'
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
 C
 #ifdef TIMER
 C
@@ -343,6 +347,11 @@ C
 #endif
 C
       DT = 0.0
+#ifdef OPENACC
+      ifdev = nek_acc_dev(x)
+#endif
+c$acc parallel loop default(present) reduction(+:dt) if(ifdev)
+c$acc& private(t)
       DO 10 I=1,N
          T = X(I)*Y(I)*B(I)
          DT = DT+T
@@ -605,11 +614,15 @@ c
       if (p945.eq.0)              ifstdh = .true.
       if (istep.lt.p945)          ifstdh = .true.
 
+      n = lx1*ly1*lz1*nelfld(ifield)
+#ifdef OPENACC
+      call nek_acc_begin(u,r,h1,h2,vmk,vml,bi,n,name)
+#endif
+
       if (ifstdh) then
          call hmholtz(name,u,r,h1,h2,vmk,vml,imsh,tol,maxit,isd)
       else
 
-         n = lx1*ly1*lz1*nelfld(ifield)
 
          call col2   (r,vmk,n)
          call dssum  (r,lx1,ly1,lz1)
@@ -628,6 +641,9 @@ c
      $       (u,n,approx,napprox,h1,h2,vmk,vml,ifwt,ifvec,name6)
 
       endif
+#ifdef OPENACC
+      call nek_acc_end(u,r,h1,h2,vmk,vml,bi,n)
+#endif
 
       return
       end
@@ -667,15 +683,21 @@ c     work.   The idea is to retain fresh vectors by injecting the most
 c     recent solution and pushing the oldest off the stack, hopefully 
 c     keeping the number of vectors, m, small.
 
+c     With param(181) > 0 X and B are stored in single precision (twice
+c     as many vectors in the same space, half the memory traffic); dot
+c     products still accumulate in double and bbar is recomputed as
+c     A*xbar, so the projected rhs stays exact.
+
 
       include 'SIZE'   ! For nid/nio
       include 'TSTEP'  ! For istep
+      include 'INPUT'  ! For param
       include 'CTIMER'
 
       real b(n),rvar(n,1),h1(n),h2(n),w(n),msk(n)
       integer ivar(1)
       character*6 name6
-      logical ifwt,ifvec
+      logical ifwt,ifvec,ifsp
 
       etime0 = dnekclock() 
 
@@ -697,17 +719,26 @@ c     Re-orthogonalize basis set w.r.t. new vectors if space has changed.
 
       if (ireset.eq.1) then
 
+         ifsp = param(181).gt.0
          do j=0,m-1         ! First, set B := A*X
             jb = ib+j*nn    !Iterate through xs and bs
             jx = ix+j*nn
-            call proj_matvec (rvar(jb,1),rvar(jx,1),n,h1,h2,msk,name6)
+            if (ifsp) then  ! via xbar/bbar, free until project1_a
+               call proj_colget(rvar(ixb,1),rvar(ix,1),j+1,nn,ifsp)
+               call proj_matvec
+     $            (rvar(ibb,1),rvar(ixb,1),n,h1,h2,msk,name6)
+               call proj_colput(rvar(ib,1),j+1,rvar(ibb,1),nn,ifsp)
+            else
+               call proj_matvec
+     $            (rvar(jb,1),rvar(jx,1),n,h1,h2,msk,name6)
+            endif
          enddo
 
          if (nio.eq.0 .and. loglevel.gt.2) 
      $      write(6,'(13x,A)') 'Reorthogonalize Basis'
 
-         call proj_ortho_full
-     $      (rvar(ix,1),rvar(ib,1),n,m,w,ifwt,ifvec,name6)      
+         call proj_ortho_full(rvar(ix,1),rvar(ib,1),rvar(ixb,1)
+     $      ,rvar(ibb,1),n,m,w,ifwt,ifvec,name6)
 
          ivar(2) = m ! Update number of saved vectors
 
@@ -716,7 +747,7 @@ c     Re-orthogonalize basis set w.r.t. new vectors if space has changed.
 c     ixb is pointer to xbar,  ibb is pointer to bbar := A*xbar
 
       call project1_a(rvar(ixb,1),rvar(ibb,1),b,rvar(ix,1),rvar(ib,1)
-     $               ,n,m,w,ifwt,ifvec)
+     $               ,n,m,w,ifwt,ifvec,h1,h2,msk,name6)
 
       baf = glsc3(b,w,b,n)
       baf = sqrt(baf)
@@ -731,7 +762,8 @@ c     ixb is pointer to xbar,  ibb is pointer to bbar := A*xbar
       return
       end
 c-----------------------------------------------------------------------
-      subroutine project1_a(xbar,bbar,b,xx,bb,n,m,w,ifwt,ifvec)
+      subroutine project1_a(xbar,bbar,b,xx,bb,n,m,w,ifwt,ifvec
+     $                     ,h1,h2,msk,name6)
 
 c     xbar is best fit in xx, bbar = A*xbar
 c     b <-- b - bbar
@@ -740,49 +772,34 @@ c     b <-- b - bbar
       include 'TSTEP'
       include 'INPUT'
       include 'PARALLEL'
-      parameter(lt=lx1*ly1*lz1*lelv)
-      real xbar(n),bbar(n),b(n),xx(n,m),bb(n,m),w(n)
-      logical ifwt,ifvec
-      integer e,eg
-      parameter(lxyz=lx1*ly1*lz1)
-      real tt(lxyz,lelt)
+      real xbar(n),bbar(n),b(n),xx(1),bb(1),w(n)
+      real h1(n),h2(n),msk(n)
+      character*6 name6
+      logical ifwt,ifvec,ifsp
 
       real work(mxprev),alpha(mxprev)
 
       if (m.le.0) return
 
-      !First round of CGS
-      do k = 1, m 
-         if(ifwt) then
-            alpha(k) = vlsc3(xx(1,k),w,b,n)
-         else
-            alpha(k) = vlsc2(xx(1,k),b,n)
-         endif
-      enddo
-      !First one outside loop to avoid zeroing xbar and bbar
-      call gop(alpha,work,'+  ',m)
-      call cmult2(xbar,xx(1,1),alpha(1),n)
-      call cmult2(bbar,bb(1,1),alpha(1),n)
-      call add2s2(b,bb(1,1),-alpha(1),n)
-      do k = 2,m
-         call add2s2(xbar,xx(1,k),alpha(k),n)
-         call add2s2(bbar,bb(1,k),alpha(k),n)
-         call add2s2(b,bb(1,k),-alpha(k),n)
-      enddo
-      !Second round of CGS
-      do k = 1, m
-         if(ifwt) then
-            alpha(k) = vlsc3(xx(1,k),w,b,n)
-         else
-            alpha(k) = vlsc2(xx(1,k),b,n)
-         endif
+      ifsp = param(181).gt.0
+      if (ifsp) call copy(bbar,b,n) ! keep b for b - A*xbar below
+
+      call rzero(xbar,n)
+      if (.not.ifsp) call rzero(bbar,n)
+
+      do i = 1,2 ! Two rounds of CGS, one reduction each
+         call proj_mdot(alpha,xx,1,m,b,w,n,ifwt,ifsp)
+         call gop(alpha,work,'+  ',m)
+         call proj_maxpy(xbar,xx,1,m,alpha, 1.,n,ifsp)
+         if (.not.ifsp) call proj_maxpy(bbar,bb,1,m,alpha, 1.,n,ifsp)
+         call proj_maxpy(b   ,bb,1,m,alpha,-1.,n,ifsp)
       enddo
-      call gop(alpha,work,'+  ',m) 
-      do k = 1,m
-         call add2s2(xbar,xx(1,k),alpha(k),n)
-         call add2s2(bbar,bb(1,k),alpha(k),n)
-         call add2s2(b,bb(1,k),-alpha(k),n)
-      enddo 
+
+      if (ifsp) then ! b = b - A*xbar, exact in spite of single B
+         call copy       (b,bbar,n)
+         call proj_matvec(bbar,xbar,n,h1,h2,msk,name6)
+         call sub2       (b,bbar,n)
+      endif
 
       return
       end
@@ -793,6 +810,11 @@ c-----------------------------------------------------------------------
 
 c     Matrix has changed if h1/h2 differ from old values
 
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
       real h1(n),h2(n),h1old(n),h2old(n)
 
       iproj_chk = 0
@@ -804,6 +826,10 @@ c     Matrix has changed if h1/h2 differ from old values
 
       dh1 = 0.
       dh2 = 0.
+#ifdef OPENACC
+      ifdev = nek_acc_dev(h1old)
+#endif
+c$acc parallel loop default(present) reduction(max:dh1,dh2) if(ifdev)
       do i=1,n
          dh1 = max(dh1,abs(h1(i)-h1old(i)))
          dh2 = max(dh2,abs(h2(i)-h2old(i)))
@@ -848,78 +874,80 @@ c     string "name6"
 c-----------------------------------------------------------------------
       !O(nm) method for updating projection space
       !See James Lotte's note or Nicholas Christensen's master's thesis
-      subroutine proj_ortho(xx,bb,n,m,w,ifwt,ifvec,name6)
+      !New vector xw, bw=A*xw (overwritten) becomes column m
+      subroutine proj_ortho(xx,bb,xw,bw,n,m,w,ifwt,ifvec,name6)
 
       include 'SIZE'      ! nio
       include 'TSTEP'     ! istep
+      include 'INPUT'     ! param
       include 'PARALLEL'  ! wdsize
 
-      real xx(n,1), bb(n,1), w(n)
+      real xx(1), bb(1), xw(n), bw(n), w(n)
       character*6 name6
-      logical ifwt, ifvec
-      real tol, nrm, scl1, scl2, c, s
+      logical ifwt, ifvec, ifsp
+      real tol, nrm, scl1, c, s
       real work(mxprev), alpha(mxprev), beta(mxprev)
       integer h
+      integer itmr
+      save    itmr
+      data    itmr /0/
 
       if(m.le.0) return !No vectors to ortho-normalize 
+      if (itmr.eq.0) call nek_timer_id('proj_ortho',itmr)
+      call nek_timer_push(itmr)
+      call nek_comm_push('proj')
+
+      ifsp = param(181).gt.0
 
       ! AX = B
       ! Calculate dx, db: dx = x-XX^Tb, db=b-BX^Tb     
          
-      do k = 1, m !First round CGS
-         if(ifwt) then
-            alpha(k) = 0.5*(vlsc3(xx(1,k),w,bb(1,m),n)
-     $                 +    vlsc3(bb(1,k),w,xx(1,m),n))
-         else
-            alpha(k) = 0.5*(vlsc2(xx(1,k),bb(1,m),n)
-     $                 +    vlsc2(bb(1,k),xx(1,m),n))
-         endif
-      enddo
+      !First round CGS
+      call proj_msdot(alpha,sd,xx,bb,1,m-1,xw,bw,w,n,ifwt,ifsp)
+      alpha(m) = sd
       call gop(alpha,work,'+  ',m)
       nrm = sqrt(alpha(m)) !Calculate A-norm of new vector
-      do k = 1,m-1
-         call add2s2(xx(1,m),xx(1,k),-alpha(k),n)
-         call add2s2(bb(1,m),bb(1,k),-alpha(k),n)
-      enddo
+      call proj_maxpy(xw,xx,1,m-1,alpha,-1.,n,ifsp)
+      call proj_maxpy(bw,bb,1,m-1,alpha,-1.,n,ifsp)
       
-      do k = 1, m-1 !Second round CGS
-         if(ifwt) then
-            beta(k) = 0.5*(vlsc3(xx(1,k),w,bb(1,m),n)
-     $                 +   vlsc3(bb(1,k),w,xx(1,m),n))
-         else
-            beta(k) = 0.5*(vlsc2(xx(1,k),bb(1,m),n)
-     $                 +   vlsc2(bb(1,k),xx(1,m),n))
-         endif
-      enddo
-      call gop(beta,work,'+  ',m-1)
+      !Second round CGS, also yields the A-norm of dx
+      call proj_msdot(beta,sd,xx,bb,1,m-1,xw,bw,w,n,ifwt,ifsp)
+      beta(m) = sd
+      call gop(beta,work,'+  ',m)
+      call proj_maxpy(xw,xx,1,m-1,beta,-1.,n,ifsp)
+      call proj_maxpy(bw,bb,1,m-1,beta,-1.,n,ifsp)
+      alpha(m) = beta(m)
       do k = 1,m-1
-         call add2s2(xx(1,m),xx(1,k),-beta(k),n)
-         call add2s2(bb(1,m),bb(1,k),-beta(k),n)
-         !While we're at it,
          !Sum weights from each round to get the total alpha
          alpha(k) = alpha(k) + beta(k)
+         alpha(m) = alpha(m) - beta(k)**2
       enddo
 
-      !Calculate A-norm of newest solution
-      if(ifwt) then
-        alpha(m) = glsc3(xx(1,m), w, bb(1,m), n) 
-      else
-        alpha(m) = glsc2(xx(1,m), bb(1,m), n) 
+      !A-norm of newest solution, (dx,db) = (x,b) - sum beta^2 unless
+      !that has cancelled
+      if (alpha(m).lt.1.e-4*beta(m)) then
+         if(ifwt) then
+           alpha(m) = glsc3(xw, w, bw, n) 
+         else
+           alpha(m) = glsc2(xw, bw, n) 
+         endif
       endif
-      alpha(m) = sqrt(alpha(m))
-      !dx and db now stored in last column of xx and bb
+      alpha(m) = sqrt(max(alpha(m),0.))
+      !dx and db now stored in xw and bw
 
 c     Set tolerance for linear independence
       tol = 1.e-7
-      if (wdsize.eq.4) tol=1.e-3
+      if (wdsize.eq.4 .or. ifsp) tol=1.e-3
 
 c     Check for linear independence.
       if(alpha(m).gt.tol*nrm) then !New vector is linearly independent    
        
-         !Normalize dx and db
+         !Normalize dx and db, store as column m
          scl1 = 1.0/alpha(m) 
-         call cmult(xx(1,m), scl1, n)   
-         call cmult(bb(1,m), scl1, n)   
+         call cmult(xw, scl1, n)   
+         call cmult(bw, scl1, n)   
+         call proj_colput(xx,m,xw,n,ifsp)
+         call proj_colput(bb,m,bw,n,ifsp)
 
          !We want to throw away the oldest information
          !The below propagates newest information to first vector.
@@ -929,14 +957,7 @@ c     Check for linear independence.
             h = k - 1   
             call givens_rotation(alpha(h),alpha(k),c,s,nrm)
             alpha(h) = nrm     
-            do i = 1, n !Apply rotation to xx and bb
-               scl1 = c*xx(i,h) + s*xx(i,k)
-               xx(i,k) = -s*xx(i,h) + c*xx(i,k)
-               xx(i,h) = scl1       
-               scl2 = c*bb(i,h) + s*bb(i,k)
-               bb(i,k) = -s*bb(i,h) + c*bb(i,k)    
-               bb(i,h) = scl2        
-            enddo
+            call proj_rot(xx,bb,h,k,c,s,n,ifsp) !Apply rotation
          enddo
 
       else !New vector is not linearly independent, forget about it
@@ -950,22 +971,26 @@ c     Check for linear independence.
          
          m = m - 1 !Remove column
       endif   
+      call nek_comm_pop()
+      call nek_timer_pop(itmr)
 
       return
       end      
 c-----------------------------------------------------------------------
       !Function to switch between mgs and cgs2 full reorthogonalization
-      subroutine proj_ortho_full(xx,bb,n,m,w,ifwt,ifvec,name6)
+      !xk, bk are work vectors of length n
+      subroutine proj_ortho_full(xx,bb,xk,bk,n,m,w,ifwt,ifvec,name6)
 
       include 'SIZE'
 
-      real xx(n,1),bb(n,1),w(n)
+      real xx(1),bb(1),xk(n),bk(n),w(n)
       character*6 name6
       logical ifwt,ifvec
       integer flag(mxprev)
  
+      !MGS only for double precision X,B (param(181) = 0)
       !call proj_ortho_full_mgs(xx,bb,n,m,w,ifwt,ifvec,name6)
-      call proj_ortho_full_cgs2(xx,bb,n,m,w,ifwt,ifvec,name6)
+      call proj_ortho_full_cgs2(xx,bb,xk,bk,n,m,w,ifwt,ifvec,name6)
      
       return
       end      
@@ -1056,56 +1081,65 @@ c     $           ,1p2e12.4)
 c-----------------------------------------------------------------------
       !CGS2 version of full reorthogonalization, possibly more stable in
       !certain instances. Much faster for large m.
-      subroutine proj_ortho_full_cgs2(xx,bb,n,m,w,ifwt,ifvec,name6)
+      !One reduction per column: the multi-dot against the columns
+      !k+1..m and (x_k,b_k) go together, the new norm follows from
+      !(x_k,b_k) - sum alpha^2 unless that has cancelled.
+      subroutine proj_ortho_full_cgs2(xx,bb,xk,bk,n,m,w,ifwt,ifvec
+     $                               ,name6)
 
       include 'SIZE'      ! nio
       include 'TSTEP'     ! istep
+      include 'INPUT'     ! param
       include 'PARALLEL'  ! wdsize
             
-      real xx(n,1),bb(n,1),w(n)
+      real xx(1),bb(1),xk(n),bk(n),w(n)
       character*6 name6
-      logical ifwt,ifvec
+      logical ifwt,ifvec,ifsp
       integer flag(mxprev)
       real normk,normp,alpha(mxprev),work(mxprev),scl1,tol
 
       if (m.le.0) return
 
+      ifsp = param(181).gt.0
+
       tol = 1.e-7
-      if (wdsize.eq.4) tol=1.e-3
+      if (wdsize.eq.4 .or. ifsp) tol=1.e-3
 
       do i = 1, 2 !Do this twice for CGS2
 
       do k = m, 1, -1
-         do j = m, k, -1
-            alpha(j) = 0.0
-            if(ifwt) then
-                  alpha(j) = .5*(vlsc3(xx(1,j),w,bb(1,k),n)
-     $                       +     vlsc3(bb(1,j),w,xx(1,k),n))
-            else
-                  alpha(j) = .5*(vlsc2(xx(1,j),bb(1,k),n)
-     $                       +     vlsc2(bb(1,j),xx(1,k),n))
-            endif
-         enddo
+         call proj_colget(xk,xx,k,n,ifsp)
+         call proj_colget(bk,bb,k,n,ifsp)
+         call proj_msdot(alpha,sd,xx,bb,k+1,m,xk,bk,w,n,ifwt,ifsp)
+         alpha(k) = sd
          call gop(alpha(k), work,'+  ',(m - k) + 1)
+         normp = alpha(k)
+         normk = alpha(k)
          do j = m, k+1, -1
-            call add2s2(xx(1,k),xx(1,j),-alpha(j),n)
-            call add2s2(bb(1,k),bb(1,j),-alpha(j),n)
+            if (flag(j).eq.0) alpha(j) = 0. ! not part of the basis
+            normk = normk - alpha(j)**2
          enddo
-         normp = sqrt(alpha(k))
-         if(ifwt) then
-            normk = glsc3(xx(1,k),w,bb(1,k),n)
-         else
-            normk = glsc2(xx(1,k),bb(1,k),n)
+         call proj_maxpy(xk,xx,k+1,m,alpha,-1.,n,ifsp)
+         call proj_maxpy(bk,bb,k+1,m,alpha,-1.,n,ifsp)
+         normp = sqrt(normp)
+         if (normk.lt.1.e-4*alpha(k)) then
+            if(ifwt) then
+               normk = glsc3(xk,w,bk,n)
+            else
+               normk = glsc2(xk,bk,n)
+            endif
          endif
-         normk = sqrt(normk)
+         normk = sqrt(max(normk,0.))
          if(normk.gt.tol*normp) then
             scl1 = 1.0/normk
-            call cmult(xx(1,k), scl1, n)
-            call cmult(bb(1,k), scl1, n)
+            call cmult(xk, scl1, n)
+            call cmult(bk, scl1, n)
             flag(k) = 1
          else
             flag(k) = 0
          endif
+         call proj_colput(xx,k,xk,n,ifsp)
+         call proj_colput(bb,k,bk,n,ifsp)
       enddo
 
       enddo
@@ -1115,8 +1149,10 @@ c-----------------------------------------------------------------------
          if (flag(j).eq.1) then
             k=k+1
             if (k.lt.j) then
-               call copy(xx(1,k),xx(1,j),n)
-               call copy(bb(1,k),bb(1,j),n)
+               call proj_colget(xk,xx,j,n,ifsp)
+               call proj_colput(xx,k,xk,n,ifsp)
+               call proj_colget(bk,bb,j,n,ifsp)
+               call proj_colput(bb,k,bk,n,ifsp)
             endif
          endif
       enddo
@@ -1142,7 +1178,7 @@ c-----------------------------------------------------------------------
 c     ix  is pointer to X,     ib  is pointer to B
 c     ixb is pointer to xbar,  ibb is pointer to bbar := A*xbar
 
-      call project2_a(x,rvar(ixb,1),rvar(ix,1),rvar(ib,1)
+      call project2_a(x,rvar(ixb,1),rvar(ibb,1),rvar(ix,1),rvar(ib,1)
      $              ,n,m,mmx,h1,h2,msk,w,ifwt,ifvec,name6)
 
       ivar(2) = m ! Update number of saved vectors
@@ -1153,9 +1189,9 @@ c     ixb is pointer to xbar,  ibb is pointer to bbar := A*xbar
       end
 c-----------------------------------------------------------------------
       subroutine project2_a
-     $      (x,xbar,xx,bb,n,m,mmx,h1,h2,msk,w,ifwt,ifvec,name6)
+     $      (x,xbar,bbar,xx,bb,n,m,mmx,h1,h2,msk,w,ifwt,ifvec,name6)
 
-      real x(n),xbar(n),xx(n,1),bb(n,1),h1(n),h2(n),w(n),msk(n)
+      real x(n),xbar(n),bbar(n),xx(1),bb(1),h1(n),h2(n),w(n),msk(n)
       character*6 name6
       logical ifwt,ifvec
 
@@ -1174,11 +1210,13 @@ c      endif
 
       m = min(m+1,mmx)
       !print *, "m", m
-      call copy        (xx(1,m),x,nn)   ! Update (X,B)
-      call proj_matvec (bb(1,m),xx(1,m),n,h1,h2,msk,name6)
-      call proj_ortho  (xx,bb,n,m,w,ifwt,ifvec,name6) !Update orthogonalization
+      call copy        (xbar,x,nn)      ! Update (X,B), xbar/bbar
+      call proj_matvec (bbar,xbar,n,h1,h2,msk,name6) ! as work vectors
+      call proj_ortho  (xx,bb,xbar,bbar,n,m,w,ifwt,ifvec,name6) !Update
       !Uncomment the if block above if using full reorthogonalization
-c      call proj_ortho_full  (xx,bb,n,m,w,ifwt,ifvec,name6) !Fully reorthogonalize
+c      call proj_colput(xx,m,x,nn,param(181).gt.0)
+c      call proj_colput(bb,m,bbar,nn,param(181).gt.0)
+c      call proj_ortho_full  (xx,bb,xbar,bbar,n,m,w,ifwt,ifvec,name6) !Fully reorthogonalize
 
       return
       end
@@ -1188,6 +1226,7 @@ c-----------------------------------------------------------------------
 
       include 'SIZE'
       include 'TSTEP'
+      include 'INPUT'
 
       logical ifvec
       character*6 name6
@@ -1200,6 +1239,7 @@ c-----------------------------------------------------------------------
 
       m    = ivar(2)
       mmx  = (mxprev-4)/2 ! ivar=0 --> mxprev array
+      if (param(181).gt.0) mmx = mxprev-4 ! X, B in single precision
       ivar(1) = mmx
 
       nn = n
@@ -1212,6 +1252,461 @@ c-----------------------------------------------------------------------
       ibb  = ixb + nn     !    "    to bbar
       ix   = ibb + nn     !    "    to X
       ib   = ix  + nn*mmx !    "    to B
+      if (param(181).gt.0) ib = ix + (nn*mmx+1)/2
+
+      return
+      end
+c-----------------------------------------------------------------------
+c
+c     Kernels on the columns of the projection space X, B (xx, bb).
+c     The columns are real*4 if ifsp (param(181) > 0), else real;
+c     the real*4 kernels see them through the ws4 view (WSPACE).
+c     All sums are accumulated in real.  Multi-column kernels sweep
+c     four columns per pass over the n-vectors.
+c
+c-----------------------------------------------------------------------
+      subroutine proj_mdot(a,xx,k1,k2,y,w,n,ifwt,ifsp)
+
+c     a(k) = (x_k,y), k = k1,...,k2, local sums
+
+      include 'WSPACE'
+
+      real a(1),xx(1),y(n),w(n)
+      logical ifwt,ifsp
+      integer*8 kx
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         call proj_mdot4(a,ws4(kx),k1,k2,y,w,n,ifwt)
+      else
+         call proj_mdot8(a,xx,k1,k2,y,w,n,ifwt)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_msdot(a,sd,xx,bb,k1,k2,xw,bw,w,n,ifwt,ifsp)
+
+c     a(k) = ((x_k,bw) + (b_k,xw))/2, k = k1,...,k2, and sd = (xw,bw),
+c     local sums
+
+      include 'WSPACE'
+
+      real a(1),xx(1),bb(1),xw(n),bw(n),w(n)
+      logical ifwt,ifsp
+      integer*8 kx,kb
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         kb = nek_ws_loc4(bb)
+         call proj_msdot4(a,ws4(kx),ws4(kb),k1,k2,xw,bw,w,n,ifwt)
+      else
+         call proj_msdot8(a,xx,bb,k1,k2,xw,bw,w,n,ifwt)
+      endif
+      if (ifwt) then
+         sd = vlsc3(xw,w,bw,n)
+      else
+         sd = vlsc2(xw,bw,n)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_maxpy(y,xx,k1,k2,a,sc,n,ifsp)
+
+c     y = y + sc * sum a(k) x_k, k = k1,...,k2
+
+      include 'WSPACE'
+
+      real y(n),xx(1),a(1)
+      logical ifsp
+      integer*8 kx
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         call proj_maxpy4(y,ws4(kx),k1,k2,a,sc,n)
+      else
+         call proj_maxpy8(y,xx,k1,k2,a,sc,n)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_rot(xx,bb,h,k,c,s,n,ifsp)
+
+c     Givens rotation of the columns h, k of xx and bb
+
+      include 'WSPACE'
+
+      real xx(1),bb(1)
+      integer h
+      logical ifsp
+      integer*8 kx,kb
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         kb = nek_ws_loc4(bb)
+         call proj_rot4(ws4(kx),ws4(kb),h,k,c,s,n)
+      else
+         call proj_rot8(xx,bb,h,k,c,s,n)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_colget(y,xx,k,n,ifsp)
+
+c     y = x_k
+
+      include 'WSPACE'
+
+      real y(n),xx(1)
+      logical ifsp
+      integer*8 kx
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         call proj_colget4(y,ws4(kx),k,n)
+      else
+         call copy(y,xx(1+(k-1)*n),n)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_colput(xx,k,y,n,ifsp)
+
+c     x_k = y
+
+      include 'WSPACE'
+
+      real xx(1),y(n)
+      logical ifsp
+      integer*8 kx
+
+      if (ifsp) then
+         kx = nek_ws_loc4(xx)
+         call proj_colput4(ws4(kx),k,y,n)
+      else
+         call copy(xx(1+(k-1)*n),y,n)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_mdot8(a,xx,k1,k2,y,w,n,ifwt)
+
+      real a(1),xx(n,1),y(n),w(n)
+      logical ifwt
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2) ! repeat the last column in a short block
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         s1 = 0.
+         s2 = 0.
+         s3 = 0.
+         s4 = 0.
+c$acc parallel loop default(present) reduction(+:s1,s2,s3,s4) if(ifdev)
+c$acc& private(t)
+         do i=1,n
+            t = y(i)
+            if (ifwt) t = t*w(i)
+            s1 = s1 + t*xx(i,k)
+            s2 = s2 + t*xx(i,k2b)
+            s3 = s3 + t*xx(i,k3b)
+            s4 = s4 + t*xx(i,k4b)
+         enddo
+         a(k)   = s1
+         a(k2b) = s2
+         a(k3b) = s3
+         a(k4b) = s4
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_mdot4(a,xx,k1,k2,y,w,n,ifwt)
+
+      real a(1),y(n),w(n)
+      real*4 xx(n,1)
+      logical ifwt
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2)
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         s1 = 0.
+         s2 = 0.
+         s3 = 0.
+         s4 = 0.
+c$acc parallel loop default(present) reduction(+:s1,s2,s3,s4) if(ifdev)
+c$acc& private(t)
+         do i=1,n
+            t = y(i)
+            if (ifwt) t = t*w(i)
+            s1 = s1 + t*xx(i,k)
+            s2 = s2 + t*xx(i,k2b)
+            s3 = s3 + t*xx(i,k3b)
+            s4 = s4 + t*xx(i,k4b)
+         enddo
+         a(k)   = s1
+         a(k2b) = s2
+         a(k3b) = s3
+         a(k4b) = s4
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_msdot8(a,xx,bb,k1,k2,xw,bw,w,n,ifwt)
+
+      real a(1),xx(n,1),bb(n,1),xw(n),bw(n),w(n)
+      logical ifwt
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(xw)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2)
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         s1 = 0.
+         s2 = 0.
+         s3 = 0.
+         s4 = 0.
+c$acc parallel loop default(present) reduction(+:s1,s2,s3,s4) if(ifdev)
+c$acc& private(tx,tb)
+         do i=1,n
+            tx = xw(i)
+            tb = bw(i)
+            if (ifwt) tx = tx*w(i)
+            if (ifwt) tb = tb*w(i)
+            s1 = s1 + tb*xx(i,k)   + tx*bb(i,k)
+            s2 = s2 + tb*xx(i,k2b) + tx*bb(i,k2b)
+            s3 = s3 + tb*xx(i,k3b) + tx*bb(i,k3b)
+            s4 = s4 + tb*xx(i,k4b) + tx*bb(i,k4b)
+         enddo
+         a(k)   = .5*s1
+         a(k2b) = .5*s2
+         a(k3b) = .5*s3
+         a(k4b) = .5*s4
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_msdot4(a,xx,bb,k1,k2,xw,bw,w,n,ifwt)
+
+      real a(1),xw(n),bw(n),w(n)
+      real*4 xx(n,1),bb(n,1)
+      logical ifwt
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(xw)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2)
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         s1 = 0.
+         s2 = 0.
+         s3 = 0.
+         s4 = 0.
+c$acc parallel loop default(present) reduction(+:s1,s2,s3,s4) if(ifdev)
+c$acc& private(tx,tb)
+         do i=1,n
+            tx = xw(i)
+            tb = bw(i)
+            if (ifwt) tx = tx*w(i)
+            if (ifwt) tb = tb*w(i)
+            s1 = s1 + tb*xx(i,k)   + tx*bb(i,k)
+            s2 = s2 + tb*xx(i,k2b) + tx*bb(i,k2b)
+            s3 = s3 + tb*xx(i,k3b) + tx*bb(i,k3b)
+            s4 = s4 + tb*xx(i,k4b) + tx*bb(i,k4b)
+         enddo
+         a(k)   = .5*s1
+         a(k2b) = .5*s2
+         a(k3b) = .5*s3
+         a(k4b) = .5*s4
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_maxpy8(y,xx,k1,k2,a,sc,n)
+
+      real y(n),xx(n,1),a(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2) ! short block: zero weight on the repeats
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         c1 = sc*a(k)
+         c2 = 0.
+         c3 = 0.
+         c4 = 0.
+         if (k+1.le.k2) c2 = sc*a(k2b)
+         if (k+2.le.k2) c3 = sc*a(k3b)
+         if (k+3.le.k2) c4 = sc*a(k4b)
+c$acc parallel loop default(present) if(ifdev)
+         do i=1,n
+            y(i) = y(i) + c1*xx(i,k)   + c2*xx(i,k2b)
+     $                  + c3*xx(i,k3b) + c4*xx(i,k4b)
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_maxpy4(y,xx,k1,k2,a,sc,n)
+
+      real y(n),a(1)
+      real*4 xx(n,1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+      do k=k1,k2,4
+         k2b = min(k+1,k2)
+         k3b = min(k+2,k2)
+         k4b = min(k+3,k2)
+         c1 = sc*a(k)
+         c2 = 0.
+         c3 = 0.
+         c4 = 0.
+         if (k+1.le.k2) c2 = sc*a(k2b)
+         if (k+2.le.k2) c3 = sc*a(k3b)
+         if (k+3.le.k2) c4 = sc*a(k4b)
+c$acc parallel loop default(present) if(ifdev)
+         do i=1,n
+            y(i) = y(i) + c1*xx(i,k)   + c2*xx(i,k2b)
+     $                  + c3*xx(i,k3b) + c4*xx(i,k4b)
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_rot8(xx,bb,h,k,c,s,n)
+
+      real xx(n,1),bb(n,1)
+      integer h
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(xx)
+#endif
+c$acc parallel loop default(present) private(scl1,scl2) if(ifdev)
+      do i = 1, n
+         scl1 = c*xx(i,h) + s*xx(i,k)
+         xx(i,k) = -s*xx(i,h) + c*xx(i,k)
+         xx(i,h) = scl1       
+         scl2 = c*bb(i,h) + s*bb(i,k)
+         bb(i,k) = -s*bb(i,h) + c*bb(i,k)    
+         bb(i,h) = scl2        
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_rot4(xx,bb,h,k,c,s,n)
+
+      real*4 xx(n,1),bb(n,1)
+      integer h
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(xx)
+#endif
+c$acc parallel loop default(present) private(scl1,scl2) if(ifdev)
+      do i = 1, n
+         scl1 = c*xx(i,h) + s*xx(i,k)
+         xx(i,k) = -s*xx(i,h) + c*xx(i,k)
+         xx(i,h) = scl1       
+         scl2 = c*bb(i,h) + s*bb(i,k)
+         bb(i,k) = -s*bb(i,h) + c*bb(i,k)    
+         bb(i,h) = scl2        
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_colget4(y,xx,k,n)
+
+      real y(n)
+      real*4 xx(n,1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+c$acc parallel loop default(present) if(ifdev)
+      do i = 1, n
+         y(i) = xx(i,k)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine proj_colput4(xx,k,y,n)
+
+      real y(n)
+      real*4 xx(n,1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+
+#ifdef OPENACC
+      ifdev = nek_acc_dev(y)
+#endif
+c$acc parallel loop default(present) if(ifdev)
+      do i = 1, n
+         xx(i,k) = y(i)
+      enddo
 
       return
       end
@@ -47,9 +47,11 @@ c
       real uf(1),vf(1)
       common /scrpre/ uc(lcr*lelt),w(2*lx1*ly1*lz1)
 
+      call nek_comm_push('crs')
       call map_f_to_c_l2_bilin(uf,vf,w)
-      call fgslib_crs_solve(xxth(ifield),uc,uf)
+      call nek_crs_solve(xxth(ifield),uc,uf)
       call map_c_to_f_l2_bilin(uf,uc,w)
+      call nek_comm_pop()
 
       return
       end
@@ -79,6 +81,40 @@ c      end
 c-----------------------------------------------------------------------
 c
       subroutine set_up_h1_crs
+c
+c     Mask, multiplicity and the local matrices (a,ia,ja) are only
+c     needed until the coarse solver has been set up and are sized by
+c     nelv in a workspace frame.
+c
+      include 'SIZE'
+      include 'WSPACE'
+
+      integer*8 kmsk,kmlt,ka,kia,kja
+
+      integer itmr
+      save    itmr
+      data    itmr /0/
+
+      if (itmr.eq.0) call nek_timer_id('crs_setup',itmr)
+      call nek_timer_push(itmr)
+
+      ncr = 2**ldim
+      nz  = ncr*ncr*nelv
+
+      call nek_ws_push
+      kmsk = nek_ws_r(ncr*nelv)
+      kmlt = nek_ws_r(ncr*nelv)
+      ka   = nek_ws_r(nz)
+      kia  = nek_ws_i(nz)
+      kja  = nek_ws_i(nz)
+      call set_up_h1_crs_a(ws(kmsk),ws(kmlt),iws(kia),iws(kja),ws(ka))
+      call nek_ws_pop
+
+      call nek_timer_pop(itmr)
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine set_up_h1_crs_a(mask,cmlt,ia,ja,a)
 
       include 'SIZE'
       include 'GEOM'
@@ -95,20 +131,10 @@ c
       integer null_space,e
 
       character*3 cb
-      common /scrxxt/ cmlt(lcr,lelv),mask(lcr,lelv)
-      common /scrxxti/ ia(lcr,lcr,lelv), ja(lcr,lcr,lelv)
-      real mask
-      integer ia,ja
+      real mask(1),cmlt(1),a(1)
+      integer ia(1),ja(1)
       real z
 
-      integer key(2),aa(2)
-      common /scrch/ iwork(2,lx1*ly1*lz1*lelv)
-      common /scrns/ w(7*lx1*ly1*lz1*lelv)
-      common /vptsol/ a(27*lx1*ly1*lz1*lelv)
-      integer w
-      real wr(1)
-      equivalence (wr,w)
-
       common /scrvhx/ h1(lx1*ly1*lz1*lelv),h2(lx1*ly1*lz1*lelv)
       common /scrmgx/ w1(lx1*ly1*lz1*lelv),w2(lx1*ly1*lz1*lelv)
 
@@ -185,7 +211,7 @@ c         lda = 27*nxyz1*lelt
 c         ldw =  7*nxyz1*lelt
 c         call get_local_crs(a,lda,nxc,h1,h2,w,ldw)
 c      else
-c        NOTE: a(),h1,...,w2() must all be large enough
+c        NOTE: h1,...,w2() must all be large enough
          n = lx1*ly1*lz1*nelv
          call rone (h1,n)
          call rzero(h2,n)
@@ -206,8 +232,8 @@ c      endif
       if (imode.eq.0 .and. nelgt.gt.350000) call exitti(
      $ 'Problem size requires AMG solver$',1)
 
-      call fgslib_crs_setup(xxth(ifield),imode,nekcomm,mp,ntot,
-     $                      se_to_gcrs,nz,ia,ja,a, null_space)
+      call nek_crs_setup(xxth(ifield),imode,nekcomm,mp,ntot,
+     $                   se_to_gcrs,nz,ia,ja,a, null_space)
 c      call fgslib_crs_stats(xxth(ifield))
 
       t0 = dnekclock()-t0
@@ -219,6 +245,58 @@ c      call fgslib_crs_stats(xxth(ifield))
       return
       end
 c
+c-----------------------------------------------------------------------
+      subroutine nek_crs_setup(h,imode,comm,np,n,id,nz,ia,ja,a,null_sp)
+c
+c     Coarse grid solver setup: XXT (imode=0) or AMG from the offline
+c     amg_hypre/amg_matlab2 files (imode=1) in gslib, or hypre BoomerAMG
+c     set up in-process from the same matrix (imode=2, crs_hypre.c).
+c     Hypre handles are stored as h < 0.
+c
+      integer h,imode,comm,np,n,nz,ia(nz),ja(nz),null_sp
+      integer*8 id(n)
+      real a(nz)
+
+      if (imode.eq.2) then
+         call crs_hypre_setup(ih,comm,np,n,id,nz,ia,ja,a,null_sp)
+         h = -1-ih
+      else
+         call fgslib_crs_setup(h,imode,comm,np,n,id,nz,ia,ja,a,null_sp)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_crs_solve(h,x,b)
+c
+c     x = A^-1 b for the coarse grid handle h of nek_crs_setup
+c
+      integer h
+      real x(1),b(1)
+
+      if (h.lt.0) then
+         ih = -1-h
+         call crs_hypre_solve(ih,x,b)
+      else
+         call fgslib_crs_solve(h,x,b)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_crs_free(h)
+
+      integer h
+
+      if (h.lt.0) then
+         ih = -1-h
+         call crs_hypre_free(ih)
+      else
+         call fgslib_crs_free(h)
+      endif
+
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine set_jl_crs_mask(n, mask, se_to_gcrs)
       real mask(1)
@@ -1339,7 +1417,6 @@ c
       real uf(1),vf(1)
       common /scrpre/ uc(lcr*lelt)
       common /scrpr2/ vc(lcr*lelt)
-      common /scrxxt/ cmlt(lcr,lelv),mask(lcr,lelv)
 
       integer icalld1
       save    icalld1
@@ -1361,7 +1438,7 @@ c
 #ifdef TIMER
       etime1=dnekclock()
 #endif
-      call fgslib_crs_solve(xxth(ifield),uc,vc)
+      call nek_crs_solve(xxth(ifield),uc,vc)
 #ifdef TIMER
       tcrsl=tcrsl+dnekclock()-etime1
 #endif
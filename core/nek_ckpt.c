@@ -0,0 +1,501 @@
+/*
+ * Multi-level checkpoint store (general:checkpointLocal, see ckpt_init
+ * in prepost.f)
+ *
+ * Fortran usage:
+ *
+ *      call nek_ckpt_setup(comm,mode,dir,partner,delta,session)
+ *      call nek_ckpt_field('vx',vx,n)          ! ... every state array
+ *      call nek_ckpt_save(gen,time,ierr)       ! level 1 checkpoint
+ *      call nek_ckpt_load(gen,time,ierr)       ! restore it
+ *
+ * The registered arrays are packed into one buffer per rank and kept
+ * either in memory (mode 1) or as files in a node-local directory
+ * (mode 2, <dir>/<session>.ck<rank>).  Every save also sends the packed
+ * state to a partner rank (rank+partner, by default one node further)
+ * which keeps it as a replica, in memory or as <session>.ck<src>.r in
+ * its own directory, so the loss of one node can be recovered from.
+ *
+ * With delta set the state is stored as a base plus the XOR difference
+ * to it, which is written (and replicated) with the leading zero bytes
+ * of every word dropped.  The base is replaced by the current state
+ * once the difference no longer saves a quarter of the bytes.
+ *
+ * A load first tries the own copy and, if any rank misses it, fetches
+ * the replica from the partner.  The state is only restored if every
+ * rank finds a complete copy of the same checkpoint with the same
+ * layout; otherwise ierr is set on all ranks and nothing is touched.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include "name.h"
+
+#ifdef MPI
+#include <mpi.h>
+#endif
+
+#define nek_ckpt_setup FORTRAN_UNPREFIXED(nek_ckpt_setup,NEK_CKPT_SETUP)
+#define nek_ckpt_field FORTRAN_UNPREFIXED(nek_ckpt_field,NEK_CKPT_FIELD)
+#define nek_ckpt_save  FORTRAN_UNPREFIXED(nek_ckpt_save, NEK_CKPT_SAVE)
+#define nek_ckpt_load  FORTRAN_UNPREFIXED(nek_ckpt_load, NEK_CKPT_LOAD)
+
+#define NFIELD_MAX 256
+#define CK_MAGIC   0x31544b43504b454eULL           /* "NEKPCKT1" */
+
+typedef struct {
+  uint64_t magic;
+  int32_t  np, rank;
+  int64_t  nbytes;             /* size of the packed state          */
+  int64_t  nenc;               /* bytes following (base or delta)   */
+  int64_t  gen, bgen;          /* checkpoint and base generation    */
+  uint64_t layout;             /* hash of the registered fields     */
+  uint64_t sum;                /* checksum of the packed state      */
+  double   time;
+} ck_hdr;
+
+typedef struct {
+  ck_hdr bh, dh;               /* base and delta headers            */
+  char  *base, *dlt;
+  size_t nbase, ndlt;          /* allocated bytes                   */
+} ck_slot;
+
+typedef struct {
+  double *p;
+  size_t  n;
+} ck_field;
+
+static ck_field fld[NFIELD_MAX];
+static int      nfld;
+static size_t   nbytes;
+static uint64_t layout = 1469598103934665603ULL;
+
+static int  mode, ifdelta, nid, np = 1, part, src;
+static char fbase[512];
+static char *cur;                     /* packed state                 */
+static size_t ncur;
+static int    ifload;                 /* rebase after a load          */
+static ck_slot own, rep;
+#ifdef MPI
+static MPI_Comm comm;
+#endif
+
+static double wtime(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+static uint64_t hash(uint64_t h, const void *p, size_t n)
+{
+  const unsigned char *c = p;
+  while(n--) h = (h ^ *c++)*1099511628211ULL;
+  return h;
+}
+
+static uint64_t checksum(const char *p, size_t n)
+{
+  const uint64_t *w = (const uint64_t *)p;
+  uint64_t h = 1469598103934665603ULL;
+  size_t i;
+  for(i=0;i<n/8;++i) h = (h ^ w[i])*1099511628211ULL + (h >> 29);
+  return h;
+}
+
+static void *grow(char **p, size_t *cap, size_t n)
+{
+  if(n > *cap) {
+    free(*p);
+    *p = malloc(n ? n : 1);
+    *cap = *p ? n : 0;
+  }
+  return *p;
+}
+
+/* (a^b) of n words: a nibble per word with its number of significant
+   bytes, then those bytes (low first).  Returns the encoded size. */
+static size_t encode(const char *a, const char *b, size_t n,
+                     unsigned char *out)
+{
+  const uint64_t *u = (const uint64_t *)a, *v = (const uint64_t *)b;
+  unsigned char *d = out + (n+1)/2;
+  size_t i;
+  memset(out,0,(n+1)/2);
+  for(i=0;i<n;++i) {
+    uint64_t x = u[i]^v[i];
+    int k = 0;
+    while(x) { *d++ = (unsigned char)x; x >>= 8; ++k; }
+    out[i/2] |= (unsigned char)(k << 4*(i&1));
+  }
+  return d-out;
+}
+
+static int decode(const unsigned char *in, size_t nin, const char *b,
+                  size_t n, char *a)
+{
+  const uint64_t *v = (const uint64_t *)b;
+  uint64_t *u = (uint64_t *)a;
+  const unsigned char *d = in + (n+1)/2, *e = in + nin;
+  size_t i;
+  if(nin < (n+1)/2) return 1;
+  for(i=0;i<n;++i) {
+    int j, k = (in[i/2] >> 4*(i&1)) & 15;
+    uint64_t x = 0;
+    if(k > 8 || d+k > e) return 1;
+    for(j=0;j<k;++j) x |= (uint64_t)d[j] << 8*j;
+    d += k;
+    u[i] = v[i]^x;
+  }
+  return d != e;
+}
+
+static size_t enc_max(size_t n) { return n + n/16 + 16; }
+
+static int write_file(const char *name, const ck_hdr *h, const char *p)
+{
+  char tmp[540];
+  FILE *fp;
+  int ierr = 0;
+  snprintf(tmp,sizeof(tmp),"%s.tmp",name);
+  if(!(fp = fopen(tmp,"wb"))) return 1;
+  if(fwrite(h,sizeof(*h),1,fp) != 1) ierr = 1;
+  if(!ierr && h->nenc > 0 && fwrite(p,h->nenc,1,fp) != 1) ierr = 1;
+  if(fclose(fp)) ierr = 1;
+  return ierr;
+}
+
+static int commit_file(const char *name)
+{
+  char tmp[540];
+  snprintf(tmp,sizeof(tmp),"%s.tmp",name);
+  return rename(tmp,name) != 0;
+}
+
+static int read_file(const char *name, ck_hdr *h, char **p, size_t *cap)
+{
+  FILE *fp;
+  int ierr = 0;
+  if(!(fp = fopen(name,"rb"))) return 1;
+  if(fread(h,sizeof(*h),1,fp) != 1 || h->magic != CK_MAGIC ||
+     h->nenc < 0 || !grow(p,cap,h->nenc)) ierr = 1;
+  if(!ierr && h->nenc > 0 && fread(*p,h->nenc,1,fp) != 1) ierr = 1;
+  fclose(fp);
+  return ierr;
+}
+
+static void fname(char *s, int r, const char *ext)
+{
+  snprintf(s,520,"%s%d%s",fbase,r,ext);
+}
+
+/* write (or keep) slot s of rank r: the base only if it changed */
+static int store(ck_slot *s, int r, const char *ext, int ifbase)
+{
+  char name[520], dext[8];
+  int ierr = 0;
+  if(mode != 2) return 0;
+  if(ifbase) {
+    fname(name,r,ext);
+    ierr |= write_file(name,&s->bh,s->base);
+  }
+  if(ifdelta) {
+    snprintf(dext,sizeof(dext),"%sd",ext);
+    fname(name,r,dext);
+    ierr |= write_file(name,&s->dh,s->dlt);
+  }
+  return ierr;
+}
+
+static int commit(int r, const char *ext, int ifbase)
+{
+  char name[520], dext[8];
+  int ierr = 0;
+  if(mode != 2) return 0;
+  if(ifbase) { fname(name,r,ext); ierr |= commit_file(name); }
+  if(ifdelta) {
+    snprintf(dext,sizeof(dext),"%sd",ext);
+    fname(name,r,dext);
+    ierr |= commit_file(name);
+  }
+  return ierr;
+}
+
+static int fetch(ck_slot *s, int r, const char *ext)
+{
+  char name[520], dext[8];
+  fname(name,r,ext);
+  if(read_file(name,&s->bh,&s->base,&s->nbase)) return 1;
+  if(!ifdelta) return 0;
+  snprintf(dext,sizeof(dext),"%sd",ext);
+  fname(name,r,dext);
+  return read_file(name,&s->dh,&s->dlt,&s->ndlt);
+}
+
+/* 0 if slot s holds a consistent checkpoint of rank r */
+static int invalid(const ck_slot *s, int r)
+{
+  const ck_hdr *b = &s->bh;
+  if(!s->base || b->magic != CK_MAGIC || b->np != np || b->rank != r ||
+     b->layout != layout || b->nbytes != (int64_t)nbytes ||
+     b->nenc != (int64_t)nbytes) return 1;
+  if(!ifdelta) return 0;
+  b = &s->dh;
+  return b->magic != CK_MAGIC || b->bgen != s->bh.gen ||
+         b->layout != layout || b->nenc > (int64_t)enc_max(nbytes) ||
+         (b->nenc > 0 && !s->dlt);
+}
+
+#ifdef MPI
+/* send slot a to dest, receive slot b from from (base only if
+   ifbase is set on the sender) */
+static void exchange(ck_slot *a, int dest, int ifbase, ck_slot *b,
+                    int from)
+{
+  int64_t ns[2], nr[2];
+  ns[0] = ifbase ? (int64_t)(sizeof(ck_hdr)+a->bh.nenc) : 0;
+  ns[1] = ifdelta ? (int64_t)(sizeof(ck_hdr)+a->dh.nenc) : 0;
+  MPI_Sendrecv(ns,2,MPI_INT64_T,dest,701,nr,2,MPI_INT64_T,from,701,
+               comm,MPI_STATUS_IGNORE);
+  if((nr[0] && !grow(&b->base,&b->nbase,nr[0]-sizeof(ck_hdr)+1)) ||
+     (nr[1] && !grow(&b->dlt,&b->ndlt,nr[1]-sizeof(ck_hdr)+1))) {
+    printf("ckpt: cannot allocate replica of rank %d\n",from);
+    MPI_Abort(comm,1);
+  }
+  MPI_Sendrecv(&a->bh,ns[0] ? (int)sizeof(ck_hdr) : 0,MPI_BYTE,dest,702,
+               &b->bh,nr[0] ? (int)sizeof(ck_hdr) : 0,MPI_BYTE,from,702,
+               comm,MPI_STATUS_IGNORE);
+  MPI_Sendrecv(a->base,ns[0] ? a->bh.nenc : 0,MPI_BYTE,dest,703,
+               b->base,nr[0] ? b->bh.nenc : 0,MPI_BYTE,from,703,
+               comm,MPI_STATUS_IGNORE);
+  MPI_Sendrecv(&a->dh,ns[1] ? (int)sizeof(ck_hdr) : 0,MPI_BYTE,dest,704,
+               &b->dh,nr[1] ? (int)sizeof(ck_hdr) : 0,MPI_BYTE,from,704,
+               comm,MPI_STATUS_IGNORE);
+  MPI_Sendrecv(a->dlt,ns[1] ? a->dh.nenc : 0,MPI_BYTE,dest,705,
+               b->dlt,nr[1] ? b->dh.nenc : 0,MPI_BYTE,from,705,
+               comm,MPI_STATUS_IGNORE);
+}
+#endif
+
+static int all_ok(int ierr)
+{
+#ifdef MPI
+  MPI_Allreduce(MPI_IN_PLACE,&ierr,1,MPI_INT,MPI_MAX,comm);
+#endif
+  return ierr == 0;
+}
+
+void nek_ckpt_setup(int *fcomm, int *imode, char *dir, int *partner,
+                    int *delta, char *session, int dlen, int slen)
+{
+  int nd = dlen, ns = slen;
+
+#ifdef MPI
+  MPI_Comm_dup(MPI_Comm_f2c(*fcomm),&comm);
+  MPI_Comm_rank(comm,&nid);
+  MPI_Comm_size(comm,&np);
+#else
+  (void)fcomm;
+#endif
+  mode    = *imode;
+  ifdelta = *delta;
+
+  part = *partner;
+#ifdef MPI
+  if(part <= 0) {                     /* one node further             */
+    MPI_Comm node;
+    int nn;
+    MPI_Comm_split_type(comm,MPI_COMM_TYPE_SHARED,nid,MPI_INFO_NULL,
+                        &node);
+    MPI_Comm_size(node,&nn);
+    MPI_Comm_free(&node);
+    MPI_Allreduce(MPI_IN_PLACE,&nn,1,MPI_INT,MPI_MAX,comm);
+    part = nn < np ? nn : np/2;
+  }
+#endif
+  part %= np;
+  if(part == 0 && np > 1) part = 1;
+  src  = (nid - part + np) % np;
+  part = (nid + part) % np;
+
+  while(nd > 0 && dir[nd-1] == ' ') --nd;
+  while(ns > 0 && session[ns-1] == ' ') --ns;
+  if(nd == 0) { dir = "."; nd = 1; }
+  snprintf(fbase,sizeof(fbase),"%.*s/%.*s.ck",nd,dir,ns,session);
+
+  if(nid == 0) {
+    if(mode == 2) printf("ckpt: level 1 in %.*s",nd,dir);
+    else          printf("ckpt: level 1 in memory");
+    if(np > 1)    printf(", replica on rank+%d",(part-nid+np)%np);
+    printf("%s\n",ifdelta ? ", delta against base" : "");
+  }
+}
+
+void nek_ckpt_field(char *name, double *p, int *n, int nlen)
+{
+  int64_t m = *n;
+  if(nfld == NFIELD_MAX) {
+    if(nid == 0)
+      printf("ckpt: more than %d fields, ignoring %.*s\n",
+             NFIELD_MAX,nlen,name);
+    return;
+  }
+  fld[nfld].p = p;
+  fld[nfld].n = *n > 0 ? *n : 0;
+  nfld++;
+  nbytes += fld[nfld-1].n*sizeof(double);
+  layout = hash(layout,name,nlen);
+  layout = hash(layout,&m,sizeof(m));
+}
+
+void nek_ckpt_save(int *gen, double *time, int *ierr)
+{
+  double t0 = wtime(), st[3];
+  size_t n = nbytes/8, nenc = 0, off = 0;
+  int i, ifbase = 1;
+
+  *ierr = 0;
+  if(!grow(&cur,&ncur,nbytes+8) || !grow(&own.base,&own.nbase,nbytes+8) ||
+     (ifdelta && !grow(&own.dlt,&own.ndlt,enc_max(nbytes)))) *ierr = 1;
+  if(!all_ok(*ierr)) {
+    if(nid == 0) printf("ckpt: cannot allocate %zu bytes\n",nbytes);
+    *ierr = 1;
+    return;
+  }
+
+  for(i=0;i<nfld;++i) {
+    memcpy(cur+off,fld[i].p,fld[i].n*sizeof(double));
+    off += fld[i].n*sizeof(double);
+  }
+
+  if(ifdelta && own.bh.magic == CK_MAGIC && !ifload) {
+    nenc = encode(cur,own.base,n,(unsigned char *)own.dlt);
+    ifbase = nenc > 3*nbytes/4;
+  }
+#ifdef MPI
+  MPI_Allreduce(MPI_IN_PLACE,&ifbase,1,MPI_INT,MPI_MAX,comm);
+#endif
+  ifload = 0;
+  if(ifbase) {
+    char *c = own.base;
+    size_t m = own.nbase;
+    own.base = cur; own.nbase = ncur;
+    cur = c; ncur = m;
+    nenc = 0;
+    own.bh.magic  = CK_MAGIC;
+    own.bh.np     = np;
+    own.bh.rank   = nid;
+    own.bh.nbytes = own.bh.nenc = nbytes;
+    own.bh.gen    = own.bh.bgen = *gen;
+    own.bh.layout = layout;
+    own.bh.sum    = checksum(own.base,nbytes);
+    own.bh.time   = *time;
+  }
+  own.dh = own.bh;
+  own.dh.nenc = nenc;
+  own.dh.gen  = *gen;
+  own.dh.bgen = own.bh.gen;
+  own.dh.sum  = ifbase ? own.bh.sum : checksum(cur,nbytes);
+  own.dh.time = *time;
+
+  *ierr = store(&own,nid,"",ifbase);
+#ifdef MPI
+  if(np > 1) {
+    exchange(&own,part,ifbase,&rep,src);
+    *ierr |= store(&rep,src,".r",ifbase);
+  }
+#endif
+  if(all_ok(*ierr)) {                 /* all copies are complete      */
+    *ierr = commit(nid,"",ifbase);
+    if(np > 1) *ierr |= commit(src,".r",ifbase);
+  }
+  *ierr = !all_ok(*ierr);
+  if(*ierr) ifload = 1;               /* own.bh names an uncommitted base */
+
+  st[0] = wtime()-t0;
+  st[1] = (ifbase ? nbytes : 0) + (ifdelta ? nenc : 0);
+  st[2] = nbytes;
+#ifdef MPI
+  MPI_Allreduce(MPI_IN_PLACE,st,1,MPI_DOUBLE,MPI_MAX,comm);
+  MPI_Allreduce(MPI_IN_PLACE,st+1,2,MPI_DOUBLE,MPI_SUM,comm);
+#endif
+  if(nid == 0) {
+    if(*ierr)
+      printf("ckpt: level 1 checkpoint %d failed\n",*gen);
+    else
+      printf("ckpt: level 1 checkpoint %d (%s) %.4g of %.4g MB "
+             "in %.3e s\n",*gen,ifbase ? "base" : "delta",st[1]/1e6,
+             st[2]/1e6,st[0]);
+  }
+}
+
+void nek_ckpt_load(int *gen, double *time, int *ierr)
+{
+  int ifown = 0, ifrep = 0, i, g[2];
+  size_t off = 0;
+
+  *ierr = 0;
+  if(mode == 2) {
+    ifown = fetch(&own,nid,"") == 0;
+    if(np > 1) ifrep = fetch(&rep,src,".r") == 0;
+  } else {
+    ifown = own.bh.magic == CK_MAGIC;
+    ifrep = rep.bh.magic == CK_MAGIC;
+  }
+  ifown = ifown && !invalid(&own,nid);
+  ifrep = ifrep && !invalid(&rep,src);
+
+#ifdef MPI
+  if(np > 1 && !all_ok(!ifown)) {     /* somebody needs its replica   */
+    ck_slot in;
+    memset(&in,0,sizeof(in));
+    if(!ifrep) {
+      memset(&rep.bh,0,sizeof(ck_hdr));
+      memset(&rep.dh,0,sizeof(ck_hdr));
+    }
+    exchange(&rep,src,1,&in,part);
+    if(!ifown && in.base && !invalid(&in,nid)) {
+      free(own.base); free(own.dlt);
+      own = in;
+      ifown = 1;
+      store(&own,nid,"",1);
+      commit(nid,"",1);
+    } else {
+      free(in.base); free(in.dlt);
+    }
+  }
+#endif
+
+  if(ifown && !grow(&cur,&ncur,nbytes+8)) ifown = 0;
+  if(ifown) {
+    if(ifdelta && own.dh.nenc > 0) {
+      if(decode((unsigned char *)own.dlt,own.dh.nenc,own.base,nbytes/8,
+                cur)) ifown = 0;
+    } else
+      memcpy(cur,own.base,nbytes);
+    if(ifown && checksum(cur,nbytes) !=
+                (ifdelta ? own.dh.sum : own.bh.sum)) ifown = 0;
+  }
+
+  g[0] = ifown ? (int)(ifdelta ? own.dh.gen : own.bh.gen) : -1;
+  g[1] = -g[0];
+#ifdef MPI
+  MPI_Allreduce(MPI_IN_PLACE,g,2,MPI_INT,MPI_MIN,comm);
+#endif
+  if(g[0] < 0 || g[0] != -g[1]) {     /* missing or mixed checkpoints */
+    *ierr = 1;
+    memset(&own.bh,0,sizeof(ck_hdr));
+    return;
+  }
+
+  for(i=0;i<nfld;++i) {
+    memcpy(fld[i].p,cur+off,fld[i].n*sizeof(double));
+    off += fld[i].n*sizeof(double);
+  }
+  ifload = 1;
+  *gen  = g[0];
+  *time = ifdelta ? own.dh.time : own.bh.time;
+}
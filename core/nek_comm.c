@@ -10,9 +10,22 @@
  * 5 MPI_Isend
  * 6 MPI_Recv
  * 7 MPI_Send
+ * 8 MPI_Alltoallv
+ * 9 MPI_Wait
+ * 10 MPI_Put
+ * 11 MPI_Get
+ * 12 MPI_Iallreduce
+ *
+ * With MPITIMER every call is also charged to the region on top of a
+ * label stack (nek_comm_push/nek_comm_pop, "other" if empty) and the
+ * communicator it was issued on (Fortran handle, -1 for calls without
+ * one: wait, waitall, put, get): time, calls, bytes and a log2
+ * histogram of the message size per call type.  nek_comm_dump writes
+ * these tables to mpiprof.<rank>.
  *
  */
 #include <stdio.h>
+#include <string.h>
 #ifdef MPI
 #include <mpi.h>
 #endif
@@ -31,18 +44,146 @@
 #define nek_comm_settings  FORTRAN_NAME(nek_comm_settings, NEK_COMM_SETTINGS)
 #define nek_comm_getstat   FORTRAN_NAME(nek_comm_getstat, NEK_COMM_GETSTAT)
 #define nek_comm_startstat FORTRAN_NAME(nek_comm_startstat, NEK_COMM_STARTSTAT)
+#define nek_comm_push      FORTRAN_NAME(nek_comm_push, NEK_COMM_PUSH)
+#define nek_comm_pop       FORTRAN_NAME(nek_comm_pop, NEK_COMM_POP)
+#define nek_comm_dump      FORTRAN_NAME(nek_comm_dump, NEK_COMM_DUMP)
+#define nek_comm_wtime     FORTRAN_NAME(nek_comm_wtime, NEK_COMM_WTIME)
 
-#define NTIMER 8
+#define NTIMER 8           /* reported through nek_comm_getstat */
 #define NCOUNTER NTIMER
+#define NOP 13             /* call types profiled per region    */
+
+#define NLABEL  32
+#define NREGION 64         /* (label,communicator) pairs         */
+#define NDEPTH  16
+#define NBIN    32         /* bin b: 2^(b-1) <= bytes < 2^b     */
+#define NAMELEN 16
 
 int SYNC = 0;
 int TIMING = 1;
-double MPI_TIMERS[NTIMER] = {(double)0.0};
-int COUNTER[NCOUNTER] = {0};
+double MPI_TIMERS[NOP] = {(double)0.0};
+int COUNTER[NOP] = {0};
 
 
 #if defined(MPITIMER)
 
+static const char *OPNAME[NOP] = {
+  "allreduce","allreduce_sync","waitall","barrier","irecv","isend",
+  "recv","send","alltoallv","wait","put","get","iallreduce" };
+
+typedef struct {
+  int         label;
+  MPI_Fint    comm;
+  double      t[NOP];
+  double      bytes[NOP];
+  long long   n[NOP];
+  long long   hist[NOP][NBIN];
+} comm_region;
+
+static char LABEL[NLABEL][NAMELEN+1] = {"other"};
+static int NLAB = 1;
+/* region 0 also takes the calls once the table is full */
+static comm_region REGION[NREGION] = {{.label = 0, .comm = -1}};
+static int NREG = 1;
+static int STACK[NDEPTH];
+static int DEPTH = 0;
+
+static int comm_bin(double bytes)
+{
+  long long b = (long long)bytes;
+  int k = 0;
+  while (b>0 && k<NBIN-1) { b >>= 1; k++; }
+  return k;
+}
+
+static void comm_record(int op, MPI_Fint comm, double t, double bytes)
+{
+  int d = DEPTH<NDEPTH ? DEPTH : NDEPTH;
+  int l = d>0 ? STACK[d-1] : 0;
+  int k;
+  comm_region *r;
+
+  for (k=0; k<NREG; k++)
+    if (REGION[k].label==l && REGION[k].comm==comm) break;
+  if (k==NREG && NREG<NREGION) {
+    REGION[NREG].label = l;
+    REGION[NREG].comm  = comm;
+    NREG++;
+  }
+  r = &REGION[k<NREG ? k : 0];
+
+  r->t[op]     += t;
+  r->n[op]++;
+  r->bytes[op] += bytes;
+  r->hist[op][comm_bin(bytes)]++;
+}
+
+static double comm_bytes(int count, MPI_Datatype type)
+{
+  int size;
+  PMPI_Type_size(type,&size);
+  return (double)count*size;
+}
+
+void nek_comm_push(char *name, int nlen)
+{
+  int i,k;
+  char s[NAMELEN+1];
+
+  /* pushes beyond NDEPTH are charged to the deepest stored region */
+  if (DEPTH>=NDEPTH) { DEPTH++; return; }
+
+  for (i=0; i<nlen && i<NAMELEN && name[i]!=' '; i++) s[i] = name[i];
+  s[i] = '\0';
+  for (k=0; k<NLAB; k++) if (!strcmp(LABEL[k],s)) break;
+  if (k==NLAB) {
+    if (NLAB==NLABEL) k = 0;
+    else           strcpy(LABEL[NLAB++],s);
+  }
+
+  STACK[DEPTH++] = k;
+}
+
+void nek_comm_pop(void)
+{
+  if (DEPTH>0) DEPTH--;
+}
+
+void nek_comm_dump(void)
+{
+  int i,k,b,nid,np,nb;
+  char fname[32];
+  FILE *fp;
+
+  PMPI_Comm_rank(MPI_COMM_WORLD,&nid);
+  PMPI_Comm_size(MPI_COMM_WORLD,&np);
+  sprintf(fname,"mpiprof.%06d",nid);
+  if (!(fp = fopen(fname,"w"))) {
+    printf("nek_comm_dump() :: cannot open %s\n",fname);
+    return;
+  }
+
+  fprintf(fp,"# nek_comm profile, rank %d of %d\n",nid,np);
+  fprintf(fp,"#%-15s %11s %-15s %12s %14s %12s\n",
+          "region","comm","call","count","bytes","time [s]");
+  for (k=0; k<NREG; k++) for (i=0; i<NOP; i++) if (REGION[k].n[i]>0)
+    fprintf(fp," %-15s %11d %-15s %12lld %14.6e %12.4e\n",
+            LABEL[REGION[k].label],(int)REGION[k].comm,OPNAME[i],
+            REGION[k].n[i],REGION[k].bytes[i],REGION[k].t[i]);
+
+  fprintf(fp,"\n# message size histogram, bin b: 2^(b-1) <= bytes < 2^b\n");
+  for (k=0; k<NREG; k++) for (i=0; i<NOP; i++) if (REGION[k].n[i]>0) {
+    for (nb=NBIN; nb>1 && REGION[k].hist[i][nb-1]==0; nb--);
+    fprintf(fp," %-15s %11d %-15s",LABEL[REGION[k].label],
+            (int)REGION[k].comm,OPNAME[i]);
+    for (b=0; b<nb; b++) fprintf(fp," %lld",REGION[k].hist[i][b]);
+    fprintf(fp,"\n");
+  }
+  fclose(fp);
+
+  if (nid==0) printf("MPI profile written to mpiprof.*\n");
+}
+
 void nek_comm_settings(int *sync,int *timing)
 {
      SYNC   = *sync;
@@ -80,11 +221,25 @@ void nek_comm_getstat(double *timers, int *counters)
      for (i = 0; i < NCOUNTER; i++) counters[i] = COUNTER[i];
 }
 
-void nek_comm_startstat(void)
+/* time spent in MPI so far (all call types), no side effects */
+void nek_comm_wtime(double *t)
 {
      int i;
-     for (i = 0; i < NTIMER; i++) MPI_TIMERS[i] = 0.0;
-     for (i = 0; i < NCOUNTER; i++) COUNTER[i] = 0;
+     *t = 0.0;
+     for (i = 0; i < NOP; i++) *t += MPI_TIMERS[i];
+}
+
+void nek_comm_startstat(void)
+{
+     int i,k;
+     for (i = 0; i < NOP; i++) MPI_TIMERS[i] = 0.0;
+     for (i = 0; i < NOP; i++) COUNTER[i] = 0;
+     for (k = 0; k < NREG; k++) {
+       memset(REGION[k].t,0,sizeof(REGION[k].t));
+       memset(REGION[k].bytes,0,sizeof(REGION[k].bytes));
+       memset(REGION[k].n,0,sizeof(REGION[k].n));
+       memset(REGION[k].hist,0,sizeof(REGION[k].hist));
+     }
 }
 
 /* FORTRAN wrappers */
@@ -104,11 +259,14 @@ void mpi_allreduce_f(char *sendbuf, char *recvbuf, MPI_Fint *count,
 
     COUNTER[0]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     if (SYNC) *ierr = MPI_Barrier(c_comm);
-    if (TIMING) t1 = PMPI_Wtime(); 
+    t1 = TIMING ? PMPI_Wtime() : 0;
     *ierr = PMPI_Allreduce(sendbuf, recvbuf, *count, c_type, c_op, c_comm);
     if (TIMING) {MPI_TIMERS[0] += PMPI_Wtime()-t1; MPI_TIMERS[1] += t1-t0;}
+    comm_record(0,*comm,TIMING ? PMPI_Wtime()-t1 : 0,
+                comm_bytes(*count,c_type));
+    if (SYNC) comm_record(1,*comm,TIMING ? t1-t0 : 0,0);
 }
 
 #pragma weak MPI_BARRIER   = mpi_barrier_f
@@ -122,9 +280,10 @@ void mpi_barrier_f(MPI_Fint *comm, MPI_Fint *ierr)
 
     COUNTER[3]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     *ierr = PMPI_Barrier(c_comm);
     if (TIMING) MPI_TIMERS[3] += PMPI_Wtime()-t0;
+    comm_record(3,*comm,TIMING ? PMPI_Wtime()-t0 : 0,0);
 }
 
 #pragma weak MPI_RECV   = mpi_recv_f
@@ -142,9 +301,11 @@ void mpi_recv_f(char *buf, MPI_Fint *count, MPI_Fint *datatype,
 
     COUNTER[6]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     *ierr = PMPI_Recv(buf, *count, c_type, *source, *tag, c_comm, c_status);
     if (TIMING) MPI_TIMERS[6] += PMPI_Wtime()-t0;
+    comm_record(6,*comm,TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(*count,c_type));
 }
 
 #pragma weak MPI_SEND   = mpi_send_f
@@ -160,9 +321,100 @@ void mpi_send_f(char *buf, MPI_Fint *count, MPI_Fint *datatype,
 
     COUNTER[7]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     *ierr = PMPI_Send(buf, *count, c_type, *dest, *tag, c_comm);
     if (TIMING) MPI_TIMERS[7] += PMPI_Wtime()-t0;
+    comm_record(7,*comm,TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(*count,c_type));
+}
+
+#pragma weak MPI_WAIT   = mpi_wait_f
+#pragma weak mpi_wait   = mpi_wait_f
+#pragma weak mpi_wait_  = mpi_wait_f
+#pragma weak mpi_wait__ = mpi_wait_f
+void mpi_wait_f(MPI_Fint *request, MPI_Fint *status, MPI_Fint *ierr)
+{
+    MPI_Request c_req = MPI_Request_f2c(*request);
+    MPI_Status c_status;
+    double t0;
+
+    COUNTER[9]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    *ierr = PMPI_Wait(&c_req, &c_status);
+    if (TIMING) MPI_TIMERS[9] += PMPI_Wtime()-t0;
+    comm_record(9,-1,TIMING ? PMPI_Wtime()-t0 : 0,0);
+
+    *request = MPI_Request_c2f(c_req);
+    if (status != MPI_F_STATUS_IGNORE) MPI_Status_c2f(&c_status, status);
+}
+
+#pragma weak MPI_IALLREDUCE   = mpi_iallreduce_f
+#pragma weak mpi_iallreduce   = mpi_iallreduce_f
+#pragma weak mpi_iallreduce_  = mpi_iallreduce_f
+#pragma weak mpi_iallreduce__ = mpi_iallreduce_f
+void mpi_iallreduce_f(char *sendbuf, char *recvbuf, MPI_Fint *count,
+                     MPI_Fint *datatype, MPI_Fint *op, MPI_Fint *comm,
+                     MPI_Fint *request, MPI_Fint *ierr)
+{
+    MPI_Comm c_comm = MPI_Comm_f2c(*comm);
+    MPI_Datatype c_type = MPI_Type_f2c(*datatype);
+    MPI_Op c_op = MPI_Op_f2c(*op);
+    MPI_Request c_req;
+    double t0;
+
+    COUNTER[12]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    *ierr = PMPI_Iallreduce(sendbuf, recvbuf, *count, c_type, c_op, c_comm,
+                            &c_req);
+    if (TIMING) MPI_TIMERS[12] += PMPI_Wtime()-t0;
+    comm_record(12,*comm,TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(*count,c_type));
+
+    *request = MPI_Request_c2f(c_req);
+}
+
+#pragma weak MPI_PUT   = mpi_put_f
+#pragma weak mpi_put   = mpi_put_f
+#pragma weak mpi_put_  = mpi_put_f
+#pragma weak mpi_put__ = mpi_put_f
+void mpi_put_f(char *buf, MPI_Fint *count, MPI_Fint *datatype,
+               MPI_Fint *rank, MPI_Aint *disp, MPI_Fint *tcount,
+               MPI_Fint *tdatatype, MPI_Fint *win, MPI_Fint *ierr)
+{
+    MPI_Datatype c_type = MPI_Type_f2c(*datatype);
+    double t0;
+
+    COUNTER[10]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    *ierr = PMPI_Put(buf, *count, c_type, *rank, *disp, *tcount,
+                     MPI_Type_f2c(*tdatatype), MPI_Win_f2c(*win));
+    if (TIMING) MPI_TIMERS[10] += PMPI_Wtime()-t0;
+    comm_record(10,-1,TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(*count,c_type));
+}
+
+#pragma weak MPI_GET   = mpi_get_f
+#pragma weak mpi_get   = mpi_get_f
+#pragma weak mpi_get_  = mpi_get_f
+#pragma weak mpi_get__ = mpi_get_f
+void mpi_get_f(char *buf, MPI_Fint *count, MPI_Fint *datatype,
+               MPI_Fint *rank, MPI_Aint *disp, MPI_Fint *tcount,
+               MPI_Fint *tdatatype, MPI_Fint *win, MPI_Fint *ierr)
+{
+    MPI_Datatype c_type = MPI_Type_f2c(*datatype);
+    double t0;
+
+    COUNTER[11]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    *ierr = PMPI_Get(buf, *count, c_type, *rank, *disp, *tcount,
+                     MPI_Type_f2c(*tdatatype), MPI_Win_f2c(*win));
+    if (TIMING) MPI_TIMERS[11] += PMPI_Wtime()-t0;
+    comm_record(11,-1,TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(*count,c_type));
 }
 
 
@@ -179,11 +431,14 @@ int mpi_allreduce_c(void *sendbuf, void *recvbuf, int count,
 
     COUNTER[0]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     if (SYNC) ierr = MPI_Barrier(comm);
-    if (TIMING) t1 = PMPI_Wtime(); 
+    t1 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
     if (TIMING) {MPI_TIMERS[0] += PMPI_Wtime()-t1; MPI_TIMERS[1] += t1-t0;}
+    comm_record(0,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t1 : 0,
+                comm_bytes(count,datatype));
+    if (SYNC) comm_record(1,MPI_Comm_c2f(comm),TIMING ? t1-t0 : 0,0);
     return ierr;
 }
 
@@ -192,14 +447,14 @@ int mpi_allreduce_c(void *sendbuf, void *recvbuf, int count,
 int mpi_waitall_c(int count, MPI_Request *request, MPI_Status *status)
 {
     int ierr;
-    double t0,t1;
-
+    double t0;
 
     COUNTER[2]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Waitall(count, request, status);
     if (TIMING) MPI_TIMERS[2] += PMPI_Wtime()-t0;
+    comm_record(2,-1,TIMING ? PMPI_Wtime()-t0 : 0,0);
     return ierr;
 }
 
@@ -212,9 +467,10 @@ int mpi_barrier_c(MPI_Comm comm)
 
     COUNTER[3]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Barrier(comm);
     if (TIMING) MPI_TIMERS[3] += PMPI_Wtime()-t0;
+    comm_record(3,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,0);
     return ierr;
 }
 
@@ -228,9 +484,11 @@ int mpi_irecv_c(void *buf, int count, MPI_Datatype type, int source,
 
     COUNTER[4]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Irecv(buf,count,type,source,tag,comm,request);
     if (TIMING) MPI_TIMERS[4] += PMPI_Wtime()-t0;
+    comm_record(4,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(count,type));
     return ierr;
 }
 
@@ -245,9 +503,11 @@ int mpi_isend_c(void *buf, int count, MPI_Datatype type, int dest,
 
     COUNTER[5]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Isend(buf,count,type,dest,tag,comm,request);
     if (TIMING) MPI_TIMERS[5] += PMPI_Wtime()-t0;
+    comm_record(5,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(count,type));
     return ierr;
 }
 
@@ -261,9 +521,11 @@ int mpi_recv_c(void *buf, int count, MPI_Datatype type, int source,
 
     COUNTER[6]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Recv(buf,count,type,source,tag,comm,status);
     if (TIMING) MPI_TIMERS[6] += PMPI_Wtime()-t0;
+    comm_record(6,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(count,type));
     return ierr;
 }
 
@@ -277,15 +539,88 @@ int mpi_send_c(void *buf, int count, MPI_Datatype type, int dest,
 
     COUNTER[7]++;
 
-    if (TIMING) t0 = PMPI_Wtime(); 
+    t0 = TIMING ? PMPI_Wtime() : 0;
     ierr = PMPI_Send(buf,count,type,dest,tag,comm);
     if (TIMING) MPI_TIMERS[7] += PMPI_Wtime()-t0;
+    comm_record(7,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,
+                comm_bytes(count,type));
+    return ierr;
+}
+
+#pragma weak MPI_Alltoallv  = mpi_alltoallv_c
+#pragma weak MPI_Alltoallv_ = mpi_alltoallv_c
+int mpi_alltoallv_c(void *sendbuf, int *sendcounts, int *sdispls,
+                    MPI_Datatype sendtype, void *recvbuf, int *recvcounts,
+                    int *rdispls, MPI_Datatype recvtype, MPI_Comm comm)
+{
+    int ierr,i,np;
+    double t0,bytes=0;
+
+    COUNTER[8]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    ierr = PMPI_Alltoallv(sendbuf,sendcounts,sdispls,sendtype,
+                          recvbuf,recvcounts,rdispls,recvtype,comm);
+    if (TIMING) MPI_TIMERS[8] += PMPI_Wtime()-t0;
+    PMPI_Comm_size(comm,&np);
+    for (i = 0; i < np; i++) bytes += comm_bytes(sendcounts[i],sendtype);
+    comm_record(8,MPI_Comm_c2f(comm),TIMING ? PMPI_Wtime()-t0 : 0,bytes);
+    return ierr;
+}
+
+#pragma weak MPI_Wait  = mpi_wait_c
+#pragma weak MPI_Wait_ = mpi_wait_c
+int mpi_wait_c(MPI_Request *request, MPI_Status *status)
+{
+    int ierr;
+    double t0;
+
+    COUNTER[9]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    ierr = PMPI_Wait(request,status);
+    if (TIMING) MPI_TIMERS[9] += PMPI_Wtime()-t0;
+    comm_record(9,-1,TIMING ? PMPI_Wtime()-t0 : 0,0);
+    return ierr;
+}
+
+#pragma weak MPI_Put  = mpi_put_c
+#pragma weak MPI_Put_ = mpi_put_c
+int mpi_put_c(void *buf, int count, MPI_Datatype type, int rank,
+              MPI_Aint disp, int tcount, MPI_Datatype ttype, MPI_Win win)
+{
+    int ierr;
+    double t0;
+
+    COUNTER[10]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    ierr = PMPI_Put(buf,count,type,rank,disp,tcount,ttype,win);
+    if (TIMING) MPI_TIMERS[10] += PMPI_Wtime()-t0;
+    comm_record(10,-1,TIMING ? PMPI_Wtime()-t0 : 0,comm_bytes(count,type));
+    return ierr;
+}
+
+#pragma weak MPI_Get  = mpi_get_c
+#pragma weak MPI_Get_ = mpi_get_c
+int mpi_get_c(void *buf, int count, MPI_Datatype type, int rank,
+              MPI_Aint disp, int tcount, MPI_Datatype ttype, MPI_Win win)
+{
+    int ierr;
+    double t0;
+
+    COUNTER[11]++;
+
+    t0 = TIMING ? PMPI_Wtime() : 0;
+    ierr = PMPI_Get(buf,count,type,rank,disp,tcount,ttype,win);
+    if (TIMING) MPI_TIMERS[11] += PMPI_Wtime()-t0;
+    comm_record(11,-1,TIMING ? PMPI_Wtime()-t0 : 0,comm_bytes(count,type));
     return ierr;
 }
 
 #else
 
-void nek_comm_settings(int *sync,int *timing){}
+void nek_comm_settings(int *sync,int *timing){ (void)sync; (void)timing; }
 void nek_comm_getstat(double *timer, int *counter)
 {
      int i;
@@ -293,6 +628,10 @@ void nek_comm_getstat(double *timer, int *counter)
      for (i = 0; i < NCOUNTER; i++) counter[i] = COUNTER[i];
 }
 void nek_comm_startstat(void){}
+void nek_comm_wtime(double *t){ *t = 0.0; }
+void nek_comm_push(char *name, int nlen){ (void)name; (void)nlen; }
+void nek_comm_pop(void){}
+void nek_comm_dump(void){}
 
 #endif
 
@@ -0,0 +1,251 @@
+/*
+ * Generic in-situ adapter (PPLIST="INSITU", consumer API in nek_insitu.h)
+ *
+ * Fortran usage (see 3rd_party/nek_in_situ.f):
+ *
+ *      call nek_insitu_setup(comm,async,move,session)
+ *      call nek_insitu_mesh(ldim,lx1,ly1,lz1,nelv,nelt,lglel,xm1,ym1,zm1)
+ *      call nek_insitu_field('vx',vx,lx1*ly1*lz1,nelv)        ! ...
+ *      call nek_insitu_start                   ! consumer init
+ *      call nek_insitu_publish(istep,time)     ! every inSituInterval
+ *      call nek_insitu_end
+ *
+ * Fields are registered by address once.  A synchronous publish hands
+ * the consumer Nek5000's own arrays.  An asynchronous publish first waits
+ * for the previous consumer call, copies all fields (and the coordinates
+ * if move is set) into one persistent staging buffer and runs the
+ * consumer on a worker thread, so the solver only pays for the copy.
+ * The worker gets the communicator only under MPI_THREAD_MULTIPLE.
+ *
+ * nek_insitu_end joins the worker, finalizes the consumer and prints
+ * the hand-off count and the time the solver spent waiting and copying
+ * (max over ranks).
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "name.h"
+
+#define nek_insitu_setup   FORTRAN_UNPREFIXED(nek_insitu_setup,  NEK_INSITU_SETUP)
+#define nek_insitu_mesh    FORTRAN_UNPREFIXED(nek_insitu_mesh,   NEK_INSITU_MESH)
+#define nek_insitu_field   FORTRAN_UNPREFIXED(nek_insitu_field,  NEK_INSITU_FIELD)
+#define nek_insitu_start   FORTRAN_UNPREFIXED(nek_insitu_start,  NEK_INSITU_START)
+#define nek_insitu_publish FORTRAN_UNPREFIXED(nek_insitu_publish,NEK_INSITU_PUBLISH)
+#define nek_insitu_end     FORTRAN_UNPREFIXED(nek_insitu_end,    NEK_INSITU_END)
+
+#ifdef INSITU
+
+#include <pthread.h>
+#include <sys/time.h>
+#include "nek_insitu.h"
+
+#define NFIELD_MAX 64
+
+static nek_insitu_data  live;          /* Nek5000's arrays            */
+static nek_insitu_data  snap;          /* staged copy (async)         */
+static nek_insitu_var   live_f[NFIELD_MAX], snap_f[NFIELD_MAX];
+
+static int     ifasync, ifmove, ifrun, ifthread;
+static char    sess[256];
+static double *stage;
+static size_t  nstage;
+static pthread_t worker;
+
+static long    npub;
+static double  twait, tcopy;
+
+static double wtime(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+static void *run_consumer(void *arg)
+{
+  nek_insitu_consumer((const nek_insitu_data *)arg);
+  return NULL;
+}
+
+static void join(void)
+{
+  double t0 = wtime();
+  if(ifthread) pthread_join(worker,NULL);
+  ifthread = 0;
+  twait += wtime()-t0;
+}
+
+void nek_insitu_setup(int *comm, int *async, int *move,
+                      char *session, int nlen)
+{
+  int n = nlen < (int)sizeof(sess)-1 ? nlen : (int)sizeof(sess)-1;
+  memset(&live,0,sizeof(live));
+  live.field = live_f;
+
+#ifdef MPI
+  {
+    MPI_Comm c = MPI_Comm_f2c(*comm);
+    MPI_Comm_dup(c,&live.comm);
+    MPI_Comm_rank(live.comm,&live.nid);
+    MPI_Comm_size(live.comm,&live.np);
+  }
+#else
+  live.np = 1;
+#endif
+  ifasync = *async;
+  ifmove  = *move;
+
+#ifdef MPI
+  if(ifasync) {
+    int level;
+    MPI_Query_thread(&level);
+    if(level < MPI_THREAD_MULTIPLE && live.nid == 0)
+      printf("insitu: MPI thread level %d < MPI_THREAD_MULTIPLE, "
+             "async consumer runs without communicator\n",level);
+  }
+#endif
+
+  memcpy(sess,session,n);
+  while(n > 0 && sess[n-1] == ' ') --n;
+  sess[n] = '\0';
+}
+
+void nek_insitu_mesh(int *ldim, int *lx1, int *ly1, int *lz1,
+                     int *nelv, int *nelt, int *lglel,
+                     double *x, double *y, double *z)
+{
+  live.ldim = *ldim;
+  live.lx1 = *lx1; live.ly1 = *ly1; live.lz1 = *lz1;
+  live.nelv = *nelv; live.nelt = *nelt;
+  live.lglel = lglel;
+  live.x = x; live.y = y; live.z = *ldim == 3 ? z : NULL;
+}
+
+void nek_insitu_field(char *name, double *p, int *nxyz, int *nel, int nlen)
+{
+  nek_insitu_var *f;
+  int n = nlen < NEK_INSITU_NAME-1 ? nlen : NEK_INSITU_NAME-1;
+  if(live.nfield == NFIELD_MAX) {
+    if(live.nid == 0)
+      printf("insitu: more than %d fields, ignoring %.*s\n",
+             NFIELD_MAX,nlen,name);
+    return;
+  }
+  f = &live_f[live.nfield++];
+  memcpy(f->name,name,n);
+  while(n > 0 && f->name[n-1] == ' ') --n;
+  f->name[n] = '\0';
+  f->data = p;
+  f->nxyz = *nxyz;
+  f->nel  = *nel;
+}
+
+void nek_insitu_start(void)
+{
+  size_t n = 0, nx;
+  int i, ok;
+
+  if(ifasync) {
+    nx = (size_t)live.lx1*live.ly1*live.lz1*live.nelt;
+    for(i=0;i<live.nfield;++i)
+      n += (size_t)live_f[i].nxyz*live_f[i].nel;
+    if(ifmove) n += live.ldim*nx;
+    nstage = n;
+    stage  = malloc((n ? n : 1)*sizeof(double));
+    if(!stage) {
+      if(live.nid == 0)
+        printf("insitu: cannot allocate %zu bytes staging, "
+               "falling back to synchronous hand-off\n",n*sizeof(double));
+      ifasync = 0;
+    }
+  }
+  ok = nek_insitu_consumer_init(&live,sess) == 0;
+  ifrun = ok;
+#ifdef MPI
+  /* all ranks or none, nek_insitu_end is collective */
+  MPI_Allreduce(&ok,&ifrun,1,MPI_INT,MPI_MIN,live.comm);
+#endif
+  if(ok && !ifrun) nek_insitu_consumer_end();
+  if(!ifrun && live.nid == 0)
+    printf("insitu: consumer init failed, disabled\n");
+}
+
+void nek_insitu_publish(int *istep, double *time)
+{
+  double *p;
+  size_t nx, m;
+  double t0;
+  int i;
+
+  if(!ifrun) return;
+  live.istep = *istep;
+  live.time  = *time;
+  npub++;
+
+  if(!ifasync) {
+    nek_insitu_consumer(&live);
+    return;
+  }
+
+  join();
+  t0 = wtime();
+  snap = live;
+  snap.field = snap_f;
+#ifdef MPI
+  {
+    int level;
+    MPI_Query_thread(&level);
+    if(level < MPI_THREAD_MULTIPLE) snap.comm = MPI_COMM_NULL;
+  }
+#endif
+  p = stage;
+  if(ifmove) {
+    nx = (size_t)live.lx1*live.ly1*live.lz1*live.nelt;
+    memcpy(p,live.x,nx*sizeof(double)); snap.x = p; p += nx;
+    memcpy(p,live.y,nx*sizeof(double)); snap.y = p; p += nx;
+    if(live.z) {
+      memcpy(p,live.z,nx*sizeof(double)); snap.z = p; p += nx;
+    }
+  }
+  for(i=0;i<live.nfield;++i) {
+    snap_f[i] = live_f[i];
+    m = (size_t)live_f[i].nxyz*live_f[i].nel;
+    memcpy(p,live_f[i].data,m*sizeof(double));
+    snap_f[i].data = p;
+    p += m;
+  }
+  tcopy += wtime()-t0;
+
+  if(pthread_create(&worker,NULL,run_consumer,&snap) == 0)
+    ifthread = 1;
+  else
+    nek_insitu_consumer(&snap);
+}
+
+void nek_insitu_end(void)
+{
+  double t[2];
+
+  if(ifrun) {
+    join();
+    nek_insitu_consumer_end();
+    ifrun = 0;
+
+    t[0] = twait; t[1] = tcopy;
+#ifdef MPI
+    MPI_Allreduce(MPI_IN_PLACE,t,2,MPI_DOUBLE,MPI_MAX,live.comm);
+#endif
+    if(live.nid == 0)
+      printf("insitu: %ld hand-offs (%s), wait %.3e s, copy %.3e s "
+             "(%.1f MB staged)\n",npub,ifasync ? "async" : "sync",
+             t[0],t[1],nstage*sizeof(double)/1e6);
+  }
+
+  free(stage); stage = NULL;
+#ifdef MPI
+  MPI_Comm_free(&live.comm);
+#endif
+}
+
+#endif
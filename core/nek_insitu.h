@@ -0,0 +1,56 @@
+#ifndef NEK_INSITU_H
+#define NEK_INSITU_H
+
+/*
+ * Consumer interface of the generic in-situ adapter (nek_insitu.c)
+ *
+ * Build with PPLIST="INSITU" and link a library that defines the three
+ * functions below (USR_LFLAGS="-L... -lmyanalysis -lpthread").  Every
+ * general:inSituInterval steps each rank calls nek_insitu_consumer once
+ * with its part of the mesh and solution:
+ *
+ *   inSituAsync = no    the arrays are Nek5000's own (no copy); the
+ *                       solver waits until the consumer returns.
+ *   inSituAsync = yes   the fields are snapshotted into a staging
+ *                       buffer (the mesh too if it moves) and the
+ *                       consumer runs on a worker thread while the
+ *                       solver advances.  The next hand-off waits for
+ *                       it to finish.  comm is MPI_COMM_NULL unless MPI
+ *                       was initialized with MPI_THREAD_MULTIPLE.
+ *
+ * All arrays are element by element, point index fastest (lx1*ly1*lz1
+ * points per element on the velocity mesh, see nxyz of each field), and
+ * are only valid during the call.
+ */
+#ifdef MPI
+#include <mpi.h>
+#endif
+
+#define NEK_INSITU_NAME 32
+
+typedef struct {
+  char          name[NEK_INSITU_NAME];
+  const double *data;
+  int           nxyz, nel;          /* points per element, elements */
+} nek_insitu_var;
+
+typedef struct {
+  int     istep;
+  double  time;
+  int     nid, np;
+#ifdef MPI
+  MPI_Comm comm;                    /* dup of the solver communicator */
+#endif
+  int     ldim, lx1, ly1, lz1;
+  int     nelv, nelt;               /* local fluid / total elements   */
+  const int    *lglel;              /* global element id (1-based)    */
+  const double *x, *y, *z;          /* GLL coordinates, nelt elements */
+  int     nfield;
+  const nek_insitu_var *field;
+} nek_insitu_data;
+
+int  nek_insitu_consumer_init(const nek_insitu_data *d, const char *session);
+void nek_insitu_consumer(const nek_insitu_data *d);
+void nek_insitu_consumer_end(void);
+
+#endif
@@ -0,0 +1,947 @@
+/*
+ * Hierarchical region timers
+ *
+ * Fortran usage:
+ *
+ *      integer itmr
+ *      save    itmr
+ *      data    itmr /0/
+ *      if (itmr.eq.0) call nek_timer_id('axhelm',itmr)
+ *      call nek_timer_push(itmr)
+ *      ...
+ *      call nek_timer_pop(itmr)
+ *
+ * nek_timer_id interns a name once, push/pop then only read the clock
+ * and touch a per-thread node table.  Regions nest: the same name
+ * reached through different parents is accounted separately.  The tick
+ * source is the TSC on x86-64 (calibrated against CLOCK_MONOTONIC over
+ * the run) and clock_gettime elsewhere or with -DNOTSC.
+ *
+ * nek_timer_report(comm) merges all threads, reduces min/max/avg over
+ * the ranks of comm for every region path known to rank 0 and prints
+ * the tree on rank 0.
+ *
+ * With -DHWCOUNTERS push/pop also read hardware counters for the regions
+ * listed in NEK_HWC_REGIONS (comma separated, default all) and the
+ * report adds a table of per rank avg/max counts with IPC, stalled
+ * cycle fraction and LLC miss bandwidth.  NEK_HWC selects the events:
+ *
+ *    ipc     cycles, instructions
+ *    cache   L1D read misses, LLC misses
+ *    mem     LLC misses and references (bandwidth = 64 B per miss)
+ *    stall   cycles, frontend and backend stalled cycles
+ *    vector  retired scalar/128/256/512 bit double precision FP
+ *            instructions (Intel FP_ARITH_INST_RETIRED codes)
+ *
+ * or raw events rXXXX (perf) / any PAPI event name with -DPAPI, at most
+ * HWC_NEV per thread (default "ipc,cache", "none" to disable).  The
+ * counters come from Linux perf_event, or from PAPI if built with
+ * -DPAPI.  A sample costs a read() per push and pop, so leave fine
+ * grained regions such as hsmg_fdm out of NEK_HWC_REGIONS.  Time
+ * operators at the caller (axhelm, cdabdtp, ...), not per mxm call.
+ *
+ * Push/pop of the regions in NEK_MEM_REGIONS (default the setup phases
+ * below, "all" or "none") also sample the resident set size and high
+ * watermark (/proc/self/statm, VmHWM) and the heap in use (mallinfo).
+ * Per region they add up the RSS and heap deltas, keep the highest RSS
+ * seen and the growth of the process watermark inside the region, so
+ * the report shows which phase set the peak of each rank.
+ * nek_mem_report(comm) prints only this table (end of setup), the one
+ * of nek_timer_report includes the time loop.  Sampling is done by the
+ * first thread that enters such a region.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef MPI
+#include <mpi.h>
+#endif
+#ifdef HWCOUNTERS
+#ifdef PAPI
+#include <papi.h>
+#include <pthread.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+#define MEM_MALLINFO2
+#endif
+#endif
+#if defined(__x86_64__) && !defined(NOTSC)
+#include <x86intrin.h>
+#define TMR_TSC
+#endif
+
+#ifdef UPCASE
+#  define FORTRAN_NAME(low,up) up
+#else
+#ifdef UNDERSCORE
+#  define FORTRAN_NAME(low,up) low##_
+#else
+#  define FORTRAN_NAME(low,up) low
+#endif
+#endif
+
+#define nek_timer_id     FORTRAN_NAME(nek_timer_id,NEK_TIMER_ID)
+#define nek_timer_push   FORTRAN_NAME(nek_timer_push,NEK_TIMER_PUSH)
+#define nek_timer_pop    FORTRAN_NAME(nek_timer_pop,NEK_TIMER_POP)
+#define nek_timer_report FORTRAN_NAME(nek_timer_report,NEK_TIMER_REPORT)
+#define nek_mem_report   FORTRAN_NAME(nek_mem_report,NEK_MEM_REPORT)
+
+#define TMR_NREG  64   /* distinct region names            */
+#define TMR_NNODE 256  /* distinct (parent,region) pairs   */
+#define TMR_DEPTH 32   /* nesting depth                    */
+#define TMR_NAME  24
+#define TMR_PATH  256
+
+#ifdef HWCOUNTERS
+#define HWC_NEV   8    /* counters per thread              */
+#else
+#define HWC_NEV   1
+#endif
+#define HWC_NAME  24
+#define MEM_NV    4    /* drss, peak, hwm growth, dheap    */
+#define MEM_DEFAULT "setup,readat,topo,geom,solver_setup,crs_setup," \
+                    "hsmg_setup,findpts_setup,ics,io_read,io_write"
+
+typedef unsigned long long tick_t;
+
+typedef struct {
+  int    parent, reg, depth;
+  tick_t ticks;
+  long long calls;
+  tick_t cnt[HWC_NEV];
+  double mem[MEM_NV];
+} tmr_node;
+
+typedef struct {
+  int    n;                 /* counters open on this thread     */
+  int    idx[HWC_NEV];      /* read position -> event           */
+  int    fd[HWC_NEV];       /* perf_event fds, fd[0] leader     */
+  int    evset;             /* PAPI event set                   */
+  tick_t enabled, running;  /* perf_event multiplexing check    */
+} hwc_ctx;
+
+typedef struct tmr_state {
+  int       nnode, sp, bad;
+  int       stack[TMR_DEPTH];
+  tick_t    t0[TMR_DEPTH];
+  tick_t    c0[TMR_DEPTH][HWC_NEV];
+  double    m0[TMR_DEPTH][3];        /* rss, hwm, heap at push   */
+  char      msamp[TMR_DEPTH];
+  short     child[TMR_NNODE][TMR_NREG];  /* node index + 1, 0 = none */
+  tmr_node  node[TMR_NNODE];
+  hwc_ctx   hwc;
+  struct tmr_state *next;
+} tmr_state;
+
+static char      reg_name[TMR_NREG][TMR_NAME];
+static int       nreg = 0;
+static volatile int reg_lock = 0;
+
+static tmr_state * volatile tmr_list = NULL;
+static __thread tmr_state *tmr_self = NULL;
+
+static tick_t tick0 = 0;
+static double wall0 = 0;
+
+static int  hwc_nev = 0;                   /* configured events        */
+static char reg_hwc[TMR_NREG];             /* region sampled?          */
+#ifdef HWCOUNTERS
+static char hwc_name[HWC_NEV][HWC_NAME];
+#endif
+
+static char reg_mem[TMR_NREG];             /* memory sampled?          */
+static int  mem_statm = -1, mem_status = -1;
+static double mem_page = 0;
+static tmr_state * volatile mem_self = NULL;
+
+static double wall_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+static inline tick_t tick_now()
+{
+#ifdef TMR_TSC
+  return (tick_t)__rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (tick_t)ts.tv_sec*1000000000ull + (tick_t)ts.tv_nsec;
+#endif
+}
+
+static double sec_per_tick()
+{
+#ifdef TMR_TSC
+  double dw = wall_now() - wall0;
+  tick_t dt = tick_now() - tick0;
+  return (dt > 0) ? dw/(double)dt : 0.0;
+#else
+  return 1e-9;
+#endif
+}
+
+/* is name an entry of the comma separated list? */
+static int in_list(const char *list, const char *name)
+{
+  const char *p;
+  size_t n = strlen(name);
+
+  for (p = strstr(list,name); p; p = strstr(p+1,name))
+    if ((p == list || p[-1] == ',') && (p[n] == ',' || p[n] == '\0'))
+      return 1;
+  return 0;
+}
+
+static void mem_config()
+{
+#ifdef __linux__
+  const char *list = getenv("NEK_MEM_REGIONS");
+  if (list && !strcmp(list,"none")) return;
+  mem_statm  = open("/proc/self/statm",O_RDONLY);
+  mem_status = open("/proc/self/status",O_RDONLY);
+  mem_page   = (double)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static int mem_region(const char *name)
+{
+  const char *list = getenv("NEK_MEM_REGIONS");
+
+  if (mem_statm < 0) return 0;
+  if (!list) list = MEM_DEFAULT;
+  return !strcmp(list,"all") || in_list(list,name);
+}
+
+/* resident set, its high watermark and the heap in use [bytes] */
+static void mem_sample(double *v)
+{
+  v[0] = v[1] = v[2] = 0;
+#ifdef __linux__
+  {
+    char buf[4096], *p;
+    long vsz, rss;
+    ssize_t n;
+    if ((n = pread(mem_statm,buf,sizeof(buf)-1,0)) > 0) {
+      buf[n] = '\0';
+      if (sscanf(buf,"%ld %ld",&vsz,&rss) == 2) v[0] = mem_page*rss;
+    }
+    if (mem_status >= 0 &&
+        (n = pread(mem_status,buf,sizeof(buf)-1,0)) > 0) {
+      buf[n] = '\0';
+      if ((p = strstr(buf,"VmHWM:"))) v[1] = 1024.0*strtod(p+6,NULL);
+    }
+  }
+#endif
+  if (v[1] < v[0]) v[1] = v[0];
+#if defined(MEM_MALLINFO2)
+  {
+    struct mallinfo2 m = mallinfo2();
+    v[2] = (double)m.uordblks + (double)m.hblkhd;
+  }
+#elif defined(__GLIBC__)
+  {
+    struct mallinfo m = mallinfo();
+    v[2] = (double)(unsigned)m.uordblks + (double)(unsigned)m.hblkhd;
+  }
+#endif
+}
+
+#ifdef HWCOUNTERS
+
+static const char *hwc_sets[][2] = {
+#ifdef PAPI
+  {"ipc",    "PAPI_TOT_CYC,PAPI_TOT_INS"},
+  {"cache",  "PAPI_L1_DCM,PAPI_L3_TCM"},
+  {"mem",    "PAPI_L3_TCM,PAPI_L3_TCA"},
+  {"stall",  "PAPI_TOT_CYC,PAPI_STL_ICY,PAPI_RES_STL"},
+  {"vector", "PAPI_VEC_DP,PAPI_DP_OPS"},
+#else
+  {"ipc",    "cycles,instructions"},
+  {"cache",  "l1d_miss,llc_miss"},
+  {"mem",    "llc_miss,llc_ref"},
+  {"stall",  "cycles,stall_front,stall_back"},
+  {"vector", "fp_dp_scalar,fp_dp_128,fp_dp_256,fp_dp_512"},
+#endif
+};
+#define HWC_NSET (int)(sizeof(hwc_sets)/sizeof(hwc_sets[0]))
+
+/* derived columns look for these names */
+#ifdef PAPI
+#define HWC_CYC  "PAPI_TOT_CYC"
+#define HWC_INS  "PAPI_TOT_INS"
+#define HWC_STL  "PAPI_RES_STL"
+#define HWC_LLC  "PAPI_L3_TCM"
+#else
+#define HWC_CYC  "cycles"
+#define HWC_INS  "instructions"
+#define HWC_STL  "stall_back"
+#define HWC_LLC  "llc_miss"
+#endif
+
+static void hwc_add(const char *name)
+{
+  int k;
+  for (k=0; k<hwc_nev; k++) if (!strcmp(hwc_name[k],name)) return;
+  if (hwc_nev == HWC_NEV) {
+    printf("nek_timer: more than %d counters, %s dropped\n",HWC_NEV,name);
+    return;
+  }
+  strncpy(hwc_name[hwc_nev],name,HWC_NAME-1);
+  hwc_name[hwc_nev++][HWC_NAME-1] = '\0';
+}
+
+/* expand a comma separated list of sets and event names */
+static void hwc_parse(const char *list, int level)
+{
+  char buf[256], *tok, *save;
+  int i;
+
+  strncpy(buf,list,sizeof(buf)-1);
+  buf[sizeof(buf)-1] = '\0';
+  for (tok = strtok_r(buf,", ",&save); tok; tok = strtok_r(NULL,", ",&save)) {
+    for (i=0; i<HWC_NSET; i++) if (!strcmp(tok,hwc_sets[i][0])) break;
+    if (i < HWC_NSET && level == 0) hwc_parse(hwc_sets[i][1],1);
+    else hwc_add(tok);
+  }
+}
+
+static void hwc_config()
+{
+  const char *ev = getenv("NEK_HWC");
+
+  if (!ev) ev = "ipc,cache";
+  if (!strcmp(ev,"none")) return;
+  hwc_parse(ev,0);
+#ifdef PAPI
+  if (PAPI_is_initialized() == PAPI_NOT_INITED &&
+      PAPI_library_init(PAPI_VER_CURRENT) != PAPI_VER_CURRENT) {
+    printf("nek_timer: PAPI_library_init failed, no counters\n");
+    hwc_nev = 0;
+    return;
+  }
+  PAPI_thread_init((unsigned long (*)(void)) pthread_self);
+#endif
+}
+
+/* is region name in NEK_HWC_REGIONS? */
+static int hwc_region(const char *name)
+{
+  const char *list = getenv("NEK_HWC_REGIONS");
+
+  if (hwc_nev == 0) return 0;
+  if (!list || !strcmp(list,"all")) return 1;
+  return in_list(list,name);
+}
+
+#ifdef PAPI
+
+static void hwc_open(hwc_ctx *h)
+{
+  int k;
+
+  h->n = 0;
+  h->evset = PAPI_NULL;
+  if (PAPI_create_eventset(&h->evset) != PAPI_OK) return;
+  for (k=0; k<hwc_nev; k++)
+    if (PAPI_add_named_event(h->evset,hwc_name[k]) == PAPI_OK)
+      h->idx[h->n++] = k;
+  if (h->n && PAPI_start(h->evset) != PAPI_OK) h->n = 0;
+}
+
+static void hwc_read(hwc_ctx *h, tick_t *c)
+{
+  long long v[HWC_NEV];
+  int i;
+
+  if (PAPI_read(h->evset,v) != PAPI_OK) return;
+  for (i=0; i<h->n; i++) c[h->idx[i]] = (tick_t)v[i];
+}
+
+#else
+
+static int hwc_perf_attr(const char *name, struct perf_event_attr *a)
+{
+  static const struct { const char *name; unsigned type; tick_t config; }
+  tab[] = {
+    {"cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_miss",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"llc_ref",      PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"stall_front",  PERF_TYPE_HARDWARE,
+                     PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+    {"stall_back",   PERF_TYPE_HARDWARE,
+                     PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    {"l1d_miss",     PERF_TYPE_HW_CACHE,
+                     PERF_COUNT_HW_CACHE_L1D |
+                     PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                     PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+    {"fp_dp_scalar", PERF_TYPE_RAW, 0x01c7},
+    {"fp_dp_128",    PERF_TYPE_RAW, 0x04c7},
+    {"fp_dp_256",    PERF_TYPE_RAW, 0x10c7},
+    {"fp_dp_512",    PERF_TYPE_RAW, 0x40c7},
+  };
+  int i;
+
+  memset(a,0,sizeof(*a));
+  a->size = sizeof(*a);
+  for (i=0; i<(int)(sizeof(tab)/sizeof(tab[0])); i++)
+    if (!strcmp(name,tab[i].name)) {
+      a->type   = tab[i].type;
+      a->config = tab[i].config;
+      return 0;
+    }
+  if (name[0] == 'r' && name[1]) {            /* raw event rXXXX */
+    char *end;
+    a->type   = PERF_TYPE_RAW;
+    a->config = strtoull(name+1,&end,16);
+    return *end ? -1 : 0;
+  }
+  return -1;
+}
+
+static void hwc_open(hwc_ctx *h)
+{
+  struct perf_event_attr a;
+  int k, fd;
+
+  h->n = 0;
+  for (k=0; k<hwc_nev; k++) {
+    if (hwc_perf_attr(hwc_name[k],&a)) continue;
+    a.exclude_kernel = 1;
+    a.exclude_hv     = 1;
+    a.read_format    = PERF_FORMAT_GROUP |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd = (int) syscall(__NR_perf_event_open,&a,0,-1,
+                       h->n ? h->fd[0] : -1,0);
+    if (fd < 0) continue;
+    h->fd[h->n]    = fd;
+    h->idx[h->n++] = k;
+  }
+}
+
+static void hwc_read(hwc_ctx *h, tick_t *c)
+{
+  tick_t v[3+HWC_NEV];
+  int i;
+
+  if (read(h->fd[0],v,(3+h->n)*sizeof(tick_t)) <= 0) return;
+  h->enabled = v[1];
+  h->running = v[2];
+  for (i=0; i<(int)v[0] && i<h->n; i++) c[h->idx[i]] = v[3+i];
+}
+
+#endif
+
+#else
+
+static void hwc_config() {}
+static int  hwc_region(const char *name) { (void)name; return 0; }
+static void hwc_open(hwc_ctx *h) { h->n = 0; }
+static void hwc_read(hwc_ctx *h, tick_t *c) { (void)h; (void)c; }
+
+#endif
+
+static tmr_state *tmr_attach()
+{
+  tmr_state *s = (tmr_state *) calloc(1,sizeof(tmr_state));
+  if (!s) return NULL;
+  s->nnode = 1;                       /* node 0 is the root */
+  s->node[0].parent = -1;
+  s->node[0].reg    = -1;
+  s->stack[0]       = 0;
+  if (hwc_nev) hwc_open(&s->hwc);
+  do s->next = tmr_list;
+  while (!__sync_bool_compare_and_swap(&tmr_list,s->next,s));
+  tmr_self = s;
+  return s;
+}
+
+/* intern a region name (trailing blanks dropped), id > 0 on return */
+void nek_timer_id(const char *name, int *id, int nlen)
+{
+  char buf[TMR_NAME];
+  int i,n = nlen;
+
+  while (n > 0 && name[n-1] == ' ') n--;
+  if (n > TMR_NAME-1) n = TMR_NAME-1;
+  memcpy(buf,name,n);
+  buf[n] = '\0';
+
+  while (__sync_lock_test_and_set(&reg_lock,1));
+  if (nreg == 0) {
+    wall0 = wall_now();
+    tick0 = tick_now();
+    hwc_config();
+    mem_config();
+  }
+  for (i=0; i<nreg; i++) if (!strcmp(reg_name[i],buf)) break;
+  if (i == nreg) {
+    if (nreg < TMR_NREG) {
+      reg_hwc[nreg] = hwc_region(buf);
+      reg_mem[nreg] = mem_region(buf);
+      strcpy(reg_name[nreg++],buf);
+    } else i = -1;
+  }
+  __sync_lock_release(&reg_lock);
+
+  if (i < 0) {
+    printf("nek_timer_id(): too many regions, %s not timed\n",buf);
+    *id = -1;
+  } else
+    *id = i+1;
+}
+
+void nek_timer_push(const int *id)
+{
+  tmr_state *s = tmr_self;
+  int r = *id - 1, p, c;
+
+  if (r < 0) return;
+  if (!s && !(s = tmr_attach())) return;
+  if (s->sp >= TMR_DEPTH-1) { s->bad++; return; }
+
+  p = s->stack[s->sp];
+  c = s->child[p][r] - 1;
+  if (c < 0) {
+    if (s->nnode == TMR_NNODE) { s->bad++; return; }
+    c = s->nnode++;
+    s->node[c].parent = p;
+    s->node[c].reg    = r;
+    s->node[c].depth  = s->node[p].depth + 1;
+    s->child[p][r]    = c + 1;
+  }
+  s->stack[++s->sp] = c;
+  s->msamp[s->sp] = reg_mem[r] && (s == mem_self || (!mem_self &&
+                    __sync_bool_compare_and_swap(&mem_self,NULL,s)));
+  if (s->msamp[s->sp]) mem_sample(s->m0[s->sp]);
+  if (reg_hwc[r] && s->hwc.n) hwc_read(&s->hwc,s->c0[s->sp]);
+  s->t0[s->sp] = tick_now();
+}
+
+void nek_timer_pop(const int *id)
+{
+  tick_t t = tick_now();
+  tmr_state *s = tmr_self;
+  tmr_node *nd;
+
+  if (*id <= 0 || !s) return;
+  if (s->sp == 0) { s->bad++; return; }
+  nd = &s->node[s->stack[s->sp]];
+  if (nd->reg != *id - 1) { s->bad++; return; }
+  nd->ticks += t - s->t0[s->sp];
+  nd->calls++;
+  if (reg_hwc[nd->reg] && s->hwc.n) {
+    tick_t c[HWC_NEV];
+    int k;
+    memcpy(c,s->c0[s->sp],sizeof(c));
+    hwc_read(&s->hwc,c);
+    for (k=0; k<hwc_nev; k++) nd->cnt[k] += c[k] - s->c0[s->sp][k];
+  }
+  if (s->msamp[s->sp]) {
+    double v[3], *v0 = s->m0[s->sp], pk;
+    mem_sample(v);
+    pk = v[1] > v0[1] ? v[1] : (v[0] > v0[0] ? v[0] : v0[0]);
+    nd->mem[0] += v[0] - v0[0];
+    if (pk > nd->mem[1]) nd->mem[1] = pk;
+    nd->mem[2] += v[1] - v0[1];
+    nd->mem[3] += v[2] - v0[2];
+  }
+  s->sp--;
+}
+
+/* '/'-joined region names from the root down to node i */
+static void node_path(const tmr_state *s, int i, char *path)
+{
+  const char *part[TMR_DEPTH];
+  int k, n = 0;
+
+  for (; i > 0 && n < TMR_DEPTH; i = s->node[i].parent)
+    part[n++] = reg_name[s->node[i].reg];
+  path[0] = '\0';
+  for (k=n-1; k>=0; k--) {
+    if (strlen(path) + strlen(part[k]) + 2 > TMR_PATH) break;
+    strcat(path,part[k]);
+    if (k) strcat(path,"/");
+  }
+}
+
+/* order paths so that children follow their parent */
+static const char *sort_paths;
+
+static int path_key(unsigned char c)
+{
+  return c == '\0' ? 0 : (c == '/' ? 1 : (int)c + 2);
+}
+
+static int path_cmp(const void *a, const void *b)
+{
+  const unsigned char *p, *q;
+  p = (const unsigned char *) sort_paths + *(const int *)a*TMR_PATH;
+  q = (const unsigned char *) sort_paths + *(const int *)b*TMR_PATH;
+  for (; *p && *p == *q; p++, q++);
+  return path_key(*p) - path_key(*q);
+}
+
+#ifdef HWCOUNTERS
+/* counter table of the sampled regions: per rank avg and max */
+static void hwc_report(int npath, int np, const char *paths,
+                       const int *depth, const double *tsum,
+                       const double *hsum, const double *hmax, int mux)
+{
+  const int nh = HWC_NEV;
+  int icyc = -1, iins = -1, istl = -1, illc = -1, j, k, r;
+
+  for (k=0; k<hwc_nev; k++) {
+    if (!strcmp(hwc_name[k],HWC_CYC)) icyc = k;
+    if (!strcmp(hwc_name[k],HWC_INS)) iins = k;
+    if (!strcmp(hwc_name[k],HWC_STL)) istl = k;
+    if (!strcmp(hwc_name[k],HWC_LLC)) illc = k;
+  }
+
+#ifdef PAPI
+  printf("hardware counters per rank (PAPI)\n");
+#else
+  printf("hardware counters per rank (perf_event)\n");
+#endif
+  printf("  %-30s %3s","region","");
+  for (k=0; k<hwc_nev; k++) printf(" %11.11s",hwc_name[k]);
+  printf(" %6s %6s %8s\n","IPC","stall%","LLC GB/s");
+
+  for (j=0; j<npath; j++) {
+    const char *leaf = strrchr(paths+j*TMR_PATH,'/');
+    const double *h;
+    int ind = 2*(depth[j]-1), any = 0;
+    double tavg = tsum[j]/np;
+
+    for (k=0; k<hwc_nev; k++) if (hsum[j*nh+k] > 0) any = 1;
+    if (!any) continue;
+    if (ind > 20) ind = 20;
+    leaf = leaf ? leaf+1 : paths+j*TMR_PATH;
+
+    for (r=0; r<2; r++) {
+      double s = r ? 1.0 : 1.0/np;
+      h = (r ? hmax : hsum) + j*nh;
+      printf("  %*s%-*s %3s",ind,"",30-ind,r ? "" : leaf,r ? "max" : "avg");
+      for (k=0; k<hwc_nev; k++) printf(" %11.4e",s*h[k]);
+      if (r == 0 && icyc >= 0 && h[icyc] > 0) {
+        printf(" %6.2f",iins >= 0 ? h[iins]/h[icyc] : 0.0);
+        printf(" %6.1f",istl >= 0 ? 100*h[istl]/h[icyc] : 0.0);
+      } else if (r == 0)
+        printf(" %6s %6s","-","-");
+      if (r == 0 && illc >= 0 && tavg > 0)
+        printf(" %8.3f",64e-9*s*h[illc]/tavg);
+      printf("\n");
+    }
+  }
+  for (k=0; k<hwc_nev; k++) {
+    for (j=0; j<npath; j++) if (hsum[j*nh+k] > 0) break;
+    if (j == npath) printf("  %s: not counted (unsupported or no access)\n",
+                           hwc_name[k]);
+  }
+  if (mux) printf("  warning: counters multiplexed on %d threads, "
+                  "values are partial\n",mux);
+  printf("\n");
+}
+#else
+static void hwc_report(int npath, int np, const char *paths,
+                       const int *depth, const double *tsum,
+                       const double *hsum, const double *hmax, int mux)
+{
+  (void)npath; (void)np; (void)paths; (void)depth;
+  (void)tsum; (void)hsum; (void)hmax; (void)mux;
+}
+#endif
+
+/* memory table of the sampled regions: per rank avg, min and max [MB] */
+static void mem_report(int npath, int np, const char *paths,
+                       const int *depth, const long long *csum,
+                       const double *msum, const double *mmin,
+                       const double *mmax, const double *proc)
+{
+  const int nm = MEM_NV;
+  const double mb = 1.0/(1024*1024);
+  double *excl, best = 0;
+  int j, k, r, ipk = -1;
+
+  /* hwm growth not explained by a sampled child marks the peak phase */
+  excl = (double *) malloc((npath+1)*sizeof(double));
+  if (!excl) return;
+  for (j=0; j<npath; j++) {
+    size_t n = strlen(paths+j*TMR_PATH);
+    excl[j] = msum[j*nm+2];
+    for (k=j+1; k<npath && !strncmp(paths+k*TMR_PATH,paths+j*TMR_PATH,n)
+                && paths[k*TMR_PATH+n] == '/'; k++)
+      if (depth[k] == depth[j]+1) excl[j] -= msum[k*nm+2];
+    if (excl[j] > best) { best = excl[j]; ipk = j; }
+  }
+
+  printf("memory per rank [MB] (%d ranks, RSS min %.1f avg %.1f max %.1f,"
+         " peak min %.1f avg %.1f max %.1f)\n",np,mb*proc[4],
+         mb*proc[0]/np,mb*proc[2],mb*proc[5],mb*proc[1]/np,mb*proc[3]);
+  printf("  %-30s %3s %10s %10s %10s %10s %10s\n","region","",
+         "calls","drss","peak","hwm+","dheap");
+  for (j=0; j<npath; j++) {
+    const char *leaf = strrchr(paths+j*TMR_PATH,'/');
+    int ind = 2*(depth[j]-1);
+    if (mmax[j*nm+1] <= 0) continue;
+    if (ind > 20) ind = 20;
+    leaf = leaf ? leaf+1 : paths+j*TMR_PATH;
+    for (r=0; r<3; r++) {
+      const double *m = (r == 2 ? mmax : r ? mmin : msum) + j*nm;
+      double f = r ? mb : mb/np;
+      printf("  %*s%-*s %3s",ind,"",30-ind,r ? "" : leaf,
+             r == 2 ? "max" : r ? "min" : "avg");
+      if (r) printf(" %10s","");
+      else   printf(" %10lld",(long long)(csum[j]/np));
+      for (k=0; k<nm; k++) printf(" %10.1f",f*m[k]);
+      printf("%s\n",r == 0 && j == ipk ? "  <- peak" : "");
+    }
+  }
+  printf("  (drss/dheap: summed change over the calls, peak: highest RSS\n"
+         "   seen, hwm+: growth of the process high watermark inside)\n\n");
+  free(excl);
+}
+
+static void report(const int *comm, int what)
+{
+  tmr_state *s;
+  char *paths, path[TMR_PATH];
+  double *tloc, *tmin, *tmax, *tsum, spt, wall;
+  long long *cloc, *csum;
+  double *hloc, *hsum, *hmax;
+  double *mloc, *msum, *mmin, *mmax, proc[6];
+  int *depth;
+  int npath = 0, bad = 0, mux = 0, nid = 0, np = 1, i, j, k;
+  size_t cap = TMR_NNODE;
+  const int nh = HWC_NEV, nm = MEM_NV;
+
+  if (nreg == 0) return;
+  if (what == 2 && mem_statm < 0) return;
+  spt  = sec_per_tick();
+  wall = wall_now() - wall0;
+
+  {
+    double v[3];
+    mem_sample(v);
+    proc[0] = proc[2] = proc[4] = v[0];
+    proc[1] = proc[3] = proc[5] = v[1];
+  }
+
+#ifdef MPI
+  MPI_Comm c_comm = MPI_Comm_f2c(*comm);
+  MPI_Comm_rank(c_comm,&nid);
+  MPI_Comm_size(c_comm,&np);
+#else
+  (void)comm;
+#endif
+
+  /* local tree: all threads merged by path */
+  for (s = tmr_list; s; s = s->next) cap += s->nnode;
+  paths = (char *)      calloc(cap,TMR_PATH);
+  tloc  = (double *)    calloc(4*cap,sizeof(double));
+  cloc  = (long long *) calloc(2*cap,sizeof(long long));
+  depth = (int *)       calloc(cap,sizeof(int));
+  hloc  = (double *)    calloc(3*cap*nh,sizeof(double));
+  mloc  = (double *)    calloc(4*cap*nm,sizeof(double));
+  if (!paths || !tloc || !cloc || !depth || !hloc || !mloc) {
+    printf("nek_timer_report(): out of memory\n");
+    return;
+  }
+  tmin = tloc + cap; tmax = tmin + cap; tsum = tmax + cap;
+  csum = cloc + cap;
+  hsum = hloc + cap*nh; hmax = hsum + cap*nh;
+  msum = mloc + cap*nm; mmin = msum + cap*nm; mmax = mmin + cap*nm;
+
+  for (s = tmr_list; s; s = s->next) {
+    bad += s->bad;
+    if (s->hwc.running < s->hwc.enabled) mux++;
+    for (i=1; i<s->nnode; i++) {
+      node_path(s,i,path);
+      for (j=0; j<npath; j++) if (!strcmp(paths+j*TMR_PATH,path)) break;
+      if (j == npath) {
+        strcpy(paths+j*TMR_PATH,path);
+        depth[j] = s->node[i].depth;
+        npath++;
+      }
+      tloc[j] += spt*(double)s->node[i].ticks;
+      cloc[j] += s->node[i].calls;
+      for (k=0; k<hwc_nev; k++) hloc[j*nh+k] += (double)s->node[i].cnt[k];
+      for (k=0; k<nm; k++) {
+        double m = s->node[i].mem[k];
+        if (k != 1)                  mloc[j*nm+k] += m;
+        else if (m > mloc[j*nm+k])   mloc[j*nm+k]  = m;
+      }
+    }
+  }
+
+  {
+    int *perm = (int *) malloc(cap*sizeof(int));
+    char *p2 = (char *) malloc(cap*TMR_PATH);
+    if (perm && p2) {
+      for (j=0; j<npath; j++) perm[j] = j;
+      sort_paths = paths;
+      qsort(perm,npath,sizeof(int),path_cmp);
+      for (j=0; j<npath; j++) {
+        memcpy(p2+j*TMR_PATH,paths+perm[j]*TMR_PATH,TMR_PATH);
+        tsum[j] = tloc[perm[j]];
+        csum[j] = cloc[perm[j]];
+        tmin[j] = depth[perm[j]];
+        memcpy(hsum+j*nh,hloc+perm[j]*nh,nh*sizeof(double));
+        memcpy(msum+j*nm,mloc+perm[j]*nm,nm*sizeof(double));
+      }
+      memcpy(paths,p2,npath*TMR_PATH);
+      for (j=0; j<npath; j++) {
+        tloc[j]  = tsum[j];
+        cloc[j]  = csum[j];
+        depth[j] = (int)tmin[j];
+      }
+      memcpy(hloc,hsum,npath*nh*sizeof(double));
+      memcpy(mloc,msum,npath*nm*sizeof(double));
+    }
+    free(perm); free(p2);
+  }
+
+#ifdef MPI
+  {
+    /* align to the paths of rank 0 */
+    double *t2;
+    long long *c2;
+    char *p0;
+    int n0 = npath, *d0;
+
+    MPI_Bcast(&n0,1,MPI_INT,0,c_comm);
+    t2 = (double *)    calloc(n0+1,sizeof(double));
+    c2 = (long long *) calloc(n0+1,sizeof(long long));
+    d0 = (int *)       calloc(n0+1,sizeof(int));
+    p0 = (char *)      calloc(n0+1,TMR_PATH);
+    if (!t2 || !c2 || !d0 || !p0) {
+      printf("nek_timer_report(): out of memory\n");
+      MPI_Abort(c_comm,1);
+    }
+    if (nid == 0) {
+      memcpy(p0,paths,n0*TMR_PATH);
+      memcpy(d0,depth,n0*sizeof(int));
+    }
+    MPI_Bcast(p0,n0*TMR_PATH,MPI_CHAR,0,c_comm);
+    MPI_Bcast(d0,n0,MPI_INT,0,c_comm);
+    for (k=0; k<n0; k++)
+      for (j=0; j<npath; j++)
+        if (!strcmp(p0+k*TMR_PATH,paths+j*TMR_PATH)) {
+          t2[k] = tloc[j];
+          c2[k] = cloc[j];
+          break;
+        }
+    MPI_Reduce(t2,tmin,n0,MPI_DOUBLE,MPI_MIN,0,c_comm);
+    MPI_Reduce(t2,tmax,n0,MPI_DOUBLE,MPI_MAX,0,c_comm);
+    MPI_Reduce(t2,tsum,n0,MPI_DOUBLE,MPI_SUM,0,c_comm);
+    MPI_Reduce(c2,csum,n0,MPI_LONG_LONG,MPI_SUM,0,c_comm);
+    k = bad;
+    MPI_Reduce(&k,&bad,1,MPI_INT,MPI_SUM,0,c_comm);
+    if (hwc_nev) {
+      double *h2 = (double *) calloc(n0*nh+1,sizeof(double));
+      if (!h2) {
+        printf("nek_timer_report(): out of memory\n");
+        MPI_Abort(c_comm,1);
+      }
+      for (k=0; k<n0; k++)
+        for (j=0; j<npath; j++)
+          if (!strcmp(p0+k*TMR_PATH,paths+j*TMR_PATH)) {
+            memcpy(h2+k*nh,hloc+j*nh,nh*sizeof(double));
+            break;
+          }
+      MPI_Reduce(h2,hsum,n0*nh,MPI_DOUBLE,MPI_SUM,0,c_comm);
+      MPI_Reduce(h2,hmax,n0*nh,MPI_DOUBLE,MPI_MAX,0,c_comm);
+      k = mux;
+      MPI_Reduce(&k,&mux,1,MPI_INT,MPI_SUM,0,c_comm);
+      free(h2);
+    }
+    if (mem_statm >= 0) {
+      double *m2 = (double *) calloc(n0*nm+1,sizeof(double));
+      if (!m2) {
+        printf("nek_timer_report(): out of memory\n");
+        MPI_Abort(c_comm,1);
+      }
+      for (k=0; k<n0; k++)
+        for (j=0; j<npath; j++)
+          if (!strcmp(p0+k*TMR_PATH,paths+j*TMR_PATH)) {
+            memcpy(m2+k*nm,mloc+j*nm,nm*sizeof(double));
+            break;
+          }
+      MPI_Reduce(m2,msum,n0*nm,MPI_DOUBLE,MPI_SUM,0,c_comm);
+      MPI_Reduce(m2,mmin,n0*nm,MPI_DOUBLE,MPI_MIN,0,c_comm);
+      MPI_Reduce(m2,mmax,n0*nm,MPI_DOUBLE,MPI_MAX,0,c_comm);
+      MPI_Allreduce(MPI_IN_PLACE,proc,2,MPI_DOUBLE,MPI_SUM,c_comm);
+      MPI_Allreduce(MPI_IN_PLACE,proc+2,2,MPI_DOUBLE,MPI_MAX,c_comm);
+      MPI_Allreduce(MPI_IN_PLACE,proc+4,2,MPI_DOUBLE,MPI_MIN,c_comm);
+      free(m2);
+    }
+    npath = n0;
+    free(t2); free(c2); free(d0); free(p0);
+  }
+#else
+  for (j=0; j<npath; j++) {
+    tmin[j] = tmax[j] = tsum[j] = tloc[j];
+    csum[j] = cloc[j];
+  }
+  memcpy(hsum,hloc,npath*nh*sizeof(double));
+  memcpy(hmax,hloc,npath*nh*sizeof(double));
+  memcpy(msum,mloc,npath*nm*sizeof(double));
+  memcpy(mmin,mloc,npath*nm*sizeof(double));
+  memcpy(mmax,mloc,npath*nm*sizeof(double));
+#endif
+
+  if (nid == 0 && (what & 1)) {
+    printf("\nregion timers [s] (%d ranks, wall %11.4e)\n",np,wall);
+    printf("  %-36s %12s %11s %11s %11s %6s\n",
+           "region","calls/rank","min","avg","max","%wall");
+    for (j=0; j<npath; j++) {
+      const char *leaf = strrchr(paths+j*TMR_PATH,'/');
+      double tavg = tsum[j]/np;
+      int ind = 2*(depth[j]-1);
+      if (ind > 24) ind = 24;
+      leaf = leaf ? leaf+1 : paths+j*TMR_PATH;
+      printf("  %*s%-*s %12lld %11.4e %11.4e %11.4e %6.2f\n",
+             ind,"",36-ind,leaf,(long long)(csum[j]/np),
+             tmin[j],tavg,tmax[j],wall > 0 ? 100.0*tavg/wall : 0.0);
+    }
+    if (bad) printf("  warning: %d unbalanced push/pop or table overflows\n",
+                    bad);
+    printf("\n");
+    if (hwc_nev) hwc_report(npath,np,paths,depth,tsum,hsum,hmax,mux);
+  }
+  if (nid == 0 && (what & 2) && mem_statm >= 0) {
+    if (!(what & 1)) printf("\n");
+    mem_report(npath,np,paths,depth,csum,msum,mmin,mmax,proc);
+  }
+  if (nid == 0) fflush(stdout);
+
+  free(paths); free(tloc); free(cloc); free(depth); free(hloc);
+  free(mloc);
+}
+
+void nek_timer_report(const int *comm)
+{
+  report(comm,3);
+}
+
+void nek_mem_report(const int *comm)
+{
+  report(comm,2);
+}
@@ -0,0 +1,249 @@
+/*
+ * Scratch workspace arena
+ *
+ * Fortran usage (see WSPACE):
+ *
+ *      include 'WSPACE'
+ *      call nek_ws_push
+ *      kw = nek_ws_r(n)              ! n reals,    ws(kw)
+ *      ki = nek_ws_i(m)              ! m integers, iws(ki)
+ *      kl = nek_ws_i8(m)             ! m integer*8, iws8(kl)
+ *      call foo(ws(kw),iws(ki),...)
+ *      call nek_ws_pop
+ *
+ * nek_ws_loc(a) maps an existing real array onto ws (ws(k) is a(1)),
+ * e.g. to keep a device resident common under OpenACC.  nek_ws_loc4(a)
+ * does the same for the real*4 view ws4, for single precision data
+ * stored in a real array.
+ *
+ * nek_ws_rkeep(n) / nek_ws_ikeep(n) reserve a block outside the frames
+ * that stays until nek_ws_rfree(k) / nek_ws_ifree(k), for data cached
+ * between calls; it is addressed through ws / iws the same way.
+ *
+ * Blocks are carved from a per-thread stack of 64-byte aligned chunks
+ * and handed back to Fortran as indices relative to the /nekws/ base
+ * registered by nek_ws_init.  nek_ws_pop releases everything reserved
+ * since the matching push.  The largest chunk released is kept as a
+ * spare for the next frame so solver iterations do not go back to the
+ * system, nek_ws_trim drops it (after setup).  The resident size thus
+ * follows the current problem, not the lelt bound.
+ *
+ * nek_ws_stats(cur,peak,held) returns the bytes in use by the calling
+ * thread, the high watermark over all threads and the bytes the
+ * calling thread holds in chunks.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "name.h"
+
+#define nek_ws_init  FORTRAN_UNPREFIXED(nek_ws_init, NEK_WS_INIT)
+#define nek_ws_push  FORTRAN_UNPREFIXED(nek_ws_push, NEK_WS_PUSH)
+#define nek_ws_pop   FORTRAN_UNPREFIXED(nek_ws_pop,  NEK_WS_POP)
+#define nek_ws_r     FORTRAN_UNPREFIXED(nek_ws_r,    NEK_WS_R)
+#define nek_ws_i     FORTRAN_UNPREFIXED(nek_ws_i,    NEK_WS_I)
+#define nek_ws_i8    FORTRAN_UNPREFIXED(nek_ws_i8,   NEK_WS_I8)
+#define nek_ws_loc   FORTRAN_UNPREFIXED(nek_ws_loc,  NEK_WS_LOC)
+#define nek_ws_loc4  FORTRAN_UNPREFIXED(nek_ws_loc4, NEK_WS_LOC4)
+#define nek_ws_rkeep FORTRAN_UNPREFIXED(nek_ws_rkeep,NEK_WS_RKEEP)
+#define nek_ws_ikeep FORTRAN_UNPREFIXED(nek_ws_ikeep,NEK_WS_IKEEP)
+#define nek_ws_rfree FORTRAN_UNPREFIXED(nek_ws_rfree,NEK_WS_RFREE)
+#define nek_ws_ifree FORTRAN_UNPREFIXED(nek_ws_ifree,NEK_WS_IFREE)
+#define nek_ws_trim  FORTRAN_UNPREFIXED(nek_ws_trim, NEK_WS_TRIM)
+#define nek_ws_stats FORTRAN_UNPREFIXED(nek_ws_stats,NEK_WS_STATS)
+
+#define WS_ALIGN 64
+#define WS_CHUNK (8u<<20)  /* minimum chunk size                     */
+#define WS_DEPTH 32        /* frame nesting depth                    */
+
+typedef struct ws_chunk {
+  struct ws_chunk *prev;
+  size_t size, used;
+} ws_chunk;
+
+/* chunk header is padded so the payload starts 64-byte aligned */
+#define WS_HDR (((sizeof(ws_chunk)+WS_ALIGN-1)/WS_ALIGN)*WS_ALIGN)
+
+typedef struct {
+  ws_chunk *top, *spare;
+  size_t cur, peak, held;
+  int depth;
+  ws_chunk *ftop[WS_DEPTH];
+  size_t fused[WS_DEPTH], fcur[WS_DEPTH];
+} ws_state;
+
+static char  *ws_base = NULL;
+static int    ws_wdsize = 8;
+static size_t ws_peak_all = 0;
+static __thread ws_state ws_self;
+
+static void ws_abort(const char *msg, long long n)
+{
+  fprintf(stderr,"ERROR (nek_ws): %s %lld\n",msg,n);
+  fflush(stderr);
+  abort();
+}
+
+void nek_ws_init(void *base, int *wdsize)
+{
+  ws_base   = (char *)base;
+  ws_wdsize = *wdsize;
+}
+
+void nek_ws_push(void)
+{
+  ws_state *s = &ws_self;
+  if (s->depth == WS_DEPTH) ws_abort("frame depth exceeded",WS_DEPTH);
+  s->ftop[s->depth]  = s->top;
+  s->fused[s->depth] = s->top ? s->top->used : 0;
+  s->fcur[s->depth]  = s->cur;
+  s->depth++;
+}
+
+void nek_ws_pop(void)
+{
+  ws_state *s = &ws_self;
+  if (s->depth == 0) ws_abort("pop without push",0);
+  s->depth--;
+  while (s->top != s->ftop[s->depth]) {
+    ws_chunk *c = s->top;
+    s->top = c->prev;
+    if (s->spare == NULL || c->size > s->spare->size) {
+      ws_chunk *t = s->spare;
+      s->spare = c;
+      c = t;
+    }
+    if (c) {
+      s->held -= c->size;
+      free(c);
+    }
+  }
+  if (s->top) s->top->used = s->fused[s->depth];
+  s->cur = s->fcur[s->depth];
+}
+
+static char *ws_alloc(size_t nbytes)
+{
+  ws_state *s = &ws_self;
+  ws_chunk *c = s->top;
+  char *p;
+
+  if (s->depth == 0) ws_abort("allocation outside a frame",0);
+  nbytes = ((nbytes+WS_ALIGN-1)/WS_ALIGN)*WS_ALIGN;
+
+  if (c == NULL || c->size-c->used < nbytes) {
+    if (s->spare && s->spare->size >= nbytes) {
+      c = s->spare;
+      s->spare = NULL;
+    } else {
+      size_t size = nbytes > WS_CHUNK ? nbytes : WS_CHUNK;
+      void *q;
+      if (posix_memalign(&q,WS_ALIGN,WS_HDR+size))
+        ws_abort("out of memory requesting bytes",(long long)nbytes);
+      c = (ws_chunk *)q;
+      c->size  = size;
+      s->held += size;
+    }
+    c->prev = s->top;
+    c->used = 0;
+    s->top  = c;
+  }
+
+  p = (char *)c + WS_HDR + c->used;
+  c->used += nbytes;
+  s->cur  += nbytes;
+  if (s->cur > s->peak) {
+    size_t old = ws_peak_all;
+    s->peak = s->cur;
+    while (s->peak > old &&
+           !__sync_bool_compare_and_swap(&ws_peak_all,old,s->peak))
+      old = ws_peak_all;
+  }
+  return p;
+}
+
+/* 1-based index of p in a Fortran array of esize-byte words at base */
+static long long ws_index(char *p, int esize)
+{
+  ptrdiff_t d;
+  if (ws_base == NULL) ws_abort("nek_ws_init not called",0);
+  d = p - ws_base;
+  if (d % esize) ws_abort("misaligned workspace base",(long long)d);
+  return (long long)(d/esize) + 1;
+}
+
+long long nek_ws_r(int *n)
+{
+  size_t nw = *n > 0 ? (size_t)*n : 1;
+  return ws_index(ws_alloc(nw*ws_wdsize),ws_wdsize);
+}
+
+long long nek_ws_i(int *n)
+{
+  size_t nw = *n > 0 ? (size_t)*n : 1;
+  return ws_index(ws_alloc(nw*sizeof(int)),sizeof(int));
+}
+
+long long nek_ws_i8(int *n)
+{
+  size_t nw = *n > 0 ? (size_t)*n : 1;
+  return ws_index(ws_alloc(nw*sizeof(long long)),sizeof(long long));
+}
+
+long long nek_ws_loc(void *a)
+{
+  return ws_index((char *)a,ws_wdsize);
+}
+
+long long nek_ws_loc4(void *a)
+{
+  return ws_index((char *)a,4);
+}
+
+static long long ws_keep(size_t nbytes, int esize)
+{
+  void *q;
+  if (posix_memalign(&q,WS_ALIGN,nbytes > 0 ? nbytes : 1))
+    ws_abort("out of memory requesting bytes",(long long)nbytes);
+  return ws_index((char *)q,esize);
+}
+
+long long nek_ws_rkeep(int *n)
+{
+  return ws_keep((*n > 0 ? (size_t)*n : 1)*ws_wdsize,ws_wdsize);
+}
+
+long long nek_ws_ikeep(int *n)
+{
+  return ws_keep((*n > 0 ? (size_t)*n : 1)*sizeof(int),sizeof(int));
+}
+
+void nek_ws_rfree(long long *k)
+{
+  if (*k != 0) free(ws_base + (*k-1)*ws_wdsize);
+  *k = 0;
+}
+
+void nek_ws_ifree(long long *k)
+{
+  if (*k != 0) free(ws_base + (*k-1)*(long long)sizeof(int));
+  *k = 0;
+}
+
+void nek_ws_trim(void)
+{
+  ws_state *s = &ws_self;
+  if (s->spare) {
+    s->held -= s->spare->size;
+    free(s->spare);
+    s->spare = NULL;
+  }
+}
+
+void nek_ws_stats(double *cur, double *peak, double *held)
+{
+  *cur  = (double)ws_self.cur;
+  *peak = (double)ws_peak_all;
+  *held = (double)ws_self.held;
+}
@@ -0,0 +1,1058 @@
+c-----------------------------------------------------------------------
+c
+c     Device offload of the Helmholtz and pressure solves (OpenACC)
+c
+c     With PPLIST OPENACC the static solver data (geometry, masks,
+c     multiplicities, fast-diagonalization and multigrid operators,
+c     GMRES and projection spaces, solver scratch) is entered on the
+c     device once by nek_acc_init.  hsolve and hmholtz bracket each
+c     eligible solve with nek_acc_begin/nek_acc_end: rhs, solution and
+c     h1/h2 cross the bus once per solve, everything else stays on the
+c     device and ifacc is set while the solve runs.  The vector ops of
+c     math.f, axhelm, dssum, the hsmg Schwarz/FDM smoother and the
+c     projection then run on the device for present arguments.
+c
+c     Direct stiffness sums run on the device as local group sums;
+c     only nodes shared with other ranks go through the host, by a
+c     second gs handle over the shared ids (nek_acc_gs_setup).  The
+c     coarse grid solve stays on the host.
+c
+c     Eligible: no axisymmetry, moving mesh or DG; the pressure with
+c     the split scheme, GMRES and h1 multigrid (param 42 = 0, 43 = 0);
+c     other fields with the Jacobi preconditioned CG of cggo.  Other
+c     solves run on the host unchanged.
+c
+c     Without OPENACC the routines below reduce to no-ops.
+c
+c-----------------------------------------------------------------------
+#ifdef _OPENACC
+#define NEK_ACC_LT ((lx1+2)*(ly1+2)*(lz1+2)*lelt)
+#else
+#define NEK_ACC_LT 1
+#endif
+c-----------------------------------------------------------------------
+      subroutine nek_acc_init
+c
+c     enter (first call) or refresh (rebal_setup) the static device data
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'HSMG'
+      include 'GMRES'
+      include 'ORTHOP'
+      include 'ORTHOT'
+      include 'VPROJ'
+      include 'OFFLOAD'
+#ifdef _OPENACC
+      include 'openacc_lib.h'
+      include 'WSPACE'
+
+      integer*8 nek_ws_rkeep
+      parameter (lmg_w=2*lxm*lym*lzm*lelt,lgm_w=lx2*ly2*lz2*lelv)
+#endif
+
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+
+      parameter (lt=lx1*ly1*lz1*lelt)
+      common /scrcg/ scd(lt)
+      common /scrmg/ scmg(4*lt)
+      common /ctmp0/ sct0(2*lt)
+      common /scrpcg/ scpcg(5*lt)
+
+      parameter (lacc_w=NEK_ACC_LT)
+      common /nekaccw/ accw(lacc_w)
+
+      integer icalld
+      save    icalld
+      data    icalld /0/
+
+      ifacc   = .false.
+      ifaccon = .false.
+      iacclev = 0
+
+#ifdef _OPENACC
+      if (icalld.eq.0) then
+         mg_kwork  = nek_ws_rkeep(lmg_w) ! hsmg_schwarz extended arrays
+         kwp_gmres = nek_ws_rkeep(lgm_w) ! uzawa_gmres preconditioner
+c$acc enter data create(ws(mg_kwork:mg_kwork+lmg_w-1))
+c$acc enter data create(ws(kwp_gmres:kwp_gmres+lgm_w-1))
+c$acc enter data create(g1m1,g2m1,g3m1,g4m1,g5m1,g6m1,bm1,binvm1,bintm1)
+c$acc enter data create(dxm1,dxtm1,dym1,dytm1,dzm1,dztm1)
+c$acc enter data create(v1mask,v2mask,v3mask,pmask,tmask,vmult,tmult)
+c$acc enter data create(wddx,wddyt,wddzt,ifdfrm,iffast)
+c$acc enter data create(mg_jh,mg_jht,mg_rstr_wt,mg_mask,mg_fast_s)
+c$acc enter data create(mg_fast_d,mg_schwarz_wt)
+c$acc enter data create(x_gmres,r_gmres,w_gmres,v_gmres,z_gmres)
+c$acc enter data create(ml_gmres,mu_gmres)
+c$acc enter data create(approxp,approxt,vproj)
+c$acc enter data create(scd,scmg,sct0,scpcg,accw)
+         icalld = 1
+         ndev = acc_get_num_devices(acc_device_not_host)
+         if (nio.eq.0) write(6,1) ndev
+    1    format(' OpenACC offload enabled,',i3,' device(s) per node')
+      endif
+
+c$acc update device(g1m1,g2m1,g3m1,g4m1,g5m1,g6m1,bm1,binvm1,bintm1)
+c$acc update device(dxm1,dxtm1,dym1,dytm1,dzm1,dztm1)
+c$acc update device(v1mask,v2mask,v3mask,pmask,tmask,vmult,tmult)
+c$acc update device(wddx,wddyt,wddzt,ifdfrm,iffast)
+c$acc update device(mg_jh,mg_jht,mg_rstr_wt,mg_mask,mg_fast_s)
+c$acc update device(mg_fast_d,mg_schwarz_wt)
+c$acc update device(approxp,approxt,vproj)
+
+      ifaccon = .true.
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      logical function nek_acc_dev(a)
+c
+c     true if a resident solve is running and a is present on the device
+c
+      real a(1)
+
+      logical         ifacc,ifaccon
+      integer         iacclev
+      common /nekacc/ ifacc,ifaccon,iacclev
+#ifdef _OPENACC
+      include 'openacc_lib.h'
+#endif
+
+      nek_acc_dev = .false.
+#ifdef _OPENACC
+      if (ifacc) nek_acc_dev = acc_is_present(a(1))
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_todev(a,n)
+c
+c     refresh the device copy of a host-computed array
+c
+      include 'OFFLOAD'
+      real a(n)
+      logical nek_acc_dev
+
+      if (nek_acc_dev(a)) then
+c$acc update device(a)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_tohost(a,n)
+c
+c     refresh the host copy of a device-computed array
+c
+      include 'OFFLOAD'
+      real a(n)
+      logical nek_acc_dev
+
+      if (nek_acc_dev(a)) then
+c$acc update self(a)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_host_push
+c
+c     run the following (setup type) code on the host copies
+c
+      include 'OFFLOAD'
+
+      parameter (lstk=8)
+      logical         ifstk(lstk)
+      integer         nstk
+      common /nekaccp/ ifstk,nstk
+      data nstk /0/
+
+      if (nstk.ge.lstk) call exitti('nek_acc_host_push: depth $',nstk)
+      nstk        = nstk+1
+      ifstk(nstk) = ifacc
+      ifacc       = .false.
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_host_pop
+
+      include 'OFFLOAD'
+
+      parameter (lstk=8)
+      logical         ifstk(lstk)
+      integer         nstk
+      common /nekaccp/ ifstk,nstk
+
+      if (nstk.le.0) call exitti('nek_acc_host_pop: empty $',nstk)
+      ifacc = ifstk(nstk)
+      nstk  = nstk-1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_begin(u,r,h1,h2,msk,mlt,bi,n,name)
+c
+c     open a device resident solve of H u = r (hsolve, hmholtz)
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'TSTEP'
+      include 'OFFLOAD'
+#ifdef _OPENACC
+      include 'openacc_lib.h'
+#endif
+
+      real u(n),r(n),h1(n),h2(n),msk(n),mlt(n),bi(n)
+      character*4 name
+
+      integer         iacnew(7)
+      common /nekacci/ iacnew
+
+      character*4 cname
+      logical ifok
+
+      if (.not.ifaccon) return
+      if (iacclev.gt.0) then
+         iacclev = iacclev+1
+         return
+      endif
+
+      call chcopy(cname,name,4)
+      call capit (cname,4)
+
+      ifok = .not.(ifaxis .or. ifmvbd .or. ifdg)
+      if (cname.eq.'PRES') ifok = ifok .and. ifsplit .and. ifmgrid
+     $                    .and. param(42).eq.0 .and. param(43).eq.0
+      if (.not.ifok) return
+
+#ifdef _OPENACC
+      do i=1,7
+         iacnew(i) = 0
+      enddo
+      if (acc_is_present(u)) then
+c$acc update device(u)
+      else
+c$acc enter data copyin(u)
+         iacnew(1) = 1
+      endif
+      if (acc_is_present(r)) then
+c$acc update device(r)
+      else
+c$acc enter data copyin(r)
+         iacnew(2) = 1
+      endif
+      if (acc_is_present(h1)) then
+c$acc update device(h1)
+      else
+c$acc enter data copyin(h1)
+         iacnew(3) = 1
+      endif
+      if (acc_is_present(h2)) then
+c$acc update device(h2)
+      else
+c$acc enter data copyin(h2)
+         iacnew(4) = 1
+      endif
+      if (.not.acc_is_present(msk)) then
+c$acc enter data copyin(msk)
+         iacnew(5) = 1
+      endif
+      if (.not.acc_is_present(mlt)) then
+c$acc enter data copyin(mlt)
+         iacnew(6) = 1
+      endif
+      if (.not.acc_is_present(bi)) then
+c$acc enter data copyin(bi)
+         iacnew(7) = 1
+      endif
+#endif
+
+      ifacc   = .true.
+      iacclev = 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_end(u,r,h1,h2,msk,mlt,bi,n)
+c
+c     close the solve opened by nek_acc_begin, u and r back to the host
+c
+      include 'OFFLOAD'
+
+      real u(n),r(n),h1(n),h2(n),msk(n),mlt(n),bi(n)
+
+      integer         iacnew(7)
+      common /nekacci/ iacnew
+
+      if (iacclev.eq.0) return
+      iacclev = iacclev-1
+      if (iacclev.gt.0) return
+
+      ifacc = .false.
+
+#ifdef _OPENACC
+      if (iacnew(1).eq.1) then
+c$acc exit data copyout(u)
+      else
+c$acc update self(u)
+      endif
+      if (iacnew(2).eq.1) then
+c$acc exit data copyout(r)
+      else
+c$acc update self(r)
+      endif
+      if (iacnew(3).eq.1) then
+c$acc exit data delete(h1)
+      endif
+      if (iacnew(4).eq.1) then
+c$acc exit data delete(h2)
+      endif
+      if (iacnew(5).eq.1) then
+c$acc exit data delete(msk)
+      endif
+      if (iacnew(6).eq.1) then
+c$acc exit data delete(mlt)
+      endif
+      if (iacnew(7).eq.1) then
+c$acc exit data delete(bi)
+      endif
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_setfast
+c
+c     push the element flags computed by setfast to the device
+c
+      include 'SIZE'
+      include 'OFFLOAD'
+
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+
+      if (.not.ifaccon) return
+c$acc update device(iffast)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine axhelm_acc(au,u,helm1,nel)
+c
+c     au = helm1*[A]u on the device, nel elements (no axisymmetry)
+c
+      include 'SIZE'
+      include 'DXYZ'
+      include 'GEOM'
+
+      COMMON /FASTAX/ WDDX(LX1,LX1),WDDYT(LY1,LY1),WDDZT(LZ1,LZ1)
+      COMMON /FASTMD/ IFDFRM(LELT), IFFAST(LELT), IFH2, IFSOLV
+      LOGICAL IFDFRM, IFFAST, IFH2, IFSOLV
+
+      real au(lx1,ly1,lz1,nel),u(lx1,ly1,lz1,nel),helm1(lx1,ly1,lz1,nel)
+
+      real ur(lx1,ly1,lz1),us(lx1,ly1,lz1),ut(lx1,ly1,lz1)
+      integer e
+
+      if (ldim.eq.3) then
+
+c$acc parallel loop gang default(present) private(ur,us,ut)
+      do e=1,nel
+         if (iffast(e)) then
+            h = helm1(1,1,1,e)
+c$acc loop vector collapse(3) private(sr,ss,st)
+            do k=1,lz1
+            do j=1,ly1
+            do i=1,lx1
+               sr = 0
+               ss = 0
+               st = 0
+               do l=1,lx1
+                  sr = sr + wddx(i,l)*u(l,j,k,e)
+                  ss = ss + u(i,l,k,e)*wddyt(l,j)
+                  st = st + u(i,j,l,e)*wddzt(l,k)
+               enddo
+               au(i,j,k,e) = h*( g4m1(i,j,k,e)*sr
+     $                         + g5m1(i,j,k,e)*ss
+     $                         + g6m1(i,j,k,e)*st )
+            enddo
+            enddo
+            enddo
+         else
+c$acc loop vector collapse(3) private(sr,ss,st,h)
+            do k=1,lz1
+            do j=1,ly1
+            do i=1,lx1
+               sr = 0
+               ss = 0
+               st = 0
+               do l=1,lx1
+                  sr = sr + dxm1(i,l)*u(l,j,k,e)
+                  ss = ss + u(i,l,k,e)*dytm1(l,j)
+                  st = st + u(i,j,l,e)*dztm1(l,k)
+               enddo
+               h = helm1(i,j,k,e)
+               if (ifdfrm(e)) then
+                  ur(i,j,k) = h*( g1m1(i,j,k,e)*sr
+     $                          + g4m1(i,j,k,e)*ss
+     $                          + g5m1(i,j,k,e)*st )
+                  us(i,j,k) = h*( g2m1(i,j,k,e)*ss
+     $                          + g4m1(i,j,k,e)*sr
+     $                          + g6m1(i,j,k,e)*st )
+                  ut(i,j,k) = h*( g3m1(i,j,k,e)*st
+     $                          + g5m1(i,j,k,e)*sr
+     $                          + g6m1(i,j,k,e)*ss )
+               else
+                  ur(i,j,k) = h*g1m1(i,j,k,e)*sr
+                  us(i,j,k) = h*g2m1(i,j,k,e)*ss
+                  ut(i,j,k) = h*g3m1(i,j,k,e)*st
+               endif
+            enddo
+            enddo
+            enddo
+c$acc loop vector collapse(3) private(s)
+            do k=1,lz1
+            do j=1,ly1
+            do i=1,lx1
+               s = 0
+               do l=1,lx1
+                  s = s + dxtm1(i,l)*ur(l,j,k)
+     $                  + us(i,l,k)*dym1(l,j)
+     $                  + ut(i,j,l)*dzm1(l,k)
+               enddo
+               au(i,j,k,e) = s
+            enddo
+            enddo
+            enddo
+         endif
+      enddo
+
+      else
+
+c$acc parallel loop gang default(present) private(ur,us)
+      do e=1,nel
+         if (iffast(e)) then
+            h = helm1(1,1,1,e)
+c$acc loop vector collapse(2) private(sr,ss)
+            do j=1,ly1
+            do i=1,lx1
+               sr = 0
+               ss = 0
+               do l=1,lx1
+                  sr = sr + wddx(i,l)*u(l,j,1,e)
+                  ss = ss + u(i,l,1,e)*wddyt(l,j)
+               enddo
+               au(i,j,1,e) = h*( g4m1(i,j,1,e)*sr
+     $                         + g5m1(i,j,1,e)*ss )
+            enddo
+            enddo
+         else
+c$acc loop vector collapse(2) private(sr,ss,h)
+            do j=1,ly1
+            do i=1,lx1
+               sr = 0
+               ss = 0
+               do l=1,lx1
+                  sr = sr + dxm1(i,l)*u(l,j,1,e)
+                  ss = ss + u(i,l,1,e)*dytm1(l,j)
+               enddo
+               h = helm1(i,j,1,e)
+               if (ifdfrm(e)) then
+                  ur(i,j,1) = h*( g1m1(i,j,1,e)*sr
+     $                          + g4m1(i,j,1,e)*ss )
+                  us(i,j,1) = h*( g2m1(i,j,1,e)*ss
+     $                          + g4m1(i,j,1,e)*sr )
+               else
+                  ur(i,j,1) = h*g1m1(i,j,1,e)*sr
+                  us(i,j,1) = h*g2m1(i,j,1,e)*ss
+               endif
+            enddo
+            enddo
+c$acc loop vector collapse(2) private(s)
+            do j=1,ly1
+            do i=1,lx1
+               s = 0
+               do l=1,lx1
+                  s = s + dxtm1(i,l)*ur(l,j,1)
+     $                  + us(i,l,1)*dym1(l,j)
+               enddo
+               au(i,j,1,e) = s
+            enddo
+            enddo
+         endif
+      enddo
+
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_tnsr(v,nv,u,nu,a,at)
+c
+c     v = [A (x) A (x) A] u for nelv elements on the device (hsmg_tnsr)
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      real v(1),u(1),a(nv,nu),at(nu,nv)
+
+      if (if3d) then
+         call nek_acc_tnsr3(v,nv,u,nu,a,at,nelv)
+      else
+         call nek_acc_tnsr2(v,nv,u,nu,a,at,nelv)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_tnsr2(v,nv,u,nu,a,bt,nel)
+
+      include 'SIZE'
+
+      real v(nv,nv,nel),u(nu,nu,nel),a(nv,nu),bt(nu,nv)
+
+      parameter (lw=lx1+2)
+      real w(lw,lw)
+      integer e
+
+c$acc parallel loop gang default(present) private(w)
+      do e=1,nel
+c$acc loop vector collapse(2) private(s)
+         do j=1,nu
+         do i=1,nv
+            s = 0
+            do l=1,nu
+               s = s + a(i,l)*u(l,j,e)
+            enddo
+            w(i,j) = s
+         enddo
+         enddo
+c$acc loop vector collapse(2) private(s)
+         do j=1,nv
+         do i=1,nv
+            s = 0
+            do l=1,nu
+               s = s + w(i,l)*bt(l,j)
+            enddo
+            v(i,j,e) = s
+         enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_tnsr3(v,nv,u,nu,a,bt,nel)
+
+      include 'SIZE'
+
+      real v(nv,nv,nv,nel),u(nu,nu,nu,nel),a(nv,nu),bt(nu,nv)
+
+      parameter (lw=lx1+2)
+      real w1(lw,lw,lw),w2(lw,lw,lw)
+      integer e
+
+c$acc parallel loop gang default(present) private(w1,w2)
+      do e=1,nel
+c$acc loop vector collapse(3) private(s)
+         do k=1,nu
+         do j=1,nu
+         do i=1,nv
+            s = 0
+            do l=1,nu
+               s = s + a(i,l)*u(l,j,k,e)
+            enddo
+            w1(i,j,k) = s
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(s)
+         do k=1,nu
+         do j=1,nv
+         do i=1,nv
+            s = 0
+            do l=1,nu
+               s = s + w1(i,l,k)*bt(l,j)
+            enddo
+            w2(i,j,k) = s
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(s)
+         do k=1,nv
+         do j=1,nv
+         do i=1,nv
+            s = 0
+            do l=1,nu
+               s = s + w2(i,j,l)*bt(l,k)
+            enddo
+            v(i,j,k,e) = s
+         enddo
+         enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_tnsr1(v,nv,nu,a,at)
+c
+c     in-place hsmg_tnsr1 on the device, through the accw scratch
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      real v(1),a(1),at(1)
+
+      parameter (lacc_w=NEK_ACC_LT)
+      common /nekaccw/ accw(lacc_w)
+
+      call nek_acc_tnsr(accw,nv,v,nu,a,at)
+      call copy        (v,accw,nelv*nv**ldim)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_fdm(e,r,s,d,nl)
+c
+c     fast diagonalization solves of hsmg_do_fast on the device;
+c     like the host version r is overwritten (r = d .* S^T r)
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      real e(1),r(1),s(1),d(1)
+
+      if (if3d) then
+         call nek_acc_fdm3(e,r,s,d,nl,nelv)
+      else
+         call nek_acc_fdm2(e,r,s,d,nl,nelv)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_fdm2(e,r,s,d,nl,nel)
+
+      include 'SIZE'
+
+      real e(nl,nl,nel),r(nl,nl,nel),s(nl,nl,2,2,nel),d(nl,nl,nel)
+
+      parameter (lw=lx1+2)
+      real w(lw,lw)
+      integer ie
+
+c$acc parallel loop gang default(present) private(w)
+      do ie=1,nel
+c$acc loop vector collapse(2) private(t)
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + s(i,l,2,1,ie)*r(l,j,ie)
+            enddo
+            w(i,j) = t
+         enddo
+         enddo
+c$acc loop vector collapse(2) private(t)
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w(i,l)*s(l,j,1,2,ie)
+            enddo
+            r(i,j,ie) = d(i,j,ie)*t
+         enddo
+         enddo
+c$acc loop vector collapse(2) private(t)
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + s(i,l,1,1,ie)*r(l,j,ie)
+            enddo
+            w(i,j) = t
+         enddo
+         enddo
+c$acc loop vector collapse(2) private(t)
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w(i,l)*s(l,j,2,2,ie)
+            enddo
+            e(i,j,ie) = t
+         enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_fdm3(e,r,s,d,nl,nel)
+
+      include 'SIZE'
+
+      real e(nl,nl,nl,nel),r(nl,nl,nl,nel),d(nl,nl,nl,nel)
+      real s(nl,nl,2,3,nel)
+
+      parameter (lw=lx1+2)
+      real w1(lw,lw,lw),w2(lw,lw,lw)
+      integer ie
+
+c$acc parallel loop gang default(present) private(w1,w2)
+      do ie=1,nel
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + s(i,l,2,1,ie)*r(l,j,k,ie)
+            enddo
+            w1(i,j,k) = t
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w1(i,l,k)*s(l,j,1,2,ie)
+            enddo
+            w2(i,j,k) = t
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w2(i,j,l)*s(l,k,1,3,ie)
+            enddo
+            r(i,j,k,ie) = d(i,j,k,ie)*t
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + s(i,l,1,1,ie)*r(l,j,k,ie)
+            enddo
+            w1(i,j,k) = t
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w1(i,l,k)*s(l,j,2,2,ie)
+            enddo
+            w2(i,j,k) = t
+         enddo
+         enddo
+         enddo
+c$acc loop vector collapse(3) private(t)
+         do k=1,nl
+         do j=1,nl
+         do i=1,nl
+            t = 0
+            do l=1,nl
+               t = t + w2(i,j,l)*s(l,k,2,3,ie)
+            enddo
+            e(i,j,k,ie) = t
+         enddo
+         enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_mask(w,mask,nel)
+c
+c     h1mg_mask on the device: zero the Dirichlet nodes listed in mask
+c
+      real    w(1)
+      integer mask(1)
+      integer e
+
+c$acc parallel loop gang default(present)
+      do e=1,nel
+         im = mask(e)
+c$acc loop vector
+         do i=1,mask(im)
+            w(mask(im+i)) = 0.
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_gs_setup(gs_h,glo_num,n)
+c
+c     device tables for gs_h (called by setupds): the local copies of
+c     each global id with more than one local copy or shared with
+c     another rank, in groups, the shared ones first, and a gs handle
+c     over the shared ids only.  ng < 0 marks a handle whose tables did
+c     not fit; its dssum goes through the host on the whole vector.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer gs_h
+      integer*8 glo_num(n)
+
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
+
+      parameter (lacc_h=64,lacc_t=NEK_ACC_LT)
+      parameter (lacc_m=2*lacc_t,lacc_g=lacc_t)
+      integer         acc_gsh(lacc_h),acc_gn(lacc_h),acc_gng(lacc_h)
+     $               ,acc_gns(lacc_h),acc_gm0(lacc_h),acc_gg0(lacc_h)
+     $               ,acc_ghs(lacc_h),acc_nh,acc_mtop,acc_gtop
+      common /nekaccg/ acc_gsh,acc_gn,acc_gng,acc_gns,acc_gm0,acc_gg0
+     $               ,acc_ghs,acc_nh,acc_mtop,acc_gtop
+      integer         acc_gp(lacc_g+lacc_h),acc_gi(lacc_m)
+      real            acc_gb(lacc_g)
+      common /nekaccq/ acc_gb,acc_gp,acc_gi
+
+      integer   ti(2,lacc_t)
+      integer*8 tl(lacc_t)
+      real      wmin(lacc_t),wmax(lacc_t)
+      common /nekaccs/ tl,ti,wmin,wmax
+#ifdef _OPENACC
+      real      vr(1)
+      integer h,g0,key(2),iglmax
+      integer*8 gg
+#endif
+
+      integer icalld
+      save    icalld
+      data    icalld /0/
+
+#ifdef _OPENACC
+      if (icalld.eq.0) then
+         acc_nh   = 0
+         acc_mtop = 0
+         acc_gtop = 0
+c$acc enter data create(acc_gp,acc_gi,acc_gb)
+         icalld = 1
+      endif
+
+      ierr = 0
+      if (acc_nh.ge.lacc_h) call exitti('nek_acc_gs_setup: max $',
+     $                                    lacc_h)
+      if (n.gt.lacc_t) ierr = 1
+
+      h = acc_nh+1
+      acc_nh     = h
+      acc_gsh(h) = gs_h
+      acc_gn(h)  = n
+      acc_gng(h) = -1
+      acc_gns(h) = 0
+      acc_ghs(h) = -1
+      acc_gm0(h) = acc_mtop
+      acc_gg0(h) = acc_gtop
+
+c     nodes shared with another rank: min/max of the owner id differ
+      if (ierr.eq.0) then
+         do i=1,n
+            wmin(i) = nid
+            wmax(i) = nid
+         enddo
+      endif
+      ierr = iglmax(ierr,1)
+      if (ierr.ne.0) return
+      call fgslib_gs_op(gs_h,wmin,1,3,0)
+      call fgslib_gs_op(gs_h,wmax,1,4,0)
+
+c     shared copies first, then by global id
+      m = 0
+      do i=1,n
+         if (glo_num(i).ne.0) then
+            m = m+1
+            ti(1,m) = i
+            ti(2,m) = 1
+            if (wmin(i).ne.wmax(i)) ti(2,m) = 0
+            tl(m)   = glo_num(i)
+         endif
+      enddo
+      key(1) = 2
+      key(2) = 3
+      call fgslib_crystal_tuple_sort(cr_h,m,ti,2,tl,1,vr,0,key,2)
+
+c     groups: runs of equal ids, local runs only with 2+ copies
+      ng  = 0
+      ns  = 0
+      nm  = 0
+      m0  = acc_mtop
+      g0  = acc_gtop
+      j0  = 1
+      do j=1,m
+         if (j.eq.m .or. tl(min(j+1,m)).ne.tl(j0)) then
+            nc = j-j0+1
+            if (ti(2,j0).eq.0 .or. nc.gt.1) then
+               if (m0+nm+nc.gt.lacc_m .or. g0+ng+2.gt.lacc_g+lacc_h)
+     $            ierr = 1
+               if (ierr.eq.0) then
+                  ng = ng+1
+                  acc_gp(g0+ng) = nm+1
+                  do k=j0,j
+                     acc_gi(m0+nm+k-j0+1) = ti(1,k)
+                  enddo
+                  nm = nm+nc
+                  if (ti(2,j0).eq.0) then
+                     gg     = tl(j0)
+                     ns     = ns+1
+                     tl(ns) = gg
+                  endif
+               endif
+            endif
+            j0 = j+1
+         endif
+      enddo
+      if (ns.gt.lacc_g) ierr = 1
+      ierr = iglmax(ierr,1)
+      if (ierr.ne.0) return
+
+      acc_gp(g0+ng+1) = nm+1
+      call fgslib_gs_setup(acc_ghs(h),tl,ns,nekcomm,mp)
+
+      acc_gng(h) = ng
+      acc_gns(h) = ns
+      acc_mtop   = m0+nm
+      acc_gtop   = g0+ng+1
+c$acc update device(acc_gp(g0+1:g0+ng+1),acc_gi(m0+1:m0+nm))
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_gs_op(gs_h,u,op)
+c
+c     fgslib_gs_op(gs_h,u,1,op,0) on device resident u
+c
+      include 'SIZE'
+
+      integer gs_h,op
+      real    u(1)
+
+      parameter (lacc_h=64,lacc_t=NEK_ACC_LT)
+      parameter (lacc_m=2*lacc_t,lacc_g=lacc_t)
+      integer         acc_gsh(lacc_h),acc_gn(lacc_h),acc_gng(lacc_h)
+     $               ,acc_gns(lacc_h),acc_gm0(lacc_h),acc_gg0(lacc_h)
+     $               ,acc_ghs(lacc_h),acc_nh,acc_mtop,acc_gtop
+      common /nekaccg/ acc_gsh,acc_gn,acc_gng,acc_gns,acc_gm0,acc_gg0
+     $               ,acc_ghs,acc_nh,acc_mtop,acc_gtop
+      integer         acc_gp(lacc_g+lacc_h),acc_gi(lacc_m)
+      real            acc_gb(lacc_g)
+      common /nekaccq/ acc_gb,acc_gp,acc_gi
+
+      integer h
+
+      h = 0
+      do i=acc_nh,1,-1
+         if (acc_gsh(i).eq.gs_h) then
+            h = i
+            goto 10
+         endif
+      enddo
+   10 continue
+      if (h.eq.0) call exitti('nek_acc_gs_op: unknown handle $',gs_h)
+
+      n = acc_gn(h)
+      if (op.eq.1 .and. acc_gng(h).ge.0) then
+         call nek_acc_gs_sum(u,acc_gp(acc_gg0(h)+1),acc_gi(acc_gm0(h)+1)
+     $                      ,acc_gb,acc_ghs(h),acc_gng(h),acc_gns(h),n)
+      else
+c$acc update self(u(1:n))
+         call fgslib_gs_op(gs_h,u,1,op,0)
+c$acc update device(u(1:n))
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_gs_sum(u,gp,gi,gb,ghs,ng,ns,n)
+c
+c     u := sum over the local copies, the ns shared group sums are
+c     combined on the host through ghs
+c
+      real    u(n),gb(1)
+      integer gp(ng+1),gi(1),ghs
+      integer g
+
+c$acc parallel loop gang vector default(present) private(s)
+      do g=1,ng
+         s = 0
+         do k=gp(g),gp(g+1)-1
+            s = s + u(gi(k))
+         enddo
+         if (g.le.ns) then
+            gb(g) = s
+         else
+            do k=gp(g),gp(g+1)-1
+               u(gi(k)) = s
+            enddo
+         endif
+      enddo
+
+      if (ns.gt.0) then
+c$acc update self(gb(1:ns))
+      endif
+      call fgslib_gs_op(ghs,gb,1,1,0)
+      if (ns.gt.0) then
+c$acc update device(gb(1:ns))
+      endif
+
+c$acc parallel loop gang vector default(present)
+      do g=1,ns
+         do k=gp(g),gp(g+1)-1
+            u(gi(k)) = gb(g)
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_acc_gs_free
+c
+c     drop all device gs tables (rebal_setup, before the handles are
+c     rebuilt)
+c
+      parameter (lacc_h=64)
+      integer         acc_gsh(lacc_h),acc_gn(lacc_h),acc_gng(lacc_h)
+     $               ,acc_gns(lacc_h),acc_gm0(lacc_h),acc_gg0(lacc_h)
+     $               ,acc_ghs(lacc_h),acc_nh,acc_mtop,acc_gtop
+      common /nekaccg/ acc_gsh,acc_gn,acc_gng,acc_gns,acc_gm0,acc_gg0
+     $               ,acc_ghs,acc_nh,acc_mtop,acc_gtop
+
+#ifdef _OPENACC
+      integer h
+
+      do h=1,acc_nh
+         if (acc_ghs(h).ge.0) call fgslib_gs_free(acc_ghs(h))
+      enddo
+      acc_nh   = 0
+      acc_mtop = 0
+      acc_gtop = 0
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
@@ -0,0 +1,1043 @@
+c-----------------------------------------------------------------------
+c
+c     In-situ partitioning: element to rank map and global vertex ids
+c     computed from the .re2 at startup instead of a genmap .map/.ma2.
+c
+c     - every rank reads a contiguous block of the mesh section
+c     - vertex ids come from genmap's tolerance based lexicographic
+c       sort (unique_vertex2), done here as a distributed sample sort,
+c       and are merged across periodic ('P  ') face pairs
+c     - elements are split by recursive coordinate bisection of their
+c       centroids, fluid and solid separately, into the per rank
+c       counts of assign_gllnid
+c
+c     Used when no map file exists or mesh:partitioner = rcb
+c     (param(175)).  mesh:writePartition (param(176)) saves the result
+c     as .ma2, mesh:connectivityTol (param(177)) is the relative vertex
+c     tolerance (genmap's default 0.2).
+c
+c-----------------------------------------------------------------------
+      subroutine parmap_vert(vertex,nlv,wk,mdw,ndw,ifgfdm,mapfle)
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      integer vertex(nlv,1),wk(mdw,ndw)
+      logical ifgfdm
+      character*132 mapfle
+
+      parameter (lv = 2**ldim, lr = ldim+1, lt = 3*lv*lelt)
+
+      real            xv(lr,lv,lelt),xce(ldim,lelt)
+      common /pmapv/  xv,xce
+
+      integer         vid(lv,lelt),part(lelt),ibuf(2,lelt)
+      common /pmapi/  vid,part,ibuf
+
+      real            tr(lr,lt)
+      integer*8       tl(3,lt)
+      integer         ti(lt)
+      common /pmapt/  tr,tl,ti
+
+      real            wv(lelt)
+      integer         iev(lelt)
+      common /pmape/  wv,iev
+
+      logical ifbswap,if_byte_swap_test
+      real*4  test
+      integer e,eb0,jeg
+      integer*8 offs
+
+      etime0 = dnekclock_sync()
+      if (nio.eq.0) write(6,'(A)') ' partitioning mesh in-situ'
+
+      q = 0.2
+      if (param(177).gt.0) q = param(177)
+
+      ! block of elements read by this rank
+      eb0  = iparmap_blk0(nid,nelgt)
+      nelb = iparmap_blk0(nid+1,nelgt) - eb0
+      ierr = 0
+      if (nelb.gt.lelt) ierr = 1
+      call err_chk(ierr,'parmap: lelt too small for the mesh block$')
+
+#ifndef NOMPIIO
+      call byte_open_mpi(re2fle,fh_re2,.true.,ierr)
+#else
+      call byte_mmap_open(re2fle,fh_re2,ierr)
+#endif
+      call err_chk(ierr,' Cannot open .re2 file!$')
+
+      offs = 80
+      call readp_re2_words(test,offs,1,.false.,ierr)
+      ifbswap = if_byte_swap_test(test,ierr)
+      call err_chk(ierr,' Error reading .re2 header!$')
+
+      call parmap_read_mesh(xv,xce,lr,lv,nelb,eb0,ifbswap,tr)
+      call parmap_number   (vid,xv,lr,lv,nelb,eb0,q,ti,tl,tr,lt)
+      call parmap_periodic (vid,xv,lr,lv,nelb,eb0,ifbswap)
+
+#ifndef NOMPIIO
+      call byte_close_mpi(fh_re2,ierr)
+#else
+      call byte_mmap_close(fh_re2,ierr)
+#endif
+
+      nvg = 0
+      do e=1,nelb
+      do k=1,lv
+         nvg = max(nvg,vid(k,e))
+      enddo
+      enddo
+      nvg = iglmax(nvg,1)
+
+      ! fluid elements of the block come first
+      nbv = max(0,min(nelb,nelgv-eb0))
+      if (ifgfdm) then
+         jeg = eb0+1
+         call dProcmapNidN(part,1,jeg,0,nelb)
+      else
+         do e=1,nelb
+            wv(e)  = 1
+            iev(e) = eb0+e
+         enddo
+         call parmap_rcb(part,xce,wv,iev,nbv,nelgv)
+         call parmap_rcb(part(nbv+1),xce(1,nbv+1),wv(nbv+1),iev(nbv+1)
+     $                  ,nelb-nbv,nelgt-nelgv)
+      endif
+
+      ! send elements with their vertex ids to their ranks
+      do e=1,nelb
+         wk(1,e) = eb0+e
+         call icopy(wk(2,e),vid(1,e),lv)
+         wk(mdw,e) = part(e)
+      enddo
+      n   = nelb
+      key = mdw
+      call fgslib_crystal_ituple_transfer(cr_h,wk,mdw,n,ndw,key)
+
+      ierr = 0
+      if (n.gt.lelt) ierr = 1
+      if (ifgfdm .and. n.ne.nelt) ierr = 1
+      call err_chk(ierr,'parmap: too many elements on a rank$')
+
+      key = 1
+      call fgslib_crystal_ituple_sort(cr_h,wk,mdw,n,key,1)
+
+      if (.not.ifgfdm) then
+         nelt = n
+         nelv = 0
+         do e=1,nelt
+            lglel(e)  = wk(1,e)
+            if (lglel(e).le.nelgv) nelv = nelv+1
+            ibuf(1,e) = e
+            ibuf(2,e) = nid
+         enddo
+         call dProcmapPutN(ibuf,2,2,0,lglel,1,nelt)
+         call nekgsync()
+      endif
+
+      do e=1,n
+         call icopy(vertex(1,e),wk(2,e),nlv)
+      enddo
+
+      if (param(176).gt.0 .and. .not.ifgfdm)
+     $   call parmap_write(wk,mdw,n,mapfle,nvg)
+
+      dtmp = dnekclock_sync() - etime0
+      if (nio.eq.0) write(6,'(A,i12,A,1p1e13.4,A)')
+     $   '   unique vertices:',nvg,'  done ::',dtmp,' sec'
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function iparmap_blk0(ip,ntot)
+c
+c     number of elements before rank ip in the block distribution of
+c     assign_gllnid (the last ranks hold one element more)
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      n0 = ntot/np
+      nn = np-mod(ntot,np)
+      iparmap_blk0 = ip*n0 + max(0,ip-nn)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function iparmap_blk(eg,ntot)
+c
+c     rank holding element eg in the block distribution
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer eg
+
+      n0 = ntot/np
+      nn = np-mod(ntot,np)
+      if (eg.le.nn*n0) then
+         iparmap_blk = (eg-1)/n0
+      else
+         iparmap_blk = nn + (eg-nn*n0-1)/(n0+1)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_read_mesh(xv,xce,lr,nv,nelb,eb0,ifbswap,bufr)
+c
+c     read the mesh records of the block, keep the vertices in
+c     symmetric order with their squared distance to the nearest
+c     neighbor vertex in xv(1,:,:) and the element centroids in xce
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      real    xv(lr,nv,1),xce(ldim,1)
+      integer bufr(1)
+      logical ifbswap
+
+      integer e,eb0,h2s(8),neigh(3,8)
+      integer*8 offs
+
+      data h2s   / 1,2,4,3,5,6,8,7 /
+      data neigh / 2,3,5 , 1,4,6 , 1,4,7 , 2,3,8
+     $           , 1,6,7 , 2,5,8 , 3,5,8 , 4,6,7 /
+
+      lrs  = 1+ldim*nv
+      lrs4 = lrs*wdsizi/4
+      offs = 84 + int(eb0,8)*lrs*wdsizi
+      call readp_re2_words(bufr,offs,nelb*lrs4,ifbswap,ierr)
+      call err_chk(ierr,'Error reading .re2 mesh$')
+
+      do e=1,nelb
+         call buf_to_xyz(bufr((e-1)*lrs4+1),e,.false.,ierr)
+         do k=1,nv
+            xv(2,k,e) = xc(h2s(k),e)
+            xv(3,k,e) = yc(h2s(k),e)
+            if (ldim.eq.3) xv(4,k,e) = zc(h2s(k),e)
+         enddo
+
+         do k=1,nv
+            d2 = 1.e30
+            do j=1,ldim
+               kk  = neigh(j,k)
+               d2l = 0
+               do i=1,ldim
+                  d2l = d2l + (xv(1+i,kk,e)-xv(1+i,k,e))**2
+               enddo
+               d2 = min(d2,d2l)
+            enddo
+            xv(1,k,e) = d2
+         enddo
+
+         do i=1,ldim
+            s = 0
+            do k=1,nv
+               s = s + xv(1+i,k,e)
+            enddo
+            xce(i,e) = s/nv
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_number(vid,xv,lr,nv,nelb,eb0,q,ti,tl,tr,lt)
+c
+c     global vertex ids of the block: each vertex is a tuple
+c     (segment, key, slot) with (d2,x) attached; ldim passes over the
+c     ldim directions sort the tuples by their quantized x_j within
+c     the segments and split the segments at gaps above the tolerance
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer   vid(nv,1),ti(lt)
+      integer*8 tl(3,lt)
+      real      xv(lr,nv,1),tr(lr,lt)
+
+      integer e,eb0
+      integer*8 nv8
+
+      n = 0
+      do e=1,nelb
+      do k=1,nv
+         n = n+1
+         tl(1,n) = 1
+         tl(2,n) = 0
+         tl(3,n) = int(eb0+e-1,8)*nv + k-1
+         call copy(tr(1,n),xv(1,k,e),lr)
+         ti(n) = 0
+      enddo
+      enddo
+
+      qq  = q*q
+      do ipass=1,ldim     ! more passes remove false positives
+      do j=1,ldim
+         xmn =  1.e30
+         xmx = -1.e30
+         do i=1,n
+            xmn = min(xmn,tr(1+j,i))
+            xmx = max(xmx,tr(1+j,i))
+         enddo
+         xmn = glmin(xmn,1)
+         xmx = glmax(xmx,1)
+         scl = 0
+         if (xmx.gt.xmn) scl = 2.**50/(xmx-xmn)
+         do i=1,n
+            tl(2,i) = (tr(1+j,i)-xmn)*scl
+         enddo
+         call parmap_sort   (n,ti,tl,tr,lr,lt)
+         call parmap_segment(n,tl,tr,lr,j,qq)
+      enddo
+      enddo
+
+      ! the segment number is the vertex id, return it to the block
+      nv8 = nv
+      do i=1,n
+         ti(i) = iparmap_blk(int(tl(3,i)/nv8)+1,nelgt)
+      enddo
+      key = 1
+      call fgslib_crystal_tuple_transfer(cr_h,n,lt,ti,1,tl,3,tr,lr,key)
+      do i=1,n
+         e = tl(3,i)/nv8 - eb0 + 1
+         k = mod(tl(3,i),nv8) + 1
+         vid(k,e) = tl(1,i)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_sort(n,ti,tl,tr,lr,lt)
+c
+c     global sort of the tuples by (tl(1),tl(2),tl(3)): local sort,
+c     np-1 splitters from ls regular samples per rank, transfer to the
+c     splitter interval and sort the received tuples
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'mpif.h'
+
+      common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
+
+      integer   ti(lt)
+      integer*8 tl(3,lt)
+      real      tr(lr,lt)
+
+      parameter (ls = 16)
+      integer*8       smp(3,ls),sall(3,ls*lp)
+      integer         iall(ls*lp)
+      real            rdum
+      common /pmaps/  sall,iall
+
+      integer keys(3)
+      logical ifle
+      save    keys
+      data    keys / 2,3,4 /
+
+      call fgslib_crystal_tuple_sort(cr_h,n,ti,1,tl,3,tr,lr,keys,3)
+      if (np.eq.1) return
+
+      do k=1,ls
+         if (n.gt.0) then
+            i = 1 + ((k-1)*n)/ls
+            call i8copy(smp(1,k),tl(1,i),3)
+         else
+            do j=1,3
+               smp(j,k) = huge(smp(1,1))
+            enddo
+         endif
+      enddo
+      call mpi_allgather(smp ,3*ls,mpi_integer8
+     $                  ,sall,3*ls,mpi_integer8,nekcomm,ierr)
+      m = ls*np
+      call izero(iall,m)
+      call fgslib_crystal_tuple_sort(cr_h,m,iall,1,sall,3,rdum,0,keys,3)
+
+      ! destination: the last splitter sall(:,k*ls) not above the tuple
+      do i=1,n
+         klo = 0
+         khi = np
+         do while (khi-klo.gt.1)
+            km   = (klo+khi)/2
+            ifle = .true.
+            do j=1,3
+               if (sall(j,km*ls).ne.tl(j,i)) then
+                  ifle = sall(j,km*ls).lt.tl(j,i)
+                  goto 10
+               endif
+            enddo
+   10       if (ifle) then
+               klo = km
+            else
+               khi = km
+            endif
+         enddo
+         ti(i) = klo
+      enddo
+
+      key = 1
+      call fgslib_crystal_tuple_transfer(cr_h,n,lt,ti,1,tl,3,tr,lr,key)
+      ierr = 0
+      if (n.gt.lt) ierr = 1
+      call err_chk(ierr,'parmap: vertex sort overflow, increase lelt$')
+      call fgslib_crystal_tuple_sort(cr_h,n,ti,1,tl,3,tr,lr,keys,3)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_segment(n,tl,tr,lr,j,qq)
+c
+c     renumber the segments of the globally sorted tuples: a new one
+c     starts where the old segment changes or where the gap in x_j
+c     exceeds the tolerance of either vertex (genmap's unique_vertex2)
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'mpif.h'
+
+      common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
+
+      integer*8 tl(3,n)
+      real      tr(lr,n)
+
+      integer*8       il(2),ila(2,lp)
+      real            rl(2),rla(2,lp)
+      common /pmapg/  ila,rla
+
+      integer*8 nf,iseg,jseg,i8gl_running_sum
+      logical   ifprev,ifnew
+
+      ! last tuple of the nearest preceding rank holding any
+      ifprev = .false.
+      if (np.gt.1) then
+         il(1) = 0
+         il(2) = 0
+         rl(1) = 0
+         rl(2) = 0
+         if (n.gt.0) then
+            il(1) = 1
+            il(2) = tl(1,n)
+            rl(1) = tr(1+j,n)
+            rl(2) = tr(1,n)
+         endif
+         call mpi_allgather(il ,2,mpi_integer8
+     $                     ,ila,2,mpi_integer8,nekcomm,ierr)
+         call mpi_allgather(rl ,2,nekreal,rla,2,nekreal,nekcomm,ierr)
+         do ip=nid,1,-1
+            if (ila(1,ip).eq.1) then
+               ifprev = .true.
+               jseg   = ila(2,ip)
+               xp     = rla(1,ip)
+               d2p    = rla(2,ip)
+               goto 10
+            endif
+         enddo
+   10    continue
+      endif
+
+      nf = 0
+      do i=1,n
+         if (i.gt.1) then
+            ifprev = .true.
+            jseg   = tl(1,i-1)
+            xp     = tr(1+j,i-1)
+            d2p    = tr(1,i-1)
+         endif
+         ifnew = .true.
+         if (ifprev) ifnew = tl(1,i).ne.jseg .or.
+     $      (tr(1+j,i)-xp)**2 .gt. qq*min(tr(1,i),d2p)
+         tl(2,i) = 0
+         if (ifnew) tl(2,i) = 1
+         nf = nf + tl(2,i)
+      enddo
+
+      iseg = i8gl_running_sum(nf) - nf
+      do i=1,n
+         iseg    = iseg + tl(2,i)
+         tl(1,i) = iseg
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_periodic(vid,xv,lr,nv,nelb,eb0,ifbswap)
+c
+c     merge the vertex ids across periodic face pairs: the 'P  '
+c     records of the topology bc section are read striped, matched
+c     vertex by vertex as in genmap's find_connctd_pairs, and every
+c     connected set of ids collapses to its minimum (label propagation)
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      integer vid(nv,1)
+      real    xv(lr,nv,1)
+      logical ifbswap
+
+      parameter (lpf = 6*lelt, lpe = 2*lpf*2**(ldim-1))
+      parameter (lpi = 5+4, lpr = 3*4, lrs = 2+1+5)
+
+      real            pr(lpr,lpf)
+      integer         pi(lpi,lpf),pe(3,lpe),pm(4,lpe),nd(lpe),lb(lpe)
+      common /pmapp/  pr,pi,pe,pm,nd,lb
+
+      integer         ibr(2*lrs*lelt)
+      common /pmapb/  ibr
+
+      integer e,f,eg,je,jf,eb0,efaci(6),vface(4,6),vf3(4,6),vf2(4,6)
+      integer*4 nrg4(2)
+      real      rtmp(2),x0(3,4),x1(3,4),x0m(3),x1m(3)
+      character*3 cb
+      integer*8 offs
+
+      data efaci / 3,2,4,1,5,6 /
+      data vf3   / 1,5,7,3 , 2,4,8,6 , 1,2,6,5
+     $           , 3,7,8,4 , 1,3,4,2 , 5,6,8,7 /
+      data vf2   / 3,1,0,0 , 2,4,0,0 , 1,2,0,0
+     $           , 4,3,0,0 , 0,0,0,0 , 0,0,0,0 /
+
+      if (ldim.eq.3) then
+         call icopy(vface,vf3,24)
+      else
+         call icopy(vface,vf2,24)
+      endif
+      nvf = nv/2
+      nfc = 2*ldim
+
+      ! skip the mesh and curve sections, and the fluid bc section when
+      ! the thermal one holds the topology of all elements
+      lrsm = 1+ldim*nv
+      offs = 84 + int(nelgt,8)*lrsm*wdsizi
+      nsec = 1
+      if (nelgt.gt.nelgv) nsec = 2
+      do isec=0,nsec
+         call readp_re2_words(nrg4,offs,wdsizi/4,ifbswap,ierr)
+         call err_chk(ierr,'Error reading .re2 boundary data$')
+         if (wdsizi.eq.8) then
+            call copy(dnrg,nrg4,1)
+            nrg = dnrg
+         else
+            nrg = nrg4(1)
+         endif
+         offs = offs + wdsizi
+         if (isec.lt.nsec) offs = offs + int(nrg,8)*8*wdsizi
+      enddo
+
+      ! read the stripe, keep each pair once at the owner of eg
+      nr = nrg/np
+      if (nid.lt.mod(nrg,np)) nr = nr+1
+      irankoff = igl_running_sum(nr) - nr
+      lrs4 = lrs*wdsizi/4
+      offs = offs + int(irankoff,8)*lrs*wdsizi
+
+      npf   = 0
+      ierr  = 0
+      nrp   = lelt
+      npass = iglmax((nr+nrp-1)/nrp,1)
+      do ipass = 1,npass
+         nrr = max(0,min(nrp,nr-(ipass-1)*nrp))
+         call readp_re2_words(ibr,offs,nrr*lrs4,.false.,ierr)
+         offs = offs + 4*nrr*lrs4
+         call err_chk(ierr,'Error reading .re2 boundary data$')
+
+         do i=1,nrr
+            jj = (i-1)*lrs4 + 1
+            if (ifbswap) then
+               lrs4s = lrs4 - wdsizi/4
+               if(wdsizi.eq.8) call byte_reverse8(ibr(jj),lrs4s,ierr)
+               if(wdsizi.eq.4) call byte_reverse (ibr(jj),lrs4s,ierr)
+            endif
+            if (wdsizi.eq.8) then
+               call chcopy(cb,ibr(jj+14),3)
+            else
+               call chcopy(cb,ibr(jj+7),3)
+            endif
+            if (cb.eq.'P  ') then
+               if (wdsizi.eq.8) then
+                  call copyi4(eg,ibr(jj  ),1)
+                  call copyi4(f,ibr(jj+2),1)
+                  call copyi4(je,ibr(jj+4),1)
+                  call copyi4(jf,ibr(jj+6),1)
+               else
+                  eg = ibr(jj  )
+                  f  = ibr(jj+1)
+                  call copy4r(rtmp,ibr(jj+2),2)
+                  je = rtmp(1)
+                  jf = rtmp(2)
+                  if (nelgt.ge.1000000) je = ibr(jj+2)
+               endif
+               je = abs(je)
+               if (eg.lt.1 .or. eg.gt.nelgt .or. je.lt.1 .or.
+     $             je.gt.nelgt .or. f.lt.1 .or. f.gt.nfc .or.
+     $             jf.lt.1 .or. jf.gt.nfc) then
+                  ierr = 1
+               else
+                  f  = efaci(f)
+                  jf = efaci(jf)
+                  if (eg.lt.je .or. (eg.eq.je .and. f.lt.jf)) then
+                     npf = npf+1
+                     if (npf.gt.lpf) then
+                        ierr = 1
+                        npf  = lpf
+                     endif
+                     pi(1,npf) = iparmap_blk(eg,nelgt)
+                     pi(2,npf) = eg
+                     pi(3,npf) = f
+                     pi(4,npf) = je
+                     pi(5,npf) = jf
+                  endif
+               endif
+            endif
+         enddo
+      enddo
+      call err_chk(ierr,'parmap: invalid periodic bc record$')
+      if (iglsum(npf,1).eq.0) return
+
+      ! attach ids and coordinates of face f of eg
+      n   = npf
+      key = 1
+      call fgslib_crystal_tuple_transfer(cr_h,n,lpf,pi,lpi,vl,0,pr,lpr
+     $                                  ,key)
+      if (n.gt.lpf) ierr = 1
+      call err_chk(ierr,'parmap: periodic pair overflow$')
+      do i=1,n
+         e = pi(2,i) - eb0
+         f = pi(3,i)
+         do m=1,nvf
+            kv = vface(m,f)
+            pi(5+m,i) = vid(kv,e)
+            do k=1,ldim
+               pr(k+(m-1)*ldim,i) = xv(1+k,kv,e)
+            enddo
+         enddo
+         pi(1,i) = iparmap_blk(pi(4,i),nelgt)
+      enddo
+      call fgslib_crystal_tuple_transfer(cr_h,n,lpf,pi,lpi,vl,0,pr,lpr
+     $                                  ,key)
+      if (n.gt.lpf) ierr = 1
+      call err_chk(ierr,'parmap: periodic pair overflow$')
+
+      ! match the vertices of the two faces up to a translation
+      ne = 0
+      do i=1,n
+         je = pi(4,i) - eb0
+         jf = pi(5,i)
+         call rzero(x0m,3)
+         call rzero(x1m,3)
+         do m=1,nvf
+            do k=1,ldim
+               x0(k,m) = pr(k+(m-1)*ldim,i)
+               x1(k,m) = xv(1+k,vface(m,jf),je)
+               x0m(k)  = x0m(k) + x0(k,m)/nvf
+               x1m(k)  = x1m(k) + x1(k,m)/nvf
+            enddo
+         enddo
+         xmx = 0
+         do m=1,nvf
+            do k=1,ldim
+               xmx     = max(xmx,abs(x0(k,m)),abs(x1(k,m)))
+               x0(k,m) = x0(k,m) - x0m(k)
+               x1(k,m) = x1(k,m) - x1m(k)
+            enddo
+         enddo
+
+         d2min = 1.e30
+         ishft = 0
+         do is=0,nvf-1
+            d2 = 0
+            do m=1,nvf
+               jm = m+is
+               if (jm.gt.nvf) jm = jm-nvf
+               jm = nvf+1-jm
+               do k=1,ldim
+                  d2 = d2 + (x0(k,m)-x1(k,jm))**2
+               enddo
+            enddo
+            if (d2.lt.d2min) then
+               d2min = d2
+               ishft = is
+            endif
+         enddo
+         if (sqrt(d2min).gt.1.e-3*xmx) ierr = 1
+
+         do m=1,nvf
+            jm = m+ishft
+            if (jm.gt.nvf) jm = jm-nvf
+            jm = nvf+1-jm
+            ia = pi(5+m,i)
+            ib = vid(vface(jm,jf),je)
+            if (ia.ne.ib .and. ne+2.le.lpe) then
+               pe(1,ne+1) = mod(ia,np)
+               pe(2,ne+1) = ia
+               pe(3,ne+1) = ib
+               pe(1,ne+2) = mod(ib,np)
+               pe(2,ne+2) = ib
+               pe(3,ne+2) = ia
+               ne = ne+2
+            elseif (ia.ne.ib) then
+               ierr = 1
+            endif
+         enddo
+      enddo
+      call err_chk(ierr,'parmap: periodic faces do not match$')
+
+      ! edges at the owner of their first id, one table entry per id
+      key = 1
+      call fgslib_crystal_ituple_transfer(cr_h,pe,3,ne,lpe,key)
+      if (ne.gt.lpe) ierr = 1
+      call err_chk(ierr,'parmap: periodic edge overflow$')
+      key = 2
+      call fgslib_crystal_ituple_sort(cr_h,pe,3,ne,key,1)
+      nn = 0
+      do i=1,ne
+         if (i.eq.1) then
+            nn = nn+1
+         elseif (pe(2,i).ne.pe(2,i-1)) then
+            nn = nn+1
+         endif
+         nd(nn)  = pe(2,i)
+         lb(nn)  = pe(2,i)
+         pe(1,i) = nn
+      enddo
+
+      do iter=1,nelgt
+         do i=1,ne
+            pm(1,i) = mod(pe(3,i),np)
+            pm(2,i) = pe(3,i)
+            pm(3,i) = lb(pe(1,i))
+         enddo
+         nm  = ne
+         key = 1
+         call fgslib_crystal_ituple_transfer(cr_h,pm,4,nm,lpe,key)
+         ichg = 0
+         do i=1,nm
+            k = iparmap_find(pm(2,i),nd,nn)
+            if (pm(3,i).lt.lb(k)) then
+               lb(k) = pm(3,i)
+               ichg  = 1
+            endif
+         enddo
+         if (iglmax(ichg,1).eq.0) goto 20
+      enddo
+   20 continue
+
+      ! relabel the vertices of the block
+      nq = 0
+      do e=1,nelb
+      do k=1,nv
+         nq = nq+1
+         pm(1,nq) = mod(vid(k,e),np)
+         pm(2,nq) = vid(k,e)
+         pm(3,nq) = nq
+         pm(4,nq) = nid
+      enddo
+      enddo
+      key = 1
+      call fgslib_crystal_ituple_transfer(cr_h,pm,4,nq,lpe,key)
+      if (nq.gt.lpe) ierr = 1
+      call err_chk(ierr,'parmap: periodic relabel overflow$')
+      do i=1,nq
+         k = iparmap_find(pm(2,i),nd,nn)
+         if (k.gt.0) pm(2,i) = lb(k)
+         pm(1,i) = pm(4,i)
+      enddo
+      call fgslib_crystal_ituple_transfer(cr_h,pm,4,nq,lpe,key)
+      do i=1,nq
+         e = (pm(3,i)-1)/nv + 1
+         k = pm(3,i) - (e-1)*nv
+         vid(k,e) = pm(2,i)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function iparmap_find(ix,nd,nn)
+c
+c     position of ix in the sorted list nd(1:nn), 0 if not present
+c
+      integer nd(nn)
+
+      iparmap_find = 0
+      ilo = 1
+      ihi = nn
+      do while (ilo.le.ihi)
+         im = (ilo+ihi)/2
+         if (nd(im).eq.ix) then
+            iparmap_find = im
+            return
+         elseif (nd(im).lt.ix) then
+            ilo = im+1
+         else
+            ihi = im-1
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_rcb(part,xce,w,ieg,nel,ntot)
+c
+c     recursive coordinate bisection of the nel local elements with
+c     global ids ieg() and weights w() (ntot elements over all ranks)
+c     into np parts, part ip receiving the share of the weight that
+c     assign_gllnid gives rank ip in element count; for unit weights
+c     the counts match exactly.  Every level cuts each rank group
+c     across its longest extent; the cut is located by a nb-way
+c     bisection of unique integer keys (quantized coordinate, element
+c     id), so ties are split exactly.
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer part(1),ieg(1)
+      real    xce(ldim,1),w(1)
+
+      parameter (nb = 16)
+      integer         ig(lelt),gp0(lp),gp1(lp),gq0(lp),gq1(lp),inew(lp)
+     $               ,iax(lp)
+      integer*8       key(lelt),klo(lp),khi(lp),kw(lp)
+      real            bmn(ldim,lp),bmx(ldim,lp),rw(ldim*lp)
+     $               ,wtl(lp),wlo(lp),wg(lp),hist(nb,lp),hw(nb*lp)
+      common /pmapr/  bmn,bmx,rw,wtl,wlo,wg,hist,hw,key,klo,khi,kw
+     $               ,ig,gp0,gp1,gq0,gq1,inew,iax
+
+      integer e,g
+      integer*8 k31,k62
+      logical ifopen
+
+      if (ntot.eq.0) return
+
+      k31 = 2
+      k31 = k31**31
+      k62 = k31*k31/2
+
+      ng     = 1
+      gp0(1) = 0
+      gp1(1) = np
+      do e=1,nel
+         ig(e) = 1
+      enddo
+
+      do lev=1,64
+         nsplit = 0
+         do g=1,ng
+            if (gp1(g)-gp0(g).gt.1) nsplit = nsplit+1
+         enddo
+         if (nsplit.eq.0) goto 100
+
+         ! bounding box and longest extent of every group
+         do g=1,ng
+            do k=1,ldim
+               bmn(k,g) =  1.e30
+               bmx(k,g) = -1.e30
+            enddo
+         enddo
+         do e=1,nel
+            g = ig(e)
+            do k=1,ldim
+               bmn(k,g) = min(bmn(k,g),xce(k,e))
+               bmx(k,g) = max(bmx(k,g),xce(k,e))
+            enddo
+         enddo
+         call gop(bmn,rw,'m  ',ldim*ng)
+         call gop(bmx,rw,'M  ',ldim*ng)
+         do g=1,ng
+            iax(g) = 1
+            do k=2,ldim
+               if (bmx(k,g)-bmn(k,g).gt.bmx(iax(g),g)-bmn(iax(g),g))
+     $            iax(g) = k
+            enddo
+         enddo
+
+         do e=1,nel
+            g   = ig(e)
+            k   = iax(g)
+            ext = bmx(k,g)-bmn(k,g)
+            iq  = 0
+            if (ext.gt.0) iq = (xce(k,e)-bmn(k,g))/ext*(k31-2)
+            key(e) = iq*k31 + ieg(e)-1
+         enddo
+
+         ! cut: the smallest keys up to weight wtl go to the lower half
+         call rzero(wg,ng)
+         do e=1,nel
+            wg(ig(e)) = wg(ig(e)) + w(e)
+         enddo
+         call gop(wg,hw,'+  ',ng)
+         do g=1,ng
+            ip0 = gp0(g)
+            ip1 = gp1(g)
+            ipm = ip0 + (ip1-ip0)/2
+            ntl  = iparmap_blk0(ipm,ntot) - iparmap_blk0(ip0,ntot)
+            nall = iparmap_blk0(ip1,ntot) - iparmap_blk0(ip0,ntot)
+            wtl(g) = 0
+            if (nall.gt.0) wtl(g) = (wg(g)*ntl)/nall
+            wlo(g) = 0
+            klo(g) = 0
+            khi(g) = k62
+            if (ip1-ip0.le.1 .or. wtl(g).le.0) then
+               khi(g) = 0
+               klo(g) = 0
+            elseif (wtl(g).ge.wg(g)) then
+               klo(g) = k62
+            endif
+         enddo
+
+         do it=1,64
+            ifopen = .false.
+            call rzero(hist,nb*ng)
+            do g=1,ng
+               kw(g) = (khi(g)-klo(g)+nb-1)/nb
+               if (khi(g)-klo(g).gt.1) ifopen = .true.
+            enddo
+            if (.not.ifopen) goto 50
+
+            do e=1,nel
+               g = ig(e)
+               if (khi(g)-klo(g).gt.1 .and. key(e).ge.klo(g) .and.
+     $             key(e).lt.khi(g)) then
+                  ib = (key(e)-klo(g))/kw(g) + 1
+                  hist(ib,g) = hist(ib,g) + w(e)
+               endif
+            enddo
+            call gop(hist,hw,'+  ',nb*ng)
+
+            do g=1,ng
+               if (khi(g)-klo(g).gt.1) then
+                  wc = wlo(g)
+                  do ib=1,nb
+                     if (wc+hist(ib,g).ge.wtl(g) .or. ib.eq.nb) then
+                        khi(g) = min(khi(g),klo(g)+ib*kw(g))
+                        klo(g) = klo(g)+(ib-1)*kw(g)
+                        wlo(g) = wc
+                        goto 40
+                     endif
+                     wc = wc+hist(ib,g)
+                  enddo
+   40             continue
+               endif
+            enddo
+         enddo
+   50    continue
+
+         ! split the groups
+         nq = 0
+         do g=1,ng
+            nq = nq+1
+            inew(g) = nq
+            gq0(nq) = gp0(g)
+            gq1(nq) = gp1(g)
+            if (gp1(g)-gp0(g).gt.1) then
+               ipm     = gp0(g) + (gp1(g)-gp0(g))/2
+               gq1(nq) = ipm
+               nq      = nq+1
+               gq0(nq) = ipm
+               gq1(nq) = gp1(g)
+            endif
+         enddo
+         do e=1,nel
+            g = ig(e)
+            if (gp1(g)-gp0(g).gt.1 .and. key(e).ge.khi(g)) then
+               ig(e) = inew(g)+1
+            else
+               ig(e) = inew(g)
+            endif
+         enddo
+         ng = nq
+         do g=1,ng
+            gp0(g) = gq0(g)
+            gp1(g) = gq1(g)
+         enddo
+      enddo
+
+  100 continue
+      do e=1,nel
+         part(e) = gp0(ig(e))
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine parmap_write(wk,mdw,n,mapfle,nvg)
+c
+c     save the partition as .ma2 (rows in rank order, fluid first) so
+c     later runs can read it like a genmap file
+c
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer wk(mdw,n)
+      character*132 mapfle
+
+      integer         iw((1+2**ldim)*lelt)
+      common /pmapw/  iw
+
+      character*132 hdr
+      real*4        test
+      integer*8     offs,npts
+      integer       e,ifh
+
+      data test / 6.54321 /
+
+#ifdef NOMPIIO
+      if (nio.eq.0) write(6,*)
+     $   'WARNING: mesh:writePartition requires MPI-IO, skipped'
+#else
+      nv = mdw-2
+      if (nio.eq.0) write(6,'(A,A)') ' Writing ', mapfle
+
+      call byte_open_mpi(mapfle,ifh,.false.,ierr)
+      call err_chk(ierr,' Cannot open map file for writing!$')
+
+      idepth = 0
+      do while (2**(idepth+1).le.nelgt)
+         idepth = idepth+1
+      enddo
+      npts = nelgt
+      npts = npts*nv
+      call blank(hdr,sizeof(hdr))
+      write(hdr,'(a5,7i12)') '#v002',nelgt,nvg,idepth,2**idepth,npts
+     $                       ,nvg,0
+
+      offs = 0
+      call byte_set_view(offs,ifh)
+      call byte_write_mpi(hdr,sizeof(hdr)/4,0,ifh,ierr)
+      offs = sizeof(hdr)
+      call byte_set_view(offs,ifh)
+      call byte_write_mpi(test,1,0,ifh,ierr)
+
+      ! fluid rows, then solid rows, each in rank order
+      do icls=1,2
+         nw = 0
+         do e=1,n
+            if ((icls.eq.1 .and. wk(1,e).le.nelgv) .or.
+     $          (icls.eq.2 .and. wk(1,e).gt.nelgv)) then
+               iw(nw+1) = wk(1,e)
+               call icopy(iw(nw+2),wk(2,e),nv)
+               nw = nw+nv+1
+            endif
+         enddo
+         if (icls.eq.1) then
+            irow0 = iparmap_blk0(nid,nelgv)
+         else
+            irow0 = nelgv + iparmap_blk0(nid,nelgt-nelgv)
+         endif
+         offs = sizeof(hdr) + 4 + int(irow0,8)*(nv+1)*4
+         call byte_set_view(offs,ifh)
+         call byte_write_mpi(iw,nw,-1,ifh,ierr)
+      enddo
+
+      call byte_close_mpi(ifh,ierr)
+      call err_chk(ierr,' Error writing map file!$')
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
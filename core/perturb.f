@@ -8,6 +8,16 @@ c
       include 'TSTEP'
       include 'SOLN'
 
+      logical ifpert_batch
+
+      if (ifpert_batch()) then
+         if (nio.eq.0.and.igeom.eq.2) write(6,2) istep,time,npert
+   2     format(i9,1pe14.7,' Perturbation Solve:',i5,' (batched)')
+         call perturbv_many (igeom)
+         jp=0
+         return
+      endif
+
       do jp=1,npert
 
          if (nio.eq.0.and.igeom.eq.2) write(6,1) istep,time,jp
@@ -67,6 +77,154 @@ c
 c
       endif
 c
+      return
+      end
+c-----------------------------------------------------------------------
+      logical function ifpert_batch()
+c
+c     problemType:perturbationBatch: advance all npert perturbations
+c     together (perturbv_many).  Only the plain velocity Helmholtz
+c     solve is batched; stress formulation, axisymmetry, the adjoint
+c     and velocity projection keep the per-perturbation loop.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'TSTEP'
+      include 'ADJOINT'
+
+      logical ifproj
+
+      ifproj = ifprojfld(1) .and. param(93).ne.0 .and. param(94).ne.0
+     $         .and. istep.ge.param(94)
+
+      ifpert_batch = param(190).ne.0 .and. npert.gt.1 .and.
+     $               .not.(ifstrs.or.ifaxis.or.ifadj.or.ifproj)
+#ifdef OPENACC
+      ifpert_batch = .false.
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine perturbv_many (igeom)
+c
+c     perturbv for all npert perturbations at once.  The convection
+c     about the base flow is one fused pass (advabp_many) and the
+c     ldim*npert velocity components share one block Helmholtz solve
+c     (ophinvp_block).  The pressure correction is done per field.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'SOLN'
+      include 'TSTEP'
+      include 'MASS'
+      include 'WSPACE'
+c
+      COMMON /SCRVH/  H1    (LX1,LY1,LZ1,LELV)
+     $ ,              H2    (LX1,LY1,LZ1,LELV)
+
+      integer*8 km,kr,kx,kz,k,k3
+c
+      ifield = 1
+      n      = lx1*ly1*lz1*nelv
+c
+      if (igeom.eq.1) then
+c
+c        Old geometry, old velocity
+c
+         do jp=1,npert
+            call makeufp
+         enddo
+         if (ifnav.and.(.not.ifchar)) call advabp_many
+         do jp=1,npert
+            if (iftran) call makextp
+                        call makebdfp
+                        call lagfieldp
+         enddo
+c
+      else
+c
+c        New geometry, new velocity
+c
+         nb = ldim*npert
+         call nek_ws_push
+         km = nek_ws_r(n*ldim)
+         kr = nek_ws_r(n*nb)
+         kx = nek_ws_r(n*nb)
+         kz = nek_ws_r(n)              ! third component in 2D
+         call copy (ws(km)  ,v1mask,n)
+         call copy (ws(km+n),v2mask,n)
+         if (if3d) call copy (ws(km+2*n),v3mask,n)
+
+         intype = -1
+         call sethlm   (h1,h2,intype)
+         do jp=1,npert
+            k  = kr + ldim*(jp-1)*n
+            k3 = kz
+            if (if3d) k3 = k+2*n
+            call cresvipp (ws(k),ws(k+n),ws(k3),h1,h2)
+         enddo
+
+         call ophinvp_block(ws(kx),ws(kr),h1,h2,ws(km),n,nb,tolhv,nmxh)
+
+         do jp=1,npert
+            k  = kx + ldim*(jp-1)*n
+            call add2 (vxp(1,jp),ws(k)  ,n)
+            call add2 (vyp(1,jp),ws(k+n),n)
+            if (if3d) call add2 (vzp(1,jp),ws(k+2*n),n)
+            call incomprp (vxp(1,jp),vyp(1,jp),vzp(1,jp),prp(1,jp))
+         enddo
+         call nek_ws_pop
+c
+      endif
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine ophinvp_block(x,r,h1,h2,mask,n,nb,tolh,maxit)
+c
+c     hmholtz for the nb = ldim*npert velocity components r(n,nb) of
+c     all perturbations, column i+ldim*(jp-1) holding component i of
+c     perturbation jp and masked with mask(:,i).  One dssum for all
+c     columns, then cggo_block; r is destroyed.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CTIMER'
+
+      real x(n,nb),r(n,nb),h1(1),h2(1),mask(n,ldim)
+
+      character*4 name(ldim*lpert)
+      real        tol (ldim*lpert)
+      character*1 cxyz(3)
+      save        cxyz
+      data        cxyz /'X','Y','Z'/
+
+#ifdef TIMER
+      nhmhz = nhmhz + nb
+      etime1 = dnekclock()
+#endif
+
+      call nvec_dssum(r,n,nb,gsh_fld(ifield))
+
+      do k=1,nb
+         i  = 1+mod(k-1,ldim)
+         kp = 1+(k-1)/ldim
+         write(name(k),'(a1,a1,i2.2)') 'V',cxyz(i),mod(kp,100)
+         tol(k) = abs(tolh)
+         call col2 (r(1,k),mask(1,i),n)
+         if (param(22).eq.0.or.istep.le.10)
+     $      call chktcg1 (tol(k),r(1,k),h1,h2,mask(1,i),vmult,1,1)
+         if (tolh.lt.0) tol(k)=tolh  ! relative tolerance
+      enddo
+
+      call cggo_block
+     $   (x,r,nb,n,h1,h2,mask,ldim,vmult,1,1,binvm1,tol,maxit,name)
+
+#ifdef TIMER
+      thmhz=thmhz+(dnekclock()-etime1)
+#endif
+
       return
       end
 c-----------------------------------------------------------------------
@@ -200,6 +358,64 @@ c
 c
       endif
 c
+      return
+      end
+c--------------------------------------------------------------------
+      subroutine advabp_many
+C
+C     advabp for all perturbations.  With the dealiased convection of
+C     perturbation runs (param(99)=4) both linearized terms of every
+C     perturbation come from one pass of convect_pert_many over the
+C     base flow, otherwise advabp is called per perturbation.
+C
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CTIMER'
+      include 'WSPACE'
+
+      integer*8 kx,ky,kz
+
+      ntot1 = lx1*ly1*lz1*nelv
+      ld    = lpx1*lpy1*lpz1*lpelv
+
+      if (.not.ifdeal(ifield) .or. param(99).ne.4 .or.
+     $    param(86).ne.0 .or. ifdgfld(ifield)) then
+         do jp=1,npert
+            call advabp
+         enddo
+         return
+      endif
+
+#ifdef TIMER
+      etime1=dnekclock()
+#endif
+      call nek_ws_push
+      kx = nek_ws_r(ld*npert)
+      ky = nek_ws_r(ld*npert)
+      kz = nek_ws_r(ld*npert)
+
+      call convect_pert_many(ws(kx),ws(ky),ws(kz),vxp,vyp,vzp,ld,npert
+     $                      ,vx,vy,vz)
+
+      do jp=1,npert
+         kp = (jp-1)*ld - 1
+         do i=1,ntot1
+            tmp = vtrans(i,1,1,1,ifield)
+            bfxp(i,jp) = bfxp(i,jp)-tmp*ws(kx+kp+i)
+            bfyp(i,jp) = bfyp(i,jp)-tmp*ws(ky+kp+i)
+         enddo
+         if (if3d) then
+            do i=1,ntot1
+               bfzp(i,jp) = bfzp(i,jp)-vtrans(i,1,1,1,ifield)
+     $                                *ws(kz+kp+i)
+            enddo
+         endif
+      enddo
+      call nek_ws_pop
+#ifdef TIMER
+      tadvc=tadvc+(dnekclock()-etime1)
+#endif
+
       return
       end
 c--------------------------------------------------------------------
@@ -74,10 +74,12 @@ C        first, compute pressure
          call rzero    (h2,ntot1)
          call ctolspl  (tolspl,respr)
          napproxp(1) = laxtp
+         call nek_comm_push('pres')
          call hsolve   ('PRES',dpr,respr,h1,h2 
      $                        ,pmask,vmult
      $                        ,imesh,tolspl,nmxh,1
      $                        ,approxp,napproxp,binvm1)
+         call nek_comm_pop()
          call add2    (pr,dpr,ntot1)
          call ortho   (pr)
 
@@ -1511,6 +1511,7 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
 
       include 'SIZE'
       include 'TOTAL'
+      include 'DPROCMAP'
 
       parameter(nfldm=ldim+ldimt+1)
 
@@ -1529,10 +1530,10 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
       common /outtmp/ wrk (lx1*ly1*lz1*lelt,nfldm)
 
 
-      logical iffind
+      logical iffind,ifloc
 
-      integer icalld,npoints,npts
-      save    icalld,npoints,npts
+      integer icalld,npoints,npts,igen,igeom
+      save    icalld,npoints,npts,igen,igeom
       data    icalld  /0/
       data    npoints /0/
 
@@ -1549,7 +1550,13 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
       if(icalld.eq.0) then
         npts  = lhis      ! number of points per proc
         call hpts_in(pts,npts,npoints)
+      endif
 
+      ! locate the points again once elements changed ranks or moved
+      ifloc = icalld.eq.0 .or. igen.ne.dProcmapGen
+     $                    .or. igeom.ne.geomGen
+      if(ifloc) then
+        if(icalld.ne.0) call fgslib_findpts_free(inth_hpts)
         tol     = 5e-13
         n       = lx1*ly1*lz1*lelt
         npt_max = 256
@@ -1590,7 +1597,7 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
       enddo
       
       ! interpolate
-      if(icalld.eq.0) then
+      if(ifloc) then
         call fgslib_findpts(inth_hpts,rcode,1,
      &                      proc,1,
      &                      elid,1,
@@ -1618,6 +1625,8 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
            endif
         enddo
         icalld = 1
+        igen   = dProcmapGen
+        igeom  = geomGen
       endif
 
 
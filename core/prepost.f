@@ -833,11 +833,18 @@ c-----------------------------------------------------------------------
       integer*8 offs0,offs,nbyte,stride,strideB,nxyzo8
       character*3 prefix
       logical ifxyo_s
+
+      integer itmr
+      save    itmr
+      data    itmr /0/
  
       common /SCRUZ/  ur1(lxo*lxo*lxo*lelt)
      &              , ur2(lxo*lxo*lxo*lelt)
      &              , ur3(lxo*lxo*lxo*lelt)
 
+      if (itmr.eq.0) call nek_timer_id('io_write',itmr)
+      call nek_timer_push(itmr)
+
       tiostart=dnekclock_sync()
 
       call io_init
@@ -860,12 +867,18 @@ c-----------------------------------------------------------------------
          if(if3d) nzo = nrg
       endif
       offs0 = iHeaderSize + 4 + isize*nelgt
+      offzo = offs0                          ! compressed: running offset
+      dnbzo = 0
 
       ierr=0
       if (nid.eq.pid0) then
          call mfo_open_files(prefix,ierr)         ! open files on i/o nodes
       endif
       call err_chk(ierr,'Error opening file in mfo_open_files. $')
+      if (ifasyncio) then
+         call byte_async_open(ifh_mbyte,ierr) ! waits for previous use
+         call err_chk(ierr,'Error flushing async output. $')
+      endif
       call bcast(ifxyo_,lsize)
       ifxyo = ifxyo_
       call mfo_write_hdr                     ! create element mapping +
@@ -882,6 +895,7 @@ c     call exitti('this is wdsizo A:$',wdsizo)
       if (ifxyo) then
          offs = offs0 + ldim*strideB
          call byte_set_view(offs,ifh_mbyte)
+         izipc = min(izipo,1)                ! mesh is never lossy
          if (ifreguo) then
             call map2reg(ur1,nrg,xm1,nout)
             call map2reg(ur2,nrg,ym1,nout)
@@ -890,6 +904,7 @@ c     call exitti('this is wdsizo A:$',wdsizo)
          else
             call mfo_outv(xm1,ym1,zm1,nout,nxo,nyo,nzo)
          endif
+         izipc = izipo
          ioflds = ioflds + ldim
       endif
       if (ifvo ) then
@@ -941,9 +956,11 @@ c     call exitti('this is wdsizo A:$',wdsizo)
          endif
       enddo
       dnbyte = 1.*ioflds*nout*wdsizo*nxo*nyo*nzo
+      if (ifzipo) dnbyte = dnbzo
 
       if (if3d) then
          offs0   = offs0 + ioflds*stride
+         if (ifzipo) offs0 = offzo
          strideB = nelB *2*4   ! min/max single precision
          stride  = nelgt*2*4
          ioflds  = 0
@@ -1006,6 +1023,7 @@ c     call exitti('this is wdsizo A:$',wdsizo)
 
       ifxyo = ifxyo_s ! restore old value
 
+      call nek_timer_pop(itmr)
       return
       end
 c-----------------------------------------------------------------------
@@ -1025,6 +1043,15 @@ c-----------------------------------------------------------------------
       ifmpiio = .false.
 #endif
 
+      ifasyncio = .false.
+      if(ifmpiio .and. param(170).gt.0) ifasyncio = .true.
+
+      izipo  = int(param(172))               ! 1: lossless, 2: lossy
+      if(izipo.lt.0 .or. izipo.gt.2) izipo = 0
+      izipc  = izipo
+      ifzipo = izipo.gt.0
+      ziptol = param(173)                    ! abs. error bound, lossy
+
       if(ifmpiio) then
         nfileo  = np
         nproc_o = 1
@@ -1286,7 +1313,11 @@ c-----------------------------------------------------------------------
       endif
       save_size=8  ! For full restart
 
-      call restart_save(iosave,save_size,nfld_save)
+      if (param(191).gt.0) then  ! multi-level, see ckpt_init
+         call ckpt_save(iosave,save_size,nfld_save)
+      else
+         call restart_save(iosave,save_size,nfld_save)
+      endif
 
       return
       end
@@ -1319,7 +1350,7 @@ c
       character*1  ks1(0:16)
       equivalence (ks1,kst)
 
-      logical if_full_pres_tmp
+      logical if_full_pres_tmp,ifxyo_tmp
 
       iosav = iosave
 
@@ -1358,6 +1389,10 @@ c                                      ! is the only form used for restart
          if_full_pres_tmp = if_full_pres     
          if (save_size.eq.8) if_full_pres = .true. !Preserve mesh 2 pressure
 
+         ifxyo_tmp = ifxyo
+         if (param(191).gt.0)
+     $   ifxyo     = ifmvbd          ! a static mesh is in the .re2
+
          if (ifmhd) call outpost2(bx,by,bz,pm,t,0      ,prefix)  ! first B
                     call outpost2(vx,vy,vz,pr,t,npscal1,prefix)  ! then  U
 
@@ -1365,6 +1400,7 @@ c                                      ! is the only form used for restart
 
          param(66) = p66
          if_full_pres = if_full_pres_tmp
+         ifxyo = ifxyo_tmp
 
       endif
 
@@ -1372,6 +1408,193 @@ c     if (nid.eq.0) write(6,8) istep,prefix,nfld,nfld2,i2,m1,mt
 c  8  format(i8,' prefix ',a3,5i5)
 
       if_full_pres = .false.
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine ckpt_init
+c
+c     Multi-level checkpoints for full_restart_save, enabled by
+c     general:checkpointLocal = memory | <node-local directory>.
+c
+c     Every iosave steps the raw time stepping state (as in rstartc:
+c     solution, lagged fields, extrapolation terms, dt history, and the
+c     mesh only if it moves) goes to memory or the local directory and
+c     to a partner rank (nek_ckpt.c); only every checkpointFlush-th one
+c     is also written as rs files to the parallel file system.  At
+c     startup the latest complete local checkpoint replaces the initial
+c     condition.
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'WSPACE'
+
+      common /ckpti/ ickgen
+      integer ickgen
+
+      common /cchar/ ct_vx(0:lorder+1) ! time for each slice in c_vx()
+
+      character*132 dir
+      integer imode,ipart,idelta,ifnd,nv,nt,nw,ilag,ifld,ierr
+      real tck
+
+      ickgen = 0
+      imode  = int(param(191))
+      if (imode.eq.0) return
+
+      if (ifmhd .or. ifpert .or. ifcvode) then
+         if (nio.eq.0) write(6,*)
+     $      'ckpt: no local checkpoints for MHD/perturbation/CVODE'
+         param(191) = 0
+         return
+      endif
+
+      call blank(dir,132)
+      if (imode.eq.2)
+     $   call finiparser_getString(dir,'general:checkpointLocal',ifnd)
+      ipart  = int(param(193))
+      idelta = 0
+      if (param(194).gt.0) idelta = 1
+      call nek_ckpt_setup(nekcomm,imode,dir,ipart,idelta,session)
+
+      nv = lx1*ly1*lz1*nelv
+      nt = lx1*ly1*lz1*nelt
+      nw = lx1m*ly1m*lz1m*nelt
+
+      call nek_ckpt_field('dt'    ,dt    ,1 )
+      call nek_ckpt_field('dtlag' ,dtlag ,10)
+      call nek_ckpt_field('courno',courno,1 )
+      if (ifmvbd) then
+         call nek_ckpt_field('xm1',xm1,nt)
+         call nek_ckpt_field('ym1',ym1,nt)
+         if (if3d) call nek_ckpt_field('zm1',zm1,nt)
+         call nek_ckpt_field('wx',wx,nw)
+         call nek_ckpt_field('wy',wy,nw)
+         if (if3d) call nek_ckpt_field('wz',wz,nw)
+         do ilag=1,lorder-1
+            call nek_ckpt_field('wxlag',wxlag(1,1,1,1,ilag),nw)
+            call nek_ckpt_field('wylag',wylag(1,1,1,1,ilag),nw)
+            if (if3d)
+     $      call nek_ckpt_field('wzlag',wzlag(1,1,1,1,ilag),nw)
+            call nek_ckpt_field('bm1lag',bm1lag(1,1,1,1,ilag),nt)
+         enddo
+      endif
+      if (ifflow) then
+         call nek_ckpt_field('vx',vx,nv)
+         call nek_ckpt_field('vy',vy,nv)
+         if (if3d) call nek_ckpt_field('vz',vz,nv)
+         call nek_ckpt_field('pr',pr,lx2*ly2*lz2*nelv)
+         do ilag=1,lorder2
+            call nek_ckpt_field('prlag',prlag(1,1,1,1,ilag)
+     $                         ,lx2*ly2*lz2*nelv)
+         enddo
+         call nek_ckpt_field('abx1',abx1,nv)
+         call nek_ckpt_field('aby1',aby1,nv)
+         if (if3d) call nek_ckpt_field('abz1',abz1,nv)
+         call nek_ckpt_field('abx2',abx2,nv)
+         call nek_ckpt_field('aby2',aby2,nv)
+         if (if3d) call nek_ckpt_field('abz2',abz2,nv)
+         do ilag=1,2
+            call nek_ckpt_field('vxlag',vxlag(1,1,1,1,ilag),nv)
+            call nek_ckpt_field('vylag',vylag(1,1,1,1,ilag),nv)
+            if (if3d)
+     $      call nek_ckpt_field('vzlag',vzlag(1,1,1,1,ilag),nv)
+         enddo
+      endif
+      if (ifchar) then               ! convecting field history (OIFS)
+         call char_alloc
+         call nek_ckpt_field('ct_vx',ct_vx,lorder+2)
+         call nek_ckpt_field('c_vx',ws(kc_vx),
+     $                       lxd*lyd*lzd*nelv*ldim*(lorder+1))
+      endif
+      do ifld=2,nfield
+         nt = lx1*ly1*lz1*nelfld(ifld)
+         call nek_ckpt_field('t',t(1,1,1,1,ifld-1),nt)
+         call nek_ckpt_field('vgradt1',vgradt1(1,1,1,1,ifld-1),nt)
+         call nek_ckpt_field('vgradt2',vgradt2(1,1,1,1,ifld-1),nt)
+         do ilag=1,lorder-1
+            call nek_ckpt_field('tlag',tlag(1,1,1,1,ilag,ifld-1),nt)
+         enddo
+      enddo
+
+      if (imode.ne.2) return
+
+c     param(46) > 0 makes settime use the full BDF/EXT order and the
+c     restored dtlag from the first step on, although istep (which
+c     only counts the steps of this run) starts again from 0
+      call nek_ckpt_load(ickgen,tck,ierr)
+      if (ierr.eq.0) then
+         time      = tck
+         param(46) = 1               ! lags are valid, see below
+         if (ifmvbd) call geom_reset(1)
+         if (nio.eq.0) write(6,1) ickgen,time
+    1    format(' ckpt: restored local checkpoint',i8,' at time',
+     $          1pe14.6)
+      else
+         ickgen = 0
+         if (nio.eq.0) write(6,*)
+     $      'ckpt: no complete local checkpoint, initial condition used'
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine ckpt_save(iosave,save_size,nfldi)
+c
+c     Level 1 checkpoint every iosave steps (default iostep), rs files
+c     every general:checkpointFlush-th one (0 = never)
+c
+      include 'SIZE'
+      include 'TSTEP'
+      include 'INPUT'
+
+      integer iosave,save_size,nfldi
+
+      common /ckpti/ ickgen
+      integer ickgen
+
+      integer iosav,nflush,ierr
+
+      iosav = iosave
+      if (iosav.eq.0) iosav = iostep
+      if (iosav.eq.0) return
+
+      if (istep.gt.0 .and. mod(istep,iosav).eq.0) then
+         ickgen = ickgen+1
+         call nek_ckpt_save(ickgen,time,ierr)
+      endif
+
+      nflush = int(param(192))
+      if (nflush.gt.0) call restart_save(iosav*nflush,save_size,nfldi)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine ckpt_restore(ierr)
+c
+c     Roll back to the latest level 1 checkpoint (e.g. from userchk
+c     after a blow-up); ierr = 0 on success on all ranks
+c
+      include 'SIZE'
+      include 'TOTAL'
+
+      common /ckpti/ ickgen
+      integer ickgen
+
+      integer ierr
+      real tck
+
+      ierr = 1
+      if (param(191).eq.0) return
+
+      call nek_ckpt_load(ickgen,tck,ierr)
+      if (ierr.ne.0) return
+
+      time      = tck
+      param(46) = 1                  ! keep the order, see ckpt_init
+      if (ifmvbd) call geom_reset(1)
+      if (nio.eq.0) write(6,1) ickgen,time
+    1 format(' ckpt: rolled back to checkpoint',i8,' at time',1pe14.6)
+
       return
       end
 c-----------------------------------------------------------------------
@@ -1652,6 +1875,11 @@ c-----------------------------------------------------------------------
         call exitt
       endif
 
+      if (ifzipo) then
+         call mfo_zout(u,u,u,1,nel,mx,my,mz)
+         return
+      endif
+
       nxyz = mx*my*mz
       len  = 8 + 8*(lelt*nxyz)  ! recv buffer size
       leo  = 8 + wdsizo*(nel*nxyz)
@@ -1741,6 +1969,11 @@ c-----------------------------------------------------------------------
         call exitt
       endif
 
+      if (ifzipo) then
+         call mfo_zout(u,v,w,ldim,nel,mx,my,mz)
+         return
+      endif
+
       nxyz = mx*my*mz
       len  = 8 + 8*(lelt*nxyz*ldim)   ! recv buffer size (u4)
       leo  = 8 + wdsizo*(nel*nxyz*ldim)
@@ -1838,6 +2071,103 @@ c-----------------------------------------------------------------------
       endif
 
       call err_chk(ierr,'Error writing data to .f00 in mfo_outv. $')
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_zout(u,v,w,ncomp,nel,mx,my,mz) ! compressed field
+c
+c     Every rank compresses its own elements (byte_zpack). The field
+c     block holds the record sizes of all elements followed by the
+c     records, see mfi_zopen. Local buffer layout:
+c
+c        [nel] [size(1:nel)] [nw] [records (nw words)]
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(mx*my*mz,1),v(mx*my*mz,1),w(mx*my*mz,1)
+
+      parameter (lzbo=3+lxo*lxo*lxo*6*lelt+2*lelt)
+      common /SCRNS/ z4(lzbo)
+      real*4         z4
+      integer        iz4(lzbo)
+      equivalence    (z4,iz4)
+      common /ctmp0/ lzlist(0:lelt)
+
+      real*4         e4(2*lxo*lxo*lxo*ldim)
+      real*8         e8(lxo*lxo*lxo*ldim)
+      equivalence    (e4,e8)
+
+      integer e
+      integer*8 i8nb,i8pre,i8tot,ioff,i8gl_running_sum,i8glsum
+
+      nxyz = mx*my*mz
+      idum = 1
+      ierr = 0
+
+      iz4(1) = nel
+      ip     = nel+3
+      do e=1,nel
+         if (wdsizo.eq.4) then
+            call copyx4(e4(1),u(1,e),nxyz)
+            if (ncomp.gt.1) call copyx4(e4(1+nxyz),v(1,e),nxyz)
+            if (ncomp.gt.2) call copyx4(e4(1+2*nxyz),w(1,e),nxyz)
+         else
+            call copy  (e8(1),u(1,e),nxyz)
+            if (ncomp.gt.1) call copy  (e8(1+nxyz),v(1,e),nxyz)
+            if (ncomp.gt.2) call copy  (e8(1+2*nxyz),w(1,e),nxyz)
+         endif
+         call byte_zpack(e4,ncomp,mx,my,mz,wdsizo,izipc,ziptol,
+     $                   z4(ip),nb)
+         iz4(1+e) = nb
+         ip = ip + nb/4
+      enddo
+      nw = ip-nel-3
+      iz4(nel+2) = nw
+      dnbzo = dnbzo + 4.*(nel+nw)
+
+      if (ifmpiio) then
+         i8nb  = 4*nw
+         i8pre = i8gl_running_sum(i8nb) - i8nb
+         i8tot = i8glsum(i8nb,1)
+
+         ioff = offzo + isize*nelB
+         call byte_set_view(ioff,ifh_mbyte)
+         call byte_write_mpi(iz4(2),nel,-1,ifh_mbyte,ierr)
+         ioff = offzo + isize*nelgt + i8pre
+         call byte_set_view(ioff,ifh_mbyte)
+         call byte_write_mpi(z4(nel+3),nw,-1,ifh_mbyte,ierr)
+         offzo = offzo + isize*nelgt + i8tot
+
+      elseif (nid.eq.pid0) then
+         call byte_write(iz4(2),nel,ierr)          ! record sizes
+         do k=pid0+1,pid1
+            mtype = k
+            call csend(mtype,idum,4,k,0)           ! handshake
+            call crecv(mtype,lzlist,4*(lelt+1))
+            if(ierr.eq.0) call byte_write(lzlist(1),lzlist(0),ierr)
+         enddo
+
+         if(ierr.eq.0) call byte_write(z4(nel+3),nw,ierr) ! records
+         do k=pid0+1,pid1
+            mtype = k
+            call csend(mtype,idum,4,k,0)           ! handshake
+            call crecv(mtype,z4,4*lzbo)
+            if(ierr.eq.0) call byte_write(z4(2),iz4(1),ierr)
+         enddo
+
+      else
+         mtype = nid
+         call crecv(mtype,idum,4)                  ! hand-shake
+         call csend(mtype,iz4,4*(nel+1),pid0,0)
+         call crecv(mtype,idum,4)                  ! hand-shake
+         call csend(mtype,iz4(nel+2),4*(nw+1),pid0,0)
+      endif
+
+      call err_chk(ierr,'Error writing data to .f00 in mfo_zout. $')
+
       return
       end
 c-----------------------------------------------------------------------
@@ -1921,6 +2251,7 @@ c     check pressure format
      $            ,(rdcode1(i),i=1,10),p0th,if_press_mesh
     1 format('#std',1x,i1,1x,i2,1x,i2,1x,i2,1x,i10,1x,i10,1x,e20.13,
      &       1x,i9,1x,i6,1x,i6,1x,10a,1pe15.7,1x,l1)
+      if (ifzipo) hdr(4:4) = 'z'       ! compressed field blocks
 
       test_pattern = 6.54321           ! write test pattern for byte swap
 
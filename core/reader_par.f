@@ -9,15 +9,26 @@ C
       INCLUDE 'PARALLEL'
       INCLUDE 'CTIMER'
       INCLUDE 'ZPER'
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
 c
       logical ifbswap
 
       call setDefaultParam
 
-      if(nid.eq.0) call par_read(ierr)
+c     rank 0 reads the file, every rank gets the parsed dictionary in
+c     one broadcast and evaluates it locally (no file access, no per
+c     parameter broadcasts)
+      if(nid.eq.0) call finiparser_load(parfle,ierr)
       call bcast(ierr,isize)
       if(ierr .ne. 0) call exitt
-      call bcastParam
+      call finiparser_bcast(nekcomm)
+
+      if(nid.eq.0) call par_verify(ierr)
+      if(nid.eq.0 .and. ierr.eq.0) call par_read(ierr) ! reports errors
+      call bcast(ierr,isize)
+      if(ierr .ne. 0) call exitt
+      if(nid.ne.0) call par_read(ierr)
+      call setParamInternals
 
       call read_re2_hdr(ifbswap)
 
@@ -144,6 +155,9 @@ C
       do i=1,ldimt
          ifprojfld(1+i) = .false.
       enddo
+      do i=0,ldimt1
+         ifpipefld(i) = .false.
+      enddo
 
       ifflow    = .false.
       ifheat    = .false.  
@@ -215,11 +229,7 @@ c     - mhd support
 
       character*132 c_out,txt, txt2
 
-      call finiparser_load(parfle,ierr)
-      if(ierr .ne. 0) return
-
-      call par_verify(ierr)
-      if(ierr .ne. 0) return
+      ierr = 0
 
 c set parameters
       call finiparser_getDbl(d_out,'general:loglevel',ifnd)
@@ -374,6 +384,11 @@ c set parameters
          ifprojfld(i+1) = .false.
          if(i_out .eq. 1) ifprojfld(i+1) = .true.
       endif
+      call finiparser_getBool(i_out,trim(txt)//':pipelined',ifnd)
+      if (ifnd .eq. 1) then
+         ifpipefld(i+1) = .false.
+         if(i_out .eq. 1) ifpipefld(i+1) = .true.
+      endif
  
       enddo
 
@@ -422,10 +437,38 @@ c set parameters
       call finiparser_getDbl(d_out,'mesh:firstBCFieldIndex',ifnd)
       if(ifnd .eq. 1) param(33) = int(d_out)
 
+      call finiparser_getString(c_out,'mesh:partitioner',ifnd)
+      if (ifnd .eq. 1) then
+         call capit(c_out,132)
+         if (index(c_out,'RCB') .eq. 1) then
+            param(175) = 1
+         else if (index(c_out,'MAP') .eq. 1) then
+            param(175) = 0
+         else
+           write(6,*) 'value: ',trim(c_out)
+           write(6,*) 'is invalid for mesh:partitioner!'
+           goto 999
+         endif
+      endif
+
+      call finiparser_getBool(i_out,'mesh:writePartition',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(176) = 1
+
+      call finiparser_getDbl(d_out,'mesh:connectivityTol',ifnd)
+      if(ifnd .eq. 1) param(177) = d_out
+
+      call finiparser_getDbl(d_out,'mesh:rebalanceTol',ifnd)
+      if(ifnd .eq. 1) param(178) = d_out
+
+      call finiparser_getDbl(d_out,'mesh:rebalanceInterval',ifnd)
+      if(ifnd .eq. 1) param(179) = d_out
+
       call finiparser_getString(c_out,'pressure:preconditioner',ifnd)
       if (ifnd .eq. 1) then 
          call capit(c_out,132)
-         if (index(c_out,'SEMG_AMG') .eq. 1) then
+         if (index(c_out,'SEMG_AMG_HYPRE') .eq. 1) then
+            param(40) = 2
+         else if (index(c_out,'SEMG_AMG') .eq. 1) then
             param(40) = 1
          else if (index(c_out,'SEMG_XXT') .eq. 1) then
             param(40) = 0
@@ -442,6 +485,89 @@ c set parameters
       call finiparser_getDbl(d_out,'general:writeNFiles',ifnd)
       if(ifnd .eq. 1) param(65) = int(d_out) 
 
+      call finiparser_getBool(i_out,'general:writeAsync',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(170) = 1 
+
+      call finiparser_getBool(i_out,'general:readMmap',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(171) = 1 
+
+      call finiparser_getDbl(d_out,'general:inSituInterval',ifnd)
+      if(ifnd .eq. 1) param(188) = d_out
+
+      call finiparser_getBool(i_out,'general:inSituAsync',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(189) = 1
+
+      call finiparser_getString(c_out,'general:checkpointLocal',ifnd)
+      if (ifnd .eq. 1) then
+         txt = c_out                 ! keep the case of a directory
+         call capit(txt,132)
+         if (index(txt,'NO ') .eq. 1) then
+            param(191) = 0
+         else if (index(txt,'MEMORY ') .eq. 1) then
+            param(191) = 1
+         else
+            param(191) = 2
+         endif
+      endif
+
+      call finiparser_getDbl(d_out,'general:checkpointFlush',ifnd)
+      if(ifnd .eq. 1) param(192) = d_out
+
+      call finiparser_getDbl(d_out,'general:checkpointPartner',ifnd)
+      if(ifnd .eq. 1) param(193) = d_out
+
+      call finiparser_getBool(i_out,'general:checkpointDelta',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(194) = 1
+
+      call finiparser_getDbl(d_out,'general:transferChunkSize',ifnd)
+      if(ifnd .eq. 1) param(195) = d_out
+
+      call finiparser_getString(c_out,'general:writeCompression',ifnd)
+      if (ifnd .eq. 1) then
+         call capit(c_out,132)
+         if (index(c_out,'NONE') .eq. 1) then
+            param(172) = 0
+         else if (index(c_out,'LOSSLESS') .eq. 1) then
+            param(172) = 1
+         else if (index(c_out,'LOSSY') .eq. 1) then
+            param(172) = 2
+         else
+            write(6,*) 'value: ',trim(c_out)
+            write(6,*) 'is invalid for general:writeCompression!'
+            goto 999
+         endif
+      endif
+
+      call finiparser_getDbl(d_out,'general:writeCompressionTol',ifnd)
+      if(ifnd .eq. 1) param(173) = d_out 
+      if (param(172).eq.2 .and. param(173).le.0) then
+         write(6,*) 'general:writeCompression = lossy requires'
+         write(6,*) 'general:writeCompressionTol > 0!'
+         goto 999
+      endif
+
+      call finiparser_getString(c_out,'general:compressedGeometry',ifnd)
+      if (ifnd .eq. 1) then
+         call capit(c_out,132)
+         if (index(c_out,'NONE') .eq. 1) then
+            param(183) = 0
+         else if (index(c_out,'AFFINE') .eq. 1) then
+            param(183) = 1
+         else if (index(c_out,'RECOMPUTE') .eq. 1) then
+            param(183) = 2
+         else
+            write(6,*) 'value: ',trim(c_out)
+            write(6,*) 'is invalid for general:compressedGeometry!'
+            goto 999
+         endif
+      endif
+
+      call finiparser_getBool(i_out,'general:overlapDssum',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(174) = 1 
+
+      call finiparser_getBool(i_out,'general:scalarBlockSolve',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(184) = 1 
+
       call finiparser_getBool(i_out,'velocity:residualProj',ifnd)
       if(ifnd .eq. 1) then
         ifprojfld(1) = .false.
@@ -454,6 +580,27 @@ c set parameters
         if(i_out .eq. 1) param(95) = 5 
       endif
 
+      call finiparser_getBool(i_out,'general:residualProjSingle',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(181) = 1 
+
+      call finiparser_getBool(i_out,'pressure:smootherSingle',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(187) = 1
+
+      call finiparser_getDbl(d_out,'general:nekNekSubSteps',ifnd)
+      if(ifnd .eq. 1) param(182) = d_out 
+
+      call finiparser_getBool(i_out,'velocity:pipelined',ifnd)
+      if(ifnd .eq. 1) then
+        ifpipefld(1) = .false.
+        if(i_out .eq. 1) ifpipefld(1) = .true. 
+      endif
+
+      call finiparser_getBool(i_out,'pressure:pipelined',ifnd)
+      if(ifnd .eq. 1) then
+        param(180) = 0
+        if(i_out .eq. 1) param(180) = 1 
+      endif
+
       call finiparser_getBool(i_out,'general:dealiasing',ifnd)
       if(ifnd .eq. 1 .and. i_out .eq. 0) param(99) = -1 
 
@@ -630,6 +777,9 @@ c set logical flags
             write(6,*) 'is required for ', trim(c_out) 
             goto 999
          endif
+         call finiparser_getBool
+     $        (i_out,'problemType:perturbationBatch',ifnd)
+         if(ifnd .eq. 1 .and. i_out .eq. 1) param(190) = 1
       else if (index(c_out,'COMPNS') .eq. 1) then
 #ifdef CMTNEK
          continue
@@ -670,6 +820,12 @@ c set logical flags
         if(i_out .eq. 1) param(161) = 2 !BDF
       endif
 
+      call finiparser_getBool(i_out,'cvode:cachedRhs',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(185) = 1
+
+      call finiparser_getBool(i_out,'cvode:localJacobian',ifnd)
+      if(ifnd .eq. 1 .and. i_out .eq. 1) param(186) = 1
+
 c set advection
       call finiparser_getBool(i_out,'velocity:advection',ifnd)
       if(ifnd .eq. 1) then
@@ -776,7 +932,7 @@ c set restart options
       enddo
 
 
-100   if(ierr.eq.0) call finiparser_dump()
+100   if(ierr.eq.0 .and. nid.eq.0) call finiparser_dump()
       return
 
 c error handling
@@ -786,9 +942,9 @@ c error handling
 
       end
 c-----------------------------------------------------------------------
-      subroutine bcastParam
+      subroutine setParamInternals
 C
-C     Broadcast run parameters to all processors
+C     Derived run parameters, set on all ranks after par_read
 C
       INCLUDE 'SIZE'
       INCLUDE 'INPUT'
@@ -799,55 +955,6 @@ C
       INCLUDE 'ADJOINT'
       INCLUDE 'CVODE'
 
-      call bcast(loglevel, isize)
-      call bcast(optlevel, isize)
-
-      call bcast(param , 200*wdsize)
-      call bcast(uparam, 20*wdsize)
-
-      call bcast(filterType, wdsize)
-
-      call bcast(atol ,  (ldimt1+1)*wdsize)
-      call bcast(restol, (ldimt1+1)*wdsize)
-
-      call bcast(ifchar , lsize)
-      call bcast(iftran  , lsize)
-      call bcast(ifflow  , lsize)
-      call bcast(ifheat  , lsize)     
-      call bcast(iflomach, lsize)
-      call bcast(ifstrs  , lsize)
-      call bcast(ifmvbd  , lsize)
-      call bcast(ifusermv, lsize)
-      call bcast(ifdp0dt,  lsize)
-      call bcast(ifaxis  , lsize)
-      call bcast(ifcyclic, lsize)
-      call bcast(ifmhd   , lsize)
-      call bcast(ifuservp, lsize)
-      call bcast(ifpert, lsize)
-      call bcast(ifbase, lsize)
-      call bcast(ifmoab, lsize)
-      call bcast(ifaziv, lsize)
-      call bcast(ifadj , lsize)
-
-      call bcast(ifadvc ,  ldimt1*lsize)
-      call bcast(ifdiff ,  ldimt1*lsize)
-      call bcast(ifdeal ,  ldimt1*lsize)
-      call bcast(iffilter, ldimt1*lsize)
-
-      call bcast(idpss    ,  ldimt*isize)
-      call bcast(iftmsh   , (ldimt1+1)*lsize)
-      call bcast(ifprojfld, (ldimt1+1)*lsize)
-
-      call bcast(cpfld, 3*ldimt1*wdsize)
-
-      call bcast(ifxyo , lsize)
-      call bcast(ifvo  , lsize)
-      call bcast(ifpo  , lsize)
-      call bcast(ifto  , lsize)
-      call bcast(ifpsco, ldimt1*lsize)
-
-      call bcast(initc, 15*132*csize) 
-
 c set some internals 
       if (ldim.eq.3) if3d=.true.
       if (ldim.ne.3) if3d=.false.
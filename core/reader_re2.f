@@ -7,7 +7,6 @@ c-----------------------------------------------------------------------
       include 'CTIMER'
 
       logical ifbswap
-      integer idummy(100)
 
       common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
  
@@ -30,10 +29,14 @@ c-----------------------------------------------------------------------
       lcbc=18*lelt*(ldimt1 + 1)
       call blank(cbc,lcbc)
 
-#ifndef NOMPIIO
       call fgslib_crystal_setup(cr_re2,nekcomm,np)
 
+      ! every rank reads its own byte ranges (see readp_re2_words)
+#ifndef NOMPIIO
       call byte_open_mpi(re2fle,fh_re2,.TRUE.,ierr)
+#else
+      call byte_mmap_open(re2fle,fh_re2,ierr)
+#endif
       call err_chk(ierr,' Cannot open .re2 file!$')
 
       call readp_re2_mesh (ifbswap)
@@ -43,18 +46,10 @@ c-----------------------------------------------------------------------
       enddo
 
       call fgslib_crystal_free(cr_re2)
+#ifndef NOMPIIO
       call byte_close_mpi(fh_re2,ierr)
 #else
-      call byte_open(re2fle,ierr)
-      call byte_read(idummy,21,ierr) ! skip hdr+endian code 
-
-      call bin_rd1_mesh (ifbswap)
-      call bin_rd1_curve(ifbswap)
-      do ifield = ibc,nfldt
-         call bin_rd1_bc (cbc(1,1,ifield),bc(1,1,1,ifield),ifbswap)
-      enddo
-
-      call byte_close(ierr)
+      call byte_mmap_close(fh_re2,ierr)
 #endif
 
       etime_t = dnekclock_sync() - etime0
@@ -62,6 +57,38 @@ c-----------------------------------------------------------------------
      &                   ' done :: read .re2 file   ',
      &                   etime_t, ' sec'
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine readp_re2_words(buf,ioff,nwds4r,ifbswap,ierr)
+c
+c     read nwds4r 4-byte words at byte offset ioff of the .re2 file and
+c     byte swap them using word size wdsizi if requested.  Collective
+c     (MPI_file_read_all) with MPI-IO, a local read of the mapped file
+c     with NOMPIIO; either way each rank only touches its own range.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      real*4    buf(1)
+      integer*8 ioff
+      logical   ifbswap
+
+#ifndef NOMPIIO
+      call byte_set_view(ioff,fh_re2)
+      call byte_read_mpi(buf,nwds4r,-1,fh_re2,ierr)
+#else
+      call byte_mmap_read(fh_re2,ioff,buf,nwds4r,ierr)
+#endif
+      if(ierr.ne.0 .or. .not.ifbswap) return
+
+      if(wdsizi.eq.8) then
+        call byte_reverse8(buf,nwds4r,ierr)
+      else
+        call byte_reverse (buf,nwds4r,ierr)
+      endif
+
       return
       end
 c-----------------------------------------------------------------------
@@ -97,17 +124,16 @@ c-----------------------------------------------------------------------
 
       ! read coordinates from file
       nwds4r = nr*lrs4
-      call byte_set_view(lre2off_b,fh_re2)
-      call byte_read_mpi(bufr,nwds4r,-1,fh_re2,ierr)
+      call readp_re2_words(bufr,lre2off_b,nwds4r,ifbswap,ierr)
       re2off_b = re2off_b + nrg*4*lrs4
       if(ierr.gt.0) goto 100
 
       ! pack buffer
+      ielg = irankoff + 1 ! elements are stored in global order
+      call dProcmapNidN(vi(1,1),li,ielg,0,nr)
       do i = 1,nr
          jj      = (i-1)*lrs4 + 1
-         ielg    = irankoff + i ! elements are stored in global order
-         vi(1,i) = gllnid(ielg)
-         vi(2,i) = ielg
+         vi(2,i) = irankoff + i
          call icopy(vi(3,i),bufr(jj,1),lrs4)
       enddo
 
@@ -122,7 +148,7 @@ c-----------------------------------------------------------------------
       do i = 1,n
          iel = gllel(vi(2,i)) 
          call icopy     (bufr,vi(3,i),lrs4)
-         call buf_to_xyz(bufr,iel,ifbswap,ierr)
+         call buf_to_xyz(bufr,iel,.false.,ierr) ! swapped on read
       enddo
 
       return
@@ -142,6 +168,7 @@ c-----------------------------------------------------------------------
       common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
 
       parameter(nrmax = 12*lelt) ! maximum number of records
+      parameter(nrp   = lelt)    ! records read per pass
       parameter(lrs   = 2+1+5)   ! record size: eg iside curve(5) ccurve
       parameter(li    = 2*lrs+1)
 
@@ -151,6 +178,8 @@ c-----------------------------------------------------------------------
       integer         vi  (li  ,nrmax)
       common /ctmp1/  vi
 
+      integer         iegr(nrp)
+
       integer*8       lre2off_b,dtmp8
       integer*8       nrg
       integer*4       nrg4(2)
@@ -158,17 +187,13 @@ c-----------------------------------------------------------------------
 
       ! read total number of records
       nwds4r    = 1*wdsizi/4
-      lre2off_b = re2off_b
-      call byte_set_view(lre2off_b,fh_re2)
-      call byte_read_mpi(nrg4,nwds4r,-1,fh_re2,ierr)
+      call readp_re2_words(nrg4,re2off_b,nwds4r,ifbswap,ierr)
       if(ierr.gt.0) goto 100
 
       if(wdsizi.eq.8) then
-         if(ifbswap) call byte_reverse8(nrg4,nwds4r,ierr)
          call copy(dnrg,nrg4,1)
          nrg = dnrg
       else
-         if(ifbswap) call byte_reverse (nrg4,nwds4r,ierr)
          nrg = nrg4(1)
       endif
       re2off_b = re2off_b + 4*nwds4r
@@ -176,7 +201,7 @@ c-----------------------------------------------------------------------
       if(nrg.eq.0) return
       if(nio.eq.0) write(6,*) ' preading curved sides '
 
-      ! read data from file
+      ! each rank reads a contiguous stripe of the records
       dtmp8 = np
       nr = nrg/dtmp8
       do i = 0,mod(nrg,dtmp8)-1
@@ -186,44 +211,49 @@ c-----------------------------------------------------------------------
       dtmp8     = irankoff
       lre2off_b = re2off_b + dtmp8*lrs*wdsizi
       lrs4      = lrs*wdsizi/4
+      re2off_b  = re2off_b + nrg*4*lrs4
+
+      ! stream the stripe through the buffers, nrp records per pass
+      npass = iglmax((nr+nrp-1)/nrp,1)
+      do ipass = 1,npass
+         nrr    = max(0,min(nrp,nr-(ipass-1)*nrp))
+         nwds4r = nrr*lrs4
+         call readp_re2_words(bufr,lre2off_b,nwds4r,.false.,ierr)
+         lre2off_b = lre2off_b + 4*nwds4r
+         if(ierr.gt.0) goto 100
+
+         ! pack buffer
+         do i = 1,nrr
+            jj = (i-1)*lrs4 + 1
+
+            if(ifbswap) then 
+              lrs4s = lrs4 - wdsizi/4 ! words to swap (last is char)
+              if(wdsizi.eq.8) call byte_reverse8(bufr(jj,1),lrs4s,ierr)
+              if(wdsizi.eq.4) call byte_reverse (bufr(jj,1),lrs4s,ierr)
+            endif
 
-      nwds4r = nr*lrs4
-      call byte_set_view(lre2off_b,fh_re2)
-      call byte_read_mpi(bufr,nwds4r,-1,fh_re2,ierr)
-
-      re2off_b = re2off_b + nrg*4*lrs4
-      if(ierr.gt.0) goto 100
-
-      ! pack buffer
-      do i = 1,nr
-         jj = (i-1)*lrs4 + 1
-
-         if(ifbswap) then 
-           lrs4s = lrs4 - wdsizi/4 ! words to swap (last is char)
-           if(wdsizi.eq.8) call byte_reverse8(bufr(jj,1),lrs4s,ierr)
-           if(wdsizi.eq.4) call byte_reverse (bufr(jj,1),lrs4s,ierr)
-         endif
-
-         ielg = bufr(jj,1)
-         if(wdsizi.eq.8) call copyi4(ielg,bufr(jj,1),1)
-
-         if(ielg.le.0 .or. ielg.gt.nelgt) goto 100
-         vi(1,i) = gllnid(ielg)
+            ielg = bufr(jj,1)
+            if(wdsizi.eq.8) call copyi4(ielg,bufr(jj,1),1)
 
-         call icopy (vi(2,i),bufr(jj,1),lrs4)
-      enddo
+            if(ielg.le.0 .or. ielg.gt.nelgt) goto 100
+            iegr(i) = ielg
 
-      ! crystal route nr real items of size lrs to rank vi(key,1:nr)
-      n    = nr
-      key  = 1
-      call fgslib_crystal_tuple_transfer(cr_re2,n,nrmax,vi,li,vl,0,vr,0,
-     &                                   key)
-
-      ! unpack buffer
-      if(n.gt.nrmax) goto 100
-      do i = 1,n
-         call icopy       (bufr,vi(2,i),lrs4)
-         call buf_to_curve(bufr)
+            call icopy (vi(2,i),bufr(jj,1),lrs4)
+         enddo
+         call dProcmapNidN(vi(1,1),li,iegr,1,nrr)
+
+         ! crystal route nrr real items of size lrs to rank vi(key,1:nrr)
+         n    = nrr
+         key  = 1
+         call fgslib_crystal_tuple_transfer(cr_re2,n,nrmax,vi,li,vl,0,
+     &                                      vr,0,key)
+
+         ! unpack buffer
+         if(n.gt.nrmax) goto 100
+         do i = 1,n
+            call icopy       (bufr,vi(2,i),lrs4)
+            call buf_to_curve(bufr)
+         enddo
       enddo
 
       return
@@ -243,6 +273,7 @@ c-----------------------------------------------------------------------
       logical      ifbswap
 
       parameter(nrmax = 6*lelt) ! maximum number of records
+      parameter(nrp   = lelt)   ! records read per pass
       parameter(lrs   = 2+1+5)  ! record size: eg iside bl(5) cbl
       parameter(li    = 2*lrs+1)
 
@@ -252,6 +283,8 @@ c-----------------------------------------------------------------------
       integer         vi  (li  ,nrmax)
       common /ctmp1/  vi
 
+      integer         iegr(nrp)
+
       integer*8       lre2off_b,dtmp8
       integer*8       nrg
       integer*4       nrg4(2)
@@ -266,17 +299,13 @@ c-----------------------------------------------------------------------
 
       ! read total number of records
       nwds4r    = 1*wdsizi/4
-      lre2off_b = re2off_b
-      call byte_set_view(lre2off_b,fh_re2)
-      call byte_read_mpi(nrg4,nwds4r,-1,fh_re2,ierr)
+      call readp_re2_words(nrg4,re2off_b,nwds4r,ifbswap,ierr)
       if(ierr.gt.0) goto 100
 
       if(wdsizi.eq.8) then
-         if(ifbswap) call byte_reverse8(nrg4,nwds4r,ierr)
          call copy(dnrg,nrg4,1)
          nrg = dnrg
       else
-         if(ifbswap) call byte_reverse (nrg4,nwds4r,ierr)
          nrg = nrg4(1)
       endif
       re2off_b = re2off_b + 4*nwds4r
@@ -284,7 +313,7 @@ c-----------------------------------------------------------------------
       if(nrg.eq.0) return
       if(nio.eq.0) write(6,*) ' preading bc for ifld',ifield
 
-      ! read data from file
+      ! each rank reads a contiguous stripe of the records
       dtmp8 = np
       nr = nrg/dtmp8
       do i = 0,mod(nrg,dtmp8)-1
@@ -294,44 +323,49 @@ c-----------------------------------------------------------------------
       dtmp8     = irankoff
       lre2off_b = re2off_b + dtmp8*lrs*wdsizi
       lrs4      = lrs*wdsizi/4
+      re2off_b  = re2off_b + nrg*4*lrs4
+
+      ! stream the stripe through the buffers, nrp records per pass
+      npass = iglmax((nr+nrp-1)/nrp,1)
+      do ipass = 1,npass
+         nrr    = max(0,min(nrp,nr-(ipass-1)*nrp))
+         nwds4r = nrr*lrs4
+         call readp_re2_words(bufr,lre2off_b,nwds4r,.false.,ierr)
+         lre2off_b = lre2off_b + 4*nwds4r
+         if(ierr.gt.0) goto 100
+
+         ! pack buffer
+         do i = 1,nrr
+            jj = (i-1)*lrs4 + 1
+
+            if(ifbswap) then 
+              lrs4s = lrs4 - wdsizi/4 ! words to swap (last is char)
+              if(wdsizi.eq.8) call byte_reverse8(bufr(jj,1),lrs4s,ierr)
+              if(wdsizi.eq.4) call byte_reverse (bufr(jj,1),lrs4s,ierr)
+            endif
 
-      nwds4r = nr*lrs4
-      call byte_set_view(lre2off_b,fh_re2)
-      call byte_read_mpi(bufr,nwds4r,-1,fh_re2,ierr)
-
-      re2off_b = re2off_b + nrg*4*lrs4
-      if(ierr.gt.0) goto 100
-
-      ! pack buffer
-      do i = 1,nr
-         jj = (i-1)*lrs4 + 1
-
-         if(ifbswap) then 
-           lrs4s = lrs4 - wdsizi/4 ! words to swap (last is char)
-           if(wdsizi.eq.8) call byte_reverse8(bufr(jj,1),lrs4s,ierr)
-           if(wdsizi.eq.4) call byte_reverse (bufr(jj,1),lrs4s,ierr)
-         endif
-
-         ielg = bufr(jj,1)
-         if(wdsizi.eq.8) call copyi4(ielg,bufr(jj,1),1)
-
-         if(ielg.le.0 .or. ielg.gt.nelgt) goto 100
-         vi(1,i) = gllnid(ielg)
+            ielg = bufr(jj,1)
+            if(wdsizi.eq.8) call copyi4(ielg,bufr(jj,1),1)
 
-         call icopy (vi(2,i),bufr(jj,1),lrs4)
-      enddo
+            if(ielg.le.0 .or. ielg.gt.nelgt) goto 100
+            iegr(i) = ielg
 
-      ! crystal route nr real items of size lrs to rank vi(key,1:nr)
-      n    = nr
-      key  = 1
-      call fgslib_crystal_tuple_transfer(cr_re2,n,nrmax,vi,li,vl,0,vr,0,
-     &                                   key)
-
-      ! unpack buffer
-      if(n.gt.nrmax) goto 100
-      do i = 1,n
-         call icopy    (bufr,vi(2,i),lrs4)
-         call buf_to_bc(cbl,bl,bufr)
+            call icopy (vi(2,i),bufr(jj,1),lrs4)
+         enddo
+         call dProcmapNidN(vi(1,1),li,iegr,1,nrr)
+
+         ! crystal route nrr real items of size lrs to rank vi(key,1:nrr)
+         n    = nrr
+         key  = 1
+         call fgslib_crystal_tuple_transfer(cr_re2,n,nrmax,vi,li,vl,0,
+     &                                      vr,0,key)
+
+         ! unpack buffer
+         if(n.gt.nrmax) goto 100
+         do i = 1,n
+            call icopy    (bufr,vi(2,i),lrs4)
+            call buf_to_bc(cbl,bl,bufr)
+         enddo
       enddo
 
       return
@@ -453,308 +487,6 @@ c-----------------------------------------------------------------------
 c     write(6,1) eg,e,f,cbl(f,e),' CBC',nid
 c  1  format(2i8,i4,2x,a3,a4,i8)
 
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine bin_rd1_mesh(ifbswap)    ! version 1 of binary reader
-
-      include 'SIZE'
-      include 'TOTAL'
-      logical ifbswap
-
-      integer e,eg,buf(55)
-
-      if (nio.eq.0) write(6,*)    '  reading mesh '
-
-      nwds = (1 + ldim*(2**ldim))*(wdsizi/4) ! group + 2x4 for 2d, 3x8 for 3d
-      len  = 4*nwds                          ! 4 bytes / wd
-
-      if (nwds.gt.55.or.isize.gt.4) then
-         write(6,*) nid,' Error in bin_rd1_mesh: buf size',nwds,isize
-         call exitt
-      endif
-
-      call nekgsync()
-
-      niop = 10
-      do k=1,8
-         if (nelgt/niop .lt. 100) goto 10
-         niop = niop*10
-      enddo
-   10 continue
-
-      ierr  = 0
-      ierr2 = 0
-      len1  = 4
-      do eg=1,nelgt             ! sync NOT needed here
-
-         mid = gllnid(eg)
-         e   = gllel (eg)
-#ifdef DEBUG
-         if (nio.eq.0.and.mod(eg,niop).eq.0) write(6,*) eg,' mesh read'
-#endif
-         if (mid.ne.nid.and.nid.eq.0) then              ! read & send
-
-            if(ierr.eq.0) then
-              call byte_read  (buf,nwds,ierr)
-              call csend(e,ierr,len1,mid,0)
-              if(ierr.eq.0) call csend(e,buf,len,mid,0)
-            else
-              call csend(e,ierr,len1,mid,0)
-            endif
-
-         elseif (mid.eq.nid.and.nid.ne.0) then          ! recv & process
-
-            call crecv      (e,ierr,len1)
-            if(ierr.eq.0) then
-              call crecv      (e,buf,len)
-              call buf_to_xyz (buf,e,ifbswap,ierr2)
-            endif
- 
-         elseif (mid.eq.nid.and.nid.eq.0) then          ! read & process
-
-            if(ierr.eq.0) then
-              call byte_read  (buf,nwds,ierr)
-              call buf_to_xyz (buf,e,ifbswap,ierr2)
-            endif
-         endif
-
-      enddo
-      ierr = ierr + ierr2
-      call err_chk(ierr,'Error reading .re2 mesh. Abort. $')
-
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine bin_rd1_curve (ifbswap) ! v. 1 of curve side reader
-
-      include 'SIZE'
-      include 'TOTAL'
-      logical ifbswap
-
-      integer e,eg,buf(55)
-      real rcurve
-
-      nwds = (2 + 1 + 5)*(wdsizi/4) !eg+iside+ccurve+curve(6,:,:) !only 5 in rea
-      len  = 4*nwds      ! 4 bytes / wd
-
-      if (nwds.gt.55.or.isize.gt.4) then
-         write(6,*)nid,' Error in bin_rd1_curve: buf size',nwds,isize
-         call exitt
-      endif
-
-      call nekgsync()
-
-      ierr = 0
-      len1 = 4
-      if (nid.eq.0) then  ! read & send/process
-
-         if(wdsizi.eq.8) then
-           call byte_read(rcurve,2,ierr)
-           if (ifbswap) call byte_reverse8(rcurve,2,ierr)
-           ncurve = rcurve
-         else
-           call byte_read(ncurve,1,ierr)
-           if (ifbswap) call byte_reverse(ncurve,1,ierr)
-         endif
-
-         if(ncurve.ne.0) write(6,*) '  reading curved sides '
-         do k=1,ncurve
-           if(ierr.eq.0) then
-              call byte_read(buf,nwds,ierr)
-              if(wdsizi.eq.8) then
-                if(ifbswap) call byte_reverse8(buf,nwds-2,ierr)
-                call copyi4(eg,buf(1),1)  !1,2
-              else
-                if (ifbswap) call byte_reverse(buf,nwds-1,ierr) ! last is char
-                eg  = buf(1)
-              endif
-
-              mid = gllnid(eg)
-              if (mid.eq.0.and.ierr.eq.0) then
-                 call buf_to_curve(buf)
-              else
-                 if(ierr.eq.0) then
-                   call csend(mid,buf,len,mid,0)
-                 else
-                   goto 98
-                 endif
-              endif
-           else
-              goto 98
-           endif
-         enddo
-  98     call buf_close_out  ! notify all procs: no more data
-
-      else               ! wait for data from node 0
-
-         ncurve_mx = 12*nelt
-         do k=1,ncurve_mx+1   ! +1 to make certain we receive the close-out
-
-            call crecv(nid,buf,len)
-            if(wdsizi.eq.8) then 
-               call copyi4(ichk,buf(1),1)
-               if(ichk.eq.0) goto 99
-               call buf_to_curve(buf)
-            elseif (buf(1).eq.0) then
-               goto 99
-            else
-               call buf_to_curve(buf)
-            endif
-            
-         enddo
-   99    call buf_close_out
-
-      endif
-      call err_chk(ierr,'Error reading .re2 curved data. Abort.$')
-
-
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine bin_rd1_bc (cbl,bl,ifbswap) ! v. 1 of bc reader
-
-      include 'SIZE'
-      include 'TOTAL'
-      logical ifbswap
-
-      character*3 cbl(6,lelt)
-      real         bl(5,6,lelt)
-
-      integer e,eg,buf(55)
-      real rbc_max
-
-      nwds = (2 + 1 + 5)*(wdsizi/4)   ! eg + iside + cbc + bc(5,:,:)
-      len  = 4*nwds      ! 4 bytes / wd
-
-      if (nwds.gt.55.or.isize.gt.4) then
-         write(6,*) nid,' Error in bin_rd1_bc: buf size',nwds,isize
-         call exitt
-      endif
-
-      do e=1,nelt   ! fill up cbc w/ default
-      do k=1,6
-         cbl(k,e) = 'E  '
-      enddo
-      enddo
-
-      call nekgsync()
-      ierr=0
-      len1=4
-      if (nid.eq.0) then  ! read & send/process
-  
-         if(wdsizi.eq.8) then
-           call byte_read(rbc_max,2,ierr)
-           if (ifbswap) call byte_reverse8(rbc_max,2,ierr) ! last is char
-           nbc_max = rbc_max
-         else
-           call byte_read(nbc_max,1,ierr)
-           if (ifbswap) call byte_reverse(nbc_max,1,ierr) ! last is char
-         endif
-
-         if(nbc_max.ne.0) write(6,*) '  reading bc for ifld',ifield
-         do k=1,nbc_max
-c           write(6,*) k,' dobc1 ',nbc_max
-            if(ierr.eq.0) then
-               call byte_read(buf,nwds,ierr)
-               if(wdsizi.eq.8) then
-                 if (ifbswap) call byte_reverse8(buf,nwds-2,ierr)
-                 call copyi4(eg,buf(1),1) !1&2 of buf
-               else
-                 if (ifbswap) call byte_reverse(buf,nwds-1,ierr) ! last is char
-                 eg  = buf(1)
-               endif
-               mid = gllnid(eg)
-c              write(6,*) k,' dobc3 ',eg,mid
-
-               if (mid.eq.0.and.ierr.eq.0) then
-                   call buf_to_bc(cbl,bl,buf)
-               else
-c                  write(6,*) mid,' sendbc1 ',eg
-                   if(ierr.eq.0) then
-                     call csend(mid,buf,len,mid,0)
-                   else
-                     goto 98
-                   endif
-c                  write(6,*) mid,' sendbc2 ',eg
-               endif
-c              write(6,*) k,' dobc2 ',nbc_max,eg
-            else
-               goto 98
-            endif
-         enddo
-c        write(6,*) mid,' bclose ',eg,nbc_max
-  98     call buf_close_outv ! notify all procs: no more data
-
-      else               ! wait for data from node 0
-
-         nbc_max = 2*ldim*nelt
-         do k=1,nbc_max+1  ! Need one extra !
-
-c           write(6,*) nid,' recvbc1',k
-            call crecv(nid,buf,len)
-c           write(6,*) nid,' recvbc2',k,buf(1)
-
-            if(wdsizi.eq.8) then 
-               call copyi4(ichk,buf(1),1)
-               if(ichk.eq.0) goto 99
-               call buf_to_bc(cbl,bl,buf)
-            elseif (buf(1).eq.0) then
-                goto 99
-            else
-                call buf_to_bc(cbl,bl,buf)
-            endif
-            
-         enddo
-   99    call buf_close_outv
-
-      endif
-
-      call err_chk(ierr,'Error reading boundary data for re2. Abort.$')
-
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine buf_close_outv  ! this is the stupid O(P) formulation
-
-      include 'SIZE'
-      include 'PARALLEL'
-      integer*4 zero
-      real      rzero
-
-      len   = wdsizi
-      rzero = 0
-      zero  = 0
-c     write(6,*) nid,' bufclose'
-      if (nid.eq.0) then
-         do mid=1,np-1
-            if(wdsizi.eq.8)call csend(mid,rzero,len,mid,0)
-            if(wdsizi.eq.4)call csend(mid, zero,len,mid,0)
-c           write(6,*) mid,' sendclose'
-         enddo
-      endif
-
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine buf_close_out  ! this is the stupid O(P) formulation
-
-      include 'SIZE'
-      include 'PARALLEL'
-      integer*4 zero
-      real      rzero
-
-c     len  = 4
-      len   = wdsizi
-      zero = 0
-      rzero = 0
-      if (nid.eq.0) then
-         do mid=1,np-1
-            if(wdsizi.eq.8)call csend(mid,rzero,len,mid,0)
-            if(wdsizi.eq.4)call csend(mid, zero,len,mid,0)
-         enddo
-      endif
-
       return
       end
 c-----------------------------------------------------------------------
@@ -789,9 +521,9 @@ c-----------------------------------------------------------------------
       call err_chk(ierr,' Cannot find re2 file!$')
 
       if (nid.eq.0) then
-         call byte_open(fname,ierr)
+         call byte_hopen(fname,ih,1,0,0,ierr)
          if(ierr.ne.0) goto 100
-         call byte_read(hdr,20,ierr)
+         call byte_hread(ih,hdr,20,ierr)
          if(ierr.ne.0) goto 100
 
          read (hdr,1) version,nelgt,ldimr,nelgv
@@ -804,12 +536,12 @@ c-----------------------------------------------------------------------
            param(32) = 1
          endif
 
-         call byte_read(test,1,ierr)
+         call byte_hread(ih,test,1,ierr)
          if(ierr.ne.0) goto 100
          ifbswap = if_byte_swap_test(test,ierr)
          if(ierr.ne.0) goto 100
         
-         call byte_close(ierr)
+         call byte_hclose(ih,ierr)
       endif
  
  100  call err_chk(ierr,'Error reading re2 header$')
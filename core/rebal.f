@@ -0,0 +1,662 @@
+c-----------------------------------------------------------------------
+c
+c     Runtime load rebalancing
+c
+c     nek_rebalance repartitions the elements by weighted recursive
+c     coordinate bisection (parmap_rcb), migrates the element data to
+c     the new ranks and rebuilds gather-scatter, geometry and solver
+c     setup.  The weight of an element is rb_wusr(e) times the work
+c     per unit weight measured on its rank (wall time of the time
+c     steps minus MPI time, see rebal_tic/rebal_toc).  The MPI time is
+c     only seen with MPITIMER and TIMER; otherwise rb_wusr alone is
+c     used.  nek_rebalance is collective and may be called from
+c     userchk.  With mesh:rebalanceTol = param(178) > 0 the imbalance
+c     max/avg-1 is checked every mesh:rebalanceInterval = param(179)
+c     steps (default 100) and the mesh is rebalanced above the tol.
+c
+c     User arrays holding m words per element are carried over after
+c     nek_rebalance with rebal_move (real), rebal_movei (integer) or
+c     rebal_movec (character); itype = 1 for arrays on the velocity
+c     mesh (nelv), 2 for all nelt elements.
+c
+c-----------------------------------------------------------------------
+      subroutine rebal_init
+
+      include 'SIZE'
+      include 'REBAL'
+
+      call rone(rb_wusr,lelt)
+      rb_tw    = 0
+      rb_tc    = 0
+      rb_nstep = 0
+      rb_cnt   = 0
+      rb_no    = 0
+      rb_nvo   = 0
+      rb_nn    = 0
+      rb_nvn   = 0
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_tic
+
+      include 'SIZE'
+      include 'REBAL'
+
+      real*8 dnekclock
+
+      rb_t0 = dnekclock()
+      call nek_comm_wtime(rb_tc0)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_toc
+
+      include 'SIZE'
+      include 'REBAL'
+
+      real*8 dnekclock,tc
+
+      call nek_comm_wtime(tc)
+      rb_tw    = rb_tw + (dnekclock()-rb_t0)
+      rb_tc    = rb_tc + (tc-rb_tc0)
+      rb_nstep = rb_nstep + 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_check
+c
+c     automatic rebalancing, called once per step after userchk
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'TSTEP'
+      include 'REBAL'
+
+      common /rebalw/ w(lelt)
+
+      if (param(178).le.0 .or. np.eq.1 .or. lastep.eq.1) return
+
+      nstp = 100
+      if (param(179).gt.0) nstp = param(179)
+      if (mod(istep,nstp).ne.0) return
+
+      call rebal_weights(w,rimb)
+      if (rimb.gt.param(178)) then
+         call nek_rebalance
+      else
+         rb_tw    = 0
+         rb_tc    = 0
+         rb_nstep = 0
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine nek_rebalance
+c
+c     rebalance the elements over the ranks (collective)
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'ZPER'
+      include 'REBAL'
+
+      common /rebalw/ w(lelt)
+
+      real*8 dnekclock_sync,etime0
+
+      if (np.eq.1) return
+
+      ierr = 0
+      if (ifcvode .or. ifneknek .or. ifmhd .or. ifchar .or. ifdg
+     $    .or. ifgfdm .or. ifzper .or. ifgtp) ierr = 1
+#ifdef CMTNEK
+      ierr = 1
+#endif
+      if (ierr.ne.0) then
+         if (nio.eq.0) write(6,*)
+     $      'WARNING: rebalance not supported for this case, skipping'
+         return
+      endif
+
+      etime0 = dnekclock_sync()
+
+      call rebal_weights(w,rimb)
+      call rebal_plan(w,nmove,ierr)
+      if (ierr.ne.0) then
+         if (nio.eq.0) write(6,*)
+     $      'WARNING: rebalance exceeds lelt/lelv, skipping'
+         return
+      endif
+
+      call rebal_fields
+      call rebal_finish
+      call rebal_setup
+
+      rb_tw    = 0
+      rb_tc    = 0
+      rb_nstep = 0
+      rb_cnt   = rb_cnt + 1
+
+      dtmp = dnekclock_sync() - etime0
+      if (nio.eq.0) write(6,1) istep,rimb,nmove,dtmp
+    1 format(i9,' rebalance: imbalance',f8.3,'  moved',i10
+     $      ,' elements  done ::',1p1e13.4,' sec')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_weights(w,rimb)
+c
+c     element weights w and the current imbalance max/avg-1 of the
+c     rank loads
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'REBAL'
+
+      real w(1)
+      real*8 tw
+
+      integer e
+
+      wsum = 0
+      do e=1,nelt
+         wsum = wsum + rb_wusr(e)
+      enddo
+
+      tc = rb_tc
+      tc = glmax(tc,1)
+      if (rb_nstep.gt.0 .and. tc.gt.0 .and. wsum.gt.0) then
+         tw = max(rb_tw-rb_tc,0.d0)
+         do e=1,nelt
+            w(e) = rb_wusr(e)*tw/wsum
+         enddo
+      else
+         call copy(w,rb_wusr,nelt)
+      endif
+
+      ! keep every element in the count
+      wrk  = vlsum(w,nelt)
+      wtot = glsum(wrk,1)
+      wmin = 1.e-3*wtot/nelgt
+      if (wmin.le.0) wmin = 1
+      do e=1,nelt
+         w(e) = max(w(e),wmin)
+      enddo
+
+      wrk  = vlsum(w,nelt)
+      wmax = glmax(wrk,1)
+      wtot = glsum(wrk,1)
+      rimb = wmax/(wtot/np) - 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_plan(w,nmove,ierr)
+c
+c     new rank of every local element and the new local element list
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'REBAL'
+
+      real w(1)
+
+      real            xce(ldim,lelt)
+      integer         iw(2,lelt)
+      common /rebalp/ xce,iw
+
+      integer e
+
+      nv = 2**ldim
+      do e=1,nelt
+         xce(1,e) = vlsum(xc(1,e),nv)/nv
+         xce(2,e) = vlsum(yc(1,e),nv)/nv
+         if (ldim.eq.3) xce(ldim,e) = vlsum(zc(1,e),nv)/nv
+      enddo
+
+      call parmap_rcb(rb_dst,xce,w,lglel,nelv,nelgv)
+      call parmap_rcb(rb_dst(nelv+1),xce(1,nelv+1),w(nelv+1)
+     $               ,lglel(nelv+1),nelt-nelv,nelgt-nelgv)
+
+      nmove = 0
+      do e=1,nelt
+         if (rb_dst(e).ne.nid) nmove = nmove+1
+         iw(1,e)   = rb_dst(e)
+         iw(2,e)   = lglel(e)
+         rb_ego(e) = lglel(e)
+      enddo
+      nmove = iglsum(nmove,1)
+
+      n   = nelt
+      key = 1
+      call fgslib_crystal_ituple_transfer(cr_h,iw,2,n,lelt,key)
+      key = 2
+      call fgslib_crystal_ituple_sort(cr_h,iw,2,n,key,1)
+
+      nv = 0
+      do e=1,n
+         rb_eg(e) = iw(2,e)
+         if (rb_eg(e).le.nelgv) nv = nv+1
+      enddo
+
+      ierr = 0
+      if (n.gt.lelt .or. nv.gt.lelv .or. n.lt.1) ierr = 1
+      ierr = iglmax(ierr,1)
+      if (ierr.ne.0) return
+
+      rb_no  = nelt
+      rb_nvo = nelv
+      rb_nn  = n
+      rb_nvn = nv
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_fields
+c
+c     migrate mesh, solution and lag arrays
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'AVG'
+      include 'REBAL'
+
+      common /ivrtx/ vertex((2**ldim)*lelt)
+      integer vertex
+
+      integer f
+
+      n1 = lx1*ly1*lz1
+      n2 = lx2*ly2*lz2
+      nm = lx1m*ly1m*lz1m
+      np1 = lpx1*lpy1*lpz1
+      np2 = lpx2*lpy2*lpz2
+      na1 = ax1*ay1*az1
+      na2 = ax2*ay2*az2
+
+      call rebal_move (rb_wusr,1,2)
+
+      ! mesh
+      call rebal_move (xc,8,2)
+      call rebal_move (yc,8,2)
+      call rebal_move (zc,8,2)
+      call rebal_move (curve,72,2)
+      call rebal_movec(ccurve,12,2)
+      call rebal_movec(cdof,6,2)
+      call rebal_movei(igroup,1,2)
+      call rebal_movei(imatie,1,2)
+      call rebal_movei(vertex,2**ldim,2)
+      do f=0,ldimt1
+         call rebal_move (bc(1,1,1,f),30,2)
+         call rebal_movec(cbc(1,1,f),18,2)
+      enddo
+      call rebal_move (xm1,n1,2)
+      call rebal_move (ym1,n1,2)
+      call rebal_move (zm1,n1,2)
+      do i=1,lorder-1
+         call rebal_move (bm1lag(1,1,1,1,i),n1,2)
+      enddo
+
+      ! velocity and pressure
+      call rebal_move (vx,n1,1)
+      call rebal_move (vy,n1,1)
+      call rebal_move (vz,n1,1)
+      do i=1,2
+         call rebal_move (vxlag(1,1,1,1,i),n1,1)
+         call rebal_move (vylag(1,1,1,1,i),n1,1)
+         call rebal_move (vzlag(1,1,1,1,i),n1,1)
+      enddo
+      call rebal_move (abx1,n1,1)
+      call rebal_move (aby1,n1,1)
+      call rebal_move (abz1,n1,1)
+      call rebal_move (abx2,n1,1)
+      call rebal_move (aby2,n1,1)
+      call rebal_move (abz2,n1,1)
+      call rebal_move (pr,n2,1)
+      do i=1,lorder2
+         call rebal_move (prlag(1,1,1,1,i),n2,1)
+      enddo
+      call rebal_move (usrdiv,n2,2)
+
+      ! scalars
+      do f=1,ldimt
+         call rebal_move (t(1,1,1,1,f),n1,2)
+         do i=1,lorder-1
+            call rebal_move (tlag(1,1,1,1,i,f),n1,2)
+         enddo
+         call rebal_move (vgradt1(1,1,1,1,f),n1,2)
+         call rebal_move (vgradt2(1,1,1,1,f),n1,2)
+      enddo
+      call rebal_move (vdiff_e,n1,2)
+
+      ! mesh velocity
+      if (ifmvbd) then
+         call rebal_move (wx,nm,2)
+         call rebal_move (wy,nm,2)
+         call rebal_move (wz,nm,2)
+         do i=1,lorder-1
+            call rebal_move (wxlag(1,1,1,1,i),nm,2)
+            call rebal_move (wylag(1,1,1,1,i),nm,2)
+            call rebal_move (wzlag(1,1,1,1,i),nm,2)
+         enddo
+      endif
+
+      ! perturbations
+      if (ifpert .and. lpelv.eq.lelv .and. lpelt.eq.lelt) then
+         do j=1,npert
+            call rebal_move (vxp(1,j),np1,1)
+            call rebal_move (vyp(1,j),np1,1)
+            call rebal_move (vzp(1,j),np1,1)
+            call rebal_move (prp(1,j),np2,1)
+            call rebal_move (exx1p(1,j),np1,1)
+            call rebal_move (exy1p(1,j),np1,1)
+            call rebal_move (exz1p(1,j),np1,1)
+            call rebal_move (exx2p(1,j),np1,1)
+            call rebal_move (exy2p(1,j),np1,1)
+            call rebal_move (exz2p(1,j),np1,1)
+            do i=1,lorder-1
+               call rebal_move (vxlagp(1,i,j),np1,1)
+               call rebal_move (vylagp(1,i,j),np1,1)
+               call rebal_move (vzlagp(1,i,j),np1,1)
+            enddo
+            do i=1,lorder2
+               call rebal_move (prlagp(1,i,j),np2,1)
+            enddo
+            do f=1,ldimt
+               call rebal_move (tp(1,f,j),np1,2)
+               call rebal_move (vgradt1p(1,f,j),np1,2)
+               call rebal_move (vgradt2p(1,f,j),np1,2)
+               do i=1,lorder-1
+                  call rebal_move (tlagp(1,f,i,j),np1,2)
+               enddo
+            enddo
+         enddo
+      endif
+
+      ! running averages
+      call rebal_move (uavg,na1,2)
+      call rebal_move (vavg,na1,2)
+      call rebal_move (wavg,na1,2)
+      call rebal_move (pavg,na2,2)
+      call rebal_move (urms,na1,2)
+      call rebal_move (vrms,na1,2)
+      call rebal_move (wrms,na1,2)
+      call rebal_move (prms,na2,2)
+      call rebal_move (vwms,na1,2)
+      call rebal_move (wums,na1,2)
+      call rebal_move (uvms,na1,2)
+      do f=1,ldimt
+         call rebal_move (tavg(1,1,1,1,f),na1,2)
+         call rebal_move (trms(1,1,1,1,f),na1,2)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_finish
+c
+c     switch to the new element list
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'TSTEP'
+      include 'DPROCMAP'
+      include 'REBAL'
+
+      integer         ibuf(2,lelt)
+      common /rebalq/ ibuf
+
+      integer e
+
+      nelt = rb_nn
+      nelv = rb_nvn
+      do e=1,nelt
+         lglel(e)  = rb_eg(e)
+         ibuf(1,e) = e
+         ibuf(2,e) = nid
+      enddo
+      call dProcmapPutN(ibuf,2,2,0,lglel,1,nelt)
+      call nekgsync()
+      dProcmapGen = dProcmapGen + 1
+
+      do i=0,ldimt1
+         if (iftmsh(i)) then
+            nelfld(i) = nelt
+         else
+            nelfld(i) = nelv
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_setup
+c
+c     free the setup bound to the old partition and rebuild it as in
+c     nek_init
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'HSMG'
+      include 'ORTHOP'
+      include 'ORTHOT'
+      include 'ORTHOSTRS'
+      include 'VPROJ'
+
+      common /orthoi/ nprev,mprev
+
+      logical ifovl
+
+      ifovl = ifflow .and. (fintim.ne.0.or.nsteps.ne.0)
+     $        .and. iftran .and. solver_type.eq.'itr'
+
+      call dssum_split_free
+#ifdef OPENACC
+      call nek_acc_gs_free
+#endif
+      call fgslib_gs_free(gsh_fld(1))
+      if (gsh_fld(2).ne.gsh_fld(1)) call fgslib_gs_free(gsh_fld(2))
+      if (ifmvbd) call fgslib_gs_free(gsh_fld(0)) ! own mesh handle
+
+      if (ifovl) then
+         nl = 0
+         if (ifsplit .and. ifmgrid) then
+            nl = mg_lmax
+         elseif (.not.ifsplit .and. param(43).eq.0) then
+            nl = mg_lmax-1
+         endif
+         npass = 1
+         if (ifmhd) npass = 2       ! B-field handles sit in mg_fld=2
+         do ipass=1,npass
+            ifld = 1
+            if (ipass.gt.1) ifld = ifldmhd
+            do l=1,nl
+               call fgslib_gs_free(mg_gsh_handle(l,ipass))
+               call fgslib_gs_free(mg_gsh_schwarz_handle(l,ipass))
+            enddo
+            call nek_crs_free(xxth(ifld))
+         enddo
+      endif
+
+      call setup_topo
+      if (ifmvbd) call setup_mesh_dssum
+      call geom_reset(1)
+      call bcmask
+      if (ifovl) call set_overlap
+      call setprop
+
+      ! projection spaces hold data of the old partition
+      napproxp(2) = 0
+      do i=1,ldimt_proj
+         napproxt(2,i) = 0
+      enddo
+      napproxstrs(2) = 0
+      do i=1,6
+         ivproj(2,i) = 0
+      enddo
+      nprev = 0
+
+#ifdef OPENACC
+      call nek_acc_init
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_move(a,m,itype)
+c
+c     migrate a(m,nel) to the rebalanced partition, in place
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'REBAL'
+
+      real a(m,1)
+
+      parameter (lb = lx1*ly1*lz1)
+      real            vr(lb*lelt)
+      integer         vi(2,lelt)
+      integer*8       vl(1)
+      common /rebalb/ vr,vl,vi
+
+      integer e
+
+      nold = rb_no
+      nnew = rb_nn
+      if (itype.eq.1) then
+         nold = rb_nvo
+         nnew = rb_nvn
+      endif
+      if (rb_no.eq.0 .or. m.le.0) return
+
+      do j0=1,m,lb
+         mc = min(lb,m-j0+1)
+         k  = 0
+         do e=1,nold
+            vi(1,e) = rb_dst(e)
+            vi(2,e) = rb_ego(e)
+            do j=1,mc
+               vr(k+j) = a(j0+j-1,e)
+            enddo
+            k = k+mc
+         enddo
+         n   = nold
+         key = 1
+         call fgslib_crystal_tuple_transfer(cr_h,n,lelt,vi,2,vl,0,vr,mc
+     $                                     ,key)
+         key = 2
+         call fgslib_crystal_tuple_sort(cr_h,n,vi,2,vl,0,vr,mc,key,1)
+         k = 0
+         do e=1,nnew
+            do j=1,mc
+               a(j0+j-1,e) = vr(k+j)
+            enddo
+            k = k+mc
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_movei(ia,m,itype)
+c
+c     rebal_move for integer arrays
+c
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'REBAL'
+
+      integer ia(m,1)
+
+      parameter (lmi = 16)
+      integer         iw((lmi+2)*lelt)
+      common /rebalj/ iw
+
+      integer e
+
+      nold = rb_no
+      nnew = rb_nn
+      if (itype.eq.1) then
+         nold = rb_nvo
+         nnew = rb_nvn
+      endif
+      if (rb_no.eq.0 .or. m.le.0) return
+
+      do j0=1,m,lmi
+         mc = min(lmi,m-j0+1)
+         mw = mc+2
+         k  = 0
+         do e=1,nold
+            iw(k+1) = rb_dst(e)
+            iw(k+2) = rb_ego(e)
+            do j=1,mc
+               iw(k+2+j) = ia(j0+j-1,e)
+            enddo
+            k = k+mw
+         enddo
+         n   = nold
+         key = 1
+         call fgslib_crystal_ituple_transfer(cr_h,iw,mw,n,lelt,key)
+         key = 2
+         call fgslib_crystal_ituple_sort(cr_h,iw,mw,n,key,1)
+         k = 0
+         do e=1,nnew
+            do j=1,mc
+               ia(j0+j-1,e) = iw(k+2+j)
+            enddo
+            k = k+mw
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rebal_movec(c,m,itype)
+c
+c     rebal_move for character arrays, m characters per element
+c
+      include 'SIZE'
+      include 'REBAL'
+
+      character*1 c(m,1)
+
+      parameter (lmc = 18)
+      integer         ic(lmc,lelt)
+      common /rebalc/ ic
+
+      integer e
+
+      nold = rb_no
+      nnew = rb_nn
+      if (itype.eq.1) then
+         nold = rb_nvo
+         nnew = rb_nvn
+      endif
+      if (rb_no.eq.0 .or. m.le.0) return
+
+      do j0=1,m,lmc
+         mc = min(lmc,m-j0+1)
+         do e=1,nold
+         do j=1,mc
+            ic(j,e) = ichar(c(j0+j-1,e))
+         enddo
+         enddo
+         call rebal_movei(ic,lmc,itype)
+         do e=1,nnew
+         do j=1,mc
+            c(j0+j-1,e) = char(ic(j,e))
+         enddo
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
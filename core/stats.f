@@ -0,0 +1,615 @@
+c-----------------------------------------------------------------------
+c
+c     Turbulence statistics
+c
+c     Time averages of products of the solution and its gradient,
+c     averaged along the homogeneous directions of a tensor product
+c     mesh (elements numbered lexicographically in nelx,nely,nelz, as
+c     for gtpp_gs_setup).  Only the reduced arrays are kept, one value
+c     per statistic and GLL line (one homogeneous direction) or plane
+c     (two), instead of a full field per statistic as in avg_all.
+c
+c     Usage (userchk):
+c
+c        if (istep.eq.0) then
+c           call stat_init('xz',nelx,nely,nelz)  ! homogeneous in x,z
+c           call stat_add_std                   ! moments and budgets
+c           call stat_add('p*p*p')              ! user defined
+c           call stat_load('chan.sts00002')     ! optional restart
+c        endif
+c        call stat_avg
+c
+c     A statistic is a sum of up to lsterm products of up to lsfac of
+c
+c        u v w p t  ux uy uz vx vy vz wx wy wz  px py pz  tx ty tz
+c
+c     (velocity, pressure on the velocity mesh, temperature and their
+c     x,y,z derivatives, taken element by element), e.g. 'u*v*w' or
+c     'ux*ux+uy*uy+uz*uz'.
+c
+c     Each step all statistics are evaluated in one pass over the
+c     elements and summed (mass weighted) into the slots, one gather-
+c     scatter completes the slot sums across ranks, and the slot means
+c     x enter the running time average by the weighted incremental
+c     (Welford) update  m := m + dt/T (x - m),  T the averaging time.
+c     The state is cumulative; every param(68) (else iostep) steps it
+c     is written to <session>.sts<nnnnn> and any such file can be read
+c     back by stat_load to continue the average.
+c
+c     File layout: a 132 character header
+c
+c        #sts nstat ngl ldim nc1 nc2 T time istep
+c
+c     nstat names (character*32), the real*4 test pattern 6.54321 and
+c     ngl records (wdsize reals) of the ldim slot coordinates followed
+c     by the nstat averages.  Slot g = i1 + nc1*(i2-1) enumerates the
+c     GLL points of the non-homogeneous directions in x,y,z order.
+c
+c-----------------------------------------------------------------------
+      subroutine stat_init(hdir,nelx,nely,nelz)
+c
+c     hdir: homogeneous directions ('x', 'z', 'xz', ...)
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'STATS'
+      include 'WSPACE'
+
+      character*(*) hdir
+      integer nelx,nely,nelz
+
+      character*3 hd
+      integer e,eg,d,ex(3),ic(3),ll(3)
+      integer*8 ka,ki,kw
+
+      hd = hdir
+      call capit(hd,3)
+      nh = 0
+      do d=1,3
+         ifshom(d) = d.le.ldim .and. index(hd,char(ichar('X')+d-1)).gt.0
+         if (ifshom(d)) nh = nh+1
+      enddo
+      if (nh.lt.1 .or. nh.ge.ldim)
+     $   call exitti('stat_init: invalid homogeneous directions$',nh)
+      if (nelx*nely*nelz.ne.nelgv)
+     $   call exitti('stat_init: invalid gtp mesh dimensions!$',nelgv)
+
+      sts_nel(1) = nelx
+      sts_nel(2) = nely
+      sts_nel(3) = nelz
+      ll(1) = lx1
+      ll(2) = ly1
+      ll(3) = lz1
+
+      nd = 0
+      nsc(1) = 1
+      nsc(2) = 1
+      do d=1,ldim
+         if (.not.ifshom(d)) then
+            nd = nd+1
+            nsc(nd) = sts_nel(d)*(ll(d)-1)+1
+         endif
+      enddo
+      if (real(nsc(1))*nsc(2).gt.2.e9)
+     $   call exitti('stat_init: too many slots in the plane$',nsc(1))
+      nsgl = nsc(1)*nsc(2)
+
+c     slot of each point: its GLL index in the non-homogeneous directions
+      nxyz = lx1*ly1*lz1
+      n    = nxyz*nelv
+      call nek_ws_push
+      ka = nek_ws_i(n)
+      ki = nek_ws_i(n)
+      l  = 0
+      do e=1,nelv
+         eg = lglel(e)
+         call get_exyz(ex(1),ex(2),ex(3),eg,nelx,nely,nelz)
+         do k=1,lz1
+         do j=1,ly1
+         do i=1,lx1
+            ic(1) = i
+            ic(2) = j
+            ic(3) = k
+            ig = 1
+            is = 1
+            do d=1,ldim
+               if (.not.ifshom(d)) then
+                  ig = ig + is*((ex(d)-1)*(ll(d)-1)+ic(d)-1)
+                  is = is*(sts_nel(d)*(ll(d)-1)+1)
+               endif
+            enddo
+            iws(ka+l) = ig
+            l = l+1
+         enddo
+         enddo
+         enddo
+      enddo
+
+      call isort(iws(ka),iws(ki),n)
+      nsslot = 0
+      do l=0,n-1
+         if (l.eq.0 .or. iws(ka+l).ne.iws(ka+max(l-1,0))) then
+            nsslot = nsslot+1
+            if (nsslot.gt.lsslot)
+     $         call exitti('stat_init: increase lsslot in STATS$',l)
+            sts_gid(nsslot) = iws(ka+l)
+         endif
+         islot(iws(ki+l)) = nsslot
+      enddo
+      call nek_ws_pop
+
+      call fgslib_gs_setup(sts_gsh,sts_gid,nsslot,nekcomm,np)
+
+c     slot volumes, centroids and the rank writing each slot
+      call nek_ws_push
+      m  = ldim+1
+      kw = nek_ws_r(nsslot*m)
+      call rzero(ws(kw),nsslot*m)
+      do i=1,n
+         l = kw-1+islot(i)
+         ws(l)          = ws(l)          + bm1(i,1,1,1)
+         ws(l+nsslot)   = ws(l+nsslot)   + bm1(i,1,1,1)*xm1(i,1,1,1)
+         ws(l+2*nsslot) = ws(l+2*nsslot) + bm1(i,1,1,1)*ym1(i,1,1,1)
+         if (if3d) ws(l+3*nsslot) = ws(l+3*nsslot)
+     $                            + bm1(i,1,1,1)*zm1(i,1,1,1)
+      enddo
+      call fgslib_gs_op_fields(sts_gsh,ws(kw),nsslot,m,1,1,0)
+      call copy(sts_vol,ws(kw),nsslot)
+      do d=1,ldim
+         call invcol3(sts_xyz(1,d),ws(kw+d*nsslot),sts_vol,nsslot)
+      enddo
+
+      do j=1,nsslot
+         ws(kw+j-1) = nid
+      enddo
+      call fgslib_gs_op(sts_gsh,ws(kw),1,3,0)
+      do j=1,nsslot
+         ifsown(j) = nint(ws(kw+j-1)).eq.nid
+      enddo
+      call nek_ws_pop
+
+      nstat     = 0
+      sts_nout  = 0
+      sts_atime = 0.
+      sts_timel = time
+      do i=1,lsbase
+         ifsbase(i) = .false.
+      enddo
+
+      nsmax = iglmax(nsslot,1)
+      if (nio.eq.0) write(6,1) hd,nsc(1),nsc(2),nsmax
+    1 format(' stat: homogeneous ',a3,', ',i9,' x',i9,' slots,'
+     $      ,i9,' max per rank')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_add(spec)
+c
+c     add statistic spec, a sum of products of base fields, e.g. 'u*v'
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'STATS'
+
+      character*(*) spec
+
+      character*132 s
+      character*2 bname(lsbase)
+      data bname /'U ','V ','W ','P ','T '
+     $           ,'UX','UY','UZ','VX','VY','VZ','WX','WY','WZ'
+     $           ,'PX','PY','PZ','TX','TY','TZ'/
+
+      if (nstat.ge.lstat)
+     $   call exitti('stat_add: increase lstat in STATS$',lstat)
+      k = nstat+1
+
+      n = 0
+      do i=1,len(spec)
+         if (spec(i:i).ne.' ' .and. n.lt.131) then
+            n = n+1
+            s(n:n) = spec(i:i)
+         endif
+      enddo
+      if (n.eq.0) call exitti('stat_add: empty statistic$',k)
+      call blank(sts_name(k),32)
+      sts_name(k) = s(1:n)
+      call capit(s,n)
+
+      call izero(sts_fac(1,1,k),lsfac*lsterm)
+      it = 1
+      jf = 0
+      i0 = 1
+      do i=1,n+1
+         if (i.gt.n .or. s(i:i).eq.'*' .or. s(i:i).eq.'+') then
+            ib = 0
+            if (i-i0.ge.1 .and. i-i0.le.2) then
+               do j=1,lsbase
+                  if (s(i0:i-1).eq.bname(j)(1:i-i0)
+     $                .and. bname(j)(i-i0+1:).eq.' ') ib = j
+               enddo
+            endif
+            if (ib.eq.3 .or. ib.eq.8 .or. ib.eq.11 .or. ib.eq.17
+     $          .or. ib.eq.20 .or. (ib.ge.12 .and. ib.le.14)) then
+               if (.not.if3d) ib = 0
+            endif
+            if ((ib.eq.5 .or. ib.ge.18) .and. .not.ifheat) ib = 0
+            if (ib.eq.0) then
+               if (nid.eq.0) write(6,*) 'stat_add: invalid ',s(1:n)
+               call exitti('stat_add: invalid statistic$',k)
+            endif
+            jf = jf+1
+            if (jf.gt.lsfac)
+     $         call exitti('stat_add: increase lsfac in STATS$',k)
+            sts_fac(jf,it,k) = ib
+            ifsbase(ib) = .true.
+            if (i.le.n) then
+               if (s(i:i).eq.'+') then
+                  it = it+1
+                  jf = 0
+                  if (it.gt.lsterm) call exitti
+     $               ('stat_add: increase lsterm in STATS$',k)
+               endif
+            endif
+            i0 = i+1
+         endif
+      enddo
+      sts_nterm(k) = it
+
+      call rzero(sts_avg(1,k),nsslot)
+      nstat = k
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_add_std
+c
+c     means, Reynolds stresses, triple products, pressure-velocity and
+c     pressure-gradient correlations and the dissipation tensor sums
+c     (the terms of the Reynolds stress budgets), plus the temperature
+c     moments and fluxes with a temperature field
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'STATS'
+
+      parameter (ns3=39,ns2=20,nst=5)
+      character*20 s3(ns3),s2(ns2),st(nst)
+      data s3 /'u','v','w','p'
+     $        ,'u*u','v*v','w*w','p*p','u*v','u*w','v*w'
+     $        ,'u*u*u','v*v*v','w*w*w','u*u*v','u*u*w','u*v*v'
+     $        ,'v*v*w','u*w*w','v*w*w','u*v*w'
+     $        ,'p*u','p*v','p*w'
+     $        ,'p*ux','p*uy','p*uz','p*vx','p*vy','p*vz'
+     $        ,'p*wx','p*wy','p*wz'
+     $        ,'ux*ux+uy*uy+uz*uz','vx*vx+vy*vy+vz*vz'
+     $        ,'wx*wx+wy*wy+wz*wz','ux*vx+uy*vy+uz*vz'
+     $        ,'ux*wx+uy*wy+uz*wz','vx*wx+vy*wy+vz*wz'/
+      data s2 /'u','v','p'
+     $        ,'u*u','v*v','p*p','u*v'
+     $        ,'u*u*u','v*v*v','u*u*v','u*v*v'
+     $        ,'p*u','p*v'
+     $        ,'p*ux','p*uy','p*vx','p*vy'
+     $        ,'ux*ux+uy*uy','vx*vx+vy*vy','ux*vx+uy*vy'/
+      data st /'t','t*t','u*t','v*t','w*t'/
+
+      if (if3d) then
+         do i=1,ns3
+            call stat_add(s3(i))
+         enddo
+      else
+         do i=1,ns2
+            call stat_add(s2(i))
+         enddo
+      endif
+      if (ifheat) then
+         n = nst
+         if (.not.if3d) n = nst-1
+         do i=1,n
+            call stat_add(st(i))
+         enddo
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_avg
+c
+c     accumulate the statistics of the current step, dump if due
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'STATS'
+      include 'WSPACE'
+
+      integer*8 kw
+
+      if (nstat.eq.0) return
+
+      dtime = time - sts_timel
+      if (dtime.gt.0) then
+         sts_atime = sts_atime + dtime
+         beta      = dtime/sts_atime
+         call nek_ws_push
+         kw = nek_ws_r(nsslot*nstat)
+         call stat_sum(ws(kw))
+         call fgslib_gs_op_fields(sts_gsh,ws(kw),nsslot,nstat,1,1,0)
+         call stat_upd(ws(kw),beta)
+         call nek_ws_pop
+      endif
+      sts_timel = time
+
+      iastep = param(68)
+      if (iastep.eq.0) iastep = param(15)   ! same as iostep
+      if (iastep.eq.0) iastep = 500
+
+      if ((mod(istep,iastep).eq.0 .and. istep.gt.0) .or. lastep.eq.1)
+     $   call stat_dump
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_sum(acc)
+c
+c     acc = mass weighted sums of all statistics over the local slots,
+c     one pass over the elements
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'STATS'
+      include 'WSPACE'
+
+      real acc(nsslot,nstat)
+
+      parameter (lxyz=lx1*ly1*lz1)
+      common /stsw/ b(lxyz,lsbase),tmp(lxyz)
+
+      integer e
+      integer*8 kp
+
+      nxyz = lx1*ly1*lz1
+      call rzero(acc,nsslot*nstat)
+
+      call nek_ws_push
+      if (ifsbase(4) .or. ifsbase(15) .or. ifsbase(16)
+     $               .or. ifsbase(17)) then
+         if (lx2.eq.lx1) then
+            kp = nek_ws_loc(pr)
+         else
+            kp = nek_ws_r(nxyz*nelv)
+            call mappr(ws(kp),pr,b(1,15),b(1,16))
+         endif
+      endif
+
+      do e=1,nelv
+         i0 = (e-1)*nxyz
+         if (ifsbase(1)) call copy(b(1,1),vx(1,1,1,e),nxyz)
+         if (ifsbase(2)) call copy(b(1,2),vy(1,1,1,e),nxyz)
+         if (ifsbase(3)) call copy(b(1,3),vz(1,1,1,e),nxyz)
+         if (ifsbase(4)) call copy(b(1,4),ws(kp+i0),nxyz)
+         if (ifsbase(5)) call copy(b(1,5),t(1,1,1,e,1),nxyz)
+         if (ifsbase(6) .or. ifsbase(7) .or. ifsbase(8))
+     $      call gradm11(b(1,6),b(1,7),b(1,8),vx,e)
+         if (ifsbase(9) .or. ifsbase(10) .or. ifsbase(11))
+     $      call gradm11(b(1,9),b(1,10),b(1,11),vy,e)
+         if (ifsbase(12) .or. ifsbase(13) .or. ifsbase(14))
+     $      call gradm11(b(1,12),b(1,13),b(1,14),vz,e)
+         if (ifsbase(15) .or. ifsbase(16) .or. ifsbase(17))
+     $      call gradm11(b(1,15),b(1,16),b(1,17),ws(kp),e)
+         if (ifsbase(18) .or. ifsbase(19) .or. ifsbase(20))
+     $      call gradm11(b(1,18),b(1,19),b(1,20),t,e)
+
+         do k=1,nstat
+         do it=1,sts_nterm(k)
+            call copy(tmp,bm1(1,1,1,e),nxyz)
+            do jf=1,lsfac
+               ib = sts_fac(jf,it,k)
+               if (ib.gt.0) call col2(tmp,b(1,ib),nxyz)
+            enddo
+            do i=1,nxyz
+               l = islot(i0+i)
+               acc(l,k) = acc(l,k) + tmp(i)
+            enddo
+         enddo
+         enddo
+      enddo
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_upd(acc,beta)
+
+      include 'SIZE'
+      include 'STATS'
+
+      real acc(nsslot,nstat),beta
+
+      do k=1,nstat
+      do j=1,nsslot
+         x = acc(j,k)/sts_vol(j)
+         sts_avg(j,k) = sts_avg(j,k) + beta*(x-sts_avg(j,k))
+      enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_dump
+c
+c     write the averages to <session>.sts<nnnnn>; the slots are
+c     collected in chunks of about one field of memory
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'STATS'
+      include 'WSPACE'
+
+      character*132 hdr,fname
+      real*4 test
+      data   test / 6.54321 /
+      integer*8 kb,kw
+
+      sts_nout = sts_nout+1
+      call blank(fname,132)
+      ls = ltrunc(session,132)
+      write(fname,'(a,a4,i5.5)') session(1:ls),'.sts',sts_nout
+
+      nrec = ldim+nstat
+      nc   = min(nsgl,max(1,lx1*ly1*lz1*lelv/nrec))
+      call nek_ws_push
+      kb = nek_ws_r(nc*nrec)
+      kw = nek_ws_r(nc*nrec)
+
+      ierr = 0
+      if (nid.eq.0) then
+         call blank(hdr,132)
+         write(hdr,1) '#sts',nstat,nsgl,ldim,nsc(1),nsc(2)
+     $              ,sts_atime,time,istep
+    1    format(a4,i4,i12,i2,2i10,1p2e25.16,i10)
+         call byte_hopen(fname,ih,2,0,0,ierr)
+         if (ierr.eq.0) call byte_hwrite(ih,hdr,33,ierr)
+         if (ierr.eq.0) call byte_hwrite(ih,sts_name,8*nstat,ierr)
+         if (ierr.eq.0) call byte_hwrite(ih,test,1,ierr)
+      endif
+      call err_chk(ierr,'stat_dump: cannot write statistics file$')
+
+      do ig=1,nsgl,nc
+         m = min(nc,nsgl-ig+1)
+         call stat_pack(ws(kb),ig,m,nrec)
+         call gop(ws(kb),ws(kw),'+  ',m*nrec)
+         if (nid.eq.0 .and. ierr.eq.0)
+     $      call byte_hwrite(ih,ws(kb),m*nrec*wdsize/4,ierr)
+      enddo
+      if (nid.eq.0 .and. ih.ge.0) then
+         call byte_hclose(ih,jerr)
+         ierr = max(ierr,jerr)
+      endif
+      call err_chk(ierr,'stat_dump: cannot write statistics file$')
+      call nek_ws_pop
+
+      if (nio.eq.0) write(6,2) fname(1:ltrunc(fname,132)),sts_atime
+    2 format(' stat: wrote ',a,', averaging time ',1pe13.5)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_pack(buf,ig,m,nrec)
+c
+c     records ig..ig+m-1 of the slots owned by this rank, zero elsewhere
+c
+      include 'SIZE'
+      include 'STATS'
+
+      real buf(nrec,m)
+      integer d
+
+      call rzero(buf,nrec*m)
+      do j=1,nsslot
+         l = sts_gid(j)-ig+1
+         if (ifsown(j) .and. l.ge.1 .and. l.le.m) then
+            do d=1,ldim
+               buf(d,l) = sts_xyz(j,d)
+            enddo
+            do k=1,nstat
+               buf(ldim+k,l) = sts_avg(j,k)
+            enddo
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_load(fname)
+c
+c     continue the averages of a stat_dump file with the same
+c     statistics (call after stat_add)
+c
+      include 'SIZE'
+      include 'TOTAL'
+      include 'STATS'
+      include 'WSPACE'
+
+      character*(*) fname
+
+      character*132 hdr,fn
+      character*32  snam(lstat)
+      real*4 test
+      integer*8 kb
+
+      if (nstat.eq.0) call exitti('stat_load: no statistics$',0)
+
+      ierr = 0
+      if (nid.eq.0) then
+         call blank(fn,132)
+         fn = fname
+         call byte_hopen(fn,ih,1,0,0,ierr)
+         if (ierr.eq.0) call byte_hread(ih,hdr,33,ierr)
+      endif
+      call err_chk(ierr,'stat_load: cannot read statistics file$')
+      call bcast(hdr,132)
+      read(hdr(5:),*,iostat=ierr) ns,ng,nd,n1,n2,atime,tf,istf
+      if (ierr.ne.0 .or. hdr(1:4).ne.'#sts')
+     $   call exitti('stat_load: invalid header$',ierr)
+      if (ns.ne.nstat .or. ng.ne.nsgl .or. nd.ne.ldim)
+     $   call exitti('stat_load: statistics do not match the file$',ns)
+
+      if (nid.eq.0) then
+         call byte_hread(ih,snam,8*nstat,ierr)
+         if (ierr.eq.0) call byte_hread(ih,test,1,ierr)
+         if (ierr.eq.0 .and. abs(test-6.54321).gt.1e-5) ierr = 1
+      endif
+      call err_chk(ierr,'stat_load: cannot read statistics file$')
+      call bcast(snam,32*nstat)
+      do k=1,nstat
+         if (snam(k).ne.sts_name(k)) then
+            if (nid.eq.0) write(6,*) 'stat_load: ',sts_name(k)
+     $                               ,' vs ',snam(k)
+            call exitti('stat_load: statistic does not match$',k)
+         endif
+      enddo
+
+      nrec = ldim+nstat
+      nc   = min(nsgl,max(1,lx1*ly1*lz1*lelv/nrec))
+      call nek_ws_push
+      kb = nek_ws_r(nc*nrec)
+      do ig=1,nsgl,nc
+         m = min(nc,nsgl-ig+1)
+         if (nid.eq.0) call byte_hread(ih,ws(kb),m*nrec*wdsize/4,ierr)
+         call bcast(ws(kb),m*nrec*wdsize)
+         call stat_unpack(ws(kb),ig,m,nrec)
+      enddo
+      call nek_ws_pop
+      if (nid.eq.0) then
+         call byte_hclose(ih,jerr)
+         ierr = max(ierr,jerr)
+      endif
+      call err_chk(ierr,'stat_load: cannot read statistics file$')
+
+      sts_atime = atime
+      if (nio.eq.0) write(6,1) fn(1:ltrunc(fn,132)),atime,istf
+    1 format(' stat: continuing ',a,', averaging time ',1pe13.5
+     $      ,' (step',i9,')')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine stat_unpack(buf,ig,m,nrec)
+
+      include 'SIZE'
+      include 'STATS'
+
+      real buf(nrec,m)
+
+      do j=1,nsslot
+         l = sts_gid(j)-ig+1
+         if (l.ge.1 .and. l.le.m) then
+            do k=1,nstat
+               sts_avg(j,k) = buf(ldim+k,l)
+            enddo
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
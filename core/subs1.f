@@ -305,7 +305,7 @@ C      endif
       COURNO = DT*UMAX
 
 ! synchronize time step for multiple sessions
-      if (ifneknek) dt = ms_glmin(dt,1)
+      if (ifneknek) call neknek_setdt(dt)
 c
       if (iffxdt.and.abs(courno).gt.10.*abs(ctarg)) then
          if (nid.eq.0) write(6,*) 'CFL, Ctarg!',courno,ctarg
@@ -2054,7 +2054,7 @@ c     Given an input vector v, this generates the H1 coarse-grid solution
       endif
 
       etime1=dnekclock()
-      call fgslib_crs_solve(xxth_strs,uc1,vc1)
+      call nek_crs_solve(xxth_strs,uc1,vc1)
       tcrsl=tcrsl+dnekclock()-etime1
 
       k=0
@@ -2080,6 +2080,30 @@ c     Given an input vector v, this generates the H1 coarse-grid solution
       end
 c-----------------------------------------------------------------------
       subroutine set_up_h1_crs_strs(h1,h2,ifld,matmod)
+c
+c     The ia,ja index lists for the coarse solver setup live in a
+c     workspace frame sized by the local element count.
+c
+      include 'SIZE'
+      include 'TSTEP'
+      include 'WSPACE'
+
+      real h1(1),h2(1)
+      integer*8 kia,kja
+
+      mcr = ldim*(2**ldim)
+      nnz = mcr*mcr*nelfld(ifld)
+
+      call nek_ws_push
+      kia = nek_ws_i(nnz)
+      kja = nek_ws_i(nnz)
+      call set_up_h1_crs_strs_a(h1,h2,ifld,matmod,iws(kia),iws(kja))
+      call nek_ws_pop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine set_up_h1_crs_strs_a(h1,h2,ifld,matmod,ia,ja)
 
       include 'SIZE'
       include 'GEOM'
@@ -2095,8 +2119,7 @@ c-----------------------------------------------------------------------
       integer null_space,e
 
       character*3 cb
-      common /scrxxti/ ia(ldim*ldim*lcr*lcr*lelv)
-     $               , ja(ldim*ldim*lcr*lcr*lelv)
+      integer ia(1),ja(1)
 
       parameter (lcc=2**ldim)
       common /scrcr1/ a(ldim*ldim*lcc*lcc*lelt)
@@ -2150,8 +2173,8 @@ c     stop
       if (imode.eq.0 .and. nelgt.gt.350000) call exitti(
      $ 'Problem size requires AMG solver$',1)
 
-      call fgslib_crs_setup(xxth_strs,imode,nekcomm,mp,n,se_to_gcrs,
-     $                      nnz,ia,ja,a,null_space)
+      call nek_crs_setup(xxth_strs,imode,nekcomm,mp,n,se_to_gcrs,
+     $                   nnz,ia,ja,a,null_space)
 
       t0 = dnekclock()-t0
       if (nio.eq.0) then
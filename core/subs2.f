@@ -331,6 +331,14 @@ C
       END
       SUBROUTINE CMULT2 (A,B,CONST,N)
       DIMENSION A(1),B(1)
+      include 'OFFLOAD'
+#ifdef OPENACC
+      logical ifdev,nek_acc_dev
+#endif
+#ifdef OPENACC
+      ifdev = nek_acc_dev(a)
+#endif
+c$acc parallel loop default(present) if(ifdev)
       DO 100 I=1,N
          A(I)=B(I)*CONST
  100  CONTINUE
@@ -0,0 +1,458 @@
+/*
+ * Element-batched tensor-product kernels (double precision)
+ *
+ * tnsr3_batch  v_e = [C (x) B (x) A] u_e            same A,Bt,Ct for all e
+ * fdm3_batch   fast diagonalization solve of hsmg_do_fast (3D)
+ * ax3_batch    3D stiffness part of axhelm (fast and general elements)
+ * ax3c_batch   ax3_batch with compressed geometry: per element either
+ *              the stored g1m1..g6m1, six scalars c with g = c*w3m1
+ *              (affine elements) or g recomputed from xm1,ym1,zm1
+ * ax3m_batch   ax3_batch for nv vectors u(ld,nv) sharing the geometry,
+ *              applied element by element so g1m1..g6m1 are read once
+ *              for all vectors; h1(ldh,nv), ldh = 0 for a shared h1
+ *
+ * Each call walks a contiguous block of elements and applies all
+ * three directions of one element back to back, so intermediates stay
+ * in small stack buffers (L1) instead of going through mxm per
+ * direction.  For n = 2..TB_NMAX the element kernel is compiled with a
+ * constant n so the 1D loops are fully unrolled/vectorized; other
+ * sizes use the same code with runtime bounds.  ifok = 0 means the
+ * shape was not handled and the caller has to use its mxm path.
+ *
+ * With OpenMP (PPLIST OPENMP) the element loops are shared among the
+ * threads, each thread holding its own scratch buffers; single-element
+ * calls (tensr3) stay on the calling thread.
+ *
+ */
+#include <string.h>
+
+#ifdef UPCASE
+#  define FORTRAN_NAME(low,up) up
+#else
+#ifdef UNDERSCORE
+#  define FORTRAN_NAME(low,up) low##_
+#else
+#  define FORTRAN_NAME(low,up) low
+#endif
+#endif
+
+#define tnsr3_batch FORTRAN_NAME(tnsr3_batch,TNSR3_BATCH)
+#define fdm3_batch  FORTRAN_NAME(fdm3_batch,FDM3_BATCH)
+#define ax3_batch   FORTRAN_NAME(ax3_batch,AX3_BATCH)
+#define ax3c_batch  FORTRAN_NAME(ax3c_batch,AX3C_BATCH)
+#define ax3m_batch  FORTRAN_NAME(ax3m_batch,AX3M_BATCH)
+
+#define TB_NMAX 16
+#define INL static inline __attribute__((always_inline))
+
+#if defined(OPENMP) && defined(_OPENMP)
+#  define TB_PARALLEL _Pragma("omp parallel if(nel > 1)")
+#  define TB_FOR      _Pragma("omp for schedule(static)")
+#else
+#  define TB_PARALLEL
+#  define TB_FOR
+#endif
+
+/* v(nv,nv,nv) = [C (x) B (x) A] u(nu,nu,nu); A(nv,nu), Bt(nu,nv), Ct(nu,nv) */
+INL void tb_tnsr3(double *v, const int nv, const double *u, const int nu,
+                  const double *A, const double *Bt, const double *Ct,
+                  double *w1, double *w2)
+{
+  const int nvv = nv*nv;
+  int i,j,k,l;
+
+  memset(w1,0,sizeof(double)*nv*nu*nu);
+  for (j=0; j<nu*nu; j++)
+    for (l=0; l<nu; l++) {
+      const double ul = u[l+j*nu];
+      for (i=0; i<nv; i++) w1[i+j*nv] += A[i+l*nv]*ul;
+    }
+
+  memset(w2,0,sizeof(double)*nvv*nu);
+  for (k=0; k<nu; k++)
+    for (j=0; j<nv; j++)
+      for (l=0; l<nu; l++) {
+        const double b = Bt[l+j*nu];
+        for (i=0; i<nv; i++) w2[i+j*nv+k*nvv] += w1[i+l*nv+k*nv*nu]*b;
+      }
+
+  memset(v,0,sizeof(double)*nvv*nv);
+  for (k=0; k<nv; k++)
+    for (l=0; l<nu; l++) {
+      const double c = Ct[l+k*nu];
+      for (i=0; i<nvv; i++) v[i+k*nvv] += w2[i+l*nvv]*c;
+    }
+}
+
+/* the three 1D derivatives of u(n,n,n): ur = D u, us = u D^T, ut = u D^T */
+INL void tb_grad3(double *ur, double *us, double *ut, const double *u,
+                  const int n, const double *D)
+{
+  const int nn = n*n, nnn = n*n*n;
+  int i,j,k,l;
+
+  memset(ur,0,sizeof(double)*nnn);
+  memset(us,0,sizeof(double)*nnn);
+  memset(ut,0,sizeof(double)*nnn);
+  for (j=0; j<nn; j++)
+    for (l=0; l<n; l++) {
+      const double ul = u[l+j*n];
+      for (i=0; i<n; i++) ur[i+j*n] += D[i+l*n]*ul;
+    }
+  for (k=0; k<n; k++)
+    for (j=0; j<n; j++)
+      for (l=0; l<n; l++) {
+        const double d = D[j+l*n];
+        for (i=0; i<n; i++) us[i+j*n+k*nn] += u[i+l*n+k*nn]*d;
+      }
+  for (k=0; k<n; k++)
+    for (l=0; l<n; l++) {
+      const double d = D[k+l*n];
+      for (i=0; i<nn; i++) ut[i+k*nn] += u[i+l*nn]*d;
+    }
+}
+
+/* au = D^T wr + wr D + wt D, the transpose of tb_grad3 */
+INL void tb_grad3t(double *au, const double *wr, const double *ws,
+                   const double *wt, const int n, const double *D)
+{
+  const int nn = n*n, nnn = n*n*n;
+  int i,j,k,l;
+
+  memset(au,0,sizeof(double)*nnn);
+  for (j=0; j<nn; j++)
+    for (l=0; l<n; l++) {
+      const double w = wr[l+j*n];
+      for (i=0; i<n; i++) au[i+j*n] += D[l+i*n]*w;
+    }
+  for (k=0; k<n; k++)
+    for (j=0; j<n; j++)
+      for (l=0; l<n; l++) {
+        const double d = D[l+j*n];
+        for (i=0; i<n; i++) au[i+j*n+k*nn] += ws[i+l*n+k*nn]*d;
+      }
+  for (k=0; k<n; k++)
+    for (l=0; l<n; l++) {
+      const double d = D[l+k*n];
+      for (i=0; i<nn; i++) au[i+k*nn] += wt[i+l*nn]*d;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+
+INL void tnsr3_el(double *v, const int nv, const double *u, const int nu,
+                  const double *A, const double *Bt, const double *Ct,
+                  int nel)
+{
+  TB_PARALLEL
+  {
+    double w1[nv*nu*nu], w2[nv*nv*nu];
+    int e;
+    TB_FOR
+    for (e=0; e<nel; e++)
+      tb_tnsr3(v+e*nv*nv*nv,nv,u+e*nu*nu*nu,nu,A,Bt,Ct,w1,w2);
+  }
+}
+
+static void tnsr3_any(double *v, int nv, const double *u, int nu,
+                      const double *A, const double *Bt, const double *Ct,
+                      int nel)
+{
+  tnsr3_el(v,nv,u,nu,A,Bt,Ct,nel);
+}
+
+#define TB_CASES(X) \
+  X(2)  X(3)  X(4)  X(5)  X(6)  X(7)  X(8)  X(9)  \
+  X(10) X(11) X(12) X(13) X(14) X(15) X(16)
+
+void tnsr3_batch(double *v, const int *nv, const double *u, const int *nu,
+                 const double *A, const double *Bt, const double *Ct,
+                 const int *nel, int *ifok)
+{
+  *ifok = 0;
+  if (*nv > TB_NMAX || *nu > TB_NMAX) return;
+  if (*nv == *nu) {
+    switch (*nu) {
+#define X(N) case N: tnsr3_el(v,N,u,N,A,Bt,Ct,*nel); *ifok = 1; return;
+      TB_CASES(X)
+#undef X
+    }
+  }
+  tnsr3_any(v,*nv,u,*nu,A,Bt,Ct,*nel);
+  *ifok = 1;
+}
+
+/* ------------------------------------------------------------------ */
+
+/* e = S r, r = d.*e, e = S^T r  with per-element s(n*n,2,3,nel) */
+INL void fdm3_el(double *e, double *r, const double *s, const double *d,
+                 const int n, int nel)
+{
+  const int nn = n*n, nnn = n*n*n;
+
+  TB_PARALLEL
+  {
+  double w1[nnn], w2[nnn];
+  int ie,i;
+
+  TB_FOR
+  for (ie=0; ie<nel; ie++) {
+    const double *se = s + 6*nn*ie;
+    double *ee = e + nnn*ie, *re = r + nnn*ie;
+    const double *de = d + nnn*ie;
+    tb_tnsr3(ee,n,re,n,se+nn,se+2*nn,se+4*nn,w1,w2);
+    for (i=0; i<nnn; i++) re[i] = de[i]*ee[i];
+    tb_tnsr3(ee,n,re,n,se,se+3*nn,se+5*nn,w1,w2);
+  }
+  }
+}
+
+static void fdm3_any(double *e, double *r, const double *s,
+                     const double *d, int n, int nel)
+{
+  fdm3_el(e,r,s,d,n,nel);
+}
+
+void fdm3_batch(double *e, double *r, const double *s, const double *d,
+                const int *nl, const int *nel, int *ifok)
+{
+  *ifok = 0;
+  if (*nl > TB_NMAX) return;
+  switch (*nl) {
+#define X(N) case N: fdm3_el(e,r,s,d,N,*nel); *ifok = 1; return;
+    TB_CASES(X)
+#undef X
+  }
+  fdm3_any(e,r,s,d,*nl,*nel);
+  *ifok = 1;
+}
+
+/* ------------------------------------------------------------------ */
+
+/* metric of element e: g = (cof_a . cof_b) w3/jac from the GLL points */
+INL void tb_geom3(double *g, const double *x, const double *y,
+                  const double *z, const double *w3, const int n,
+                  const double *D, double *w)
+{
+  const int nnn = n*n*n;
+  double *xr = w, *xs = w+nnn, *xt = w+2*nnn, *yr = w+3*nnn,
+         *ys = w+4*nnn, *yt = w+5*nnn, *zr = w+6*nnn, *zs = w+7*nnn,
+         *zt = w+8*nnn;
+  int i;
+
+  tb_grad3(xr,xs,xt,x,n,D);
+  tb_grad3(yr,ys,yt,y,n,D);
+  tb_grad3(zr,zs,zt,z,n,D);
+  for (i=0; i<nnn; i++) {
+    const double rx = ys[i]*zt[i] - yt[i]*zs[i],
+                 ry = xt[i]*zs[i] - xs[i]*zt[i],
+                 rz = xs[i]*yt[i] - xt[i]*ys[i],
+                 sx = yt[i]*zr[i] - yr[i]*zt[i],
+                 sy = xr[i]*zt[i] - xt[i]*zr[i],
+                 sz = xt[i]*yr[i] - xr[i]*yt[i],
+                 tx = yr[i]*zs[i] - ys[i]*zr[i],
+                 ty = xs[i]*zr[i] - xr[i]*zs[i],
+                 tz = xr[i]*ys[i] - xs[i]*yr[i];
+    const double wj = w3[i]/(xr[i]*rx + yr[i]*ry + zr[i]*rz);
+    g[i      ] = (rx*rx + ry*ry + rz*rz)*wj;
+    g[i+  nnn] = (sx*sx + sy*sy + sz*sz)*wj;
+    g[i+2*nnn] = (tx*tx + ty*ty + tz*tz)*wj;
+    g[i+3*nnn] = (rx*sx + ry*sy + rz*sz)*wj;
+    g[i+4*nnn] = (rx*tx + ry*ty + rz*tz)*wj;
+    g[i+5*nnn] = (sx*tx + sy*ty + sz*tz)*wj;
+  }
+}
+
+/* au = helm1*A u per element; iffast elements use wddx/wddyt/wddzt.
+ * With igc, elements with igc = 1 take g = gc*w3 (w the 1D weights for
+ * the fast factors g4..g6 = g1..g3/w) and igc = 2 recompute g from
+ * x,y,z; igc = NULL or 0 reads g1..g6.  u and au hold nv vectors ld
+ * apart (h1 hd apart), all of them are applied to an element before
+ * the next. */
+INL void ax3_el(double *au, const double *u, const double *h1,
+                const double *g1, const double *g2, const double *g3,
+                const double *g4, const double *g5, const double *g6,
+                const double *D, const double *wddx, const double *wddyt,
+                const double *wddzt, const int *ifdfrm, const int *iffast,
+                const double *gc, const int *igc, const double *w3,
+                const double *w, const double *x, const double *y,
+                const double *z, const int n, int nel, int nv,
+                long ld, long hd)
+{
+  const int nn = n*n, nnn = n*n*n;
+
+  TB_PARALLEL
+  {
+  double ur[nnn], us[nnn], ut[nnn], gw[9*nnn];
+  int e,i,j,k,l,v;
+
+  TB_FOR
+  for (e=0; e<nel; e++)
+  for (v=0; v<nv; v++) {
+    const int o = e*nnn;
+    const double *ue = u + v*ld + o;
+    const double *he = h1 + v*hd;
+    double *ae = au + v*ld + o;
+    const int ic = igc ? igc[e] : 0;
+    const double *c = gc ? gc + 6*e : 0;
+
+    if (ic == 2) {
+      double g[6*nnn];
+      tb_geom3(g,x+o,y+o,z+o,w3,n,D,gw);
+      tb_grad3(ur,us,ut,ue,n,D);
+      for (i=0; i<nnn; i++) {
+        const double r = ur[i], s = us[i], t = ut[i], h = he[o+i];
+        ur[i] = h*(g[i]*r + g[i+3*nnn]*s + g[i+4*nnn]*t);
+        us[i] = h*(g[i+nnn]*s + g[i+3*nnn]*r + g[i+5*nnn]*t);
+        ut[i] = h*(g[i+2*nnn]*t + g[i+4*nnn]*r + g[i+5*nnn]*s);
+      }
+      tb_grad3t(ae,ur,us,ut,n,D);
+      continue;
+    }
+
+    if (iffast[e]) {
+      const double h = he[o];
+      memset(ur,0,sizeof(double)*nnn);
+      memset(us,0,sizeof(double)*nnn);
+      memset(ut,0,sizeof(double)*nnn);
+      for (j=0; j<nn; j++)
+        for (l=0; l<n; l++) {
+          const double ul = ue[l+j*n];
+          for (i=0; i<n; i++) ur[i+j*n] += wddx[i+l*n]*ul;
+        }
+      for (k=0; k<n; k++)
+        for (j=0; j<n; j++)
+          for (l=0; l<n; l++) {
+            const double w = wddyt[l+j*n];
+            for (i=0; i<n; i++) us[i+j*n+k*nn] += ue[i+l*n+k*nn]*w;
+          }
+      for (k=0; k<n; k++)
+        for (l=0; l<n; l++) {
+          const double w = wddzt[l+k*n];
+          for (i=0; i<nn; i++) ut[i+k*nn] += ue[i+l*nn]*w;
+        }
+      if (ic == 1) {
+        for (k=0; k<n; k++)
+          for (j=0; j<n; j++)
+            for (i=0; i<n; i++) {
+              const int m = i+j*n+k*nn;
+              ae[m] = h*w3[m]*(c[0]*ur[m]/w[i] + c[1]*us[m]/w[j]
+                               + c[2]*ut[m]/w[k]);
+            }
+        continue;
+      }
+      for (i=0; i<nnn; i++)
+        ae[i] = h*(g4[o+i]*ur[i] + g5[o+i]*us[i] + g6[o+i]*ut[i]);
+      continue;
+    }
+
+    tb_grad3(ur,us,ut,ue,n,D);
+    if (ic == 1) {
+      const double c4 = ifdfrm[e] ? c[3] : 0, c5 = ifdfrm[e] ? c[4] : 0,
+                   c6 = ifdfrm[e] ? c[5] : 0;
+      for (i=0; i<nnn; i++) {
+        const double r = ur[i], s = us[i], t = ut[i], h = he[o+i]*w3[i];
+        ur[i] = h*(c[0]*r + c4*s + c5*t);
+        us[i] = h*(c[1]*s + c4*r + c6*t);
+        ut[i] = h*(c[2]*t + c5*r + c6*s);
+      }
+    } else if (ifdfrm[e]) {
+      for (i=0; i<nnn; i++) {
+        const double r = ur[i], s = us[i], t = ut[i], h = he[o+i];
+        ur[i] = h*(g1[o+i]*r + g4[o+i]*s + g5[o+i]*t);
+        us[i] = h*(g2[o+i]*s + g4[o+i]*r + g6[o+i]*t);
+        ut[i] = h*(g3[o+i]*t + g5[o+i]*r + g6[o+i]*s);
+      }
+    } else {
+      for (i=0; i<nnn; i++) {
+        const double h = he[o+i];
+        ur[i] *= h*g1[o+i];
+        us[i] *= h*g2[o+i];
+        ut[i] *= h*g3[o+i];
+      }
+    }
+    tb_grad3t(ae,ur,us,ut,n,D);
+  }
+  }
+}
+
+static void ax3_any(double *au, const double *u, const double *h1,
+                    const double *g1, const double *g2, const double *g3,
+                    const double *g4, const double *g5, const double *g6,
+                    const double *D, const double *wddx,
+                    const double *wddyt, const double *wddzt,
+                    const int *ifdfrm, const int *iffast,
+                    const double *gc, const int *igc, const double *w3,
+                    const double *w, const double *x, const double *y,
+                    const double *z, int n, int nel, int nv, long ld,
+                    long hd)
+{
+  ax3_el(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt,ifdfrm,iffast,
+         gc,igc,w3,w,x,y,z,n,nel,nv,ld,hd);
+}
+
+void ax3_batch(double *au, const double *u, const double *h1,
+               const double *g1, const double *g2, const double *g3,
+               const double *g4, const double *g5, const double *g6,
+               const double *D, const double *wddx, const double *wddyt,
+               const double *wddzt, const int *ifdfrm, const int *iffast,
+               const int *n, const int *nel, int *ifok)
+{
+  *ifok = 0;
+  if (*n > TB_NMAX) return;
+  switch (*n) {
+#define X(N) case N: ax3_el(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt, \
+                            ifdfrm,iffast,0,0,0,0,0,0,0,N,*nel,1,0,0); \
+                     *ifok = 1; return;
+    TB_CASES(X)
+#undef X
+  }
+  ax3_any(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt,ifdfrm,iffast,
+          0,0,0,0,0,0,0,*n,*nel,1,0,0);
+  *ifok = 1;
+}
+
+void ax3c_batch(double *au, const double *u, const double *h1,
+                const double *g1, const double *g2, const double *g3,
+                const double *g4, const double *g5, const double *g6,
+                const double *D, const double *wddx, const double *wddyt,
+                const double *wddzt, const int *ifdfrm, const int *iffast,
+                const double *gc, const int *igc, const double *w3,
+                const double *w, const double *x, const double *y,
+                const double *z, const int *n, const int *nel, int *ifok)
+{
+  *ifok = 0;
+  if (*n > TB_NMAX) return;
+  switch (*n) {
+#define X(N) case N: ax3_el(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt, \
+                            ifdfrm,iffast,gc,igc,w3,w,x,y,z,N,*nel,1,0,0); \
+                     *ifok = 1; return;
+    TB_CASES(X)
+#undef X
+  }
+  ax3_any(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt,ifdfrm,iffast,
+          gc,igc,w3,w,x,y,z,*n,*nel,1,0,0);
+  *ifok = 1;
+}
+
+void ax3m_batch(double *au, const double *u, const int *nv, const int *ld,
+                const double *h1, const int *ldh,
+                const double *g1, const double *g2, const double *g3,
+                const double *g4, const double *g5, const double *g6,
+                const double *D, const double *wddx, const double *wddyt,
+                const double *wddzt, const int *ifdfrm, const int *iffast,
+                const int *n, const int *nel, int *ifok)
+{
+  *ifok = 0;
+  if (*n > TB_NMAX) return;
+  switch (*n) {
+#define X(N) case N: ax3_el(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt, \
+                            ifdfrm,iffast,0,0,0,0,0,0,0,N,*nel,*nv,*ld,*ldh); \
+                     *ifok = 1; return;
+    TB_CASES(X)
+#undef X
+  }
+  ax3_any(au,u,h1,g1,g2,g3,g4,g5,g6,D,wddx,wddyt,wddzt,ifdfrm,iffast,
+          0,0,0,0,0,0,0,*n,*nel,*nv,*ld,*ldh);
+  *ifok = 1;
+}
@@ -0,0 +1,167 @@
+#!/usr/bin/env python
+""" Nek5000 performance regression tests
+
+Runs the perf case (perf/perf.usr) over a matrix of polynomial orders
+and rank counts with a fixed number of elements per rank, collects the
+kernel timings, runstat phases, region timers and (MPITIMER builds)
+mpiprof tables into a JSON record and, if a baseline record is given,
+fails on statistically significant slowdowns (see lib/nekPerf.py).
+
+Environment, in addition to the NekTests.py variables:
+
+    PERF_LX1        polynomial orders + 1          (default: "6 8 10")
+    PERF_PROCS      rank counts                    (default: "1 PARALLEL_PROCS")
+    PERF_ELEMENTS   elements per rank, 3D box      (default: 64)
+    PERF_TRIALS     repeated runs per point        (default: 3)
+    PERF_BASELINE   baseline record to check against
+    PERF_RECORD     where to write this record     (default: perf.json in
+                                                    LOG_ROOT or the case dir)
+    PERF_TOL        relative slowdown tolerance    (default: 0.10)
+
+Run with:
+    $ python -m 'unittest' NekPerf >log
+"""
+from lib.nekTestCase import *
+from lib import nekPerf
+
+###############################################################################
+
+class PerfBox(NekTestCase):
+    example_subdir = 'perf'
+    case_name      = 'perf'
+
+    box_template = """perf.rea
+-3                     spatial dimension  ( < 0 --> generate .rea/.re2 pair)
+1                      number of fields
+#
+#    periodic box for the performance tests, written by NekPerf.py
+#
+Box
+{0}  {1}  {2}                                       nelx,nely,nelz for Box
+-1 1 1.                                             x0,x1,gain  (rescaled in usrdat2)
+-1 1 1.                                             y0,y1,gain
+-1 1 1.                                             z0,z1,gain
+P  ,P  ,P  ,P  ,P  ,P                               bc's  (3 chars each!)
+"""
+
+    def setUp(self):
+        self.size_params = dict(
+            ldim      = '3',
+            lx1       = '8',
+            lxd       = '12',
+            lx2       = 'lx1-2',
+            lelg      = '1000',
+        )
+        env = os.environ
+        self.perf_lx1    = [int(n) for n in env.get('PERF_LX1', '6 8 10').split()]
+        self.perf_procs  = [int(n) for n in env.get('PERF_PROCS',
+                            '1 {0}'.format(self.parallel_procs)).split()]
+        self.perf_nel    = int(env.get('PERF_ELEMENTS', '64'))
+        self.perf_trials = int(env.get('PERF_TRIALS', '3'))
+        self.perf_tol    = float(env.get('PERF_TOL', '0.10'))
+
+        self.build_tools(['genbox', 'genmap'])
+
+        if not self.ifmpi:
+            self.perf_procs = [1]
+
+    def box_dims(self, nel):
+        """ nelx >= nely >= nelz, nelx*nely*nelz ~ nel """
+        n = [1, 1, 1]
+        i = 0
+        while n[0]*n[1]*n[2]*2 <= nel:
+            n[i % 3] *= 2
+            i += 1
+        return n
+
+    def make_mesh(self, procs):
+        cls = self.__class__
+        workdir = os.path.join(self.examples_root, cls.example_subdir)
+        nx, ny, nz = self.box_dims(self.perf_nel*procs)
+        with open(os.path.join(workdir, 'perf.box'), 'w') as f:
+            f.write(self.box_template.format(-nx, -ny, -nz))
+        self.run_genbox()
+        self.mvn('box', cls.case_name)
+        self.run_genmap()
+        return nx*ny*nz
+
+    def logfile(self):
+        cls = self.__class__
+        return os.path.join(self.examples_root, cls.example_subdir,
+                            '{0}.log.{1}{2}'.format(cls.case_name, self.mpi_procs, self.log_suffix))
+
+    def perf_run(self, kernels):
+        cls = self.__class__
+        workdir = os.path.join(self.examples_root, cls.example_subdir)
+        if kernels:
+            opts = {'GENERAL': {'numSteps': '0', 'userParam01': '1'}}
+        else:
+            opts = {'GENERAL': {'numSteps': '20', 'userParam01': '0'}}
+        self.config_parfile(opts)
+        nekPerf.clear_mpiprof(workdir)
+        self.run_nek(step_limit=None)
+        if kernels:   # the runstat of this run times the kernels
+            return nekPerf.parse_kernels(self.logfile())
+        return nekPerf.parse_run(self.logfile(), workdir)
+
+    def record_path(self):
+        cls = self.__class__
+        path = os.environ.get('PERF_RECORD')
+        if not path:
+            root = self.log_root if self.log_root else os.path.join(self.examples_root, cls.example_subdir)
+            path = os.path.join(root, 'perf.json')
+        return path
+
+    def test_PnPn2_Perf(self):
+        cls = self.__class__
+        self.log_suffix = '.pn_pn_2.perf'
+
+        record = nekPerf.new_record(dict(
+            FC = self.f77, CC = self.cc, PPLIST = self.pplist,
+            PERF_ELEMENTS = self.perf_nel, PERF_TRIALS = self.perf_trials,
+        ))
+
+        for procs in self.perf_procs:
+            nel = self.make_mesh(procs)
+            self.size_params['lelg'] = str(max(nel, 1000))
+            for lx1 in self.perf_lx1:
+                self.size_params['lx1'] = str(lx1)
+                self.size_params['lxd'] = str((3*lx1)//2)
+                self.size_params['lx2'] = 'lx1-2'
+                self.config_size()
+                self.build_nek(opts=dict(PPLIST=(self.pplist + ' MPITIMER').strip()))
+
+                self.mpi_procs = procs
+                key = '{0}/lx1={1}/np={2}'.format(cls.case_name, lx1, procs)
+                for trial in range(self.perf_trials):
+                    for kernels in (True, False):
+                        metrics = self.perf_run(kernels)
+                        if not metrics:
+                            self._delayed_failures.append(
+                                '    FAILURE: {0}: no timings in "{1}"'.format(key, self.logfile()))
+                        nekPerf.add_samples(record, key, metrics)
+                self.move_logs()
+
+        path = self.record_path()
+        nekPerf.save(record, path)
+        print('    Wrote performance record "{0}"'.format(path))
+
+        baseline = os.environ.get('PERF_BASELINE')
+        if baseline:
+            regr, impr, report = nekPerf.compare(nekPerf.load(baseline), record,
+                                                 rel_tol=self.perf_tol)
+            print('\n'.join(report))
+            for key, name, ratio in regr:
+                msg = '    FAILURE: {0}: {1} is {2:.1f}% slower than baseline'.format(
+                    key, name, 100*(ratio-1))
+                self._delayed_failures.append(msg)
+                print(msg)
+            print('    {0} regressions, {1} improvements vs "{2}"'.format(
+                len(regr), len(impr), baseline))
+
+        self.assertDelayedFailures()
+
+    def tearDown(self):
+        self.move_logs()
+
+###############################################################################
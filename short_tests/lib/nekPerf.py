@@ -0,0 +1,255 @@
+""" Performance records for the Nek5000 perf tests (NekPerf.py)
+
+A record is a JSON document
+
+    {
+      "version": 1,
+      "date":    "2024-05-01T12:00:00",
+      "host":    "node042",
+      "config":  {"FC": ..., "PPLIST": ..., ...},
+      "results": {
+        "<case>/lx1=<n>/np=<p>": {
+          "<metric>": [sample, sample, ...],
+          ...
+        },
+        ...
+      }
+    }
+
+where every metric is a time in seconds (lower is better):
+
+    kernel:<name>         sec/call from the "perf" lines of perf.usr
+    phase:<name>          runstat "<name> time" totals (TIMER builds)
+    region:<a>/<b>/...    nek_timer region tree, avg over ranks
+    comm:<region>/<call>  mpiprof.* (MPITIMER builds), max over ranks
+    total:solver          'total solver time w/o IO'
+    total:step            'time/timestep'
+
+Samples of the same metric from repeated runs are appended, so the
+regression check can compare distributions rather than single numbers.
+
+Regression check: a metric regressed if its median grew by more than
+rel_tol over the baseline median AND the shift exceeds nsigma robust
+standard deviations (1.4826*MAD, pooled over both sample sets).  The
+second condition keeps noisy metrics from firing on a lucky baseline,
+the first keeps very stable metrics from firing on insignificant shifts.
+Metrics below min_time in the baseline are only reported.
+
+Command line:
+
+    python lib/nekPerf.py compare baseline.json current.json [rel_tol]
+    python lib/nekPerf.py show current.json
+"""
+from __future__ import print_function
+import os
+import re
+import json
+import math
+import glob
+import socket
+import datetime
+
+###############################################################################
+#  LOG PARSING
+###############################################################################
+
+_num = r'[-+]?(?:\d+\.?\d*|\.\d+)(?:[eEdD][-+]?\d+)?'
+
+def _float(s):
+    return float(s.replace('D', 'E').replace('d', 'e'))
+
+def parse_kernels(logfile):
+    """ 'perf <kernel> <lx1> <np> <calls> <sec/call>' lines. """
+    out = {}
+    pat = re.compile(r'^\s*perf\s+(\S+)\s+\d+\s+\d+\s+\d+\s+(' + _num + r')\s*$')
+    with open(logfile, 'r') as f:
+        for l in f:
+            m = pat.match(l)
+            if m:
+                out.setdefault('kernel:' + m.group(1), []).append(_float(m.group(2)))
+    return out
+
+def parse_runstat(logfile):
+    """ '<name> time [calls] total fraction' lines after 'runtime statistics:'. """
+    out = {}
+    pat = re.compile(r'^\s*(\w+)\s+time\s+((?:' + _num + r'\s*)+)$')
+    seen = False
+    with open(logfile, 'r') as f:
+        for l in f:
+            if not seen:
+                seen = l.startswith('runtime statistics:')
+                continue
+            m = pat.match(l)
+            if not m:
+                continue
+            vals = [_float(v) for v in m.group(2).split()]
+            # (total, fraction) or (calls, total, fraction)
+            t = vals[-2] if len(vals) >= 2 else vals[0]
+            out['phase:' + m.group(1)] = [t]
+    return out
+
+def parse_totals(logfile):
+    out = {}
+    keys = (('total solver time w/o IO', 'total:solver'),
+            ('time/timestep', 'total:step'))
+    with open(logfile, 'r') as f:
+        for l in f:
+            for label, key in keys:
+                if l.startswith(label):
+                    m = re.search(':\s*(' + _num + ')', l)
+                    if m:
+                        out[key] = [_float(m.group(1))]
+    return out
+
+def parse_regions(logfile):
+    """ The nek_timer_report tree; the leaf indent (2 per level) gives the path. """
+    out = {}
+    pat = re.compile(r'^  ( *)(\S+)\s+\d+\s+(' + _num + r')\s+(' + _num + r')\s+(' +
+                     _num + r')\s+' + _num + r'\s*$')
+    with open(logfile, 'r') as f:
+        lines = f.readlines()
+    start = None
+    for i, l in enumerate(lines):
+        if l.startswith('region timers [s]'):
+            start = i + 2      # skip the column header; keep the last report
+    if start is None:
+        return out
+    path = []
+    for l in lines[start:]:
+        m = pat.match(l)
+        if not m:
+            break
+        depth = len(m.group(1)) // 2
+        path = path[:depth] + [m.group(2)]
+        out['region:' + '/'.join(path)] = [_float(m.group(4))]
+    return out
+
+def parse_mpiprof(cwd):
+    """ mpiprof.<rank> tables: time of each (region, call), max over ranks. """
+    out = {}
+    pat = re.compile(r'^\s(\S+)\s+(\S+)\s+\d+\s+' + _num + r'\s+(' + _num + r')\s*$')
+    for fn in glob.glob(os.path.join(cwd, 'mpiprof.*')):
+        with open(fn, 'r') as f:
+            for l in f:
+                if l.startswith('#'):
+                    if 'histogram' in l:
+                        break
+                    continue
+                m = pat.match(l)
+                if m:
+                    key = 'comm:{0}/{1}'.format(m.group(1), m.group(2))
+                    t = _float(m.group(3))
+                    out[key] = [max(t, out.get(key, [t])[0])]
+    return out
+
+def parse_run(logfile, cwd=None):
+    """ All metrics of one run. """
+    out = {}
+    for parse in (parse_kernels, parse_runstat, parse_totals, parse_regions):
+        out.update(parse(logfile))
+    if cwd:
+        out.update(parse_mpiprof(cwd))
+    return out
+
+def clear_mpiprof(cwd):
+    for fn in glob.glob(os.path.join(cwd, 'mpiprof.*')):
+        os.remove(fn)
+
+###############################################################################
+#  RECORDS
+###############################################################################
+
+def new_record(config=None):
+    return dict(
+        version = 1,
+        date    = datetime.datetime.now().replace(microsecond=0).isoformat(),
+        host    = socket.gethostname(),
+        config  = dict(config) if config else {},
+        results = {},
+    )
+
+def add_samples(record, key, metrics):
+    res = record['results'].setdefault(key, {})
+    for name, vals in metrics.items():
+        res.setdefault(name, []).extend(vals)
+
+def load(path):
+    with open(path, 'r') as f:
+        return json.load(f)
+
+def save(record, path):
+    with open(path, 'w') as f:
+        json.dump(record, f, indent=1, sort_keys=True)
+        f.write('\n')
+
+###############################################################################
+#  REGRESSION CHECK
+###############################################################################
+
+def median(x):
+    s = sorted(x)
+    n = len(s)
+    if n == 0:
+        return float('nan')
+    return s[n//2] if n % 2 else 0.5*(s[n//2-1] + s[n//2])
+
+def mad_sigma(x):
+    m = median(x)
+    return 1.4826*median([abs(v-m) for v in x])
+
+def compare(baseline, current, rel_tol=0.10, nsigma=3.0, min_time=1e-6):
+    """ Compare two records, returns (regressions, improvements, report lines).
+
+    regressions and improvements are lists of (key, metric, ratio) with
+    ratio = current median / baseline median.
+    """
+    regr, impr, report = [], [], []
+    for key in sorted(current['results']):
+        if key not in baseline['results']:
+            report.append('  new       {0}'.format(key))
+            continue
+        base = baseline['results'][key]
+        for name in sorted(current['results'][key]):
+            cur = current['results'][key][name]
+            if name not in base or not cur or not base[name]:
+                continue
+            mb, mc = median(base[name]), median(cur)
+            if mb <= 0:
+                continue
+            ratio = mc/mb
+            sigma = math.sqrt(mad_sigma(base[name])**2 + mad_sigma(cur)**2)
+            shift = abs(mc-mb)
+            signif = shift > nsigma*sigma
+            status = 'ok'
+            if mb < min_time:
+                status = 'small'
+            elif ratio > 1+rel_tol and signif:
+                status = 'SLOWER'
+                regr.append((key, name, ratio))
+            elif ratio < 1-rel_tol and signif:
+                status = 'faster'
+                impr.append((key, name, ratio))
+            report.append('  {0:9} {1}  {2:36} {3:11.4e} -> {4:11.4e}  x{5:6.3f}'.format(
+                status, key, name, mb, mc, ratio))
+    return regr, impr, report
+
+def show(record):
+    for key in sorted(record['results']):
+        for name, vals in sorted(record['results'][key].items()):
+            print('{0}  {1:36} {2:11.4e}  (n={3}, sigma={4:9.2e})'.format(
+                key, name, median(vals), len(vals), mad_sigma(vals)))
+
+if __name__ == '__main__':
+    import sys
+    args = sys.argv[1:]
+    if len(args) >= 3 and args[0] == 'compare':
+        tol = float(args[3]) if len(args) > 3 else 0.10
+        regr, impr, report = compare(load(args[1]), load(args[2]), rel_tol=tol)
+        print('\n'.join(report))
+        print('{0} regressions, {1} improvements (tol {2})'.format(len(regr), len(impr), tol))
+        sys.exit(1 if regr else 0)
+    elif len(args) == 2 and args[0] == 'show':
+        show(load(args[1]))
+    else:
+        print(__doc__)
+        sys.exit(2)
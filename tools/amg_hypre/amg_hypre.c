@@ -1,225 +1,170 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdarg.h>
 #include <string.h>
 #include <math.h>
 #include <float.h>
+#include <unistd.h>
+#include <mpi.h>
 #include "_hypre_utilities.h"
 #include "_hypre_parcsr_ls.h"
 #include "HYPRE_parcsr_ls.h"
 #include "HYPRE.h"
 #include "amg_hypre.h"
+#include "lanczos.h"
 
-/* 
+/*
     Code for performing the AMG setup for Nek5000 using the linear algebra
     library Hypre.
 
     Author of this Hyper version: Nicolas Offermans
-    Based on the original implementation of the AMG setup in Matlab by 
+    Based on the original implementation of the AMG setup in Matlab by
     James Lottes. A thorough description of the original setup can be found in
-    his Ph. D. thesis "Towards Robust Algebraic Multigrid Methods for 
+    his Ph. D. thesis "Towards Robust Algebraic Multigrid Methods for
     Nonsymmetric Problems".
 
+    Usage: mpirun -np <p> amg_hypre [-c coarsening] [-i interpolation]
+                                    [-l levels] [-t tolerance]
+                                    [-p print level] [-f config file]
+
+    The dump files amgdmp_{i,j,p}.dat are read in chunks by all ranks, the
+    setup runs on the distributed ParCSR matrix and every rank writes its
+    rows of the amg*.dat files.
+
     - Last update: 30 June, 2017
 */
 
-int main(int argc, char *argv[])
-{   
-    /* Get user's input for the setup */
-    int coars_strat, interp_strat, ret;
-    setbuf(stdout, NULL);
+static int nid = 0, np = 1; // MPI rank and number of ranks
 
-    /* Coarsening strategy */
-    printf("Choose a coarsening method. Available options are:\n");
-    printf(" - 0: CLJP,\n");
-    printf(" - 3: Ruege-Stuben (default),\n");
-    printf(" - 6: Falgout,\n");
-    printf(" - 8: PMIS,\n");
-    printf(" - 10: HMIS,\n");
-    printf(" - 21: CGC,\n");
-    printf(" - 22: CGC-E.\n");
-    printf("Choice: ");
-    char scoars[30];
-    fgets(scoars, sizeof scoars, stdin);
-    ret = sscanf(scoars, "%d", &coars_strat);
-    if (ret == -1)
-    {
-        coars_strat = 3; // default
-    }
-    if (coars_strat == 0) printf("CLJP\n");
-    else if (coars_strat == 3) printf("Ruege-Stuben\n");
-    else if (coars_strat == 6) printf("Falgout\n");
-    else if (coars_strat == 8) printf("PMIS\n");
-    else if (coars_strat == 10) printf("HMIS\n");
-    else if (coars_strat == 21) printf("CGC\n");
-    else if (coars_strat == 22) printf("CGC-E\n");
-    else {printf("Not a valid choice.\n"); exit(0);}
-
-    /* Max number of levels */
-    int maxlvls; 
-    char smaxlvls[30];
-    printf("Maximum number of levels [30]:\n");
-    fgets(smaxlvls, sizeof smaxlvls, stdin);
-    ret = sscanf(smaxlvls, "%d", &maxlvls);
-    if (ret == -1)
-    {
-        maxlvls = 30; // default
-    }
+/* Rank 0 prints */
+static void rprintf(const char *fmt, ...)
+{
+    va_list ap;
+    if (nid != 0) return;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
 
-    /* Interpolation strategy */
-    printf("Choose an interpolation method. Available options are:\n");
-    printf(" - 0: classical modified interpolation (default),\n");
-    printf(" - 1: LS interpolation,\n");
-    printf(" - 2: classical modified interpolation for hyperbolic PDEs,\n");
-    printf(" - 3: direct interpolation,\n");
-    printf(" - 4: multipass interpolation,\n");
-    printf(" - 5: multipass interpolation (with separation of weights),\n");
-    printf(" - 6: extended + i interpolation,\n");
-    printf(" - 7: extended + i (if no common C neighbour) interpolation,\n");
-    printf(" - 8: standard interpolation,\n");
-    printf(" - 9: standard interpolation (with separation of weights),\n");
-    printf(" - 10: classical block interpolation,\n");
-    printf(" - 11: classical block interpolation with diagonalized diagonal blocks,\n");
-    printf(" - 12: FF interpolation,\n");
-    printf(" - 13: FF1 interpolation,\n");
-    printf(" - 14: extended interpolation,\n");
-    printf("Choice: ");
-    char sinterp[30];
-    fgets(sinterp, sizeof sinterp, stdin);
-    ret = sscanf(sinterp, "%d", &interp_strat);
-    if (ret == -1)
-    {
-        interp_strat = 0; // default
-    }
-    if (interp_strat == 0) printf("classical modified interpolation\n");
-    else if (interp_strat == 1) printf("LS interpolation\n");
-    else if (interp_strat == 2) printf("classical modified interpolation for hyperbolic PDEs\n");
-    else if (interp_strat == 3) printf("direct interpolation\n");
-    else if (interp_strat == 4) printf("multipass interpolation\n");
-    else if (interp_strat == 5) printf("multipass interpolation (with separation of weights)\n");
-    else if (interp_strat == 6) printf("extended + i interpolation\n");
-    else if (interp_strat == 7) printf("extended + i (if no common C neighbour) interpolation\n");
-    else if (interp_strat == 8) printf("standard interpolation\n");
-    else if (interp_strat == 9) printf("standard interpolation (with separation of weights)\n");
-    else if (interp_strat == 10) printf("classical block interpolation\n");
-    else if (interp_strat == 11) printf("classical block interpolation with diagonalized diagonal blocks\n");
-    else if (interp_strat == 12) printf("FF interpolation\n");
-    else if (interp_strat == 13) printf("FF1 interpolation\n");
-    else if (interp_strat == 14) printf("extended interpolation\n");
-    else {printf("Not a valid choice.\n"); exit(0);}
-
-    /* Smoother tolerance */
-    double tol;
-    char stol[30];
-    printf("Enter smoother tolerance [0.5]:\n");
-    fgets(stol, sizeof stol, stdin);
-    ret = sscanf(stol, "%lf", &tol);
-    if (ret == -1)
+static void die(const char *msg)
+{
+    if (nid == 0) fprintf(stderr, "ERROR: %s\n", msg);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+static const char *coars_name(const int c)
+{
+    switch (c)
     {
-        tol = 0.5; // default
+        case 0: return "CLJP";
+        case 3: return "Ruege-Stuben";
+        case 6: return "Falgout";
+        case 8: return "PMIS";
+        case 10: return "HMIS";
+        case 21: return "CGC";
+        case 22: return "CGC-E";
     }
+    return NULL;
+}
 
-    /* Verbose level */
-    int print_level = 3;  // Print solve info + parameters
-
-    /* Read data and convert rows and columns to integers */
-
-    printf("Reading AMG dump files... ");
-    int n = filesize("amgdmp_i.dat");
-    double *v   = malloc( n    * sizeof(double));
-    double *Aid = malloc((n-1) * sizeof(double));
-    double *Ajd = malloc((n-1) * sizeof(double));
-    double *Av  = malloc((n-1) * sizeof(double));
-    
-    readfile(v,n,"amgdmp_i.dat");
-    memcpy(Aid, v+1, (n-1) * sizeof (double));
-    readfile(v,n,"amgdmp_j.dat");
-    memcpy(Ajd, v+1, (n-1) * sizeof (double));
-    readfile(v,n,"amgdmp_p.dat");
-    memcpy(Av , v+1, (n-1) * sizeof (double));
-    printf("done\n");
+static const char *interp_name(const int i)
+{
+    static const char *name[] = {
+        "classical modified interpolation",
+        "LS interpolation",
+        "classical modified interpolation for hyperbolic PDEs",
+        "direct interpolation",
+        "multipass interpolation",
+        "multipass interpolation (with separation of weights)",
+        "extended + i interpolation",
+        "extended + i (if no common C neighbour) interpolation",
+        "standard interpolation",
+        "standard interpolation (with separation of weights)",
+        "classical block interpolation",
+        "classical block interpolation with diagonalized diagonal blocks",
+        "FF interpolation",
+        "FF1 interpolation",
+        "extended interpolation"};
+    if (i < 0 || i > 14) return NULL;
+    return name[i];
+}
 
-    int *Ai = malloc((n-1) * sizeof (int));
-    int *Aj = malloc((n-1) * sizeof (int));
+static void usage(void)
+{
+    int i;
+    rprintf("Usage: amg_hypre [options]\n");
+    rprintf("  -c <int>   coarsening method [3]:");
+    for (i=0;i<=22;i++) if (coars_name(i)) rprintf(" %d %s,", i, coars_name(i));
+    rprintf("\n  -i <int>   interpolation method [0]:\n");
+    for (i=0;i<=14;i++) rprintf("               %2d %s\n", i, interp_name(i));
+    rprintf("  -l <int>   maximum number of levels [30]\n");
+    rprintf("  -t <real>  smoother tolerance [0.5]\n");
+    rprintf("  -p <int>   Hypre print level [3]\n");
+    rprintf("  -f <file>  read options from file, one \"key value\" per line\n");
+    rprintf("             keys: coarsening, interpolation, levels, tolerance,\n");
+    rprintf("             print_level\n");
+    rprintf("  -h         this message\n");
+}
 
-    int iuppermax=0;
+int main(int argc, char *argv[])
+{
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &nid);
+    MPI_Comm_size(comm, &np);
+    setbuf(stdout, NULL);
+    srand(1+nid);
 
-	/* Get matrix dimensions */
-    int i;
-    for (i=0;i<n-1;i++) 
+    /* Get user's input for the setup */
+    struct amg_options opt;
+    if (get_options(&opt, argc, argv) != 0)
     {
-        Ai[i] = (int)Aid[i]-1;
-        Aj[i] = (int)Ajd[i]-1;
-        if (iuppermax < Ai[i]) iuppermax = Ai[i];
+        MPI_Finalize();
+        return 0;
     }
+    rprintf("Coarsening: %s\n", coars_name(opt.coarsening));
+    rprintf("Interpolation: %s\n", interp_name(opt.interpolation));
+    rprintf("Maximum number of levels: %d\n", opt.max_levels);
+    rprintf("Smoother tolerance: %lf\n", opt.tol);
+    rprintf("Number of ranks: %d\n", np);
+
+    int maxlvls = opt.max_levels;
+    double tol = opt.tol;
+    double t0 = MPI_Wtime();
+
+    /* Read data in chunks and convert rows and columns to integers */
+
+    rprintf("Reading AMG dump files... ");
+    long n = 0;
+    if (nid == 0) n = filesize("amgdmp_i.dat");
+    MPI_Bcast(&n, 1, MPI_LONG, 0, comm);
+    if (n < 1) die("cannot read amgdmp_i.dat");
+
+    long e0 = (n-1)*nid/np, e1 = (n-1)*(nid+1)/np;
+    int ne = (int)(e1-e0);
+    double *Aid = malloc((ne+1) * sizeof(double));
+    double *Ajd = malloc((ne+1) * sizeof(double));
+    double *Av  = malloc((ne+1) * sizeof(double));
+
+    if (readfile(Aid, e0+1, ne, "amgdmp_i.dat") != ne ||
+        readfile(Ajd, e0+1, ne, "amgdmp_j.dat") != ne ||
+        readfile(Av , e0+1, ne, "amgdmp_p.dat") != ne)
+        die("AMG dump files are inconsistent");
+    rprintf("done\n");
 
-    /* Look for zeros rows */
-    int *isrownonzero = malloc((iuppermax+1) * sizeof(int));
-    for (i=0;i<(iuppermax+1);i++) 
-    {
-        isrownonzero[i] = 0;
-    }
-    for (i=0;i<n-1;i++) 
-    {
-        if (Av[i] != 0.) isrownonzero[Ai[i]] = 1;
-    }
- 
     /* Data structure containing setup info */
-    struct amg_setup_data *data = malloc(sizeof (struct amg_setup_data));
-
-    /* Initialize local to global correspondence for id */
-    data->id_l2g = malloc((iuppermax+1) * sizeof(int));
-    int  *id_g2l = malloc((iuppermax+1) * sizeof(int));
-    int c= 0;
-    int ilower=0, iupper = -1;
-    for (i=0;i<iuppermax+1;i++) 
-    {
-        if (isrownonzero[i] != 0) 
-        {
-            data->id_l2g[c] = i+1; // Global indices start at 1
-            id_g2l[i] = c;         // Local indices start at 0
-            c++;
-            iupper++;
-        }
-    }
-
-    /* Set local ids */
-    data->idl = malloc((iupper+1) * sizeof(int));
-    for (i=0;i<iupper+1;i++)
-    {
-        data->idl[i]=i;
-    }
+    struct amg_setup_data *data = calloc(1, sizeof (struct amg_setup_data));
 
     /* Build Hypre IJ matrix */
     HYPRE_IJMatrix ij_matrix;
-	/* Init matrix */
-    HYPRE_IJMatrixCreate(0, ilower, iupper, ilower, iupper, 
-                         &ij_matrix);
-    HYPRE_IJMatrixSetObjectType(ij_matrix, HYPRE_PARCSR);
-    HYPRE_IJMatrixInitialize(ij_matrix);
+    build_matrix(&ij_matrix, data, ne, Aid, Ajd, Av, comm);
 
-	/* Set matrix entries */
-    for (i=0;i<n-1;i++) 
-    {
-		int ncols=1;
-    	if (Av[i] != 0)
-        {
-            HYPRE_IJMatrixSetValues(ij_matrix, 1, &ncols, &(id_g2l[Ai[i]]), 
-                                &(id_g2l[Aj[i]]), &Av[i]);
-        }
-    }
-
-    free(v);
     free(Aid);
     free(Ajd);
-    free(Ai);
-    free(Aj);
     free(Av);
-    free(id_g2l);
-
-    HYPRE_IJMatrixAssemble(ij_matrix);
 
-    /* Build Hypre CSR matrix */
+    /* Build Hypre ParCSR matrix */
     HYPRE_ParCSRMatrix A;
     HYPRE_IJMatrixGetObject(ij_matrix, (void **) &A);
 
@@ -230,27 +175,29 @@ int main(int argc, char *argv[])
 	/* AMG setup */
     HYPRE_Solver solver;
     HYPRE_BoomerAMGCreate(&solver); // Create solver
- 
+
     /* Set parameters (See Reference Manual for more parameters) */
-    HYPRE_BoomerAMGSetPrintLevel(solver, print_level);
+    HYPRE_BoomerAMGSetPrintLevel(solver, opt.print_level);
     //    HYPRE_BoomerAMGSetOldDefault(solver);
-    HYPRE_BoomerAMGSetCoarsenType(solver, coars_strat);
-    HYPRE_BoomerAMGSetInterpType(solver, interp_strat); 
+    HYPRE_BoomerAMGSetCoarsenType(solver, opt.coarsening);
+    HYPRE_BoomerAMGSetInterpType(solver, opt.interpolation);
     HYPRE_BoomerAMGSetMaxLevels(solver, maxlvls);  // maximum number of levels
     HYPRE_BoomerAMGSetMaxCoarseSize (solver, 1);
 
     /* Perform setup */
-    printf("BoomerAMGSetup... ");
+    rprintf("BoomerAMGSetup... ");
     HYPRE_BoomerAMGSetup(solver, A, b, x);
-    printf("done\n");
+    rprintf("done\n");
 
     /* Access solver data */
-    hypre_ParAMGData *amg_data = (hypre_ParAMGData*) solver; 
+    hypre_ParAMGData *amg_data = (hypre_ParAMGData*) solver;
             // structure hypre_ParAMGData is described in parcsr_lspar_amg.h
-    int numlvl = (amg_data)->num_levels; // number of levels
-    hypre_ParCSRMatrix **A_array = (amg_data)->A_array; 
-    hypre_ParCSRMatrix **P_array = (amg_data)->P_array;// Interpolation operator
-    int **CF_marker_array        = (amg_data)->CF_marker_array;
+    int numlvl = hypre_ParAMGDataNumLevels(amg_data); // number of levels
+    hypre_ParCSRMatrix **A_array = hypre_ParAMGDataAArray(amg_data);
+    hypre_ParCSRMatrix **P_array = hypre_ParAMGDataPArray(amg_data);
+            // Interpolation operator
+    int **CF_marker_array        = hypre_ParAMGDataCFMarkerArray(amg_data);
+    if (numlvl < 2) die("AMG setup produced a single level");
 
     /* Initialize data structure */
     data->nlevels = numlvl;
@@ -263,198 +210,51 @@ int main(int argc, char *argv[])
     data->idc   = malloc( maxlvls    * sizeof (int*));
     data->idf   = malloc( maxlvls    * sizeof (int*));
     data->D     = malloc((maxlvls-1) * sizeof (double*));
-    data->Af    = malloc((maxlvls-1) * sizeof (hypre_CSRMatrix *));
-    data->W     = malloc((maxlvls-1) * sizeof (hypre_CSRMatrix *));
-    data->AfP   = malloc((maxlvls-1) * sizeof (hypre_CSRMatrix *));
+    data->Af    = malloc((maxlvls-1) * sizeof (struct csr_mat *));
+    data->W     = malloc((maxlvls-1) * sizeof (struct csr_mat *));
+    data->AfP   = malloc((maxlvls-1) * sizeof (struct csr_mat *));
 
     /* Exctract data and compute smoother at each level */
     int lvl;
     for (lvl=0;lvl<numlvl;lvl++)
     {
-        /* Save matrix A */
         hypre_ParCSRMatrix *Alvl = A_array[lvl];
-        hypre_CSRMatrix *diagA = Alvl->diag; 
+        hypre_CSRMatrix *diagA = hypre_ParCSRMatrixDiag(Alvl);
+        hypre_CSRMatrix *offdA = hypre_ParCSRMatrixOffd(Alvl);
 
         /* Update number of rows and nonzeros in data */
-        int num_rows_A = diagA->num_rows;
-        int num_nnzs_A = diagA->num_nonzeros;
+        int num_rows_A = hypre_CSRMatrixNumRows(diagA);
         data->n[lvl] = num_rows_A;
-        data->nnz[lvl] = num_nnzs_A;
+        data->nnz[lvl] = hypre_CSRMatrixNumNonzeros(diagA) +
+                         hypre_CSRMatrixNumNonzeros(offdA);
 
         /* If not last level */
         if (lvl < numlvl-1)
         {
-            printf("--------\nLevel %d\n--------\n", lvl+1);
-            /* Extract fine and coarse variables */
-            int *CFlvl = CF_marker_array[lvl]; // CFlvl[i]==1 if i is coarse
-
-            /* Save interpolation operator W */
-            hypre_ParCSRMatrix *Plvl = P_array[lvl];
-            hypre_CSRMatrix *diagP = Plvl->diag;
-            int nF = diagP->num_rows - diagP->num_cols;
-            int nC = diagP->num_cols;
-
-            /* W = P(F,:) */
-            int *monec = malloc(nC * sizeof (int));
-            int k; 
-            for (k=0;k<nC;k++) monec[k] = -1; 
-            hypre_CSRMatrix *diagW;
-            sub_mat(&diagW, Plvl->diag, CFlvl, monec);// Extract rows "manually"
-            free(monec);
-            data->W[lvl] = diagW;
-
-            /* Save idf, idc and idl */
-            data->idf[lvl] = malloc(nF * sizeof (int));
-            data->idc[lvl] = malloc(nC * sizeof (int));
-            int *idl;
-            if (lvl == 0) idl = data->idl;
-            else          idl = data->idc[lvl-1];
-
-            /* Save ids for coarse and fine variables */
-            int *indicesF = malloc((nF+1) * sizeof (int));
-            indicesF[0] = nF;
-            int j, cc=0, cf=0;
-            for (j=0;j<num_rows_A;j++) 
-            {
-                if (CFlvl[j] == 1) 
-                {
-                    (data->idc[lvl])[cc] = idl[j];
-                    cc++;
-                }
-                else
-                {
-                    (data->idf[lvl])[cf] = idl[j];
-                    indicesF[cf+1] = j;
-                    cf++;
-                }
-            }
-
-            /* Extract submatrices
-               - Aff = A(F,F) 
-               - Afc = A(F,C) */
-            hypre_ParCSRMatrix **submatricesAf =
-                    malloc(4*sizeof(hypre_ParCSRMatrix*));
-            hypre_ParCSRMatrixExtractSubmatrices(Alvl, 
-                                                 indicesF, &submatricesAf);
-            hypre_ParCSRMatrix *Aff = (submatricesAf)[0];
-            hypre_ParCSRMatrix *Afc = (submatricesAf)[1];
-            hypre_CSRMatrix *diagAff = Aff->diag;
-            diagAff->num_rows = nF; // Correct bug
-            diagAff->num_cols = nF; // Correct bug
-            hypre_CSRMatrix *diagAfc = Afc->diag;
-            free(indicesF);
-
-            /* AfP = Af*W + Afc */
-            hypre_CSRMatrix *diagAfW;
-            diagAfW = hypre_CSRMatrixMultiply(diagAff, diagW);
-            hypre_CSRMatrix *diagAfP;
-            diagAfP = hypre_CSRMatrixAdd(diagAfW, diagAfc);
-            hypre_CSRMatrixDestroy(diagAfW); // destroy useless matrix
-
-            /* Save matrices Af and AfP */
-            data->Af[lvl] = diagAff;
-            data->AfP[lvl] = diagAfP;
-
-            /* Set nnzs and nnzfp in data */
-            int nnzAff = diagAff->num_nonzeros;
-            int nnzAfP = diagAfP->num_nonzeros;
-            data->nnzf[lvl]  = (double)nnzAff;
-            data->nnzfp[lvl] = (double)nnzAfP;
-
-/* Smoother ----------------------------------------------------------------- */
-            printf("Computing diagonal smoother... ");
-            double *af = malloc(nnzAff * sizeof (double)); 
-            memcpy(af, diagAff->data, nnzAff * sizeof (double));
-            double *af2 = af; // af2 = Af.*Af
-            vv_op(af2, af2, nnzAff, ewmult); // af2 = Af.*Af
-            double *s = malloc(nF * sizeof (double)); // s = 1./sum(Af.*Af)
-            int i;
-            for (i=0; i<nF; i++)
-            {
-                int js = diagAff->i[i];
-                int je = diagAff->i[i+1]; 
-                int nsum = je-js;
-
-                s[i] = array_op(af2, nsum, sum_op); // s = sum(af2)
-                af2 += nsum;
-            }
-            free(af);
-            array_op(s, nF, minv_op); // s = 1./s
-
-            double *D = malloc(nF * sizeof (double)); // D = diag(Af)' .* s
-            diag(D, diagAff);
-            vv_op(D, s, nF, ewmult);
-            free(s);
-            printf("Done!\n");
-
-            if (nF >= 2)
-            {
-                printf("Running Lanczos... ");
-                double *Dh = malloc(nF * sizeof (double)); // Dh = sqrt(D)
-                memcpy(Dh, D, nF * sizeof (double));
-                array_op(Dh, nF, sqrt_op);
-
-                hypre_CSRMatrix *diagDhAfDh;
-                diagDhAfDh = hypre_CSRMatrixCreate(nF, nF, nnzAff);
-                hypre_CSRMatrixInitialize(diagDhAfDh);
-
-                hypre_CSRMatrixCopy(diagAff, diagDhAfDh, 1);
-
-                dxm(diagDhAfDh, Dh, dmult); // DhAfDh = Dh*Af
-                dxm(diagDhAfDh, Dh, multd); // DhAfDh = Dh*Af*Dh
-
-                double *lambda; // vector of eigenvalues
-                int k = lanczos(&lambda, diagDhAfDh); // k=number of eigenvalues
-
-                printf("k = %d, ", (int)k);
-                printf("[lambda[0], lambda[%d]] = [%lf, %lf],",(int)k-1,
-                        lambda[0], lambda[k-1]);
-
-                double a = lambda[0]; // First and last eigenvalues
-                double b = lambda[k-1];
-
-                ar_scal_op(D, 2./(a+b), nF, mult_op);
-                
-                data->D[lvl] = malloc(nF * sizeof (double)); 
-                memcpy(data->D[lvl], D, nF * sizeof (double));
-
-                double rho = (b-a)/(b+a);
-                data->rho[lvl] = rho;
-                printf(" rho = %lf\n", rho);
-                
-                double m, c; 
-                double gamma2 = 1. - sqrt(1. - tol);
-                chebsim(&m, &c, rho, gamma2);
-                data->m[lvl] = m;
-                printf("Chebyshev smoother iterations: %d\tContraction: %lf\n",
-                        (int)m,c);
-
-                free(Dh);    
-                free(lambda);
-                hypre_CSRMatrixDestroy(diagDhAfDh);
-            }
-            else
-            {
-                data->D[lvl] = malloc(nF * sizeof (double)); 
-                memcpy(data->D[lvl], D, nF * sizeof (double));     
-
-                data->rho[lvl] = 0;
-                data->m[lvl] = 1;
-            }
-/* -------------------------------------------------------------------------- */ 
+            rprintf("--------\nLevel %d\n--------\n", lvl+1);
+            amg_level(data, lvl, Alvl, P_array[lvl], CF_marker_array[lvl],
+                      tol, comm);
         }
 
         if (lvl == (numlvl - 1))
         {
-            data->alast = diagA->data[0];
+            /* The variable of the last level is the first global row */
+            double alast = 0;
+            data->klast = -1;
+            if (num_rows_A > 0 && hypre_ParCSRMatrixFirstRowIndex(Alvl) == 0)
+            {
+                alast = hypre_CSRMatrixData(diagA)[0];
+                data->klast = data->idc[lvl-1][0];
+            }
+            MPI_Allreduce(&alast, &data->alast, 1, MPI_DOUBLE, MPI_SUM, comm);
             if (data->alast <= 1e-9) data->nullspace = 1;
             else                        data->nullspace = 0;
-            printf("Nullspace = %d\n", data->nullspace);
+            rprintf("Nullspace = %d\n", data->nullspace);
         }
     }
 
-    printf("Setup finished... Exporting data.\n");
-    amg_export(data);
+    rprintf("Setup finished (%lf s)... Exporting data.\n", MPI_Wtime()-t0);
+    amg_export(data, comm);
 
     /* Destroy matrix ij */
     HYPRE_IJMatrixDestroy(ij_matrix);
@@ -462,98 +262,710 @@ int main(int argc, char *argv[])
     /* Destroy solver */
     HYPRE_BoomerAMGDestroy(solver);
 
-    return 1;
+    rprintf("Total time: %lf s\n", MPI_Wtime()-t0);
+    MPI_Finalize();
+    return 0;
 }
 
-/* 
-    Extract sub-matrix: 
+/*
+    Set options
 */
-static void sub_mat(hypre_CSRMatrix **subA, const hypre_CSRMatrix *A, 
-    const int* idr, const int *idc)
+static int get_options(struct amg_options *opt, int argc, char *argv[])
 {
-    int rn = A->num_rows, cn = A->num_cols;
-    int *row_off = A->i, *col = A->j;
-    double *a = A->data;
-    int subrn = 0, subcn = 0, subncol = 0;
-    int i, j;
-    /* Compute number of rows and of non-zero elements for sub-matrix */
-    for (i=0; i<rn; i++)
+    int c;
+
+    opt->coarsening = 3; // Ruege-Stuben
+    opt->interpolation = 0; // classical modified interpolation
+    opt->max_levels = 30;
+    opt->tol = 0.5;
+    opt->print_level = 3; // Print solve info + parameters
+
+    opterr = 0;
+    while ((c = getopt(argc, argv, "c:i:l:t:p:f:h")) != -1)
     {
-        if (idr[i] < 0)
+        switch (c)
         {
-            subrn += 1;
-            int je=row_off[i+1]; 
-            for(j=row_off[i]; j<je; j++)
-            {
-                if (idc[col[j]] < 0)
-                {
-                    subncol += 1;
-                }
-            }
+            case 'c': opt->coarsening = atoi(optarg); break;
+            case 'i': opt->interpolation = atoi(optarg); break;
+            case 'l': opt->max_levels = atoi(optarg); break;
+            case 't': opt->tol = atof(optarg); break;
+            case 'p': opt->print_level = atoi(optarg); break;
+            case 'f': if (read_options(opt, optarg)) return 1; break;
+            case 'h': usage(); return 1;
+            default : usage(); return 1;
         }
     }
+    if (optind < argc) { usage(); return 1; }
+
+    if (!coars_name(opt->coarsening))
+    {
+        rprintf("Not a valid coarsening method: %d\n", opt->coarsening);
+        return 1;
+    }
+    if (!interp_name(opt->interpolation))
+    {
+        rprintf("Not a valid interpolation method: %d\n", opt->interpolation);
+        return 1;
+    }
+    if (opt->max_levels < 2)
+    {
+        rprintf("Maximum number of levels must be at least 2\n");
+        return 1;
+    }
+    if (opt->tol <= 0 || opt->tol >= 1)
+    {
+        rprintf("Smoother tolerance must be in (0,1)\n");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+    Read options from file
+*/
+static int read_options(struct amg_options *opt, const char *name)
+{
+    char line[256], key[64], val[64];
+    char *p;
+    FILE *f = fopen(name, "r");
+    if (!f)
+    {
+        rprintf("Cannot open %s\n", name);
+        return 1;
+    }
+    while (fgets(line, sizeof line, f))
+    {
+        if ((p = strchr(line, '#'))) *p = '\0';
+        for (p = line; *p; p++) if (*p == '=') *p = ' ';
+        if (sscanf(line, "%63s %63s", key, val) != 2) continue;
+        if      (!strcmp(key, "coarsening"))    opt->coarsening = atoi(val);
+        else if (!strcmp(key, "interpolation")) opt->interpolation = atoi(val);
+        else if (!strcmp(key, "levels"))        opt->max_levels = atoi(val);
+        else if (!strcmp(key, "tolerance"))     opt->tol = atof(val);
+        else if (!strcmp(key, "print_level"))   opt->print_level = atoi(val);
+        else
+        {
+            rprintf("Unknown key %s in %s\n", key, name);
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/*
+    Owner of global index g
+*/
+static int owner(const int *starts, const int g)
+{
+    int lo = 0, hi = np;
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi)/2;
+        if (starts[mid] <= g) lo = mid;
+        else                  hi = mid;
+    }
+    return lo;
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+    const int x = *(const int *)a, y = *(const int *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*
+    Sorted list of the distinct values of v(n)
+*/
+static int unique(int **u, const int *v, const int n)
+{
+    int i, k = 0;
+    *u = malloc((n+1) * sizeof (int));
+    memcpy(*u, v, n * sizeof (int));
+    qsort(*u, n, sizeof (int), cmp_int);
+    for (i=0;i<n;i++) if (k == 0 || (*u)[i] != (*u)[k-1]) (*u)[k++] = (*u)[i];
+    return k;
+}
+
+static int find(const int *u, const int n, const int v)
+{
+    const int *p = bsearch(&v, u, n, sizeof (int), cmp_int);
+    return p ? (int)(p - u) : -1;
+}
+
+/*
+    Partition of a distributed array
+*/
+static int *part_starts(const int n, MPI_Comm comm)
+{
+    int *starts = malloc((np+1) * sizeof (int));
+    int p;
+    MPI_Allgather((void *)&n, 1, MPI_INT, starts+1, 1, MPI_INT, comm);
+    starts[0] = 0;
+    for (p=0;p<np;p++) starts[p+1] += starts[p];
+    return starts;
+}
+
+/*
+    Set up distributed lookup
+*/
+static void lookup_setup(struct lookup *lk, const int *starts, const int n,
+    const int *gidx, MPI_Comm comm)
+{
+    int *own = malloc((n+1) * sizeof (int));
+    int *q   = malloc((n+1) * sizeof (int));
+    int *pos = malloc( np   * sizeof (int));
+    int i, p;
+
+    lk->comm = comm;
+    lk->n    = n;
+    lk->qcnt = calloc(np, sizeof (int));
+    lk->qdsp = malloc((np+1) * sizeof (int));
+    lk->acnt = malloc( np    * sizeof (int));
+    lk->adsp = malloc((np+1) * sizeof (int));
+    lk->perm = malloc((n+1)  * sizeof (int));
+
+    for (i=0;i<n;i++) own[i] = owner(starts, gidx[i]), lk->qcnt[own[i]]++;
+    lk->qdsp[0] = 0;
+    for (p=0;p<np;p++) lk->qdsp[p+1] = lk->qdsp[p] + lk->qcnt[p];
+    memcpy(pos, lk->qdsp, np * sizeof (int));
+    for (i=0;i<n;i++)
+    {
+        int k = pos[own[i]]++;
+        lk->perm[k] = i;
+        q[k] = gidx[i];
+    }
+
+    MPI_Alltoall(lk->qcnt, 1, MPI_INT, lk->acnt, 1, MPI_INT, comm);
+    lk->adsp[0] = 0;
+    for (p=0;p<np;p++) lk->adsp[p+1] = lk->adsp[p] + lk->acnt[p];
+    lk->na = lk->adsp[np];
+    lk->aidx = malloc((lk->na+1) * sizeof (int));
+    MPI_Alltoallv(q, lk->qcnt, lk->qdsp, MPI_INT,
+                  lk->aidx, lk->acnt, lk->adsp, MPI_INT, comm);
+    for (i=0;i<lk->na;i++) lk->aidx[i] -= starts[nid];
+
+    free(own);
+    free(q);
+    free(pos);
+}
+
+/*
+    Apply distributed lookup
+*/
+static void lookup_exec(const struct lookup *lk, void *out, const void *val,
+    MPI_Datatype type)
+{
+    int size, i;
+    MPI_Type_size(type, &size);
+    char *a = malloc((lk->na+1) * size);
+    char *q = malloc((lk->n +1) * size);
+
+    for (i=0;i<lk->na;i++)
+        memcpy(a + i*size, (const char *)val + lk->aidx[i]*size, size);
+    MPI_Alltoallv(a, lk->acnt, lk->adsp, type,
+                  q, lk->qcnt, lk->qdsp, type, lk->comm);
+    for (i=0;i<lk->n;i++)
+        memcpy((char *)out + lk->perm[i]*size, q + i*size, size);
+
+    free(a);
+    free(q);
+}
+
+static void lookup_free(struct lookup *lk)
+{
+    free(lk->qcnt);
+    free(lk->qdsp);
+    free(lk->acnt);
+    free(lk->adsp);
+    free(lk->aidx);
+    free(lk->perm);
+}
+
+static void csr_alloc(struct csr_mat *A, const int rn, const int nnz)
+{
+    A->rn = rn;
+    A->cn = 0;
+    A->row_off = malloc((rn+1)  * sizeof (int));
+    A->col     = malloc((nnz+1) * sizeof (int));
+    A->a       = malloc((nnz+1) * sizeof (double));
+    A->row_off[0] = 0;
+}
+
+static void csr_free(struct csr_mat *A)
+{
+    free(A->row_off);
+    free(A->col);
+    free(A->a);
+}
+
+/*
+    Fetch rows of a distributed matrix
+*/
+static void fetch_rows(struct csr_mat *out, const struct csr_mat *M,
+    const int *starts, const int n, const int *gidx, MPI_Comm comm)
+{
+    struct lookup lk;
+    int *len  = malloc((M->rn+1) * sizeof (int));
+    int *olen = malloc((n+1)     * sizeof (int));
+    int *ecnt = calloc(np, sizeof (int)), *edsp = malloc((np+1)*sizeof (int));
+    int *fcnt = calloc(np, sizeof (int)), *fdsp = malloc((np+1)*sizeof (int));
+    int i, j, p;
+
+    for (i=0;i<M->rn;i++) len[i] = M->row_off[i+1] - M->row_off[i];
+    lookup_setup(&lk, starts, n, gidx, comm);
+    lookup_exec(&lk, olen, len, MPI_INT);
+
+    int nnz = 0;
+    for (i=0;i<n;i++) nnz += olen[i];
+    csr_alloc(out, n, nnz);
+    for (i=0;i<n;i++) out->row_off[i+1] = out->row_off[i] + olen[i];
+
+    /* Pack the requested rows */
+    int na = 0;
+    for (p=0;p<np;p++)
+        for (i=lk.adsp[p];i<lk.adsp[p+1];i++) ecnt[p] += len[lk.aidx[i]];
+    edsp[0] = 0;
+    for (p=0;p<np;p++) edsp[p+1] = edsp[p] + ecnt[p];
+    na = edsp[np];
+    int *ca = malloc((na+1) * sizeof (int));
+    double *va = malloc((na+1) * sizeof (double));
+    for (i=0, na=0;i<lk.na;i++)
+    {
+        int r = lk.aidx[i];
+        for (j=M->row_off[r];j<M->row_off[r+1];j++)
+            ca[na] = M->col[j], va[na++] = M->a[j];
+    }
 
-    /* Compute cn for sub-matrix */
-    int c = 0; // counter
-    int *g2lcol = malloc(cn * sizeof (int)); // correspondence between local and 
-                                             // global column ids
-    for (i=0; i<cn; i++)
+    /* Receive in sorted request order */
+    for (p=0;p<np;p++)
+        for (i=lk.qdsp[p];i<lk.qdsp[p+1];i++) fcnt[p] += olen[lk.perm[i]];
+    fdsp[0] = 0;
+    for (p=0;p<np;p++) fdsp[p+1] = fdsp[p] + fcnt[p];
+    int *cq = malloc((nnz+1) * sizeof (int));
+    double *vq = malloc((nnz+1) * sizeof (double));
+    MPI_Alltoallv(ca, ecnt, edsp, MPI_INT, cq, fcnt, fdsp, MPI_INT, comm);
+    MPI_Alltoallv(va, ecnt, edsp, MPI_DOUBLE, vq, fcnt, fdsp, MPI_DOUBLE,
+                  comm);
+    for (i=0, j=0;i<n;i++)
     {
-        if (idc[i] < 0)
+        int r = lk.perm[i];
+        memcpy(out->col + out->row_off[r], cq + j, olen[r] * sizeof (int));
+        memcpy(out->a   + out->row_off[r], vq + j, olen[r] * sizeof (double));
+        j += olen[r];
+    }
+
+    lookup_free(&lk);
+    free(len); free(olen);
+    free(ecnt); free(edsp); free(fcnt); free(fdsp);
+    free(ca); free(va); free(cq); free(vq);
+}
+
+struct entry { int c; double v; };
+
+/*
+    Relabel columns, rows are sorted by the new column index so that the
+    result does not depend on the partition
+*/
+static void relabel(struct csr_mat *M, const int *starts, const int *val,
+    MPI_Comm comm)
+{
+    struct lookup lk;
+    const int nnz = M->row_off[M->rn];
+    struct entry *e = malloc((nnz+1) * sizeof (struct entry));
+    int i, k;
+    lookup_setup(&lk, starts, nnz, M->col, comm);
+    lookup_exec(&lk, M->col, val, MPI_INT);
+    lookup_free(&lk);
+    for (k=0;k<nnz;k++) e[k].c = M->col[k], e[k].v = M->a[k];
+    for (i=0;i<M->rn;i++)
+        qsort(e + M->row_off[i], M->row_off[i+1] - M->row_off[i],
+              sizeof (struct entry), cmp_int);
+    for (k=0;k<nnz;k++) M->col[k] = e[k].c, M->a[k] = e[k].v;
+    free(e);
+}
+
+/*
+    Build the IJ matrix from the dump entries.
+    Global ids are split in contiguous blocks over the ranks and every
+    entry is sent to the owner of its row. Rows without nonzero entries
+    are dropped, the others are numbered consecutively (ids ascending).
+*/
+struct triplet { int i, j; double v; };
+
+static void build_matrix(HYPRE_IJMatrix *ij_matrix,
+    struct amg_setup_data *data, const int ne, const double *Aid,
+    const double *Ajd, const double *Av, MPI_Comm comm)
+{
+    int i, p, maxid = 0, gmax;
+    for (i=0;i<ne;i++) if ((int)Aid[i] > maxid) maxid = (int)Aid[i];
+    MPI_Allreduce(&maxid, &gmax, 1, MPI_INT, MPI_MAX, comm);
+
+    /* Rank p owns the ids idstarts[p]+1 ... idstarts[p+1] */
+    int bs = (gmax + np - 1)/np;
+    int *idstarts = malloc((np+1) * sizeof (int));
+    for (p=0;p<=np;p++) idstarts[p] = p*bs < gmax ? p*bs : gmax;
+
+    /* Send nonzero entries to the owner of the row */
+    int *scnt = calloc(np, sizeof (int)), *sdsp = malloc((np+1)*sizeof (int));
+    int *rcnt = malloc(np * sizeof (int)), *rdsp = malloc((np+1)*sizeof (int));
+    for (i=0;i<ne;i++) if (Av[i] != 0) scnt[owner(idstarts, (int)Aid[i]-1)]++;
+    sdsp[0] = 0;
+    for (p=0;p<np;p++) sdsp[p+1] = sdsp[p] + scnt[p];
+    struct triplet *ts = malloc((sdsp[np]+1) * sizeof (struct triplet));
+    int *pos = malloc(np * sizeof (int));
+    memcpy(pos, sdsp, np * sizeof (int));
+    for (i=0;i<ne;i++)
+    {
+        if (Av[i] == 0) continue;
+        struct triplet *t = &ts[pos[owner(idstarts, (int)Aid[i]-1)]++];
+        t->i = (int)Aid[i]-1;
+        t->j = (int)Ajd[i]-1;
+        t->v = Av[i];
+    }
+    MPI_Alltoall(scnt, 1, MPI_INT, rcnt, 1, MPI_INT, comm);
+    rdsp[0] = 0;
+    for (p=0;p<np;p++) rdsp[p+1] = rdsp[p] + rcnt[p];
+    int nr = rdsp[np];
+    struct triplet *tr = malloc((nr+1) * sizeof (struct triplet));
+    for (p=0;p<np;p++)
+    {
+        scnt[p] *= sizeof (struct triplet); sdsp[p] *= sizeof (struct triplet);
+        rcnt[p] *= sizeof (struct triplet); rdsp[p] *= sizeof (struct triplet);
+    }
+    MPI_Alltoallv(ts, scnt, sdsp, MPI_BYTE, tr, rcnt, rdsp, MPI_BYTE, comm);
+    free(ts);
+
+    /* Number the nonzero rows */
+    const int i0 = idstarts[nid], nb = idstarts[nid+1] - i0;
+    int *id_g2l = malloc((nb+1) * sizeof(int));
+    for (i=0;i<nb;i++) id_g2l[i] = -1;
+    for (i=0;i<nr;i++) id_g2l[tr[i].i - i0] = 0;
+    int c = 0, ilower = 0;
+    for (i=0;i<nb;i++) if (id_g2l[i] == 0) c++;
+    MPI_Exscan(&c, &ilower, 1, MPI_INT, MPI_SUM, comm);
+    if (nid == 0) ilower = 0;
+
+    data->ilower = ilower;
+    data->id_l2g = malloc((c+1) * sizeof(int));
+    data->idl    = malloc((c+1) * sizeof(int));
+    for (i=0, c=0;i<nb;i++)
+    {
+        if (id_g2l[i] == 0)
         {
-            subcn += 1;
-            g2lcol[i] = c;
+            data->id_l2g[c] = i0+i+1; // Global indices start at 1
+            data->idl[c] = c;
+            id_g2l[i] = ilower + c;
             c++;
         }
+    }
+
+    /* Row and column numbers */
+    int *rows = malloc((nr+1) * sizeof (int));
+    int *cols = malloc((nr+1) * sizeof (int));
+    struct lookup lk;
+    for (i=0;i<nr;i++) rows[i] = tr[i].j;
+    lookup_setup(&lk, idstarts, nr, rows, comm);
+    lookup_exec(&lk, cols, id_g2l, MPI_INT);
+    lookup_free(&lk);
+    for (i=0;i<nr;i++) rows[i] = id_g2l[tr[i].i - i0];
+
+	/* Init matrix */
+    HYPRE_IJMatrixCreate(comm, ilower, ilower+c-1, ilower, ilower+c-1,
+                         ij_matrix);
+    HYPRE_IJMatrixSetObjectType(*ij_matrix, HYPRE_PARCSR);
+    HYPRE_IJMatrixInitialize(*ij_matrix);
+
+	/* Set matrix entries */
+    for (i=0;i<nr;i++)
+    {
+        int ncols=1;
+        HYPRE_IJMatrixAddToValues(*ij_matrix, 1, &ncols, &rows[i], &cols[i],
+                                  &tr[i].v);
+    }
+    HYPRE_IJMatrixAssemble(*ij_matrix);
+
+    free(idstarts);
+    free(scnt); free(sdsp); free(rcnt); free(rdsp); free(pos);
+    free(tr);
+    free(id_g2l);
+    free(rows);
+    free(cols);
+}
+
+/*
+    Column of entry k of the local row block of A in the level numbering:
+    fine columns >= 0, coarse columns -1-(global coarse index)
+*/
+#define COLCODE(diag,k) ((diag) ? code[Adj[k]] : ocode[Aoj[k]])
+
+/*
+    Extract data and compute smoother at one level
+*/
+static void amg_level(struct amg_setup_data *data, const int lvl,
+    hypre_ParCSRMatrix *A, hypre_ParCSRMatrix *P, const int *CF,
+    const double tol, MPI_Comm comm)
+{
+    hypre_CSRMatrix *Ad = hypre_ParCSRMatrixDiag(A);
+    hypre_CSRMatrix *Ao = hypre_ParCSRMatrixOffd(A);
+    hypre_CSRMatrix *Pd = hypre_ParCSRMatrixDiag(P);
+    hypre_CSRMatrix *Po = hypre_ParCSRMatrixOffd(P);
+    const int *Adi = hypre_CSRMatrixI(Ad), *Adj = hypre_CSRMatrixJ(Ad);
+    const int *Aoi = hypre_CSRMatrixI(Ao), *Aoj = hypre_CSRMatrixJ(Ao);
+    const double *Ada = hypre_CSRMatrixData(Ad), *Aoa = hypre_CSRMatrixData(Ao);
+    const int *Pdi = hypre_CSRMatrixI(Pd), *Pdj = hypre_CSRMatrixJ(Pd);
+    const int *Poi = hypre_CSRMatrixI(Po), *Poj = hypre_CSRMatrixJ(Po);
+    const double *Pda = hypre_CSRMatrixData(Pd), *Poa = hypre_CSRMatrixData(Po);
+    const int *Pcmap = hypre_ParCSRMatrixColMapOffd(P);
+    const int nr = hypre_CSRMatrixNumRows(Ad);
+    const int nco = hypre_CSRMatrixNumCols(Ao);
+    const int *idl = lvl == 0 ? data->idl : data->idc[lvl-1];
+    int i, j, k;
+
+    /* Split into fine and coarse variables */
+    int nF = 0, nC = 0;
+    for (i=0;i<nr;i++) if (CF[i] == 1) nC++; else nF++;
+    int *rstarts = part_starts(nr, comm);
+    int *fstarts = part_starts(nF, comm);
+    int *cstarts = part_starts(nC, comm);
+    if (hypre_ParCSRMatrixFirstColDiag(P) != cstarts[nid])
+        die("unexpected coarse grid partition");
+
+    data->idf[lvl] = malloc((nF+1) * sizeof (int));
+    data->idc[lvl] = malloc((nC+1) * sizeof (int));
+    int *code = malloc((nr+1) * sizeof (int));
+    int *fid  = malloc((nF+1) * sizeof (int));
+    int *cid  = malloc((nC+1) * sizeof (int));
+    int cc = 0, cf = 0;
+    for (i=0;i<nr;i++)
+    {
+        if (CF[i] == 1)
+        {
+            data->idc[lvl][cc] = idl[i];
+            cid[cc] = data->id_l2g[idl[i]];
+            code[i] = -1 - (cstarts[nid] + cc++);
+        }
         else
         {
-            g2lcol[i] = -1; // dummy
+            data->idf[lvl][cf] = idl[i];
+            fid[cf] = data->id_l2g[idl[i]];
+            code[i] = fstarts[nid] + cf++;
         }
     }
+    int *ocode = malloc((nco+1) * sizeof (int));
+    struct lookup lk;
+    lookup_setup(&lk, rstarts, nco, hypre_ParCSRMatrixColMapOffd(A), comm);
+    lookup_exec(&lk, ocode, code, MPI_INT);
+    lookup_free(&lk);
+
+    /* Af = A(F,F), Afc = A(F,C) and W = P(F,:) in global numbering */
+    struct csr_mat *Af = malloc(sizeof (struct csr_mat));
+    struct csr_mat *W  = malloc(sizeof (struct csr_mat));
+    struct csr_mat Afc;
+    int naf = 0, nafc = 0, nw = 0;
+    for (i=0;i<nr;i++)
+    {
+        if (CF[i] == 1) continue;
+        for (k=Adi[i];k<Adi[i+1];k++) if (COLCODE(1,k) >= 0) naf++; else nafc++;
+        for (k=Aoi[i];k<Aoi[i+1];k++) if (COLCODE(0,k) >= 0) naf++; else nafc++;
+        nw += Pdi[i+1]-Pdi[i] + Poi[i+1]-Poi[i];
+    }
+    csr_alloc(Af, nF, naf);
+    csr_alloc(&Afc, nF, nafc);
+    csr_alloc(W, nF, nw);
+    naf = nafc = nw = 0;
+    for (i=0, j=0;i<nr;i++)
+    {
+        if (CF[i] == 1) continue;
+        for (k=Adi[i];k<Adi[i+1];k++)
+        {
+            int c = COLCODE(1,k);
+            if (c >= 0) Af->col[naf] = c, Af->a[naf++] = Ada[k];
+            else Afc.col[nafc] = -1-c, Afc.a[nafc++] = Ada[k];
+        }
+        for (k=Aoi[i];k<Aoi[i+1];k++)
+        {
+            int c = COLCODE(0,k);
+            if (c >= 0) Af->col[naf] = c, Af->a[naf++] = Aoa[k];
+            else Afc.col[nafc] = -1-c, Afc.a[nafc++] = Aoa[k];
+        }
+        for (k=Pdi[i];k<Pdi[i+1];k++)
+            W->col[nw] = cstarts[nid] + Pdj[k], W->a[nw++] = Pda[k];
+        for (k=Poi[i];k<Poi[i+1];k++)
+            W->col[nw] = Pcmap[Poj[k]], W->a[nw++] = Poa[k];
+        j++;
+        Af->row_off[j] = naf;
+        Afc.row_off[j] = nafc;
+        W->row_off[j] = nw;
+    }
+    free(code);
+    free(ocode);
+
+    /* AfP = Af*W + Afc */
+    int *ucol, nu = unique(&ucol, Af->col, naf);
+    struct csr_mat Wu;
+    fetch_rows(&Wu, W, fstarts, nu, ucol, comm);
+    int nb = nafc;
+    for (k=0;k<naf;k++)
+    {
+        int r = find(ucol, nu, Af->col[k]);
+        nb += Wu.row_off[r+1] - Wu.row_off[r];
+    }
+    struct csr_mat *AfP = malloc(sizeof (struct csr_mat));
+    csr_alloc(AfP, nF, nb);
+    struct entry *buf = malloc((nb+1) * sizeof (struct entry));
+    int nafp = 0;
+    for (i=0;i<nF;i++)
+    {
+        int m = 0;
+        for (k=Af->row_off[i];k<Af->row_off[i+1];k++)
+        {
+            int r = find(ucol, nu, Af->col[k]);
+            for (j=Wu.row_off[r];j<Wu.row_off[r+1];j++)
+                buf[m].c = Wu.col[j], buf[m++].v = Af->a[k]*Wu.a[j];
+        }
+        for (k=Afc.row_off[i];k<Afc.row_off[i+1];k++)
+            buf[m].c = Afc.col[k], buf[m++].v = Afc.a[k];
+        qsort(buf, m, sizeof (struct entry), cmp_int);
+        for (k=0;k<m;k++)
+        {
+            if (k > 0 && buf[k].c == AfP->col[nafp-1])
+                AfP->a[nafp-1] += buf[k].v;
+            else
+                AfP->col[nafp] = buf[k].c, AfP->a[nafp++] = buf[k].v;
+        }
+        AfP->row_off[i+1] = nafp;
+    }
+    free(buf);
+    free(ucol);
+    csr_free(&Wu);
+    csr_free(&Afc);
 
-    /* Initialize and build sub-matrix */
-    *subA = hypre_CSRMatrixCreate(subrn, subcn, subncol);
-    hypre_CSRMatrix *subA_ptr = *subA;
-    hypre_CSRMatrixInitialize(subA_ptr);
-
-    int *subrow_off = subA_ptr->i;
-    int *subcol     = subA_ptr->j;
-    double *suba    = subA_ptr->data;
+    /* Set nnzs and nnzfp in data */
+    data->nnzf[lvl]  = (double)naf;
+    data->nnzfp[lvl] = (double)nafp;
 
-    *subrow_off++ = 0;
-    int roffset = 0;
+/* Smoother ----------------------------------------------------------------- */
+    rprintf("Computing diagonal smoother... ");
+    double *D = malloc((nF+1) * sizeof (double)); // D = diag(Af)' ./ sum(Af.*Af)
+    for (i=0; i<nF; i++)
+    {
+        double s = 0, d = 0;
+        for (k=Af->row_off[i];k<Af->row_off[i+1];k++)
+        {
+            s += Af->a[k]*Af->a[k];
+            if (Af->col[k] == fstarts[nid]+i) d = Af->a[k];
+        }
+        D[i] = d/s;
+    }
+    rprintf("Done!\n");
 
-    for (i=0; i<rn; i++)
+    if (fstarts[np] >= 2)
     {
-        if (idr[i] < 0)
+        rprintf("Running Lanczos... ");
+        double *Dh = malloc((nF+1) * sizeof (double)); // Dh = sqrt(D)
+        memcpy(Dh, D, nF * sizeof (double));
+        array_op(Dh, nF, sqrt_op);
+
+        /* Halo of Af: the fine columns owned by other ranks */
+        int *hcol = malloc((naf+1) * sizeof (int)), nh = 0, *uh;
+        for (k=0;k<naf;k++)
         {
-            int je=row_off[i+1]; 
-            for(j=row_off[i]; j<je; j++)
+            int c = Af->col[k] - fstarts[nid];
+            if (c < 0 || c >= nF) hcol[nh++] = Af->col[k];
+        }
+        nh = unique(&uh, hcol, nh);
+        struct lookup halo;
+        lookup_setup(&halo, fstarts, nh, uh, comm);
+        double *Dhh = malloc((nF+nh+1) * sizeof (double));
+        memcpy(Dhh, Dh, nF * sizeof (double));
+        lookup_exec(&halo, Dhh+nF, Dh, MPI_DOUBLE);
+
+        /* DhAfDh = Dh*Af*Dh with local columns (halo after nF) */
+        struct csr_mat DhAfDh;
+        csr_alloc(&DhAfDh, nF, naf);
+        memcpy(DhAfDh.row_off, Af->row_off, (nF+1) * sizeof (int));
+        for (i=0; i<nF; i++)
+        {
+            for (k=Af->row_off[i];k<Af->row_off[i+1];k++)
             {
-                if (idc[col[j]] < 0)
-                {
-                    roffset += 1;
-                    *subcol++ = g2lcol[col[j]];
-                    *suba++   = a[j];
-                }
+                int c = Af->col[k] - fstarts[nid];
+                if (c < 0 || c >= nF) c = nF + find(uh, nh, Af->col[k]);
+                DhAfDh.col[k] = c;
+                DhAfDh.a[k] = Dh[i]*Af->a[k]*Dhh[c];
             }
-            *subrow_off++ = roffset;
         }
+
+        double *lambda; // vector of eigenvalues
+        int k = lanczos(&lambda, &DhAfDh, &halo, comm);
+                        // k=number of eigenvalues
+
+        rprintf("k = %d, ", (int)k);
+        rprintf("[lambda[0], lambda[%d]] = [%lf, %lf],",(int)k-1,
+                lambda[0], lambda[k-1]);
+
+        double a = lambda[0]; // First and last eigenvalues
+        double b = lambda[k-1];
+
+        ar_scal_op(D, 2./(a+b), nF, mult_op);
+
+        data->D[lvl] = D;
+
+        double rho = (b-a)/(b+a);
+        data->rho[lvl] = rho;
+        rprintf(" rho = %lf\n", rho);
+
+        double m, c;
+        double gamma2 = 1. - sqrt(1. - tol);
+        chebsim(&m, &c, rho, gamma2);
+        data->m[lvl] = m;
+        rprintf("Chebyshev smoother iterations: %d\tContraction: %lf\n",
+                (int)m,c);
+
+        free(Dh);
+        free(Dhh);
+        free(hcol);
+        free(uh);
+        free(lambda);
+        lookup_free(&halo);
+        csr_free(&DhAfDh);
     }
+    else
+    {
+        data->D[lvl] = D;
 
-    free(g2lcol);
+        data->rho[lvl] = 0;
+        data->m[lvl] = 1;
+    }
+/* -------------------------------------------------------------------------- */
+
+    /* Columns in global ids for the export */
+    relabel(Af, fstarts, fid, comm);
+    relabel(W, cstarts, cid, comm);
+    relabel(AfP, cstarts, cid, comm);
+    data->Af[lvl] = Af;
+    data->W[lvl] = W;
+    data->AfP[lvl] = AfP;
+
+    free(fid);
+    free(cid);
+    free(rstarts);
+    free(fstarts);
+    free(cstarts);
 }
+#undef COLCODE
 
 /*
     Export data from the AMG setup to correct format.
 */
-static void amg_export(const struct amg_setup_data *data)
+static void amg_export(const struct amg_setup_data *data, MPI_Comm comm)
 {
     int nlevels = data->nlevels;
     int n = data->n[0];
-    
+
     /* Find what is the last level at which each variable appears */
-    int *lvl = malloc(n * sizeof (int));
+    int *lvl = malloc((n+1) * sizeof (int));
     int i, j;
 
     for (i=0;i<n;i++) lvl[i] = 1;
@@ -568,7 +980,7 @@ static void amg_export(const struct amg_setup_data *data)
     }
 
     /* Reorder diagonal smoother (except for last level) */
-    double *dvec = malloc(n * sizeof (double));
+    double *dvec = malloc((n+1) * sizeof (double));
     for (i=0;i<nlevels-1;i++)
     {
         int nl = data->n[i]-data->n[i+1];
@@ -581,32 +993,33 @@ static void amg_export(const struct amg_setup_data *data)
     }
 
     /* Set smoother at last level */
-    int k = (data->idc[nlevels-2][0]);
-    if (data->nullspace != 0) 
-    {
-        dvec[k] = 0.;
-    }
-    else 
+    int k = data->klast;
+    if (k >= 0)
     {
-        double a = data->alast;
-        dvec[k] = 1./a;
+        if (data->nullspace != 0)
+        {
+            dvec[k] = 0.;
+        }
+        else
+        {
+            double a = data->alast;
+            dvec[k] = 1./a;
+        }
     }
 
     /* Save matrices */
-    int *W_len = malloc(n * sizeof (int));
-    savemats(W_len, n, nlevels-1, lvl, data->idc, data->id_l2g, data->W,
-             "amg_W.dat");
+    int *W_len = malloc((n+1) * sizeof (int));
+    savemats(W_len, n, nlevels-1, lvl, data->W, "amg_W.dat", comm);
 
-    int *AfP_len = malloc(n * sizeof (int));
-    savemats(AfP_len, n, nlevels-1, lvl, data->idc, data->id_l2g, data->AfP, 
-             "amg_AfP.dat");
+    int *AfP_len = malloc((n+1) * sizeof (int));
+    savemats(AfP_len, n, nlevels-1, lvl, data->AfP, "amg_AfP.dat", comm);
 
-    int *Aff_len = malloc(n * sizeof (int));
-    savemats(Aff_len, n, nlevels-1, lvl, data->idf, data->id_l2g, data->Af, 
-             "amg_Aff.dat");
+    int *Aff_len = malloc((n+1) * sizeof (int));
+    savemats(Aff_len, n, nlevels-1, lvl, data->Af, "amg_Aff.dat", comm);
 
     /* Save vector */
-    savevec(nlevels, data, n, lvl, W_len, AfP_len, Aff_len, dvec, "amg.dat");
+    savevec(nlevels, data, n, lvl, W_len, AfP_len, Aff_len, dvec, "amg.dat",
+            comm);
 
     /* Free allocated memory */
     free(W_len);
@@ -619,85 +1032,71 @@ static void amg_export(const struct amg_setup_data *data)
 /*
     Function to save matrices
 */
-static void savemats(int *len, const int n, const int nl, const int *lvl, 
-    int **id, const int *id_l2g, hypre_CSRMatrix **mat, const char *filename)
+static void savemats(int *len, const int n, const int nl, const int *lvl,
+    struct csr_mat **mat, const char *filename, MPI_Comm comm)
 {
     const double magic = 3.14159;
-    FILE *f = fopen(filename,"w");
-    int max=0;
+    long long tot = 0, off = 0;
     int i;
     int *row;
-    double *buf;
-    fwrite(&magic,sizeof (double),1,f);
-    for(i=0;i<nl;++i) {int l=max_row_nnz(mat[i]); if(l>max) max=l; }
-    buf = malloc(2*max * sizeof (double));
-    row = malloc(nl    * sizeof (int));
+    double *buf, *p;
+    row = malloc((nl+1) * sizeof (int));
+    for(i=0;i<nl;++i) tot += 2*mat[i]->row_off[mat[i]->rn];
+    buf = malloc((tot+1) * sizeof (double));
     for(i=0;i<nl;++i) row[i]=0;
-    for(i=0;i<n;++i) 
+    p = buf;
+    for(i=0;i<n;++i)
     {
         int l = lvl[i]-1;
-        hypre_CSRMatrix *M;
+        struct csr_mat *M;
         int j,k,kb,ke;
-        double *p;
         if(l>nl) { printf("level out of bounds\n"); continue; }
         if(l==nl) { len[i]=0; continue; }
         M = mat[l];
         j = row[l]++;
-        if(j>=M->num_rows) { printf("row out of bounds\n"); continue; }
-        kb=M->i[j],ke=M->i[j+1];
-        p = buf;
-        for(k=kb;k!=ke;++k) *p++ = id_l2g[id[l][M->j[k]]], *p++ = M->data[k];
+        if(j>=M->rn) { printf("row out of bounds\n"); continue; }
+        kb=M->row_off[j],ke=M->row_off[j+1];
+        for(k=kb;k!=ke;++k) *p++ = M->col[k], *p++ = M->a[k];
         len[i] = ke-kb;
-        fwrite(buf,sizeof (double),(double)(2*(ke-kb)),f);
     }
-    for(i=0;i<nl;++i) 
+    for(i=0;i<nl;++i)
     {
-        if(row[i]!=mat[i]->num_rows) printf("matrices not exhausted\n");
+        if(row[i]!=mat[i]->rn) printf("matrices not exhausted\n");
     }
+    tot = p - buf;
+    MPI_Exscan(&tot, &off, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (nid == 0) off = 0;
+    write_par(filename, &magic, 1, buf, tot, off, comm);
     free(row);
     free(buf);
-    fclose(f);
 
-    printf("%d matrices written to %s\n",(int)nl, filename);
-}
-
-/* 
-    Returns max number of non zero elements on a row
-*/
-static int max_row_nnz(const hypre_CSRMatrix *mat)
-{
-    int n=mat->num_rows,max=0;     
-
-    int i;
-    for(i=0;i<n;++i) 
-    {
-        int l=mat->i[i+1]-mat->i[i];
-        if(l>max) max=l;
-    }
-    return max;
+    rprintf("%d matrices written to %s\n",(int)nl, filename);
 }
 
 /*
     Function to save vectors
 */
-static void savevec(const int nl, const struct amg_setup_data *data, 
-    const int n, const int *lvl, const int *W_len, const int *AfP_len, 
-    const int *Aff_len, const double *dvec, const const char *filename)
+static void savevec(const int nl, const struct amg_setup_data *data,
+    const int n, const int *lvl, const int *W_len, const int *AfP_len,
+    const int *Aff_len, const double *dvec, const char *filename,
+    MPI_Comm comm)
 {
-    int ntot = 2+2*nl+6*n;
-    double *q = malloc(ntot * sizeof (double));
+    int nh = 2+2*nl, ng;
+    double *h = malloc(nh * sizeof (double));
+    double *q = malloc((6*n+1) * sizeof (double));
     const double magic = 3.14159;
     const double stamp = 2.01;
 
-    q[0] = magic;
-    q[1] = stamp;
-    q[2] = (double)nl;
-    memcpy(&q[3]       , data->m  , sizeof(double)*(nl-1));
-    memcpy(&q[3+(nl-1)], data->rho, sizeof(double)*(nl-1));
-    q[3+2*(nl-1)] = (double)n;
+    MPI_Allreduce((void *)&n, &ng, 1, MPI_INT, MPI_SUM, comm);
+    h[0] = magic;
+    h[1] = stamp;
+    h[2] = (double)nl;
+    memcpy(&h[3]       , data->m  , sizeof(double)*(nl-1));
+    memcpy(&h[3+(nl-1)], data->rho, sizeof(double)*(nl-1));
+    h[3+2*(nl-1)] = (double)ng;
 
     int i;
-    int qi = 2+2*nl;
+    int qi = 0;
     for (i=0;i<n;i++)
     {
             q[qi++] = (double)data->id_l2g[data->idl[i]];
@@ -708,16 +1107,35 @@ static void savevec(const int nl, const struct amg_setup_data *data,
             q[qi++] = dvec[i];
     }
 
-    FILE *f = fopen(filename,"w");
-    fwrite(q,sizeof(double),ntot,f);
-    fclose(f);
+    write_par(filename, h, nh, q, 6*n, 6*(long long)data->ilower, comm);
+    free(h);
     free(q);
 
-    printf("%d doubles written to %s\n", (int)ntot, filename);
+    rprintf("%d doubles written to %s\n", nh+6*ng, filename);
+}
+
+/*
+    Parallel write
+*/
+static void write_par(const char *filename, const double *hdr, const int nh,
+    const double *buf, const long long n, const long long off,
+    MPI_Comm comm)
+{
+    MPI_File fh;
+    MPI_Status st;
+    if (MPI_File_open(comm, (char *)filename,
+                      MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh)
+        != MPI_SUCCESS) die("cannot open output file");
+    MPI_File_set_size(fh, 0);
+    if (nid == 0)
+        MPI_File_write_at(fh, 0, (void *)hdr, nh, MPI_DOUBLE, &st);
+    MPI_File_write_at_all(fh, (MPI_Offset)(nh+off)*sizeof (double),
+                          (void *)buf, (int)n, MPI_DOUBLE, &st);
+    MPI_File_close(&fh);
 }
 
 /*
-    Chebsim: computes number of iteration and contraction factor for the    
+    Chebsim: computes number of iteration and contraction factor for the
     Chebyshev relaxation.
 */
 static void chebsim(double *m, double *c, const double rho, const double tol)
@@ -728,7 +1146,7 @@ static void chebsim(double *m, double *c, const double rho, const double tol)
     *c = rho;
     double gamma = 1;
     double d, cn;
-    
+
     while (*c > tol)
     {
         *m += 1;
@@ -740,46 +1158,128 @@ static void chebsim(double *m, double *c, const double rho, const double tol)
     }
 }
 
-/* 
-    Compute eigenvalues by Lanczos algorithm
+/*
+    Get size file in number of doubles
 */
-static int lanczos(double **lambda, hypre_CSRMatrix *A)
+static long filesize(const char *name)
 {
-    int rn = A->num_rows;
-    int cn = A->num_cols;
-    double *r = malloc(rn * sizeof (double));
-    
-    int i;
+  long n;
+  FILE *f = fopen(name,"r");
+  if (!f) return -1;
+  fseek(f,0,SEEK_END);
+  n = ftell(f)/sizeof(double);
+  fclose(f);
+  return n;
+}
+
+/*
+    Read input files
+*/
+static long readfile(double *data, long off, long n, const char *name)
+{
+  const double magic = 3.14159;
+  double m;
+  long nf;
+  FILE *f = fopen(name,"r");
+  if (!f) return -1;
+
+  fseek(f,0,SEEK_END);
+  nf = ftell(f)/sizeof(double);
+  if(off+n>nf) printf("file shorter than expected"),n=nf-off;
+  if(n<0) n=0;
+  fseek(f,0,SEEK_SET);
+  fread(&m,sizeof(double),1,f);
+  fseek(f,off*sizeof(double),SEEK_SET);
+  n = fread(data,sizeof(double),n,f);
+  fclose(f);
+  if(fabs(m-magic)>0.000001) {
+    long i;
+    /*printf("swapping byte order"); */
+    if(fabs(byteswap(m)-magic)>0.000001) {
+      printf("magic number for endian test not found");
+    } else
+      for(i=0;i<n;++i) data[i]=byteswap(data[i]);
+  }
+  return n;
+}
+
+/*
+    y = A*x
+*/
+static void csr_matvec(double *y, const struct csr_mat *A, const double *x)
+{
+    int i, k;
+    for (i=0;i<A->rn;i++)
+    {
+        double s = 0;
+        for (k=A->row_off[i];k<A->row_off[i+1];k++) s += A->a[k]*x[A->col[k]];
+        y[i] = s;
+    }
+}
+
+/*
+    Lanczos operator: halo exchange, then the local rows
+*/
+struct lanczos_ctx
+{
+    const struct csr_mat *A;
+    const struct lookup *halo;
+    double *x; // local values followed by the halo
+    MPI_Comm comm;
+};
+
+static void lanczos_ax(double *y, const double *x, void *ctx)
+{
+    struct lanczos_ctx *c = ctx;
+    memcpy(c->x, x, c->A->rn*sizeof(double));
+    lookup_exec(c->halo, c->x+c->A->rn, c->x, MPI_DOUBLE);
+    csr_matvec(y, c->A, c->x);
+}
+
+static void lanczos_gsum(double *v, int n, void *ctx)
+{
+    struct lanczos_ctx *c = ctx;
+    MPI_Allreduce(MPI_IN_PLACE, v, n, MPI_DOUBLE, MPI_SUM, c->comm);
+}
+
+/*
+    Compute eigenvalues by Lanczos algorithm (core/lanczos.c)
+*/
+static int lanczos(double **lambda, const struct csr_mat *A,
+    const struct lookup *halo, MPI_Comm comm)
+{
+    int rn = A->rn, ng;
+    double *r = malloc((rn+1) * sizeof (double));
+
+    int i, j;
     for (i=0; i<rn; i++)
     {
         r[i] = (double)rand() / (double)RAND_MAX;
     }
-    
+    MPI_Allreduce(&rn, &ng, 1, MPI_INT, MPI_SUM, comm);
+
     int kmax = 299; // Fixed length for max value of k
     *lambda = malloc(kmax * sizeof (double));
     double *l = *lambda;
     double *y = malloc(kmax * sizeof (double));
-    double *a = malloc(kmax * sizeof (double));
-    double *b = malloc(kmax * sizeof (double));
-    double *d = malloc((kmax+1) * sizeof (double));
-    double *v = malloc(kmax * sizeof (double));
-
-    double beta = array_op(r, rn, norm2_op);
-    double beta2 = beta*beta;
 
-    int k = 0; 
-    double change = 0.0;
+    int k = 0;
 
-    double *eye = malloc(rn * sizeof (double));
-    init_array(eye, rn, 1.);
-
-    /* Frobenius norm */
-    hypre_CSRMatrix *Ae;
-    dpm(&Ae, A, eye, dsub);
-    /* A assumed to be real ==> Frobenius norm is 2-norm of A->a */
-    double fronorm = array_op(Ae->data, Ae->i[rn], norm2_op);
-
-    hypre_CSRMatrixDestroy(Ae);
+    /* Frobenius norm of A - I */
+    double fro = 0, fronorm;
+    for (i=0; i<rn; i++)
+    {
+        int hasd = 0;
+        for (j=A->row_off[i];j<A->row_off[i+1];j++)
+        {
+            double aij = A->a[j];
+            if (A->col[j] == i) aij -= 1., hasd = 1;
+            fro += aij*aij;
+        }
+        if (!hasd) fro += 1.;
+    }
+    MPI_Allreduce(&fro, &fronorm, 1, MPI_DOUBLE, MPI_SUM, comm);
+    fronorm = sqrt(fronorm);
 
     if (fronorm < 1e-11)
     {
@@ -788,83 +1288,28 @@ static int lanczos(double **lambda, hypre_CSRMatrix *A)
         y[0] = 0;
         y[1] = 0;
         k = 2;
-        change = 0.0;
-    }
-    else
-    {
-        change = 1.0;
     }
 
-    if (rn == 1)
+    if (ng == 1)
     {
-        double A00 = A->data[0];
+        double A00 = rn == 1 ? A->a[0] : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &A00, 1, MPI_DOUBLE, MPI_SUM, comm);
 
         l[0] = A00;
         l[1] = A00;
         y[0] = 0;
         y[1] = 0;
         k = 2;
-        change = 0.0; 
     }
 
-    double *qk = malloc(rn * sizeof (double));
-    init_array(qk, cn, 0.);
-    double *qkm1 = malloc(rn * sizeof (double));
-    double *alphaqk = malloc(rn * sizeof (double)); // alpha * qk vector
-    double *Aqk = malloc(rn * sizeof (double));
-    int na = 0, nb = 0;
-
-    hypre_Vector *Aqk_hyper, *qk_hyper;
-    qk_hyper = hypre_SeqVectorCreate(rn);
-    hypre_SeqVectorInitialize(qk_hyper);
-
-    Aqk_hyper = hypre_SeqVectorCreate(rn);
-    hypre_SeqVectorInitialize(Aqk_hyper);
-
-    while (k < kmax && ( change > 1e-5 || y[0] > 1e-3 || y[k-1] > 1e-3))
+    if (k == 0)
     {
-        k++;
-        memcpy(qkm1, qk, rn*sizeof(double)); // qkm1 = qk
-        memcpy(qk, r, rn*sizeof(double)); // qk = r/beta
-        ar_scal_op(qk, 1./beta, rn, mult_op);
-        qk_hyper->data = qk; 
-        hypre_CSRMatrixMatvec( 1, A, qk_hyper, 0, Aqk_hyper); // Aqk = A*qk
-        Aqk = Aqk_hyper->data;
-        double alpha = vv_dot(qk, Aqk, rn);  // alpha = qk'*Aqk
-        a[na++] = alpha;//a = [a; alpha];
-        /* r = Aqk - alpha*qk - beta*qkm1 */
-        memcpy(alphaqk, qk, rn*sizeof(double)); // alphaqk = qk
-        ar_scal_op(alphaqk, alpha, rn, mult_op); // alphaqk = alpha*qk
-        ar_scal_op(qkm1, beta, rn, mult_op); // qkm1 = beta*qkm1
-
-        memcpy(r, Aqk, rn*sizeof(double)); // r = Aqk
-        vv_op(r, alphaqk, rn, minus); // r = Aqk - alpha*qk
-        vv_op(r, qkm1, rn, minus); // r = Aqk - alpha*qk - beta*qkm1
-        
-        if (k == 1)
-        {
-            l[0] = alpha;
-            y[0] = 1;
-        }
-        else
-        {
-            double l0 = l[0];
-            double lkm2 = l[k-2];
-            d[0] = 0;
-            for (i=1; i<k; i++) d[i] = l[i-1];
-            d[k] = 0;
-            v[0] = alpha;
-            for (i=1; i<k; i++) v[i] = beta*y[i-1]; // y assumed to be real !!!
-            tdeig(l, y, d, v, k-1);
-            change = fabs(l0 - l[0]) + fabs(lkm2 - l[k-1]);
-        }        
-
-        beta = array_op(r, rn, norm2_op);
-        beta2 = beta*beta;
-        beta = sqrt(beta2);
-        b[nb++] = beta;
-
-        if (beta == 0) {break;}
+        struct lanczos_ctx c = { A, halo, NULL, comm };
+        struct lanczos L = { rn, kmax, 0, 1e-5, 1e-3,
+                             lanczos_ax, lanczos_gsum, &c };
+        c.x = malloc((rn+halo->n+1) * sizeof (double));
+        k = lanczos_eig(l, y, &L, r);
+        free(c.x);
     }
 
     int n = 0;
@@ -875,133 +1320,15 @@ static int lanczos(double **lambda, hypre_CSRMatrix *A)
         {
             (*lambda)[n++] = l[i];
         }
-    }  
+    }
 
     /* Free allocated memory */
     free(r);
-    free(eye);
-    free(qkm1);
-    free(alphaqk);
     free(y);
-    free(a);
-    free(b);
-    free(d);
-    free(v);
-    hypre_SeqVectorDestroy(qk_hyper);
-    hypre_SeqVectorDestroy(Aqk_hyper);
 
     return n;
 }
 
-/* 
-    Minimizes cancellation error (but not round-off ...) 
-*/
-static double sum_3(const double a, const double b, const double c)
-{
-  if     ( (a>=0 && b>=0) || (a<=0 && b<=0) ) return (a+b)+c;
-  else if( (a>=0 && c>=0) || (a<=0 && c<=0) ) return (a+c)+b;
-  else return a+(b+c);
-}
-
-/* 
-    Solve 
-             c
-          - --- + b + a x == 0        with sign(x) = sign
-             x
-*/
-static double rat_root(const double a, const double b, const double c,
-                       const double sign)
-{
-  double bh = (fabs(b) + sqrt(b*b + 4*a*c))/2;
-  return sign * (b*sign <= 0 ? bh/a : c/bh);
-}
-
-/*
-    Find d[ri] <= lambda <= d[ri+1]
-    such that 0 = lambda - v[0] + \sum_i^n v[i]^2 / (d[i] - lambda)
-*/
-#define EPS (128*DBL_EPSILON)
-static double sec_root(double *y, const double *d, const double *v,
-                       const int ri, const int n)
-{
-  double dl = d[ri], dr = d[ri+1], L = dr-dl;
-  double x0l = L/2, x0r = -L/2;
-  int i;
-  double al, ar, bln, blp, brn, brp, cl, cr;
-  double fn, fp, lambda0, lambda;
-  double tol = L;
-  if(fabs(dl)>tol) tol=fabs(dl);
-  if(fabs(dr)>tol) tol=fabs(dr);
-  tol *= EPS;
-  for(;;) {
-    if(fabs(x0l)==0 || x0l < 0) { *y=0; return dl; }
-    if(fabs(x0r)==0 || x0r > 0) { *y=0; return dr; }
-    lambda0 = fabs(x0l) < fabs(x0r) ? dl + x0l : dr + x0r;
-    al = ar = cl = cr = bln = blp = brn = brp = 0;
-    fn = fp = 0;
-    for(i=1;i<=ri;++i) {
-      double den = (d[i]-dl)-x0l;
-      double fac = v[i]/den;
-      double num = sum_3(d[i],-dr,-2*x0r);
-      fn += v[i]*fac;
-      fac *= fac;
-      ar += fac;
-      if(num > 0) brp += fac*num; else brn += fac*num;
-      bln += fac*(d[i]-dl);
-      cl  += fac*x0l*x0l;
-    }
-    for(i=ri+1;i<=n;++i) {
-      double den = (d[i]-dr)-x0r;
-      double fac = v[i]/den;
-      double num = sum_3(d[i],-dl,-2*x0l);
-      fp += v[i]*fac;
-      fac *= fac;
-      al += fac;
-      if(num > 0) blp += fac*num; else bln += fac*num;
-      brp += fac*(d[i]-dr);
-      cr  += fac*x0r*x0r;
-    }
-    if(lambda0>0) fp+=lambda0; else fn+=lambda0;
-    if(v[0]<0) fp-=v[0],blp-=v[0],brp-=v[0];
-          else fn-=v[0],bln-=v[0],brn-=v[0];
-    if(fp+fn > 0) { /* go left */
-      x0l = rat_root(1+al,sum_3(dl,blp,bln),cl,1);
-      lambda = dl + x0l;
-      x0r = x0l - L;
-    } else { /* go right */
-      x0r = rat_root(1+ar,sum_3(dr,brp,brn),cr,-1);
-      lambda = dr + x0r;
-      x0l = x0r + L;
-    }
-    if( fabs(lambda-lambda0) < tol ) {
-      double ty=0, fac;
-      for(i=1;i<=ri;++i) fac = v[i]/((d[i]-dl)-x0l), ty += fac*fac;
-      for(i=ri+1;i<=n;++i) fac = v[i]/((d[i]-dr)-x0r), ty += fac*fac;
-      *y = 1/sqrt(1+ty);
-      return lambda;
-    }
-  }
-}
-
-/*
-    Find eigenvalues
-*/
-static void tdeig(double *lambda, double *y, double *d, const double *v,
-                  const int n)
-{
-  int i;
-  double v1norm = 0, min=v[0], max=v[0];
-  for(i=1;i<=n;++i) {
-    double vi = fabs(v[i]), a=d[i]-vi, b=d[i]+vi;
-    v1norm += vi;
-    if(a<min) min=a;
-    if(b>max) max=b;
-  }
-  d[0]   = v[0] - v1norm < min ? v[0] - v1norm : min;
-  d[n+1] = v[0] + v1norm > max ? v[0] + v1norm : max;
-  for(i=0;i<=n;++i) lambda[i] = sec_root(&y[i],d,v,i,n);
-}
-
 /*
     Dot product between two vectors
 */
@@ -1043,120 +1370,6 @@ static void ar_scal_op(double *a, const double scal, const int n,
     }
 }
 
-/* 
-    Extract diagonal from square sparse matrix 
-*/
-static void diag(double *D, const hypre_CSRMatrix *A)
-{
-    int i; 
-    int rn=A->num_rows;
-    int *row_off = A->i, *col = A->j;
-    double *a = A->data;
-    
-    for(i=0;i<rn;++i) 
-    {
-        int j; 
-        const int jb=row_off[i], je=row_off[i+1];
-        if (jb == je) *D++ = 0.; // A(i,:) is empty -> A(i,i)=0
-        for(j=jb; j<je; ++j) 
-        {  
-            if (col[j] == i) 
-            {
-                *D++ = a[j]; 
-                break;
-            }
-            if (j == je-1) *D++ = 0.; // A(i,i) is not present -> A(i,i)=0
-        }
-    }
-}
-
-/*
-    Addition/subtraction between csr and diagonal matrices
-*/
-static void dpm(hypre_CSRMatrix **AD, hypre_CSRMatrix *A, const double *D,
-    enum dpm_ops op)   
-{
-    int rn = A->num_rows;
-
-    /* Build Hypre IJ diagonal matrix */
-    HYPRE_IJMatrix D_ij;
-	/* Init matrix */
-    HYPRE_IJMatrixCreate(0, 0, rn-1, 0, rn-1, &D_ij);
-    HYPRE_IJMatrixSetObjectType(D_ij, HYPRE_PARCSR);
-    HYPRE_IJMatrixInitialize(D_ij);
-
-    /* Set matrix entries */
-    int i;
-    switch(op)
-    {
-        case(dadd): for (i=0;i<rn;i++) 
-                    {
-		                int ncols=1;
-    	                if (D[i] != 0)
-                        {
-                            HYPRE_IJMatrixSetValues(D_ij, 1, &ncols, &i, &i, 
-                                                    &D[i]);
-                        }
-                    }
-                    break;
-        case(dsub): for (i=0;i<rn;i++) 
-                    {
-		                int ncols=1;
-    	                if (D[i] != 0)
-                        {
-                            double d = -D[i];
-                            HYPRE_IJMatrixSetValues(D_ij, 1, &ncols, &i, &i, 
-                                                    &d);
-                        }
-                    }
-                    break;
-    }
-    HYPRE_IJMatrixAssemble(D_ij);
-
-    /* Build diagonal Hypre CSR matrix */
-    HYPRE_ParCSRMatrix ParD;
-    HYPRE_IJMatrixGetObject(D_ij, (void **) &ParD);
-    hypre_ParCSRMatrix *T = ParD;
-    hypre_CSRMatrix *Dcsr = T->diag;
-    /* Add A and D */
-    *AD = hypre_CSRMatrixAdd(A, Dcsr);
-}
-
-/*
-    Addition/subtraction between csr and diagonal matrices
-*/
-static void dxm(hypre_CSRMatrix *A, const double *D, enum dxm_ops op)
-{
-    int i;
-    int rn = A->num_rows;
-    int *row_off = A->i, *col = A->j;
-    double *a = A->data;
-
-    switch(op)
-    {
-        case(dmult):  for(i=0;i<rn;++i) 
-                      {
-                          int j; 
-                          const int jb=row_off[i], je=row_off[i+1];
-                          for(j=jb; j<je; ++j) 
-                          {       
-                              a[j] = a[j]*D[i];
-                          }
-                      }
-                      break;
-        case(multd):  for(i=0;i<rn;++i) 
-                      {
-                          int j; 
-                          const int jb=row_off[i], je=row_off[i+1];
-                          for(j=jb; j<je; ++j) 
-                          {       
-                              a[j] = a[j]*D[col[j]];
-                          }
-                      }
-                      break;
-    }
-}
-
 /*
     Array operations
 */
@@ -1229,45 +1442,6 @@ static double byteswap(double x)
 #undef N
 }
 
-/*
-    Get size file in number of doubles
-*/
-static long filesize(const char *name) 
-{
-  long n;
-  FILE *f = fopen(name,"r");
-  fseek(f,0,SEEK_END);
-  n = ftell(f)/sizeof(double);
-  fclose(f);
-  return n;
-}
-
-/*
-    Read input files
-*/
-static long readfile(double *data, long max, const char *name)
-{
-  const double magic = 3.14159;
-  long n;
-  FILE *f = fopen(name,"r");
-  
-  fseek(f,0,SEEK_END);
-  n = ftell(f)/sizeof(double);
-  if(n>max) printf("file longer than expected"),n=max;
-  fseek(f,0,SEEK_SET);
-  fread(data,sizeof(double),n,f);
-  fclose(f);
-  if(n>0 && fabs(data[0]-magic)>0.000001) {
-    long i;
-    /*printf("swapping byte order"); */
-    if(fabs(byteswap(data[0])-magic)>0.000001) {
-      printf("magic number for endian test not found");
-    } else
-      for(i=0;i<n;++i) data[i]=byteswap(data[i]);
-  }
-  return n;
-}
-
 /* 
     Print CSR matrix
     For debugging purposes only
@@ -13,123 +13,158 @@ struct csr_mat
 
 /*******************************************************************************
 * Main data structure
+*
+* Every rank holds a contiguous block of the variables (ordered as on one
+* rank). A variable keeps its rank at all levels, hence the level data
+* below refers to the local variables only.
 *******************************************************************************/
 struct amg_setup_data 
 {
-    double *n; // number of variables at each level
-    double *nnz; // number of non zeros of matrix A at each level
-    double *nnzf; // number of non zeros of matrix Af at each level
-    double *nnzfp; // number of non zeros of matrix AfP at each level
+    double *n; // number of local variables at each level
+    double *nnz; // number of local non zeros of matrix A at each level
+    double *nnzf; // number of local non zeros of matrix Af at each level
+    double *nnzfp; // number of local non zeros of matrix AfP at each level
     double *m; // number of Chebyshev iterations at each level
     double *rho; // contraction for one Chebyshev iteration at each level
-    int *idl; // local id (ranges from 0 to # of nonzero lines-1)
+    int ilower; // global index of the first local variable
+    int *idl; // local id (ranges from 0 to # of local nonzero lines-1)
     int *id_l2g; // local to global id (ranges from 1 to max of global id)
     int **idc; // coarse subset of idl
     int **idf; // fine subset of idl
     double **D; // diagonal smoother at each level
     double alast; // A at the last level (one variable only)
-    hypre_CSRMatrix **Af; // Af (fine rows, fine columns) at each level
-    hypre_CSRMatrix **W; // interpolation operator at each level
-    hypre_CSRMatrix **AfP; // AfP at each level
+    int klast; // local id of the last level variable, -1 if not local
+    struct csr_mat **Af; // Af (fine rows, fine columns) at each level
+    struct csr_mat **W; // interpolation operator at each level
+    struct csr_mat **AfP; // AfP at each level
+        // (columns of Af, W and AfP hold global ids)
     int nlevels; // number of levels
     int nullspace; // 0 if no nullspace / 1 otherwise
 };
 
 /*******************************************************************************
-* Algebraic functions
+* Setup options (command line and/or configuration file)
 *******************************************************************************/
-/* 
-    Compute eigenvalues by Lanczos algorithm
+struct amg_options
+{
+    int coarsening; // Hypre coarsening type
+    int interpolation; // Hypre interpolation type
+    int max_levels; // maximum number of levels
+    double tol; // smoother tolerance
+    int print_level; // Hypre print level
+};
+
+/*
+    Set options from defaults, configuration file (-f) and command line
     OUTPUT:
-    - n = number of eigenvalues computed
-    - lambda: array of eigenvalues
+    - opt: options
+    - returns 0 on success, 1 if the setup should not be run
     INPUT:
-    - A: matrix
+    - argc, argv: command line arguments
 */
-static int lanczos(double **lambda, hypre_CSRMatrix *A);
+static int get_options(struct amg_options *opt, int argc, char *argv[]);
 
-/* 
-    Extract sub-matrix: 
-    OUTPUT:    
-    - subA = A(idr, idc)
-    INPUT:
-    - A: original matrix of dim. rn x cn
-    - idr: if idr[i] < 0, i=0...rn-1 -> keep row i in subA
-    - idc: if idc[j] < 0, j=0...cn-1 -> keep column j in subA
+/*
+    Read options from a configuration file, one "key value" per line
+    (keys: coarsening, interpolation, levels, tolerance, print_level)
 */
-static void sub_mat(hypre_CSRMatrix **subA, const hypre_CSRMatrix *A, 
-    const int* idr, const int *idc);
+static int read_options(struct amg_options *opt, const char *name);
 
-/* 
-    Extract diagonal from square sparse matrix 
-    OUTPUT:
-    - D: array of double containing diagonal of A
-    INPUT:
-    - A: matrix from which to extract diagonal
+/*******************************************************************************
+* Distributed data
+*******************************************************************************/
+/*
+    Lookup of the values of a block distributed array at a list of global
+    indices. Rank p owns the indices starts[p] ... starts[p+1]-1. The
+    communication pattern is set up once and can be applied repeatedly.
 */
-static void diag(double *D, const hypre_CSRMatrix *A);
+struct lookup
+{
+    MPI_Comm comm;
+    int n; // number of requested indices
+    int *qcnt, *qdsp; // requests sent to each rank
+    int na; // number of requests answered
+    int *acnt, *adsp; // requests answered for each rank
+    int *aidx; // local index of each answered request
+    int *perm; // position in the input list of each sorted request
+};
 
 /*
-    Multiplication between csr and diagonal matrices
-    OUTPUT:
-    - A: A=A*D or A=D*A
-    INPUT:
-    - A: matrix
-    - D: array of doubles representing the diagonal
-    - op: operation to be performed (A*D or D*A)
+    Set up lookup lk for the n global indices gidx
+*/
+static void lookup_setup(struct lookup *lk, const int *starts, const int n,
+    const int *gidx, MPI_Comm comm);
+
+/*
+    out[i] = val(gidx[i]) where val is the local part of the distributed
+    array (elements of MPI type 'type')
 */
-enum dxm_ops {dmult, multd}; // A = {D*A, A*D}
-static void dxm(hypre_CSRMatrix *A, const double *D, enum dxm_ops op);
+static void lookup_exec(const struct lookup *lk, void *out, const void *val,
+    MPI_Datatype type);
+
+static void lookup_free(struct lookup *lk);
 
 /*
-    Addition/subtraction between csr and diagonal matrices
+    Partition of a distributed array with n local entries
     OUTPUT:
-    - AD: AD = A +/- D
-    INPUT:
-    - A: matrix
-    - D: array of doubles representing the diagonal
-    - op: operation to be performed (addition of subtraction)
+    - returns starts(np+1), starts[p] = global index of first entry of p
 */
-enum dpm_ops {dadd, dsub}; // A = {A+D, A-D}
-static void dpm(hypre_CSRMatrix **AD, hypre_CSRMatrix *A, const double *D,
-    enum dpm_ops op);
+static int *part_starts(const int n, MPI_Comm comm);
 
 /*
-    tdeig: find the eigenvalues of
-  
-      d[1]           v[1]
-             d[2]      v[2]
-              d[n] v[n]
-      v[1] v[2] v[n] v[0]
-  
-      sets d[0], d[n+1] to Gershgorin bounds
-  
-      also gives (n+1)th component of each orthonormal eigenvector in y
+    Fetch rows gidx[0...n-1] of the row distributed matrix M
+    (rows of rank p start at starts[p]); out->col holds global columns
 */
-static void tdeig(double *lambda, double *y, double *d, const double *v,
-                  const int n);
+static void fetch_rows(struct csr_mat *out, const struct csr_mat *M,
+    const int *starts, const int n, const int *gidx, MPI_Comm comm);
 
 /*
-    Find d[ri] <= lambda <= d[ri+1]
-    such that 0 = lambda - v[0] + \sum_i^n v[i]^2 / (d[i] - lambda)
+    Replace the (global) column indices of M by val(col)
 */
-static double sec_root(double *y, const double *d, const double *v,
-                       const int ri, const int n);
+static void relabel(struct csr_mat *M, const int *starts, const int *val,
+    MPI_Comm comm);
 
-/* 
-    Solve 
-             c
-          - --- + b + a x == 0        with sign(x) = sign
-             x
+/*
+    Distribute the dump entries to the owners of their rows and build the
+    IJ matrix from the nonzero rows
+*/
+static void build_matrix(HYPRE_IJMatrix *ij_matrix,
+    struct amg_setup_data *data, const int ne, const double *Aid,
+    const double *Ajd, const double *Av, MPI_Comm comm);
+
+/*
+    Extract W, Af, AfP and compute the smoother of level lvl
+    INPUT:
+    - A, P: matrix and interpolation operator at level lvl
+    - CF: coarse/fine marker of the local rows (1 = coarse)
+    - tol: smoother tolerance
 */
-static double rat_root(const double a, const double b, const double c,
-                       const double sign);
+static void amg_level(struct amg_setup_data *data, const int lvl,
+    hypre_ParCSRMatrix *A, hypre_ParCSRMatrix *P, const int *CF,
+    const double tol, MPI_Comm comm);
 
+/*******************************************************************************
+* Algebraic functions
+*******************************************************************************/
 /* 
-    Minimizes cancellation error (but not round-off ...) 
-    OUTPUT: a + b + c 
+    Compute eigenvalues by Lanczos algorithm
+    OUTPUT:
+    - n = number of eigenvalues computed
+    - lambda: array of eigenvalues
+    INPUT:
+    - A: local rows of the matrix, columns >= A->rn refer to the halo
+    - halo: lookup of the halo values
+*/
+static int lanczos(double **lambda, const struct csr_mat *A,
+    const struct lookup *halo, MPI_Comm comm);
+
+/*
+    y = A*x, x holds the local values followed by the halo
 */
-static double sum_3(const double a, const double b, const double c);
+static void csr_matvec(double *y, const struct csr_mat *A, const double *x);
+
+static void csr_alloc(struct csr_mat *A, const int rn, const int nnz);
+static void csr_free(struct csr_mat *A);
 
 /*
     Chebsim: computes number of iteration and contraction factor for the    
@@ -224,29 +259,22 @@ static void ar_scal_op(double *a, const double scal, const int n,
     INPUT:
     - structure data
 */
-static void amg_export(const struct amg_setup_data *data);
+static void amg_export(const struct amg_setup_data *data, MPI_Comm comm);
 
 /*
-    Save matrices
+    Save matrices (every rank writes the rows of its variables)
     OUTPUT:
     - file 'filename' with matrix data
     - len(n): length of each row
     INPUT:
     - nl: number of levels
-    - n: number of points
+    - n: number of local points
     - lvl(n): last level at which each point appears
-    - id(nl, n(l)): local id for each row
-    - id_l2g(n): local to global id converter
     - mat(nl): array pointing to matrices of the different levels
     - filename: name of the file
 */
 static void savemats(int *len, const int n, const int nl, const int *lvl, 
-    int **id, const int *id_l2g, hypre_CSRMatrix **mat, const char *filename);
-
-/* 
-    Returns max number of non zero elements on a row
-*/
-static int max_row_nnz(const hypre_CSRMatrix *mat);
+    struct csr_mat **mat, const char *filename, MPI_Comm comm);
 
 /*
     Save vectors
@@ -255,7 +283,7 @@ static int max_row_nnz(const hypre_CSRMatrix *mat);
     INPUT:
     - nl: number of levels
     - data: data with all info about setup
-    - n: number of points
+    - n: number of local points
     - lvl(n): last level at which each point appears
     - W_len(n), Aff_len(n), AfP_len(n): length of each row of corresponding matrix
     - dvec(n): diagonal smoother for each point
@@ -263,7 +291,16 @@ static int max_row_nnz(const hypre_CSRMatrix *mat);
 */
 static void savevec(const int nl, const struct amg_setup_data *data, 
     const int n, const int *lvl, const int *W_len, const int *AfP_len, 
-    const int *Aff_len, const double *dvec, const const char *filename);
+    const int *Aff_len, const double *dvec, const char *filename,
+    MPI_Comm comm);
+
+/*
+    Write a file in parallel: rank 0 writes hdr(nh), every rank writes
+    buf(n) at offset nh+off (in doubles)
+*/
+static void write_par(const char *filename, const double *hdr, const int nh,
+    const double *buf, const long long n, const long long off,
+    MPI_Comm comm);
 
 /*
     Swap bytes for big endian / small endian consistency
@@ -271,14 +308,14 @@ static void savevec(const int nl, const struct amg_setup_data *data,
 static double byteswap(double x);
 
 /*
-    Get size file in number of doubles
+    Get size file in number of doubles, -1 if the file cannot be opened
 */
 static long filesize(const char *name);
 
 /*
-    Read input files
+    Read n doubles starting at entry off of an input file
 */
-static long readfile(double *data, long max, const char *name);
+static long readfile(double *data, long off, long n, const char *name);
 
 /*******************************************************************************
 * For debugging purposes only
@@ -4,15 +4,15 @@
 #include "matrix.h"
 #include "cinterp_common.h"
 
+/* the columns of X are independent: they are computed in parallel (with
+   OpenMP), each thread using its own slice of the persistent workspace */
 static void interp(const sp_mat *X, const sp_mat_c *A, const sp_mat_c *B,
                    const double *u, const double *lambda)
 {
-  mwSize nf = X->m, nc = X->n;
-  mwSize max_nz=0, max_Q;
-  mwIndex j;
-  
-  double *sqv1, *sqv2;
-  double *Q, *QQt;
+  mwSize nc = X->n;
+  mwSize max_nz=0, max_Q, wsn;
+  mwSignedIndex j;
+  char *ws; int fresh;
   
   for(j=0;j<nc;++j) {
     mwSize nz=X->jc[j+1]-X->jc[j];
@@ -20,10 +20,15 @@ static void interp(const sp_mat *X, const sp_mat_c *A, const sp_mat_c *B,
   }
   max_Q = (max_nz*(max_nz+1))/2;
   
-  sqv1 = mem_alloc((2*max_nz + max_Q)*sizeof(double));
-  sqv2 = sqv1+max_nz, Q = sqv2+max_nz;
+  wsn = WS_ALIGN((2*max_nz + max_Q)*sizeof(double));
+  ws = ws_get(num_threads()*wsn,0,0,&fresh);
 
-  for(j=0;j<nc;++j) {
+#ifdef _OPENMP
+# pragma omp parallel for schedule(dynamic,64)
+#endif
+  for(j=0;j<(mwSignedIndex)nc;++j) {
+    double *sqv1 = (double*)(ws+thread_id()*wsn);
+    double *sqv2 = sqv1+max_nz, *Q = sqv2+max_nz;
     mwIndex xjc = X->jc[j];
     const mwIndex *Qi = &X->ir[xjc];
     mwSize nz = X->jc[j+1]-xjc;
@@ -57,7 +62,7 @@ static void interp(const sp_mat *X, const sp_mat_c *A, const sp_mat_c *B,
     /* X e_j := Q Q^t (B e_j + u_j lambda) */
     mv_ut(&X->pr[xjc], nz,Q, sqv2);
   }
-  mem_free(sqv1);
+  ws_done();
 }
 
 /* A, B, u, lambda, X_skel */
@@ -57,6 +57,61 @@ typedef struct {
   static void mem_free(void *p) { mxFree(p); }
 #endif
 
+/*--------------------------------------------------------------------------
+   persistent workspace
+   
+   ws_get(n,k1,k2,&fresh) returns a block of at least n bytes that is kept
+   between calls of the mex function, so repeated calls on the same level
+   neither allocate nor reinitialize their work arrays.
+   (k1,k2) is the layout key of the block (e.g. problem size and number
+   of threads): fresh is set to 1 when the contents are undefined (new
+   block, other layout key, or the last call did not get to ws_done, e.g.
+   after a memory error); the caller then initializes the block, and
+   restores that state before calling ws_done.  "clear mex" frees it.
+--------------------------------------------------------------------------*/
+static void *ws_ptr = 0;
+static size_t ws_size = 0, ws_key[2] = {0,0};
+static int ws_clean = 0;
+
+static void ws_free(void)
+{
+  if(ws_ptr) mxFree(ws_ptr);
+  ws_ptr = 0, ws_size = 0, ws_clean = 0;
+}
+
+static void *ws_get(size_t n, size_t k1, size_t k2, int *fresh)
+{
+  static int registered = 0;
+  if(n>ws_size) {
+    ws_free();
+    ws_ptr = mem_alloc(n);
+    mexMakeMemoryPersistent(ws_ptr);
+    ws_size = n;
+    if(!registered) mexAtExit(ws_free), registered = 1;
+  }
+  if(k1!=ws_key[0] || k2!=ws_key[1])
+    ws_clean = 0, ws_key[0] = k1, ws_key[1] = k2;
+  *fresh = !ws_clean, ws_clean = 0;
+  return ws_ptr;
+}
+
+static void ws_done(void) { ws_clean = 1; }
+
+/* threads used by the column parallel loops
+   (compile with the OpenMP flag, e.g. mex CFLAGS='$CFLAGS -fopenmp'
+    LDFLAGS='$LDFLAGS -fopenmp', to enable) */
+#ifdef _OPENMP
+#  include <omp.h>
+   static int num_threads(void) { return omp_get_max_threads(); }
+   static int thread_id(void) { return omp_get_thread_num(); }
+#else
+   static int num_threads(void) { return 1; }
+   static int thread_id(void) { return 0; }
+#endif
+
+/* round up to a multiple of 64 bytes, keeps per thread blocks apart */
+#define WS_ALIGN(n) ((((size_t)(n))+63)&~(size_t)63)
+
 /* Upper triangular transpose matrix vector product
    y[0] = U[0] * x[0]
    y[1] = U[1] * x[0] + U[2] * x[1]
@@ -35,6 +35,7 @@ static int interp_lmop(const sp_mat *T, const sp_mat_c *A, const double *u,
   
   double *sqv1, *sqv2;
   double *Q, *QQt;
+  int fresh;
   
   for(j=0;j<nc;++j) {
     mwSize nz=X_skel->jc[j+1]-X_skel->jc[j];
@@ -42,8 +43,10 @@ static int interp_lmop(const sp_mat *T, const sp_mat_c *A, const double *u,
   }
   max_Q = (max_nz*(max_nz+1))/2;
   
-  if(!(sqv1=mem_alloc((2*max_nz + max_Q + max_nz*max_nz)*sizeof(double))))
-    return 0;
+  /* serial: the columns of X update overlapping entries of T */
+  sqv1 = ws_get((2*max_nz + max_Q + max_nz*max_nz)*sizeof(double),
+                0,0,&fresh);
+  if(!sqv1 && max_nz>0) return 0;
   sqv2 = sqv1+max_nz, Q = sqv2+max_nz, QQt = Q+max_Q;
 
   { mwIndex nz=T->jc[nf]; for(j=0;j<nz;++j) T->pr[j]=0; }
@@ -84,7 +87,7 @@ static int interp_lmop(const sp_mat *T, const sp_mat_c *A, const double *u,
       sp_add(T->jc[i+1]-ti,&T->ir[ti],&T->pr[ti], uj, nz,Qi,qk);
     }
   }
-  mem_free(sqv1);
+  ws_done();
   return 1;
 }
 
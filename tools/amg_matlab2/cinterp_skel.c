@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "mex.h"
@@ -19,27 +20,28 @@
    y := A * x
    
    the sparse vector x may have unsorted indices
-   the sparse output y will have sorted indices
+   the nonzero indices of y are returned, unsorted, in yi,
+   their values are left in the accumulator: y[yi[k]] = sv[yi[k]]
    the return value is nnz(y)
    y is set to 0 where mask >= 0
    
-   yi, y assumed big enough to store the result
+   yi assumed big enough to store the result
    mask, sv, flag must be of length A->m
-   flag must be 0 on input and will be 0 on output
+   flag must be 0 on input, and is 1 at yi on output
+   (resid_update clears it)
 ----------------------------------------------------------------------------
    Implementation:
    
-   A non-sparse version of y is built by summing columns of A times the
-   corresponding x component. The components of y that get set are added
-   to a heap structure, which gets sorted at the end. "flag" records which
-   components have already been set, so that the heap will not contain
-   duplicates.
+   A non-sparse version of y is built in sv by summing columns of A times
+   the corresponding x component (a sparse accumulator). "flag" records
+   which components have already been set, so that yi will not contain
+   duplicates. Nothing is sorted here; see resid_update.
 --------------------------------------------------------------------------*/
-static mwSize sp_mv(mwIndex *yi, double *y, const sp_mat_c *A,
+static mwSize sp_mv(mwIndex *yi, const sp_mat_c *A,
                     mwSize xn, const mwIndex *xi, const double *x,
                     double *sv, char *flag, const mwSignedIndex *mask)
 {
-  mwSize yn=0; mwIndex *heap = yi-1, hi;
+  mwSize yn=0;
   const mwIndex *const xe=xi+xn;
   for(;xi!=xe;++xi,++x) {
     mwIndex j=*xi; double xj=*x;
@@ -52,94 +54,81 @@ static mwSize sp_mv(mwIndex *yi, double *y, const sp_mat_c *A,
 #ifndef IGNORE_MASK
       if(mask[i]>=0) continue;
 #endif
-      if(flag[i]==0) {
-        mwIndex hole = ++yn;
-        while(hole>1) {
-          mwIndex parent=hole>>1, ip=heap[parent];
-          if(i<ip) break;
-          heap[hole]=ip, hole=parent;
-        }
-        heap[hole]=i;
-        flag[i]=1, sv[i]=0;
-      }
+      if(flag[i]==0) yi[yn++]=i, flag[i]=1, sv[i]=0;
       sv[i] += (*Apr)*xj;
     }
   }
-  for(hi=yn;hi>1;--hi) {
-    mwIndex i=heap[hi], hole=1;
-    heap[hi] = heap[1];
-    /* heap size = hi - 1 */
+  return yn;
+}
+
+static void heap_sort(mwSize un, mwIndex *uv)
+{
+  mwIndex *heap = uv-1, i;
+  for(i=2;i<=un;++i) if(heap[i]>heap[i>>1]) {
+    mwIndex hole=i, v=heap[i];
+    do {
+      mwIndex parent=hole>>1, vp=heap[parent];
+      if(v<vp) break;
+      heap[hole]=vp, hole=parent;
+    } while(hole>1);
+    heap[hole]=v;
+  }
+  for(i=un;i>1;--i) {
+    mwIndex v=heap[i], hole=1;
+    heap[i] = heap[1];
+    /* heap size = i - 1 */
     for(;;) {
-      mwIndex child=hole<<1, r=child+1, ic;
-      if(r<hi && heap[r]>heap[child]) child=r;
-      if(child>=hi || (ic=heap[child],i>=ic)) break;
-      heap[hole]=ic, hole=child;
+      mwIndex child=hole<<1, r=child+1, vc;
+      if(r<i && heap[r]>heap[child]) child=r;
+      if(child>=i || (vc=heap[child],v>=vc)) break;
+      heap[hole]=vc, hole=child;
     }
-    heap[hole]=i;
+    heap[hole]=v;
   }
-  for(hi=0;hi<yn;++hi) y[hi]=sv[yi[hi]], flag[yi[hi]]=0;
-  return yn;
 }
 
-/* sets r := x - alpha * y,    with r,x,y all sparse
+/* sets r := x - alpha * y,    with r,x sparse and sorted,
+                                y as returned by sp_mv (yi, sv, flag)
    also, sets beta := beta + y .* y,
        where beta is not sparse,
        but is only initialized where x is defined
    sets r to 0 where mask >= 0
+   
+   inr flags the pattern of x on input, and of r on output;
+   only the indices of y outside x are sorted (in yi, which is
+   overwritten), before being merged with x
+   flag is 0 on output
 */
 static mwSize resid_update(mwIndex *ri, double *rp, double *beta,
                            mwSize xn, const mwIndex *xi, const double *xp,
                            double alpha,
-                           mwSize yn, const mwIndex *yi, const double *yp,
+                           mwSize yn, mwIndex *yi, const double *sv,
+                           char *flag, char *inr,
                            const mwSignedIndex *mask)
 {
-  const mwIndex *const xe = xi+xn, *const ye = yi+yn;
-  mwSize rnz = 0;
-  if(xi!=xe && yi!=ye) {
-    mwIndex ix=*xi, iy=*yi;
-    for(;;) {
-      if(ix<iy) {
-#ifndef IGNORE_MASK
-        if(mask[ix]<0)
-#endif        
-          ++rnz, *ri++=ix, *rp++ = *xp;
-        ++xi,++xp; if(xi==xe) break; ix=*xi;
-      } else if(ix>iy) {
-        double y = *yp;
-        beta[iy] = y*y;
-#ifndef IGNORE_MASK
-        if(mask[iy]<0)
-#endif        
-          ++rnz, *ri++=iy, *rp++ = -alpha*y;
-        ++yi,++yp; if(yi==ye) break; iy=*yi;
-      } else { /* ix==iy */
-        double y = *yp;
-        beta[iy] += y*y;
-#ifndef IGNORE_MASK
-        if(mask[iy]<0)
-#endif        
-          ++rnz, *ri++=iy, *rp++ = *xp - alpha*y;
-        ++xi,++xp; ++yi,++yp;
-        if(xi==xe || yi==ye) break;
-        ix=*xi, iy=*yi;
-      }
-    }
+  const mwIndex *const xe = xi+xn, *ni=yi, *ne;
+  mwIndex *const ri0 = ri;
+  mwSize rnz = 0, nn = 0, k;
+  for(k=0;k<yn;++k) { /* beta, and collect the new indices */
+    mwIndex i = yi[k]; double y = sv[i];
+    if(inr[i]) beta[i] += y*y;
+    else       beta[i]  = y*y, yi[nn++] = i;
   }
-  while(xi!=xe) {
-    mwIndex ix = *xi++; double x = *xp++;
+  heap_sort(nn,yi), ne = yi+nn;
+  for(k=0;k<xn;++k) inr[xi[k]] = 0;
+  while(xi!=xe || ni!=ne) {
+    mwIndex i; double v;
+    if(ni==ne || (xi!=xe && *xi<*ni)) {
+      i = *xi++, v = *xp++;
+      if(flag[i]) v -= alpha*sv[i], flag[i]=0;
+    } else
+      i = *ni++, v = -alpha*sv[i], flag[i]=0;
 #ifndef IGNORE_MASK
-    if(mask[ix]<0)
-#endif        
-      ++rnz, *ri++ = ix, *rp++ = x;
-  }
-  while(yi!=ye) {
-    mwIndex iy = *yi++; double y = *yp++;
-    beta[iy] = y*y;
-#ifndef IGNORE_MASK
-    if(mask[iy]<0)
-#endif        
-      ++rnz, *ri++ = iy, *rp++ = -alpha*y;
+    if(mask[i]<0)
+#endif
+      ++rnz, *ri++ = i, *rp++ = v;
   }
+  for(k=0;k<rnz;++k) inr[ri0[k]] = 1;
   return rnz;
 }
 
@@ -160,46 +149,29 @@ static void print_veci(const char *name, int n, const int *i)
 }
 #endif
 
-static void heap_sort(mwSize un, mwIndex *uv)
+/* the columns j0 <= j < j1 of X_skel, computed by one thread */
+typedef struct {
+  mwIndex j0, j1;
+  mwSize nzmax;
+  mwIndex *ir, *jc; /* jc[j-j0], malloc'd (not mxMalloc: thread safe) */
+} skel_part;
+
+/* per thread work arrays: beta, rp, Aqk_p, sp, ri, Aqk_i, si, map_to_Qi,
+   flag, inr (each of length nf) */
+static size_t skel_ws_size(mwSize nf)
 {
-  mwIndex *heap = uv-1, i;
-  for(i=2;i<=un;++i) if(heap[i]>heap[i>>1]) {
-    mwIndex hole=i, v=heap[i];
-    do {
-      mwIndex parent=hole>>1, vp=heap[parent];
-      if(v<vp) break;
-      heap[hole]=vp, hole=parent;
-    } while(hole>1);
-    heap[hole]=v;
-  }
-  for(i=un;i>1;--i) {
-    mwIndex v=heap[i], hole=1;
-    heap[i] = heap[1];
-    /* heap size = i - 1 */
-    for(;;) {
-      mwIndex child=hole<<1, r=child+1, vc;
-      if(r<i && heap[r]>heap[child]) child=r;
-      if(child>=i || (vc=heap[child],v>=vc)) break;
-      heap[hole]=vc, hole=child;
-    }
-    heap[hole]=v;
-  }
+  return WS_ALIGN(nf*(4*sizeof(double)+3*sizeof(mwIndex)
+                      +sizeof(mwSignedIndex)+2*sizeof(char)));
 }
 
-/* computes, column-wise, a sparse minimizer X of
-  
-   f = .5 X^t A X - B^t X
-  
-   assumes D = diag(A)
-   sets X_skel := sparsity pattern of X
-        X_sum := X * u
-   tol controls sparsity */
-static void interp_skel(sp_log_mat *X_skel, double *X_sum,
-                        const sp_mat_c *A, const sp_mat_c *B,
-                        const double *D, const double *u, double tol)
+static void skel_cols(skel_part *P, double *X_sum,
+                      const sp_mat_c *A, const sp_mat_c *B,
+                      const double *D, const double *u, double tol,
+                      char *ws)
 {
-  mwSize nf = B->m, nc = B->n;
-  mwIndex iri, *irp, *jcp; /* irp = &W->ir[iri], jcp = &W->jc[j] */
+  mwSize nf = B->m;
+  mwIndex j0 = P->j0, j1 = P->j1;
+  mwIndex iri, *irp, *jcp; /* irp = &P->ir[iri], jcp = &P->jc[j-j0] */
   mwIndex j;
   
   int max_Q; double *Q; /* local triangular A-orthonormal basis */
@@ -207,39 +179,30 @@ static void interp_skel(sp_log_mat *X_skel, double *X_sum,
                            only defined where r is nonzero */
   mwSize rnz; mwIndex *ri; double *rp; /* residual r = (I - A Q Q^t) B e_j */
   mwSize Aqk_nz; mwIndex *Aqk_i; double *Aqk_p; /* A Q e_k .... (almost) */
-  mwSize snz; mwIndex *si; double *sp; /* sparse scratch vector */
+  mwIndex *si; double *sp; /* sparse scratch vector */
   mwSignedIndex *map_to_Qi;
     /* the inverse of the map Qi[k], -1 where not defined */
   char *flag; /* used by sp_mv; always zero outside that routine */
+  char *inr;  /* the pattern of r; always zero between columns */
   
-#if STOP_TEST == 1
-  tol *= .5*tol;
-#elif STOP_TEST == 2
-  tol *= .5;
-#endif
-
-  /* initialize the X_skel structure */
-  X_skel->m = nf, X_skel->n = nc;
-  X_skel->nzmax = 2*B->jc[nc]; /* initial guess: nnz(X_skel) = 2*nnz(B) */
-  X_skel->jc = mem_alloc((X_skel->n+1)*sizeof(mwIndex));
-  X_skel->ir = mem_alloc(X_skel->nzmax*sizeof(mwIndex));
+  /* initialize the P structure */
+  P->nzmax = 2*(B->jc[j1]-B->jc[j0]); /* initial guess: 2*nnz(B) */
+  if(P->nzmax<1) P->nzmax=1;
+  P->jc = malloc((j1-j0+1)*sizeof(mwIndex));
+  P->ir = malloc(P->nzmax*sizeof(mwIndex));
   
-  /* allocate memory */
-  beta = mem_alloc(4*nf*sizeof(double));
+  /* carve the work arrays (see skel_ws_size) */
+  beta = (double*)ws;
   rp = beta+nf, Aqk_p=rp+nf, sp=Aqk_p+nf;
-  ri = mem_alloc(4*nf*sizeof(mwIndex));
-  Aqk_i = ri+nf, si=Aqk_i+nf, map_to_Qi=si+nf;
-  flag = mem_alloc(nf*sizeof(char));
+  ri = (mwIndex*)(sp+nf);
+  Aqk_i = ri+nf, si=Aqk_i+nf;
+  map_to_Qi = (mwSignedIndex*)(si+nf);
+  flag = (char*)(map_to_Qi+nf), inr = flag+nf;
   /* initial guess: no column will have nnz > 35 */
-  max_Q=35; Q = mem_alloc(max_Q*(max_Q+1)*sizeof(double)/2);
+  max_Q=35; Q = malloc(max_Q*(max_Q+1)*sizeof(double)/2);
   
-  /* initialize work arrays */
-  memset(flag,0,nf*sizeof(char));
-  for(j=0;j<nf;++j) map_to_Qi[j] = -1;
-  for(j=0;j<nf;++j) X_sum[j]=0;
-
-  irp = X_skel->ir, iri=0; jcp = X_skel->jc;
-  for(j=0;j<nc;++j) { /* working on column j of X */
+  irp = P->ir, iri=0; jcp = P->jc;
+  for(j=j0;j<j1;++j) { /* working on column j of X */
     int m; /* multi-use loop index */
     mwIndex mm;
     int k=0; /* working on the (k+1)th nonzero for this column,
@@ -265,10 +228,11 @@ static void interp_skel(sp_log_mat *X_skel, double *X_sum,
     memcpy(rp, &B->pr[B->jc[j]], rnz*sizeof(double));
     /* initialize beta, and use residual to find s, norm */
     s=ri[0], beta[s]=0, w=rp[0]/sqrt(D[s]), norm=fabs(rp[0]/D[s]);
+    inr[s]=1;
     for(m=1;m<rnz;++m) {
       mwIndex i=ri[m]; double r=rp[m],d=D[i];
       double tw=r/sqrt(d), tn=fabs(r/d);
-      beta[i]=0;
+      beta[i]=0, inr[i]=1;
       if(fabs(tw)>fabs(w)) w=tw,s=i;
 #if STOP_TEST == 1
       if(tn>norm) norm=tn;
@@ -281,16 +245,16 @@ static void interp_skel(sp_log_mat *X_skel, double *X_sum,
       mexPrintf(".");
 #endif
       /* check if we underestimated nnz(X_skel) */
-      if(iri==X_skel->nzmax) {
-        ptrdiff_t d = Qi - X_skel->ir;
-        X_skel->nzmax*=2;
-        X_skel->ir=mem_realloc(X_skel->ir,X_skel->nzmax*sizeof(mwIndex));
-        irp=X_skel->ir+iri, Qi=X_skel->ir+d;
+      if(iri==P->nzmax) {
+        ptrdiff_t d = Qi - P->ir;
+        P->nzmax*=2;
+        P->ir=realloc(P->ir,P->nzmax*sizeof(mwIndex));
+        irp=P->ir+iri, Qi=P->ir+d;
       }
       /* check if we underestimated dim(Q) */
       if(k+1>max_Q) {
         ptrdiff_t d = qk-Q;
-        max_Q*=2, Q=mem_realloc(Q,max_Q*(max_Q+1)*sizeof(double)/2);
+        max_Q*=2, Q=realloc(Q,max_Q*(max_Q+1)*sizeof(double)/2);
         qk = Q+d;
       }
       /* record new non-zero in W, (which updates Qi), update the inverse map */
@@ -329,15 +293,13 @@ static void interp_skel(sp_log_mat *X_skel, double *X_sum,
            but e_s^t r will be 0, so we don't care
            the other masked components are the previous nonzeros,
              for which A Q e_k is 0 because Q is A-orthogonal */
-      Aqk_nz = sp_mv(Aqk_i,Aqk_p, A, k+1,Qi,qk, sp,flag,map_to_Qi);
-#if DEBUG_LEVEL > 4
-      print_vec("A Q e_k",Aqk_nz,Aqk_i,Aqk_p);
-#endif
+      Aqk_nz = sp_mv(Aqk_i, A, k+1,Qi,qk, Aqk_p,flag,map_to_Qi);
       /* r := r - w Aqk, beta := beta + Aqk .* Aqk */
       memcpy(si, ri, rnz*sizeof(mwIndex));
       memcpy(sp, rp, rnz*sizeof(double));
       rnz = resid_update(ri,rp, beta, rnz,si,sp, w, Aqk_nz,Aqk_i,Aqk_p,
-                         map_to_Qi); /* the mask ensures e_s^t r = 0 */
+                         flag,inr, map_to_Qi);
+                         /* the mask ensures e_s^t r = 0 */
 #if DEBUG_LEVEL > 3
       print_vec("r",rnz,ri,rp);
 #endif
@@ -363,12 +325,89 @@ static void interp_skel(sp_log_mat *X_skel, double *X_sum,
     print_veci("Qi",k,Qi);
 #endif
     for(m=0;m<k;++m) map_to_Qi[Qi[m]] = -1;
+    for(mm=0;mm<rnz;++mm) inr[ri[mm]] = 0;
 #ifdef VERBOSE_PROGRESS
     mexPrintf("\n");
 #endif
   }
   *jcp++ = iri;
-  mem_free(Q); mem_free(flag); mem_free(ri); mem_free(beta);  
+  free(Q);
+}
+
+/* computes, column-wise, a sparse minimizer X of
+  
+   f = .5 X^t A X - B^t X
+  
+   assumes D = diag(A)
+   sets X_skel := sparsity pattern of X
+        X_sum := X * u
+   tol controls sparsity
+   
+   the columns are split into one contiguous block per thread, each with
+   its own work arrays and X_sum partial; the blocks are joined, and the
+   partials summed, in block order (the result only depends on the
+   number of threads, and is that of the serial code for one thread) */
+static void interp_skel(sp_log_mat *X_skel, double *X_sum,
+                        const sp_mat_c *A, const sp_mat_c *B,
+                        const double *D, const double *u, double tol)
+{
+  mwSize nf = B->m, nc = B->n, nz;
+  size_t wsn = skel_ws_size(nf);
+  int nt = num_threads(), t, fresh;
+  char *ws; double *Xs; skel_part *P;
+  mwIndex j;
+  
+#if STOP_TEST == 1
+  tol *= .5*tol;
+#elif STOP_TEST == 2
+  tol *= .5;
+#endif
+
+  if(nt>(int)nc) nt = nc>0 ? nc : 1;
+  
+  /* work arrays, kept between calls with map_to_Qi = -1, flag = inr = 0;
+     their position in the block depends on nf and nt */
+  ws = ws_get(nt*wsn,nf,nt,&fresh);
+  if(fresh) for(t=0;t<nt;++t) {
+    char *w = ws+t*wsn;
+    mwSignedIndex *map_to_Qi = (mwSignedIndex*)
+                               (w+nf*(4*sizeof(double)+3*sizeof(mwIndex)));
+    char *flag = (char*)(map_to_Qi+nf);
+    for(j=0;j<nf;++j) map_to_Qi[j] = -1;
+    memset(flag,0,2*nf*sizeof(char));
+  }
+  Xs = nt>1 ? mem_alloc((nt-1)*nf*sizeof(double)) : 0;
+  for(j=0;j<nf;++j) X_sum[j]=0;
+  for(j=0;j<(nt-1)*nf;++j) Xs[j]=0;
+  P = mem_alloc(nt*sizeof(skel_part));
+  for(t=0;t<nt;++t) P[t].j0 = nc*t/nt, P[t].j1 = nc*(t+1)/nt;
+
+#ifdef _OPENMP
+# pragma omp parallel for num_threads(nt) schedule(static,1)
+#endif
+  for(t=0;t<nt;++t)
+    skel_cols(&P[t], t==0 ? X_sum : Xs+(t-1)*nf, A,B,D,u,tol, ws+t*wsn);
+  
+  for(t=1;t<nt;++t) {
+    const double *x = Xs+(t-1)*nf;
+    for(j=0;j<nf;++j) X_sum[j] += x[j];
+  }
+  
+  /* join the blocks */
+  for(nz=0,t=0;t<nt;++t) nz += P[t].jc[P[t].j1-P[t].j0];
+  X_skel->m = nf, X_skel->n = nc, X_skel->nzmax = nz>0 ? nz : 1;
+  X_skel->jc = mem_alloc((nc+1)*sizeof(mwIndex));
+  X_skel->ir = mem_alloc(X_skel->nzmax*sizeof(mwIndex));
+  for(nz=0,t=0;t<nt;++t) {
+    mwIndex j0 = P[t].j0, n = P[t].jc[P[t].j1-j0];
+    for(j=j0;j<P[t].j1;++j) X_skel->jc[j] = nz + P[t].jc[j-j0];
+    memcpy(X_skel->ir+nz, P[t].ir, n*sizeof(mwIndex));
+    nz += n;
+    free(P[t].ir), free(P[t].jc);
+  }
+  X_skel->jc[nc] = nz;
+  ws_done();
+  mem_free(P); if(Xs) mem_free(Xs);
 }
 
 /* A, B, D, u, tol */
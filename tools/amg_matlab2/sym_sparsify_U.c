@@ -9,7 +9,30 @@ static void *mem_alloc(size_t n)
   return ptr;
 }
 
-typedef struct { mwIndex i,j; double v; } matent;
+/* persistent workspace, kept between calls (freed by "clear mex") */
+static void *ws_ptr = 0;
+static size_t ws_size = 0;
+
+static void ws_free(void)
+{
+  if(ws_ptr) mxFree(ws_ptr);
+  ws_ptr = 0, ws_size = 0;
+}
+
+static void *ws_get(size_t n)
+{
+  static int registered = 0;
+  if(n>ws_size) {
+    ws_free();
+    if(!(ws_ptr = mem_alloc(n))) return 0;
+    mexMakeMemoryPersistent(ws_ptr);
+    ws_size = n;
+    if(!registered) mexAtExit(ws_free), registered = 1;
+  }
+  return ws_ptr;
+}
+
+typedef struct { mwIndex i,j,k; double v; } matent; /* k: position in A */
 
 #define DEF_HEAP_SORT(name)                                   \
 static void name(T *A, mwSize n)                              \
@@ -43,9 +66,6 @@ static void name(T *A, mwSize n)                              \
 #define LT(a,b) (fabs((a).v)<fabs((b).v))
 DEF_HEAP_SORT(heap_sortv)
 #undef LT
-#define LT(a,b) ((a).j<(b).j || ((a).j==(b).j && (a).i<(b).i))
-DEF_HEAP_SORT(heap_sortij)
-#undef LT
 #undef T
 
 static mxArray *sym_sparsify(
@@ -53,14 +73,16 @@ static mxArray *sym_sparsify(
   double tol)
 {
   mwIndex j, k; mwSize count=0;
-  matent *S, *p, *end; double *E;
+  matent *S, *p, *end; double *E; char *keep;
   mxArray *U;
   for(j=0;j<n;++j) for(k=jc[j];k<jc[j+1];++k) if(A[k]!=0 && ir[k]<j) ++count;
-  if(!(S=mem_alloc(count*sizeof(matent))) && count) return 0;
-  if(!(E=mem_alloc(n*sizeof(double)))) { mxFree(S); return 0; }
+  /* workspace: S[count], E[n], keep[nnz(A)] */
+  S = ws_get(count*sizeof(matent) + n*sizeof(double) + jc[n]);
+  if(!S) return 0;
+  E = (double*)(S+count), keep = (char*)(E+n);
   p=S;
   for(j=0;j<n;++j) for(k=jc[j];k<jc[j+1];++k) if(A[k]!=0 && ir[k]<j)
-    p->j=j,p->i=ir[k],p->v=A[k],++p;
+    p->j=j,p->i=ir[k],p->k=k,p->v=A[k],++p;
   heap_sortv(S,count);
   for(j=0;j<n;++j) E[j]=0;
   if(count && fabs(S->v)<tol) {
@@ -73,22 +95,22 @@ static mxArray *sym_sparsify(
     }
     count = o-S;
   }
-  heap_sortij(S,count);
+  /* the entries kept are a subset of those of A: mark them, and copy
+     them out in the (column, row) order of A, with no second sort */
+  for(k=0;k<jc[n];++k) keep[k]=0;
+  for(k=0;k<count;++k) keep[S[k].k]=1;
   U = mxCreateSparse(n,n,count,mxREAL);
   if(U) {
     mwIndex *Ujc=mxGetJc(U), *Uir=mxGetIr(U);
     double *Upr=mxGetPr(U);
-    mwIndex lj=0;
+    mwIndex uk=0;
     Ujc[0]=0;
-    for(k=0;k<count;++k) {
-      j=S[k].j;
-      while(lj<j) Ujc[++lj]=k;
-      Uir[k]=S[k].i;
-      Upr[k]=1;/*S[k].v;*/
+    for(j=0;j<n;++j) {
+      for(k=jc[j];k<jc[j+1];++k) if(keep[k])
+        Uir[uk]=ir[k], Upr[uk]=1/*A[k]*/, ++uk;
+      Ujc[j+1]=uk;
     }
-    while(lj<n) Ujc[++lj]=count;
   } else mexWarnMsgTxt("Out of memory.");
-  mxFree(E),mxFree(S);
   return U;
 }
 
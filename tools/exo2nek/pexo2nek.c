@@ -0,0 +1,595 @@
+/*
+ * pexo2nek - MPI-parallel, block-streamed version of exo2nek
+ *
+ * Usage: mpirun -np <p> pexo2nek [-c chunk] [-p id1,id2 ...] [-t tol] <case>
+ *
+ * Reads <case>.exo and writes <case>.re2 with the same content as the
+ * serial exo2nek (HEX20/HEX27 or QUAD8/QUAD9, midside curves, sideset
+ * ids as 'EXO' bcs with the id in bc(5)), but no process ever holds the
+ * whole mesh:
+ *
+ *  - the elements are split into contiguous global ranges, one per rank,
+ *    each spanning one or more element blocks
+ *  - a rank streams its range in chunks of at most <chunk> elements
+ *    (default 100000): partial connectivity, the node range it touches
+ *    (ex_get_partial_conn/_coord), conversion, midside curves, and a
+ *    collective MPI-IO write of the chunk's element records
+ *  - sidesets are read in chunks by every rank, each keeping the sides
+ *    of its own elements
+ *  - curve and bc records are buffered per rank and written at offsets
+ *    from a prefix sum over the ranks
+ *
+ * -p id1,id2 makes the faces of sideset id1 periodic with those of id2
+ * ('P  ' bcs pointing at the partner element/face, both ways).  The
+ * translation is the difference of the mean face centroids of the two
+ * sets; faces are matched by hashing their translated centroids on a
+ * grid of tol (-t, default 1e-6) times the mean face size.  Only the
+ * faces of periodic sidesets are gathered on all ranks.
+ *
+ * Every rank opens the file for reading with ex_open.  The memory per
+ * rank is one chunk plus the node range the chunk references, so it
+ * relies on the usual locality of the exodus node numbering.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "exodusII.h"
+
+#define MAXPER   16          /* periodic sideset pairs            */
+#define RECSIZE  64          /* curve and bc records: 8 doubles   */
+
+static int nid = 0, np = 1;
+
+static void die(const char *msg)
+{
+  fprintf(stderr,"ERROR (rank %d): %s\n",nid,msg);
+  MPI_Abort(MPI_COMM_WORLD,1);
+}
+
+static void *xmalloc(size_t n)
+{
+  void *p = malloc(n ? n : 1);
+  if (!p) die("out of memory");
+  return p;
+}
+
+/* exodus node -> position in the 3x3(x3) nek element, 0-based */
+static const int exo2nek3[27] = {
+  18, 0, 6,24,20, 2, 8,26, 9, 3,15,21,19, 1, 7,25,11, 5,
+  17,23,13,12,14,22, 4,10,16 };
+static const int exo2nek2[9]  = { 0, 2, 8, 6, 1, 5, 7, 3, 4 };
+
+/* exodus side -> nek (preprocessor) face */
+static const int exoface3[6] = { 1, 5, 3, 6, 4, 2 };
+static const int exoface2[4] = { 1, 2, 3, 4 };
+
+/* edges of the 3x3x3 element (exo2nek.f gen_rea_midside_e), 0-based */
+static const int edge3[12][3] = {
+  { 0, 1, 2},{ 2, 5, 8},{ 8, 7, 6},{ 6, 3, 0},
+  {18,19,20},{20,23,26},{26,25,24},{24,21,18},
+  { 0, 9,18},{ 2,11,20},{ 8,17,26},{ 6,15,24} };
+
+/* corners of nek face f (1..6) in 3x3x3 positions */
+static const int face3[6][4] = {
+  { 0, 2,20,18},{ 2, 8,26,20},{ 8, 6,24,26},
+  { 6, 0,18,24},{ 0, 2, 8, 6},{18,20,26,24} };
+static const int face2[4][2] = { {0,2},{2,8},{8,6},{6,0} };
+
+/* re2 corner order (isym2pre) */
+static const int corner3[8] = { 0, 2, 8, 6,18,20,26,24 };
+static const int corner2[4] = { 0, 2, 8, 6 };
+
+typedef struct {
+  int     ndim, nvert, nface, nedge;
+  int     nelg, nnodes, nblk, nss;
+  int    *blk_id, *blk_nel;              /* element blocks            */
+  int    *ss_id;
+  int     e0, nloc;                       /* local global range        */
+  int    *bcid;                           /* nloc*nface sideset ids    */
+  double *fc;                             /* nloc*nface*3 centroids    */
+  int     exoid;
+} mesh_t;
+
+typedef struct {
+  double *r;
+  int64_t n, cap;
+} recbuf;
+
+static void rec_add(recbuf *b, int iel, int f, const double *v,
+                    const char *tag)
+{
+  double *p;
+  if (b->n == b->cap) {
+    b->cap = b->cap ? 2*b->cap : 1024;
+    b->r = realloc(b->r,b->cap*RECSIZE);
+    if (!b->r) die("out of memory");
+  }
+  p = b->r + 8*b->n++;
+  p[0] = iel;
+  p[1] = f;
+  memcpy(p+2,v,5*sizeof(double));
+  memset(p+7,' ',sizeof(double));
+  memcpy(p+7,tag,strlen(tag));
+}
+
+static void mpi_check(int ierr, const char *what)
+{
+  if (ierr != MPI_SUCCESS) die(what);
+}
+
+/* ------------------------------------------------------------------ */
+/* mesh parameters, same checks as exodus_read in exo2nek.f           */
+
+static void read_params(mesh_t *m, const char *exoname)
+{
+  char typ[MAX_STR_LENGTH+1], title[MAX_LINE_LENGTH+1];
+  int  cpu_ws = 8, io_ws = 0, nns, i, nattr, ned, nfa;
+  float vers;
+
+  m->exoid = ex_open(exoname,EX_READ,&cpu_ws,&io_ws,&vers);
+  if (m->exoid < 0) die("cannot open the exodus file");
+
+  if (ex_get_init(m->exoid,title,&m->ndim,&m->nnodes,&m->nelg,&m->nblk,
+                  &nns,&m->nss) < 0)
+    die("cannot read exodusII parameters (ex_get_init)");
+
+  if (m->ndim != 2 && m->ndim != 3) die("unknown number of dimensions");
+  m->nface = 2*m->ndim;
+  m->nedge = 4 + 8*(m->ndim-2);
+
+  m->blk_id  = xmalloc(m->nblk*sizeof(int));
+  m->blk_nel = xmalloc(m->nblk*sizeof(int));
+  m->ss_id   = xmalloc((m->nss+1)*sizeof(int));
+  if (ex_get_ids(m->exoid,EX_ELEM_BLOCK,m->blk_id) < 0)
+    die("cannot read block ids");
+  if (m->nss > 0 && ex_get_ids(m->exoid,EX_SIDE_SET,m->ss_id) < 0)
+    die("cannot read SideSet ids");
+
+  for (i=0; i<m->nblk; i++) {
+    int nv;
+    if (ex_get_block(m->exoid,EX_ELEM_BLOCK,m->blk_id[i],typ,
+                     &m->blk_nel[i],&nv,&ned,&nfa,&nattr) < 0)
+      die("cannot read block parameters (ex_get_block)");
+    if (i == 0) {
+      m->nvert = nv;
+      if (m->ndim == 2 && nv != 8 && nv != 9)
+        die("only QUAD8 elements are allowed in a 2D mesh");
+      if (m->ndim == 3 && nv != 20 && nv != 27)
+        die("only HEX20 elements are allowed in a 3D mesh");
+      if (nid == 0 && (nv == 9 || nv == 27))
+        printf("WARNING: %s elements are not officially supported\n",
+               nv == 9 ? "QUAD9" : "HEX27");
+    }
+    if (nv != m->nvert) die("all blocks should contain the same type");
+  }
+
+  if (nid == 0) {
+    printf("\ndatabase parameters:\n\n"
+           "title         = %s\n\n"
+           "num_dim       = %8d\n"
+           "num_nodes     = %8d\n"
+           "num_elem      = %8d\n"
+           "num_elem_blk  = %8d\n"
+           "num_side_sets = %8d\n\n",
+           title,m->ndim,m->nnodes,m->nelg,m->nblk,m->nss);
+    if (m->nss == 0) printf("WARNING: No SideSets in exodus file!\n");
+  }
+
+  /* contiguous element range of this rank */
+  {
+    int q = m->nelg/np, r = m->nelg%np;
+    m->nloc = q + (nid < r);
+    m->e0   = nid*q + (nid < r ? nid : r);
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* sidesets: keep the sides of local elements                         */
+
+static void read_sidesets(mesh_t *m, int chunk)
+{
+  int *el = xmalloc(chunk*sizeof(int)), *sd = xmalloc(chunk*sizeof(int));
+  const int *fmap = m->ndim == 3 ? exoface3 : exoface2;
+  int s, i;
+
+  m->bcid = calloc((size_t)m->nloc*m->nface+1,sizeof(int));
+  if (!m->bcid) die("out of memory");
+
+  for (s=0; s<m->nss; s++) {
+    int nside, ndf;
+    int64_t k;
+    if (ex_get_set_param(m->exoid,EX_SIDE_SET,m->ss_id[s],&nside,&ndf) < 0)
+      die("cannot read SideSet parameters (ex_get_set_param)");
+    if (nid == 0)
+      printf("side set %2d num_sides = %8d\n",m->ss_id[s],nside);
+    for (k=0; k<nside; k+=chunk) {
+      int n = nside-k < chunk ? (int)(nside-k) : chunk;
+      if (ex_get_partial_set(m->exoid,EX_SIDE_SET,m->ss_id[s],k+1,n,
+                             el,sd) < 0)
+        die("cannot read SideSet (ex_get_partial_set)");
+      for (i=0; i<n; i++) {
+        int e = el[i]-1-m->e0;
+        if (e >= 0 && e < m->nloc && sd[i] >= 1 && sd[i] <= m->nface)
+          m->bcid[e*m->nface + fmap[sd[i]-1]-1] = m->ss_id[s];
+      }
+    }
+  }
+  free(el); free(sd);
+}
+
+/* ------------------------------------------------------------------ */
+/* elements: stream the local range in chunks                         */
+
+static void midside(const mesh_t *m, int eg, const double *x,
+                    const double *y, const double *z, recbuf *curve)
+{
+  const double tol2 = 1.e-8;
+  int i, j;
+
+  for (i=0; i<m->nedge; i++) {
+    double xyz[3][3], h = 0, len = 0, c[5] = {0,0,0,0,0};
+    for (j=0; j<3; j++) {
+      int p = edge3[i][j];
+      xyz[0][j] = x[p];
+      xyz[1][j] = y[p];
+      xyz[2][j] = m->ndim == 3 ? z[p] : 0;
+    }
+    for (j=0; j<m->ndim; j++) {
+      double xm = .5*(xyz[j][0]+xyz[j][2]);
+      h   += (xyz[j][1]-xm)*(xyz[j][1]-xm);
+      len += (xyz[j][2]-xyz[j][0])*(xyz[j][2]-xyz[j][0]);
+    }
+    if (h > tol2*len) {
+      for (j=0; j<m->ndim; j++) c[j] = xyz[j][1];
+      rec_add(curve,eg,i+1,c,"m");
+    }
+  }
+}
+
+static void write_elements(mesh_t *m, MPI_File fh, MPI_Offset base,
+                           int chunk, recbuf *curve)
+{
+  const int nv = m->nvert, nc = 1 << m->ndim;
+  const int *vmap = m->ndim == 3 ? exo2nek3 : exo2nek2;
+  const int *cmap = m->ndim == 3 ? corner3 : corner2;
+  const int  nrec = 1 + m->ndim*nc;                /* doubles / element */
+  int *conn = xmalloc((size_t)chunk*nv*sizeof(int));
+  double *rec = xmalloc((size_t)chunk*nrec*sizeof(double));
+  double *xn = NULL, *yn = NULL, *zn = NULL;
+  size_t ncap = 0;
+  int nchunk, mchunk, ic, e1 = 0, b = 0, boff = 0;
+
+  m->fc = xmalloc(((size_t)m->nloc*m->nface*3+1)*sizeof(double));
+
+  /* first block of the local range */
+  for (b=0, boff=0; b<m->nblk && boff+m->blk_nel[b] <= m->e0; b++)
+    boff += m->blk_nel[b];
+
+  nchunk = (m->nloc+chunk-1)/chunk;
+  MPI_Allreduce(&nchunk,&mchunk,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+
+  for (ic=0; ic<mchunk; ic++) {
+    int n = 0, nmin = m->nnodes, nmax = 0, i, j, k;
+    MPI_Status st;
+
+    if (ic < nchunk) {
+      int eg = m->e0 + e1;                           /* 0-based global */
+      n = m->nloc-e1 < chunk ? m->nloc-e1 : chunk;
+
+      /* connectivity, possibly across block boundaries */
+      for (k=0; k<n; ) {
+        int nb;
+        while (eg+k >= boff+m->blk_nel[b]) boff += m->blk_nel[b++];
+        nb = boff+m->blk_nel[b]-(eg+k);
+        if (nb > n-k) nb = n-k;
+        if (ex_get_partial_conn(m->exoid,EX_ELEM_BLOCK,m->blk_id[b],
+                                eg+k-boff+1,nb,conn+(size_t)k*nv,
+                                NULL,NULL) < 0)
+          die("cannot read element connectivity (ex_get_partial_conn)");
+        k += nb;
+      }
+      for (i=0; i<n*nv; i++) {
+        if (conn[i] < nmin) nmin = conn[i];
+        if (conn[i] > nmax) nmax = conn[i];
+      }
+
+      /* the node range of this chunk */
+      if ((size_t)(nmax-nmin+1) > ncap) {
+        ncap = nmax-nmin+1;
+        free(xn); free(yn); free(zn);
+        xn = xmalloc(ncap*sizeof(double));
+        yn = xmalloc(ncap*sizeof(double));
+        zn = xmalloc(ncap*sizeof(double));
+      }
+      if (ex_get_partial_coord(m->exoid,nmin,nmax-nmin+1,xn,yn,
+                               m->ndim == 3 ? zn : NULL) < 0)
+        die("cannot read nodal coordinates (ex_get_partial_coord)");
+
+      for (k=0; k<n; k++) {
+        double x[27], y[27], z[27], *r = rec + (size_t)k*nrec;
+        int el = e1+k;
+        memset(z,0,sizeof(z));
+        for (i=0; i<nv; i++) {
+          int p = conn[(size_t)k*nv+i]-nmin;
+          x[vmap[i]] = xn[p];
+          y[vmap[i]] = yn[p];
+          if (m->ndim == 3) z[vmap[i]] = zn[p];
+        }
+
+        r[0] = 0;                                    /* group          */
+        for (j=0; j<nc; j++) {
+          r[1+j]      = x[cmap[j]];
+          r[1+nc+j]   = y[cmap[j]];
+          if (m->ndim == 3) r[1+2*nc+j] = z[cmap[j]];
+        }
+
+        midside(m,m->e0+el+1,x,y,z,curve);
+
+        for (i=0; i<m->nface; i++) {                 /* face centroids */
+          double *c = m->fc + ((size_t)el*m->nface+i)*3;
+          int nf = m->ndim == 3 ? 4 : 2;
+          c[0] = c[1] = c[2] = 0;
+          for (j=0; j<nf; j++) {
+            int p = m->ndim == 3 ? face3[i][j] : face2[i][j];
+            c[0] += x[p]/nf; c[1] += y[p]/nf; c[2] += z[p]/nf;
+          }
+        }
+      }
+    }
+
+    mpi_check(MPI_File_write_at_all(fh,
+                base+(MPI_Offset)(m->e0+e1)*nrec*sizeof(double),
+                rec,n*nrec,MPI_DOUBLE,&st),"writing elements");
+    e1 += n;
+    if (nid == 0 && ic < nchunk)
+      printf("chunk %d/%d: %d elements per rank written\n",
+             ic+1,mchunk,n);
+  }
+
+  free(conn); free(rec); free(xn); free(yn); free(zn);
+}
+
+/* ------------------------------------------------------------------ */
+/* periodic sideset pairs, matched by hashed centroids                */
+
+typedef struct { double c[3]; int e, f; } pface;
+
+static pface *gather_faces(const mesh_t *m, int id, int *nall)
+{
+  pface *loc, *all;
+  int n = 0, e, f, i, *cnt, *dsp;
+
+  for (i=0; i<m->nloc*m->nface; i++) if (m->bcid[i] == id) n++;
+  loc = xmalloc(n*sizeof(pface));
+  for (n=0, e=0; e<m->nloc; e++)
+    for (f=0; f<m->nface; f++)
+      if (m->bcid[e*m->nface+f] == id) {
+        memcpy(loc[n].c,m->fc+((size_t)e*m->nface+f)*3,3*sizeof(double));
+        loc[n].e = m->e0+e+1;
+        loc[n].f = f+1;
+        n++;
+      }
+
+  cnt = xmalloc(np*sizeof(int));
+  dsp = xmalloc(np*sizeof(int));
+  n *= sizeof(pface);
+  MPI_Allgather(&n,1,MPI_INT,cnt,1,MPI_INT,MPI_COMM_WORLD);
+  for (dsp[0]=0, i=1; i<np; i++) dsp[i] = dsp[i-1]+cnt[i-1];
+  *nall = (dsp[np-1]+cnt[np-1])/sizeof(pface);
+  all = xmalloc(*nall*sizeof(pface));
+  MPI_Allgatherv(loc,n,MPI_BYTE,all,cnt,dsp,MPI_BYTE,MPI_COMM_WORLD);
+  free(loc); free(cnt); free(dsp);
+  return all;
+}
+
+static uint64_t cell_key(const double *c, double h, int di, int dj, int dk)
+{
+  int64_t i = (int64_t)floor(c[0]/h) + di;
+  int64_t j = (int64_t)floor(c[1]/h) + dj;
+  int64_t k = (int64_t)floor(c[2]/h) + dk;
+  return ((uint64_t)i*73856093u) ^ ((uint64_t)j*19349663u) ^
+         ((uint64_t)k*83492791u);
+}
+
+/* per pair: partner of every local face of id1 and id2 */
+static void periodic(mesh_t *m, int id1, int id2, double tol,
+                     int *pe, int *pf)
+{
+  pface *a, *b;
+  int na, nb, i, j, nhash, *head, *next, nmatch = 0, miss = 0;
+  double t[3] = {0,0,0}, lo[3], hi[3], area = 1, h;
+  int nd = 0;
+
+  a = gather_faces(m,id1,&na);
+  b = gather_faces(m,id2,&nb);
+  if (na != nb || na == 0) {
+    if (nid == 0)
+      printf("periodic %d,%d: %d vs %d faces, pair skipped\n",
+             id1,id2,na,nb);
+    free(a); free(b);
+    return;
+  }
+
+  /* translation id1 -> id2, mean face size from the extent of id2 */
+  for (j=0; j<3; j++) { lo[j] = 1e300; hi[j] = -1e300; }
+  for (i=0; i<na; i++) for (j=0; j<3; j++) {
+    t[j] += (b[i].c[j]-a[i].c[j])/na;
+    if (b[i].c[j] < lo[j]) lo[j] = b[i].c[j];
+    if (b[i].c[j] > hi[j]) hi[j] = b[i].c[j];
+  }
+  for (j=0; j<3; j++) if (hi[j]-lo[j] > 0) { area *= hi[j]-lo[j]; nd++; }
+  h = tol*(nd ? pow(area/nb,1.0/nd) : 1);
+
+  nhash = 2*nb+1;
+  head = xmalloc(nhash*sizeof(int));
+  next = xmalloc(nb*sizeof(int));
+  for (i=0; i<nhash; i++) head[i] = -1;
+  for (i=0; i<nb; i++) {
+    int k = (int)(cell_key(b[i].c,h,0,0,0) % nhash);
+    next[i] = head[k];
+    head[k] = i;
+  }
+
+  for (i=0; i<na; i++) {
+    double c[3];
+    int di, dj, dk, best = -1;
+    double dbest = 1e300;
+    for (j=0; j<3; j++) c[j] = a[i].c[j]+t[j];
+    for (di=-1; di<=1; di++) for (dj=-1; dj<=1; dj++)
+    for (dk=-1; dk<=1; dk++) {
+      int k = (int)(cell_key(c,h,di,dj,dk) % nhash), q;
+      for (q=head[k]; q>=0; q=next[q]) {
+        double d = 0;
+        for (j=0; j<3; j++) d += (b[q].c[j]-c[j])*(b[q].c[j]-c[j]);
+        if (d < dbest) { dbest = d; best = q; }
+      }
+    }
+    if (best < 0 || dbest > h*h) { miss++; continue; }
+    nmatch++;
+    /* store on the owners of either face */
+    j = a[i].e-1-m->e0;
+    if (j >= 0 && j < m->nloc) {
+      pe[j*m->nface+a[i].f-1] = b[best].e;
+      pf[j*m->nface+a[i].f-1] = b[best].f;
+    }
+    j = b[best].e-1-m->e0;
+    if (j >= 0 && j < m->nloc) {
+      pe[j*m->nface+b[best].f-1] = a[i].e;
+      pf[j*m->nface+b[best].f-1] = a[i].f;
+    }
+  }
+  if (nid == 0)
+    printf("periodic %d,%d: %d faces matched, %d unmatched, "
+           "translation %g %g %g\n",id1,id2,nmatch,miss,t[0],t[1],t[2]);
+  if (miss) die("unmatched periodic faces, check the pair or -t");
+
+  free(head); free(next); free(a); free(b);
+}
+
+/* ------------------------------------------------------------------ */
+
+static void write_records(recbuf *r, MPI_File fh, MPI_Offset *off)
+{
+  int64_t n = r->n, start = 0, ntot;
+  double cnt;
+  MPI_Status st;
+
+  MPI_Exscan(&n,&start,1,MPI_INT64_T,MPI_SUM,MPI_COMM_WORLD);
+  if (nid == 0) start = 0;
+  MPI_Allreduce(&n,&ntot,1,MPI_INT64_T,MPI_SUM,MPI_COMM_WORLD);
+
+  cnt = (double)ntot;
+  if (nid == 0)
+    mpi_check(MPI_File_write_at(fh,*off,&cnt,1,MPI_DOUBLE,&st),
+              "writing record count");
+  *off += sizeof(double);
+  mpi_check(MPI_File_write_at_all(fh,*off+start*RECSIZE,r->r,8*(int)n,
+                                  MPI_DOUBLE,&st),"writing records");
+  *off += ntot*RECSIZE;
+}
+
+int main(int argc, char **argv)
+{
+  char name[256] = "", exoname[300], re2name[300], hdr[81];
+  int  chunk = 100000, nper = 0, per[MAXPER][2], i, f;
+  double tol = 1e-6, t0;
+  mesh_t m;
+  recbuf curve = {NULL,0,0}, bc = {NULL,0,0};
+  MPI_File fh;
+  MPI_Offset off;
+  int *pe = NULL, *pf = NULL;
+
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD,&nid);
+  MPI_Comm_size(MPI_COMM_WORLD,&np);
+  t0 = MPI_Wtime();
+
+  for (i=1; i<argc; i++) {
+    if (!strcmp(argv[i],"-c") && i+1 < argc) chunk = atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-t") && i+1 < argc) tol = atof(argv[++i]);
+    else if (!strcmp(argv[i],"-p") && i+1 < argc) {
+      if (nper == MAXPER) die("too many periodic pairs");
+      if (sscanf(argv[++i],"%d,%d",&per[nper][0],&per[nper][1]) != 2)
+        die("-p expects id1,id2");
+      nper++;
+    } else strncpy(name,argv[i],sizeof(name)-1);
+  }
+  if (!name[0]) {
+    if (nid == 0) {
+      printf("Input (.exo) file name:\n");
+      fflush(stdout);
+      if (scanf("%255s",name) != 1) name[0] = '\0';
+    }
+    MPI_Bcast(name,sizeof(name),MPI_CHAR,0,MPI_COMM_WORLD);
+  }
+  if (!name[0]) die("no input file");
+  if (chunk < 1) chunk = 1;
+  {
+    size_t n = strlen(name);
+    if (n > 4 && !strcmp(name+n-4,".exo")) name[n-4] = '\0';
+  }
+  sprintf(exoname,"%s.exo",name);
+  sprintf(re2name,"%s.re2",name);
+
+  memset(&m,0,sizeof(m));
+  read_params(&m,exoname);
+  read_sidesets(&m,chunk);
+
+  mpi_check(MPI_File_open(MPI_COMM_WORLD,re2name,
+                          MPI_MODE_CREATE|MPI_MODE_WRONLY,
+                          MPI_INFO_NULL,&fh),"cannot open the .re2 file");
+  MPI_File_set_size(fh,0);
+
+  if (nid == 0) {                                 /* header, as open_re2 */
+    float test = 6.54321f;
+    MPI_Status st;
+    memset(hdr,' ',80);
+    snprintf(hdr,81,"#v003%9d%3d%9d this is the hdr",m.nelg,m.ndim,m.nelg);
+    hdr[strlen(hdr)] = ' ';
+    MPI_File_write_at(fh,0,hdr,80,MPI_CHAR,&st);
+    MPI_File_write_at(fh,80,&test,1,MPI_FLOAT,&st);
+    printf("\nwriting %s\n",re2name);
+  }
+  off = 84;
+  write_elements(&m,fh,off,chunk,&curve);
+  off += (MPI_Offset)m.nelg*(1+m.ndim*(1 << m.ndim))*sizeof(double);
+  ex_close(m.exoid);
+
+  if (nper) {
+    pe = calloc((size_t)m.nloc*m.nface+1,sizeof(int));
+    pf = calloc((size_t)m.nloc*m.nface+1,sizeof(int));
+    if (!pe || !pf) die("out of memory");
+    for (i=0; i<nper; i++) periodic(&m,per[i][0],per[i][1],tol,pe,pf);
+  }
+
+  for (i=0; i<m.nloc; i++)
+    for (f=0; f<m.nface; f++) {
+      int k = i*m.nface+f;
+      double v[5] = {0,0,0,0,0};
+      if (pe && pe[k]) {
+        v[0] = pe[k];
+        v[1] = pf[k];
+        rec_add(&bc,m.e0+i+1,f+1,v,"P  ");
+      } else if (m.bcid[k]) {
+        v[4] = m.bcid[k];
+        rec_add(&bc,m.e0+i+1,f+1,v,"EXO");
+      }
+    }
+
+  write_records(&curve,fh,&off);
+  write_records(&bc,fh,&off);
+  MPI_File_close(&fh);
+
+  if (nid == 0)
+    printf("done :: %d elements on %d ranks in %.2f s\n",
+           m.nelg,np,MPI_Wtime()-t0);
+
+  free(curve.r); free(bc.r); free(pe); free(pf);
+  free(m.bcid); free(m.fc); free(m.blk_id); free(m.blk_nel); free(m.ss_id);
+  MPI_Finalize();
+  return 0;
+}
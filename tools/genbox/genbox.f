@@ -14,6 +14,12 @@ C    .For each box, the User specifies the number of elements in the
 c     x-y-z directions and the corresponding locations of the vertices
 c     and the boundary conditions on the box
 c
+C    .Elements, curves and bcs are written as they are generated, so
+c     memory does not grow with the element count.  For a single box
+c     (no circle) written to box.re2 a matching box.ma2 is written as
+c     well and genmap can be skipped, otherwise an old box.ma2 is
+c     removed.
+c
 C    .INPUT FILE FORMAT:
 c
 c     line  0:    name of .rea file (start in col. 1, include .rea suffix)
@@ -90,7 +96,6 @@ c------------------------------------------------------------------------------
       integer nlx(mbox),nly(mbox),nlz(mbox)
       real x(0:maxx,mbox),y(0:maxx,mbox),z(0:maxx,mbox)
       real xc(mbox),yc(mbox),zc(mbox)
-      real curve(8,maxel)
       character*3 cbc(6,mbox,20)
       character*1 boxcirc(mbox)
       integer e0
@@ -98,7 +103,7 @@ c------------------------------------------------------------------------------
       real*8 rbc8(6)
       integer ibc(6)
 
-      common /genbr/ x,y,z,xc,yc,zc,curve
+      common /genbr/ x,y,z,xc,yc,zc
       common /genbc/ cbc
 
       real*4 buf (60)
@@ -155,6 +160,11 @@ c     Error check for missing .rea file name
       else
         call byte_open('box.re2' // char(0))
       endif
+c     a box.ma2 left by an earlier run would not match this mesh,
+c     it is rewritten below only for a single box
+      open (unit=10,file='box.ma2',status='old',err=13)
+      close(10,status='delete')
+   13 continue
       ndim = abs(ndim)
       if (ndim.eq.3) then 
           if3d = .true.
@@ -253,11 +263,7 @@ c----------------------------------------------------------------------
             nely = abs(nely)
             nelz = abs(nelz)
 
-            if(nelx*nely*nelz.gt.maxel) then
-              write(6,*)
-     $           'ABORT: increase maxel and recompile!',nelx,nely
-              call exitt
-            elseif (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
+            if (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
                write(6,*) 'ABORT, increase maxx and recompile',
      $                       nelx,nely,nelz,maxx
               call exitt
@@ -362,10 +368,7 @@ c              write(6,*) 'CBC:',(cbc(k,ibox,ifld),k=1,6),ifld,ibox
             nelx = abs(nelx)
             nely = abs(nely)
 
-            if(nelx*nely*nelz.gt.maxel) then
-              write(6,*) 'ABORT: increase maxel and recompile!'
-              call exitt
-            elseif (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
+            if (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
                write(6,*) 'ABORT, increase maxx and recompile',
      $                       nelx,nely,nelz,maxx
               call exitt
@@ -458,11 +461,9 @@ c           write(998,*) (y(i,1),i=0,nely)
       endif
 
 
-      if(nel.gt.maxel) then
-        write(6,*) 'Abort: number of elements too large',nel
-        write(6,*) 'change MAXNEL and recompile'
-        call exitt
-      elseif (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
+c     Elements, curves and bcs are generated on the fly from the box
+c     coordinates, so nel is only bounded by mbox and maxx here.
+      if (nelx.gt.maxx.or.nely.gt.maxx.or.nelz.gt.maxx) then
         write(6,*) 'ABORT, increase maxx and recompile',
      $       nelx,nely,nelz,maxx
         call exitt
@@ -490,13 +491,11 @@ c
         endif
   111   format('#v001',i9,i3,i9,' hdr')
   112   format('#v002',i9,i3,i9,' hdr')
-        call byte_write(hdr,20)   ! assumes byte_open() already issued
-        call byte_write(test,1)   ! write the endian discriminator
+        call buf_write(hdr,20)   ! assumes byte_open() already issued
+        call buf_write(test,1)   ! write the endian discriminator
       endif
  
       ncurv = 0
-
-      call rzero(curve,8*nel)
  
 c----------------------------------------------------------------------
 c     OUTPUT mesh data
@@ -529,10 +528,6 @@ c             ilev = ilev+1
                    y2 = yc(ibox) + r2*sin(t1)
                    y3 = yc(ibox) + r2*sin(t2)
                    y4 = yc(ibox) + r1*sin(t2)
-                   curve(2,ie) =  r2
-                   curve(4,ie) = -r1
-                   curve(6,ie) =  r2
-                   curve(8,ie) = -r1
                    ncurv = ncurv+4
 c                  write(9,11) ie,ilev,apt(ia),'0'
                    if(iffo) then 
@@ -545,7 +540,7 @@ c                  write(9,11) ie,ilev,apt(ia),'0'
                       write(9,12) z2,z2,z2,z2
                    elseif(wdsize.eq.4) then
                     igroup = 0
-                    call byte_write(igroup, 1)
+                    call buf_write(igroup, 1)
                     buf(1)  = x1
                     buf(2)  = x2
                     buf(3)  = x3
@@ -570,10 +565,10 @@ c                  write(9,11) ie,ilev,apt(ia),'0'
                     buf(22) = z2
                     buf(23) = z2
                     buf(24) = z2
-                    call byte_write(buf,24)
+                    call buf_write(buf,24)
                    else
                     rgroup = 0.0
-                    call byte_write(rgroup, 2)
+                    call buf_write(rgroup, 2)
                     buf2(1)  = x1
                     buf2(2)  = x2
                     buf2(3)  = x3
@@ -598,7 +593,7 @@ c                  write(9,11) ie,ilev,apt(ia),'0'
                     buf2(22) = z2
                     buf2(23) = z2
                     buf2(24) = z2
-                    call byte_write(buf,48)
+                    call buf_write(buf,48)
                    endif
                 enddo
               enddo
@@ -636,7 +631,7 @@ c           ilev = ilev+1
                     write(9,12) z2,z2,z2,z2
                   elseif(wdsize.eq.4) then
                     igroup = 0
-                    call byte_write(igroup, 1)
+                    call buf_write(igroup, 1)
                     buf(1)  = x1
                     buf(2)  = x2
                     buf(3)  = x2
@@ -661,10 +656,10 @@ c           ilev = ilev+1
                     buf(22) = z2
                     buf(23) = z2
                     buf(24) = z2
-                    call byte_write(buf,24)
+                    call buf_write(buf,24)
                   else
                     rgroup = 0.0
-                    call byte_write(rgroup, 2)
+                    call buf_write(rgroup, 2)
                     buf2(1)  = x1
                     buf2(2)  = x2
                     buf2(3)  = x2
@@ -689,7 +684,7 @@ c           ilev = ilev+1
                     buf2(22) = z2
                     buf2(23) = z2
                     buf2(24) = z2
-                    call byte_write(buf,48)
+                    call buf_write(buf,48)
                   endif
                enddo
             enddo
@@ -726,15 +721,13 @@ c             CIRCLE (x = r, y = theta) .... specified in std. "box" way...
                     y2 = yc(ibox) + r2*sin(t1)
                     y3 = yc(ibox) + r2*sin(t2)
                     y4 = yc(ibox) + r1*sin(t2)
-                    curve(2,ie) =  r2
-                    curve(4,ie) = -r1
                     if(iffo) then
                       write(9,11) ie,ilev,apt(ia),'0'
                       write(9,12) x1,x2,x3,x4
                       write(9,12) y1,y2,y3,y4
                     elseif(wdsize.eq.4) then
                       igroup = 0
-                      call byte_write(igroup, 1)
+                      call buf_write(igroup, 1)
                       buf(1) = x1
                       buf(2) = x2
                       buf(3) = x3
@@ -743,10 +736,10 @@ c             CIRCLE (x = r, y = theta) .... specified in std. "box" way...
                       buf(6) = y2
                       buf(7) = y3
                       buf(8) = y4
-                      call byte_write(buf,8)
+                      call buf_write(buf,8)
                     else
                       rgroup = 0.0
-                      call byte_write(rgroup, 2)
+                      call buf_write(rgroup, 2)
                       buf2(1) = x1
                       buf2(2) = x2
                       buf2(3) = x3
@@ -755,7 +748,7 @@ c             CIRCLE (x = r, y = theta) .... specified in std. "box" way...
                       buf2(6) = y2
                       buf2(7) = y3
                       buf2(8) = y4
-                      call byte_write(buf,16)
+                      call buf_write(buf,16)
                     endif
                     ncurv = ncurv+2
                  enddo
@@ -784,15 +777,13 @@ c             CIRCLE (x = r, y = theta) .... specified in Cool fast way...
                     y2 = yc(ibox) + r2*sin(p1)
                     y3 = yc(ibox) + r2*sin(p2)
                     y4 = yc(ibox) + r1*sin(p2)
-                    curve(2,ie) =  r2
-                    curve(4,ie) = -r1
                     if(iffo) then
                       write(9,11) ie,ilev,apt(ia),'0'
                       write(9,12) x1,x2,x3,x4
                       write(9,12) y1,y2,y3,y4
                     elseif(wdsize.eq.4) then 
                       igroup = 0
-                      call byte_write(igroup, 1)
+                      call buf_write(igroup, 1)
                       buf(1) = x1
                       buf(2) = x2
                       buf(3) = x3
@@ -801,10 +792,10 @@ c             CIRCLE (x = r, y = theta) .... specified in Cool fast way...
                       buf(6) = y2
                       buf(7) = y3
                       buf(8) = y4
-                      call byte_write(buf,8)
+                      call buf_write(buf,8)
                     else
                       rgroup = 0.0
-                      call byte_write(rgroup, 2)
+                      call buf_write(rgroup, 2)
                       buf2(1) = x1
                       buf2(2) = x2
                       buf2(3) = x3
@@ -813,7 +804,7 @@ c             CIRCLE (x = r, y = theta) .... specified in Cool fast way...
                       buf2(6) = y2
                       buf2(7) = y3
                       buf2(8) = y4
-                      call byte_write(buf,16)
+                      call buf_write(buf,16)
                     endif
                     ncurv = ncurv+2
                  enddo
@@ -835,7 +826,7 @@ c             BOX
                       write(9,12) y1,y1,y2,y2
                     elseif(wdsize.eq.4) then
                       igroup = 0
-                      call byte_write(igroup, 1)
+                      call buf_write(igroup, 1)
                       buf(1) = x1
                       buf(2) = x2
                       buf(3) = x2
@@ -844,10 +835,10 @@ c             BOX
                       buf(6) = y1
                       buf(7) = y2
                       buf(8) = y2
-                      call byte_write(buf,8)
+                      call buf_write(buf,8)
                     else
                       rgroup = 0.0
-                      call byte_write(rgroup, 2)
+                      call buf_write(rgroup, 2)
                       buf2(1) = x1
                       buf2(2) = x2
                       buf2(3) = x2
@@ -856,7 +847,7 @@ c             BOX
                       buf2(6) = y1
                       buf2(7) = y2
                       buf2(8) = y2
-                      call byte_write(buf,16)
+                      call buf_write(buf,16)
                     endif
                  enddo
               enddo
@@ -874,69 +865,35 @@ c     output curve stuff and Boundary conditions
    28   format(
      $   '  ***** CURVED SIDE DATA *****',/,
      $      i12,' Curved sides follow IEDGE,IEL,CURVE(I),I=1,5, CCURVE')
-
-        if (nel.lt.1000) then
-           do ie=1,nel
-              do iedge = 2,maxedge,2
-                 if (curve(iedge,ie).ne.0) write(9,290) 
-     $            iedge,ie,curve(iedge,ie),(zero,k=1,4),'C'
-              enddo
-           enddo
-  290      format(i3,i3,5g14.6,1x,a1)
-         elseif(nel.lt.1 000 000) then
-           do ie=1,nel
-              do iedge = 2,maxedge,2
-                 if (curve(iedge,ie).ne.0) write(9,291) 
-     $              iedge,ie,curve(iedge,ie),(zero,k=1,4),'C'
-              enddo
-           enddo
-  291      format(i2,i6,5g14.6,1x,a1)
-         else
-           do ie=1,nel
-              do iedge = 2,maxedge,2
-                 if (curve(iedge,ie).ne.0) write(9,292) 
-     $              iedge,ie,curve(iedge,ie),(zero,k=1,4),'C'
-              enddo
-           enddo
-  292      format(i2,i12,5g14.6,1x,a1)
-         endif
       elseif(wdsize.eq.4) then 
-         call byte_write(ncurv,1)  
-         do ie=1,nel
-            do iedge = 2,maxedge,2
-               if (curve(iedge,ie).ne.0) then
-                  call icopy(buf(1),ie,1)
-                  call icopy(buf(2),iedge,1)
-                  buf(3) = curve(iedge,ie)
-                  buf(4) = zero
-                  buf(5) = zero
-                  buf(6) = zero
-                  buf(7) = zero
-                  call chcopy(buf(8),'C',1)
-                  call byte_write(buf,8)
-               endif
-            enddo
-         enddo
+         call buf_write(ncurv,1)  
       else
          rcurv=ncurv
-         call byte_write(rcurv,2)  
-         do ie=1,nel
-            do iedge = 2,maxedge,2
-               if (curve(iedge,ie).ne.0) then
-                  buf2(1) = ie
-                  buf2(2) = iedge
-                  buf2(3) = curve(iedge,ie)
-                  buf2(4) = zero
-                  buf2(5) = zero
-                  buf2(6) = zero
-                  buf2(7) = zero
-                  call chcopy(buf2(8),'C',1)
-                  call byte_write(buf,16)
-               endif
-            enddo
-         enddo
+         call buf_write(rcurv,2)  
       endif
 
+c     Only circle boxes carry curves (r2 on the outer, -r1 on the inner
+c     arcs), they depend on the radial index i alone.
+      ie = 0
+      do ibox=1,nbox
+         nelb = nlx(ibox)*nly(ibox)*nlz(ibox)
+         if (boxcirc(ibox).eq.'c'.or.boxcirc(ibox).eq.'C') then
+            do ieb=1,nelb
+               ie = ie+1
+               i  = mod1(ieb,nlx(ibox))
+               r1 = x(i-1,ibox)
+               r2 = x(i  ,ibox)
+               do iedge = 2,maxedge,2
+                  rc = r2
+                  if (mod(iedge,4).eq.0) rc = -r1
+                  if (rc.ne.0) call out_curve(ie,iedge,rc,nel,iffo)
+               enddo
+            enddo
+         else
+            ie = ie+nelb
+         endif
+      enddo
+
  
 c----------------------------------------------------------------------
 c     output Boundary conditions
@@ -978,10 +935,10 @@ c     output Boundary conditions
 
              if (ipass.eq.2 .and. .not. iffo) then
                 if(wdsize.eq.4) then
-                   call byte_write(nbc,1)
+                   call buf_write(nbc,1)
                 else
                    rbc=nbc
-                   call byte_write(rbc,2)
+                   call buf_write(rbc,2)
                 endif
              endif
              do ibx=1,nbox
@@ -1148,7 +1105,7 @@ c
                        call copy48(buf(3),rbc3,5)
                        call chcopy(buf(8),cbc3,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(3),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                        icount = icount+1
                      endif
                      if(cbc2.ne.'E  ') then 
@@ -1156,7 +1113,7 @@ c
                        call copy48(buf(3),rbc2,5)
                        call chcopy(buf(8),cbc2,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(2),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                        icount = icount+1
                      endif
                      if(cbc4.ne.'E  ') then 
@@ -1164,7 +1121,7 @@ c
                        call copy48(buf(3),rbc4,5)
                        call chcopy(buf(8),cbc4,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(4),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                        icount = icount+1
                      endif
                      if(cbc1.ne.'E  ') then 
@@ -1172,7 +1129,7 @@ c
                        call copy48(buf(3),rbc1,5)
                        call chcopy(buf(8),cbc1,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(1),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                        icount = icount+1
                      endif
                      if(cbc5.ne.'E  ') then 
@@ -1180,7 +1137,7 @@ c
                       call copy48(buf(3),rbc5,5)
                       call chcopy(buf(8),cbc5,3)
                       if(nel.ge.1000000) call icopy(buf(3),ibc(5),1)
-                      call byte_write(buf,8)
+                      call buf_write(buf,8)
                       icount = icount+1
                      endif
                      if(cbc6.ne.'E  ') then 
@@ -1188,7 +1145,7 @@ c
                       call copy48(buf(3),rbc6,5)
                       call chcopy(buf(8),cbc6,3)
                       if(nel.ge.1000000) call icopy(buf(3),ibc(6),1)
-                      call byte_write(buf,8)
+                      call buf_write(buf,8)
                       icount = icount+1
                      endif
                    else
@@ -1198,7 +1155,7 @@ c
                        call copy(buf2(3),rbc3,5)
                        call chcopy(buf2(8),cbc3,3)
                        if(nel.ge.1000000) buf2(3)=ibc(3)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                        icount = icount+1
                      endif
                      if(cbc2.ne.'E  ') then 
@@ -1206,7 +1163,7 @@ c
                         call copy  (buf2(3),rbc2,5)
                         call chcopy(buf2(8),cbc2,3)
                         if(nel.ge.1000000) buf(3)=ibc(2)
-                        call byte_write(buf,16)
+                        call buf_write(buf,16)
                         icount = icount+1
                      endif
                      if(cbc4.ne.'E  ') then 
@@ -1214,7 +1171,7 @@ c
                        call copy  (buf2(3),rbc4,5)
                        call chcopy(buf2(8),cbc4,3)
                        if(nel.ge.1000000) buf2(3)=ibc(4)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                        icount = icount+1
                      endif
                      if(cbc1.ne.'E  ') then 
@@ -1222,7 +1179,7 @@ c
                        call copy  (buf2(3),rbc1,5)
                        call chcopy(buf2(8),cbc1,3)
                        if(nel.ge.1000000) buf2(3)=ibc(1)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                        icount = icount+1
                      endif
                      if(cbc5.ne.'E  ') then 
@@ -1230,7 +1187,7 @@ c
                       call copy  (buf2(3),rbc5,5)
                       call chcopy(buf2(8),cbc5,3)
                       if(nel.ge.1000000) buf2(3)=ibc(5)
-                      call byte_write(buf,16)
+                      call buf_write(buf,16)
                       icount = icount+1
                      endif
                      if(cbc6.ne.'E  ') then 
@@ -1238,7 +1195,7 @@ c
                       call copy  (buf2(3),rbc6,5)
                       call chcopy(buf2(8),cbc6,3)
                       if(nel.ge.1000000) buf2(3)=ibc(6)
-                      call byte_write(buf,16)
+                      call buf_write(buf,16)
                       icount = icount+1
                      endif
                    endif
@@ -1257,10 +1214,10 @@ c
              ie = 0
              if(ipass.eq.2 .and. .not. iffo) then
                 if(wdsize.eq.4) then
-                   call byte_write(nbc,1)
+                   call buf_write(nbc,1)
                 else
                    rbc=nbc
-                   call byte_write(rbc,2)
+                   call buf_write(rbc,2)
                 endif
              endif
              do ibx=1,nbox
@@ -1377,7 +1334,7 @@ c
                        call copy48(buf(3),rbc3,5)
                        call chcopy(buf(8),cbc3,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(3),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                      endif
  
                      if(cbc2.ne.'E  ') then 
@@ -1385,7 +1342,7 @@ c
                        call copy48(buf(3),rbc2,5)
                        call chcopy(buf(8),cbc2,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(2),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                      endif
  
                      if(cbc4.ne.'E  ') then 
@@ -1393,7 +1350,7 @@ c
                        call copy48(buf(3),rbc4,5)
                        call chcopy(buf(8),cbc4,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(4),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                      endif
  
                      if(cbc1.ne.'E  ') then 
@@ -1401,7 +1358,7 @@ c
                        call copy48(buf(3),rbc1,5)
                        call chcopy(buf(8),cbc1,3)
                        if(nel.ge.1000000) call icopy(buf(3),ibc(1),1)
-                       call byte_write(buf,8)
+                       call buf_write(buf,8)
                      endif 
                    else
                      buf2(1)=ie
@@ -1411,7 +1368,7 @@ c
                        call copy(buf2(3),rbc3,5)
                        call chcopy(buf2(8),cbc3,3)
                        if(nel.ge.1000000) buf2(3)=ibc(3)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                      endif
  
                      if(cbc2.ne.'E  ') then 
@@ -1419,7 +1376,7 @@ c
                        call copy(buf2(3),rbc2,5)
                        call chcopy(buf2(8),cbc2,3)
                        if(nel.ge.1000000) buf2(3)=ibc(2)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                      endif
  
                      if(cbc4.ne.'E  ') then 
@@ -1427,7 +1384,7 @@ c
                        call copy(buf2(3),rbc4,5)
                        call chcopy(buf2(8),cbc4,3)
                        if(nel.ge.1000000) buf2(3)=ibc(4)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                      endif
  
                      if(cbc1.ne.'E  ') then 
@@ -1435,7 +1392,7 @@ c
                        call copy(buf2(3),rbc1,5)
                        call chcopy(buf2(8),cbc1,3)
                        if(nel.ge.1000000) buf2(3)=ibc(1)
-                       call byte_write(buf,16)
+                       call buf_write(buf,16)
                      endif
                    endif
                  endif
@@ -1464,9 +1421,222 @@ c       Scan through and output .rea file until end of file
         close(8)
         close(9)
       else
+        call buf_flush
         call byte_close()
+        if (nbox.eq.1 .and. boxcirc(1).ne.'c'.and.boxcirc(1).ne.'C')
+     $     call out_box_map(nlx,nly,nlz,cbc,if3d)
+      endif
+
+      end
+c-----------------------------------------------------------------------
+      subroutine out_curve(ie,iedge,c,nel,iffo)
+c
+c     output curved side iedge of element ie (circle of radius c)
+c
+#     include "SIZE"
+
+      logical iffo
+
+      real*4 buf (16)
+      real   buf2(8)
+      equivalence (buf,buf2)
+
+      zero = 0.
+      if (iffo) then
+         if (nel.lt.1000) then
+            write(9,290) iedge,ie,c,(zero,k=1,4),'C'
+         elseif(nel.lt.1 000 000) then
+            write(9,291) iedge,ie,c,(zero,k=1,4),'C'
+         else
+            write(9,292) iedge,ie,c,(zero,k=1,4),'C'
+         endif
+  290    format(i3,i3,5g14.6,1x,a1)
+  291    format(i2,i6,5g14.6,1x,a1)
+  292    format(i2,i12,5g14.6,1x,a1)
+      elseif(wdsize.eq.4) then
+         call icopy(buf(1),ie,1)
+         call icopy(buf(2),iedge,1)
+         buf(3) = c
+         buf(4) = zero
+         buf(5) = zero
+         buf(6) = zero
+         buf(7) = zero
+         call blank(buf(8),4)
+         call chcopy(buf(8),'C',1)
+         call buf_write(buf,8)
+      else
+         buf2(1) = ie
+         buf2(2) = iedge
+         buf2(3) = c
+         buf2(4) = zero
+         buf2(5) = zero
+         buf2(6) = zero
+         buf2(7) = zero
+         call blank(buf2(8),8)
+         call chcopy(buf2(8),'C',1)
+         call buf_write(buf,16)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buf_write(a,n)
+c
+c     Stage n 4-byte words for byte_write, the .re2/.ma2 records are
+c     handed to byte.c in chunks of lbufw words (see buf_flush).
+c
+      integer a(n)
+
+      parameter (lbufw=262144)
+      common /genbw/ nbufw,ibufw(lbufw)
+
+      if (nbufw+n.gt.lbufw) call buf_flush
+      if (n.gt.lbufw) then
+         call byte_write(a,n)
+      else
+         do i=1,n
+            ibufw(nbufw+i) = a(i)
+         enddo
+         nbufw = nbufw+n
       endif
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buf_flush
+c
+c     write out the words staged by buf_write
+c
+      parameter (lbufw=262144)
+      common /genbw/ nbufw,ibufw(lbufw)
+
+      if (nbufw.gt.0) call byte_write(ibufw,nbufw)
+      nbufw = 0
+
+      return
+      end
+c-----------------------------------------------------------------------
+      block data genbwd
+      parameter (lbufw=262144)
+      common /genbw/ nbufw,ibufw(lbufw)
+      data nbufw /0/
+      end
+c-----------------------------------------------------------------------
+      subroutine out_box_map(nlx,nly,nlz,cbc,if3d)
+c
+c     Write box.ma2 for a single box so genmap can be skipped.
+c
+c     Vertices are numbered lexicographically on the (nelx+1)(nely+1)
+c     (nelz+1) lattice, a direction with 'P  ' on both faces of the
+c     first field wraps around.  Elements are listed in recursive
+c     coordinate bisection order of the index box: the contiguous
+c     blocks nek hands to each rank (map2.f) are compact sub-boxes.
+c
+#     include "SIZE"
+
+      integer nlx(1),nly(1),nlz(1)
+      character*3 cbc(6,mbox,20)
+      logical if3d
+
+      integer n(3),nv(3),lo(3),hi(3),ijk(3),irow(9)
+      logical ifp(3)
+      parameter (lstk=200)
+      integer stk(2,3,lstk)
+
+      integer depth,d2
+      character*132 hdr
+      real*4 test
+      data   test  / 6.54321 /
+
+      ndim = 2
+      if (if3d) ndim = 3
+      nvrt = 2**ndim
+      n(1) = nlx(1)
+      n(2) = nly(1)
+      n(3) = nlz(1)
+
+      do id=1,3
+         ifp(id) = .false.
+         nv(id)  = n(id)+1
+         if (id.le.ndim .and. cbc(2*id-1,1,1).eq.'P  '
+     $                  .and. cbc(2*id  ,1,1).eq.'P  ') then
+            if (n(id).lt.2) then
+               write(6,*) 'Skipping box.ma2, periodic direction',id,
+     $                    ' needs 2 elements or more, run genmap'
+               return
+            endif
+            ifp(id) = .true.
+            nv(id)  = n(id)
+         endif
+      enddo
+      if (.not.if3d) nv(3) = 1
+
+      nel  = n(1)*n(2)*n(3)
+      nrnk = nv(1)*nv(2)*nv(3)
+      npts = nel*nvrt
+      depth = int(log(real(nel))/log(2.)+1.e-6)
+      d2    = 2**depth
+
+      call byte_open('box.ma2' // char(0))
+      call blank(hdr,132)
+      write(hdr,1) '#v002',nel,nrnk,depth,d2,npts,nrnk,0
+    1 format(a5,7i12)
+      call buf_write(hdr,132/4)
+      call buf_write(test,1)
+
+c     Depth first walk over the bisection tree with an explicit stack,
+c     the lower half of each split is visited first
+      nstk = 1
+      do id=1,3
+         stk(1,id,1) = 1
+         stk(2,id,1) = n(id)
+      enddo
+
+  10  if (nstk.gt.0) then
+         do id=1,3
+            lo(id) = stk(1,id,nstk)
+            hi(id) = stk(2,id,nstk)
+         enddo
+         nstk = nstk-1
+
+         mx = 1
+         do id=2,ndim
+            if (hi(id)-lo(id).gt.hi(mx)-lo(mx)) mx = id
+         enddo
+
+         if (hi(mx).gt.lo(mx)) then
+            if (nstk+2.gt.lstk) call exitt
+            mid = (lo(mx)+hi(mx))/2
+            do k=1,2
+               do id=1,3
+                  stk(1,id,nstk+k) = lo(id)
+                  stk(2,id,nstk+k) = hi(id)
+               enddo
+            enddo
+            stk(1,mx,nstk+1) = mid+1
+            stk(2,mx,nstk+2) = mid
+            nstk = nstk+2
+         else
+            irow(1) = lo(1) + n(1)*(lo(2)-1 + n(2)*(lo(3)-1))
+            do iv=0,nvrt-1
+               ijk(1) = lo(1)-1 +     mod(iv,2)
+               ijk(2) = lo(2)-1 + mod(iv/2,2)
+               ijk(3) = lo(3)-1 +     iv/4
+               do id=1,3
+                  if (ifp(id)) ijk(id) = mod(ijk(id),n(id))
+               enddo
+               irow(iv+2) = 1 + ijk(1) + nv(1)*(ijk(2) + nv(2)*ijk(3))
+            enddo
+            call buf_write(irow,nvrt+1)
+         endif
+         goto 10
+      endif
+
+      call buf_flush
+      call byte_close()
+      write(6,*) 'wrote box.ma2 for',nel,' elements'
+
+      return
       end
 c-----------------------------------------------------------------------
       subroutine scanout(string,input,len,infile,outfile)
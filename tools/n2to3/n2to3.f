@@ -150,6 +150,7 @@ c     write(6,*) len,(file1(k),k=1,len+4)
 
       close (unit=10)
       close (unit=11)
+      if (itype.eq.1) call buf_flush
       call byte_close(fout2)
 
       stop
@@ -316,8 +317,8 @@ c
         call blank(hdr,80)
         write(hdr,111) neln,ndim3,neln       ! writes out header for .re2
   111   format('#v002',i9,i3,i9,' hdr')
-        call byte_write(hdr,20)              ! assumes byte_open() already issued
-        call byte_write(test,1)              ! write the endian discriminator
+        call buf_write(hdr,20)              ! assumes byte_open() already issued
+        call buf_write(test,1)              ! write the endian discriminator
 
         call rea2re2(dzi,zmin,cb5,cb6,ifflow,ifheat,ifper,ifmhd)
 
@@ -684,7 +685,7 @@ c     Read bc from .rea
          endif
          
          r_nb=nb
-         call byte_write(r_nb,2)
+         call buf_write(r_nb,2)
 
          do e = 1,nel
 c           Set bc and cbc
@@ -735,7 +736,7 @@ c           Set bc and cbc
                call blank     (buf(8),8)
                call chcopy    (buf(8),cbc(k,e),3)
                if(neln.ge.1000000) buf(3)=ibc(k,e)
-               call byte_write(buf,16)
+               call buf_write(buf,16)
             endif
             enddo
             cbc(5,e) = 'E  '
@@ -798,7 +799,7 @@ c              Periodic bc's on Z plane
                  call blank     (buf(8),8)
                  call chcopy    (buf(8),cbc(k,e),3)
                  if(neln.ge.1000000) buf(3)=ibc(k,e)
-                 call byte_write(buf,16)
+                 call buf_write(buf,16)
                  endif
                enddo
             enddo
@@ -867,7 +868,7 @@ c-----------------------------------------------------------------------
 
          do e=1,nel
             rgroup=igroup
-            call byte_write(rgroup, 2)
+            call buf_write(rgroup, 2)
             if (ifcirc) then ! Sweep in circular arc
 
                call sweep_circ(xc,yc,zc,x(1,e),y(1,e),4,z0)             ! z0=theta
@@ -898,7 +899,7 @@ c-----------------------------------------------------------------------
                buf(23) = zc(3)
                buf(24) = zc(4)
 
-               call byte_write(buf,48)
+               call buf_write(buf,48)
 
             else   ! Translate data in z direction (std n2to3)
 
@@ -926,7 +927,7 @@ c-----------------------------------------------------------------------
                buf(22) = z1
                buf(23) = z1
                buf(24) = z1
-               call byte_write(buf,48)
+               call buf_write(buf,48)
 
             endif
 
@@ -936,6 +937,48 @@ c-----------------------------------------------------------------------
       
       return
       end
+c-----------------------------------------------------------------------
+      subroutine buf_write(a,n)
+c
+c     Stage n 4-byte words for byte_write, the extruded records are
+c     handed to byte.c in chunks of lbufw words (see buf_flush).
+c
+      integer a(n)
+
+      parameter (lbufw=262144)
+      common /n23bw/ nbufw,ibufw(lbufw)
+
+      if (nbufw+n.gt.lbufw) call buf_flush
+      if (n.gt.lbufw) then
+         call byte_write(a,n)
+      else
+         do i=1,n
+            ibufw(nbufw+i) = a(i)
+         enddo
+         nbufw = nbufw+n
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buf_flush
+c
+c     write out the words staged by buf_write
+c
+      parameter (lbufw=262144)
+      common /n23bw/ nbufw,ibufw(lbufw)
+
+      if (nbufw.gt.0) call byte_write(ibufw,nbufw)
+      nbufw = 0
+
+      return
+      end
+c-----------------------------------------------------------------------
+      block data n23bwd
+      parameter (lbufw=262144)
+      common /n23bw/ nbufw,ibufw(lbufw)
+      data nbufw /0/
+      end
 c-----------------------------------------------------------------------
       subroutine bufchk(buf,n)
       real*8 buf(n)
@@ -1169,7 +1212,7 @@ C
      $    ,' Curved sides follow IEDGE,IEL,CURVE(I),I=1,5, CCURVE')
       else
          rcun=ncun
-         call byte_write(rcun,2)
+         call buf_write(rcun,2)
       endif
 
       ilev = 0
@@ -1221,7 +1264,7 @@ C
                  buf(14) = r4
                  buf(15) = r5
                  call chcopy(buf(16),ans,1)
-                 call byte_write(buf,32)
+                 call buf_write(buf,32)
                endif
             elseif (ans.eq.'m') then
                if(itype.eq.0) then
@@ -1256,7 +1299,7 @@ C
                  buf(14) = r4
                  buf(15) = r5
                  call chcopy(buf(16),ans,1)
-                 call byte_write(buf,32)
+                 call buf_write(buf,32)
                endif
             endif
    50      continue
@@ -1415,7 +1458,7 @@ c-----------------------------------------------------------------------
 
       elseif(ilast.eq.1.and.ipass.eq.2.and.itype.eq.1) then
           rcurve=ncurve
-          call byte_write(rcurve,2)
+          call buf_write(rcurve,2)
       endif
 
       ilast = ipass
@@ -1451,7 +1494,7 @@ c-----------------------------------------------------------------------
           buf(6) = r4
           buf(7) = r5
           call chcopy(buf(8),cc,1)
-          call byte_write(buf,16)
+          call buf_write(buf,16)
       endif
 
       return
@@ -57,7 +57,11 @@ c     an ascii rea file for just the parameters
 
       nfld = 1        ! CHANGE THIS IFHEAT etc.
 
-      call blank(cbc,3*6*lelt*ldimt1)
+      open(unit=io_xyz,status='scratch',form='unformatted')
+      open(unit=io_crv,status='scratch',form='unformatted')
+      do ifld=1,ldimt1
+         open(unit=io_bc+ifld-1,status='scratch',form='unformatted')
+      enddo
 
       do ifile=1,1000
 
@@ -79,17 +83,12 @@ c     an ascii rea file for just the parameters
            call exitt 
          endif
 
+         call rd_xyz  (io_xyz,dface(0,1,e),nel,ndim)
 
-         call rd_xyz (x(1,e),y(1,e),z(1,e),nel,ndim)
-
-         call rd_curve(ncurvn,ccurve(1,e),curve(1,1,e),nel,ndim)
+         call rd_curve(io_crv,ncurvn,nelo,nel)
          ncurve = ncurve + ncurvn
-c         write(6,*) ncurve,ncurvn,e,' NCURVE'
 
-         call rd_bdry(cbc(1,e,1),bc(1,1,e,1),ibc(1,e,1),string
-     $               ,nel,nelo,ndim,nfld,lelt)
-c        write(6,66) (cbc(k,1,1),k=1,12)
-c 66     format(6(1x,a3))
+         call rd_bdry (io_bc,string,nelo,nel,ndim,nfld)
 
       enddo
    99 continue
@@ -182,97 +181,176 @@ c         write(6,*) 'Opening binary file: ',(fout1(k),k=1,len)
       end
 c-----------------------------------------------------------------------
       subroutine set_ee_bcs ! connectivity 
-
+c
+c     Pair coincident faces through a hash of their centroids.
+c
+c     Faces a and b match when each centroid coordinate differs by
+c     less than sqrt(q*min(gap_a,gap_b)), gap being the element's min
+c     face to face distance^2 (get_side).  Each face is bucketed on a
+c     grid of width 2**lev just above its own tolerance, and looks up
+c     the 3**ndim neighbouring cells on every level up to its own, so
+c     a pair is found once, from the face with the larger tolerance,
+c     at O(1) cost per face instead of repeated global sorts.
+c
 #     include "SIZE"
       include 'INPUT'
 
       parameter (lf = 6*lelt)
-      common /cwork/ dx(4*lf),face(lf),ind(lf),ninseg(lf),ifseg(lf)
-      real    dx
-      integer face,ind,ninseg
-      logical ifseg
+      common /cwork/ lhead(lf),lnext(lf)
 
-      call get_side    (dx,x,y,z,nel,ndim)
-      call global_fnbr (face,dx,ndim,nel,ind,ninseg,ifseg)
-      call f_pairing(cbc,face,ndim,nel,nfld,lelt,ind)
+      parameter (mlev=256)
+      integer levs(mlev)
 
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine global_fnbr(face,dx,ndim,nel,ind,ninseg,ifseg)
-c
-c     Establish global numbering for faces, based on dx
-c
-      integer face(1),ind(1),ninseg(1)
-      logical ifseg(1)
-      real dx(0:ndim,1)
-      integer e
-      real dxt(4),t1(4),t2(4)
+      integer eface(6)
+      save    eface
+      data    eface  / 4,2,1,3,5,6 /
+
+      integer e,f,ea,fa,ic(3),jc(3),kc(3),ka(3)
+
+      q = 0.0010   ! Smaller is better
 
       nface = 2*ndim
-      n     = nface*nel
+      call izero(lhead ,lf)
+      call izero(nmatch,6*nel)
 
-      do i=1,n
-         face  (i) = i
-         ifseg (i) = .false.
+      nlev = 0
+      do e=1,nel
+      do f=1,nface
+         i = f+6*(e-1)
+         call face_cell(ic,lev,dface(0,f,e),ndim,q,0)
+         ih = ihash_cell(ic,lev,lf)
+         lnext(i)  = lhead(ih)
+         lhead(ih) = i
+         call iinsert(levs,nlev,mlev,lev)
+      enddo
       enddo
 
-c     Sort by directions
-
-      lda         = 1+ndim
-      nseg        = 1
-      ifseg(1)    = .true.
-      ninseg(1)   = n
-
-      do ipass=1,ndim   ! Multiple passes eliminates false positives
-      do j=1,ndim       ! Sort within each segment
-         write(6,*) 'locglob:',ipass,j,nseg,n
-         i =1
-         j1=j+1
-         do iseg=1,nseg
-            call tuple_sort(dx(0,i),lda,ninseg(iseg),j1,1,ind,dxt) ! key=j1
-            call iswap_ip  (face(i),ind,ninseg(iseg)) ! Swap position 
-            i  =   i + ninseg(iseg)
-         enddo
- 
-         q=0.2
-         q=0.0010   ! Smaller is better
-         do i=2,n
-           if ((dx(j,i)-dx(j,i-1))**2.gt.q*min(dx(0,i),dx(0,i-1)))
-     $        ifseg(i)=.true.
+      npair = 0
+      do e=1,nel
+      do f=1,nface
+         i  = f+6*(e-1)
+         call face_cell(ic,levi,dface(0,f,e),ndim,q,0)
+         kz = 0
+         if (ndim.eq.3) kz = 1
+
+         do il=1,nlev
+            lev = levs(il)
+            if (lev.gt.levi) goto 30
+            call face_cell(jc,lev,dface(0,f,e),ndim,q,1)
+
+            do iz=-kz,kz
+            do iy=-1,1
+            do ix=-1,1
+               kc(1) = jc(1)+ix
+               kc(2) = jc(2)+iy
+               kc(3) = jc(3)+iz
+               j = lhead(ihash_cell(kc,lev,lf))
+   10          if (j.eq.0) goto 20
+                  ea = (j-1)/6 + 1
+                  fa = j - 6*(ea-1)
+                  if (ea.eq.e) goto 15
+                  if (levi.eq.lev .and. j.ge.i) goto 15
+                  call face_cell(ka,leva,dface(0,fa,ea),ndim,q,0)
+                  if (leva.ne.lev)   goto 15
+                  if (ka(1).ne.kc(1) .or. ka(2).ne.kc(2)
+     $           .or. ka(3).ne.kc(3)) goto 15
+
+                  tol = q*min(dface(0,f,e),dface(0,fa,ea))
+                  do k=1,ndim
+                     if ((dface(k,f,e)-dface(k,fa,ea))**2.gt.tol)
+     $                  goto 15
+                  enddo
+                  nmatch(eface(f ),e ) = nmatch(eface(f ),e ) + 1
+                  nmatch(eface(fa),ea) = nmatch(eface(fa),ea) + 1
+                  npair = npair + 1
+
+   15             j = lnext(j)
+               goto 10
+   20          continue
+            enddo
+            enddo
+            enddo
          enddo
+   30    continue
+      enddo
+      enddo
 
-         nseg = 0              !  Count up number of different segments
-         do i=1,n
-            if (ifseg(i)) then
-               nseg = nseg+1
-               ninseg(nseg) = 1
-            else
-               ninseg(nseg) = ninseg(nseg) + 1
-            endif
-         enddo
+      do e=1,nel
+      do f=1,nface
+         if (nmatch(f,e).gt.1) then
+            write(6,*) 'FACE ERROR:',e,f,nmatch(f,e)
+            call exitt
+         endif
       enddo
       enddo
+
+      write(6,6) nlev,npair,nface*nel
+    6 format('done face hash:',3i12)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine face_cell(ic,lev,dx,ndim,q,ifix)
+c
+c     Hash grid cell of face centroid dx(1:ndim); the level lev is
+c     derived from the face tolerance unless ifix=1 (lev given)
+c
+      integer ic(3)
+      real dx(0:3)
+
+      if (ifix.eq.0) then
+         r   = max(sqrt(q*dx(0)),1.e-30)
+         lev = int(log(r)/log(2.))
+         if (2.**lev.lt.r) lev = lev+1
+      endif
+
+      h = 2.**lev
+      ic(3) = 0
+      do k=1,ndim
+         t = max(-2.e9,min(2.e9,dx(k)/h))
+         ic(k) = int(t)
+         if (t.lt.ic(k)) ic(k) = ic(k)-1   ! floor
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      function ihash_cell(ic,lev,n)
 c
-c     Unshuffle geometry
+c     Slot in 1..n of hash grid cell (ic,lev)
 c
-      call tuple_swapt_ip(dx,lda,n,face,t1,t2)
+      integer ic(3)
+      integer*8 k
+
+      k = 73856093_8*ic(1) + 19349663_8*ic(2) + 83492791_8*ic(3)
+     $  + 2654435_8*lev
+      ihash_cell = mod(abs(k),int(n,8)) + 1
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine iinsert(list,n,nmax,k)
 c
-c     Assign global node numbers (now sorted lexigraphically!)
+c     Insert k into the ascending list(1:n) unless present
 c
-      ig = 0
+      integer list(nmax)
+
       do i=1,n
-         if (ifseg(i)) ig=ig+1
-         ind(face(i)) = ig
+         if (list(i).eq.k) return
+         if (list(i).gt.k) goto 10
       enddo
-      nglb = ig
-      call icopy(face,ind,n)
-c          do ik=1,n
-c             write(15,*) dx(1,ik),dx(2,ik),ik
-c          enddo
+      i = n+1
+   10 continue
 
-      write(6,6) nseg,nglb,n
-    6 format('done locglob_lexico:',3i12)
+      if (n.eq.nmax) then
+         write(6,*) 'ABORT: too many face levels',nmax
+         call exitt
+      endif
+      do j=n,i,-1
+         list(j+1) = list(j)
+      enddo
+      list(i) = k
+      n = n+1
 
       return
       end
@@ -342,48 +420,6 @@ c-----------------------------------------------------------------------
 
       enddo
 
-      return
-      end
-c-----------------------------------------------------------------------
-      subroutine f_pairing(cbc,face,ndim,nel,nfld,lelt,work)
-
-      character*3 cbc(6,lelt,ndim)
-      integer face(2*ndim,nel),work(1)
-
-      integer eface(6)
-      save    eface
-      data    eface  / 4,2,1,3,5,6 /
-
-      integer e,f
-
-      nface = 2*ndim
-      n     = nface*nel
-      call izero(work,n)
-      do e=1,nel
-      do f=1,nface
-         i = face(f,e)
-         work(i) = work(i)+1
-      enddo
-      enddo
-
-      do e=1,nel
-      do f=1,nface
-         i = face(f,e)
-
-c        write(6,4) i,work(i),f,e,cbc(f,e,1)
-c  4     format(4i9,2x,a3)
-
-         if (work(i).eq.2) then    ! we have adjoining faces
-            do k=1,nfld
-               cbc(eface(f),e,k) = 'E  '  ! This is equivalent to E-E
-            enddo
-         elseif (work(i).gt.2) then    ! we have adjoining faces
-            write(6,*) 'FACE ERROR:',e,f,i,work(i)
-            call exitt
-         endif
-      enddo
-      enddo
-
       return
       end
 c-----------------------------------------------------------------------
@@ -416,6 +452,11 @@ c     output remainder of mesh: .rea/.re2 format
       save   test
       data   test  / 6.54321 /
 
+      real x(8),y(8),z(8),curve(6),bc(5)
+      character*1 ccurve
+      character*4 ccurv4
+      character*3 cbc
+
       integer e,f
 
 
@@ -433,28 +474,30 @@ c     output remainder of mesh: .rea/.re2 format
 c      call strg_write(hdr,20)   ! assumes byte_open() already issued
 c      call strg_write(test,1)   ! write the endian discriminator
 
+      rewind(io_xyz)
       do e=1,nel      
          if (mod(e,10000).eq.0) write(6,*) e,nel,' mesh'
+         read(io_xyz) x,y,z
 
          igroup = 0
          call byte_write(igroup, 1)
 c         call  int_write(igroup, 1)
 
          if (ndim.eq.3) then
-            call byte_write(x(1,e),8)
-            call byte_write(y(1,e),8)
-            call byte_write(z(1,e),8)
+            call byte_write(x,8)
+            call byte_write(y,8)
+            call byte_write(z,8)
 
-c            call real_write(x(1,e),8)
-c            call real_write(y(1,e),8)
-c            call real_write(z(1,e),8)
+c            call real_write(x,8)
+c            call real_write(y,8)
+c            call real_write(z,8)
 
          else
-            call byte_write(x(1,e),4)
-            call byte_write(y(1,e),4)
+            call byte_write(x,4)
+            call byte_write(y,4)
 
-c            call real_write(x(1,e),4)
-c            call real_write(y(1,e),4)
+c            call real_write(x,4)
+c            call real_write(y,4)
          endif
 
       enddo
@@ -462,52 +505,45 @@ c            call real_write(y(1,e),4)
       nface = 2*ndim
 
       call byte_write(ncurve,1)
-      if (ncurve.gt.0) then
-         do e=1,nel      
-         do f=1,nface
-            if (ccurve(f,e).ne.' ') then
-               call byte_write(e     ,1)
-               call byte_write(f     ,1)
-               call byte_write(curve(1,f,e),5)
-               call byte_write(ccurve(f,e),1) ! writing 4 bytes, but ok
-            
-c               call  int_write(e     ,1)
-c               call  int_write(f     ,1)
-c               call real_write(curve(1,f,e),5)
-c               call strg_write(ccurve(f,e),1) ! writing 4 bytes, but ok
-            endif
-         enddo
-         enddo
-      endif
+      rewind(io_crv)
+      do i=1,ncurve
+         read(io_crv) e,k,curve,ccurve
+         call byte_write(e     ,1)
+         call byte_write(k     ,1)
+         call byte_write(curve ,5)
+         ccurv4 = ccurve
+         call byte_write(ccurv4,1)
+      enddo
          
 
       do ifld = 1,nfld
+         io  = io_bc+ifld-1
          nbc = 0
-         do e=1,nel
-         do f=1,nface
-            if (cbc(f,e,ifld).ne.'E  '.and.cbc(f,e,ifld).ne.'   ')
+         rewind(io)
+    5    read(io,end=6) e,f,cbc
+            if (cbc.ne.'E  '.and.cbc.ne.'   '.and.nmatch(f,e).eq.0)
      $         nbc = nbc+1
-         enddo
-         enddo
+         goto 5
+    6    continue
 
          write(6,*) ifld,nbc,' Number of bcs'
          call byte_write(nbc,1)
 c         call  int_write(nbc,1)
 
-         do e=1,nel
-         do f=1,nface
-            if (cbc(f,e,ifld).ne.'E  '.and.cbc(f,e,ifld).ne.'   ') then
+         rewind(io)
+    7    read(io,end=8) e,f,cbc,bc,ibc
+            if (cbc.ne.'E  '.and.cbc.ne.'   '.and.nmatch(f,e).eq.0) then
                call icopy      (buf(1),e,1)
                call icopy      (buf(2),f,1)
-               call copy       (buf(3),bc(1,f,e,ifld),5)
+               call copy       (buf(3),bc,5)
                call blank      (buf(8),4)
-               call chcopy     (buf(8),cbc(f,e,ifld),3)
-               if(nel.ge.1000000) call icopy(buf(3),ibc(f,e,ifld),1)
+               call chcopy     (buf(8),cbc,3)
+               if(nel.ge.1000000) call icopy(buf(3),ibc,1)
                call byte_write (buf,8)
 c               call bdry_write (buf,8)
             endif
-         enddo
-         enddo
+         goto 7
+    8    continue
 
       enddo
 
@@ -552,10 +588,13 @@ c-----------------------------------------------------------------------
 #     include "SIZE"
       include 'INPUT'
 
+      real x(8),y(8),z(8)
       integer e
 
       igroup = 0
+      rewind(io_xyz)
       do e=1,nelt
+         read(io_xyz) x,y,z
          if(nelt.lt.100000) then
            write (11,12) e, e, 'a', igroup
          else
@@ -564,15 +603,15 @@ c-----------------------------------------------------------------------
          endif
 
          if (ndim.eq.2) then
-            write(11,90)  (x(k,e),k=1,4)
-            write(11,90)  (y(k,e),k=1,4)
+            write(11,90)  (x(k),k=1,4)
+            write(11,90)  (y(k),k=1,4)
          else
-            write(11,90)  (x(k,e),k=1,4)
-            write(11,90)  (y(k,e),k=1,4)
-            write(11,90)  (z(k,e),k=1,4)
-            write(11,90)  (x(k,e),k=5,8)
-            write(11,90)  (y(k,e),k=5,8)
-            write(11,90)  (z(k,e),k=5,8)
+            write(11,90)  (x(k),k=1,4)
+            write(11,90)  (y(k),k=1,4)
+            write(11,90)  (z(k),k=1,4)
+            write(11,90)  (x(k),k=5,8)
+            write(11,90)  (y(k),k=5,8)
+            write(11,90)  (z(k),k=5,8)
          endif
       enddo
 
@@ -590,7 +629,9 @@ c     .Ouput curve side data in ascii to unit 11
 #     include "SIZE"
       include 'INPUT'
 
-      integer e,f
+      real curve(6)
+      character*1 ccurve
+      integer e
 
 
       write(11,11)
@@ -600,26 +641,20 @@ c     .Ouput curve side data in ascii to unit 11
    12 format(i12
      $ ,' Curved sides follow IEDGE,IEL,CURVE(I),I=1,5, CCURVE')
 
-      if (ncurve.gt.0) then
-         do e=1,nel
-         do k=1,12
-            if (ccurve(k,e).ne.' ') then
-               call cleanr(curve(1,k,e),5)
-               if (nelt.lt.1000) then
-                  write(11,60) k,e,(curve(j,k,e),j=1,5),ccurve(k,e)
-               elseif (nelt.lt.1 000 000) then
-                  write(11,61) k,e,(curve(j,k,e),j=1,5),ccurve(k,e)
-               else
-                  write(11,62) k,e,(curve(j,k,e),j=1,5),ccurve(k,e)
-               endif
-            endif
-         enddo
-         enddo
-   50    continue
-   60    format(i3,i3,1p5g14.6,1x,a1)
-   61    format(i2,i6,1p5g14.6,1x,a1)
-   62    format(i2,i12,1p5g14.6,1x,a1)
-      endif
+      rewind(io_crv)
+      do i=1,ncurve
+         read(io_crv) e,k,curve,ccurve
+         if (nelt.lt.1000) then
+            write(11,60) k,e,(curve(j),j=1,5),ccurve
+         elseif (nelt.lt.1 000 000) then
+            write(11,61) k,e,(curve(j),j=1,5),ccurve
+         else
+            write(11,62) k,e,(curve(j),j=1,5),ccurve
+         endif
+      enddo
+   60 format(i3,i3,1p5g14.6,1x,a1)
+   61 format(i2,i6,1p5g14.6,1x,a1)
+   62 format(i2,i12,1p5g14.6,1x,a1)
 
       return
       end
@@ -631,13 +666,12 @@ c     .Ouput bdry data
 #     include "SIZE"
       include 'INPUT'
 
-      integer e,f,fld
-
-      integer eface(6)
-      save    eface
-      data    eface  / 4,2,1,3,5,6 /
+      integer e,f,fld,er,fr
 
       real*8 bc8(6)
+
+      real bc(5),bcr(5)
+      character*3 cbc,cbcr
 c
 c
       write(11,31) 
@@ -654,18 +688,39 @@ c
    43    format('  ***** PASSIVE SCALAR',i2
      $                       ,'  BOUNDARY CONDITIONS *****')
 
+c        faces without a record (no bcs in that file) are blank
+         io = io_bc+fld-1
+         rewind(io)
+         er = 0
+         read(io,end=10) er,fr,cbcr,bcr,ibcr
+   10    continue
+
          nface = 2*ndim
          do e=1,nel
          do f=1,nface
+            if (e.eq.er .and. f.eq.fr) then
+               cbc = cbcr
+               call copy(bc,bcr,5)
+               ibc = ibcr
+               er  = 0
+               read(io,end=15) er,fr,cbcr,bcr,ibcr
+   15          continue
+            else
+               cbc = '   '
+               call rzero(bc,5)
+               ibc = 0
+            endif
+            if (nmatch(f,e).eq.1) cbc = 'E  '  ! equivalent to E-E
+
             if (nel.lt.1000) then
-               write(11,20) cbc(f,e,fld),e,f,(bc(j,f,e,fld),j=1,5)
+               write(11,20) cbc,e,f,(bc(j),j=1,5)
             elseif (nel.lt.100000) then
-               write(11,21) cbc(f,e,fld),e,f,(bc(j,f,e,fld),j=1,5)
+               write(11,21) cbc,e,f,(bc(j),j=1,5)
             elseif (nel.lt.1000000) then
-               write(11,22) cbc(f,e,fld),e,(bc(j,f,e,fld),j=1,5)
+               write(11,22) cbc,e,(bc(j),j=1,5)
             else
-               bc8(f) = ibc(f,e,fld)
-               write(11,23) cbc(f,e,fld),e,bc8(f),(bc(j,f,e,fld),j=2,5)
+               bc8(f) = ibc
+               write(11,23) cbc,e,bc8(f),(bc(j),j=2,5)
             endif
 
    20       format(1x,a3,2i3,5g14.6)
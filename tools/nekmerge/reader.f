@@ -51,47 +51,58 @@ c
       return
       end
 c-----------------------------------------------------------------------
-      subroutine rd_xyz (x,y,z,nel,ndim)
+      subroutine rd_xyz (io,dface,nel,ndim)
 c
-      real x(8,nel),y(8,nel),z(8,nel)
-      integer e
+c     Stream the vertices to unit io, keeping only the face centroids
+c
+      real dface(0:3,6,nel)
+      real x(8),y(8),z(8),dx(0:3,6)
+      integer e,f
       character*80 string
 
-      if (ndim.eq.3) then
-         do e=1,nel
+      call rzero(z,8)
+      do e=1,nel
+         if (ndim.eq.3) then
             read (10,80) string
-            read (10,*)   (x(k,e),k=1,4)
-            read (10,*)   (y(k,e),k=1,4)
-            read (10,*)   (z(k,e),k=1,4)
-            read (10,*)   (x(k,e),k=5,8)
-            read (10,*)   (y(k,e),k=5,8)
-            read (10,*)   (z(k,e),k=5,8)
-         enddo
-      else
-         do e=1,nel
+            read (10,*)   (x(k),k=1,4)
+            read (10,*)   (y(k),k=1,4)
+            read (10,*)   (z(k),k=1,4)
+            read (10,*)   (x(k),k=5,8)
+            read (10,*)   (y(k),k=5,8)
+            read (10,*)   (z(k),k=5,8)
+         else
             read (10,80) string
-            read (10,*)   (x(k,e),k=1,4)
-            read (10,*)   (y(k,e),k=1,4)
+            read (10,*)   (x(k),k=1,4)
+            read (10,*)   (y(k),k=1,4)
+         endif
+         write(io) x,y,z
+
+         call get_side (dx,x,y,z,1,ndim)   ! dx(0:ndim,2*ndim)
+         l = 0
+         do f=1,2*ndim
+            call rzero(dface(0,f,e),4)
+            do k=0,ndim
+               dface(k,f,e) = dx(mod(l,4),l/4+1)
+               l = l+1
+            enddo
          enddo
-      endif
+      enddo
    80 format(a80)
 
       return
       end
 c-----------------------------------------------------------------------
-      subroutine rd_curve(ncurve,ccurve,curve,nel,ndim)
-
-      character*1 ccurve  (12,1),cc
-      real         curve(6,12,1)
+      subroutine rd_curve(io,ncurve,nelo,nel)
+c
+c     Stream the curve records (global element) to unit io
+c
+      character*1 cc
       integer e,f
 
       real buf(6)
 
       buf(6) = 0
 
-      call blank(ccurve,12*nel)
-      call rzero(curve ,72*nel)
-
       read(10,*)
       read(10,*) ncurve
       if (ncurve.gt.0) then
@@ -103,26 +114,25 @@ c-----------------------------------------------------------------------
             else
                read(10,62) f,e,(buf(k),k=1,5),cc
             endif
-            ccurve(f,e) = cc
-            call copy(curve(1,f,e),buf,6)
+            call cleanr(buf,5)  ! clean up small zeros
+            write(io) e+nelo,f,buf,cc
          enddo
    60    format(i3,i3,5g14.6,1x,a1)
    61    format(i2,i6,5g14.6,1x,a1)
    62    format(i2,i12,5g14.6,1x,a1)
       endif
 
-      call cleanr(curve ,72*nel)  ! clean up small zeros
-         
       return
       end
 c-----------------------------------------------------------------------
-      subroutine rd_bdry(cbc,bc,ibc,string,nel,nelo,ndim,nfld,lelt)
-
-      character*3  cbc (6,lelt,nfld) ! note: lelt reqd
-      real         bc(5,6,lelt,nfld) ! for memory reasons
+      subroutine rd_bdry(io,string,nelo,nel,ndim,nfld)
+c
+c     Stream the bc records (global element) of field j to io+j-1
+c
+      character*3  cbc
+      real         bc(5)
       character*80 string
       integer e,f
-      integer ibc (6,lelt,nfld)
 
       real*8 bc8(5)
 
@@ -137,15 +147,16 @@ c-----------------------------------------------------------------------
                do e=1,nel
                do f=1,nface
 
+                  ibc = 0
                   if (nel.lt.1 000) then
-                     read(10,20) cbc(f,e,j),(bc(k,f,e,j),k=1,5)
+                     read(10,20) cbc,(bc(k),k=1,5)
                   elseif (nel.lt.1 000 000) then
-                     read(10,21) cbc(f,e,j),(bc(k,f,e,j),k=1,5)
+                     read(10,21) cbc,(bc(k),k=1,5)
                   else
-                     read(10,22) cbc(f,e,j),(bc8(k),k=1,5)
-                     ibc(f,e,j) = bc8(1)
-                     do ii = 1,5
-                        bc(k,f,e,j) = bc8(k)
+                     read(10,22) cbc,(bc8(k),k=1,5)
+                     ibc = bc8(1)
+                     do k = 1,5
+                        bc(k) = bc8(k)
                      enddo
                   endif
    20             format(1x,a3,6x,5g14.7)
@@ -158,17 +169,17 @@ c
 c                    .Assumes that P-P pointer boundaries are not
 c                     eliminated during mesh merge
 c
-                  if (cbc(f,e,j).eq.'P  '.or.cbc(f,e,j).eq.'E  ')
-     $               bc(1,f,e,j) = bc(1,f,e,j) + nelo
-                  if (cbc(f,e,j).eq.'P  '.or.cbc(f,e,j).eq.'E  '.and.
-     $                 nel.ge.1000000)
-     $               ibc(f,e,j) = ibc(f,e,j) + nelo
+                  if (cbc.eq.'P  '.or.cbc.eq.'E  ') then
+                     bc(1) = bc(1) + nelo
+                     if (nel.ge.1000000) ibc = ibc + nelo
+                  endif
+
+                  call cleanr(bc,5)  ! clean up small zeros
+                  write(io+j-1) e+nelo,f,cbc,bc,ibc
 
                enddo
                enddo
 
-               call cleanr(bc(1,1,1,j),30*nel)  ! clean up small zeros
-
             endif
          else
             goto 51
@@ -17,10 +17,21 @@ Last Modification:
 /********************************bss_malloc.c**********************************
 File Description:
 -----------------
-
+perm_malloc() is for space that lives as long as the gs handle, bss_malloc()
+for scratch.  With MYMALLOC both are served by a size-class pool: requests
+are rounded up to a power of two (16 bytes .. 64K incl. a 16 byte header)
+and taken from/returned to a per-thread free list of that class, so alloc
+and free are O(1) and threads do not contend.  An empty list is refilled
+with a batch of blocks carved from the static buffer, then from mmap'd
+regions once it is exhausted (under a spin lock).  Larger requests are
+mmap'd on their own and unmapped by the free.  Blocks return to the list
+of the thread that frees them.
 *********************************bss_malloc.c*********************************/
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef MYMALLOC
+#include <sys/mman.h>
+#endif
 
 #if   defined NXSRC
 #ifndef DELTA
@@ -66,6 +77,12 @@ static int num_nodes=1;
 #ifdef MYMALLOC
 #define PERM_MALLOC_BUF  4194304 /* 16777216 8388608 4194304 31072 16384 */
 #define BSS_MALLOC_BUF   4194304 /* 524288  1048576 4194304 65536 */
+
+#define POOL_HDR      16         /* block header, keeps payload 16 aligned */
+#define POOL_MINSHIFT 4          /* smallest class 16 bytes                */
+#define POOL_NCLASS   13         /* largest class 64K                      */
+#define POOL_REFILL   65536      /* bytes carved per free list refill      */
+#define POOL_GROW     4194304    /* minimum mmap growth of a pool          */
 #endif
 
 
@@ -77,16 +94,187 @@ static int    perm_req       = 0;
 static int    num_perm_req   = 0;
 static int    num_perm_frees = 0;
 #ifdef MYMALLOC
-static double perm_buf[PERM_MALLOC_BUF/sizeof(double)];
-static double *perm_top = perm_buf;
+static double perm_buf[PERM_MALLOC_BUF/sizeof(double)]
+                         __attribute__((aligned(POOL_HDR)));
 #endif
 
 static int    bss_req        = 0;
 static int    num_bss_req    = 0;
 static int    num_bss_frees  = 0;
 #ifdef MYMALLOC
-static double bss_buf[BSS_MALLOC_BUF/sizeof(double)];
-static double *bss_top = bss_buf;
+static double bss_buf[BSS_MALLOC_BUF/sizeof(double)]
+                        __attribute__((aligned(POOL_HDR)));
+#endif
+
+#ifdef MYMALLOC
+/* block header: size class, or -1 and the mapped size for large blocks */
+typedef union {
+  struct {int cls; size_t size;} h;
+  double align[POOL_HDR/sizeof(double)];
+} pool_hdr;
+
+/* region blocks are carved from (static buffer first, then mmap) */
+typedef struct {
+  volatile int lock;
+  char *top, *end;
+} pool_region;
+
+static pool_region perm_pool = {0, (char *) perm_buf,
+                                (char *) perm_buf + PERM_MALLOC_BUF};
+static pool_region bss_pool  = {0, (char *) bss_buf,
+                                (char *) bss_buf + BSS_MALLOC_BUF};
+
+static __thread char *perm_list[POOL_NCLASS];
+static __thread char *bss_list[POOL_NCLASS];
+
+#define POOL_NEXT(b) (*(char **)((b) + POOL_HDR))
+
+
+
+/********************************bss_malloc.c**********************************
+Function: pool_class()
+
+Input : size of request in bytes
+Output: 
+Return: size class c (block of 2^(c+POOL_MINSHIFT) bytes incl. header) or
+        -1 if the request is larger than the largest class
+Description: 
+*********************************bss_malloc.c*********************************/
+static int
+pool_class(size_t size)
+{
+  int c = 0;
+  size_t b = (size_t) 1 << POOL_MINSHIFT;
+
+  size += POOL_HDR;
+  while (b < size && c < POOL_NCLASS)
+    {b <<= 1; c++;}
+  return(c < POOL_NCLASS ? c : -1);
+}
+
+
+
+/********************************bss_malloc.c**********************************
+Function: pool_map()
+
+Input : bytes
+Output: 
+Return: page aligned anonymous mapping of at least bytes, NULL on failure
+Description: 
+*********************************bss_malloc.c*********************************/
+static char *
+pool_map(size_t bytes)
+{
+  void *q = mmap(NULL,bytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,
+                 -1,0);
+  return(q == MAP_FAILED ? NULL : (char *) q);
+}
+
+
+
+/********************************bss_malloc.c**********************************
+Function: pool_carve()
+
+Input : region, bytes
+Output: 
+Return: bytes taken from the region, growing it by mmap when exhausted
+Description: 
+
+The tail of an exhausted region is left unused (less than one refill).
+*********************************bss_malloc.c*********************************/
+static char *
+pool_carve(pool_region *r, size_t bytes)
+{
+  char *p = NULL;
+
+  while (__sync_lock_test_and_set(&r->lock,1))
+    {;}
+
+  if ((size_t) (r->end - r->top) < bytes)
+    {
+      size_t grow = bytes > POOL_GROW ? bytes : POOL_GROW;
+      char *q = pool_map(grow);
+      if (q)
+        {r->top = q; r->end = q + grow;}
+    }
+  if ((size_t) (r->end - r->top) >= bytes)
+    {p = r->top; r->top += bytes;}
+
+  __sync_lock_release(&r->lock);
+  return(p);
+}
+
+
+
+/********************************bss_malloc.c**********************************
+Function: pool_alloc()
+
+Input : region, free lists of the calling thread, size
+Output: 
+Return: 16 byte aligned space of at least size bytes, NULL on failure
+Description: 
+*********************************bss_malloc.c*********************************/
+static void *
+pool_alloc(pool_region *r, char **list, size_t size)
+{
+  int c = pool_class(size);
+  char *b;
+
+  if (c < 0)
+    {
+      size_t n = size + POOL_HDR;
+      if (!(b = pool_map(n)))
+        {return(NULL);}
+      ((pool_hdr *) b)->h.cls  = -1;
+      ((pool_hdr *) b)->h.size = n;
+      return(b + POOL_HDR);
+    }
+
+  if (!list[c])
+    {
+      size_t bs = (size_t) 1 << (c + POOL_MINSHIFT);
+      size_t nb = bs < POOL_REFILL ? POOL_REFILL/bs : 1;
+      size_t i;
+
+      if (!(b = pool_carve(r,nb*bs)))
+        {return(NULL);}
+      for (i=0; i<nb; i++, b+=bs)
+        {
+          ((pool_hdr *) b)->h.cls = c;
+          POOL_NEXT(b) = list[c];
+          list[c] = b;
+        }
+    }
+
+  b = list[c];
+  list[c] = POOL_NEXT(b);
+  return(b + POOL_HDR);
+}
+
+
+
+/********************************bss_malloc.c**********************************
+Function: pool_free()
+
+Input : free lists of the calling thread, space from pool_alloc()
+Output: 
+Return: 
+Description: 
+*********************************bss_malloc.c*********************************/
+static void
+pool_free(char **list, void *ptr)
+{
+  char *b = (char *) ptr - POOL_HDR;
+  int c = ((pool_hdr *) b)->h.cls;
+
+  if (c < 0)
+    {munmap(b,((pool_hdr *) b)->h.size);}
+  else
+    {
+      POOL_NEXT(b) = list[c];
+      list[c] = b;
+    }
+}
 #endif
 
 
@@ -102,6 +290,9 @@ Description:
 Add ability to pass in later ... for Fortran interface
 
 Space to be passed later should be double aligned!!!
+
+Resets the stats only; with MYMALLOC space still held by earlier gs
+handles stays valid.
 *********************************bss_malloc.c*********************************/
 void 
 perm_init(void)
@@ -109,10 +300,6 @@ perm_init(void)
   perm_req = 0;
   num_perm_req = 0;
   num_perm_frees = 0;
-
-#ifdef MYMALLOC
-  perm_top = perm_buf;
-#endif
 }
 
 
@@ -129,10 +316,6 @@ void *
 perm_malloc(size_t size)
 {
   void *tmp;
-#ifdef MYMALLOC  
-  double *space;
-  int num_blocks;
-#endif
 
 
   if (!size)
@@ -144,18 +327,11 @@ perm_malloc(size_t size)
     }
 
 #if defined MYMALLOC
-  if (size%sizeof(double))
-    {num_blocks = size/sizeof(double) + 1;}
-  else
-    {num_blocks = size/sizeof(double);}
-  
-  if (num_blocks < (PERM_MALLOC_BUF/sizeof(double) - (perm_top - perm_buf)))
+  if ((tmp = pool_alloc(&perm_pool,perm_list,size)))
     {
-      space = perm_top;
-      perm_top += num_blocks;
-      perm_req+=size;
-      num_perm_req++;
-      return(space);
+      __sync_fetch_and_add(&perm_req,(int) size);
+      __sync_fetch_and_add(&num_perm_req,1);
+      return(tmp);
     }
 
 #else 
@@ -186,11 +362,11 @@ perm_free(void *ptr)
 {
   if (ptr)
     {
-      num_perm_frees--;  
-
 #ifdef MYMALLOC
-      return;
+      __sync_fetch_and_sub(&num_perm_frees,1);
+      pool_free(perm_list,ptr);
 #else
+      num_perm_frees--;  
       free((void *) ptr);
 #endif
     }
@@ -285,6 +461,8 @@ Description:
 Add ability to pass in later ...
 
 Space to be passed later should be double aligned!!!
+
+Resets the stats only, see perm_init().
 *********************************bss_malloc.c*********************************/
 void 
 bss_init(void)
@@ -292,10 +470,6 @@ bss_init(void)
   bss_req = 0;
   num_bss_req = 0;
   num_bss_frees = 0;
-
-#ifdef MYMALLOC
-  bss_top = bss_buf;
-#endif
 }
 
 
@@ -312,10 +486,6 @@ void *
 bss_malloc(size_t size)
 {
   void *tmp;  
-#ifdef MYMALLOC  
-  double *space;
-  int num_blocks;
-#endif
 
 
   if (!size)
@@ -327,18 +497,11 @@ bss_malloc(size_t size)
     }
 
 #ifdef MYMALLOC
-  if (size%sizeof(double))
-    {num_blocks = size/sizeof(double) + 1;}
-  else
-    {num_blocks = size/sizeof(double);}
-
-  if (num_blocks < (BSS_MALLOC_BUF/sizeof(double) - (bss_top - bss_buf)))
+  if ((tmp = pool_alloc(&bss_pool,bss_list,size)))
     {
-      space = bss_top;
-      bss_top += num_blocks;
-      bss_req+=size;
-      num_bss_req++;
-      return(space);
+      __sync_fetch_and_add(&bss_req,(int) size);
+      __sync_fetch_and_add(&num_bss_req,1);
+      return(tmp);
     }
 
 #else
@@ -369,11 +532,11 @@ bss_free(void *ptr)
 {
   if (ptr)
     {
-      num_bss_frees--;
-
 #ifdef MYMALLOC
-      return;
+      __sync_fetch_and_sub(&num_bss_frees,1);
+      pool_free(bss_list,ptr);
 #else
+      num_bss_frees--;
       free((void *) ptr);
 #endif
     }
@@ -52,6 +52,30 @@ File Description:
 
 
 
+/***********************************gs.c***************************************
+Type: struct gs_fields
+
+Templates of gs_gop_fields(), built from the gs handle on first use.  The
+local groups of 2, 3 and 4 elements are stored column wise (idx[k][j*n+g]
+is member j of group g) so each column is one contiguous gather; larger
+groups keep their -1 terminated lists.  pack is node_list back to back.
+************************************gs.c**************************************/
+typedef struct gs_fields {
+  int  loc_n[3], *loc_idx[3], *loc_gen;   /* local, reduce and bcast   */
+  int  gop_n[3], *gop_idx[3], *gop_gen;   /* local_in/out              */
+  int *pack;                             /* pw slot of message entries */
+  REAL *t0, *t1;                         /* gather buffers             */
+  int  nt;
+
+  int  nf;                               /* # fields bufs are sized to */
+  REAL *pw, *in, *out, *tree, *work;
+#ifdef MPISRC
+  MPI_Request *req;                      /* persistent recvs, sends    */
+#endif
+} gs_fields;
+
+
+
 /***********************************gs.c***************************************
 Type: struct gather_scatter_id 
 ------------------------------
@@ -158,10 +182,14 @@ typedef struct gather_scatter_id {
   MPI_Comm gs_comm;
 #endif
 
+  /* multi-field templates */
+  gs_fields *fld;
+
 } gs_id;
 
 /* to be made public */
 static int  gs_dump_ngh(gs_id *id, int loc_num, int *num, int *ngh_list);
+void gs_gop_fields(gs_id *gs, REAL *vals, char *op, int nf, int ld);
 
 /* PRIVATE - and definitely not exported */
 static void gs_print_template(register gs_id* gs, int who);
@@ -240,6 +268,16 @@ static void gs_gop_tree_binary(gs_id *gs, REAL *vals, rbfp fct);
 
 static int in_sub_tree(int *ptr3, int p_mask_size, int *buf2, int buf_size);
 
+static void gs_fields_setup(gs_id *gs);
+static void gs_fields_bufs(gs_id *gs, int nf);
+static void gs_fields_free(gs_id *gs);
+static void gs_fields_local(gs_id *gs, int *n, int **idx, int *gen,
+                            REAL *vals, int nf, int ld, vfp fp,
+                            int reduce, int bcast);
+static void gs_fields_pairwise(gs_id *gs, REAL *vals, int nf, int ld,
+                               int type, vfp fp);
+static void gs_fields_tree(gs_id *gs, REAL *vals, int nf, int ld, int type);
+
 
 /* global vars */
 /* from comm.c module */
@@ -441,6 +479,34 @@ extern void gs_gop_vec_ (int *gs, REAL *vals, char *op, int *step)
 
 
 
+/******************************************************************************
+Function: gs_gop_fields_ ()
+
+Input : 
+
+Output: 
+
+RETURN: 
+
+Description: gs_gop_fields() on vals(ld,nf)
+******************************************************************************/
+#if defined UPCASE
+extern void GS_GOP_FIELDS  (int *gs, REAL *vals, char *op, int *nf, int *ld)
+#else
+extern void gs_gop_fields_ (int *gs, REAL *vals, char *op, int *nf, int *ld)
+#endif
+{
+  gs_id *gsh;
+
+
+  gsh = gs_handles[*gs-1];
+
+  
+  gs_gop_fields(gsh,vals,op,*nf,*ld);
+}
+
+
+
 /******************************************************************************
 Function: gs_free_ ()
 
@@ -4731,6 +4797,8 @@ gs_free(register gs_id *gs)
   if (gs->gop_local_reduce) {perm_free((void*) gs->gop_local_reduce);}
   if (gs->num_gop_local_reduce) {perm_free((void*) gs->num_gop_local_reduce);}
 
+  if (gs->fld) {gs_fields_free(gs);}
+
   perm_free((void *) gs);
 }
 
@@ -5802,3 +5870,542 @@ gs_gop_tree_plus_hc(gs_id *gs, REAL *vals, int dim)
 
 
 
+/******************************************************************************
+Function: gs_gop_fields()
+
+Input : gs handle, vals[f*ld+i] for the nf fields f, op as for gs_gop()
+Output: 
+Return: 
+Description: 
+
+Applies op to nf fields in one sweep: the local reductions gather the
+members of all groups of a size column by column and combine them with
+the contiguous rvec_* kernel of op, and the pairwise exchange sends one
+message per neighbor for all fields, using persistent requests that are
+kept while nf stays the same.  Same result as nf calls of gs_gop().
+******************************************************************************/
+void
+gs_gop_fields(register gs_id *gs, register REAL *vals, register char *op,
+              int nf, int ld)
+{
+  int type;
+  vfp fp;
+
+
+#ifdef DEBUG
+  error_msg_warning("start gs_gop_fields()\n");
+  if (!gs) {error_msg_fatal("gs_gop_fields() :: passed NULL gs handle!!!");}
+  if (!op) {error_msg_fatal("gs_gop_fields() :: passed NULL operation!!!");}
+#endif
+
+  switch (*op) {
+  case '+': type = GL_ADD;     break;
+  case '*': type = GL_MULT;    break;
+  case 'a': type = GL_MIN_ABS; break;
+  case 'A': type = GL_MAX_ABS; break;
+  case 'e': type = GL_EXISTS;  break;
+  case 'm': type = GL_MIN;     break;
+  case 'M': type = GL_MAX;     break;
+  default:
+    error_msg_warning("gs_gop_fields() :: %c is not a valid op",op[0]);
+    error_msg_warning("gs_gop_fields() :: default :: plus");
+    type = GL_ADD;
+    break;
+  }
+  fp = rvec_fct_addr(type);
+
+  if (nf<1)
+    {return;}
+
+#if defined NXSRC
+  /* no persistent requests here ... one field at a time */
+  for (; nf>0; nf--, vals+=ld)
+    {gs_gop(gs,vals,op);}
+#else
+
+  if (!gs->fld)
+    {gs_fields_setup(gs);}
+  gs_fields_bufs(gs,nf);
+
+  /* local only operations!!! */
+  if (gs->num_local)
+    {
+      gs_fields_local(gs,gs->fld->loc_n,gs->fld->loc_idx,gs->fld->loc_gen,
+                      vals,nf,ld,fp,TRUE,TRUE);
+    }
+
+  /* if intersection tree/pairwise and local isn't empty */
+  if (gs->num_local_gop)
+    {
+      gs_fields_local(gs,gs->fld->gop_n,gs->fld->gop_idx,gs->fld->gop_gen,
+                      vals,nf,ld,fp,TRUE,FALSE);
+    }
+
+  /* pairwise (does the tree) or tree only */
+  if (gs->num_pairs)
+    {gs_fields_pairwise(gs,vals,nf,ld,type,fp);}
+  else if (gs->max_left_over)
+    {gs_fields_tree(gs,vals,nf,ld,type);}
+
+  if (gs->num_local_gop)
+    {
+      gs_fields_local(gs,gs->fld->gop_n,gs->fld->gop_idx,gs->fld->gop_gen,
+                      vals,nf,ld,fp,FALSE,TRUE);
+    }
+#endif
+
+#ifdef DEBUG
+  error_msg_warning("end gs_gop_fields()\n");
+#endif
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_groups()
+
+Input : NULL terminated reduce lists and their sizes num
+Output: n[k], idx[k] for groups of k+2 members, gen for the others
+Return: size of the largest class (for the gather buffers)
+Description: 
+******************************************************************************/
+static
+int
+gs_fields_groups(int **reduce, int *num, int *n, int **idx, int **gen)
+{
+  int k, g, j, len=1, nmax=0, *map, **r, *cnt;
+
+
+  n[0]=n[1]=n[2]=0;
+  for (r=reduce, cnt=num; (map = *r); r++, cnt++)
+    {
+      if (*cnt>=2 && *cnt<=4)
+        {n[*cnt-2]++;}
+      else
+        {len += *cnt + 1;}
+    }
+
+  for (k=0; k<3; k++)
+    {
+      idx[k] = (int *) perm_malloc(INT_LEN*((k+2)*n[k]+1));
+      nmax = MAX(nmax,n[k]);
+      n[k] = 0;
+    }
+  *gen = (int *) perm_malloc(INT_LEN*len);
+
+  for (j=0, r=reduce, cnt=num; (map = *r); r++, cnt++)
+    {
+      if (*cnt>=2 && *cnt<=4)
+        {
+          k = *cnt-2;
+          g = n[k]++;
+          /* column major once all groups are counted, see below */
+          ivec_copy(idx[k]+(k+2)*g,map,k+2);
+        }
+      else
+        {
+          while (*map >= 0)
+            {(*gen)[j++] = *map++;}
+          (*gen)[j++] = -1;
+        }
+    }
+  (*gen)[j] = -1;
+
+  /* transpose the groups of each class to columns */
+  for (k=0; k<3; k++)
+    {
+      int m = k+2, *t;
+
+      if (!n[k]) {continue;}
+      t = (int *) bss_malloc(INT_LEN*m*n[k]);
+      for (g=0; g<n[k]; g++)
+        for (j=0; j<m; j++)
+          {t[j*n[k]+g] = idx[k][m*g+j];}
+      ivec_copy(idx[k],t,m*n[k]);
+      bss_free((void *) t);
+    }
+
+  return(nmax);
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_setup()
+
+Input : 
+Output: 
+Return: 
+Description: flatten the local and pairwise templates of gs into gs->fld
+******************************************************************************/
+static
+void
+gs_fields_setup(gs_id *gs)
+{
+  register gs_fields *fld;
+  int i, j, nt=0;
+  int *iptr;
+
+
+  fld = gs->fld = (gs_fields *) perm_malloc(sizeof(gs_fields));
+  bzero((char *) fld, sizeof(gs_fields));
+
+  if (gs->num_local)
+    {
+      nt = gs_fields_groups(gs->local_reduce,gs->num_local_reduce,
+                            fld->loc_n,fld->loc_idx,&fld->loc_gen);
+    }
+  if (gs->num_local_gop)
+    {
+      i = gs_fields_groups(gs->gop_local_reduce,gs->num_gop_local_reduce,
+                           fld->gop_n,fld->gop_idx,&fld->gop_gen);
+      nt = MAX(nt,i);
+    }
+
+  if (gs->num_pairs)
+    {
+      fld->pack = (int *) perm_malloc(INT_LEN*(gs->msg_total+1));
+      for (j=i=0; i<gs->num_pairs; i++)
+        {
+          iptr = gs->node_list[i];
+          while (*iptr >= 0)
+            {fld->pack[j++] = *iptr++;}
+          nt = MAX(nt,gs->msg_sizes[i]);
+        }
+      fld->pack[j] = -1;
+    }
+
+  fld->nt = MAX(nt,1);
+  fld->t0 = (REAL *) perm_malloc(REAL_LEN*fld->nt);
+  fld->t1 = (REAL *) perm_malloc(REAL_LEN*fld->nt);
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_bufs()
+
+Input : 
+Output: 
+Return: 
+Description: 
+
+size the exchange buffers to nf fields and set up the persistent requests
+on them (kept until a call with a different nf)
+******************************************************************************/
+static
+void
+gs_fields_bufs(gs_id *gs, int nf)
+{
+  register gs_fields *fld = gs->fld;
+  int i, np, off;
+
+
+  if (fld->nf == nf)
+    {return;}
+
+#ifdef MPISRC
+  if (fld->nf && gs->num_pairs)
+    {
+      for (i=0; i<2*gs->num_pairs; i++)
+        {MPI_Request_free(fld->req+i);}
+    }
+#endif
+  if (fld->pw)   {perm_free((void *) fld->pw);}
+  if (fld->in)   {perm_free((void *) fld->in);}
+  if (fld->out)  {perm_free((void *) fld->out);}
+  if (fld->tree) {perm_free((void *) fld->tree);}
+  if (fld->work) {perm_free((void *) fld->work);}
+  fld->pw = fld->in = fld->out = fld->tree = fld->work = NULL;
+
+  fld->nf = nf;
+
+  if (gs->max_left_over)
+    {
+      fld->tree = (REAL *) perm_malloc(REAL_LEN*gs->tree_nel*nf);
+      fld->work = (REAL *) perm_malloc(REAL_LEN*gs->tree_nel*nf);
+    }
+
+  if (!(np = gs->num_pairs))
+    {return;}
+
+  fld->pw  = (REAL *) perm_malloc(REAL_LEN*gs->len_pw_list*nf);
+  fld->in  = (REAL *) perm_malloc(REAL_LEN*gs->msg_total*nf);
+  fld->out = (REAL *) perm_malloc(REAL_LEN*gs->msg_total*nf);
+
+#ifdef MPISRC
+  if (!fld->req)
+    {fld->req = (MPI_Request *) perm_malloc(sizeof(MPI_Request)*2*np);}
+  for (off=i=0; i<np; i++)
+    {
+      MPI_Recv_init(fld->in+off*nf, gs->msg_sizes[i]*nf, REAL_TYPE,
+                    gs->pair_list[i], MSGTAG1+gs->pair_list[i],
+                    gs->gs_comm, fld->req+i);
+      MPI_Send_init(fld->out+off*nf, gs->msg_sizes[i]*nf, REAL_TYPE,
+                    gs->pair_list[i], MSGTAG1+my_id,
+                    gs->gs_comm, fld->req+np+i);
+      off += gs->msg_sizes[i];
+    }
+#endif
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_free()
+
+Input : 
+Output: 
+Return: 
+Description: 
+******************************************************************************/
+static
+void
+gs_fields_free(gs_id *gs)
+{
+  register gs_fields *fld = gs->fld;
+  int k;
+
+
+#ifdef MPISRC
+  if (fld->nf && gs->num_pairs)
+    {
+      for (k=0; k<2*gs->num_pairs; k++)
+        {MPI_Request_free(fld->req+k);}
+    }
+  if (fld->req) {perm_free((void *) fld->req);}
+#endif
+
+  for (k=0; k<3; k++)
+    {
+      if (fld->loc_idx[k]) {perm_free((void *) fld->loc_idx[k]);}
+      if (fld->gop_idx[k]) {perm_free((void *) fld->gop_idx[k]);}
+    }
+  if (fld->loc_gen) {perm_free((void *) fld->loc_gen);}
+  if (fld->gop_gen) {perm_free((void *) fld->gop_gen);}
+  if (fld->pack)    {perm_free((void *) fld->pack);}
+  if (fld->t0)      {perm_free((void *) fld->t0);}
+  if (fld->t1)      {perm_free((void *) fld->t1);}
+  if (fld->pw)      {perm_free((void *) fld->pw);}
+  if (fld->in)      {perm_free((void *) fld->in);}
+  if (fld->out)     {perm_free((void *) fld->out);}
+  if (fld->tree)    {perm_free((void *) fld->tree);}
+  if (fld->work)    {perm_free((void *) fld->work);}
+
+  perm_free((void *) fld);
+  gs->fld = NULL;
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_local()
+
+Input : 
+Output: 
+Return: 
+Description: 
+
+reduce: combine the members of each group into the first, bcast: copy the
+first to the others (local = both, local_in = reduce, local_out = bcast)
+******************************************************************************/
+static
+void
+gs_fields_local(gs_id *gs, int *n, int **idx, int *gen, REAL *vals,
+                int nf, int ld, vfp fp, int reduce, int bcast)
+{
+  register REAL *v, *t0, *t1;
+  register int i, *col, *map, *lst;
+  int f, k, j, m;
+  REAL tmp;
+
+
+  t0 = gs->fld->t0;
+  t1 = gs->fld->t1;
+
+  for (f=0; f<nf; f++)
+    {
+      v = vals + f*ld;
+
+      for (k=0; k<3; k++)
+        {
+          if (!(m = n[k])) {continue;}
+
+          col = idx[k];
+          for (i=0; i<m; i++)
+            {t0[i] = v[col[i]];}
+
+          if (reduce)
+            {
+              for (j=1; j<k+2; j++)
+                {
+                  col = idx[k] + j*m;
+                  for (i=0; i<m; i++)
+                    {t1[i] = v[col[i]];}
+                  (*fp)(t0,t1,m);
+                }
+            }
+
+          for (j=reduce?0:1; j<=(bcast?k+1:0); j++)
+            {
+              col = idx[k] + j*m;
+              for (i=0; i<m; i++)
+                {v[col[i]] = t0[i];}
+            }
+        }
+
+      for (lst=gen; *lst >= 0; lst=map+1)
+        {
+          tmp = v[*lst];
+          if (reduce)
+            {
+              for (map=lst+1; *map >= 0; map++)
+                {(*fp)(&tmp,v + *map,1);}
+              v[*lst] = tmp;
+            }
+          for (map=lst+1; *map >= 0; map++)
+            {if (bcast) {v[*map] = tmp;}}
+        }
+    }
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_pairwise()
+
+Input : 
+Output: 
+Return: 
+Description: 
+
+messages hold the nf fields back to back, each packed through fld->pack
+******************************************************************************/
+static
+void
+gs_fields_pairwise(gs_id *gs, REAL *vals, int nf, int ld, int type, vfp fp)
+{
+#ifdef MPISRC
+  register gs_fields *fld = gs->fld;
+  register REAL *v, *pw, *buf, *t0 = fld->t0;
+  register int i, *pe = gs->pw_elm_list, *pk;
+  int f, m, np = gs->num_pairs, len = gs->len_pw_list, sz, off;
+
+
+  /* load the pairwise values of all fields */
+  for (f=0; f<nf; f++)
+    {
+      v  = vals + f*ld;
+      pw = fld->pw + f*len;
+      for (i=0; i<len; i++)
+        {pw[i] = v[pe[i]];}
+    }
+
+  MPI_Startall(np,fld->req);
+
+  /* load out buffers and post the sends */
+  for (off=m=0; m<np; m++)
+    {
+      sz  = gs->msg_sizes[m];
+      pk  = fld->pack + off;
+      buf = fld->out + off*nf;
+      for (f=0; f<nf; f++, buf+=sz)
+        {
+          pw = fld->pw + f*len;
+          for (i=0; i<sz; i++)
+            {buf[i] = pw[pk[i]];}
+        }
+      off += sz;
+    }
+  MPI_Startall(np,fld->req+np);
+
+  if (gs->max_left_over)
+    {gs_fields_tree(gs,vals,nf,ld,type);}
+
+  /* process the received data */
+  MPI_Waitall(np,fld->req,MPI_STATUSES_IGNORE);
+  for (off=m=0; m<np; m++)
+    {
+      sz  = gs->msg_sizes[m];
+      pk  = fld->pack + off;
+      buf = fld->in + off*nf;
+      for (f=0; f<nf; f++, buf+=sz)
+        {
+          pw = fld->pw + f*len;
+          for (i=0; i<sz; i++)
+            {t0[i] = pw[pk[i]];}
+          (*fp)(t0,buf,sz);
+          for (i=0; i<sz; i++)
+            {pw[pk[i]] = t0[i];}
+        }
+      off += sz;
+    }
+
+  /* replace vals */
+  for (f=0; f<nf; f++)
+    {
+      v  = vals + f*ld;
+      pw = fld->pw + f*len;
+      for (i=0; i<len; i++)
+        {v[pe[i]] = pw[i];}
+    }
+
+  MPI_Waitall(np,fld->req+np,MPI_STATUSES_IGNORE);
+#else
+  return;
+#endif
+}
+
+
+
+/******************************************************************************
+Function: gs_fields_tree()
+
+Input : 
+Output: 
+Return: 
+Description: one grop() of length tree_nel*nf for all fields
+******************************************************************************/
+static
+void
+gs_fields_tree(gs_id *gs, REAL *vals, int nf, int ld, int type)
+{
+  register REAL *v, *buf;
+  register int *in, *out;
+  int f, size = gs->tree_nel;
+  int op[2];
+  REAL id;
+
+
+  op[0] = type; op[1] = 0;
+  switch (type) {
+  case GL_MULT:    id = 1.0;       break;
+  case GL_MIN:
+  case GL_MIN_ABS: id = REAL_MAX;  break;
+  case GL_MAX:     id = -REAL_MAX; break;
+  default:         id = 0.0;       break;
+  }
+  rvec_set(gs->fld->tree,id,size*nf);
+
+  for (f=0; f<nf; f++)
+    {
+      v   = vals + f*ld;
+      buf = gs->fld->tree + f*size;
+      in  = gs->tree_map_in;
+      out = gs->tree_map_out;
+      while (*in >= 0)
+        {*(buf + *out++) = *(v + *in++);}
+    }
+
+  grop(gs->fld->tree,gs->fld->work,size*nf,op);
+
+  for (f=0; f<nf; f++)
+    {
+      v   = vals + f*ld;
+      buf = gs->fld->tree + f*size;
+      in  = gs->tree_map_in;
+      out = gs->tree_map_out;
+      while (*in >= 0)
+        {*(v + *in++) = *(buf + *out++);}
+    }
+}
@@ -328,6 +328,10 @@ c
       integer nppcell_last,nppcell
       save    nppcell_last,nppcell
       data    nppcell_last,nppcell  /-1,0/
+c
+      integer nvtu_piece,kvtu
+      save    nvtu_piece,kvtu
+      data    nvtu_piece,kvtu  /1,0/
 c
       common /bigvtkl/ ifclip,ifillt,iffmt_vtk,ifdouble
       logical          ifclip,ifillt,iffmt_vtk,ifdouble
@@ -372,6 +376,12 @@ c
       nchoic=nchoic+1
       item(nchoic)                 = 'Animate vtk vol'
       nchoic=nchoic+1
+      item(nchoic)                 = 'Set vtu pieces'
+      nchoic=nchoic+1
+      item(nchoic)                 = 'DUMP vtu binary'
+      nchoic=nchoic+1
+      item(nchoic)                 = 'Animate vtu series'
+      nchoic=nchoic+1
       item(nchoic)                 = 'XYZ dump'
       nchoic=nchoic+1
       item(nchoic)                 = 'XWD dump'
@@ -394,6 +404,24 @@ c
 c
       elseif (choice.eq.'Animate vtk vol') then
          call mltiplt4
+c
+      elseif (choice.eq.'Set vtu pieces') then
+         call prsis('Input number of .vtu pieces:[$',nvtu_piece,']$')
+         call res(line,70)
+         if (line.ne.' ') then
+             call reader(value,ierr)
+             nvtu_piece=max(1,min(nel,int(value)))
+         endif
+         goto 1
+c
+      elseif (choice.eq.'DUMP vtu binary') then
+c        successive dumps are appended to the .pvd series
+         call vtu_out(nppcell,nvtu_piece,kvtu)
+         kvtu = kvtu+1
+         goto 1
+c
+      elseif (choice.eq.'Animate vtu series') then
+         call vtu_series(nppcell,nvtu_piece,kvtu)
 c
       elseif (choice.eq.'Animate vtk srf') then
          call mltiplt3
@@ -2741,6 +2769,220 @@ ccc         enddo
 ccc   c
       return
       end
+c-----------------------------------------------------------------------
+      subroutine vtu_out(mx,npiece,kframe)
+c
+c     Dump the current fields as appended binary VTK (.vtu), taken
+c     straight from the element layout: each element is sampled on
+c     mx points per edge and written as (mx-1)**ndim linear cells
+c     with its own copy of the face points, so there is no global
+c     numbering / sort pass and no ASCII formatting (see vtu.c).
+c
+c     The elements are split in npiece contiguous ranges, one .vtu
+c     each, tied together by a .pvtu.  The dump is entered in the
+c     <session>.pvd time series as frame kframe (0 starts it anew).
+c
+#     include "basics.inc"
+      include 'basicsp.inc'
+c
+      parameter (lxv=30*30*30)
+      common /vtuwk/ wm(lxv,3),wv(2*lxv)
+c
+      parameter (mfld=3+mpscal)
+      character*20 vname(mfld)
+      integer      isd(mfld)
+c
+      character*80 prefix,fname,pname
+      integer e,e0,e1,wdsize
+c
+      mz = mx
+      if (.not.if3d) mz = 1
+      mdim = 2
+      if (if3d) mdim = 3
+      nxyz = nx*ny*nz
+      mxyz = mx*mx*mz
+c
+      if (mx.lt.2 .or. mxyz.gt.lxv .or. nx.gt.30) then
+         call prsi('vtu: sampling size must be in [2,30]:$',mx)
+         return
+      endif
+c
+      wdsize = 4
+      eps    = 1.e-12
+      one    = 1.
+      if (one+eps.ne.one) wdsize = 8
+c
+c     Fields present: velocity, pressure, temperature, scalars
+c
+      nvec = 0
+      nsca = 0
+      nfld = 0
+      if (ifflow) then
+         nvec = 1
+         nfld = nfld+1
+         vname(nfld) = 'velocity'
+         isd  (nfld) = 4
+         nsca = nsca+1
+         nfld = nfld+1
+         vname(nfld) = 'pressure'
+         isd  (nfld) = 7
+      endif
+      if (ifheat) then
+         nsca = nsca+1
+         nfld = nfld+1
+         vname(nfld) = 'temperature'
+         isd  (nfld) = 8
+      endif
+      do i=1,min(npscal,mpscal)
+         nsca = nsca+1
+         nfld = nfld+1
+         write(vname(nfld),'(a1,i1)') 's',i
+         isd  (nfld) = 8+i
+      enddo
+c
+      ls = ltrunc(session_name,80)
+      call blank(prefix,80)
+      write(prefix,1) session_name(1:ls),kframe
+    1 format(a,i5.5)
+      lp = ltrunc(prefix,80)
+c
+      do ip=1,npiece
+         e0 = 1 + ((ip-1)*nel)/npiece
+         e1 = (ip*nel)/npiece
+         ne = e1-e0+1
+c
+         call blank(fname,80)
+         if (npiece.eq.1) then
+            write(fname,2) prefix(1:lp)
+         else
+            write(fname,3) prefix(1:lp),ip
+         endif
+    2    format(a,'.vtu')
+    3    format(a,'_p',i4.4,'.vtu')
+c
+         call vtu_open(fname,80,ne,mx,mdim,nvec,nsca,vname,20,wdsize)
+c
+         do e=e0,e1
+            j = 1 + (e-1)*nxyz
+            call vtu_mapel(wm(1,1),mx,xp(j),nx,wv,if3d)
+            call vtu_mapel(wm(1,2),mx,yp(j),nx,wv,if3d)
+            if (if3d) call vtu_mapel(wm(1,3),mx,zp(j),nx,wv,if3d)
+            call vtu_vec(wm(1,1),wm(1,2),wm(1,3),mxyz)
+         enddo
+         call vtu_cells
+c
+         do k=1,nfld
+            jf = isd(k)
+            do e=e0,e1
+               j = 1 + (e-1)*nxyz
+               call vtu_mapel(wm(1,1),mx,sdump(j,jf),nx,wv,if3d)
+               if (k.le.nvec) then
+                  call vtu_mapel(wm(1,2),mx,sdump(j,jf+1),nx,wv,if3d)
+                  if (if3d) 
+     $            call vtu_mapel(wm(1,3),mx,sdump(j,jf+2),nx,wv,if3d)
+                  call vtu_vec(wm(1,1),wm(1,2),wm(1,3),mxyz)
+               else
+                  call vtu_sca(wm(1,1),mxyz)
+               endif
+            enddo
+         enddo
+c
+         call vtu_close
+      enddo
+c
+      call blank(pname,80)
+      if (npiece.gt.1) then
+         write(pname,4) prefix(1:lp)
+    4    format(a,'.pvtu')
+         call vtu_pvtu(pname,80,prefix,80,npiece)
+      else
+         call chcopy(pname,fname,80)
+      endif
+c
+      call blank(fname,80)
+      write(fname,5) session_name(1:ls)
+    5 format(a,'.pvd')
+      ifnew = 0
+      if (kframe.eq.0) ifnew = 1
+      call vtu_pvd(fname,80,pname,80,time,ifnew)
+c
+      call blank(line,70)
+      write(line,6) nel,npiece,mx
+    6 format('vtu: wrote',i9,' elements in',i5,' pieces, mx=',i3,'$')
+      call prs(line)
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine vtu_mapel(w_map,mx,w_in,nx,w,if3d)
+c
+c     Sample one element on mx uniformly spaced points per edge,
+c     2D or 3D (cf. mapreg3d1).
+c
+      real w_map(1),w_in(1),w(1)
+      logical if3d
+c
+      integer nx_last,mx_last
+      save    nx_last,mx_last
+      data    nx_last,mx_last  /-1,-1/
+c
+      parameter (nxm=30)
+      real gll_pts(nxm)
+      real gll_wts(nxm)
+      real i (nxm*nxm)
+      real it(nxm*nxm)
+      save gll_pts,gll_wts,i,it
+c
+      if (nx.ne.nx_last .or. mx.ne.mx_last) then
+         call legend(gll_pts,gll_wts,nx)
+         nx1 = nx-1
+         l   = 1
+         do k=1,mx
+            z0 = (2.*(k-1))/(mx-1) - 1.
+            call fd_weights_full(z0,gll_pts,nx1,0,it(l))
+            l  = l+nx
+         enddo
+         call transpose(i,mx,it,nx)
+         nx_last = nx
+         mx_last = mx
+      endif
+c
+      nmx = max(nx,mx)
+      l   = nmx*nmx*nmx + 1
+      call map_tnsr(w_map,mx,w_in,nx,i,it,w,w(l),if3d)
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine vtu_series(mx,npiece,kframe)
+c
+c     Dump a range of .fld files as a new .vtu time series (cf.
+c     mltiplt_all), kframe returns the number of frames written
+c
+#     include "basics.inc"
+      include 'basicsp.inc'
+c
+      call prs  ('Input start and stop fld numbers:$')
+      call reii (iframe0,iframe1)
+c
+      call prs  ('Input stride:$')
+      call rei  (istride)
+      if (istride.le.0) istride = 1
+c
+      kframe = 0
+      do iframe = iframe0,iframe1,istride
+         ndumps = iframe
+         call getfld(ndumps,ierr,.true.,.true.)
+         if (ierr.ne.0) goto 10
+         call vtu_out(mx,npiece,kframe)
+         kframe = kframe+1
+      enddo
+   10 continue
+c
+      call prsi('vtu: frames written to the .pvd:$',kframe)
+c
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine vtk_out_vec (uu,vv,ww,n,ifout,ivtk_dump)
 c
@@ -0,0 +1,427 @@
+/***********************************vtu.c**************************************
+Module Name: vtu
+Module Info: appended raw binary VTK XML output (.vtu/.pvtu/.pvd)
+
+Usage from trap.f (vtu_out):
+
+  call vtu_open (fname,lf,nel,mx,ndim,nvec,nsca,names,lnam,wdsize)
+  call vtu_vec  (x,y,z,n)        points, once per element (in order)
+  call vtu_cells                 connectivity, offsets and types
+  call vtu_vec  (u,v,w,n)        each vector field, once per element
+  call vtu_sca  (s,n)            each scalar field, once per element
+  call vtu_close
+
+  call vtu_pvtu (fname,lf,prefix,lp,npiece)  after the pieces of a dump
+  call vtu_pvd  (fname,lf,entry,le,time,ifnew) time series collection
+
+Every element is written as mx**ndim points and (mx-1)**ndim linear
+cells numbered locally, so no global node numbering is needed and the
+data goes out element by element as it is sampled.  All arrays are
+declared up front in the XML header (the offsets follow from nel and
+mx) and streamed in the order listed above, each behind a UInt64 byte
+count.  Reals are stored as Float32, indices as Int64.
+***********************************vtu.c*************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_NAME  132
+#define MAX_ARRAY 16
+#define VTU_CHUNK 4096
+
+typedef struct {
+  char name[MAX_NAME+1];
+  int  ncomp;
+} vtu_array;
+
+static FILE *vtu_fp = NULL;
+static int  vtu_wdsize = 4;
+static int  vtu_mx, vtu_ndim, vtu_nel;
+static int  vtu_nvec, vtu_nsca;
+static vtu_array vtu_arr[MAX_ARRAY];
+
+/* streaming state: current array and bytes still due in it */
+static int      vtu_cur;
+static uint64_t vtu_left;
+static uint64_t vtu_size[3+MAX_ARRAY+1];
+static int      vtu_narr;
+
+static const char vtu_pvd_tail[] = "  </Collection>\n</VTKFile>\n";
+
+
+static const char *
+vtu_endian(void)
+{
+  int one = 1;
+  return *(char *)&one ? "LittleEndian" : "BigEndian";
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_fname
+
+Copy a blank padded Fortran name of length lf into buf.
+***********************************vtu.c*************************************/
+static void
+vtu_fname(char *buf, char *f, int lf)
+{
+  int n = lf;
+  if (n>MAX_NAME) n=MAX_NAME;
+  while (n>0 && (f[n-1]==' ' || f[n-1]=='\0')) n--;
+  memcpy(buf,f,n);
+  buf[n]='\0';
+}
+
+
+static void
+vtu_error(const char *msg)
+{
+  printf("vtu :: %s\n",msg);
+  abort();
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_next
+
+Account for nb bytes of the current stream, starting the next array
+(and writing its byte count) when the previous one is complete.
+***********************************vtu.c*************************************/
+static void
+vtu_next(uint64_t nb)
+{
+  if (vtu_fp==NULL) vtu_error("no file open");
+  if (vtu_left==0)
+    {
+      if (++vtu_cur>=vtu_narr) vtu_error("more data than declared");
+      vtu_left = vtu_size[vtu_cur];
+      fwrite(&vtu_left,sizeof(uint64_t),1,vtu_fp);
+    }
+  if (nb>vtu_left) vtu_error("array overrun");
+  vtu_left -= nb;
+}
+
+
+static void
+vtu_floats(float *buf, int m)
+{
+  vtu_next((uint64_t)m*sizeof(float));
+  fwrite(buf,sizeof(float),m,vtu_fp);
+}
+
+
+static float
+vtu_real(void *x, int i)
+{
+  if (vtu_wdsize==8) return (float) ((double *)x)[i];
+  return ((float *)x)[i];
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_open_
+
+Open a piece of nel elements sampled on mx points per edge and write
+the XML header for the points, the cells, nvec vectors and nsca
+scalars; names holds nvec+nsca blank padded names of length lnam.
+***********************************vtu.c*************************************/
+void
+vtu_open_(char *f, int *lf, int *nel, int *mx, int *ndim, int *nvec,
+          int *nsca, char *names, int *lnam, int *wdsize)
+{
+  char fname[MAX_NAME+1];
+  uint64_t npts, ncell, nvert, off;
+  int i, k, npe, cpe;
+
+  if (vtu_fp) vtu_error("previous piece not closed");
+  if (*nvec+*nsca>MAX_ARRAY) vtu_error("too many fields");
+
+  vtu_fname(fname,f,*lf);
+  if (!(vtu_fp=fopen(fname,"wb")))
+    {printf("vtu_open() :: unable to open %s\n",fname); abort();}
+
+  vtu_wdsize = *wdsize;
+  vtu_mx   = *mx;
+  vtu_ndim = *ndim;
+  vtu_nel  = *nel;
+  vtu_nvec = *nvec;
+  vtu_nsca = *nsca;
+
+  npe = cpe = 1;
+  for (i=0;i<vtu_ndim;i++) {npe*=vtu_mx; cpe*=vtu_mx-1;}
+  nvert = 1<<vtu_ndim;
+  npts  = (uint64_t)npe*vtu_nel;
+  ncell = (uint64_t)cpe*vtu_nel;
+
+  for (k=0;k<vtu_nvec+vtu_nsca;k++)
+    {
+      vtu_fname(vtu_arr[k].name,names+k*(*lnam),*lnam);
+      vtu_arr[k].ncomp = k<vtu_nvec ? 3 : 1;
+    }
+
+  vtu_narr = 0;
+  vtu_size[vtu_narr++] = 3*npts*sizeof(float);
+  vtu_size[vtu_narr++] = nvert*ncell*sizeof(int64_t);
+  vtu_size[vtu_narr++] = ncell*sizeof(int64_t);
+  vtu_size[vtu_narr++] = ncell*sizeof(uint8_t);
+  for (k=0;k<vtu_nvec+vtu_nsca;k++)
+    vtu_size[vtu_narr++] = vtu_arr[k].ncomp*npts*sizeof(float);
+
+  fprintf(vtu_fp,"<?xml version=\"1.0\"?>\n");
+  fprintf(vtu_fp,"<VTKFile type=\"UnstructuredGrid\" version=\"1.0\""
+          " byte_order=\"%s\" header_type=\"UInt64\">\n",vtu_endian());
+  fprintf(vtu_fp,"  <UnstructuredGrid>\n");
+  fprintf(vtu_fp,"    <Piece NumberOfPoints=\"%llu\" NumberOfCells=\"%llu\">\n",
+          (unsigned long long)npts,(unsigned long long)ncell);
+
+#define VTU_DA(type,name,nc)                                               \
+  fprintf(vtu_fp,"        <DataArray type=\"%s\" Name=\"%s\""              \
+          " NumberOfComponents=\"%d\" format=\"appended\" offset=\"%llu\"/>\n",\
+          type,name,nc,(unsigned long long)off);                           \
+  off += sizeof(uint64_t)+vtu_size[i++];
+
+  off = 0; i = 0;
+  fprintf(vtu_fp,"      <Points>\n");
+  VTU_DA("Float32","Points",3);
+  fprintf(vtu_fp,"      </Points>\n");
+  fprintf(vtu_fp,"      <Cells>\n");
+  VTU_DA("Int64","connectivity",1);
+  VTU_DA("Int64","offsets",1);
+  VTU_DA("UInt8","types",1);
+  fprintf(vtu_fp,"      </Cells>\n");
+  fprintf(vtu_fp,"      <PointData>\n");
+  for (k=0;k<vtu_nvec+vtu_nsca;k++)
+    {VTU_DA("Float32",vtu_arr[k].name,vtu_arr[k].ncomp);}
+  fprintf(vtu_fp,"      </PointData>\n");
+#undef VTU_DA
+
+  fprintf(vtu_fp,"    </Piece>\n");
+  fprintf(vtu_fp,"  </UnstructuredGrid>\n");
+  fprintf(vtu_fp,"  <AppendedData encoding=\"raw\">\n_");
+
+  vtu_cur  = -1;
+  vtu_left = 0;
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_vec_
+
+Stream n (x,y,z) triplets of the points or of the current vector.
+***********************************vtu.c*************************************/
+void
+vtu_vec_(void *x, void *y, void *z, int *n)
+{
+  float buf[3*VTU_CHUNK];
+  int i, j, m;
+
+  for (i=0;i<*n;i+=VTU_CHUNK)
+    {
+      m = *n-i<VTU_CHUNK ? *n-i : VTU_CHUNK;
+      for (j=0;j<m;j++)
+        {
+          buf[3*j  ] = vtu_real(x,i+j);
+          buf[3*j+1] = vtu_real(y,i+j);
+          buf[3*j+2] = vtu_ndim==3 ? vtu_real(z,i+j) : 0.0f;
+        }
+      vtu_floats(buf,3*m);
+    }
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_sca_
+
+Stream n values of the current scalar.
+***********************************vtu.c*************************************/
+void
+vtu_sca_(void *s, int *n)
+{
+  float buf[VTU_CHUNK];
+  int i, j, m;
+
+  for (i=0;i<*n;i+=VTU_CHUNK)
+    {
+      m = *n-i<VTU_CHUNK ? *n-i : VTU_CHUNK;
+      for (j=0;j<m;j++) buf[j] = vtu_real(s,i+j);
+      vtu_floats(buf,m);
+    }
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_cells_
+
+Write the linear sub-cells of all elements: (mx-1)**ndim hexahedra
+(quads in 2D) per element, vertices in VTK order numbered within the
+element's own block of points.
+***********************************vtu.c*************************************/
+void
+vtu_cells_(void)
+{
+  int64_t ibuf[8*VTU_CHUNK], base;
+  uint8_t tbuf[VTU_CHUNK];
+  int nvert = 1<<vtu_ndim;
+  int mx = vtu_mx, mz = vtu_ndim==3 ? vtu_mx : 2;
+  int npe = vtu_ndim==3 ? mx*mx*mx : mx*mx;
+  int e, i, j, k, m, v;
+  int64_t c, ncell;
+
+  /* connectivity */
+  m = 0;
+  for (e=0;e<vtu_nel;e++)
+    {
+      base = (int64_t)e*npe;
+      for (k=0;k<mz-1;k++)
+        for (j=0;j<mx-1;j++)
+          for (i=0;i<mx-1;i++)
+            {
+              int64_t p = base+i+mx*(j+mx*k);
+              ibuf[m++] = p;
+              ibuf[m++] = p+1;
+              ibuf[m++] = p+1+mx;
+              ibuf[m++] = p+mx;
+              if (nvert==8)
+                {
+                  int64_t q = p+mx*mx;
+                  ibuf[m++] = q;
+                  ibuf[m++] = q+1;
+                  ibuf[m++] = q+1+mx;
+                  ibuf[m++] = q+mx;
+                }
+              if (m==8*VTU_CHUNK)
+                {
+                  vtu_next((uint64_t)m*sizeof(int64_t));
+                  fwrite(ibuf,sizeof(int64_t),m,vtu_fp);
+                  m = 0;
+                }
+            }
+    }
+  if (m)
+    {
+      vtu_next((uint64_t)m*sizeof(int64_t));
+      fwrite(ibuf,sizeof(int64_t),m,vtu_fp);
+    }
+
+  /* offsets */
+  ncell = (int64_t) vtu_size[2]/sizeof(int64_t);
+  for (c=0;c<ncell;c+=m)
+    {
+      m = ncell-c<8*VTU_CHUNK ? (int)(ncell-c) : 8*VTU_CHUNK;
+      for (v=0;v<m;v++) ibuf[v] = (c+v+1)*nvert;
+      vtu_next((uint64_t)m*sizeof(int64_t));
+      fwrite(ibuf,sizeof(int64_t),m,vtu_fp);
+    }
+
+  /* types: VTK_HEXAHEDRON or VTK_QUAD */
+  memset(tbuf,nvert==8 ? 12 : 9,VTU_CHUNK);
+  for (c=0;c<ncell;c+=m)
+    {
+      m = ncell-c<VTU_CHUNK ? (int)(ncell-c) : VTU_CHUNK;
+      vtu_next((uint64_t)m);
+      fwrite(tbuf,1,m,vtu_fp);
+    }
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_close_
+***********************************vtu.c*************************************/
+void
+vtu_close_(void)
+{
+  if (vtu_fp==NULL) return;
+  if (vtu_left!=0 || vtu_cur!=vtu_narr-1) vtu_error("piece incomplete");
+  fprintf(vtu_fp,"\n  </AppendedData>\n</VTKFile>\n");
+  fclose(vtu_fp);
+  vtu_fp = NULL;
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_pvtu_
+
+Tie npiece pieces <prefix>_p<ip>.vtu of the last written layout
+together in fname.
+***********************************vtu.c*************************************/
+void
+vtu_pvtu_(char *f, int *lf, char *p, int *lp, int *npiece)
+{
+  char fname[MAX_NAME+1], prefix[MAX_NAME+1];
+  const char *s;
+  FILE *fp;
+  int k, ip;
+
+  vtu_fname(fname,f,*lf);
+  vtu_fname(prefix,p,*lp);
+  if (!(fp=fopen(fname,"w")))
+    {printf("vtu_pvtu() :: unable to open %s\n",fname); abort();}
+
+  /* pieces are referenced relative to the .pvtu */
+  s = strrchr(prefix,'/');
+  s = s ? s+1 : prefix;
+
+  fprintf(fp,"<?xml version=\"1.0\"?>\n");
+  fprintf(fp,"<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\""
+          " byte_order=\"%s\" header_type=\"UInt64\">\n",vtu_endian());
+  fprintf(fp,"  <PUnstructuredGrid GhostLevel=\"0\">\n");
+  fprintf(fp,"    <PPoints>\n");
+  fprintf(fp,"      <PDataArray type=\"Float32\" Name=\"Points\""
+          " NumberOfComponents=\"3\"/>\n");
+  fprintf(fp,"    </PPoints>\n");
+  fprintf(fp,"    <PPointData>\n");
+  for (k=0;k<vtu_nvec+vtu_nsca;k++)
+    fprintf(fp,"      <PDataArray type=\"Float32\" Name=\"%s\""
+            " NumberOfComponents=\"%d\"/>\n",
+            vtu_arr[k].name,vtu_arr[k].ncomp);
+  fprintf(fp,"    </PPointData>\n");
+  for (ip=1;ip<=*npiece;ip++)
+    fprintf(fp,"    <Piece Source=\"%s_p%04d.vtu\"/>\n",s,ip);
+  fprintf(fp,"  </PUnstructuredGrid>\n");
+  fprintf(fp,"</VTKFile>\n");
+  fclose(fp);
+}
+
+
+/***********************************vtu.c**************************************
+Function: vtu_pvd_
+
+Add dataset entry at the given time to the collection fname, which is
+started afresh if ifnew is set (or does not exist yet).  The footer is
+rewritten after each entry so the series can be opened at any time.
+***********************************vtu.c*************************************/
+void
+vtu_pvd_(char *f, int *lf, char *e, int *le, float *time, int *ifnew)
+{
+  char fname[MAX_NAME+1], entry[MAX_NAME+1];
+  const char *s;
+  FILE *fp = NULL;
+  double t;
+
+  vtu_fname(fname,f,*lf);
+  vtu_fname(entry,e,*le);
+  t = vtu_wdsize==8 ? *(double *)time : *time;
+
+  s = strrchr(entry,'/');
+  s = s ? s+1 : entry;
+
+  if (!*ifnew && (fp=fopen(fname,"r+")))
+    {
+      if (fseek(fp,-(long)strlen(vtu_pvd_tail),SEEK_END))
+        {fclose(fp); fp=NULL;}
+    }
+  if (fp==NULL)
+    {
+      if (!(fp=fopen(fname,"w")))
+        {printf("vtu_pvd() :: unable to open %s\n",fname); abort();}
+      fprintf(fp,"<?xml version=\"1.0\"?>\n");
+      fprintf(fp,"<VTKFile type=\"Collection\" version=\"1.0\""
+              " byte_order=\"%s\">\n",vtu_endian());
+      fprintf(fp,"  <Collection>\n");
+    }
+  fprintf(fp,"    <DataSet timestep=\"%.9g\" part=\"0\" file=\"%s\"/>\n",
+          t,s);
+  fputs(vtu_pvd_tail,fp);
+  fclose(fp);
+}
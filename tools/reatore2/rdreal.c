@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef FNAME_H
+#define FNAME_H
+
+/*
+   FORTRAN naming convention
+     default      cpgs_setup, etc.
+     -DUPCASE     CPGS_SETUP, etc.
+     -DUNDERSCORE cpgs_setup_, etc.
+*/
+
+#ifdef UPCASE
+#  define FORTRAN_NAME(low,up) up
+#else
+#ifdef UNDERSCORE
+#  define FORTRAN_NAME(low,up) low##_
+#else
+#  define FORTRAN_NAME(low,up) low
+#endif
+#endif
+
+#endif
+
+#define rd_reals  FORTRAN_NAME(rd_reals,  RD_REALS )
+#define rd_fixed  FORTRAN_NAME(rd_fixed,  RD_FIXED )
+#define rd_fixed8 FORTRAN_NAME(rd_fixed8, RD_FIXED8)
+
+#define MAX_TOK 64
+
+/*************************************rdreal.c*********************************
+
+  rd_reals(s,len,n,x,ierr)
+
+  Read n reals from the first len characters of s, the fast path of the
+  list-directed reads in reatore2.f.  Values are separated by blanks or
+  a single comma, d/D exponents are accepted.  strtof rounds like the
+  Fortran runtime, so the result matches read(s,*) bit for bit.
+
+  Anything else (null values, r*c repeats, '/', exponents without a
+  letter, too few values) returns ierr=1 and the caller falls back to
+  the Fortran read.  Thread safe.
+
+*******************************************************************************/
+void rd_reals(char *s, int *len, int *n, float *x, int *ierr)
+{
+  char tok[MAX_TOK+1], *end;
+  int  i=0, k, m, comma;
+
+  *ierr=1;
+  for (k=0; k<*n; k++)
+  {
+    comma=0;
+    while (i<*len && (s[i]==' ' || s[i]==',' || s[i]=='\t'))
+      if (s[i++]==',' && (comma++ || k==0)) return;
+    if (i>=*len) return;
+
+    for (m=0; i<*len && s[i]!=' ' && s[i]!=',' && s[i]!='\t'; i++)
+    {
+      if (m==MAX_TOK || s[i]=='*' || s[i]=='/') return;
+      tok[m++] = (s[i]=='d' || s[i]=='D') ? 'e' : s[i];
+    }
+    tok[m]='\0';
+
+    x[k]=strtof(tok,&end);
+    if (*end) return;
+  }
+  *ierr=0;
+}
+
+/* field k (0-based) of width w at offset off, blanks dropped (BN) */
+static int fixed_tok(char *s, int off, int w, int k, char *tok)
+{
+  int i, m=0, dot=0;
+
+  for (i=off+k*w; i<off+(k+1)*w; i++)
+  {
+    if (s[i]==' ') continue;
+    if (m==MAX_TOK) return 1;
+    if (s[i]=='.') dot=1;
+    tok[m++] = (s[i]=='d' || s[i]=='D') ? 'e' : s[i];
+  }
+  tok[m]='\0';
+  return m>0 && !dot;   /* no decimal point: scale factor applies */
+}
+
+/*************************************rdreal.c*********************************
+
+  rd_fixed(s,off,w,n,x,ierr), rd_fixed8(...)
+
+  Read n real*4 (real*8) values in fields of width w starting after
+  column off, i.e. read(s,'(offx,nGw.d)').  Blank fields give 0.
+  Fields without a decimal point return ierr=1 (the Fortran read
+  scales those by 10**-d), as does anything strtof cannot take.
+
+*******************************************************************************/
+void rd_fixed(char *s, int *off, int *w, int *n, float *x, int *ierr)
+{
+  char tok[MAX_TOK+1], *end;
+  int  k;
+
+  *ierr=1;
+  if (*w>MAX_TOK) return;
+  for (k=0; k<*n; k++)
+  {
+    if (fixed_tok(s,*off,*w,k,tok)) return;
+    x[k] = tok[0] ? strtof(tok,&end) : 0;
+    if (tok[0] && *end) return;
+  }
+  *ierr=0;
+}
+
+void rd_fixed8(char *s, int *off, int *w, int *n, double *x, int *ierr)
+{
+  char tok[MAX_TOK+1], *end;
+  int  k;
+
+  *ierr=1;
+  if (*w>MAX_TOK) return;
+  for (k=0; k<*n; k++)
+  {
+    if (fixed_tok(s,*off,*w,k,tok)) return;
+    x[k] = tok[0] ? strtod(tok,&end) : 0;
+    if (tok[0] && *end) return;
+  }
+  *ierr=0;
+}
@@ -6,11 +6,6 @@ c     extract geometry, bcs, and curve data to a new binary re2 file, plus
 c     an ascii rea file for just the parameters
 
       
-      character*4 ans
-      real*4      buf(10)
-      real*8      buf2(30)
-      real*8      rgroup,rcurve,rbc
-
       character*80 file,fout,fbout,string
       character*1  file1(80),fout1(80),fbout1(80),string1(80)
       equivalence (file1,file)
@@ -18,22 +13,20 @@ c     an ascii rea file for just the parameters
       equivalence (fbout1,fbout)
       equivalence (string,string1)
 
-      parameter(lelt=MAXNEL)
-      common /array/ x(8),y(8),z(8),bc(5,6,lelt),curve(6,8)
-      common /arrai/ nel,ncurve
-      common /arrac/ cbc
-      character*3 cbc(6,lelt)
-      integer e,f
-      character*1 ccurve(4)
-      logical ifflow,ifheat
+      real*8 rcurve
+
+      include 'CHUNK'
+      character*132 lns(lln)
+      real*8  rbuf(8,6*lch)
+      logical ifkeep(6*lch)
+      common /chnkc/ lns
+      common /chnkr/ rbuf
+      common /chnkl/ ifkeep
 
       character*80 hdr
       real*4 test
       data   test  / 6.54321 /
 
-      integer ibc(6,lelt)
-      real*8  bc8(5)
-
       write(6,*) 'Input old (source) file name:'      
       call blank(file,80)
       read(5,80) file
@@ -67,12 +60,6 @@ c     an ascii rea file for just the parameters
       write(11,11) -nel, ndim, nelv
    11 format(i12,2x,i1,2x,i12,5x,'NELT,NDIM,NELV')
    
-      if(nel.ge.lelt) then
-        write(6,*) 'Abort: number of elements too large',nel
-        write(6,*) 'change MAXNEL and recompile'
-        stop
-      endif
-
       call blank(hdr,80)
       write(hdr,1) nel,ndim,nelv
     1 format('#v002',i9,i3,i9,' this is the hdr')
@@ -81,36 +68,7 @@ c     an ascii rea file for just the parameters
 
 
 C MESH
-      igroup = 0
-      do ie=1,nel      
-         read(10,*) ! for now skip igroup (not used at the moment)
-         rgroup=igroup
-         call byte_write(rgroup, 2)
-
-         if (ndim.eq.3) then
-            read (10,*)   (x(k),k=1,4)
-            read (10,*)   (y(k),k=1,4)
-            read (10,*)   (z(k),k=1,4)
-            read (10,*)   (x(k),k=5,8)
-            read (10,*)   (y(k),k=5,8)
-            read (10,*)   (z(k),k=5,8)
-
-            call copy48(buf2(1) ,x,8)
-            call copy48(buf2(9) ,y,8)
-            call copy48(buf2(17),z,8)
-            call byte_write(buf2(1) ,16)
-            call byte_write(buf2(9) ,16)
-            call byte_write(buf2(17),16)
-         else
-            read (10,*)   (x(k),k=1,4)
-            read (10,*)   (y(k),k=1,4)
-           
-            call copy48(buf2(1) ,x,4)
-            call copy48(buf2(5) ,y,4)
-            call byte_write(buf2(1),8)
-            call byte_write(buf2(5),8)
-         endif
-      enddo
+      call rd_xyz(rbuf,lns,nel,ndim)
       write(6,'(i12,1x,i12,1x,i1,A)') nel,nelv,ndim, 
      &     ' nelt/nelv/ndim'
 
@@ -121,28 +79,8 @@ c CURVED SIDES
       rcurve=ncurve
       call byte_write(rcurve,2)
 
-      call blank(ccurve,4)
       if (ncurve.gt.0) then
-         do icurve=1,ncurve
-c           if (mod(icurve,10000).eq.0) write(6,*) icurve,' curve'
-            if (nel.lt.1000) then
-               read(10,60) f,e,(buf(k),k=1,5),ccurve(1)
-            elseif (nel.lt.1 000 000) then
-               read(10,61) f,e,(buf(k),k=1,5),ccurve(1)
-            else
-               read(10,62) f,e,(buf(k),k=1,5),ccurve(1)
-            endif
-            buf2(1)=e
-            buf2(2)=f
-            call copy48(buf2(3),buf(1),5)
-            call blank(buf2(8),8)
-            call chcopy(buf2(8),ccurve,1)
-            call byte_write(buf2,16)
-         enddo
-   60    format(i3,i3 ,5g14.6,1x,a1)
-   61    format(i2,i6 ,5g14.6,1x,a1)
-   62    format(i2,i12,5g14.6,1x,a1)
-
+          call rd_curve(rbuf,lns,ncurve,nel)
           write(6,*) ncurve,' Number of curved sides'
       endif
 
@@ -156,44 +94,10 @@ C BOUNDARY CONDITIONS
          if (indx1(string,'BOUN',4).ne.0) then ! we might have bcs
             if (indx1(string,'NO ',3).eq.0)  then ! we have bcs, read and count
                write(6,'(A,A)') 'read: ',string
-               nbc = 0
                nelb = nelv
                if(kpass.eq.2) nelb=nel     ! only ifield2 is a T mesh 
-               do e=1,nelb
-               do f=1,nface
-                  if (nel.lt.1 000 000) then
-                     read(10,20) cbc(f,e),(bc(k,f,e),k=1,5)
-                  else
-                     read(10,21) cbc(f,e),(bc8(k),k=1,5)
-                     do ii = 1,5
-                        bc(ii,f,e)=bc8(ii)
-                     enddo
-                     ibc(f,e) = bc8(1)
-                  endif
-                  if (cbc(f,e).ne.'E  ') nbc = nbc+1
-               enddo
-               enddo
-   20          format(1x,a3,6x,5g14.6)  
-   21          format(1x,a3,12x,5g18.11)  
-
+               call rd_bc(rbuf,ifkeep,lns,nbc,nelb,nface,nel)
                write(6,*) kpass,nbc,' Number of bcs'
-               rbc=nbc
-               call byte_write(rbc,2)
-
-               do e=1,nelb
-               do f=1,nface
-                  if (cbc(f,e).ne.'E  ') then
-                     buf2(1)=e
-                     buf2(2)=f
-                     call copy48(buf2(3),bc(1,f,e),5)
-                     call blank      (buf2(8),8)
-                     call chcopy     (buf2(8),cbc(f,e),3)
-                     if(nelb.ge.1000000) buf2(3)=ibc(f,e)
-                     call byte_write (buf2,16)
-                  endif
-               enddo
-               enddo
-
             endif
          else
             goto 51
@@ -220,6 +124,260 @@ c     write(6 ,81) (string1(k),k=1,len)
       write(6,*) 'could not find file "indat". abort.'
       stop
       end
+c-----------------------------------------------------------------------
+c
+c     The .rea sections below are converted in chunks of lch elements:
+c     the lines of a chunk are read serially into lns, parsed in
+c     parallel (internal reads, build with OpenMP to enable) and the
+c     chunk goes to the .re2 in a single byte_write.
+c
+c-----------------------------------------------------------------------
+      subroutine rd_xyz(rbuf,lns,nel,ndim)
+
+      include 'CHUNK'
+      real*8 rbuf(*)
+      character*132 lns(*)
+
+      nlpe = 1 + ndim*(ndim-1)   ! lines per element, incl. header
+      nw   = 1 + ndim*2**ndim    ! group + vertex coordinates
+
+      do ie0=0,nel-1,lch
+         nc = min(lch,nel-ie0)
+         call rd_lines(lns,nc*nlpe)
+
+         ierr = 0
+c$omp parallel do private(i) reduction(max:ierr)
+         do i=1,nc
+            call rd_xyz1(rbuf((i-1)*nw+1),lns((i-1)*nlpe+1),ndim
+     $                  ,ie0+i,ierr)
+         enddo
+         if (ierr.gt.0) call rd_abort('element',ierr)
+
+         call byte_write(rbuf,2*nw*nc)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_curve(cbuf,lns,ncurve,nel)
+
+      include 'CHUNK'
+      real*8 cbuf(8,*)
+      character*132 lns(*)
+
+      do ic0=0,ncurve-1,lch
+         nc = min(lch,ncurve-ic0)
+         call rd_lines(lns,nc)
+
+         ierr = 0
+c$omp parallel do private(i) reduction(max:ierr)
+         do i=1,nc
+            call rd_curve1(cbuf(1,i),lns(i),nel,ic0+i,ierr)
+         enddo
+         if (ierr.gt.0) call rd_abort('curve',ierr)
+
+         call byte_write(cbuf,16*nc)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_bc(bbuf,ifkeep,lns,nbc,nelb,nface,nel)
+c
+c     The bc count precedes the records in the .re2, chunks are kept
+c     on a scratch unit until the field is complete (unless the field
+c     fits in one chunk).
+c
+      include 'CHUNK'
+      real*8 bbuf(8,*)
+      logical ifkeep(*)
+      character*132 lns(*)
+
+      real*8  rbc
+
+      nbc   = 0
+      nchnk = 0
+      do ie0=0,nelb-1,lch
+         nc = min(lch,nelb-ie0)
+         nl = nc*nface
+         call rd_lines(lns,nl)
+
+         ierr = 0
+c$omp parallel do private(l) reduction(max:ierr)
+         do l=1,nl
+            call rd_bc1(bbuf(1,l),ifkeep(l),lns(l),ie0+(l-1)/nface+1
+     $                 ,mod(l-1,nface)+1,nelb,nel,ierr)
+         enddo
+         if (ierr.gt.0) call rd_abort('bc',ierr)
+
+         n = 0
+         do l=1,nl
+            if (ifkeep(l)) then
+               n = n+1
+               if (n.lt.l) call copy8(bbuf(1,n),bbuf(1,l),8)
+            endif
+         enddo
+         nbc = nbc + n
+
+         if (nchnk.eq.0 .and. ie0+nc.lt.nelb)
+     $      open(unit=12,status='scratch',form='unformatted')
+         if (ie0+nc.lt.nelb .or. nchnk.gt.0)
+     $      write(12) n,((bbuf(k,l),k=1,8),l=1,n)
+         nchnk = nchnk+1
+      enddo
+
+      rbc=nbc
+      call byte_write(rbc,2)
+
+      if (nchnk.eq.1) then
+         call byte_write(bbuf,16*n)
+      elseif (nchnk.gt.1) then
+         rewind(12)
+         do ic=1,nchnk
+            read(12) n,((bbuf(k,l),k=1,8),l=1,n)
+            call byte_write(bbuf,16*n)
+         enddo
+         close(12)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_xyz1(r,ln,ndim,ie,ierr)
+c
+c     parse the vertex lines ln(2:) of element ie into the re2 record r
+c
+      real*8 r(*)
+      character*132 ln(*)
+      real    x(8),y(8),z(8)
+
+      if (ndim.eq.3) then
+         call rd_v4(ln(2),x(1),ie,ierr)
+         call rd_v4(ln(3),y(1),ie,ierr)
+         call rd_v4(ln(4),z(1),ie,ierr)
+         call rd_v4(ln(5),x(5),ie,ierr)
+         call rd_v4(ln(6),y(5),ie,ierr)
+         call rd_v4(ln(7),z(5),ie,ierr)
+         r(1) = 0             ! igroup (not used at the moment)
+         call copy48(r( 2),x,8)
+         call copy48(r(10),y,8)
+         call copy48(r(18),z,8)
+      else
+         call rd_v4(ln(2),x(1),ie,ierr)
+         call rd_v4(ln(3),y(1),ie,ierr)
+         r(1) = 0
+         call copy48(r(2),x,4)
+         call copy48(r(6),y,4)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_v4(ln,x,ie,ierr)
+c
+c     read 4 reals from ln, rd_reals (rdreal.c) with read(ln,*) as a
+c     fallback for anything it does not take
+c
+      character*132 ln
+      real x(4)
+
+      call rd_reals(ln,132,4,x,jerr)
+      if (jerr.ne.0) read(ln,*,err=5) (x(k),k=1,4)
+      return
+
+    5 ierr = ie
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_curve1(r,ln,nel,ic,ierr)
+c
+c     parse curve line ln (curve ic) into the re2 record r
+c
+      real*8 r(8)
+      character*132 ln
+      real    buf(5)
+      integer e,f
+      character*1 cc
+
+      if (nel.lt.1000) then
+         read(ln,60,err=5) f,e,(buf(k),k=1,5),cc
+      elseif (nel.lt.1 000 000) then
+         read(ln,61,err=5) f,e,(buf(k),k=1,5),cc
+      else
+         read(ln,62,err=5) f,e,(buf(k),k=1,5),cc
+      endif
+   60 format(i3,i3 ,5g14.6,1x,a1)
+   61 format(i2,i6 ,5g14.6,1x,a1)
+   62 format(i2,i12,5g14.6,1x,a1)
+      r(1) = e
+      r(2) = f
+      call copy48(r(3),buf,5)
+      call blank (r(8),8)
+      call chcopy(r(8),cc,1)
+      return
+
+    5 ierr = ic
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_bc1(r,ifkeep,ln,e,f,nelb,nel,ierr)
+c
+c     parse bc line ln (face f of element e) into the re2 record r,
+c     ifkeep is false for 'E  '
+c
+      real*8 r(8)
+      logical ifkeep
+      character*132 ln
+      integer e,f
+
+      real    bc(5)
+      real*8  bc8(5)
+      character*3 cb
+
+      cb = ln(2:4)
+      if (nel.lt.1 000 000) then
+         call rd_fixed(ln,10,14,5,bc,jerr)
+         if (jerr.ne.0) read(ln,20,err=5) cb,(bc(k),k=1,5)
+         call copy48(r(3),bc,5)
+      else
+         call rd_fixed8(ln,16,18,5,bc8,jerr)
+         if (jerr.ne.0) read(ln,21,err=5) cb,(bc8(k),k=1,5)
+         call copy8(r(3),bc8,5)
+         if (nelb.ge.1000000) r(3) = int(bc8(1))
+      endif
+   20 format(1x,a3,6x,5g14.6)  
+   21 format(1x,a3,12x,5g18.11)  
+      ifkeep = cb.ne.'E  '
+      r(1) = e
+      r(2) = f
+      call blank (r(8),8)
+      call chcopy(r(8),cb,3)
+      return
+
+    5 ierr = e
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_lines(lns,n)
+
+      character*132 lns(n)
+
+      do l=1,n
+         read(10,'(a132)',end=9) lns(l)
+      enddo
+      return
+
+    9 call rd_abort('end of file, line',l)
+      end
+c-----------------------------------------------------------------------
+      subroutine rd_abort(what,i)
+      character*(*) what
+
+      write(6,*) 'Abort: could not read ',what,i
+      call exitt
+
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine exitt
 